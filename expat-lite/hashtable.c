@@ -114,6 +114,22 @@ NAMED *hashTableLookup(HASH_TABLE *table, KEY name, size_t createSize)
   return table->v[i];
 }
 
+/* Remove (and free) every entry, but keep the bucket vector at its
+grown size so a reused table doesn't re-grow from scratch. */
+
+void hashTableClear(HASH_TABLE *table)
+{
+  size_t i;
+  for (i = 0; i < table->size; i++) {
+    NAMED *p = table->v[i];
+    if (p) {
+      free(p);
+      table->v[i] = 0;
+    }
+  }
+  table->used = 0;
+}
+
 void hashTableDestroy(HASH_TABLE *table)
 {
   size_t i;
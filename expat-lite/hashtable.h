@@ -58,6 +58,7 @@ typedef struct {
 
 NAMED *hashTableLookup(HASH_TABLE *table, KEY name, size_t createSize);
 void hashTableInit(HASH_TABLE *);
+void hashTableClear(HASH_TABLE *);
 void hashTableDestroy(HASH_TABLE *);
 
 typedef struct {
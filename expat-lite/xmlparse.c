@@ -237,6 +237,7 @@ static const XML_Char *getContext(XML_Parser parser);
 static int setContext(XML_Parser parser, const XML_Char *context);
 static void normalizePublicId(XML_Char *s);
 static int dtdInit(DTD *);
+static void dtdReset(DTD *);
 static void dtdDestroy(DTD *);
 static int dtdCopy(DTD *newDtd, const DTD *oldDtd);
 static void poolInit(STRING_POOL *);
@@ -297,6 +298,7 @@ typedef struct {
   INIT_ENCODING m_initEncoding;
   const XML_Char *m_protocolEncodingName;
   int m_ns;
+  int m_leanParse;
   void *m_unknownEncodingMem;
   void *m_unknownEncodingData;
   void *m_unknownEncodingHandlerData;
@@ -360,6 +362,7 @@ typedef struct {
 #define unknownEncodingRelease (((Parser *)parser)->m_unknownEncodingRelease)
 #define protocolEncodingName (((Parser *)parser)->m_protocolEncodingName)
 #define ns (((Parser *)parser)->m_ns)
+#define leanParse (((Parser *)parser)->m_leanParse)
 #define prologState (((Parser *)parser)->m_prologState)
 #define processor (((Parser *)parser)->m_processor)
 #define errorCode (((Parser *)parser)->m_errorCode)
@@ -408,11 +411,42 @@ Parser *asParser(XML_Parser parser)
 #endif
 #endif
 
-XML_Parser XML_ParserCreate(const XML_Char *encodingName)
+static
+const XML_Char implicitContext[] = {
+  XML_T('x'), XML_T('m'), XML_T('l'), XML_T('='),
+  XML_T('h'), XML_T('t'), XML_T('t'), XML_T('p'), XML_T(':'),
+  XML_T('/'), XML_T('/'), XML_T('w'), XML_T('w'), XML_T('w'),
+  XML_T('.'), XML_T('w'), XML_T('3'),
+  XML_T('.'), XML_T('o'), XML_T('r'), XML_T('g'),
+  XML_T('/'), XML_T('X'), XML_T('M'), XML_T('L'),
+  XML_T('/'), XML_T('1'), XML_T('9'), XML_T('9'), XML_T('8'),
+  XML_T('/'), XML_T('n'), XML_T('a'), XML_T('m'), XML_T('e'),
+  XML_T('s'), XML_T('p'), XML_T('a'), XML_T('c'), XML_T('e'),
+  XML_T('\0')
+};
+
+/* Move a binding list onto the parser's free list, so the bindings
+(and their uri buffers) can be reused rather than reallocated. */
+
+static
+void moveToFreeBindingList(XML_Parser parser, BINDING *bindings)
+{
+  while (bindings) {
+    BINDING *b = bindings;
+    bindings = b->nextTagBinding;
+    b->nextTagBinding = freeBindingList;
+    freeBindingList = b;
+  }
+}
+
+/* Initialize the per-document state of the parser, leaving its
+allocations (buffer, atts, dataBuf, pool blocks, free lists) alone so
+that XML_ParserReset can reuse them.  Shared between XML_ParserCreate
+and XML_ParserReset. */
+
+static
+void parserInit(XML_Parser parser, const XML_Char *encodingName)
 {
-  XML_Parser parser = malloc(sizeof(Parser));
-  if (!parser)
-    return parser;
   processor = prologInitProcessor;
   XmlPrologStateInit(&prologState);
   userData = 0;
@@ -433,12 +467,10 @@ XML_Parser XML_ParserCreate(const XML_Char *encodingName)
   externalEntityRefHandler = 0;
   externalEntityRefHandlerArg = parser;
   unknownEncodingHandler = 0;
-  buffer = 0;
-  bufferPtr = 0;
-  bufferEnd = 0;
+  bufferPtr = buffer;
+  bufferEnd = buffer;
   parseEndByteIndex = 0;
   parseEndPtr = 0;
-  bufferLim = 0;
   declElementType = 0;
   declAttributeId = 0;
   declEntity = 0;
@@ -452,51 +484,87 @@ XML_Parser XML_ParserCreate(const XML_Char *encodingName)
   openInternalEntities = 0;
   tagLevel = 0;
   tagStack = 0;
-  freeTagList = 0;
-  freeBindingList = 0;
   inheritedBindings = 0;
-  attsSize = INIT_ATTS_SIZE;
-  atts = malloc(attsSize * sizeof(ATTRIBUTE));
   nSpecifiedAtts = 0;
-  dataBuf = malloc(INIT_DATA_BUF_SIZE * sizeof(XML_Char));
-  groupSize = 0;
-  groupConnector = 0;
   hadExternalDoctype = 0;
   unknownEncodingMem = 0;
   unknownEncodingRelease = 0;
   unknownEncodingData = 0;
   unknownEncodingHandlerData = 0;
+  protocolEncodingName = encodingName ? poolCopyString(&tempPool, encodingName) : 0;
+  if (ns)
+    XmlInitEncodingNS(&initEncoding, &encoding, 0);
+  else
+    XmlInitEncoding(&initEncoding, &encoding, 0);
+}
+
+XML_Parser XML_ParserCreate(const XML_Char *encodingName)
+{
+  XML_Parser parser = malloc(sizeof(Parser));
+  if (!parser)
+    return parser;
+  buffer = 0;
+  bufferLim = 0;
+  freeTagList = 0;
+  freeBindingList = 0;
+  attsSize = INIT_ATTS_SIZE;
+  atts = malloc(attsSize * sizeof(ATTRIBUTE));
+  dataBuf = malloc(INIT_DATA_BUF_SIZE * sizeof(XML_Char));
+  groupSize = 0;
+  groupConnector = 0;
   namespaceSeparator = '!';
   ns = 0;
+  leanParse = 0;
   poolInit(&tempPool);
   poolInit(&temp2Pool);
-  protocolEncodingName = encodingName ? poolCopyString(&tempPool, encodingName) : 0;
+  parserInit(parser, encodingName);
   if (!dtdInit(&dtd) || !atts || !dataBuf
       || (encodingName && !protocolEncodingName)) {
     XML_ParserFree(parser);
     return 0;
   }
   dataBufEnd = dataBuf + INIT_DATA_BUF_SIZE;
-  XmlInitEncoding(&initEncoding, &encoding, 0);
   return parser;
 }
 
-XML_Parser XML_ParserCreateNS(const XML_Char *encodingName, XML_Char nsSep)
+/* Prepare a parser for reuse on a new document, recycling the memory
+it has already grown: the input buffer, the attribute and data
+buffers, string pool blocks, tag and binding free lists, and the hash
+bucket vectors all survive.  Handlers and user data are cleared, just
+as XML_ParserCreate leaves them, so callers must set them again.
+Returns zero if out of memory, non-zero otherwise. */
+
+int XML_ParserReset(XML_Parser parser, const XML_Char *encodingName)
 {
-  static
-  const XML_Char implicitContext[] = {
-    XML_T('x'), XML_T('m'), XML_T('l'), XML_T('='),
-    XML_T('h'), XML_T('t'), XML_T('t'), XML_T('p'), XML_T(':'),
-    XML_T('/'), XML_T('/'), XML_T('w'), XML_T('w'), XML_T('w'),
-    XML_T('.'), XML_T('w'), XML_T('3'),
-    XML_T('.'), XML_T('o'), XML_T('r'), XML_T('g'),
-    XML_T('/'), XML_T('X'), XML_T('M'), XML_T('L'),
-    XML_T('/'), XML_T('1'), XML_T('9'), XML_T('9'), XML_T('8'),
-    XML_T('/'), XML_T('n'), XML_T('a'), XML_T('m'), XML_T('e'),
-    XML_T('s'), XML_T('p'), XML_T('a'), XML_T('c'), XML_T('e'),
-    XML_T('\0')
-  };
+  TAG *tStk = tagStack;
+
+  /* If the last parse stopped early, the tag stack is non-empty;
+     move it to the free list, keeping the tags' buffers. */
+  while (tStk) {
+    TAG *tag = tStk;
+    tStk = tag->parent;
+    tag->parent = freeTagList;
+    moveToFreeBindingList(parser, tag->bindings);
+    tag->bindings = 0;
+    freeTagList = tag;
+  }
+  moveToFreeBindingList(parser, inheritedBindings);
+  free(unknownEncodingMem);
+  if (unknownEncodingRelease)
+    unknownEncodingRelease(unknownEncodingData);
+  poolClear(&tempPool);
+  poolClear(&temp2Pool);
+  dtdReset(&dtd);
+  parserInit(parser, encodingName);
+  if (encodingName && !protocolEncodingName)
+    return 0;
+  if (ns)
+    return setContext(parser, implicitContext);
+  return 1;
+}
 
+XML_Parser XML_ParserCreateNS(const XML_Char *encodingName, XML_Char nsSep)
+{
   XML_Parser parser = XML_ParserCreate(encodingName);
   if (parser) {
     XmlInitEncodingNS(&initEncoding, &encoding, 0);
@@ -510,6 +578,14 @@ XML_Parser XML_ParserCreateNS(const XML_Char *encodingName, XML_Char nsSep)
   return parser;
 }
 
+void XML_SetLeanParsing(XML_Parser parser, int lean)
+{
+  /* Lean parsing takes shortcuts that are flatly wrong for namespace
+processing, so refuse to combine the two. */
+  if (!ns)
+    leanParse = lean;
+}
+
 int XML_SetEncoding(XML_Parser parser, const XML_Char *encodingName)
 {
   if (!encodingName)
@@ -1495,7 +1571,7 @@ static enum XML_Error storeAtts(XML_Parser parser, const ENCODING *enc,
   BINDING *binding;
   const XML_Char *localPart;
 
-  if (tagNamePtr) {
+  if (tagNamePtr && !leanParse) {
     elementType = (ELEMENT_TYPE *)hashTableLookup(&dtd.elementTypes, tagNamePtr->str, 0);
     if (!elementType) {
       tagNamePtr->str = poolCopyString(&dtd.pool, tagNamePtr->str);
@@ -1521,23 +1597,42 @@ static enum XML_Error storeAtts(XML_Parser parser, const ENCODING *enc,
   }
   appAtts = (const XML_Char **)atts;
   for (i = 0; i < n; i++) {
-    ATTRIBUTE_ID *attId = getAttributeId(parser, enc, atts[i].name,
-					 atts[i].name
-					 + XmlNameLength(enc, atts[i].name));
-    if (!attId)
-      return XML_ERROR_NO_MEMORY;
-    if ((attId->name)[-1]) {
-      if (enc == encoding)
-	eventPtr = atts[i].name;
-      return XML_ERROR_DUPLICATE_ATTRIBUTE;
+    ATTRIBUTE_ID *attId = 0;
+    if (leanParse) {
+      /* A lean parser hands each name straight to the handler from
+	 the per-tag pool instead of interning it: with no DTD there
+	 are no defaults to merge, and the writer is trusted not to
+	 repeat an attribute, so nothing needs to find this name
+	 again. */
+      if (tagNamePtr) {
+	appAtts[attIndex] = poolStoreString(&tempPool, enc, atts[i].name,
+					    atts[i].name
+					    + XmlNameLength(enc, atts[i].name));
+	if (!appAtts[attIndex])
+	  return XML_ERROR_NO_MEMORY;
+	poolFinish(&tempPool);
+	attIndex++;
+      }
+    }
+    else {
+      attId = getAttributeId(parser, enc, atts[i].name,
+			     atts[i].name
+			     + XmlNameLength(enc, atts[i].name));
+      if (!attId)
+	return XML_ERROR_NO_MEMORY;
+      if ((attId->name)[-1]) {
+	if (enc == encoding)
+	  eventPtr = atts[i].name;
+	return XML_ERROR_DUPLICATE_ATTRIBUTE;
+      }
+      (attId->name)[-1] = 1;
+      appAtts[attIndex++] = attId->name;
     }
-    (attId->name)[-1] = 1;
-    appAtts[attIndex++] = attId->name;
     if (!atts[i].normalized) {
       enum XML_Error result;
       int isCdata = 1;
 
-      if (attId->maybeTokenized) {
+      if (attId && attId->maybeTokenized) {
 	int j;
 	for (j = 0; j < nDefaultAtts; j++) {
 	  if (attId == elementType->defaultAtts[j].id) {
@@ -1565,7 +1660,7 @@ static enum XML_Error storeAtts(XML_Parser parser, const ENCODING *enc,
 	return XML_ERROR_NO_MEMORY;
       poolFinish(&tempPool);
     }
-    if (attId->prefix && tagNamePtr) {
+    if (attId && attId->prefix && tagNamePtr) {
       if (attId->xmlns) {
         if (!addBinding(parser, attId->prefix, attId, appAtts[attIndex], bindingsPtr))
           return XML_ERROR_NO_MEMORY;
@@ -1607,6 +1702,11 @@ static enum XML_Error storeAtts(XML_Parser parser, const ENCODING *enc,
     }
     appAtts[attIndex] = 0;
   }
+  /* Lean-mode names live in the tag's pool, not the DTD's tables,
+     so there are no flag bytes to reset and no bindings or prefixes
+     to resolve. */
+  if (leanParse)
+    return XML_ERROR_NONE;
   i = 0;
   if (nPrefixes) {
     for (; i < attIndex; i += 2) {
@@ -2927,6 +3027,32 @@ static int dtdInit(DTD *p)
   return 1;
 }
 
+/* Empty the DTD for reuse on a new document, keeping the hash bucket
+vectors and string pool blocks it has already grown. */
+
+static void dtdReset(DTD *p)
+{
+  HASH_TABLE_ITER iter;
+  hashTableIterInit(&iter, &(p->elementTypes));
+  for (;;) {
+    ELEMENT_TYPE *e = (ELEMENT_TYPE *)hashTableIterNext(&iter);
+    if (!e)
+      break;
+    if (e->allocDefaultAtts != 0)
+      free(e->defaultAtts);
+  }
+  hashTableClear(&(p->generalEntities));
+  hashTableClear(&(p->elementTypes));
+  hashTableClear(&(p->attributeIds));
+  hashTableClear(&(p->prefixes));
+  poolClear(&(p->pool));
+  p->complete = 1;
+  p->standalone = 0;
+  p->base = 0;
+  p->defaultPrefix.name = 0;
+  p->defaultPrefix.binding = 0;
+}
+
 static void dtdDestroy(DTD *p)
 {
   HASH_TABLE_ITER iter;
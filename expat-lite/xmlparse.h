@@ -93,6 +93,30 @@ passed through without expansion. */
 XML_Parser XMLPARSEAPI
 XML_ParserCreateNS(const XML_Char *encoding, XML_Char namespaceSeparator);
 
+/* Prepares a parser for reuse on a new document, recycling the
+buffers, string pool blocks and hash tables it has already grown
+rather than freeing them; parsing many small documents with one reset
+parser avoids the per-document allocation that creating fresh parsers
+costs.  All handlers and the user data pointer are cleared, exactly
+as XML_ParserCreate leaves them, so set them again before parsing.
+Returns zero if out of memory, non-zero otherwise. */
+
+int XMLPARSEAPI
+XML_ParserReset(XML_Parser parser, const XML_Char *encoding);
+
+/* Declares that the documents fed to this parser are trusted,
+machine-generated, use no namespaces and carry no DOCTYPE, so the
+parser may skip the bookkeeping those features need: element type and
+attribute names are no longer interned in the DTD's hash tables, and
+duplicate attributes are not detected.  If the document lies --- a
+DOCTYPE's attribute defaults, say --- the extra information is
+silently ignored rather than reported.  Must not be combined with
+XML_ParserCreateNS (the call is ignored on such parsers), and survives
+XML_ParserReset like the namespace setting does. */
+
+void XMLPARSEAPI
+XML_SetLeanParsing(XML_Parser parser, int lean);
+
 
 /* atts is array of name/value pairs, terminated by 0;
    names and values are 0 terminated. */
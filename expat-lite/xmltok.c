@@ -256,6 +256,59 @@ int sb_charMatches(const ENCODING *enc, const char *p, int c)
 #define CHAR_MATCHES(enc, p, c) (*(p) == c)
 #endif
 
+#ifndef XML_MIN_SIZE
+
+/* A byte of single-byte character data is "plain" if the content
+tokenizer's inner loop would just step over it: printable ASCII other
+than the three delimiters it must stop on.  Bytes >= 0x80 (lead/trail
+bytes in UTF-8, data in Latin-1) and control bytes are left to the
+byte-type table. */
+#define SB_PLAIN_CONTENT_BYTE(c) \
+  ((unsigned char)(c) >= 0x20 && (unsigned char)(c) < 0x80 \
+   && (c) != '<' && (c) != '&' && (c) != ']')
+
+/* Skip a run of plain content bytes a word at a time.  Each aligned
+word is tested for a byte that is < 0x20, >= 0x80, or one of "<&]"
+using the usual carry tricks; the first word that contains one is
+re-scanned bytewise, and the byte-type table takes over at the byte
+returned, so boundary handling is exactly as before. */
+static
+const char *sb_skipContentBytes(const char *ptr, const char *end)
+{
+#define ONES (~(unsigned long)0 / 0xFF)
+#define HIGHS (ONES * 0x80)
+#define HAS_LESS(x, n) (((x) - ONES * (n)) & ~(x) & HIGHS)
+#define HAS_VALUE(x, n) HAS_LESS((x) ^ (ONES * (n)), 1)
+
+  while (ptr != end && ((size_t)ptr & (sizeof(unsigned long) - 1))) {
+    if (!SB_PLAIN_CONTENT_BYTE(*ptr))
+      return ptr;
+    ptr++;
+  }
+  while ((size_t)(end - ptr) >= sizeof(unsigned long)) {
+    unsigned long w = *(const unsigned long *)ptr;
+    if ((w & HIGHS)
+	|| HAS_LESS(w, 0x20)
+	|| HAS_VALUE(w, '<')
+	|| HAS_VALUE(w, '&')
+	|| HAS_VALUE(w, ']'))
+      break;
+    ptr += sizeof(unsigned long);
+  }
+  while (ptr != end && SB_PLAIN_CONTENT_BYTE(*ptr))
+    ptr++;
+  return ptr;
+
+#undef HAS_VALUE
+#undef HAS_LESS
+#undef HIGHS
+#undef ONES
+}
+
+#define CONTENT_FAST_SKIP(enc, ptr, end) sb_skipContentBytes(ptr, end)
+
+#endif /* not XML_MIN_SIZE */
+
 #define PREFIX(ident) normal_ ## ident
 #include "xmltok_impl.c"
 
@@ -263,6 +316,9 @@ int sb_charMatches(const ENCODING *enc, const char *p, int c)
 #undef BYTE_TYPE
 #undef BYTE_TO_ASCII
 #undef CHAR_MATCHES
+#ifdef CONTENT_FAST_SKIP
+#undef CONTENT_FAST_SKIP
+#endif
 #undef IS_NAME_CHAR
 #undef IS_NAME_CHAR_MINBPC
 #undef IS_NMSTRT_CHAR
@@ -32,6 +32,11 @@ your version of this file under either the MPL or the GPL.
 #define IS_INVALID_CHAR(enc, ptr, n) (0)
 #endif
 
+#ifndef CONTENT_FAST_SKIP
+/* Encodings without a word-at-a-time fast path scan bytewise. */
+#define CONTENT_FAST_SKIP(enc, ptr, end) (ptr)
+#endif
+
 #define INVALID_LEAD_CASE(n, ptr, nextTokPtr) \
     case BT_LEAD ## n: \
       if (end - ptr < n) \
@@ -853,6 +858,12 @@ int PREFIX(contentTok)(const ENCODING *enc, const char *ptr, const char *end,
     break;
   }
   while (ptr != end) {
+    /* Skim over runs of plain character data a word at a time where
+       the encoding allows it; the byte-type switch below handles
+       whatever byte the skip stops on. */
+    ptr = CONTENT_FAST_SKIP(enc, ptr, end);
+    if (ptr == end)
+      break;
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
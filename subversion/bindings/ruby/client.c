@@ -579,7 +579,7 @@ cl_log (int argc, VALUE *argv, VALUE self)
 
   err = svn_client_log (auth_baton,
                         paths, &start, &end,
-                        RTEST (discover_changed_paths),
+                        RTEST (discover_changed_paths), 0,
                         svn_ruby_log_receiver,
                         (void *)&baton,
                         baton.pool);
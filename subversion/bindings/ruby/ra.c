@@ -681,7 +681,7 @@ ra_get_log (int argc, VALUE *argv, VALUE self)
 
   err = ra->plugin->get_log (ra->session_baton,
 			     paths, start, end,
-			     RTEST (discover_changed_paths),
+			     RTEST (discover_changed_paths), 0,
 			     svn_ruby_log_receiver,
 			     (void *)&baton);
 
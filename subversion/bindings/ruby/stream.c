@@ -68,10 +68,8 @@ svn_ruby_stream_new (VALUE class,
 static VALUE
 read (VALUE self, VALUE aInt)
 {
-  char *buffer;
   apr_size_t len;
   svn_error_t *err;
-  apr_pool_t *pool;
   svn_ruby_stream_t *stream;
   VALUE obj;
 
@@ -79,24 +77,21 @@ read (VALUE self, VALUE aInt)
   Data_Get_Struct (self, svn_ruby_stream_t, stream);
   if (stream->closed)
     rb_raise (rb_eRuntimeError, "Stream is already closed");
-  pool = svn_pool_create (stream->pool);
-  buffer = apr_palloc (pool, len);
 
-  err = svn_stream_read (stream->stream, buffer, &len);
+  /* Read straight into the string we will return, instead of reading
+     into a scratch buffer and copying every byte over.  The string
+     has to be a fresh copy anyway -- a pool buffer would be gone
+     before the GC ever saw it -- so make it the only copy. */
+  obj = rb_str_new (0, len);
+  err = svn_stream_read (stream->stream, RSTRING (obj)->ptr, &len);
   if (err)
-    {
-      apr_pool_destroy (pool);
-      svn_ruby_raise (err);
-    }
+    svn_ruby_raise (err);
 
   if (!len)
-    {
-      apr_pool_destroy (pool);
-      return Qnil;
-    }
+    return Qnil;
 
-  obj = rb_str_new (buffer, len);
-  apr_pool_destroy (pool);
+  if (len < (apr_size_t) RSTRING (obj)->len)
+    rb_str_resize (obj, len);
   return obj;
 }
 
@@ -52,6 +52,11 @@ typedef enum {
   svn_cl__auth_username_opt,
   svn_cl__auth_password_opt,
   svn_cl__targets_opt,
+  svn_cl__threads_opt,
+  svn_cl__pipeline_opt,
+  svn_cl__put_workers_opt,
+  svn_cl__limit_opt,
+  svn_cl__ra_stats_opt,
 } svn_cl__longopt_t;
 
 
@@ -99,6 +104,8 @@ typedef struct svn_cl__opt_state_t
   svn_stringbuf_t *extensions;
   /* Targets supplied from a file with --targets */
   apr_array_header_t *targets;
+  int limit;  /* N in "svn log --limit N"; zero means no limit */
+  svn_boolean_t ra_stats;  /* print network transfer totals on exit */
 } svn_cl__opt_state_t;
 
 
@@ -127,6 +134,7 @@ svn_cl__cmd_proc_t
   svn_cl__cleanup,
   svn_cl__commit,
   svn_cl__copy,
+  svn_cl__daemon,
   svn_cl__delete,
   svn_cl__diff,
   svn_cl__help,
@@ -147,6 +155,25 @@ svn_cl__cmd_proc_t
   svn_cl__update;
 
 
+/* Parse ARGV and run the subcommand it names, returning the process
+   exit code.  This is main() in all but name; the daemon uses it to
+   run forwarded commands in-process. */
+int
+svn_cl__run_command (int argc, const char * const *argv);
+
+
+/* If the SVN_DAEMON environment variable is set and a daemon (see
+   `svn daemon') is reachable, forward ARGV to it, relay its output,
+   set *EXIT_CODE to the command's exit code, and return TRUE.  Else
+   return FALSE, meaning the command should be run locally.  Use POOL
+   for all allocation. */
+svn_boolean_t
+svn_cl__daemon_forward (int *exit_code,
+                        int argc,
+                        const char *const *argv,
+                        apr_pool_t *pool);
+
+
 /* Print a generic (non-command-specific) usage message. */
 void
 svn_cl__print_generic_help (apr_pool_t *pool, FILE *stream);
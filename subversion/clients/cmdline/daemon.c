@@ -0,0 +1,642 @@
+/*
+ * daemon.c:  a resident svn process, to amortize startup costs
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+/* Build systems that shell out to `svn' thousands of times per build
+   pay process creation, APR initialization and config loading on
+   every single invocation -- a fixed floor of tens of milliseconds
+   that dwarfs the actual work of a small `svn status' or `svn up'.
+
+   `svn daemon' starts a resident process that listens on a loopback
+   socket and runs subcommands on demand, keeping the process (and
+   everything warm inside it: allocator arenas, loaded libraries, the
+   process-global caches the libraries maintain) alive between
+   commands.  The port it listens on is advertised in the file
+   ~/.subversion/daemon-port.
+
+   The front end side is built into every `svn': when the environment
+   variable SVN_DAEMON is set and a daemon is advertising a port, the
+   command line is forwarded to the daemon instead of being run
+   locally, and the daemon's output and exit code are relayed back.
+   If no daemon is reachable, the command silently runs locally, so
+   setting SVN_DAEMON is always safe.
+
+   The protocol is a trivial counted-string exchange:
+
+      request:   "svn-daemon-1 <argc>\n"
+                 "<length>\n<bytes>\n"    (the shared secret)
+                 "<length>\n<bytes>\n"    (the working directory)
+                 "<length>\n<bytes>\n"    (each argument, argc times)
+
+      response:  "<exit-code> <output-length>\n"
+                 <output bytes>
+
+   The daemon captures the command's stdout and stderr in a temporary
+   file while it runs, then ships the file's contents back.  That
+   loses the stdout/stderr distinction and any interactivity, so
+   commands that prompt (propedit, authentication prompts) should not
+   be pointed at a daemon.
+
+   The listening socket is bound to 127.0.0.1, but on a multi-user
+   host any local user can connect to a loopback port, so the daemon
+   will not run a command until the client proves it can read the
+   port file: the daemon writes a random secret there alongside the
+   port number, creates the file owner-read/write only, and rejects
+   any request that doesn't present the secret.  ### a unix domain
+   socket would let the kernel do this for us, but APR doesn't offer
+   them.  */
+
+
+
+/*** Includes. ***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SVN_WIN32
+#include <unistd.h>
+#endif
+
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_network_io.h>
+#include <apr_file_io.h>
+#include <apr_file_info.h>
+#include <apr_portable.h>
+#include <apr_lib.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_path.h"
+#include "svn_io.h"
+#include "cl.h"
+
+
+#ifndef SVN_WIN32
+
+/* How many pending connections the listening socket will hold. */
+#define DAEMON_BACKLOG 8
+
+/* The longest counted string and the most arguments a request may
+   carry.  Real command lines are nowhere near these; bounding them
+   matters because the framing is parsed before the secret has been
+   checked, so it must not let an arbitrary connection demand huge
+   allocations (or overflow a length computation) first. */
+#define DAEMON_MAX_STRING (1024 * 1024)
+#define DAEMON_MAX_ARGS 1024
+
+
+/* Set *PATH_P to the file where a running daemon advertises its
+   port, or to null if the path can't be determined (no home
+   directory, say).  Allocate the path in POOL.
+
+   ### this hardcodes the ~/.subversion location the same way the
+   config code's help text does; if the config area ever moves, both
+   must follow.  */
+static void
+daemon_port_file (const char **path_p, apr_pool_t *pool)
+{
+  apr_uid_t uid;
+  apr_gid_t gid;
+  char *username;
+  char *homedir;
+
+  *path_p = NULL;
+
+  if (apr_current_userid (&uid, &gid, pool))
+    return;
+  if (apr_get_username (&username, uid, pool))
+    return;
+  if (apr_get_home_directory (&homedir, username, pool))
+    return;
+
+  *path_p = apr_psprintf (pool, "%s/.subversion/daemon-port", homedir);
+}
+
+
+/* Set *SECRET_P to a random 32-character hex string allocated in
+   POOL.  The randomness comes from /dev/urandom; this file is
+   already unix-only, and anything we could cook up from pids and
+   timestamps would be guessable, so if that can't be read we fail
+   rather than run unprotected.  */
+static svn_error_t *
+generate_secret (const char **secret_p, apr_pool_t *pool)
+{
+  unsigned char rand_bytes[16];
+  char *hex;
+  FILE *fp;
+  int i;
+
+  fp = fopen ("/dev/urandom", "rb");
+  if (! fp)
+    return svn_error_create (SVN_ERR_UNSUPPORTED_FEATURE, 0, NULL, pool,
+                             "daemon: can't open /dev/urandom");
+  if (fread (rand_bytes, 1, sizeof (rand_bytes), fp)
+      != sizeof (rand_bytes))
+    {
+      fclose (fp);
+      return svn_error_create (SVN_ERR_UNSUPPORTED_FEATURE, 0, NULL, pool,
+                               "daemon: can't read /dev/urandom");
+    }
+  fclose (fp);
+
+  hex = apr_palloc (pool, 2 * sizeof (rand_bytes) + 1);
+  for (i = 0; i < sizeof (rand_bytes); i++)
+    sprintf (hex + 2 * i, "%02x", rand_bytes[i]);
+
+  *secret_p = hex;
+  return SVN_NO_ERROR;
+}
+
+
+/* Send LEN bytes of BUF down SOCK, looping over short writes. */
+static svn_error_t *
+send_all (apr_socket_t *sock,
+          const char *buf,
+          apr_size_t len,
+          apr_pool_t *pool)
+{
+  while (len > 0)
+    {
+      apr_size_t n = len;
+      apr_status_t apr_err = apr_send (sock, buf, &n);
+
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "error writing to daemon socket");
+      buf += n;
+      len -= n;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Read exactly LEN bytes from SOCK into BUF.  A connection closed
+   before LEN bytes arrive is an error.  */
+static svn_error_t *
+recv_all (apr_socket_t *sock,
+          char *buf,
+          apr_size_t len,
+          apr_pool_t *pool)
+{
+  while (len > 0)
+    {
+      apr_size_t n = len;
+      apr_status_t apr_err = apr_recv (sock, buf, &n);
+
+      if (apr_err || n == 0)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "error reading from daemon socket");
+      buf += n;
+      len -= n;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Read bytes from SOCK up to and including a newline; return them in
+   *LINE, newline stripped and null terminated, allocated in POOL.
+   Header lines are tiny, so reading a byte at a time costs nothing
+   worth fixing.  */
+static svn_error_t *
+recv_line (const char **line,
+           apr_socket_t *sock,
+           apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create ("", pool);
+  char c;
+
+  while (1)
+    {
+      SVN_ERR (recv_all (sock, &c, 1, pool));
+      if (c == '\n')
+        break;
+      svn_stringbuf_appendbytes (buf, &c, 1);
+    }
+
+  *line = buf->data;
+  return SVN_NO_ERROR;
+}
+
+
+/* Read a "<length>\n<bytes>\n" counted string from SOCK into *STR,
+   null terminated, allocated in POOL.  The length gets its own line
+   because the bytes may themselves contain newlines (log messages,
+   say), which would confuse any line-oriented framing. */
+static svn_error_t *
+recv_counted (const char **str,
+              apr_socket_t *sock,
+              apr_pool_t *pool)
+{
+  const char *header, *p;
+  apr_size_t len;
+  char *buf;
+  char newline;
+
+  /* Parse the length by hand: it comes from an unauthenticated peer,
+     so a sign, a stray character, or an absurd size must all be
+     rejected before they reach the allocator. */
+  SVN_ERR (recv_line (&header, sock, pool));
+  if (*header == '\0')
+    return svn_error_create (SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL, pool,
+                             "malformed counted string in daemon request");
+  len = 0;
+  for (p = header; *p; p++)
+    {
+      if (! apr_isdigit (*p))
+        return svn_error_create (SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL, pool,
+                                 "malformed counted string in daemon "
+                                 "request");
+      len = len * 10 + (*p - '0');
+      if (len > DAEMON_MAX_STRING)
+        return svn_error_create (SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL, pool,
+                                 "oversized counted string in daemon "
+                                 "request");
+    }
+
+  buf = apr_palloc (pool, len + 1);
+  SVN_ERR (recv_all (sock, buf, len, pool));
+  buf[len] = '\0';
+  SVN_ERR (recv_all (sock, &newline, 1, pool));
+
+  *str = buf;
+  return SVN_NO_ERROR;
+}
+
+
+/* Send STR to SOCK as a "<length>\n<bytes>\n" counted string. */
+static svn_error_t *
+send_counted (apr_socket_t *sock,
+              const char *str,
+              apr_pool_t *pool)
+{
+  apr_size_t len = strlen (str);
+  const char *header = apr_psprintf (pool, "%" APR_SIZE_T_FMT "\n", len);
+
+  SVN_ERR (send_all (sock, header, strlen (header), pool));
+  SVN_ERR (send_all (sock, str, len, pool));
+  SVN_ERR (send_all (sock, "\n", 1, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Serve one accepted connection CONN: read a request, run the
+   command with stdout and stderr captured in a temporary file, and
+   send the output and exit code back.  Reject the request unless it
+   presents SECRET, the string advertised in the port file.  All
+   allocation happens in POOL, which the caller clears between
+   connections. */
+static svn_error_t *
+serve_connection (apr_socket_t *conn,
+                  const char *secret,
+                  apr_pool_t *pool)
+{
+  const char *header, *cwd, *presented;
+  const char **argv;
+  int argc, i, code;
+  apr_file_t *out_file;
+  svn_stringbuf_t *out_name;
+  svn_stringbuf_t *output;
+  svn_error_t *err;
+  apr_os_file_t out_fd;
+  int saved_out, saved_err;
+
+  /* Read the request. */
+  SVN_ERR (recv_line (&header, conn, pool));
+  if (strncmp (header, "svn-daemon-1 ", 13) != 0)
+    return svn_error_create (SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL, pool,
+                             "malformed daemon request");
+  argc = atoi (header + 13);
+  if (argc < 1 || argc > DAEMON_MAX_ARGS)
+    return svn_error_create (SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL, pool,
+                             "malformed daemon request");
+
+  /* Anyone local can reach a loopback port; only someone who can
+     read the port file knows the secret. */
+  SVN_ERR (recv_counted (&presented, conn, pool));
+  if (strcmp (presented, secret) != 0)
+    return svn_error_create (SVN_ERR_RA_NOT_AUTHORIZED, 0, NULL, pool,
+                             "daemon request with wrong secret");
+
+  SVN_ERR (recv_counted (&cwd, conn, pool));
+
+  argv = apr_palloc (pool, (argc + 1) * sizeof (*argv));
+  for (i = 0; i < argc; i++)
+    SVN_ERR (recv_counted (&argv[i], conn, pool));
+  argv[argc] = NULL;
+
+  /* Run the command from the client's directory, with stdout and
+     stderr pointed at a scratch file.  The descriptors are put back
+     before the response is written, so a broken command can't wedge
+     the daemon's own stdio. */
+  apr_filepath_set (cwd, pool);
+
+  SVN_ERR (svn_io_open_unique_file (&out_file, &out_name,
+                                    "/tmp/svn-daemon", ".out", FALSE, pool));
+  apr_os_file_get (&out_fd, out_file);
+
+  fflush (stdout);
+  fflush (stderr);
+  saved_out = dup (1);
+  saved_err = dup (2);
+  dup2 (out_fd, 1);
+  dup2 (out_fd, 2);
+
+  code = svn_cl__run_command (argc, (const char * const *) argv);
+
+  fflush (stdout);
+  fflush (stderr);
+  dup2 (saved_out, 1);
+  dup2 (saved_err, 2);
+  close (saved_out);
+  close (saved_err);
+  apr_file_close (out_file);
+
+  err = svn_string_from_file (&output, out_name->data, pool);
+  apr_file_remove (out_name->data, pool);
+  SVN_ERR (err);
+
+  /* Send the response. */
+  header = apr_psprintf (pool, "%d %" APR_SIZE_T_FMT "\n",
+                         code, output->len);
+  SVN_ERR (send_all (conn, header, strlen (header), pool));
+  SVN_ERR (send_all (conn, output->data, output->len, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* ! SVN_WIN32 */
+
+
+svn_error_t *
+svn_cl__daemon (apr_getopt_t *os,
+                svn_cl__opt_state_t *opt_state,
+                apr_pool_t *pool)
+{
+#ifdef SVN_WIN32
+
+  return svn_error_create (SVN_ERR_UNSUPPORTED_FEATURE, 0, NULL, pool,
+                           "daemon mode is not supported on this platform");
+
+#else  /* ! SVN_WIN32 */
+
+  const char *port_file;
+  const char *secret;
+  apr_socket_t *sock;
+  apr_sockaddr_t *sa;
+  apr_status_t apr_err;
+  apr_file_t *pf;
+  apr_pool_t *subpool;
+
+  daemon_port_file (&port_file, pool);
+  if (! port_file)
+    return svn_error_create (SVN_ERR_UNSUPPORTED_FEATURE, 0, NULL, pool,
+                             "can't locate the ~/.subversion area");
+
+  /* Listen on a kernel-assigned loopback port. */
+  apr_err = apr_socket_create (&sock, APR_INET, SOCK_STREAM, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "daemon: can't create socket");
+  apr_setsocketopt (sock, APR_SO_REUSEADDR, 1);
+
+  apr_err = apr_sockaddr_info_get (&sa, "127.0.0.1", APR_INET, 0, 0, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "daemon: can't resolve loopback address");
+
+  apr_err = apr_bind (sock, sa);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "daemon: can't bind socket");
+
+  apr_err = apr_listen (sock, DAEMON_BACKLOG);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "daemon: can't listen on socket");
+
+  apr_err = apr_socket_addr_get (&sa, APR_LOCAL, sock);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "daemon: can't read back socket address");
+
+  SVN_ERR (generate_secret (&secret, pool));
+
+  /* Advertise the port and the secret.  The file doubles as the
+     credential, so it must be owner-only; remove any stale file
+     first in case it was created with looser permissions.  A stale
+     file from a dead daemon is handled on the client side: if the
+     connect fails, the command just runs locally. */
+  apr_file_remove (port_file, pool);
+  apr_err = apr_file_open (&pf, port_file,
+                           APR_WRITE | APR_CREATE | APR_EXCL,
+                           APR_UREAD | APR_UWRITE, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "daemon: can't write port file `%s'",
+                              port_file);
+  {
+    const char *contents = apr_psprintf (pool, "%d\n%s\n",
+                                         (int) sa->port, secret);
+
+    apr_file_write_full (pf, contents, strlen (contents), NULL);
+    apr_file_close (pf);
+  }
+
+  printf ("svn daemon: listening on port %d\n", (int) sa->port);
+  fflush (stdout);
+
+  /* Serve forever; the daemon is stopped by killing it.  A failed
+     request takes down its connection, not the daemon. */
+  subpool = svn_pool_create (pool);
+  while (1)
+    {
+      apr_socket_t *conn;
+      svn_error_t *err;
+
+      svn_pool_clear (subpool);
+
+      apr_err = apr_accept (&conn, sock, subpool);
+      if (apr_err)
+        continue;
+
+      err = serve_connection (conn, secret, subpool);
+      if (err)
+        {
+          svn_handle_error (err, stderr, FALSE);
+          svn_error_clear_all (err);
+        }
+
+      apr_socket_close (conn);
+    }
+
+  /* NOTREACHED */
+  return SVN_NO_ERROR;
+
+#endif /* SVN_WIN32 */
+}
+
+
+svn_boolean_t
+svn_cl__daemon_forward (int *exit_code,
+                        int argc,
+                        const char *const *argv,
+                        apr_pool_t *pool)
+{
+#ifndef SVN_WIN32
+
+  const char *port_file, *header;
+  svn_stringbuf_t *port_buf;
+  svn_stringbuf_t *cwd;
+  apr_socket_t *sock;
+  apr_sockaddr_t *sa;
+  svn_error_t *err;
+  int i, port, outlen;
+  char *space, *newline, *secret;
+
+  /* Forwarding is strictly opt-in, and `svn daemon' itself must
+     always run locally. */
+  if (! getenv ("SVN_DAEMON"))
+    return FALSE;
+  for (i = 1; i < argc; i++)
+    if (strcmp (argv[i], "daemon") == 0)
+      return FALSE;
+
+  /* A command line the daemon would reject as oversized just runs
+     locally. */
+  if (argc > DAEMON_MAX_ARGS)
+    return FALSE;
+  for (i = 0; i < argc; i++)
+    if (strlen (argv[i]) > DAEMON_MAX_STRING)
+      return FALSE;
+
+  /* Find an advertised daemon; any trouble at all means "run the
+     command locally", never an error the user has to see. */
+  daemon_port_file (&port_file, pool);
+  if (! port_file)
+    return FALSE;
+
+  err = svn_string_from_file (&port_buf, port_file, pool);
+  if (err)
+    {
+      svn_error_clear_all (err);
+      return FALSE;
+    }
+  /* First line is the port, second the secret the daemon expects.
+     A file without a secret is from a dead pre-secret daemon. */
+  port = atoi (port_buf->data);
+  if (port <= 0)
+    return FALSE;
+  secret = strchr (port_buf->data, '\n');
+  if (! secret)
+    return FALSE;
+  secret++;
+  newline = strchr (secret, '\n');
+  if (newline)
+    *newline = '\0';
+  if (*secret == '\0')
+    return FALSE;
+
+  if (apr_socket_create (&sock, APR_INET, SOCK_STREAM, pool))
+    return FALSE;
+  if (apr_sockaddr_info_get (&sa, "127.0.0.1", APR_INET, port, 0, pool)
+      || apr_connect (sock, sa))
+    {
+      apr_socket_close (sock);
+      return FALSE;
+    }
+
+  /* From here on the daemon owns the command; a protocol failure is
+     reported as a failed command rather than silently rerun, since
+     the daemon may already have done part of the work. */
+  *exit_code = EXIT_FAILURE;
+
+  cwd = svn_stringbuf_create (".", pool);
+  err = svn_path_get_absolute (&cwd, cwd, pool);
+  if (err)
+    goto fail;
+
+  header = apr_psprintf (pool, "svn-daemon-1 %d\n", argc);
+  err = send_all (sock, header, strlen (header), pool);
+  if (err)
+    goto fail;
+  err = send_counted (sock, secret, pool);
+  if (err)
+    goto fail;
+  err = send_counted (sock, cwd->data, pool);
+  if (err)
+    goto fail;
+  for (i = 0; i < argc; i++)
+    {
+      err = send_counted (sock, argv[i], pool);
+      if (err)
+        goto fail;
+    }
+
+  /* Relay the response. */
+  err = recv_line (&header, sock, pool);
+  if (err)
+    goto fail;
+  space = strchr (header, ' ');
+  if (! space)
+    goto fail;
+  *exit_code = atoi (header);
+  outlen = atoi (space + 1);
+
+  if (outlen > 0)
+    {
+      char *output = apr_palloc (pool, outlen);
+
+      err = recv_all (sock, output, outlen, pool);
+      if (err)
+        goto fail;
+      fwrite (output, 1, outlen, stdout);
+      fflush (stdout);
+    }
+
+  apr_socket_close (sock);
+  return TRUE;
+
+ fail:
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      svn_error_clear_all (err);
+    }
+  apr_socket_close (sock);
+  return TRUE;
+
+#else  /* SVN_WIN32 */
+
+  return FALSE;
+
+#endif /* SVN_WIN32 */
+}
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../../tools/dev/svn-dev.el")
+ * end:
+ */
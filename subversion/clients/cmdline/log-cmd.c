@@ -222,6 +222,7 @@ svn_cl__log (apr_getopt_t *os,
                            &(opt_state->start_revision),
                            &(opt_state->end_revision),
                            opt_state->verbose,
+                           opt_state->limit,
                            log_message_receiver,
                            &lb,
                            pool));
@@ -69,6 +69,11 @@ const apr_getopt_option_t svn_cl__options[] =
     {"password",      svn_cl__auth_password_opt, 1, "specify a password ARG"},
     {"extensions",    'x', 1, "pass \"ARG\" as bundled options to GNU diff"},
     {"targets",       svn_cl__targets_opt, 1, "pass contents of file \"ARG\" as additional args"},
+    {"threads",       svn_cl__threads_opt, 1, "crawl status/commit with ARG worker threads"},
+    {"pipeline",      svn_cl__pipeline_opt, 0, "overlap local and network work during checkout/update/commit/diff"},
+    {"put-workers",   svn_cl__put_workers_opt, 1, "upload ARG file bodies concurrently during commit"},
+    {"limit",         svn_cl__limit_opt, 1, "show at most ARG log messages"},
+    {"ra-stats",      svn_cl__ra_stats_opt, 0, "print network transfer statistics on exit"},
     {0,               0, 0}
   };
 
@@ -124,7 +129,7 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
   { "checkout", svn_cl__checkout, {"co"},
     "Check out a working copy from a repository.\n"
     "usage: svn checkout REPOS_URL\n",    
-    {'d', 'r', 'D', 'q', 'n',
+    {'d', 'r', 'D', 'q', 'n', svn_cl__pipeline_opt, svn_cl__ra_stats_opt,
      svn_cl__auth_username_opt, svn_cl__auth_password_opt,
      svn_cl__xml_file_opt }  },
 
@@ -133,13 +138,22 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "unfinished operations, etc.\n"
     "usage: svn cleanup [TARGETS]\n",
     {0} },
+
+  { "daemon", svn_cl__daemon, {0},
+    "Run as a resident daemon, executing subcommands forwarded by\n"
+    "other svn processes, to amortize startup costs across many\n"
+    "invocations.  Clients forward to the daemon when the environment\n"
+    "variable SVN_DAEMON is set.  Stop the daemon by killing it.\n"
+    "usage: svn daemon\n",
+    {0} },
   
   { "commit", svn_cl__commit, {"ci"},
     "Send changes from your working copy to the repository.\n"
     "usage: svn commit [TARGETS]\n\n"
     "   Be sure to use one of -m or -F to send a log message;\n"
     "   the -r switch is only for use with --xml-file.\n",
-    {'m', 'F', 'q', svn_cl__targets_opt,
+    {'m', 'F', 'q', svn_cl__targets_opt, svn_cl__put_workers_opt,
+     svn_cl__threads_opt, svn_cl__pipeline_opt, svn_cl__ra_stats_opt,
      svn_cl__force_opt, svn_cl__auth_username_opt, svn_cl__auth_password_opt,
      svn_cl__xml_file_opt, 'r'} },
   
@@ -167,7 +181,7 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "Display local changes in the working copy, or changes between the\n"
     "working copy and the repository if a revision is given.\n"
     "usage: svn diff [-r REV1[:REV2]] [TARGETS]\n",
-    {'r', 'D', 'x', 'n',
+    {'r', 'D', 'x', 'n', svn_cl__pipeline_opt, svn_cl__ra_stats_opt,
      svn_cl__auth_username_opt, svn_cl__auth_password_opt} },
   
   { "help", svn_cl__help, {"?", "h"},
@@ -186,7 +200,8 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "    If no 3rd arg, copy top-level contents of PATH into REPOS_URL\n"
     "    directly.  Otherwise, create NEW_ENTRY underneath REPOS_URL and\n"
     "    begin copy there.  (-r is only needed if importing to --xml-file)\n",
-    {'F', 'm', 'q', svn_cl__auth_username_opt, svn_cl__auth_password_opt,
+    {'F', 'm', 'q', svn_cl__put_workers_opt, svn_cl__ra_stats_opt,
+     svn_cl__auth_username_opt, svn_cl__auth_password_opt,
      svn_cl__xml_file_opt, 'r'} },
   
   { "log", svn_cl__log, {0},
@@ -204,8 +219,9 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "    svn log http://www.example.com/repo/project/foo.c\n"
     "\n"
     "    svn log http://www.example.com/repo/project foo.c bar.c\n",
-    {'r', 'D', 'v', svn_cl__targets_opt, svn_cl__auth_username_opt,
-     svn_cl__auth_password_opt} },
+    {'r', 'D', 'v', svn_cl__targets_opt, svn_cl__limit_opt,
+     svn_cl__ra_stats_opt,
+     svn_cl__auth_username_opt, svn_cl__auth_password_opt} },
   
   { "merge", svn_cl__merge, {0},
     "merge:  apply the differences between two paths to a working copy path.\n"
@@ -217,7 +233,8 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "    - If WCPATH is omitted, a value of '.' is assumed.\n"
     "    - If PATH1 and PATH2 are identical, an alternate syntax is allowed:\n"
     "            svn merge -rN:M PATH [WCPATH]\n",
-    {'r', 'n', svn_cl__auth_username_opt, svn_cl__auth_password_opt} },
+    {'r', 'n', svn_cl__pipeline_opt, svn_cl__ra_stats_opt,
+     svn_cl__auth_username_opt, svn_cl__auth_password_opt} },
   
   { "mkdir", svn_cl__mkdir, {0},
     "Create a new directory under revision control.\n"
@@ -287,21 +304,23 @@ const svn_cl__cmd_desc_t svn_cl__cmd_table[] =
     "    _                    965       938     kfogel      ./autogen.sh\n"
     "    _      *             965       970    sussman      ./build.conf\n"
     "    M                    965       687        joe      ./buildcheck.sh\n",
-    { 'u', 'v', 'n', 'q',
+    { 'u', 'v', 'n', 'q', svn_cl__threads_opt, svn_cl__ra_stats_opt,
       svn_cl__auth_username_opt, svn_cl__auth_password_opt } },
   
   { "switch", svn_cl__switch, {"sw"},
     "Update working copy to mirror a new URL\n"
     "usage: switch [TARGET] REPOS_URL\n\n" /* ### should args be reversed? */
     "   Note:  this is the way to move a working copy to a new branch.\n",
-    {'r', 'n', svn_cl__force_opt} },
+    {'r', 'n', svn_cl__force_opt, svn_cl__pipeline_opt,
+     svn_cl__ra_stats_opt} },
  
   { "update", svn_cl__update, {"up"}, 
     "Bring changes from the repository into the working copy.\n"
     "usage: update [TARGETS]\n\n"
     "  If no revision given, bring working copy up-to-date with HEAD rev.\n"
     "  Else synchronize working copy to revision given by -r or -D.\n",
-    {'r', 'D', 'n', svn_cl__auth_username_opt,
+    {'r', 'D', 'n', svn_cl__pipeline_opt, svn_cl__ra_stats_opt,
+     svn_cl__auth_username_opt,
      svn_cl__auth_password_opt, svn_cl__xml_file_opt} },
 
   { NULL, NULL, {0}, NULL, {0} }
@@ -752,8 +771,11 @@ parse_date (svn_cl__opt_state_t *os, const char *arg, apr_pool_t *pool)
 
 /*** Main. ***/
 
+/* Parse ARGV and run the subcommand it names, returning the process
+   exit code.  This is main() in all but name; it is split out so the
+   daemon (daemon.c) can run commands in-process. */
 int
-main (int argc, const char * const *argv)
+svn_cl__run_command (int argc, const char * const *argv)
 {
   int ret;
   apr_status_t apr_err;
@@ -761,7 +783,7 @@ main (int argc, const char * const *argv)
   apr_pool_t *pool;
   int opt_id;
   const char *opt_arg;
-  apr_getopt_t *os;  
+  apr_getopt_t *os;
   svn_cl__opt_state_t opt_state;
   int received_opts[SVN_CL__MAX_OPTS];
   int i, num_opts = 0;
@@ -769,21 +791,6 @@ main (int argc, const char * const *argv)
   svn_boolean_t log_under_version_control = FALSE;
   svn_boolean_t log_is_pathname = FALSE;
 
-  /* FIXME: This is a first step towards support for localization in
-     `svn'.  In real life, this call would be
-
-         setlocale (LC_ALL, "");
-
-     so that initial help or error messages are displayed in the
-     language defined by the environment.  Right now, though, we don't
-     even care if the call fails.
-
-     (Actually, this is a no-op; according to the C standard, "C" is
-     the default locale at program startup.) */
-  setlocale (LC_ALL, "C");
-
-
-  apr_initialize ();
   pool = svn_pool_create (NULL);
   memset (&opt_state, 0, sizeof (opt_state));
 
@@ -897,6 +904,24 @@ main (int argc, const char * const *argv)
             log_under_version_control = TRUE;
         }
         break;
+      case svn_cl__threads_opt:
+        svn_wc_set_status_threads (atoi (opt_arg));
+        svn_client_set_commit_threads (atoi (opt_arg));
+        break;
+      case svn_cl__pipeline_opt:
+        svn_wc_set_install_pipeline (TRUE);
+        svn_client_set_commit_pipeline (TRUE);
+        svn_client_set_diff_prefetch (TRUE);
+        break;
+      case svn_cl__put_workers_opt:
+        svn_ra_dav_set_put_workers (atoi (opt_arg));
+        break;
+      case svn_cl__limit_opt:
+        opt_state.limit = atoi (opt_arg);
+        break;
+      case svn_cl__ra_stats_opt:
+        opt_state.ra_stats = TRUE;
+        break;
       case svn_cl__targets_opt:
 	{
 	  svn_stringbuf_t *buffer;
@@ -1072,11 +1097,65 @@ main (int argc, const char * const *argv)
   else
     {
       svn_pool_destroy (pool);
+
+      if (opt_state.ra_stats)
+        {
+          svn_ra_stats_t stats;
+
+          /* Sessions are folded into the process totals as their
+             pools die, so this must come after the destroy above. */
+          svn_client_get_ra_stats (&stats);
+          fprintf (stderr,
+                   "ra-stats: requests=%" APR_OFF_T_FMT
+                   " bytes-sent=%" APR_OFF_T_FMT
+                   " bytes-received=%" APR_OFF_T_FMT
+                   " network-usec=%" APR_TIME_T_FMT "\n",
+                   stats.requests,
+                   stats.bytes_sent,
+                   stats.bytes_received,
+                   stats.network_time);
+        }
+
       return EXIT_SUCCESS;
     }
 }
 
 
+int
+main (int argc, const char * const *argv)
+{
+  apr_pool_t *pool;
+  int exit_code;
+
+  /* FIXME: This is a first step towards support for localization in
+     `svn'.  In real life, this call would be
+
+         setlocale (LC_ALL, "");
+
+     so that initial help or error messages are displayed in the
+     language defined by the environment.  Right now, though, we don't
+     even care if the call fails.
+
+     (Actually, this is a no-op; according to the C standard, "C" is
+     the default locale at program startup.) */
+  setlocale (LC_ALL, "C");
+
+  apr_initialize ();
+
+  /* If the user opted in (by setting SVN_DAEMON) and a daemon is
+     running, hand the command to it and just relay the results. */
+  pool = svn_pool_create (NULL);
+  if (svn_cl__daemon_forward (&exit_code, argc, argv, pool))
+    {
+      svn_pool_destroy (pool);
+      return exit_code;
+    }
+  svn_pool_destroy (pool);
+
+  return svn_cl__run_command (argc, argv);
+}
+
+
 
 /* 
  * local variables:
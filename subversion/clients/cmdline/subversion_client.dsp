@@ -110,6 +110,10 @@ SOURCE=".\copy-cmd.c"
 # End Source File
 # Begin Source File
 
+SOURCE=.\daemon.c
+# End Source File
+# Begin Source File
+
 SOURCE=".\delete-cmd.c"
 # End Source File
 # Begin Source File
@@ -506,6 +506,25 @@ svn_error_t *svn_client_import (svn_client_commit_info_t **commit_info,
    SVN_INVALID_REVNUM, then the commit was a no-op; nothing needed to
    be committed.
  */
+/* Tell svn_client_commit to harvest local modifications with
+   NUM_THREADS worker threads when crawling a directory target.  Only
+   effective when APR has thread support; values less than two select
+   the ordinary single-threaded crawl.
+
+   A process-wide knob, like svn_wc_set_status_threads. */
+void svn_client_set_commit_threads (int num_threads);
+
+/* Tell svn_client_commit to overlap the working copy crawl with the
+   commit editor drive: candidates stream into the drive as they are
+   discovered instead of after the whole crawl.  A pipelined commit
+   anchors at the target directory's own URL rather than condensing to
+   the narrowest common ancestor, and hands the log message callback
+   an empty candidate list, since the candidates aren't known yet when
+   the message is needed.  Only effective when APR has thread support.
+
+   A process-wide knob, like svn_wc_set_install_pipeline. */
+void svn_client_set_commit_pipeline (svn_boolean_t enabled);
+
 svn_error_t *
 svn_client_commit (svn_client_commit_info_t **commit_info,
                    const svn_delta_editor_t *before_editor,
@@ -573,7 +592,11 @@ svn_client_status (apr_hash_t **statushash,
   
    If DISCOVER_CHANGED_PATHS is set, then the `changed_paths' argument
    to RECEIVER will be passed on each invocation.
-  
+
+   If LIMIT is greater than zero, invoke RECEIVER on at most LIMIT
+   messages; the repository stops walking revisions once satisfied.
+   Pass zero for no limit.
+
    If START->kind or END->kind is svn_revision_unspecified_kind,
    return the error SVN_ERR_CLIENT_BAD_REVISION.
 
@@ -585,11 +608,19 @@ svn_client_log (svn_client_auth_baton_t *auth_baton,
                 const svn_client_revision_t *start,
                 const svn_client_revision_t *end,
                 svn_boolean_t discover_changed_paths,
+                int limit,
                 svn_log_message_receiver_t receiver,
                 void *receiver_baton,
                 apr_pool_t *pool);
 
 
+/* Set whether remote diffs fetch base texts on a prefetch thread, so
+   each file's old text is being retrieved while the diff response is
+   still arriving.  Only effective when APR has thread support.
+
+   A process-wide knob, like svn_client_set_commit_pipeline. */
+void svn_client_set_diff_prefetch (svn_boolean_t enabled);
+
 /* Produce diff output which describes the delta between
    PATH1/REVISION1 and PATH2/REVISION2.  Print the output of the diff
    to OUTFILE, and any errors to ERRFILE.
@@ -864,6 +895,19 @@ svn_error_t *svn_client_get_cancellation_editor
 
 
 
+/* Transfer statistics. */
+
+/* Set *STATS to the wire traffic this process has generated through
+   the RA layer so far: every RA session is folded into a process-wide
+   total as it is closed.  Sessions still open are not yet included.
+   RA layers with no wire (ra_local) contribute zeroes.
+
+   The caller may invoke this after the pools driving the operations
+   are destroyed; the totals live for the life of the process. */
+void svn_client_get_ra_stats (svn_ra_stats_t *stats);
+
+
+
 
 
 #ifdef __cplusplus
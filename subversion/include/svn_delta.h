@@ -149,6 +149,21 @@ typedef svn_error_t * (*svn_txdelta_window_handler_t)
                       (svn_txdelta_window_t *window, void *baton);
 
 
+/* Compose two delta windows.  WINDOW_A turns a source view into some
+   intermediate text; WINDOW_B turns that intermediate text into the
+   target text.  Return a window that turns WINDOW_A's source view
+   directly into the target text, without ever materializing the
+   intermediate fulltext.  The result is allocated in POOL and shares
+   no structure with its inputs.
+
+   This is what makes it cheap to collapse a chain of stored deltas
+   into a single delta before applying it.  */
+svn_txdelta_window_t *
+svn_txdelta_compose_windows (const svn_txdelta_window_t *window_a,
+                             const svn_txdelta_window_t *window_b,
+                             apr_pool_t *pool);
+
+
 /* A delta stream --- this is the hat from which we pull a series of
    svn_txdelta_window_t objects, which, taken in order, describe the
    entire target string.  This type is defined within libsvn_delta, and
@@ -166,11 +181,70 @@ svn_error_t *svn_txdelta_next_window (svn_txdelta_window_t **window,
                                       apr_pool_t *pool);
 
 
+/* Like svn_txdelta_next_window, but recycle window storage instead
+   of allocating each window afresh.  PREV_WINDOW must be the window
+   the previous call on STREAM returned, or NULL on the first call;
+   passing it back says the caller is done with its contents, and
+   *WINDOW gets the same storage refilled with the next window.  The
+   op array and new data live as long as STREAM, so a long drive
+   reuses one buffer per stream instead of churning a pool per
+   window.  POOL only holds per-window scratch data and may be
+   cleared between calls.
+
+   Do not mix calls to this function and svn_txdelta_next_window on
+   the same stream.  */
+svn_error_t *svn_txdelta_next_window_reuse (svn_txdelta_window_t **window,
+                                            svn_txdelta_window_t *prev_window,
+                                            svn_txdelta_stream_t *stream,
+                                            apr_pool_t *pool);
+
+
+/* A checkpoint in a delta stream: enough state to position a fresh
+   stream, reading the same source and target data, just past the
+   window the checkpoint was taken at.  A caller that remembers how
+   many windows it has transmitted successfully can resume an
+   interrupted transfer from there instead of starting over.  */
+typedef struct svn_txdelta_checkpoint_t
+{
+  apr_off_t window_index;       /* number of windows pulled so far */
+  apr_off_t source_offset;      /* bytes of source data consumed */
+  apr_off_t target_offset;      /* bytes of target data consumed */
+} svn_txdelta_checkpoint_t;
+
+
+/* Record STREAM's current position in *CHECKPOINT.  Call this only
+   between windows, i.e. not while a window pulled from STREAM is
+   still being transmitted.  */
+void svn_txdelta_checkpoint (svn_txdelta_checkpoint_t *checkpoint,
+                             svn_txdelta_stream_t *stream);
+
+
+/* Fast-forward STREAM to CHECKPOINT.  STREAM must be freshly created
+   over the same source and target contents the checkpoint was taken
+   against, and must not have produced any windows yet.  The skipped
+   windows' data is read and folded into the stream's bookkeeping
+   (MD5 digest, window sizing) without computing their deltas, so
+   subsequent windows come out exactly as they would have from the
+   original stream.  Returns SVN_ERR_INCORRECT_PARAMS if the stream's
+   position after the skip does not match the checkpoint's recorded
+   offsets.  Uses POOL for temporary allocations.  */
+svn_error_t *svn_txdelta_resume (svn_txdelta_stream_t *stream,
+                                 const svn_txdelta_checkpoint_t *checkpoint,
+                                 apr_pool_t *pool);
+
+
 /* Return the MD5 digest for the complete fulltext deltified by
    STREAM, or NULL if STREAM has not yet returned its final NULL
    window.  The digest is allocated in the same memory as STREAM.  */
 const unsigned char *svn_txdelta_md5_digest (svn_txdelta_stream_t *stream);
 
+/* Return TRUE if STREAM's source and target data turned out to be
+   byte-for-byte identical.  Only meaningful after STREAM has
+   returned its final NULL window; before that this returns FALSE.
+   Consumers can use this to skip installing a new text that is
+   really the old text over again.  */
+svn_boolean_t svn_txdelta_stream_unchanged (svn_txdelta_stream_t *stream);
+
 /* Set *STREAM to a pointer to a delta stream that will turn the byte
    string from SOURCE into the byte stream from TARGET.
 
@@ -185,6 +259,20 @@ void svn_txdelta (svn_txdelta_stream_t **stream,
                   apr_pool_t *pool);
 
 
+/* Set the delta window size of STREAM to WINDOW_SIZE bytes.
+
+   By default a delta stream starts with a small window and doubles
+   the window size after each window it produces, so small targets
+   get cheap windows and big targets get long match distances.  A
+   caller that knows the size of its data can pin the window size
+   with this function instead; WINDOW_SIZE is clamped to sane bounds.
+
+   This only has an effect if called before the first call to
+   `svn_txdelta_next_window' on STREAM.  */
+void svn_txdelta_set_window_size (svn_txdelta_stream_t *stream,
+                                  apr_size_t window_size);
+
+
 /* Send the contents of STRING to window-handler HANDLER/BATON. This is
    effectively a 'copy' operation, resulting in delta windows that make
    the target equivalent to the value of STRING.
@@ -231,6 +319,31 @@ void svn_txdelta_apply (svn_stream_t *source,
                         void **handler_baton);
 
 
+/* Like svn_txdelta_apply, but the source data comes from the open
+   file SOURCE_FILE.  Where the platform allows it the file is
+   memory-mapped and instructions copy directly out of the mapping,
+   skipping the per-window source buffering entirely; otherwise this
+   behaves exactly like svn_txdelta_apply on a file stream.
+   SOURCE_FILE must stay open until the null window has been sent to
+   *HANDLER.  */
+void svn_txdelta_apply_file (apr_file_t *source_file,
+                             svn_stream_t *target,
+                             apr_pool_t *pool,
+                             svn_txdelta_window_handler_t *handler,
+                             void **handler_baton);
+
+
+/* Return the MD5 digest of the full target text reconstructed by an
+   application set up with svn_txdelta_apply or svn_txdelta_apply_file,
+   or NULL if the null (final) window has not yet been handed to the
+   window handler.  HANDLER_BATON is the baton the setup call returned;
+   the digest is allocated in the same memory.  This is the applying
+   counterpart of svn_txdelta_md5_digest: the producer digests the
+   target it read, the consumer digests the target it wrote, and the
+   two must agree when the transfer was undamaged.  */
+const unsigned char *svn_txdelta_apply_digest (void *handler_baton);
+
+
 
 /*** Producing and consuming svndiff-format text deltas.  ***/
 
@@ -244,6 +357,20 @@ void svn_txdelta_to_svndiff (svn_stream_t *output,
                              svn_txdelta_window_handler_t *handler,
                              void **handler_baton);
 
+/* The latest svndiff format version defined.  Version 0 is the plain
+   format; version 1 deflates the instruction and new-data sections of
+   each window with zlib.  */
+#define SVN_SVNDIFF_MAX_VERSION 1
+
+/* Like svn_txdelta_to_svndiff, but produce format version VERSION.
+   VERSION is clamped to the range this build can actually encode; a
+   build without zlib always writes version 0.  */
+void svn_txdelta_to_svndiff_version (svn_stream_t *output,
+                                     apr_pool_t *pool,
+                                     int version,
+                                     svn_txdelta_window_handler_t *handler,
+                                     void **handler_baton);
+
 /* Return a writable generic stream which will parse svndiff-format
    data into a text delta, invoking HANDLER with HANDLER_BATON
    whenever a new window is ready.  If ERROR_ON_EARLY_CLOSE is TRUE,
@@ -255,6 +382,24 @@ svn_stream_t *svn_txdelta_parse_svndiff (svn_txdelta_window_handler_t handler,
                                          svn_boolean_t error_on_early_close,
                                          apr_pool_t *pool);
 
+/* Like svn_txdelta_parse_svndiff, but for vcdiff-format data, the
+   format of xdelta and friends, so foreign patch sets can be applied
+   at delta cost instead of being expanded to fulltext first.  The
+   windows handed to HANDLER take their source views from the vcdiff
+   source file, so drive HANDLER as you would for a delta whose base
+   is that file.
+
+   Secondary compressors, application-defined code tables, and
+   windows that copy from earlier target windows are not supported,
+   and are reported as SVN_ERR_VCDIFF_UNSUPPORTED; encoders working
+   from a source file don't produce them.  If ERROR_ON_EARLY_CLOSE is
+   TRUE, closing the stream mid-stream results in
+   SVN_ERR_VCDIFF_UNEXPECTED_END.  */
+svn_stream_t *svn_txdelta_parse_vcdiff (svn_txdelta_window_handler_t handler,
+                                        void *handler_baton,
+                                        svn_boolean_t error_on_early_close,
+                                        apr_pool_t *pool);
+
 
 
 /*** Traversing tree deltas. ***/
@@ -770,6 +915,31 @@ svn_delta_compose_editors (const svn_delta_editor_t **new_editor,
                            apr_pool_t *pool);
 
 
+/* Flatten the composition tree rooted at EDITOR, EDIT_BATON (built
+ * by svn_delta_compose_editors or svn_delta_wrap_editor) into a
+ * single editor, returned in *NEW_EDITOR, *NEW_EDIT_BATON, allocated
+ * in POOL.
+ *
+ * A composed editor forwards every call through a wrapper pair per
+ * layer; the flattened editor dispatches each call in one loop over
+ * the leaf editors instead, and skips a leaf entirely when its
+ * implementation of that call is null or the do-nothing default from
+ * svn_delta_default_editor().
+ *
+ * Ordering and error behavior are those of the composition: leaves
+ * run in composition order, and the first error stops the call.
+ *
+ * If EDITOR is not a composed editor, *NEW_EDITOR and
+ * *NEW_EDIT_BATON are simply set to EDITOR and EDIT_BATON.
+ */
+void
+svn_delta_fuse_editor (const svn_delta_editor_t **new_editor,
+                       void **new_edit_baton,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_pool_t *pool);
+
+
 /* Compose BEFORE_EDITOR, BEFORE_EDIT_BATON with MIDDLE_EDITOR,
  * MIDDLE_EDIT_BATON, then compose the result with AFTER_EDITOR,
  * AFTER_EDIT_BATON, all according to the conventions of
@@ -870,7 +1040,7 @@ struct svn_pipe_handler_wrapper
  * possibly intercept and modify any commands the editor-driver is
  * sending to the wrapped editor.
  */
-void 
+void
 svn_delta_old_default_pipe_editor (svn_delta_edit_fns_t **new_editor,
                                    struct svn_pipe_edit_baton **new_edit_baton,
                                    const svn_delta_edit_fns_t *editor_to_wrap,
@@ -878,6 +1048,30 @@ svn_delta_old_default_pipe_editor (svn_delta_edit_fns_t **new_editor,
                                    apr_pool_t *pool);
 
 
+/* Like the pipe editor above, but instead of forwarding each call to
+ * EDITOR_TO_WRAP as it arrives, queue events and replay them to the
+ * wrapped editor in groups of BATCH_SIZE.  This lets a consumer with
+ * per-call setup costs amortize that setup across many events, at
+ * the price of the wrapped editor seeing events late.
+ *
+ * The queue is also flushed by apply_textdelta (whose windows then
+ * stream straight through to the wrapped editor, unbatched) and by
+ * close_edit; abort_edit discards any pending events before
+ * forwarding the abort.  Events are always replayed in arrival
+ * order, so the wrapped editor sees a legal drive.
+ *
+ * A BATCH_SIZE less than one is treated as one, which is equivalent
+ * to the plain pipe editor.
+ */
+void
+svn_delta_old_batching_pipe_editor (svn_delta_edit_fns_t **new_editor,
+                                    void **new_edit_baton,
+                                    const svn_delta_edit_fns_t *editor_to_wrap,
+                                    void *edit_baton_to_wrap,
+                                    int batch_size,
+                                    apr_pool_t *pool);
+
+
 
 /* Creates an editor which outputs XML delta streams to OUTPUT.  On
    return, *EDITOR and *EDITOR_BATON will be set to the editor and its
@@ -891,6 +1085,35 @@ svn_delta_get_xml_editor (svn_stream_t *output,
 
 
 
+/* Creates an editor which serializes its drive as a compact binary
+   frame stream on OUTPUT.  This has the same drive semantics as the
+   XML editor above but costs no escaping or base64 bloat, so it is
+   the better choice for local pipes and replication between
+   Subversion processes.  The one restriction is that the driver must
+   finish each file (through close_file) before touching any other
+   file or directory; "postfix" text deltas are not supported.
+
+   On return, *EDITOR and *EDIT_BATON will be set to the editor and
+   its associated baton.  The editor's memory will live in a sub-pool
+   of POOL. */
+svn_error_t *
+svn_delta_get_binary_editor (svn_stream_t *output,
+                             const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             apr_pool_t *pool);
+
+
+/* Reads a binary editor frame stream (as produced by
+   svn_delta_get_binary_editor) from SOURCE and drives EDITOR with
+   EDIT_BATON accordingly.  Like svn_delta_xml_auto_parse, this
+   retains control and "pulls" data from SOURCE until the edit
+   completes or an error occurs. */
+svn_error_t *svn_delta_binary_auto_parse (svn_stream_t *source,
+                                          const svn_delta_edit_fns_t *editor,
+                                          void *edit_baton,
+                                          apr_pool_t *pool);
+
+
 /* An opaque object that represents a Subversion Delta XML parser. */
 
 typedef struct svn_delta_xml_parser_t svn_delta_xml_parser_t;
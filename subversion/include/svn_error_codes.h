@@ -380,6 +380,22 @@ SVN_ERROR_START
 
   /* END svndiff errors */
 
+  /* BEGIN vcdiff errors */
+
+  SVN_ERRDEF (SVN_ERR_VCDIFF_INVALID_HEADER,
+              "Vcdiff data has invalid header")
+
+  SVN_ERRDEF (SVN_ERR_VCDIFF_UNSUPPORTED,
+              "Vcdiff data uses a feature this decoder does not support")
+
+  SVN_ERRDEF (SVN_ERR_VCDIFF_CORRUPT_WINDOW,
+              "Vcdiff data contains corrupt window")
+
+  SVN_ERRDEF (SVN_ERR_VCDIFF_UNEXPECTED_END,
+              "Vcdiff data ends unexpectedly")
+
+  /* END vcdiff errors */
+
   /* BEGIN mod_dav_svn errors */
 
   SVN_ERRDEF (SVN_ERR_APMOD_MISSING_PATH_TO_FS,
@@ -28,6 +28,7 @@ extern "C" {
 #include <apr_pools.h>
 #include <apr_hash.h>
 #include <apr_tables.h>
+#include <apr_time.h>
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_delta.h"
@@ -111,6 +112,120 @@ void svn_fs_set_warning_func (svn_fs_t *fs,
 svn_error_t *svn_fs_create_berkeley (svn_fs_t *fs, const char *path);
 
 
+/* Tuning the Berkeley DB environment.
+
+   The following functions adjust how FS sets up its Berkeley DB
+   environment.  They only record settings on FS, to be applied when
+   the environment is created or opened, so they must be called after
+   svn_fs_new and before svn_fs_create_berkeley or
+   svn_fs_open_berkeley; calling them on an open filesystem returns
+   an SVN_ERR_FS_ALREADY_OPEN error.  */
+
+
+/* Set the size, in bytes, of FS's Berkeley DB shared memory buffer
+   pool --- the database page cache --- to CACHE_SIZE.  This is the
+   single biggest server-side throughput lever there is: for good
+   performance, the cache should approximate the repository's working
+   set.  Berkeley DB's default is a scant 256k.  A CACHE_SIZE of zero
+   restores the default.
+
+   This function calls `DBENV->set_cachesize'.  */
+svn_error_t *svn_fs_set_berkeley_cache_size (svn_fs_t *fs,
+                                             apr_size_t cache_size);
+
+
+/* Store FS's Berkeley DB log files under LOG_DIR, rather than in the
+   environment directory.  Putting the logs on a separate disk from
+   the database files avoids seeking between the two on every log
+   write.  If LOG_DIR is relative, Berkeley DB interprets it relative
+   to the environment directory.
+
+   This function calls `DBENV->set_lg_dir'.  */
+svn_error_t *svn_fs_set_berkeley_log_dir (svn_fs_t *fs,
+                                          const char *log_dir);
+
+
+/* After committing a Berkeley DB transaction, have FS checkpoint its
+   log only if at least KBYTES kilobytes of log data have been
+   written, or at least MINUTES minutes have passed, since the last
+   checkpoint.  If both values are zero, checkpoint after every
+   commit.  The default policy is 1024 kbytes or 5 minutes.
+
+   Unlike the functions above, this may be called on an open
+   filesystem; the new policy applies from the next commit on.  */
+svn_error_t *svn_fs_set_berkeley_checkpoint_policy (svn_fs_t *fs,
+                                                    int kbytes,
+                                                    int minutes);
+
+
+/* If TRUSTED is TRUE, have FS skip the structural re-validation of
+   records it reads back from the database.  Everything in the
+   database was validated when it was written, so on a healthy
+   repository these checks only burn CPU on every read; a server
+   that wants them anyway (say, on suspect hardware) can leave this
+   off.  Writes are always validated, and `svnadmin verify' checks
+   the whole repository regardless of this setting.  */
+void svn_fs_set_trusted_reads (svn_fs_t *fs,
+                               svn_boolean_t trusted);
+
+
+/* Have FS store a file's contents as plain fulltext, rather than
+   deltifying them at commit time, when the contents are smaller than
+   MIN_SIZE bytes or larger than MAX_SIZE bytes.  Tiny files cost
+   more in delta bookkeeping than their contents are worth, and very
+   large or already-compressed files deltify poorly while making
+   retrieval ever more expensive as their delta chains grow.
+
+   A MIN_SIZE of zero sets no lower bound; a MAX_SIZE of zero sets no
+   upper bound.  Return SVN_ERR_INCORRECT_PARAMS if MAX_SIZE is
+   non-zero but less than MIN_SIZE.  The default policy deltifies
+   everything up to the svndiff window size (SVN_STREAM_CHUNK_SIZE).
+
+   This may be called on an open filesystem; the new policy applies
+   to subsequent commits.  Representations already written are not
+   revisited.  */
+svn_error_t *svn_fs_set_deltification_limits (svn_fs_t *fs,
+                                              apr_size_t min_size,
+                                              apr_size_t max_size);
+
+
+/* Counters describing a filesystem's traffic against its Berkeley DB
+   tables.  The counters are maintained only when the library is
+   compiled with -DSVN_FS_TRAIL_STATS; in ordinary builds they stay
+   zero, and the hot paths pay nothing for them.  */
+typedef struct svn_fs_stats_t
+{
+  /* Records read through DB->get.  */
+  apr_off_t db_gets;
+
+  /* Records written or deleted through DB->put and DB->del.  */
+  apr_off_t db_puts;
+
+  /* Cursor operations: opening a cursor, and reading, writing, or
+     deleting through one.  */
+  apr_off_t db_cursor_ops;
+
+  /* Berkeley DB transactions begun, and how many of those were
+     restarts after a deadlock.  */
+  apr_off_t trails;
+  apr_off_t deadlocks;
+
+  /* Total wall-clock time spent inside Berkeley DB transactions, in
+     microseconds.  */
+  apr_time_t trail_time;
+
+} svn_fs_stats_t;
+
+
+/* Copy FS's accumulated statistics into *STATS.  Callers wanting
+   per-operation figures can snapshot the counters before the
+   operation and subtract.  */
+void svn_fs_get_stats (svn_fs_stats_t *stats, svn_fs_t *fs);
+
+/* Reset all of FS's statistics counters to zero.  */
+void svn_fs_reset_stats (svn_fs_t *fs);
+
+
 /* Make FS refer to the Berkeley DB-based Subversion filesystem at
    PATH.  PATH must refer to a file or directory created by
    `svn_fs_create_berkeley'.
@@ -181,6 +296,148 @@ svn_error_t *svn_fs_berkeley_recover (const char *path,
                                       apr_pool_t *pool);
 
 
+/* Watching for new revisions.
+
+   Every successful commit rewrites a small `commit-stamp' file in the
+   filesystem's directory, recording the number of the revision it
+   created.  A process that merely wants to notice new revisions ---
+   say, a build system polling dozens of repositories --- can read
+   that file without opening the filesystem, and so without paying for
+   a Berkeley DB environment or transaction per poll.
+
+   The stamp is a hint, not an oracle: a filesystem that has never
+   seen a commit from a stamp-writing library has no stamp at all, and
+   when several processes commit at once the stamp may briefly trail
+   the true youngest revision.  Use it to decide *when* to look;
+   use svn_fs_youngest_rev to learn the authoritative answer.  */
+
+/* Set *YOUNGEST_P to the revision recorded in the commit stamp of the
+   filesystem whose directory is PATH, without opening the filesystem.
+   If there is no stamp, set *YOUNGEST_P to SVN_INVALID_REVNUM.  Use
+   POOL for temporary allocation.  */
+svn_error_t *svn_fs_read_commit_stamp (svn_revnum_t *youngest_p,
+                                       const char *path,
+                                       apr_pool_t *pool);
+
+
+/* Block until the commit stamp of the filesystem whose directory is
+   PATH records a revision younger than LAST_SEEN, then set
+   *YOUNGEST_P to the stamped revision.
+
+   If TIMEOUT is positive, give up after that many microseconds and
+   set *YOUNGEST_P to whatever the stamp last said (possibly
+   SVN_INVALID_REVNUM); the caller can tell a timeout from a commit by
+   comparing against LAST_SEEN.  If TIMEOUT is zero, wait
+   indefinitely.  Use POOL for temporary allocation.
+
+   The wait is a sleeping poll of the stamp file, so it burns no
+   database resources while idle.  */
+svn_error_t *svn_fs_wait_for_commit (svn_revnum_t *youngest_p,
+                                     const char *path,
+                                     svn_revnum_t last_seen,
+                                     apr_interval_time_t timeout,
+                                     apr_pool_t *pool);
+
+
+/* Set *LOGFILES to an array of `const char *' log file names from
+   the Berkeley DB environment PATH, each name relative to that
+   environment directory, ordered oldest first.  If ONLY_UNUSED is
+   non-zero, list only the log files that normal recovery of the live
+   environment no longer needs --- the set that may safely be
+   archived away.  Otherwise, list every log file the environment
+   has.  Do any necessary allocation in POOL.
+
+   This may be called on a live environment; it joins nothing and
+   leaves no shared regions behind.  */
+svn_error_t *svn_fs_berkeley_logfiles (apr_array_header_t **logfiles,
+                                       const char *path,
+                                       svn_boolean_t only_unused,
+                                       apr_pool_t *pool);
+
+
+/* Copy the Berkeley DB-based Subversion filesystem stored in the
+   environment SRC_PATH into the directory DEST_PATH (creating it if
+   it does not exist), while the source remains live.  This follows
+   the hot-backup procedure documented by Berkeley DB: the database
+   files are copied first, the log files after them, and then
+   catastrophic recovery is run on the copy, so the result is a
+   consistent filesystem no matter what commits were in flight.
+
+   If INCREMENTAL is non-zero, skip the database files and ship only
+   the log segments that DEST_PATH does not already hold from an
+   earlier run; a full copy must have been made into DEST_PATH first.
+
+   Do any necessary allocation in POOL.  */
+svn_error_t *svn_fs_berkeley_hotcopy (const char *src_path,
+                                      const char *dest_path,
+                                      svn_boolean_t incremental,
+                                      apr_pool_t *pool);
+
+
+/* Check the integrity of the filesystem FS's underlying tables,
+   doing any necessary allocation in POOL.
+
+   This walks every record of the `nodes', `representations',
+   `strings', `revisions', and `transactions' tables once with a
+   sequential cursor, validates each record's syntax, and checks that
+   every reference from one table into another resolves.  Unlike a
+   full tree walk, it never reconstructs file contents, so its
+   running time is proportional to the raw size of the database ---
+   making a routine integrity pass over a large repository feasible.
+
+   Return SVN_ERR_FS_CORRUPT, with a message naming the offending
+   record, for the first problem found; return SVN_NO_ERROR if the
+   tables are sound.  */
+svn_error_t *svn_fs_verify (svn_fs_t *fs,
+                            apr_pool_t *pool);
+
+
+/* Delete the records in FS's `strings' table that no representation
+   references any more --- the debris left behind by aborted
+   transactions and obsolete fulltexts.  Set *DELETED_COUNT (if it is
+   non-null) to the number of strings removed.
+
+   The collection runs as a single database transaction, so readers
+   never see a partial sweep, but it takes read locks across whole
+   tables and is best run when the repository is quiet.  The freed
+   pages go back on Berkeley DB's free list; the database file does
+   not shrink, but it stops growing until the reclaimed space is
+   used up.  */
+svn_error_t *svn_fs_gc (apr_size_t *deleted_count,
+                        svn_fs_t *fs,
+                        apr_pool_t *pool);
+
+
+
+/* Batched read access.  */
+
+/* Invoke BATCH_BODY, passing it BATON and a pool, with all the
+   filesystem reads it performs against FS sharing a single Berkeley
+   DB transaction.
+
+   Normally, every filesystem call opens and commits a database
+   transaction of its own.  That's the right thing for isolated calls,
+   but an operation like a checkout makes thousands of small reads,
+   and the per-call transaction overhead comes to dominate.  Wrapping
+   such a read loop in a batch amortizes that overhead, and gives the
+   whole batch a consistent view of the filesystem to boot.
+
+   If the database deadlocks during the batch, the transaction is
+   aborted and BATCH_BODY is invoked again from the top, so BATCH_BODY
+   must be harmlessly re-runnable.  For that same reason, BATCH_BODY
+   must only read: a write redone on retry would be done twice, and
+   would hold its locks for the whole batch, blocking committers.
+   Keep batches to a reasonable size --- a transaction held open
+   across a huge walk pins database locks and log space.
+
+   Do not open a batch from within another batch's body.  */
+svn_error_t *svn_fs_read_batch (svn_fs_t *fs,
+                                svn_error_t *(*batch_body) (void *baton,
+                                                            apr_pool_t *pool),
+                                void *baton,
+                                apr_pool_t *pool);
+
+
 
 /* Node and Node Revision ID's.  */
 
@@ -505,6 +762,47 @@ svn_error_t *svn_fs_list_transactions (char ***names_p,
                                        svn_fs_t *fs,
                                        apr_pool_t *pool);
 
+
+/* Purge the transactions whose names appear in NAMES (an array of
+   `const char *' elements) from FS, doing any necessary allocation
+   in POOL.  Set *PURGED_COUNT (if it is non-null) to the number of
+   transactions removed.
+
+   This has the same effect as aborting each transaction, but
+   batched: the mutable nodes of all the named transactions are
+   collected first and then deleted in one sequential pass over the
+   `nodes' table, so purging a large accumulation of dead
+   transactions costs a single table sweep instead of a btree lookup
+   per node.  The whole purge is one database transaction; readers
+   never see it half done.
+
+   The caller must name only dead transactions --- purging a
+   transaction someone is still driving leaves that driver holding
+   dangling node revision IDs.  */
+svn_error_t *svn_fs_purge_txns (apr_size_t *purged_count,
+                                svn_fs_t *fs,
+                                apr_array_header_t *names,
+                                apr_pool_t *pool);
+
+
+/* Like svn_fs_purge_txns, but choose the victims by age: purge every
+   transaction in FS whose creation datestamp (the `svn:date'
+   property that svn_fs_begin_txn sets) is earlier than CUTOFF.  A
+   transaction with no datestamp predates the datestamps themselves
+   and is purged too.  Set *PURGED_COUNT (if it is non-null) to the
+   number of transactions removed.
+
+   Pick CUTOFF comfortably earlier than any transaction that might
+   still be live; an in-progress commit's transaction is
+   indistinguishable from an abandoned one.  This is cheap enough to
+   run from a nightly job, which keeps a busy repository from
+   accreting dead transactions at all.  */
+svn_error_t *svn_fs_purge_old_txns (apr_size_t *purged_count,
+                                    svn_fs_t *fs,
+                                    apr_time_t cutoff,
+                                    apr_pool_t *pool);
+
+
 /* Transaction properties */
 
 /* Set *VALUE_P to the value of the property named PROPNAME on
@@ -925,6 +1223,35 @@ svn_error_t *svn_fs_dir_entries (apr_hash_t **entries_p,
                                  apr_pool_t *pool);
 
 
+/* The type of a callback for svn_fs_dir_entries_iterate, invoked
+   once per directory entry in the order the entries are stored.
+   ENTRY --- including its name and ID --- is only valid for the
+   duration of the call; copy anything you keep.  POOL may be used
+   for temporary allocations, which likewise do not survive the
+   call.  */
+typedef svn_error_t *(*svn_fs_dirent_receiver_t) (void *baton,
+                                                  const svn_fs_dirent_t *entry,
+                                                  apr_pool_t *pool);
+
+
+/* Invoke RECEIVER, with RECEIVER_BATON, on each entry of the
+   directory at PATH in ROOT.  Unlike svn_fs_dir_entries, this does
+   not build a hash of the whole directory first --- one dirent is
+   recycled across the calls --- so walking a huge directory takes
+   constant memory.
+
+   Note that the walk runs inside a Berkeley DB transaction; if that
+   transaction deadlocks and retries, RECEIVER is invoked again from
+   the first entry, so receivers with external side effects should
+   only be used where writers cannot interfere.  Uses POOL for
+   temporary allocations.  */
+svn_error_t *svn_fs_dir_entries_iterate (svn_fs_root_t *root,
+                                         const char *path,
+                                         svn_fs_dirent_receiver_t receiver,
+                                         void *receiver_baton,
+                                         apr_pool_t *pool);
+
+
 /* Create a new directory named PATH in ROOT.  The new directory has
    no entries, and no properties.  ROOT must be the root of a
    transaction, not a revision.
@@ -1027,6 +1354,19 @@ svn_error_t *svn_fs_file_length (apr_off_t *length_p,
                                  apr_pool_t *pool);
 
 
+/* Put the MD5 checksum of the file PATH in ROOT into DIGEST, which
+   must point to 16 bytes of storage.  The checksum is the one the
+   filesystem recorded when the file's contents were committed, so
+   this is cheap: no file data is read.  If no checksum is recorded
+   for the file --- it predates checksum recording --- DIGEST is set
+   to all zeros, which is not a valid MD5 digest.  Do any necessary
+   temporary allocation in POOL.  */
+svn_error_t *svn_fs_file_md5_checksum (unsigned char digest[],
+                                       svn_fs_root_t *root,
+                                       const char *path,
+                                       apr_pool_t *pool);
+
+
 /* Set *CONTENTS to a readable generic stream will yield the contents
    of the file PATH in ROOT.  Allocate the stream in POOL.  You can
    only use *CONTENTS for as long as the underlying filesystem is
@@ -1088,6 +1428,27 @@ svn_error_t *svn_fs_contents_changed (int *changed_p,
                                       apr_pool_t *pool);
 
 
+/* Set *PROPS_CHANGED_P to 1 if the properties at PATH1 under ROOT1
+   differ from those at PATH2 under ROOT2, and set *CONTENTS_CHANGED_P
+   likewise for the two nodes' contents; set them to 0 where the two
+   are the same.  Either output pointer may be null if the caller
+   doesn't care about that answer.
+
+   This answers both questions with a single filesystem transaction,
+   where calling svn_fs_props_changed and svn_fs_contents_changed in
+   turn would use two.
+
+   Both paths must exist under their respective roots, and both roots
+   must be in the same filesystem.  */
+svn_error_t *svn_fs_things_changed (int *props_changed_p,
+                                    int *contents_changed_p,
+                                    svn_fs_root_t *root1,
+                                    const char *path1,
+                                    svn_fs_root_t *root2,
+                                    const char *path2,
+                                    apr_pool_t *pool);
+
+
 
 /* Filesystem revisions.  */
 
@@ -1141,6 +1502,35 @@ svn_error_t *svn_fs_change_rev_prop (svn_fs_t *fs,
                                      apr_pool_t *pool);
 
 
+/* Set *CHANGED_PATHS_P to a hash describing the paths changed in
+   revision REV of filesystem FS, read from the filesystem's
+   changed-paths index.  The hash maps paths (byte strings, beginning
+   with `/') to (void *) 'A', 'D', or 'R', for added, deleted, or
+   replaced.  Allocate the hash and its contents in POOL.
+
+   The index is populated as commits happen, so revisions committed
+   before the index existed have no entry; for those, set
+   *CHANGED_PATHS_P to null, and let the caller fall back on
+   comparing revision trees (or build the index with `svnadmin
+   build-changes').  */
+svn_error_t *svn_fs_paths_changed (apr_hash_t **changed_paths_p,
+                                   svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_pool_t *pool);
+
+
+/* Record CHANGED_PATHS --- a hash in the format svn_fs_paths_changed
+   returns --- as the changed-paths index entry for revision REV of
+   filesystem FS, replacing whatever the index held for REV before.
+   This exists so the index can be rebuilt for revisions committed
+   before it was kept; normal commits maintain it automatically.  Do
+   any necessary temporary allocation in POOL.  */
+svn_error_t *svn_fs_set_paths_changed (svn_fs_t *fs,
+                                       svn_revnum_t rev,
+                                       apr_hash_t *changed_paths,
+                                       apr_pool_t *pool);
+
+
 
 /* Computing deltas.  */
 
@@ -1162,6 +1552,29 @@ svn_fs_get_file_delta_stream (svn_txdelta_stream_t **stream_p,
                               apr_pool_t *pool);
 
 
+/* Send a delta that turns the contents of the file SOURCE into the
+   contents of the file TARGET, as a series of windows to
+   HANDLER/HANDLER_BATON, followed by the final null window.  If
+   SOURCE_ROOT is zero, use a file with zero length as the source.
+
+   When the filesystem already stores TARGET's contents as a delta
+   made against SOURCE's contents, the stored windows are served
+   directly from storage; otherwise the delta is computed, as
+   svn_fs_get_file_delta_stream would.
+
+   This function does not compare the two files' properties.
+
+   Do any necessary temporary allocation in POOL.  */
+svn_error_t *
+svn_fs_send_file_delta (svn_txdelta_window_handler_t handler,
+                        void *handler_baton,
+                        svn_fs_root_t *source_root,
+                        const char *source_path,
+                        svn_fs_root_t *target_root,
+                        const char *target_path,
+                        apr_pool_t *pool);
+
+
 
 
 
@@ -54,6 +54,27 @@ svn_error_t *svn_io_check_path (const char *path,
                                 apr_pool_t *pool);
 
 
+/* Like calling svn_io_check_path on PARENT_PATH/NAMES[i] for each of
+ * the NUM_NAMES entries in NAMES, but answered from a single read of
+ * PARENT_PATH's directory entries instead of one stat per name:
+ * KINDS[i] is set to the kind of PARENT_PATH/NAMES[i], or to
+ * svn_node_none if the directory holds no such entry.  A null
+ * NAMES[i] is allowed, and yields svn_node_none.
+ *
+ * The kinds come from the directory entries themselves, as with
+ * svn_io_get_dirents, so symlinks are reported as svn_node_unknown
+ * rather than followed.
+ *
+ * If PARENT_PATH cannot be opened as a directory, an error is
+ * returned and the values in KINDS are undefined.
+ */
+svn_error_t *svn_io_check_paths (enum svn_node_kind *kinds,
+                                 const char *parent_path,
+                                 const char *const *names,
+                                 int num_names,
+                                 apr_pool_t *pool);
+
+
 /* Open a new file (for writing) with a unique name based on PATH, in the
  * same directory as PATH.  The file handle is returned in *F, and the
  * name, which ends with SUFFIX, is returned in *UNIQUE_NAME.  If
@@ -116,6 +137,14 @@ svn_error_t *svn_io_copy_file (const char *src,
                                svn_boolean_t copy_perms,
                                apr_pool_t *pool);
 
+/* Make DST another name for SRC --- a hard link where the platform
+   and filesystem support one, a plain copy (with permissions) where
+   they don't.  Only use this for files that are never modified in
+   place, only replaced by rename. */
+svn_error_t *svn_io_link_or_copy_file (const char *src,
+                                       const char *dst,
+                                       apr_pool_t *pool);
+
 /* Recursively copy directory SRC into DST_PARENT, as a new entry named
    DST_BASENAME.  If DST_BASENAME already exists in DST_PARENT, return
    error. COPY_PERMS will be passed through to svn_io_copy_file when any
@@ -184,6 +213,12 @@ svn_error_t *svn_io_file_affected_time (apr_time_t *apr_time,
                                         apr_pool_t *pool);
 
 
+/* Set *SIZE to the size in bytes of file PATH. */
+svn_error_t *svn_io_file_size (apr_off_t *size,
+                               const char *path,
+                               apr_pool_t *pool);
+
+
 /* Set *DIFFERENT_P to non-zero if FILE1 and FILE2 have different
  * sizes, else set to zero.
  *
@@ -199,6 +234,15 @@ svn_error_t *svn_io_filesizes_different_p (svn_boolean_t *different_p,
                                            apr_pool_t *pool);
 
 
+/* Set *CHECKSUM_P to the hexadecimal MD5 digest of FILE's contents,
+ * allocated in POOL.  Two files whose checksums compare equal can be
+ * assumed to have equal contents.
+ */
+svn_error_t *svn_io_file_checksum (svn_stringbuf_t **checksum_p,
+                                   const char *file,
+                                   apr_pool_t *pool);
+
+
 /* Return a POSIX-like file descriptor from FILE.
 
    We need this because on some platforms, notably Windows, apr_file_t
@@ -284,6 +328,17 @@ svn_stream_t *svn_stream_from_aprfile (apr_file_t *file, apr_pool_t *pool);
 
 svn_stream_t *svn_stream_from_stdio (FILE *fp, apr_pool_t *pool);
 
+/* Return a stream that wraps SOURCE with a read buffer of BUFSIZE
+   bytes, or of SVN_STREAM_CHUNK_SIZE bytes if BUFSIZE is zero.
+   Reads are satisfied from the buffer, which is refilled from SOURCE
+   a whole BUFSIZE at a time, so a run of small reads costs SOURCE
+   only a few large ones; a read of BUFSIZE or more bypasses the
+   buffer once it is drained.  Writes and close pass straight through
+   to SOURCE. */
+svn_stream_t *svn_stream_buffered (svn_stream_t *source,
+                                   apr_size_t bufsize,
+                                   apr_pool_t *pool);
+
 
 /* Functions for operating on generic streams.  */
 
@@ -326,6 +381,27 @@ svn_error_t *svn_io_get_dirents (apr_hash_t **dirents,
                                  apr_pool_t *pool);
 
 
+/* Start CMD with ARGS, using PATH as working directory, and return
+   without waiting for it to finish.  Connect CMD's stdin, stdout, and
+   stderr to INFILE, OUTFILE, and ERRFILE, except where they are null.
+   Set *CMD_PROC to the new process, which the caller may wait for or
+   simply abandon --- pool cleanup will neither kill nor reap it.
+
+   ARGS is a list of (const char *)'s, terminated by NULL.  ARGS[0] is
+   the name of the program, though it need not be the same as CMD.
+
+   INHERIT sets whether the invoked program shall inherit its environment or
+   run "clean". */
+svn_error_t *svn_io_start_cmd (apr_proc_t *cmd_proc,
+                               const char *path,
+                               const char *cmd,
+                               const char *const *args,
+                               svn_boolean_t inherit,
+                               apr_file_t *infile,
+                               apr_file_t *outfile,
+                               apr_file_t *errfile,
+                               apr_pool_t *pool);
+
 /* Invoke CMD with ARGS, using PATH as working directory.
    Connect CMD's stdin, stdout, and stderr to INFILE, OUTFILE, and
    ERRFILE, except where they are null.
@@ -349,6 +425,44 @@ svn_error_t *svn_io_run_cmd (const char *path,
                              apr_file_t *errfile,
                              apr_pool_t *pool);
 
+/* Produce a unified diff of the files FROM and TO, writing it to
+   OUTFILE.  This is the built-in diff engine --- no external program
+   runs --- and it always behaves like "diff -u".
+
+   FROM_LABEL and TO_LABEL, if non-null, replace the file names in the
+   "---" and "+++" header lines.  When the files match, nothing at all
+   is written.  All allocation is from POOL.  */
+svn_error_t *svn_io_diff_files (const char *from,
+                                const char *to,
+                                const char *from_label,
+                                const char *to_label,
+                                apr_file_t *outfile,
+                                apr_pool_t *pool);
+
+/* Merge the changes between OLDER and YOURS into MINE, writing the
+   result to the open file handle MERGED, which is left open.  This is
+   the built-in three-way merge engine --- no external program runs
+   --- and it behaves like "diff3 -A -m".
+
+   Where MINE and YOURS both changed the same region of OLDER, and
+   changed it differently, the merged result carries the full
+   three-part conflict markers, and *CONFLICTED is set to TRUE;
+   otherwise *CONFLICTED is set to FALSE.
+
+   MINE_LABEL, OLDER_LABEL, and YOURS_LABEL decorate the conflict
+   markers; any of them may be NULL, in which case it defaults to
+   ".working", ".old", or ".new" respectively.  All allocation is from
+   POOL.  */
+svn_error_t *svn_io_merge_files (const char *mine,
+                                 const char *older,
+                                 const char *yours,
+                                 const char *mine_label,
+                                 const char *older_label,
+                                 const char *yours_label,
+                                 apr_file_t *merged,
+                                 svn_boolean_t *conflicted,
+                                 apr_pool_t *pool);
+
 /* Invoke SVN_CLIENT_DIFF, with USER_ARGS (which is an array of NUM_USER_ARGS 
    arguments), if they are specified, or "-u" if they are not.  
 
@@ -27,6 +27,7 @@ extern "C" {
 
 #include <apr_pools.h>
 #include <apr_tables.h>
+#include <apr_hash.h>
 #include "svn_string.h"
 #include "svn_error.h"
 
@@ -84,6 +85,56 @@ char *svn_path_join (const char *base,
 char *svn_path_join_many (apr_pool_t *pool, const char *base, ...);
 
 
+/* An interned path, as handed out by a path index (below).
+
+   A given index returns the same entry every time it sees the same
+   path, so two interned paths name the same thing iff they are the
+   same pointer --- no strcmp required.  PARENT is the entry for the
+   path one component up ("" is the top; its PARENT is null), so
+   callers can walk toward the root without chopping strings.
+
+   Treat the fields as read-only; the index maintains them.  */
+typedef struct svn_indexed_path_t
+{
+  const char *path;                    /* the full path, null-terminated */
+  apr_size_t len;                      /* strlen (PATH) */
+  struct svn_indexed_path_t *parent;   /* one component up, or NULL */
+  apr_hash_t *children;                /* private to the index: maps
+                                          component names to child
+                                          entries already joined */
+} svn_indexed_path_t;
+
+
+/* A table of interned paths.  */
+typedef struct svn_path_index_t svn_path_index_t;
+
+
+/* Return a new, empty path index, allocated in POOL.  Every path it
+   ever interns is allocated there too and lives as long as the index,
+   so give a tree walk its own index in a pool of matching lifetime.  */
+svn_path_index_t *svn_path_index_create (apr_pool_t *pool);
+
+
+/* Return the interned entry for PATH in INDEX, interning it (and its
+   ancestors) first if this is a path INDEX hasn't seen.  PATH should
+   be in canonical internal style --- interning two spellings of the
+   same path yields two distinct entries.  */
+svn_indexed_path_t *svn_path_index_get (svn_path_index_t *index,
+                                        const char *path);
+
+
+/* Return the interned entry for BASE joined with COMPONENT, following
+   the same rules as svn_path_join.  BASE must come from INDEX.
+
+   Once a join has been seen, repeating it is a single hash probe on
+   BASE; no path is assembled and nothing is allocated.  This is the
+   point of the index: a tree walk that builds each entry's full path
+   from its parent's stops copying the shared prefixes over and over.  */
+svn_indexed_path_t *svn_path_index_join (svn_path_index_t *index,
+                                         svn_indexed_path_t *base,
+                                         const char *component);
+
+
 /* Get the basename of the specified PATH. The basename is defined as
    the last component of the path (ignoring any trailing slashes). If
    the PATH is root ("/"), then that is returned. Otherwise, the
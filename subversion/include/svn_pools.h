@@ -25,6 +25,9 @@
 #include <apr_errno.h>     /* APR's error system */
 #include <apr_pools.h>
 
+#define APR_WANT_STDIO
+#include <apr_want.h>      /* for FILE */
+
 #include <svn_types.h>
 
 #ifdef __cplusplus
@@ -127,13 +130,49 @@ void svn_pool_clear_debug (apr_pool_t *p,
 #endif /* APR_POOL_DEBUG */
 
 
-/* Destroy a POOL and all of its children. 
+/* Destroy a POOL and all of its children.
+ *
+ * If POOL was created by svn_pool_create() with a parent, its
+ * cleanups are run and its memory released just as a destroy would,
+ * but the empty pool itself may be parked for reuse by a later
+ * svn_pool_create() with the same parent, sparing the allocator the
+ * churn of our create/destroy-happy loops.  Either way, the caller
+ * must not touch POOL afterwards.
+ */
+void svn_pool_destroy (apr_pool_t *p);
+
+
+
+/* POOL USAGE STATISTICS
+ *
+ * When compiled with SVN_POOL_STATS defined, Subversion keeps a small
+ * registry of "tagged" pools.  A pool acquires a name with
+ * svn_pool_tag(); thereafter its size is sampled each time it is
+ * cleared or destroyed, and svn_pool_stats_dump() reports, for every
+ * tag, how many pools ever carried it, how many are still alive, how
+ * often they were cleared, and the largest size seen -- so runaway
+ * memory use in a long-lived process can be traced back to a pool
+ * creation site.
  *
- * This define for svn_pool_destroy exists for symmatry (the
- * not-so-grand reason) and for the existence of a great memory usage
- * debugging hook (the grand reason).
+ * Sampling uses apr_pool_num_bytes(), so SVN_POOL_STATS requires an
+ * APR built with pool debugging (APR_POOL_DEBUG).  Without
+ * SVN_POOL_STATS, the calls below compile away to nothing.
  */
-#define svn_pool_destroy apr_pool_destroy
+
+/* Tag POOL with NAME, registering it for usage statistics.  NAME is
+ * copied.  Subpools of POOL are not themselves tagged, but a recursive
+ * byte count is used when sampling, so a tagged pool's figure covers
+ * its children.  */
+void svn_pool_tag (apr_pool_t *pool, const char *name);
+
+/* Write a report on all tagged pools to FILE.  Live pools are sampled
+ * one more time before reporting.  */
+void svn_pool_stats_dump (FILE *file);
+
+#ifndef SVN_POOL_STATS
+#define svn_pool_tag(pool, name)
+#define svn_pool_stats_dump(file)
+#endif /* SVN_POOL_STATS */
 
 
 #ifdef __cplusplus
@@ -24,6 +24,7 @@
 
 #include <apr_pools.h>
 #include <apr_tables.h>
+#include <apr_time.h>
 
 #include "svn_error.h"
 #include "svn_delta.h"
@@ -71,10 +72,38 @@ typedef svn_error_t *(*svn_ra_set_wc_prop_func_t) (void *baton,
                                                    apr_pool_t *pool);
 
 /* A function type for retrieving the youngest revision from a repos.   */
-typedef svn_error_t *(*svn_ra_get_latest_revnum_func_t) 
+typedef svn_error_t *(*svn_ra_get_latest_revnum_func_t)
        (void *session_baton,
         svn_revnum_t *latest_revnum);
 
+/* Wire-level transfer statistics for an RA session.
+
+   An RA layer that talks over a network accumulates these counters
+   over the lifetime of a session; a layer with no wire (ra_local)
+   reports all zeroes.  Callers wanting per-operation figures should
+   snapshot before the operation and subtract afterwards.  */
+typedef struct svn_ra_stats_t
+{
+  /* Number of requests issued over the wire.  */
+  apr_off_t requests;
+
+  /* Bytes written to the wire: request headers, plus request bodies
+     where the layer knows their size up front.  */
+  apr_off_t bytes_sent;
+
+  /* Bytes of response body read off the wire.  When the server
+     compresses response bodies, this counts the compressed size,
+     since that is what actually crossed the network.  */
+  apr_off_t bytes_received;
+
+  /* Total wall-clock time spent between dispatching a request and
+     finishing with its response.  This includes server think time as
+     well as transfer time; comparing it against overall elapsed time
+     shows how network-bound an operation was.  */
+  apr_time_t network_time;
+
+} svn_ra_stats_t;
+
 /*----------------------------------------------------------------------*/
 
 /* The update Reporter */
@@ -224,6 +253,28 @@ typedef struct svn_ra_callbacks_t
 } svn_ra_callbacks_t;
 
 
+/* The callback invoked by an RA layer's get_files() once per
+   requested file, in the order the paths were requested.
+
+   PATH is the path as it was requested, and FETCHED_REV the revision
+   the contents come from (SVN_INVALID_REVNUM if the layer is serving
+   an un-pinned `head').  PROPS carries the file's properties, built
+   the same way get_file() builds them, or NULL if the caller didn't
+   ask for properties.
+
+   The receiver sets *CONTENTS to a writable stream; the RA layer
+   writes the file's full text into it --- completely, before the
+   receiver is invoked for the next file --- but does not close it.
+   Set *CONTENTS to NULL to skip this file's text.
+
+   POOL is cleared between invocations; copy anything worth keeping. */
+typedef svn_error_t *(*svn_ra_file_receiver_t) (void *baton,
+                                                const char *path,
+                                                svn_revnum_t fetched_rev,
+                                                apr_hash_t *props,
+                                                svn_stream_t **contents,
+                                                apr_pool_t *pool);
+
 
 /*----------------------------------------------------------------------*/
 
@@ -339,6 +390,26 @@ typedef struct svn_ra_plugin_t
                             svn_revnum_t *fetched_rev,
                             apr_hash_t **props);
 
+  /* Fetch the contents of many files in one call.  PATHS is an array
+     of (const char *) paths, each interpreted relative to the url in
+     SESSION_BATON, and each fetched at REVISION (SVN_INVALID_REVNUM
+     meaning `head').  For each path, in order, RECEIVER is invoked
+     with RECEIVER_BATON; see svn_ra_file_receiver_t above.  If
+     WANT_PROPS is set, the receiver also gets each file's properties,
+     built the same way get_file() builds them.
+
+     This exists so that tools which want many file texts --- and
+     nothing else --- need not drive a checkout editor; a
+     network-based RA layer can also resolve REVISION once for the
+     whole batch and keep its connection busy back-to-back, which
+     beats looping over get_file(). */
+  svn_error_t *(*get_files) (void *session_baton,
+                             const apr_array_header_t *paths,
+                             svn_revnum_t revision,
+                             svn_boolean_t want_props,
+                             svn_ra_file_receiver_t receiver,
+                             void *receiver_baton);
+
 
   /* Check out revision REVISION of the url specified in
      SESSION_BATON, using EDITOR and EDIT_BATON to create the working
@@ -489,15 +560,20 @@ typedef struct svn_ra_plugin_t
      the hash's keys are all the paths committed in that revision.
      Otherwise, each call to receiver passes null for CHANGED_PATHS.
     
+     If LIMIT is greater than zero, invoke RECEIVER on at most LIMIT
+     messages; the server stops walking revisions once satisfied.
+     Pass zero for no limit.
+
      If any invocation of RECEIVER returns error, return that error
      immediately and without wrapping it.
-    
+
      See also the documentation for `svn_log_message_receiver_t'.  */
   svn_error_t *(*get_log) (void *session_baton,
                            const apr_array_header_t *paths,
                            svn_revnum_t start,
                            svn_revnum_t end,
                            svn_boolean_t discover_changed_paths,
+                           int limit,
                            svn_log_message_receiver_t receiver,
                            void *receiver_baton);
 
@@ -530,6 +606,13 @@ typedef struct svn_ra_plugin_t
                               svn_revnum_t revision);
 
 
+  /* Fill in *STATS with the transfer statistics accumulated so far on
+     this session.  Layers that do not talk over a network fill in
+     zeroes.  */
+  svn_error_t *(*get_stats) (void *session_baton,
+                             svn_ra_stats_t *stats);
+
+
 } svn_ra_plugin_t;
 
 
@@ -584,13 +667,27 @@ svn_error_t * svn_ra_local_init (int abi_version,
                                  apr_hash_t *hash);
 
 
+/* Tell the ra_dav commit editor to upload file bodies over
+   NUM_WORKERS extra connections running alongside the main one,
+   instead of one blocking PUT per round trip.  Ordering is preserved
+   where DAV demands it: the MERGE creating the new revision waits
+   for every upload, and a PROPPATCH never races the PUT on the same
+   resource.
+
+   Off by default; ignored when apr was built without thread support.
+   A process-wide knob, like svn_wc_set_install_pipeline. */
+void svn_ra_dav_set_put_workers (int num_workers);
+
+
 /*----------------------------------------------------------------------*/
 
 /*** Public Interfaces ***/
 
 /* Every user of the RA layer *must* call this routine and hold on to
    the RA_BATON returned.  This baton contains all known methods of
-   accessing a repository, for use within most svn_client_* routines. */
+   accessing a repository, for use within most svn_client_* routines.
+   (The RA libraries themselves are loaded lazily, when a URL in
+   their scheme first comes up, so this call is cheap.) */
 svn_error_t * svn_ra_init_ra_libs (void **ra_baton, apr_pool_t *pool);
 
 
@@ -53,6 +53,35 @@ svn_error_t *svn_repos_open (svn_repos_t **repos_p,
                              const char *path,
                              apr_pool_t *pool);
 
+/* Like svn_repos_open, but consult a process-wide cache of open
+   repositories first, so that the (expensive) Berkeley DB environment
+   open for PATH happens at most once per process, no matter how many
+   times the repository is opened.  This is meant for servers that
+   open the same repository over and over --- one HTTP request at a
+   time, in mod_dav_svn's case.
+
+   The handle returned may be shared with other callers, and lives in
+   the cache's own pool; POOL merely bounds this caller's reference to
+   it.  Calling svn_repos_close on a cached handle is a no-op.
+
+   Note that the cache itself is not protected by any mutex, so in a
+   multithreaded program, callers must serialize access to this
+   function themselves.  */
+svn_error_t *svn_repos_open_cached (svn_repos_t **repos_p,
+                                    const char *path,
+                                    apr_pool_t *pool);
+
+/* Limit the number of handles svn_repos_open_cached keeps open at
+   once to MAX_HANDLES.  When opening a new repository would exceed
+   the limit, the least recently used handle that no caller currently
+   holds is closed to make room; handles still in use are never
+   closed, even if that means briefly exceeding the limit.
+
+   A MAX_HANDLES of zero disables the cache altogether, making
+   svn_repos_open_cached equivalent to svn_repos_open.  A negative
+   value (the default) means no limit.  A process-wide knob. */
+void svn_repos_set_cache_size (int max_handles);
+
 /* Create a new Subversion repository at PATH, building the necessary
    directory structure, creating the Berkeley DB filesystem
    environment, and so on.  Return the repository object in *REPOS_P,
@@ -71,6 +100,30 @@ svn_error_t *svn_repos_delete (const char *path, apr_pool_t *pool);
 /* Return the filesystem associated with repository object REPOS. */
 svn_fs_t *svn_repos_fs (svn_repos_t *repos);
 
+
+/* Queued deltification.
+
+   Deltifying a big commit inside the committer's call path (from a
+   post-commit hook, say) adds its whole cost to the commit latency.
+   Instead, the hook can queue the work and let another process ---
+   `svnadmin rundeltify', typically from cron --- do it later.  */
+
+/* Add PATH in REVISION to REPOS's deltification queue, to be
+   deltified by a later call to svn_repos_deltify_drain.  Use POOL
+   for any temporary allocation.  This only appends a line to a file,
+   so it is cheap enough to call once per commit.  */
+svn_error_t *svn_repos_deltify_enqueue (svn_repos_t *repos,
+                                        svn_revnum_t revision,
+                                        const char *path,
+                                        apr_pool_t *pool);
+
+/* Deltify everything queued in REPOS by svn_repos_deltify_enqueue,
+   and empty the queue.  If an earlier drain was interrupted, its
+   remaining work is finished first.  Use POOL for any temporary
+   allocation.  */
+svn_error_t *svn_repos_deltify_drain (svn_repos_t *repos,
+                                      apr_pool_t *pool);
+
 
 /* Repository Paths */
 
@@ -106,24 +159,74 @@ const char *svn_repos_write_sentinel_hook (svn_repos_t *repos, apr_pool_t *pool)
 
 /* ---------------------------------------------------------------*/
 
+/*** Path filters: pruning a delta walk to chosen subtrees. */
+
+/* A set of include/exclude path prefixes that svn_repos_dir_delta
+   consults before visiting each entry.  A sparse consumer --- one
+   that wants three of two hundred top-level directories, say ---
+   builds a filter naming the subtrees it cares about, and the walk
+   prunes everything else before any node access, so the server cost
+   tracks the requested subset rather than the whole tree.
+
+   Prefixes are filesystem paths, matched against the full paths the
+   delta walk constructs; a prefix matches itself and everything
+   below it.  A path is visited iff it is not under any exclude
+   prefix, and either no include prefixes were given, or it is under
+   one, or it is an ancestor of one (ancestors must be opened for the
+   walk to reach the included subtrees, but their other children are
+   still pruned).
+
+   The explicitly requested delta target itself is always sent; the
+   filter governs the entries encountered while walking below it.  */
+typedef struct svn_repos_path_filter_t svn_repos_path_filter_t;
+
+/* Return a new filter with no prefixes, allocated in POOL.  Until an
+   include or exclude prefix is added, it passes every path. */
+svn_repos_path_filter_t *svn_repos_path_filter_create (apr_pool_t *pool);
+
+/* Add PREFIX to FILTER's include (respectively, exclude) list.
+   PREFIX is copied into the filter's pool. */
+void svn_repos_path_filter_include (svn_repos_path_filter_t *filter,
+                                    const char *prefix);
+void svn_repos_path_filter_exclude (svn_repos_path_filter_t *filter,
+                                    const char *prefix);
+
+
+/* ---------------------------------------------------------------*/
+
 /*** Reporting the state of a working copy, for updates. */
 
 
+/* An opaque collection of reporter state --- chiefly open revision
+   roots --- that successive report drives on the same repository can
+   share.  An RA session that drives many reports should create one
+   cache, in a pool that lives as long as the session, and hand it to
+   every svn_repos_begin_report call it makes; the revision roots the
+   drives have in common are then opened once per session instead of
+   once per drive (or, for roots opened path by path, once per
+   reported path). */
+typedef struct svn_repos_report_cache_t svn_repos_report_cache_t;
+
+/* Return a new, empty report cache allocated in POOL. */
+svn_repos_report_cache_t *svn_repos_report_cache_create (apr_pool_t *pool);
+
+
 /* Construct and return a REPORT_BATON that will be paired with some
-   svn_ra_reporter_t table.  The table and baton are used to build a
-   transaction in the system;  when the report is finished,
-   svn_repos_dir_delta is called on the transaction, driving
-   EDITOR/EDIT_BATON. 
+   svn_ra_reporter_t table.  The table and baton are used to record an
+   in-memory description of the client's base state;  when the report
+   is finished, svn_repos_dir_delta is run over that description,
+   driving EDITOR/EDIT_BATON.  Nothing is ever written to the
+   filesystem --- the whole update path is read-only.
 
-   Specifically, the report will create a transaction made by
-   USERNAME, relative to FS_BASE in the filesystem.  TARGET is a
-   single path component, used to limit the scope of the report to a
-   single entry of FS_BASE, or NULL if all of FS_BASE itself is the
-   main subject of the report.
+   Specifically, the report is made by USERNAME, relative to FS_BASE
+   in the filesystem.  TARGET is a single path component, used to
+   limit the scope of the report to a single entry of FS_BASE, or
+   NULL if all of FS_BASE itself is the main subject of the report.
 
    TGT_PATH and REVNUM is the fs path/revision pair that is the
    "target" of dir_delta.  In other words, a tree delta will be
-   returned that transforms the transaction into TGT_PATH/REVNUM.
+   returned that transforms the reported base state into
+   TGT_PATH/REVNUM.
  
    TEXT_DELTAS instructs the driver of the EDITOR to enable to disable
    the generation of text deltas.
@@ -131,6 +234,13 @@ const char *svn_repos_write_sentinel_hook (svn_repos_t *repos, apr_pool_t *pool)
    RECURSE instructs the driver of the EDITOR to send a recursive
    delta (or not.)
 
+   CACHE, if non-null, holds reporter state shared with this session's
+   other report drives (see svn_repos_report_cache_create above).
+
+   FILTER, if non-null, prunes the dir_delta walk the finished report
+   drives to the subtrees the filter names (see
+   svn_repos_path_filter_create above).
+
    All allocation for the context and collected state will occur in
    POOL. */
 svn_error_t *
@@ -145,17 +255,19 @@ svn_repos_begin_report (void **report_baton,
                         svn_boolean_t recurse,
                         const svn_delta_edit_fns_t *editor,
                         void *edit_baton,
+                        svn_repos_report_cache_t *cache,
+                        svn_repos_path_filter_t *filter,
                         apr_pool_t *pool);
 
 
 /* Given a REPORT_BATON constructed by svn_repos_begin_report(), this
-   routine will build REVISION:PATH into the current transaction.
-   This routine is called multiple times to create a transaction that
-   is a "mirror" of a working copy.
+   routine will record that the working copy has REVISION:PATH.  This
+   routine is called multiple times to build up a "mirror" of the
+   working copy's mixed revisions.
 
-   The first call of this in a given report usually passes an empty
-   PATH; that allows the reporter to set up the correct root revision
-   (useful when creating a txn, for example).  */
+   The first call of this in a given report must pass an empty PATH;
+   it establishes the base revision everything unreported is presumed
+   to be at.  */
 svn_error_t *
 svn_repos_set_path (void *report_baton,
                     const char *path,
@@ -163,23 +275,24 @@ svn_repos_set_path (void *report_baton,
 
 
 /* Given a REPORT_BATON constructed by svn_repos_begin_report(), this
-   routine will remove PATH from the current fs transaction. 
+   routine will record that the working copy does not have PATH.
 
    (This allows the reporter's driver to describe missing pieces of a
-   working copy, so that 'svn up' can recreate them.) */   
+   working copy, so that 'svn up' can recreate them.) */
 svn_error_t *svn_repos_delete_path (void *report_baton,
                                     const char *path);
 
-/* Make the filesystem compare the transaction to a revision and have
-   it drive an update editor (using svn_repos_delta_dirs()).  Then
-   abort the transaction. */
+/* Compare the reported base state to the target revision and drive
+   an update editor (using svn_repos_dir_delta()). */
 svn_error_t *svn_repos_finish_report (void *report_baton);
 
 
-/* The report-driver is bailing, so abort the fs transaction. */
+/* The report-driver is bailing; discard the collected report. */
 svn_error_t *svn_repos_abort_report (void *report_baton);
 
 
+/* ---------------------------------------------------------------*/
+
 /* ---------------------------------------------------------------*/
 
 /*** The magical dir_delta update routines. */
@@ -217,6 +330,10 @@ svn_error_t *svn_repos_abort_report (void *report_baton);
    source tree, svn_repos_dir_delta might ask that such a copy take
    place.
 
+   FILTER, if non-null, prunes the walk to the subtrees it names (see
+   svn_repos_path_filter_create above); entries it rules out generate
+   no editor calls and cost no node access.
+
    Before completing successfully, this function calls EDITOR's
    close_edit(), so the caller should expect its EDIT_BATON to be
    invalid after its use with this function.
@@ -238,9 +355,49 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
                      svn_boolean_t text_deltas,
                      svn_boolean_t recurse,
                      svn_boolean_t use_copyfrom_args,
+                     svn_repos_path_filter_t *filter,
                      apr_pool_t *pool);
 
 
+/* ---------------------------------------------------------------*/
+
+/*** Replaying ranges of revisions. */
+
+/* Callback used by svn_repos_replay_range.  Set *EDITOR and
+   *EDIT_BATON to the editor that should receive REVISION's changes,
+   allocated in POOL.  BATON is the CB_BATON given to
+   svn_repos_replay_range.  */
+typedef svn_error_t *(*svn_repos_replay_editor_cb_t)
+       (const svn_delta_edit_fns_t **editor,
+        void **edit_baton,
+        svn_revnum_t revision,
+        void *baton,
+        apr_pool_t *pool);
+
+
+/* Drive an editor once for each revision from START_REV through
+   END_REV in REPOS, describing the changes each revision made
+   relative to its predecessor.  Before each revision, call EDITOR_CB
+   with CB_BATON to obtain the editor to drive; as with
+   svn_repos_dir_delta, each editor's close_edit is called when its
+   revision is complete.  TEXT_DELTAS is passed through to
+   svn_repos_dir_delta.
+
+   This is equivalent to calling svn_repos_dir_delta once per
+   revision, except that the revision roots are shared between
+   consecutive drives, so a long range (mirroring a repository, for
+   instance) doesn't reopen every root and rebuild its node cache
+   from scratch.  Memory use is bounded regardless of the length of
+   the range.  */
+svn_error_t *svn_repos_replay_range (svn_repos_t *repos,
+                                     svn_revnum_t start_rev,
+                                     svn_revnum_t end_rev,
+                                     svn_boolean_t text_deltas,
+                                     svn_repos_replay_editor_cb_t editor_cb,
+                                     void *cb_baton,
+                                     apr_pool_t *pool);
+
+
 /* ---------------------------------------------------------------*/
 
 /*** Finding particular revisions. */
@@ -319,6 +476,9 @@ svn_repos_get_committed_info (svn_revnum_t *committed_rev,
  * see http://subversion.tigris.org/issues/show_bug.cgi?id=562 for
  * more information.
  *
+ * If LIMIT is greater than zero, invoke RECEIVER on at most LIMIT
+ * messages, then stop walking revisions.  Pass zero for no limit.
+ *
  * If any invocation of RECEIVER returns error, return that error
  * immediately and without wrapping it.
  *
@@ -331,11 +491,61 @@ svn_repos_get_logs (svn_repos_t *repos,
                     svn_revnum_t start,
                     svn_revnum_t end,
                     svn_boolean_t discover_changed_paths,
+                    int limit,
                     svn_log_message_receiver_t receiver,
                     void *receiver_baton,
                     apr_pool_t *pool);
 
 
+/* Build the changed-paths index entries for every revision of REPOS's
+ * filesystem that doesn't have one yet, by comparing each such
+ * revision with its predecessor.  Commits maintain the index
+ * automatically; this exists to cover revisions committed before the
+ * index was kept (see svn_fs_paths_changed).  Already indexed
+ * revisions are left alone, so re-running this is cheap and harmless.
+ *
+ * Use POOL for temporary allocations.  */
+svn_error_t *
+svn_repos_build_changes (svn_repos_t *repos,
+                         apr_pool_t *pool);
+
+
+/* ---------------------------------------------------------------*/
+
+/*** Dumping and loading filesystem data ***/
+
+/* Write a portable description of the revisions START_REV through
+ * END_REV of REPOS's filesystem to STREAM: for each revision, its
+ * property list and one record per changed path, with file contents
+ * carried as svndiff-format deltas against their previous text.  The
+ * stream can be loaded by svn_repos_load_fs.
+ *
+ * If START_REV is SVN_INVALID_REVNUM, dump from revision zero; if
+ * END_REV is SVN_INVALID_REVNUM, dump through the youngest revision.
+ * Dumping from the last revision a backup repository holds gives an
+ * incremental backup at delta cost.
+ *
+ * Use POOL for temporary allocations.  */
+svn_error_t *svn_repos_dump_fs (svn_repos_t *repos,
+                                svn_stream_t *stream,
+                                svn_revnum_t start_rev,
+                                svn_revnum_t end_rev,
+                                apr_pool_t *pool);
+
+
+/* Read a dump stream, as produced by svn_repos_dump_fs, from STREAM,
+ * and commit its revisions to REPOS's filesystem.  Records for
+ * revisions the filesystem already has are skipped, so a stream may
+ * safely overlap what's already loaded (this is what makes loading
+ * resumable); but the first new revision in the stream must be the
+ * successor of the filesystem's youngest revision.
+ *
+ * Use POOL for temporary allocations.  */
+svn_error_t *svn_repos_load_fs (svn_repos_t *repos,
+                                svn_stream_t *stream,
+                                apr_pool_t *pool);
+
+
 /* ---------------------------------------------------------------*/
 
 /*** Hook-sensitive wrappers for libsvn_fs routines. ***/
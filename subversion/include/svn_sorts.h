@@ -82,6 +82,21 @@ int svn_sort_compare_items_as_paths (const svn_item_t *a, const svn_item_t *b);
 int svn_sort_compare_revisions (const void *a, const void *b);
 
 
+/* Fill ARY, an array of svn_item_t structures, with HT's keys and
+   values, sorted by COMPARISON_FUNC (see apr_hash_sorted_keys).
+   Whatever ARY held before is discarded, but its element storage is
+   reused, so a caller sorting many hashes in a row can make one
+   scratch array and pay for its growth only once.
+
+   The items only point into HT; no key or value bytes are copied.  */
+void
+svn_sort_hash_keys (apr_array_header_t *ary,
+                    apr_hash_t *ht,
+                    int (*comparison_func) (const svn_item_t *,
+                                            const svn_item_t *),
+                    apr_pool_t *pool);
+
+
 #ifndef apr_hash_sorted_keys
 /* Sort HT according to its keys, return an apr_array_header_t
    containing svn_item_t structures holding those keys and values
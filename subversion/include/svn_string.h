@@ -234,6 +234,24 @@ svn_boolean_t svn_string_compare_stringbuf (const svn_string_t *str1,
 
 /*** C strings. ***/
 
+/* Set *TOKEN to the next SEP_CHAR-bounded substring of *INPUT, and
+ * advance *INPUT past it, ready for the next call.  TOKEN points into
+ * the original buffer; nothing is copied or allocated.  Callers that
+ * need a token to outlive the buffer must duplicate it themselves.
+ *
+ * To start iterating, point *INPUT at the string; after the last
+ * token *INPUT is set to NULL, and subsequent calls return FALSE
+ * without touching TOKEN.  Tokens may be empty; N occurrences of
+ * SEP_CHAR yield N+1 of them.
+ *
+ * If CHOP_WHITESPACE is true, leading and trailing whitespace is
+ * excluded from each token.
+ */
+svn_boolean_t svn_cstring_next_token (svn_string_t *token,
+                                      const char **input,
+                                      char sep_char,
+                                      svn_boolean_t chop_whitespace);
+
 /* Divide INPUT into substrings along SEP_CHAR boundaries, return an
  * array of copies of the substrings, all allocated in POOL.
  *
@@ -32,11 +32,22 @@ extern "C" {
 #include "svn_error.h"
 
 
+/* The number of bytes, including the terminating null, that
+   svn_time_to_nts_buf() writes into its buffer. */
+#define SVN_TIME_NTS_BUFSIZE 28
+
 /* Convert WHEN to a const char * representation allocated in POOL.
    Use svn_time_from_nts() for the reverse conversion. */
 const char *svn_time_to_nts (apr_time_t when, apr_pool_t *pool);
 
-/* Convert TIMESTR to an apr_time_t. */
+/* Like svn_time_to_nts(), but write the representation into BUF
+   without allocating anything.  BUF must have room for at least
+   SVN_TIME_NTS_BUFSIZE bytes. */
+void svn_time_to_nts_buf (char *buf, apr_time_t when);
+
+/* Convert TIMESTR to an apr_time_t.  TIMESTR is normally something
+   svn_time_to_nts() produced, but timestamps in the format written
+   before this release are still recognized. */
 apr_time_t svn_time_from_nts (const char *timestr);
 
 /* Needed by getdate.y parser */
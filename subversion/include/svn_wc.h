@@ -177,6 +177,14 @@ typedef struct svn_wc_entry_t
   apr_time_t text_time;          /* last up-to-date time for text contents */
   apr_time_t prop_time;          /* last up-to-date time for properties */
 
+  /* Size of the working file when TEXT_TIME was recorded (0 means no
+     information available).  Checked alongside the timestamp, so an
+     edit within the timestamp's granularity still gets noticed. */
+  apr_off_t text_size;
+
+  /* Checksum (null means no information available) */
+  svn_stringbuf_t *checksum;     /* hex MD5 of the text-base file */
+
   /* "Entry props" */
   svn_revnum_t cmt_rev;          /* last revision this was changed */
   apr_time_t cmt_date;           /* last date this was changed */
@@ -217,6 +225,18 @@ svn_error_t *svn_wc_entries_read (apr_hash_t **entries,
                                   apr_pool_t *pool);
 
 
+/* As svn_wc_entries_read, but additionally return SORTED_ENTRIES, an
+   array of (svn_wc_entry_t *) in entry name order.  The array shares
+   its entry structures with the hash, and the sort order is computed
+   once per parse, so callers that walk a directory in name order ---
+   or several such callers over the same directories --- get it for
+   the cost of the hash alone. */
+svn_error_t *svn_wc_entries_read_sorted (apr_hash_t **entries,
+                                         apr_array_header_t **sorted_entries,
+                                         svn_stringbuf_t *path,
+                                         apr_pool_t *pool);
+
+
 /* Return a duplicate of ENTRY, allocated in POOL.  No part of the new
    entry will be shared with ENTRY. */
 svn_wc_entry_t *svn_wc_entry_dup (svn_wc_entry_t *entry, apr_pool_t *pool);
@@ -379,6 +399,14 @@ svn_error_t *svn_wc_statuses (apr_hash_t *statushash,
                               apr_pool_t *pool);
 
 
+/* Tell svn_wc_statuses to crawl with NUM_THREADS worker threads when
+   descending.  The default (and any NUM_THREADS < 2) means the usual
+   serial recursion; the setting is ignored entirely when apr was
+   built without thread support.  This is a process-wide knob, not
+   something to fiddle mid-crawl. */
+void svn_wc_set_status_threads (int num_threads);
+
+
 /* Set  *EDITOR and *EDIT_BATON to an editor that tweaks or adds
    svn_wc_status_t structures to STATUSHASH to reflect repository
    modifications that would be received on update, and that sets
@@ -400,6 +428,29 @@ svn_error_t *svn_wc_get_status_editor (const svn_delta_editor_t **editor,
                                        apr_pool_t *pool);
 
 
+/* Do the work of svn_wc_statuses and svn_wc_crawl_revisions in a
+   single pass over the working copy under PATH: fill STATUSHASH with
+   local-mod status structures while describing the tree's mixed
+   revisions to REPORTER/REPORT_BATON, then call
+   REPORTER->finish_report.  Each directory's entries are read once
+   and serve both jobs, so `status -u' costs one working copy crawl,
+   not two.
+
+   DESCEND, GET_ALL and STRICT mean what they mean to
+   svn_wc_statuses, and DESCEND doubles as svn_wc_crawl_revisions'
+   RECURSE flag.  Unlike an update crawl, missing files are never
+   restored, and nothing is notified; status is a read-only
+   operation.  */
+svn_error_t *svn_wc_crawl_statuses (apr_hash_t *statushash,
+                                    svn_stringbuf_t *path,
+                                    const svn_ra_reporter_t *reporter,
+                                    void *report_baton,
+                                    svn_boolean_t descend,
+                                    svn_boolean_t get_all,
+                                    svn_boolean_t strict,
+                                    apr_pool_t *pool);
+
+
 
 /* Where you see an argument like
  * 
@@ -749,6 +800,16 @@ svn_error_t *svn_wc_get_switch_editor (svn_stringbuf_t *anchor,
    upon successful completion.  If there is no new text, then caller
    must set NEW_TEXT_PATH to NULL.
 
+   As a special case, NEW_TEXT_PATH may be the path of FILE_PATH's own
+   text-base.  This asserts that the new text is already installed
+   there, *and* that a verbatim copy of it is already sitting at
+   FILE_PATH itself --- the situation the update editor's checkout
+   fast path creates by streaming delta output straight to its final
+   destinations.  No staging or text-base shuffling happens then, and
+   if the file's properties call for no eol or keyword translation,
+   the working file stands as written.  Only use this for a fresh
+   file, where no local modifications are possible.
+
    The caller also provides the new properties for the file in the
    PROPS array; if there are no new props, then caller must pass NULL
    instead.  This argument is an array of svn_prop_t structures, and
@@ -782,6 +843,15 @@ svn_error_t *svn_wc_install_file (const char *file_path,
                                   apr_pool_t *pool);
 
 
+/* Tell the update editor whether to pipeline file installation: when
+   enabled, a worker thread runs svn_wc_install_file while the edit
+   drive goes on receiving the next file, so checkout and update
+   overlap network and disk instead of alternating between them.
+   Off by default; ignored when apr was built without thread support.
+   A process-wide knob, like svn_wc_set_status_threads. */
+void svn_wc_set_install_pipeline (svn_boolean_t enabled);
+
+
 
 /* A word about the implementation of working copy property storage:
  *
@@ -1017,6 +1087,28 @@ svn_error_t *
 svn_wc_cleanup (svn_stringbuf_t *path, apr_pool_t *pool);
 
 
+/* Tell svn_wc_cleanup to replay leftover logs with NUM_THREADS worker
+   threads; directories whose recovery is independent then proceed in
+   parallel, though a directory's log still runs only after the logs
+   of its descendants.  The default (and any NUM_THREADS < 2) means
+   serial replay; the setting is ignored entirely when apr was built
+   without thread support.  A process-wide knob, like
+   svn_wc_set_status_threads. */
+void svn_wc_set_cleanup_threads (int num_threads);
+
+
+/* Recurse from PATH, making recorded timestamps trustworthy again.
+   For each file whose working text turns out to be unmodified even
+   though its timestamp no longer matches the recorded one --- as
+   happens when a whole working copy is restored from a backup ---
+   record the working file's current timestamp, so that later
+   modification checks can answer from the timestamp alone.  Entries
+   that do not yet carry a checksum of their text-base get one
+   recorded along the way.  Perform necessary allocations in POOL. */
+svn_error_t *
+svn_wc_stabilize (svn_stringbuf_t *path, apr_pool_t *pool);
+
+
 /* Revert changes to PATH (perhaps in a RECURSIVE fashion).  Perform
    necessary allocations in POOL.
 
@@ -1196,6 +1288,25 @@ svn_error_t *svn_wc_locked (svn_boolean_t *locked,
                             svn_stringbuf_t *path,
                             apr_pool_t *pool);
 
+/* Lock the tree rooted at PATH in one pass: PATH itself and every
+   versioned directory below it, passing WAIT_FOR to each acquisition.
+   If any directory cannot be locked, release whatever was taken and
+   return the error.
+
+   Locks are reentrant within a process, so code that runs under a
+   tree lock may keep taking and releasing its usual per-directory
+   locks; those become cheap bookkeeping instead of filesystem
+   operations.  Release the tree with svn_wc_unlock_tree. */
+svn_error_t *svn_wc_lock_tree (svn_stringbuf_t *path,
+                               int wait_for,
+                               apr_pool_t *pool);
+
+/* Release the tree lock on PATH taken by svn_wc_lock_tree.
+   Directories that were added, or that left revision control, while
+   the lock was held are quietly skipped. */
+svn_error_t *svn_wc_unlock_tree (svn_stringbuf_t *path,
+                                 apr_pool_t *pool);
+
 
 
 /*** Text/Prop Deltas Using an Editor ***/
@@ -49,6 +49,12 @@ enum svn_xml_open_tag_style {
  * suitable for output as character data or as an attribute value.
  * If *OUTSTR is NULL, store a new stringbuf, else append to the
  * existing stringbuf there.
+ *
+ * When *OUTSTR is NULL and STRING contains nothing that needs
+ * escaping --- the common case for paths --- *OUTSTR may be set to
+ * STRING itself rather than to a copy, so callers that intend to
+ * modify *OUTSTR afterwards should pass an empty stringbuf instead
+ * of NULL.
  */
 void svn_xml_escape_stringbuf (svn_stringbuf_t **outstr,
                                const svn_stringbuf_t *string,
@@ -142,6 +148,22 @@ svn_error_t *svn_xml_parse (svn_xml_parser_t *parser,
                             svn_boolean_t is_final);
 
 
+/* Return a buffer of LEN bytes inside SVN_PARSER for the caller to
+   read xml data directly into, so that a later call to
+   svn_xml_parse_buffer() can parse it without copying.  Returns NULL
+   if expat cannot allocate the buffer. */
+char *svn_xml_get_parse_buffer (svn_xml_parser_t *svn_parser,
+                                apr_size_t len);
+
+
+/* Parse LEN bytes previously read into the buffer obtained from
+   svn_xml_get_parse_buffer().  Error behavior is exactly that of
+   svn_xml_parse(). */
+svn_error_t *svn_xml_parse_buffer (svn_xml_parser_t *svn_parser,
+                                   apr_size_t len,
+                                   svn_boolean_t is_final);
+
+
 
 /* The way to officially bail out of xml parsing:
    Store ERROR in SVN_PARSER and set all expat callbacks to NULL. */
@@ -122,8 +122,6 @@ svn_client_checkout (const svn_delta_editor_t *before_editor,
                                  recurse,
                                  wrapped_old_editor,
                                  wrapped_old_edit_baton);
-      /* Sleep for one second to ensure timestamp integrity. */
-      apr_sleep (APR_USEC_PER_SEC * 1);
       
       if (err)
         return err;
@@ -156,9 +154,6 @@ svn_client_checkout (const svn_delta_editor_t *before_editor,
                                       revnum,
                                       pool);
 
-      /* Sleep for one second to ensure timestamp integrity. */
-      apr_sleep (APR_USEC_PER_SEC * 1);
-      
       if (err)
         return err;
 
@@ -204,6 +204,10 @@ svn_client__update_internal (const svn_delta_editor_t *before_editor,
  * RA_LIB/RA_SESSION define the additional ra session for requesting file
  * contents.
  *
+ * PREFETCH_SESSION, if non-null, is yet another ra session, owned by
+ * a thread the editor starts to fetch base texts ahead of their
+ * deltas.  Pass null to fetch each text synchronously on RA_SESSION.
+ *
  * REVISION is the start revision in the comparison.
  *
  * EDITOR/EDIT_BATON return the newly created editor and baton/
@@ -214,12 +218,21 @@ svn_client__get_diff_editor (svn_stringbuf_t *target,
                              void *diff_cmd_baton,
                              svn_boolean_t recurse,
                              svn_ra_plugin_t *ra_lib,
-                             void *ra_session, 
+                             void *ra_session,
+                             void *prefetch_session,
                              svn_revnum_t revision,
                              const svn_delta_editor_t **editor,
                              void **edit_baton,
                              apr_pool_t *pool);
 
+/* Return whether base-text prefetching has been enabled (via
+ * svn_client_set_diff_prefetch) and this process has thread support.
+ * Callers use this to decide whether to open a PREFETCH_SESSION for
+ * svn_client__get_diff_editor.
+ */
+svn_boolean_t
+svn_client__diff_prefetch_enabled (void);
+
 
 /* ---------------------------------------------------------------- */
 
@@ -279,6 +292,12 @@ svn_client__get_diff_editor (svn_stringbuf_t *target,
 #define SVN_CLIENT__SINGLE_REPOS_NAME "svn:single-repos"
 
 
+/* The queue through which a pipelined commit's harvest hands
+   candidates to a concurrently running editor drive.  Opaque outside
+   commit_util.c. */
+typedef struct svn_client__commit_pipeline svn_client__commit_pipeline_t;
+
+
 /* Recursively crawl a set of working copy paths (PARENT_DIR + each
    item in the TARGETS array) looking for commit candidates, locking
    working copy directories as the crawl progresses.  For each
@@ -307,12 +326,18 @@ svn_client__get_diff_editor (svn_stringbuf_t *target,
    crawl_local_mods, crawl_dir, and report_single_entry.  
 
    ### needed: a committables generator to replace
-   svn_wc_crawl_as_copy and crawl_as_copy.  */
+   svn_wc_crawl_as_copy and crawl_as_copy.
+
+   If PIPELINE is non-NULL, each candidate is also pushed onto that
+   queue as it is discovered, so a concurrent editor drive can consume
+   them; see svn_client__do_commit_pipelined.  Pass NULL for the
+   ordinary batch harvest.  */
 svn_error_t *
 svn_client__harvest_committables (apr_hash_t **committables,
                                   apr_hash_t **locked_dirs,
                                   svn_stringbuf_t *parent_dir,
                                   apr_array_header_t *targets,
+                                  svn_client__commit_pipeline_t *pipeline,
                                   apr_pool_t *pool);
 
 
@@ -375,6 +400,40 @@ svn_client__do_commit (svn_stringbuf_t *base_url,
                        apr_pool_t *pool);
 
 
+#if APR_HAS_THREADS
+/* The pipelined flavor of the commit: harvest BASE_DIR's REL_TARGETS
+   on a producer thread, driving EDITOR/EDIT_BATON with each candidate
+   as it is discovered instead of after the whole crawl.  BASE_URL
+   must be BASE_DIR's own URL; each candidate's URL is rewritten
+   relative to it (a pipelined commit can't condense to the narrowest
+   base the way svn_client__condense_commit_items does, since the
+   candidate set isn't known up front).  HEAD_REV is the repository's
+   youngest revision, for the up-to-date check on propchanged
+   directories.
+
+   On return --- success or failure --- *COMMITTABLES, *LOCKED_DIRS
+   and *COMMIT_ITEMS hold whatever the harvest found, allocated in
+   POOL, so post-commit processing and unlocking work as usual.
+   *COMMIT_ITEMS is NULL if nothing needed committing, in which case
+   the edit is aborted rather than closed.  */
+svn_error_t *
+svn_client__do_commit_pipelined (svn_stringbuf_t *base_url,
+                                 svn_stringbuf_t *base_dir,
+                                 apr_array_header_t *rel_targets,
+                                 apr_hash_t **committables,
+                                 apr_hash_t **locked_dirs,
+                                 apr_array_header_t **commit_items,
+                                 const svn_delta_editor_t *editor,
+                                 void *edit_baton,
+                                 svn_revnum_t head_rev,
+                                 svn_wc_notify_func_t notify_func,
+                                 void *notify_baton,
+                                 svn_stringbuf_t *display_dir,
+                                 apr_hash_t **tempfiles,
+                                 apr_pool_t *pool);
+#endif /* APR_HAS_THREADS */
+
+
 
 #ifdef __cplusplus
 }
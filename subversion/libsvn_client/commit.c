@@ -39,6 +39,17 @@
 #include "client.h"
 
 
+/* Whether svn_client_commit should overlap its working copy crawl
+   with the commit editor drive; see svn_client_set_commit_pipeline. */
+static svn_boolean_t commit_pipeline_enabled = FALSE;
+
+void
+svn_client_set_commit_pipeline (svn_boolean_t enabled)
+{
+  commit_pipeline_enabled = enabled;
+}
+
+
 /* Shared internals of import and commit. */
 
 /* Apply PATH's contents (as a delta against the empty string) to
@@ -116,6 +127,15 @@ import_file (apr_hash_t *files,
 }
              
 
+/* One directory entry, as captured by the single readdir pass that
+   import_dir makes over each directory before descending. */
+struct import_entry
+{
+  const char *name;
+  apr_filetype_e filetype;
+};
+
+
 /* Import directory PATH into the repository directory indicated by
  * DIR_BATON in EDITOR.  ROOT_PATH is the path imported as the root
  * directory, so all edits are relative to that.
@@ -123,7 +143,7 @@ import_file (apr_hash_t *files,
  * Use POOL for any temporary allocation.  */
 static svn_error_t *
 import_dir (apr_hash_t *files,
-            const svn_delta_editor_t *editor, 
+            const svn_delta_editor_t *editor,
             void *dir_baton,
             const svn_stringbuf_t *path,
             const svn_stringbuf_t *edit_path,
@@ -134,48 +154,78 @@ import_dir (apr_hash_t *files,
   apr_finfo_t finfo;
   apr_status_t apr_err;
   apr_int32_t flags = APR_FINFO_TYPE | APR_FINFO_NAME;
+  apr_array_header_t *entries;
+  int i;
   svn_stringbuf_t *this_path, *this_edit_path;
 
   if ((apr_err = apr_dir_open (&dir, path->data, pool)))
-    return svn_error_createf (apr_err, 0, NULL, pool, 
+    return svn_error_createf (apr_err, 0, NULL, pool,
                               "unable to open directory %s", path->data);
 
+  /* Slurp the whole directory in one readdir pass, and close it
+     before descending.  Importing each file below costs an open, a
+     read to the end, and a close; interleaving those with readdir
+     just makes the disk seek back and forth between the directory
+     and its files.  Reading ahead also means only one directory
+     handle is ever open, no matter how deep the tree. */
+  entries = apr_array_make (pool, 16, sizeof (struct import_entry));
+  for (apr_err = apr_dir_read (&finfo, flags, dir);
+       APR_STATUS_IS_SUCCESS (apr_err);
+       apr_err = apr_dir_read (&finfo, flags, dir))
+    {
+      struct import_entry *entry;
+
+      /* Skip entries for this dir and its parent. */
+      if (! (strcmp (finfo.name, ".") && strcmp (finfo.name, "..")))
+        continue;
+
+      entry = apr_array_push (entries);
+      entry->name = apr_pstrdup (pool, finfo.name);
+      entry->filetype = finfo.filetype;
+    }
+
+  /* Check that the loop exited cleanly. */
+  if (! (APR_STATUS_IS_ENOENT (apr_err)))
+    return svn_error_createf
+      (apr_err, 0, NULL, subpool, "error during import of `%s'", path->data);
+
+  /* Yes, it exited cleanly, so close the dir. */
+  else if ((apr_err = apr_dir_close (dir)))
+    return svn_error_createf
+      (apr_err, 0, NULL, subpool, "error closing dir `%s'", path->data);
+
   this_path = svn_stringbuf_dup (path, pool);
   this_edit_path = svn_stringbuf_dup (edit_path, pool);
 
-  for (apr_err = apr_dir_read (&finfo, flags, dir);
-       APR_STATUS_IS_SUCCESS (apr_err);
-       svn_pool_clear (subpool), apr_err = apr_dir_read (&finfo, flags, dir))
+  for (i = 0; i < entries->nelts; i++)
     {
+      struct import_entry *entry
+        = &APR_ARRAY_IDX (entries, i, struct import_entry);
       svn_stringbuf_t *name;
 
-      if (finfo.filetype == APR_DIR)
-        {
-          /* Skip entries for this dir and its parent.  
-             ### kff todo: APR actually promises that they'll come first,
-             so this guard could be moved outside the loop. */
-          if (! (strcmp (finfo.name, ".") && strcmp (finfo.name, "..")))
-            continue;
+      svn_pool_clear (subpool);
 
+      if (entry->filetype == APR_DIR)
+        {
           /* If someone's trying to import a directory named the same
              as our administrative directories, that's probably not
              what they wanted to do.  Someday we can take an option to
              make these subdirs be silently ignored, but for now,
              seems safest to error. */
-          if (strcmp (finfo.name, SVN_WC_ADM_DIR_NAME) == 0)
+          if (strcmp (entry->name, SVN_WC_ADM_DIR_NAME) == 0)
             return svn_error_createf
               (SVN_ERR_CL_ADM_DIR_RESERVED, 0, NULL, subpool,
                "cannot import directory named \"%s\" (in `%s')",
-               finfo.name, path->data);
+               entry->name, path->data);
         }
 
       /* Make a stringbuf version of the entry name, and append it as
          a path component to THIS_PATH and THIS_EDIT_PATH. */
-      name = svn_stringbuf_create (finfo.name, subpool);
+      name = svn_stringbuf_create (entry->name, subpool);
       svn_path_add_component (this_path, name);
       svn_path_add_component (this_edit_path, name);
 
-      if (finfo.filetype == APR_DIR)
+      if (entry->filetype == APR_DIR)
         {
           void *this_dir_baton;
 
@@ -192,7 +242,7 @@ import_dir (apr_hash_t *files,
           /* Finally, close the sub-directory. */
           SVN_ERR (editor->close_directory (this_dir_baton));
         }
-      else if (finfo.filetype == APR_REG)
+      else if (entry->filetype == APR_REG)
         {
           /* Import a file. */
           SVN_ERR (import_file (files, editor, dir_baton, 
@@ -205,22 +255,12 @@ import_dir (apr_hash_t *files,
         }
       
       /* Hack THIS_PATH and THIS_EDIT_PATH back to their original sizes. */
-      svn_stringbuf_chop (this_path, 
+      svn_stringbuf_chop (this_path,
                           (path->len ? name->len + 1 : name->len));
-      svn_stringbuf_chop (this_edit_path, 
+      svn_stringbuf_chop (this_edit_path,
                           (edit_path->len ? name->len + 1 : name->len));
     }
 
-  /* Check that the loop exited cleanly. */
-  if (! (APR_STATUS_IS_ENOENT (apr_err)))
-    return svn_error_createf
-      (apr_err, 0, NULL, subpool, "error during import of `%s'", path->data);
-
-  /* Yes, it exited cleanly, so close the dir. */
-  else if ((apr_err = apr_dir_close (dir)))
-    return svn_error_createf
-      (apr_err, 0, NULL, subpool, "error closing dir `%s'", path->data);
-      
   svn_pool_destroy (subpool);
   return SVN_NO_ERROR;
 }
@@ -701,11 +741,106 @@ svn_client_commit (svn_client_commit_info_t **commit_info,
         }
     }
 
+#if APR_HAS_THREADS
+  /* If a pipelined commit has been requested, try to anchor the
+     commit at the base directory's own URL; candidates then stream
+     into the editor drive as the crawl discovers them.  Without a URL
+     for the anchor (or for an XML commit), fall through to the
+     ordinary two-phase commit below. */
+  if (commit_pipeline_enabled && (! use_xml))
+    {
+      svn_wc_entry_t *b_entry;
+      svn_error_t *b_err = svn_wc_entry (&b_entry, base_dir, pool);
+
+      if (b_err)
+        svn_error_clear_all (b_err);
+      else if (b_entry && b_entry->url)
+        {
+          svn_revnum_t head = SVN_INVALID_REVNUM;
+          apr_array_header_t *no_items
+            = apr_array_make (pool, 1, sizeof (svn_client_commit_item_t *));
+
+          base_url = svn_stringbuf_dup (b_entry->url, pool);
+          committables = NULL;
+          locked_dirs = NULL;
+          commit_items = NULL;
+
+          /* Get the log message up front; the candidate list isn't
+             known yet, so the callback sees an empty one. */
+          if (log_msg_func)
+            {
+              cmt_err = (*log_msg_func) (&log_msg, no_items,
+                                         log_msg_baton, pool);
+              if (cmt_err || (! log_msg))
+                goto cleanup;
+            }
+          else
+            log_msg = svn_stringbuf_create ("", pool);
+
+          /* The wc_prop callbacks normally consult the (condensed)
+             commit item list; with the anchor's own URL as the base,
+             the base_dir fallback inside them maps paths correctly,
+             so no list is needed. */
+          if ((cmt_err = get_ra_editor (&ra_baton, &session, &ra_lib,
+                                        &editor, &edit_baton, auth_baton,
+                                        base_url, base_dir, log_msg,
+                                        NULL, &committed_rev,
+                                        &committed_date, &committed_author,
+                                        TRUE, pool)))
+            goto cleanup;
+
+          /* Make a note that we have a commit-in-progress. */
+          commit_in_progress = TRUE;
+
+          /* The up-to-date check on propchanged directories needs the
+             youngest revision; the drive can't stop to ask for it, so
+             fetch it now. */
+          if ((cmt_err = ra_lib->get_latest_revnum (session, &head)))
+            goto cleanup;
+
+          /* Wrap the resulting editor with BEFORE and AFTER editors. */
+          svn_delta_wrap_editor (&editor, &edit_baton,
+                                 before_editor, before_edit_baton,
+                                 editor, edit_baton,
+                                 after_editor, after_edit_baton, pool);
+
+          /* Calculate a display_dir. */
+          if ((cmt_err = svn_path_get_absolute (&display_dir, display_dir,
+                                                pool)))
+            goto cleanup;
+
+          /* Harvest and drive, overlapped. */
+          cmt_err = svn_client__do_commit_pipelined (base_url, base_dir,
+                                                     rel_targets,
+                                                     &committables,
+                                                     &locked_dirs,
+                                                     &commit_items,
+                                                     editor, edit_baton,
+                                                     head,
+                                                     notify_func,
+                                                     notify_baton,
+                                                     display_dir,
+                                                     &tempfiles, pool);
+
+          /* Make a note that our commit is finished. */
+          commit_in_progress = FALSE;
+
+          /* If nothing needed committing, the edit was aborted and
+             there is no revision to bump to. */
+          if ((! cmt_err) && ((! commit_items) || (! commit_items->nelts)))
+            goto cleanup;
+
+          goto post_commit;
+        }
+    }
+#endif /* APR_HAS_THREADS */
+
   /* Crawl the working copy for commit items. */
-  if ((cmt_err = svn_client__harvest_committables (&committables, 
+  if ((cmt_err = svn_client__harvest_committables (&committables,
                                                    &locked_dirs,
                                                    base_dir,
-                                                   rel_targets, 
+                                                   rel_targets,
+                                                   NULL,
                                                    pool)))
     goto cleanup;
 
@@ -812,6 +947,9 @@ svn_client_commit (svn_client_commit_info_t **commit_info,
   /* Make a note that our commit is finished. */
   commit_in_progress = FALSE;
 
+#if APR_HAS_THREADS
+ post_commit:
+#endif /* APR_HAS_THREADS */
   /* Unlock the locked directories. */
   if (! ((unlock_err = unlock_dirs (locked_dirs, pool))))
     locked_dirs = NULL;
@@ -861,9 +999,6 @@ svn_client_commit (svn_client_commit_info_t **commit_info,
         goto cleanup;
     }
 
-  /* Sleep for one second to ensure timestamp integrity. */
-  apr_sleep (APR_USEC_PER_SEC * 1);
-
  cleanup:
   /* Abort the commit if it is still in progress. */
   if (commit_in_progress)
@@ -23,6 +23,9 @@
 
 #include "apr_pools.h"
 #include "apr_hash.h"
+#include "apr_thread_proc.h"
+#include "apr_thread_mutex.h"
+#include "apr_thread_cond.h"
 
 #include "client.h"
 #include "svn_path.h"
@@ -47,6 +50,48 @@
 /*** Harvesting Commit Candidates ***/
 
 
+/* How many worker threads the commit harvest may crawl with; see
+   svn_client_set_commit_threads. */
+static int harvest_num_threads = 1;
+
+void
+svn_client_set_commit_threads (int num_threads)
+{
+  harvest_num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+
+#if APR_HAS_THREADS
+/* The queue through which a pipelined commit's harvest hands
+   candidates to the editor drive.  The producer (harvest) thread owns
+   the pool ITEMS lives in; both sides touch the queue only with LOCK
+   held. */
+struct svn_client__commit_pipeline
+{
+  apr_array_header_t *items;    /* discovered candidates, in walk order */
+  int next;                     /* index of the next undriven one */
+  svn_boolean_t done;           /* the harvest has finished */
+  svn_boolean_t aborted;        /* the drive gave up; stop queueing */
+  svn_error_t *err;             /* the error the harvest hit, if any */
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_pool_t *pool;             /* for ITEMS; use with LOCK held */
+};
+#endif /* APR_HAS_THREADS */
+
+
+/* One directory waiting to be harvested by a worker thread, carrying
+   the state the recursive walk would have passed down to it. */
+struct harvest_dir
+{
+  svn_stringbuf_t *path;
+  svn_stringbuf_t *url;
+  svn_stringbuf_t *copyfrom_url;        /* may be NULL */
+  svn_wc_entry_t *entry;
+  svn_boolean_t adds_only;
+};
+
+
 /* If DIR isn't already in the LOCKED_DIRS hash, attempt to lock it.
    If the lock is successful, add DIR to the LOCKED_DIRS hash.  Use
    the hash's pool for adding new items, and POOL for any other
@@ -69,9 +114,12 @@ lock_dir (apr_hash_t *locked_dirs,
 
 
 /* Add a new commit candidate (described by all parameters except
-   `COMMITTABLES') to the COMMITABLES hash. */
+   `COMMITTABLES' and `PIPELINE') to the COMMITABLES hash.  If
+   PIPELINE is non-NULL, also queue the candidate there so a
+   concurrent editor drive can pick it up. */
 static void
 add_committable (apr_hash_t *committables,
+                 svn_client__commit_pipeline_t *pipeline,
                  svn_stringbuf_t *path,
                  svn_node_kind_t kind,
                  svn_stringbuf_t *url,
@@ -111,9 +159,25 @@ add_committable (apr_hash_t *committables,
                            ? svn_stringbuf_dup (copyfrom_url, pool)
                            : NULL;
   new_item->state_flags  = state_flags;
-   
+
   /* Now, add the commit item to the array. */
   (*((svn_client_commit_item_t **) apr_array_push (array))) = new_item;
+
+#if APR_HAS_THREADS
+  /* If a pipelined drive is consuming candidates as we find them,
+     queue this one for it. */
+  if (pipeline)
+    {
+      apr_thread_mutex_lock (pipeline->lock);
+      if (! pipeline->aborted)
+        {
+          (*((svn_client_commit_item_t **) apr_array_push (pipeline->items)))
+            = new_item;
+          apr_thread_cond_broadcast (pipeline->cond);
+        }
+      apr_thread_mutex_unlock (pipeline->lock);
+    }
+#endif /* APR_HAS_THREADS */
 }
 
 
@@ -125,7 +189,11 @@ add_committable (apr_hash_t *committables,
    of copied directories.
 
    If in COPY_MODE, the entry is treated as if it is destined to be
-   added with history as URL.  */
+   added with history as URL.
+
+   If DEFER_DIRS is non-NULL, don't recurse into subdirectories;
+   instead, push a `struct harvest_dir *' for each one (allocated in
+   DEFER_DIRS's pool) so the caller can hand them to other workers.  */
 static svn_error_t *
 harvest_committables (apr_hash_t *committables,
                       apr_hash_t *locked_dirs,
@@ -135,10 +203,13 @@ harvest_committables (apr_hash_t *committables,
                       svn_wc_entry_t *entry,
                       svn_boolean_t adds_only,
                       svn_boolean_t copy_mode,
+                      apr_array_header_t *defer_dirs,
+                      svn_client__commit_pipeline_t *pipeline,
                       apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create (pool);
   apr_hash_t *entries = NULL;
+  apr_array_header_t *sorted_entries = NULL;
   svn_boolean_t text_mod = FALSE, prop_mod = FALSE;
   apr_byte_t state_flags = 0;
   svn_stringbuf_t *p_path = svn_stringbuf_dup (path, pool);
@@ -163,7 +234,8 @@ harvest_committables (apr_hash_t *committables,
          entry for it (we were going to have to do this eventually to
          recurse anyway, so... ) */
       svn_wc_entry_t *e = NULL;
-      if (svn_wc_entries_read (&entries, path, subpool))
+      if (svn_wc_entries_read_sorted (&entries, &sorted_entries,
+                                      path, subpool))
         entries = NULL;
 
       if ((entries) 
@@ -297,7 +369,7 @@ harvest_committables (apr_hash_t *committables,
         lock_dir (locked_dirs, p_path, pool);
 
       /* Finally, add the committable item. */
-      add_committable (committables, path, entry->kind, url,
+      add_committable (committables, pipeline, path, entry->kind, url,
                        cf_url ? entry->copyfrom_rev : entry->revision, 
                        cf_url, state_flags);
     }
@@ -309,33 +381,31 @@ harvest_committables (apr_hash_t *committables,
       && ((! (state_flags & SVN_CLIENT_COMMIT_ITEM_DELETE))
           || (state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)))
     {
-      apr_hash_index_t *hi;
+      int i;
       svn_wc_entry_t *this_entry;
       svn_stringbuf_t *full_path = svn_stringbuf_dup (path, subpool);
       svn_stringbuf_t *this_url = svn_stringbuf_dup (url, subpool);
       svn_stringbuf_t *this_cf_url
         = cf_url ? svn_stringbuf_dup (cf_url, subpool) : NULL;
 
-      /* Loop over all other entries in this directory, skipping the
-         "this dir" entry. */
-      for (hi = apr_hash_first (subpool, entries); hi; hi = apr_hash_next (hi))
+      /* Loop over all other entries in this directory in name order
+         (so deferred directories reach the work queue in a stable
+         order), skipping the "this dir" entry. */
+      for (i = 0; i < sorted_entries->nelts; i++)
         {
-          const void *key;
-          apr_ssize_t klen;
-          void *val;
           const char *name;
+          apr_size_t klen;
           svn_stringbuf_t *used_url = NULL;
 
           /* Get the next entry */
-          apr_hash_this (hi, &key, &klen, &val);
-          name = (const char *) key;
-          
+          this_entry = APR_ARRAY_IDX (sorted_entries, i, svn_wc_entry_t *);
+          name = this_entry->name->data;
+          klen = this_entry->name->len;
+
           /* Skip "this dir" */
           if (! strcmp (name, SVN_WC_ENTRY_THIS_DIR))
             continue;
 
-          /* Name is an entry name; value is an entry structure. */
-          this_entry = (svn_wc_entry_t *) val;
           svn_path_add_component_nts (full_path, name);
           if (this_cf_url)
             svn_path_add_component_nts (this_cf_url, name);
@@ -349,15 +419,35 @@ harvest_committables (apr_hash_t *committables,
               used_url = this_url;
             }
 
-          /* Recurse. */
-          SVN_ERR (harvest_committables 
-                   (committables, locked_dirs, full_path,
-                    used_url ? used_url : this_entry->url,
-                    this_cf_url,
-                    (svn_wc_entry_t *)val, 
-                    adds_only,
-                    copy_mode,
-                    subpool));
+          /* Either hand the subdirectory off for another worker, or
+             recurse into it ourselves. */
+          if (defer_dirs && (this_entry->kind == svn_node_dir))
+            {
+              apr_pool_t *defer_pool = defer_dirs->pool;
+              struct harvest_dir *dd = apr_palloc (defer_pool, sizeof (*dd));
+
+              dd->path = svn_stringbuf_dup (full_path, defer_pool);
+              dd->url = svn_stringbuf_dup (used_url
+                                           ? used_url
+                                           : this_entry->url, defer_pool);
+              dd->copyfrom_url = this_cf_url
+                                 ? svn_stringbuf_dup (this_cf_url, defer_pool)
+                                 : NULL;
+              dd->entry = svn_wc_entry_dup (this_entry, defer_pool);
+              dd->adds_only = adds_only;
+              (*((struct harvest_dir **) apr_array_push (defer_dirs))) = dd;
+            }
+          else
+            SVN_ERR (harvest_committables
+                     (committables, locked_dirs, full_path,
+                      used_url ? used_url : this_entry->url,
+                      this_cf_url,
+                      this_entry,
+                      adds_only,
+                      copy_mode,
+                      defer_dirs,
+                      pipeline,
+                      subpool));
 
           /* Truncate paths back to their pre-loop state. */
           svn_stringbuf_chop (full_path, klen + 1);
@@ -375,11 +465,248 @@ harvest_committables (apr_hash_t *committables,
 }
 
 
+#if APR_HAS_THREADS
+
+/* The work queue a threaded harvest distributes directories from.
+   Workers pop the next unclaimed directory, harvest it into their own
+   private hashes, and push whatever subdirectories it defers; when no
+   work is left and no worker is mid-directory, everyone goes home. */
+struct harvest_queue
+{
+  apr_array_header_t *dirs;     /* harvest_dir work items */
+  int next;                     /* index of the next unclaimed one */
+  int active;                   /* workers currently mid-directory */
+  svn_boolean_t copy_mode;
+  svn_error_t *err;             /* first error any worker hit */
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_pool_t *pool;             /* for queue entries; use with LOCK held */
+};
+
+
+/* One worker's private state. */
+struct harvest_worker
+{
+  struct harvest_queue *queue;
+  apr_hash_t *committables;     /* this worker's candidates */
+  apr_hash_t *locked_dirs;      /* the dirs this worker locked */
+  apr_pool_t *pool;             /* this worker's private pool */
+};
+
+
+static void *
+harvest_crawl_worker (apr_thread_t *thread, void *data)
+{
+  struct harvest_worker *worker = data;
+  struct harvest_queue *q = worker->queue;
+
+  apr_thread_mutex_lock (q->lock);
+  while (1)
+    {
+      struct harvest_dir *dd;
+      apr_array_header_t *defer;
+      svn_error_t *err;
+      int i;
+
+      /* Wait until there's either a directory to claim or nobody
+         left who could produce one. */
+      while ((q->next >= q->dirs->nelts) && (q->active > 0) && (! q->err))
+        apr_thread_cond_wait (q->cond, q->lock);
+
+      if (q->err || (q->next >= q->dirs->nelts))
+        break;
+
+      dd = APR_ARRAY_IDX (q->dirs, q->next, struct harvest_dir *);
+      q->next++;
+      q->active++;
+      apr_thread_mutex_unlock (q->lock);
+
+      /* Do the actual work outside the lock, against our private
+         hashes and pool. */
+      defer = apr_array_make (worker->pool, 4,
+                              sizeof (struct harvest_dir *));
+      err = harvest_committables (worker->committables, worker->locked_dirs,
+                                  svn_stringbuf_dup (dd->path, worker->pool),
+                                  svn_stringbuf_dup (dd->url, worker->pool),
+                                  dd->copyfrom_url
+                                  ? svn_stringbuf_dup (dd->copyfrom_url,
+                                                       worker->pool)
+                                  : NULL,
+                                  svn_wc_entry_dup (dd->entry, worker->pool),
+                                  dd->adds_only, q->copy_mode,
+                                  defer, NULL, worker->pool);
+
+      apr_thread_mutex_lock (q->lock);
+      q->active--;
+      if (err && (! q->err))
+        q->err = err;
+      for (i = 0; i < defer->nelts; i++)
+        {
+          struct harvest_dir *src
+            = APR_ARRAY_IDX (defer, i, struct harvest_dir *);
+          struct harvest_dir *queued = apr_palloc (q->pool, sizeof (*queued));
+
+          queued->path = svn_stringbuf_dup (src->path, q->pool);
+          queued->url = svn_stringbuf_dup (src->url, q->pool);
+          queued->copyfrom_url = src->copyfrom_url
+                                 ? svn_stringbuf_dup (src->copyfrom_url,
+                                                      q->pool)
+                                 : NULL;
+          queued->entry = svn_wc_entry_dup (src->entry, q->pool);
+          queued->adds_only = src->adds_only;
+          (*((struct harvest_dir **) apr_array_push (q->dirs))) = queued;
+        }
+
+      /* Wake the others: either there's new work for them, or --- if
+         we were the last one busy and found nothing --- it's time to
+         go home. */
+      apr_thread_cond_broadcast (q->cond);
+    }
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+/* The threaded version of the commit harvest: crawl the tree under
+   PATH (whose entry is ENTRY and ancestry URL is URL) with
+   NUM_THREADS workers, merging their candidates into COMMITTABLES and
+   their locked directories into LOCKED_DIRS.  The merged candidate
+   list is sorted by URL, so the outcome doesn't depend on which
+   worker claimed which directory. */
+static svn_error_t *
+harvest_committables_threaded (apr_hash_t *committables,
+                               apr_hash_t *locked_dirs,
+                               svn_stringbuf_t *path,
+                               svn_stringbuf_t *url,
+                               svn_wc_entry_t *entry,
+                               int num_threads,
+                               apr_pool_t *pool)
+{
+  struct harvest_queue queue;
+  struct harvest_worker *workers;
+  apr_thread_t **threads;
+  apr_hash_t *entries;
+  apr_status_t apr_err;
+  struct harvest_dir *dd;
+  apr_array_header_t *merged;
+  int i;
+
+  /* Prime the entries cache from this thread, so the workers don't
+     race to create its machinery.  (See entries.c.) */
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+
+  queue.dirs = apr_array_make (pool, 16, sizeof (struct harvest_dir *));
+  dd = apr_palloc (pool, sizeof (*dd));
+  dd->path = svn_stringbuf_dup (path, pool);
+  dd->url = svn_stringbuf_dup (url, pool);
+  dd->copyfrom_url = NULL;
+  dd->entry = svn_wc_entry_dup (entry, pool);
+  dd->adds_only = FALSE;
+  (*((struct harvest_dir **) apr_array_push (queue.dirs))) = dd;
+  queue.next = 0;
+  queue.active = 0;
+  queue.copy_mode = FALSE;
+  queue.err = NULL;
+  queue.pool = pool;
+  apr_err = apr_thread_mutex_create (&queue.lock, APR_THREAD_MUTEX_DEFAULT,
+                                     pool);
+  if (! apr_err)
+    apr_err = apr_thread_cond_create (&queue.cond, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "harvest_committables_threaded: "
+                             "can't create crawl queue");
+
+  workers = apr_pcalloc (pool, num_threads * sizeof (*workers));
+  threads = apr_pcalloc (pool, num_threads * sizeof (*threads));
+  for (i = 0; i < num_threads; i++)
+    {
+      workers[i].queue = &queue;
+
+      /* An independent top-level pool; pools aren't safe to share
+         across threads. */
+      workers[i].pool = svn_pool_create (NULL);
+      workers[i].committables = apr_hash_make (workers[i].pool);
+      workers[i].locked_dirs = apr_hash_make (workers[i].pool);
+
+      apr_err = apr_thread_create (&threads[i], NULL, harvest_crawl_worker,
+                                   &workers[i], pool);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "harvest_committables_threaded: "
+                                 "can't create worker");
+    }
+
+  for (i = 0; i < num_threads; i++)
+    {
+      apr_status_t ignored;
+      apr_thread_join (&ignored, threads[i]);
+    }
+
+  /* If a worker failed, hand its error on.  (The error lives in that
+     worker's pool, so we can't clean the pools up here.) */
+  if (queue.err)
+    return queue.err;
+
+  /* Merge the workers' results into the caller's hashes.  Each
+     directory was claimed by exactly one worker, so locked dirs and
+     candidates are disjoint across workers. */
+  for (i = 0; i < num_threads; i++)
+    {
+      apr_hash_index_t *hi;
+      apr_array_header_t *array;
+      int j;
+
+      for (hi = apr_hash_first (pool, workers[i].locked_dirs); hi;
+           hi = apr_hash_next (hi))
+        {
+          const void *key;
+          apr_ssize_t klen;
+
+          apr_hash_this (hi, &key, &klen, NULL);
+          if (! apr_hash_get (locked_dirs, key, klen))
+            apr_hash_set (locked_dirs, apr_pstrmemdup (pool, key, klen),
+                          klen, (void *)1);
+        }
+
+      array = apr_hash_get (workers[i].committables,
+                            SVN_CLIENT__SINGLE_REPOS_NAME,
+                            APR_HASH_KEY_STRING);
+      for (j = 0; array && (j < array->nelts); j++)
+        {
+          svn_client_commit_item_t *item
+            = ((svn_client_commit_item_t **) array->elts)[j];
+
+          add_committable (committables, NULL, item->path, item->kind,
+                           item->url, item->revision, item->copyfrom_url,
+                           item->state_flags);
+        }
+
+      svn_pool_destroy (workers[i].pool);
+    }
+
+  /* Sort the merged candidates by URL; the order they arrived in
+     depends on worker scheduling. */
+  merged = apr_hash_get (committables, SVN_CLIENT__SINGLE_REPOS_NAME,
+                         APR_HASH_KEY_STRING);
+  if (merged)
+    qsort (merged->elts, merged->nelts, merged->elt_size,
+           svn_client__sort_commit_item_urls);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
 svn_error_t *
 svn_client__harvest_committables (apr_hash_t **committables,
                                   apr_hash_t **locked_dirs,
                                   svn_stringbuf_t *parent_dir,
                                   apr_array_header_t *targets,
+                                  svn_client__commit_pipeline_t *pipeline,
                                   apr_pool_t *pool)
 {
   int i = 0;
@@ -470,9 +797,22 @@ svn_client__harvest_committables (apr_hash_t **committables,
            "inside of an unversioned (or not-yet-versioned) directory?",
            target->data);
 
-      /* Handle our TARGET. */
-      SVN_ERR (harvest_committables (*committables, *locked_dirs, target, 
-                                     url, NULL, entry, FALSE, FALSE, pool));
+      /* Handle our TARGET.  If a worker pool has been requested,
+         crawl directory targets with it instead of recursing
+         serially --- unless a pipelined drive is consuming the
+         candidates, which needs the serial walk's depth-first
+         order. */
+#if APR_HAS_THREADS
+      if ((harvest_num_threads > 1) && (entry->kind == svn_node_dir)
+          && (pipeline == NULL))
+        SVN_ERR (harvest_committables_threaded (*committables, *locked_dirs,
+                                                target, url, entry,
+                                                harvest_num_threads, pool));
+      else
+#endif /* APR_HAS_THREADS */
+        SVN_ERR (harvest_committables (*committables, *locked_dirs, target,
+                                       url, NULL, entry, FALSE, FALSE,
+                                       NULL, pipeline, pool));
 
       /* Reset our base path for the next iteration, and increment our
          counter. */
@@ -507,9 +847,9 @@ svn_client__get_copy_committables (apr_hash_t **committables,
       (SVN_ERR_ENTRY_NOT_FOUND, 0, NULL, pool, target->data);
       
   /* Handle our TARGET. */
-  SVN_ERR (harvest_committables (*committables, *locked_dirs, target, 
-                                 new_url, entry->url, entry, 
-                                 FALSE, TRUE, pool));
+  SVN_ERR (harvest_committables (*committables, *locked_dirs, target,
+                                 new_url, entry->url, entry,
+                                 FALSE, TRUE, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -845,6 +1185,147 @@ do_item_commit (const char *url,
 }
 
 
+/* Drive EDITOR with one ITEM (whose URL is relative to the commit's
+   base): close and open whatever directories separate it from
+   *LAST_URL (the previous item's directory, or NULL for the first
+   item), then commit the item itself.  DB_STACK, STACK_PTR, FILE_MODS
+   and TEMPFILES carry the drive's state from item to item. */
+static svn_error_t *
+drive_commit_item (svn_client_commit_item_t *item,
+                   svn_stringbuf_t **last_url,
+                   const svn_delta_editor_t *editor,
+                   apr_array_header_t *db_stack,
+                   int *stack_ptr,
+                   apr_array_header_t *file_mods,
+                   apr_hash_t *tempfiles,
+                   svn_wc_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_stringbuf_t *display_dir,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *item_url, *item_dir, *item_name;
+  svn_stringbuf_t *common = NULL;
+
+  /* Get the commit item URL. */
+  item_url = item->url;
+
+  /*** Step A - Find the common ancestor of the last commit item
+       and the current one.  For the first item, this is just
+       the empty string.  ***/
+  if (*last_url)
+    common = svn_path_get_longest_ancestor (*last_url, item_url, pool);
+  if (! common)
+    common = svn_stringbuf_create ("", pool);
+
+  /*** Step B - Close any directories between the last commit item
+       and the new common ancestor, if any need to be closed.
+       Sometimes there is nothing to do here (like, for the first
+       item, or when the last commit item was an ancestor of
+       the current item).  ***/
+  if ((*last_url) && ((*last_url)->len > common->len))
+    {
+      char *rel = (*last_url)->data + (common->len ? (common->len + 1) : 0);
+      int count = count_components (rel);
+      while (count--)
+        {
+          SVN_ERR (pop_stack (db_stack, stack_ptr, editor));
+        }
+    }
+
+  /*** Step C - Open any directories between the common ancestor
+       and the parent of the commit item. ***/
+  svn_path_split (item_url, &item_dir, &item_name, pool);
+  if (item_dir->len > common->len)
+    {
+      char *rel = apr_pstrdup (pool, item_dir->data);
+      char *piece = rel + common->len + 1;
+
+      while (1)
+        {
+          /* Find the first separator. */
+          piece = strchr (piece, '/');
+
+          /* Temporarily replace it with a NULL terminator. */
+          if (piece)
+            *piece = 0;
+
+          /* Open the subdirectory. */
+          SVN_ERR (push_stack (rel, db_stack, stack_ptr,
+                               editor, NULL, SVN_INVALID_REVNUM,
+                               FALSE, pool));
+
+          /* If we temporarily replaced a '/' with a NULL,
+             un-replace it and move our piece pointer to the
+             character after the '/' we found.  If there was no
+             piece found, though, we're done.  */
+          if (piece)
+            {
+              *piece = '/';
+              piece++;
+            }
+          else
+            break;
+        }
+    }
+
+  /*** Step D - Commit the item.  ***/
+  SVN_ERR (do_item_commit (item_url->data, item, editor,
+                           db_stack, stack_ptr, file_mods, tempfiles,
+                           notify_func, notify_baton, display_dir, pool));
+
+  /* Save our state for the next item. */
+  if ((item->kind == svn_node_dir)
+      && ((! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_DELETE))
+          || (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)))
+    *last_url = item_url;
+  else
+    *last_url = item_dir;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Transmit the text deltas queued in FILE_MODS through EDITOR, then
+   empty the queue. */
+static svn_error_t *
+transmit_file_mods (apr_array_header_t *file_mods,
+                    const svn_delta_editor_t *editor,
+                    apr_hash_t *tempfiles,
+                    svn_wc_notify_func_t notify_func,
+                    void *notify_baton,
+                    apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < file_mods->nelts; i++)
+    {
+      struct file_mod_t *mod
+        = ((struct file_mod_t *) file_mods->elts) + i;
+      svn_client_commit_item_t *item = mod->item;
+      void *file_baton = mod->file_baton;
+      svn_stringbuf_t *tempfile;
+      svn_boolean_t fulltext = FALSE;
+
+      if (notify_func)
+        (*notify_func) (notify_baton, svn_wc_notify_commit_postfix_txdelta,
+                        item->path->data);
+
+      if (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+        fulltext = TRUE;
+
+      SVN_ERR (svn_wc_transmit_text_deltas (item->path, fulltext,
+                                            editor, file_baton,
+                                            &tempfile, pool));
+      if (tempfile && tempfiles)
+        apr_hash_set (tempfiles, tempfile->data, tempfile->len, (void *)1);
+    }
+
+  file_mods->nelts = 0;
+
+  return SVN_NO_ERROR;
+}
+
+
 #ifdef SVN_CLIENT_COMMIT_DEBUG
 /* Prototype for function below */
 static svn_error_t *get_test_editor (const svn_delta_editor_t **editor,
@@ -865,8 +1346,9 @@ svn_client__do_commit (svn_stringbuf_t *base_url,
                        apr_pool_t *pool)
 {
   apr_array_header_t *db_stack;
-  apr_array_header_t *file_mods 
+  apr_array_header_t *file_mods
     = apr_array_make (pool, 1, sizeof (struct file_mod_t));
+  svn_stringbuf_t *last_url = NULL;
   int i, stack_ptr = 0;
 
 #ifdef SVN_CLIENT_COMMIT_DEBUG
@@ -893,122 +1375,317 @@ svn_client__do_commit (svn_stringbuf_t *base_url,
      driving the editor. */
   for (i = 0; i < commit_items->nelts; i++)
     {
-      svn_stringbuf_t *last_url, *item_url, *item_dir, *item_name;
-      svn_stringbuf_t *common = NULL;
       svn_client_commit_item_t *item
         = ((svn_client_commit_item_t **) commit_items->elts)[i];
-      
-      /* Get the next commit item URL. */
-      item_url = item->url;
-
-      /*** Step A - Find the common ancestor of the last commit item
-           and the current one.  For the first iteration, this is just
-           the empty string.  ***/
-      if (i > 0)
-        common = svn_path_get_longest_ancestor (last_url, item_url, pool);
-      if (! common)
-        common = svn_stringbuf_create ("", pool);
-
-      /*** Step B - Close any directories between the last commit item
-           and the new common ancestor, if any need to be closed.
-           Sometimes there is nothing to do here (like, for the first
-           iteration, or when the last commit item was an ancestor of
-           the current item).  ***/
-      if ((i > 0) && (last_url->len > common->len))
+
+      SVN_ERR (drive_commit_item (item, &last_url, editor,
+                                  db_stack, &stack_ptr, file_mods, *tempfiles,
+                                  notify_func, notify_baton, display_dir,
+                                  pool));
+    }
+
+  /* Close down any remaining open directory batons. */
+  while (stack_ptr)
+    {
+      SVN_ERR (pop_stack (db_stack, &stack_ptr, editor));
+    }
+
+  /* Transmit outstanding text deltas. */
+  SVN_ERR (transmit_file_mods (file_mods, editor, *tempfiles,
+                               notify_func, notify_baton, pool));
+
+  /* Close the edit. */
+  SVN_ERR (editor->close_edit (edit_baton));
+  return SVN_NO_ERROR;
+}
+
+
+#if APR_HAS_THREADS
+
+/* What the producer thread of a pipelined commit needs to run the
+   harvest.  Everything here lives in POOL, the producer's private
+   pool, so its allocations never race the consumer's. */
+struct harvest_producer_baton
+{
+  svn_client__commit_pipeline_t *pipeline;
+  svn_stringbuf_t *base_dir;
+  apr_array_header_t *rel_targets;
+  apr_hash_t *committables;     /* the harvest's results */
+  apr_hash_t *locked_dirs;
+  apr_pool_t *pool;
+};
+
+
+static void *
+harvest_producer (apr_thread_t *thread, void *data)
+{
+  struct harvest_producer_baton *pb = data;
+  svn_client__commit_pipeline_t *q = pb->pipeline;
+  svn_error_t *err;
+
+  err = svn_client__harvest_committables (&pb->committables,
+                                          &pb->locked_dirs,
+                                          pb->base_dir, pb->rel_targets,
+                                          q, pb->pool);
+
+  apr_thread_mutex_lock (q->lock);
+  q->err = err;
+  q->done = TRUE;
+  apr_thread_cond_broadcast (q->cond);
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+svn_error_t *
+svn_client__do_commit_pipelined (svn_stringbuf_t *base_url,
+                                 svn_stringbuf_t *base_dir,
+                                 apr_array_header_t *rel_targets,
+                                 apr_hash_t **committables,
+                                 apr_hash_t **locked_dirs,
+                                 apr_array_header_t **commit_items,
+                                 const svn_delta_editor_t *editor,
+                                 void *edit_baton,
+                                 svn_revnum_t head_rev,
+                                 svn_wc_notify_func_t notify_func,
+                                 void *notify_baton,
+                                 svn_stringbuf_t *display_dir,
+                                 apr_hash_t **tempfiles,
+                                 apr_pool_t *pool)
+{
+  svn_client__commit_pipeline_t queue;
+  struct harvest_producer_baton pb;
+  apr_thread_t *thread;
+  apr_status_t apr_err;
+  apr_array_header_t *db_stack = NULL;
+  apr_array_header_t *file_mods
+    = apr_array_make (pool, 1, sizeof (struct file_mod_t));
+  svn_stringbuf_t *last_url = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int items_driven = 0;
+  int stack_ptr = 0;
+  int i;
+
+  /* If the caller wants us to track temporary file creation, create a
+     hash to store those paths in. */
+  if (tempfiles)
+    *tempfiles = apr_hash_make (pool);
+
+  /* Set up the candidate queue.  Its pool is only ever touched with
+     the lock held. */
+  queue.pool = svn_pool_create (NULL);
+  queue.items = apr_array_make (queue.pool, 16,
+                                sizeof (svn_client_commit_item_t *));
+  queue.next = 0;
+  queue.done = FALSE;
+  queue.aborted = FALSE;
+  queue.err = NULL;
+  apr_err = apr_thread_mutex_create (&queue.lock, APR_THREAD_MUTEX_DEFAULT,
+                                     pool);
+  if (! apr_err)
+    apr_err = apr_thread_cond_create (&queue.cond, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "pipelined commit: can't create queue");
+
+  /* Give the producer its own top-level pool to harvest in; pools
+     aren't safe to share across threads. */
+  pb.pipeline = &queue;
+  pb.pool = svn_pool_create (NULL);
+  pb.base_dir = svn_stringbuf_dup (base_dir, pb.pool);
+  pb.rel_targets = apr_array_make (pb.pool, rel_targets->nelts,
+                                   sizeof (svn_stringbuf_t *));
+  for (i = 0; i < rel_targets->nelts; i++)
+    (*((svn_stringbuf_t **) apr_array_push (pb.rel_targets)))
+      = svn_stringbuf_dup (APR_ARRAY_IDX (rel_targets, i, svn_stringbuf_t *),
+                           pb.pool);
+  pb.committables = NULL;
+  pb.locked_dirs = NULL;
+
+  apr_err = apr_thread_create (&thread, NULL, harvest_producer, &pb, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "pipelined commit: can't create harvest thread");
+
+  /* We start by opening the root. */
+  err = init_stack (&db_stack, &stack_ptr, editor, edit_baton, pool);
+
+  /* Consume candidates as they arrive, driving the editor.  The
+     harvest walks depth first, so each directory's candidates arrive
+     contiguously --- the same invariant the sorted batch drive
+     relies on. */
+  while (! err)
+    {
+      svn_client_commit_item_t *item;
+      svn_stringbuf_t *url;
+
+      apr_thread_mutex_lock (queue.lock);
+      while ((queue.next >= queue.items->nelts) && (! queue.done))
+        apr_thread_cond_wait (queue.cond, queue.lock);
+      if (queue.next >= queue.items->nelts)
         {
-          char *rel = last_url->data + (common->len ? (common->len + 1) : 0);
-          int count = count_components (rel);
-          while (count--)
-            {
-              SVN_ERR (pop_stack (db_stack, &stack_ptr, editor));
-            }
+          apr_thread_mutex_unlock (queue.lock);
+          break;
         }
+      item = APR_ARRAY_IDX (queue.items, queue.next,
+                            svn_client_commit_item_t *);
+      queue.next++;
+      apr_thread_mutex_unlock (queue.lock);
 
-      /*** Step C - Open any directories between the common ancestor
-           and the parent of the commit item. ***/
-      svn_path_split (item_url, &item_dir, &item_name, pool);
-      if (item_dir->len > common->len)
+      /* Rewrite the candidate's URL relative to the commit anchor,
+         the way svn_client__condense_commit_items would have. */
+      url = item->url;
+      if ((url->len < base_url->len)
+          || (memcmp (url->data, base_url->data, base_url->len) != 0)
+          || ((url->len > base_url->len)
+              && (url->data[base_url->len] != '/')))
+        err = svn_error_createf
+          (SVN_ERR_ILLEGAL_TARGET, 0, NULL, pool,
+           "pipelined commit: `%s' is not beneath the commit anchor `%s'",
+           url->data, base_url->data);
+      else if ((url->len == base_url->len)
+               && (! ((item->kind == svn_node_dir)
+                      && (item->state_flags
+                          == SVN_CLIENT_COMMIT_ITEM_PROP_MODS))))
+        err = svn_error_createf
+          (SVN_ERR_ILLEGAL_TARGET, 0, NULL, pool,
+           "pipelined commit: cannot commit `%s' without anchoring above it",
+           item->path->data);
+      else if (url->len > base_url->len)
         {
-          char *rel = apr_pstrdup (pool, item_dir->data);
-          char *piece = rel + common->len + 1;
-
-          while (1)
-            {
-              /* Find the first separator. */
-              piece = strchr (piece, '/');
-
-              /* Temporarily replace it with a NULL terminator. */
-              if (piece)
-                *piece = 0;
-
-              /* Open the subdirectory. */
-              SVN_ERR (push_stack (rel, db_stack, &stack_ptr, 
-                                   editor, NULL, SVN_INVALID_REVNUM,
-                                   FALSE, pool));
-              
-              /* If we temporarily replaced a '/' with a NULL,
-                 un-replace it and move our piece pointer to the
-                 character after the '/' we found.  If there was no
-                 piece found, though, we're done.  */
-              if (piece)
-                {
-                  *piece = '/';
-                  piece++;    
-                }
-              else
-                break;
-            }
+          memmove (url->data,
+                   url->data + base_url->len + 1,
+                   url->len - base_url->len - 1);
+          url->len = url->len - base_url->len - 1;
+          url->data[url->len] = 0;
+        }
+      else
+        {
+          url->data[0] = 0;
+          url->len = 0;
         }
 
-      /*** Step D - Commit the item.  ***/
-      SVN_ERR (do_item_commit (item_url->data, item, editor,
-                               db_stack, &stack_ptr, file_mods, *tempfiles,
-                               notify_func, notify_baton, display_dir, pool));
-
-      /* Save our state for the next iteration. */
-      if ((item->kind == svn_node_dir)
-          && ((! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_DELETE))
-              || (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)))
-        last_url = item_url;
+      /* ### Temporary: like the pre-drive check in commit.c, insist
+         that a non-added directory with property mods be up-to-date.
+         Someday this should just be protected against by the
+         server. */
+      if ((! err)
+          && (item->kind == svn_node_dir)
+          && (item->state_flags & SVN_CLIENT_COMMIT_ITEM_PROP_MODS)
+          && (! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD))
+          && (item->revision != head_rev))
+        err = svn_error_createf
+          (SVN_ERR_WC_NOT_UP_TO_DATE, 0, NULL, pool,
+           "Cannot commit propchanges for directory '%s'",
+           item->path->data);
+
+      if (! err)
+        err = drive_commit_item (item, &last_url, editor,
+                                 db_stack, &stack_ptr, file_mods,
+                                 tempfiles ? *tempfiles : NULL,
+                                 notify_func, notify_baton, display_dir,
+                                 pool);
+
+      /* Send the item's text right away; this is where the overlap
+         with the harvest's disk work actually pays off. */
+      if (! err)
+        err = transmit_file_mods (file_mods, editor,
+                                  tempfiles ? *tempfiles : NULL,
+                                  notify_func, notify_baton, pool);
+
+      if (err)
+        {
+          /* Tell the producer to stop queueing; it finishes its walk
+             (harmlessly) and we pick up the pieces below. */
+          apr_thread_mutex_lock (queue.lock);
+          queue.aborted = TRUE;
+          apr_thread_mutex_unlock (queue.lock);
+        }
       else
-        last_url = item_dir;
+        items_driven++;
     }
 
-  /* Close down any remaining open directory batons. */
-  while (stack_ptr)
+  {
+    apr_status_t ignored;
+    apr_thread_join (&ignored, thread);
+  }
+
+  /* Copy the harvest's results out before tearing its pool down; the
+     locks it took must be released even if the drive failed. */
+  *committables = apr_hash_make (pool);
+  *locked_dirs = apr_hash_make (pool);
+  *commit_items = NULL;
+  if (pb.locked_dirs)
     {
-      SVN_ERR (pop_stack (db_stack, &stack_ptr, editor));
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first (pool, pb.locked_dirs); hi;
+           hi = apr_hash_next (hi))
+        {
+          const void *key;
+          apr_ssize_t klen;
+
+          apr_hash_this (hi, &key, &klen, NULL);
+          apr_hash_set (*locked_dirs, apr_pstrmemdup (pool, key, klen),
+                        klen, (void *)1);
+        }
     }
+  if (pb.committables)
+    {
+      apr_array_header_t *array
+        = apr_hash_get (pb.committables, SVN_CLIENT__SINGLE_REPOS_NAME,
+                        APR_HASH_KEY_STRING);
 
-  /* Transmit outstanding text deltas. */
-  for (i = 0; i < file_mods->nelts; i++)
+      for (i = 0; array && (i < array->nelts); i++)
+        {
+          svn_client_commit_item_t *item
+            = ((svn_client_commit_item_t **) array->elts)[i];
+
+          add_committable (*committables, NULL, item->path, item->kind,
+                           item->url, item->revision, item->copyfrom_url,
+                           item->state_flags);
+        }
+    }
+  *commit_items = apr_hash_get (*committables, SVN_CLIENT__SINGLE_REPOS_NAME,
+                                APR_HASH_KEY_STRING);
+
+  svn_pool_destroy (queue.pool);
+
+  /* If the harvest failed, hand its error on.  (The error lives in
+     the producer's pool, so that pool has to stay.) */
+  if (queue.err)
     {
-      struct file_mod_t *mod
-        = ((struct file_mod_t *) file_mods->elts) + i;
-      svn_client_commit_item_t *item = mod->item;
-      void *file_baton = mod->file_baton;
-      svn_stringbuf_t *tempfile;
-      svn_boolean_t fulltext = FALSE;
+      if (err)
+        svn_error_compose (queue.err, err);
+      return queue.err;
+    }
 
-      if (notify_func)
-        (*notify_func) (notify_baton, svn_wc_notify_commit_postfix_txdelta, 
-                        item->path->data);
+  svn_pool_destroy (pb.pool);
 
-      if (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-        fulltext = TRUE;
+  if (err)
+    return err;
 
-      SVN_ERR (svn_wc_transmit_text_deltas (item->path, fulltext,
-                                            editor, file_baton, 
-                                            &tempfile, pool));
-      if (tempfile && *tempfiles)
-        apr_hash_set (*tempfiles, tempfile->data, tempfile->len, (void *)1);
+  if (items_driven == 0)
+    {
+      /* Nothing needed committing; don't create an empty revision. */
+      (void) editor->abort_edit (edit_baton);
+      return SVN_NO_ERROR;
     }
 
-  /* Close the edit. */
+  /* Close down any remaining open directory batons, and the edit. */
+  while (stack_ptr)
+    {
+      SVN_ERR (pop_stack (db_stack, &stack_ptr, editor));
+    }
   SVN_ERR (editor->close_edit (edit_baton));
+
   return SVN_NO_ERROR;
 }
 
+#endif /* APR_HAS_THREADS */
+
 
 svn_client_commit_info_t *
 svn_client__make_commit_info (svn_revnum_t revision,
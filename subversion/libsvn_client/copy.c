@@ -452,6 +452,100 @@ reconcile_errors (svn_error_t *commit_err,
 
 
 
+/* Set *UNMODIFIED to TRUE iff the working copy tree rooted at PATH,
+   whose entry is ENTRY, is an exact image of REVISION in the
+   repository: every entry is schedule-normal at REVISION, nothing is
+   switched away from its natural URL, and no text or props differ
+   from the base.  Such a tree need not be transmitted at all; the
+   repository can copy ENTRY's URL directly. */
+static svn_error_t *
+wc_tree_is_unmodified (svn_boolean_t *unmodified,
+                       svn_stringbuf_t *path,
+                       svn_wc_entry_t *entry,
+                       svn_revnum_t revision,
+                       apr_pool_t *pool)
+{
+  svn_boolean_t modified;
+
+  *unmodified = FALSE;
+
+  /* Scheduled changes and copies mean local modifications, as do
+     mixed revisions -- the repository tree at REVISION would not
+     match the working copy. */
+  if ((entry->schedule != svn_wc_schedule_normal)
+      || (entry->copied)
+      || (entry->revision != revision))
+    return SVN_NO_ERROR;
+
+  SVN_ERR (svn_wc_props_modified_p (&modified, path, pool));
+  if (modified)
+    return SVN_NO_ERROR;
+
+  if (entry->kind == svn_node_file)
+    {
+      SVN_ERR (svn_wc_text_modified_p (&modified, path, pool));
+      if (modified)
+        return SVN_NO_ERROR;
+    }
+  else if (entry->kind == svn_node_dir)
+    {
+      apr_hash_t *entries;
+      apr_hash_index_t *hi;
+      apr_pool_t *subpool = svn_pool_create (pool);
+
+      SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+      for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+        {
+          const void *key;
+          void *val;
+          svn_wc_entry_t *this_entry;
+          svn_stringbuf_t *this_path, *this_url;
+          svn_boolean_t this_unmodified;
+
+          apr_hash_this (hi, &key, NULL, &val);
+          this_entry = val;
+
+          /* Skip the "this dir" entry; it describes PATH itself,
+             which we checked above. */
+          if (! strcmp (key, SVN_WC_ENTRY_THIS_DIR))
+            continue;
+
+          this_path = svn_stringbuf_dup (path, subpool);
+          svn_path_add_component_nts (this_path, key);
+
+          /* The entries of subdirs carry only their `kind'; read the
+             full entry from the subdir itself. */
+          if (this_entry->kind == svn_node_dir)
+            {
+              SVN_ERR (svn_wc_entry (&this_entry, this_path, subpool));
+              if (! this_entry)
+                return SVN_NO_ERROR;
+            }
+
+          /* A switched entry means the tree is not an image of any
+             single repository URL. */
+          this_url = svn_stringbuf_dup (entry->url, subpool);
+          svn_path_add_component_nts (this_url, key);
+          if ((! this_entry->url)
+              || (! svn_stringbuf_compare (this_url, this_entry->url)))
+            return SVN_NO_ERROR;
+
+          SVN_ERR (wc_tree_is_unmodified (&this_unmodified, this_path,
+                                          this_entry, revision, subpool));
+          if (! this_unmodified)
+            return SVN_NO_ERROR;
+
+          svn_pool_clear (subpool);
+        }
+
+      svn_pool_destroy (subpool);
+    }
+
+  *unmodified = TRUE;
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 wc_to_repos_copy (svn_client_commit_info_t **commit_info,
                   svn_stringbuf_t *src_path, 
@@ -482,6 +576,38 @@ wc_to_repos_copy (svn_client_commit_info_t **commit_info,
   /* Check the SRC_PATH. */
   SVN_ERR (svn_io_check_path (src_path->data, &src_kind, pool));
 
+  /* If the source tree is an unmodified image of its repository URL,
+     there is no data to transmit: have the repository copy that URL
+     to the destination directly.  The whole operation is then one
+     svn_fs_copy on the backend -- one round trip no matter how large
+     the tree -- which is what makes cheap tags and branches. */
+  {
+    svn_wc_entry_t *entry;
+    svn_error_t *err;
+
+    err = svn_wc_entry (&entry, src_path, pool);
+    if (err)
+      svn_error_clear_all (err);
+    else if (entry && entry->url && SVN_IS_VALID_REVNUM (entry->revision))
+      {
+        svn_boolean_t unmodified;
+
+        SVN_ERR (wc_tree_is_unmodified (&unmodified, src_path, entry,
+                                        entry->revision, pool));
+        if (unmodified)
+          {
+            svn_client_revision_t src_revision;
+
+            src_revision.kind = svn_client_revision_number;
+            src_revision.value.number = entry->revision;
+
+            return repos_to_repos_copy (commit_info, entry->url,
+                                        &src_revision, dst_url, auth_baton,
+                                        message, FALSE, pool);
+          }
+      }
+  }
+
   /* Split the SRC_PATH into a parent and basename. */
   svn_path_split (src_path, &parent, &basename, pool);
   if (svn_path_is_empty (parent))
@@ -584,9 +710,6 @@ wc_to_repos_copy (svn_client_commit_info_t **commit_info,
 
   commit_in_progress = FALSE;
 
-  /* Sleep for one second to ensure timestamp integrity. */
-  apr_sleep (APR_USEC_PER_SEC * 1);
-
  cleanup:
   /* Abort the commit if it is still in progress. */
   if (commit_in_progress)
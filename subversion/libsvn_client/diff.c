@@ -89,9 +89,17 @@ diff_file_changed (const char *path,
   apr_file_printf (outfile, 
      "===================================================================\n");
 
-  SVN_ERR (svn_io_run_diff (".", args, nargs, path, 
-                            tmpfile1, tmpfile2, 
-                            &exitcode, outfile, errfile, subpool));
+  /* With no options to pass along, use the built-in diff engine ---
+     forking an external program per changed file is most of the cost
+     of a large diff.  Any user-supplied options mean the output is
+     the external program's business, so hand over to it. */
+  if (nargs == 0)
+    SVN_ERR (svn_io_diff_files (tmpfile1, tmpfile2,
+                                label, NULL, outfile, subpool));
+  else
+    SVN_ERR (svn_io_run_diff (".", args, nargs, path, 
+                              tmpfile1, tmpfile2, 
+                              &exitcode, outfile, errfile, subpool));
 
   /* ### todo: Handle exit code == 2 (i.e. errors with diff) here */
   
@@ -506,6 +514,7 @@ do_merge (const svn_delta_editor_t *after_editor,
   svn_revnum_t start_revnum, end_revnum;
   svn_stringbuf_t *URL1, *URL2;
   void *ra_baton, *session, *session2;
+  void *session3 = NULL;
   svn_ra_plugin_t *ra_lib;
   const svn_ra_reporter_t *reporter;
   void *report_baton;
@@ -547,12 +556,19 @@ do_merge (const svn_delta_editor_t *after_editor,
   SVN_ERR (svn_client__open_ra_session (&session2, ra_lib, URL1, NULL,
                                         NULL, FALSE, FALSE, TRUE,
                                         auth_baton, pool));
-  
+
+  /* A third session lets the editor's prefetch thread request file
+     contents while the other two sessions are busy. */
+  if (svn_client__diff_prefetch_enabled ())
+    SVN_ERR (svn_client__open_ra_session (&session3, ra_lib, URL1, NULL,
+                                          NULL, FALSE, FALSE, TRUE,
+                                          auth_baton, pool));
+
   SVN_ERR (svn_client__get_diff_editor (target_wcpath,
                                         callbacks,
                                         callback_baton,
                                         recurse,
-                                        ra_lib, session2,
+                                        ra_lib, session2, session3,
                                         start_revnum,
                                         &new_diff_editor,
                                         &new_diff_edit_baton,
@@ -563,6 +579,8 @@ do_merge (const svn_delta_editor_t *after_editor,
       svn_delta_compose_editors (&composed_editor, &composed_edit_baton,
                                  new_diff_editor, new_diff_edit_baton,
                                  after_editor, after_edit_baton, pool);
+      svn_delta_fuse_editor (&composed_editor, &composed_edit_baton,
+                             composed_editor, composed_edit_baton, pool);
     }
   else
     {
@@ -585,9 +603,12 @@ do_merge (const svn_delta_editor_t *after_editor,
   SVN_ERR (reporter->set_path (report_baton, "", start_revnum));
   
   SVN_ERR (reporter->finish_report (report_baton));
-  
+
   SVN_ERR (ra_lib->close (session2));
 
+  if (session3)
+    SVN_ERR (ra_lib->close (session3));
+
   SVN_ERR (ra_lib->close (session));
 
   return SVN_NO_ERROR;
@@ -857,6 +878,7 @@ do_diff (const apr_array_header_t *options,
          reused. This applies to ra_dav, ra_local does not appears to have
          this limitation. */
       void *session2;
+      void *session3 = NULL;
 
       /* ### TODO: Forcing the base_dir to null. It might be possible to
          use a special ra session that cooperates with the editor to enable
@@ -865,12 +887,19 @@ do_diff (const apr_array_header_t *options,
                                             NULL, FALSE, FALSE, TRUE,
                                             auth_baton, pool));
 
+      /* A third session lets the editor's prefetch thread request file
+         contents while the other two sessions are busy. */
+      if (svn_client__diff_prefetch_enabled ())
+        SVN_ERR (svn_client__open_ra_session (&session3, ra_lib, URL, NULL,
+                                              NULL, FALSE, FALSE, TRUE,
+                                              auth_baton, pool));
+
       /* Get the true diff editor. */
       SVN_ERR (svn_client__get_diff_editor (target,
                                             callbacks,
                                             callback_baton,
                                             recurse,
-                                            ra_lib, session2,
+                                            ra_lib, session2, session3,
                                             start_revnum,
                                             &new_diff_editor,
                                             &new_diff_edit_baton,
@@ -892,6 +921,9 @@ do_diff (const apr_array_header_t *options,
       SVN_ERR (reporter->finish_report (report_baton));
 
       SVN_ERR (ra_lib->close (session2));
+
+      if (session3)
+        SVN_ERR (ra_lib->close (session3));
     }
 
   SVN_ERR (ra_lib->close (session));
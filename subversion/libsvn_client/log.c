@@ -51,6 +51,7 @@ svn_client_log (svn_client_auth_baton_t *auth_baton,
                 const svn_client_revision_t *start,
                 const svn_client_revision_t *end,
                 svn_boolean_t discover_changed_paths,
+                int limit,
                 svn_log_message_receiver_t receiver,
                 void *receiver_baton,
                 apr_pool_t *pool)
@@ -161,6 +162,7 @@ svn_client_log (svn_client_auth_baton_t *auth_baton,
                             start_revnum,
                             end_revnum,
                             discover_changed_paths,
+                            limit,
                             receiver,
                             receiver_baton));
 
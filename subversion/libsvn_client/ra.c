@@ -134,7 +134,51 @@ set_wc_prop (void *baton,
 }
 
 
-svn_error_t * 
+/* The process-wide tally of RA traffic; see svn_client_get_ra_stats.
+   Sessions are folded in by a pool cleanup as they are torn down. */
+static svn_ra_stats_t ra_stats_total = { 0 };
+
+/* What harvest_ra_stats needs to query a session. */
+struct ra_stats_baton
+{
+  const svn_ra_plugin_t *ra_lib;
+  void *session_baton;
+};
+
+/* An APR pool cleanup: fold one session's transfer statistics into
+   the process-wide total.  Registered right after ra_lib->open(), so
+   it runs before the cleanups the session registered for itself. */
+static apr_status_t
+harvest_ra_stats (void *baton)
+{
+  struct ra_stats_baton *rsb = baton;
+  svn_ra_stats_t stats;
+  svn_error_t *err = rsb->ra_lib->get_stats (rsb->session_baton, &stats);
+
+  if (err)
+    {
+      /* a session that can't report its numbers just doesn't count. */
+      svn_error_clear_all (err);
+      return APR_SUCCESS;
+    }
+
+  ra_stats_total.requests += stats.requests;
+  ra_stats_total.bytes_sent += stats.bytes_sent;
+  ra_stats_total.bytes_received += stats.bytes_received;
+  ra_stats_total.network_time += stats.network_time;
+
+  return APR_SUCCESS;
+}
+
+
+void
+svn_client_get_ra_stats (svn_ra_stats_t *stats)
+{
+  *stats = ra_stats_total;
+}
+
+
+svn_error_t *
 svn_client__open_ra_session (void **session_baton,
                              const svn_ra_plugin_t *ra_lib,
                              svn_stringbuf_t *base_url,
@@ -162,6 +206,17 @@ svn_client__open_ra_session (void **session_baton,
 
   SVN_ERR (ra_lib->open (session_baton, base_url, cbtable, cb, pool));
 
+  /* Arrange to collect the session's transfer statistics when POOL
+     goes away. */
+  {
+    struct ra_stats_baton *rsb = apr_palloc (pool, sizeof (*rsb));
+
+    rsb->ra_lib = ra_lib;
+    rsb->session_baton = *session_baton;
+    apr_pool_cleanup_register (pool, rsb, harvest_ra_stats,
+                               apr_pool_cleanup_null);
+  }
+
   return SVN_NO_ERROR;
 }
                                         
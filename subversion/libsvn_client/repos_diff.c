@@ -33,8 +33,69 @@
 #include "svn_pools.h"
 #include "svn_path.h"
 
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
 #include "client.h"
 
+#if APR_HAS_THREADS
+/* A base-text fetch queued for the prefetch thread.  The main thread
+ * fills in PATH when the server reports the file; the prefetch thread
+ * fills in TMP_PATH and ERR and raises DONE when the fetch finishes.
+ */
+struct prefetch_item {
+  /* The path of the file within the repository. */
+  const char *path;
+
+  /* The temporary file holding the fetched text.  Allocated in the
+     prefetch thread's own pool. */
+  svn_stringbuf_t *tmp_path;
+
+  /* Set when the fetch has finished, successfully or not. */
+  svn_boolean_t done;
+
+  /* The fetch's error, if any.  Allocated in the prefetch thread's
+     own pool. */
+  svn_error_t *err;
+
+  /* The next queued fetch. */
+  struct prefetch_item *next;
+};
+
+/* The state shared between the editor and the prefetch thread.
+ */
+struct prefetch_baton {
+  /* The overall crawler editor baton. */
+  struct edit_baton *eb;
+
+  /* The RA session the prefetch thread fetches over.  Only the
+     prefetch thread may use it; see the "sequential requests" comment
+     where the caller opens its sessions. */
+  void *ra_session;
+
+  /* The queue of fetches not yet picked up by the thread, oldest
+     first.  Use with LOCK held. */
+  struct prefetch_item *first;
+  struct prefetch_item *last;
+
+  /* Set when no more fetches will be queued, telling the thread to
+     exit.  Use with LOCK held. */
+  svn_boolean_t closed;
+
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+
+  /* Queue allocations.  Use with LOCK held. */
+  apr_pool_t *pool;
+
+  /* The prefetch thread's own pool; pools aren't safe to share across
+     threads.  Destroyed after the thread is joined. */
+  apr_pool_t *fetch_pool;
+};
+#endif /* APR_HAS_THREADS */
+
 /* Overall crawler editor baton.
  */
 struct edit_baton {
@@ -67,6 +128,18 @@ struct edit_baton {
      cached here so that it can be reused, all empty files are the same. */
   svn_stringbuf_t *empty_file;
 
+  /* REV1 texts already fetched over RA, keyed by file path.  Every
+     fetch in an edit is against REVISION, so the path alone
+     identifies the text; a repeat request is served from the first
+     fetch's temporary file. */
+  apr_hash_t *text_cache;
+
+#if APR_HAS_THREADS
+  /* The thread fetching REV1 texts ahead of their deltas, or null if
+     prefetch is not enabled. */
+  struct prefetch_baton *prefetch;
+#endif /* APR_HAS_THREADS */
+
   apr_pool_t *pool;
 };
 
@@ -125,6 +198,12 @@ struct file_baton {
   /* A cache of any property changes (svn_prop_t) received for this file. */
   apr_array_header_t *propchanges;
 
+#if APR_HAS_THREADS
+  /* The queued fetch of the REV1 text, if it went to the prefetch
+     thread rather than through get_file_from_ra(). */
+  struct prefetch_item *prefetch;
+#endif /* APR_HAS_THREADS */
+
   /* The pool passed in by add_file or open_file.
      Also, the pool this file_baton is allocated in. */
   apr_pool_t *pool;
@@ -244,19 +323,32 @@ get_file_from_ra (struct file_baton *b)
   apr_status_t status;
   apr_file_t *file;
   svn_stream_t *fstream;
+  struct edit_baton *eb = b->edit_baton;
+  svn_stringbuf_t *cached;
+
+  /* Serve a repeat request from the first fetch's temporary file. */
+  cached = apr_hash_get (eb->text_cache, b->path, APR_HASH_KEY_STRING);
+  if (cached)
+    {
+      b->path_start_revision = cached;
+      return SVN_NO_ERROR;
+    }
 
   /* ### TODO: Need some apr temp file support */
   SVN_ERR (svn_io_open_unique_file (&file, &b->path_start_revision,
-                                    "tmp", "", FALSE, b->pool));
+                                    "tmp", "", FALSE, eb->pool));
 
-  /* Install a pool cleanup handler to delete the file */
-  SVN_ERR (temp_file_cleanup_register (b->path_start_revision, b->pool));
+  /* Install a pool cleanup handler to delete the file.  The file and
+     its cleanup live in the edit baton's pool, rather than the file
+     baton's, so the text stays around for reuse until the edit is
+     closed. */
+  SVN_ERR (temp_file_cleanup_register (b->path_start_revision, eb->pool));
 
-  fstream = svn_stream_from_aprfile (file, b->pool);
-  SVN_ERR (b->edit_baton->ra_lib->get_file (b->edit_baton->ra_session,
-                                            b->path,
-                                            b->edit_baton->revision,
-                                            fstream, NULL, NULL));
+  fstream = svn_stream_from_aprfile (file, eb->pool);
+  SVN_ERR (eb->ra_lib->get_file (eb->ra_session,
+                                 b->path,
+                                 eb->revision,
+                                 fstream, NULL, NULL));
 
   status = apr_file_close (file);
   if (status)
@@ -264,9 +356,239 @@ get_file_from_ra (struct file_baton *b)
                               "failed to close file '%s'",
                               b->path_start_revision->data);
 
+  apr_hash_set (eb->text_cache, apr_pstrdup (eb->pool, b->path),
+                APR_HASH_KEY_STRING, b->path_start_revision);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Try to serve the REV1 text of B's file straight from the working
+ * copy's text-base, setting *FROM_WC iff that was possible.  When the
+ * file sits in the working copy at the revision being diffed against,
+ * its text-base *is* the text an RA fetch would return (text-bases
+ * are stored in repository form, untranslated), so there is no need
+ * for a network request or a temporary copy.  No cleanup handler is
+ * installed; the text-base is not ours to delete.
+ */
+static svn_error_t *
+get_pristine_from_wc (svn_boolean_t *from_wc,
+                      struct file_baton *b)
+{
+  svn_stringbuf_t *path = svn_stringbuf_create (b->path, b->pool);
+  svn_wc_entry_t *entry;
+  svn_error_t *err;
+
+  *from_wc = FALSE;
+
+  /* If the path isn't in a working copy at all, just fall back on the
+     repository. */
+  err = svn_wc_entry (&entry, path, b->pool);
+  if (err)
+    {
+      svn_error_clear_all (err);
+      return SVN_NO_ERROR;
+    }
+
+  if (entry
+      && (entry->kind == svn_node_file)
+      && (entry->schedule == svn_wc_schedule_normal)
+      && (entry->revision == b->edit_baton->revision))
+    {
+      svn_stringbuf_t *pristine;
+      enum svn_node_kind kind;
+
+      SVN_ERR (svn_wc_get_pristine_copy_path (path, &pristine, b->pool));
+      if (! pristine)
+        return SVN_NO_ERROR;
+
+      SVN_ERR (svn_io_check_path (pristine->data, &kind, b->pool));
+      if (kind == svn_node_file)
+        {
+          b->path_start_revision = pristine;
+          *from_wc = TRUE;
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
+
+/* Process-wide switch for the base-text prefetch thread. */
+static svn_boolean_t diff_prefetch_enabled = FALSE;
+
+void
+svn_client_set_diff_prefetch (svn_boolean_t enabled)
+{
+  diff_prefetch_enabled = enabled;
+}
+
+svn_boolean_t
+svn_client__diff_prefetch_enabled (void)
+{
+#if APR_HAS_THREADS
+  return diff_prefetch_enabled;
+#else
+  return FALSE;
+#endif
+}
+
+
+#if APR_HAS_THREADS
+/* The prefetch thread.  Pull queued fetches off the baton one at a
+ * time and run each over the thread's own RA session, so the texts
+ * arrive while the main thread is still consuming the diff response.
+ */
+static void * APR_THREAD_FUNC
+prefetch_worker (apr_thread_t *thread, void *data)
+{
+  struct prefetch_baton *pb = data;
+
+  apr_thread_mutex_lock (pb->lock);
+  while (1)
+    {
+      struct prefetch_item *item;
+      apr_file_t *file = NULL;
+      svn_error_t *err;
+      apr_status_t status;
+
+      while ((pb->first == NULL) && (! pb->closed))
+        apr_thread_cond_wait (pb->cond, pb->lock);
+
+      if (pb->first == NULL)
+        break;
+
+      item = pb->first;
+      pb->first = item->next;
+      if (pb->first == NULL)
+        pb->last = NULL;
+      apr_thread_mutex_unlock (pb->lock);
+
+      /* Fetch the REV1 text into a temporary file, just as
+         get_file_from_ra() would.  Everything is allocated in the
+         thread's own pool; pools aren't safe to share across
+         threads. */
+      err = svn_io_open_unique_file (&file, &item->tmp_path,
+                                     "tmp", "", FALSE, pb->fetch_pool);
+      if (! err)
+        {
+          svn_stream_t *fstream
+            = svn_stream_from_aprfile (file, pb->fetch_pool);
+
+          err = pb->eb->ra_lib->get_file (pb->ra_session,
+                                          item->path,
+                                          pb->eb->revision,
+                                          fstream, NULL, NULL);
+        }
+      if (! err)
+        {
+          status = apr_file_close (file);
+          if (status)
+            err = svn_error_createf (status, 0, NULL, pb->fetch_pool,
+                                     "failed to close file '%s'",
+                                     item->tmp_path->data);
+        }
+
+      apr_thread_mutex_lock (pb->lock);
+      item->err = err;
+      item->done = TRUE;
+      apr_thread_cond_broadcast (pb->cond);
+    }
+  apr_thread_mutex_unlock (pb->lock);
+
+  apr_thread_exit (thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Queue a fetch of the REV1 text of B's file on the prefetch thread.
+ * Called as soon as the server reports the path, so the fetch can
+ * overlap the arrival of the file's delta.
+ */
+static svn_error_t *
+prefetch_file_from_ra (struct prefetch_baton *pb,
+                       struct file_baton *b)
+{
+  struct prefetch_item *item;
+
+  apr_thread_mutex_lock (pb->lock);
+  item = apr_pcalloc (pb->pool, sizeof (*item));
+  item->path = apr_pstrdup (pb->pool, b->path);
+  if (pb->last)
+    pb->last->next = item;
+  else
+    pb->first = item;
+  pb->last = item;
+  apr_thread_cond_broadcast (pb->cond);
+  apr_thread_mutex_unlock (pb->lock);
+
+  b->prefetch = item;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the queued fetch of B's REV1 text to finish, and adopt the
+ * resulting temporary file into B.  A pool cleanup handler is
+ * installed to delete the file, as in get_file_from_ra().
+ */
+static svn_error_t *
+prefetch_wait (struct prefetch_baton *pb,
+               struct file_baton *b)
+{
+  struct prefetch_item *item = b->prefetch;
+
+  apr_thread_mutex_lock (pb->lock);
+  while (! item->done)
+    apr_thread_cond_wait (pb->cond, pb->lock);
+  apr_thread_mutex_unlock (pb->lock);
+
+  /* The error lives in the thread's pool.  Returning it aborts the
+     edit, so close_edit() never destroys that pool; it is leaked
+     instead. */
+  if (item->err)
+    return item->err;
+
+  /* The fetched path also lives in the thread's pool; dup it so the
+     cleanup can be tied to the file baton's pool. */
+  b->path_start_revision = svn_stringbuf_dup (item->tmp_path, b->pool);
+  SVN_ERR (temp_file_cleanup_register (b->path_start_revision, b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Start the prefetch thread for EB, fetching over PREFETCH_SESSION.
+ * POOL is used for the queue and thread machinery.
+ */
+static svn_error_t *
+prefetch_start (struct edit_baton *eb,
+                void *prefetch_session,
+                apr_pool_t *pool)
+{
+  struct prefetch_baton *pb = apr_pcalloc (pool, sizeof (*pb));
+  apr_status_t status;
+
+  pb->eb = eb;
+  pb->ra_session = prefetch_session;
+  pb->pool = pool;
+  pb->fetch_pool = svn_pool_create (NULL);
+
+  status = apr_thread_mutex_create (&pb->lock, APR_THREAD_MUTEX_DEFAULT,
+                                    pool);
+  if (! status)
+    status = apr_thread_cond_create (&pb->cond, pool);
+  if (! status)
+    status = apr_thread_create (&pb->thread, NULL, prefetch_worker, pb,
+                                pool);
+  if (status)
+    return svn_error_create (status, 0, NULL, pool,
+                             "diff prefetch: can't create fetch thread");
+
+  eb->prefetch = pb;
+
+  return SVN_NO_ERROR;
+}
+#endif /* APR_HAS_THREADS */
+
+
 /* Create an empty file, the path to the file is returned in EMPTY_FILE
  */
 static svn_error_t *
@@ -374,7 +696,11 @@ delete_entry (const char *path,
                                                 FALSE,
                                                 pb->edit_baton,
                                                 pool);
-        SVN_ERR (get_file_from_ra (b));
+        svn_boolean_t from_wc;
+
+        SVN_ERR (get_pristine_from_wc (&from_wc, b));
+        if (! from_wc)
+          SVN_ERR (get_file_from_ra (b));
         SVN_ERR (get_empty_file(b->edit_baton, &b->path_end_revision));
         
         SVN_ERR (pb->edit_baton->diff_callbacks->file_deleted 
@@ -476,11 +802,25 @@ open_file (const char *path,
 {
   struct dir_baton *pb = parent_baton;
   struct file_baton *b;
+  svn_boolean_t from_wc;
 
   b = make_file_baton (path, FALSE, pb->edit_baton, pool);
   *file_baton = b;
 
-  SVN_ERR (get_file_from_ra (b));
+  /* A text-base at the right revision spares both the fetch and the
+     temporary file. */
+  SVN_ERR (get_pristine_from_wc (&from_wc, b));
+  if (from_wc)
+    return SVN_NO_ERROR;
+
+#if APR_HAS_THREADS
+  /* Queue the fetch so it runs while the rest of the diff response is
+     arriving; apply_textdelta will wait for it. */
+  if (pb->edit_baton->prefetch)
+    SVN_ERR (prefetch_file_from_ra (pb->edit_baton->prefetch, b));
+  else
+#endif /* APR_HAS_THREADS */
+    SVN_ERR (get_file_from_ra (b));
 
   return SVN_NO_ERROR;
 }
@@ -526,6 +866,12 @@ apply_textdelta (void *file_baton,
   struct file_baton *b = file_baton;
   apr_status_t status;
 
+#if APR_HAS_THREADS
+  /* If the REV1 text went to the prefetch thread, collect it now. */
+  if (b->prefetch)
+    SVN_ERR (prefetch_wait (b->edit_baton->prefetch, b));
+#endif /* APR_HAS_THREADS */
+
   /* Open the file to be used as the base for second revision */
   status = apr_file_open (&b->file_start_revision, b->path_start_revision->data,
                           APR_READ, APR_OS_DEFAULT, b->pool);
@@ -659,6 +1005,21 @@ close_edit (void *edit_baton)
 {
   struct edit_baton *eb = edit_baton;
 
+#if APR_HAS_THREADS
+  if (eb->prefetch)
+    {
+      struct prefetch_baton *pb = eb->prefetch;
+      apr_status_t status;
+
+      apr_thread_mutex_lock (pb->lock);
+      pb->closed = TRUE;
+      apr_thread_cond_broadcast (pb->cond);
+      apr_thread_mutex_unlock (pb->lock);
+      apr_thread_join (&status, pb->thread);
+      svn_pool_destroy (pb->fetch_pool);
+    }
+#endif /* APR_HAS_THREADS */
+
   svn_pool_destroy (eb->pool);
 
   return SVN_NO_ERROR;
@@ -673,6 +1034,7 @@ svn_client__get_diff_editor (svn_stringbuf_t *target,
                              svn_boolean_t recurse,
                              svn_ra_plugin_t *ra_lib,
                              void *ra_session,
+                             void *prefetch_session,
                              svn_revnum_t revision,
                              const svn_delta_editor_t **editor,
                              void **edit_baton,
@@ -690,8 +1052,15 @@ svn_client__get_diff_editor (svn_stringbuf_t *target,
   eb->ra_session = ra_session;
   eb->revision = revision;
   eb->empty_file = NULL;
+  eb->text_cache = apr_hash_make (subpool);
   eb->pool = subpool;
 
+#if APR_HAS_THREADS
+  eb->prefetch = NULL;
+  if (prefetch_session)
+    SVN_ERR (prefetch_start (eb, prefetch_session, subpool));
+#endif /* APR_HAS_THREADS */
+
   tree_editor->set_target_revision = set_target_revision;
   tree_editor->open_root = open_root;
   tree_editor->delete_entry = delete_entry;
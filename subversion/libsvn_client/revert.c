@@ -45,9 +45,6 @@ svn_client_revert (svn_stringbuf_t *path,
                                     notify_func, notify_baton,
                                     pool);
 
-  /* Sleep for one second to ensure timestamp integrity. */
-  apr_sleep (APR_USEC_PER_SEC * 1);
-
   return err;
 }
 
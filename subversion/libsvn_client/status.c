@@ -45,24 +45,26 @@
 /* Open an RA session to URL, providing PATH/AUTH_BATON for
    authentication callbacks.
 
-   STATUSHASH has presumably been filled with status structures that
-   contain only local-mod information.  Ask RA->do_status() to drive a
-   custom editor that will add update information to this collection
-   of structures.  Also, use the RA session to fill in the "youngest
-   revnum" field in each structure.
+   Fill STATUSHASH with local-mod status structures for PATH while
+   describing the working copy's revisions to RA->do_status()'s
+   reporter in the same crawl; when the report is finished, the
+   server drives a custom editor that adds update information to the
+   same collection of structures.  Also, use the RA session to fill
+   in the "youngest revnum" field in each structure.
 
    Set *YOUNGEST to the youngest revision in the repository.
 
    If DESCEND is zero, only immediate children of PATH will be edited
    or added to the hash.  Else, the dry-run update will be fully
-   recursive. */
+   recursive.  GET_ALL is as for svn_wc_statuses. */
 static svn_error_t *
-add_update_info_to_status_hash (apr_hash_t *statushash,
-                                svn_revnum_t *youngest,
-                                svn_stringbuf_t *path,
-                                svn_client_auth_baton_t *auth_baton,
-                                svn_boolean_t descend,
-                                apr_pool_t *pool)
+fill_status_hash_with_update_info (apr_hash_t *statushash,
+                                   svn_revnum_t *youngest,
+                                   svn_stringbuf_t *path,
+                                   svn_client_auth_baton_t *auth_baton,
+                                   svn_boolean_t descend,
+                                   svn_boolean_t get_all,
+                                   apr_pool_t *pool)
 {
   svn_ra_plugin_t *ra_lib;  
   void *ra_baton, *session, *report_baton;
@@ -115,13 +117,18 @@ add_update_info_to_status_hash (apr_hash_t *statushash,
                               wrap_editor, wrap_edit_baton));
 
   /* Drive the reporter structure, describing the revisions within
-     PATH.  When we call reporter->finish_report, the
-     status_editor will be driven by svn_repos_dir_delta. */
-  SVN_ERR (svn_wc_crawl_revisions (path, reporter, report_baton, 
-                                   FALSE, /* don't restore missing files */
-                                   descend,
-                                   NULL, NULL, /* notification is N/A */
-                                   pool));
+     PATH, and fill the hash with local-mod statuses in the same
+     crawl.  When the report is finished, the status_editor will be
+     driven by svn_repos_dir_delta.
+
+     We're not strict here: the editor may add as-yet-unknown paths
+     to the hash, and properly deals with files that are in the
+     repository but missing from the wc. */
+  SVN_ERR (svn_wc_crawl_statuses (statushash, path,
+                                  reporter, report_baton,
+                                  descend, get_all,
+                                  FALSE, /* not strict */
+                                  pool));
 
   /* We're done with the RA session. */
   SVN_ERR (ra_lib->close (session));
@@ -147,35 +154,32 @@ svn_client_status (apr_hash_t **statushash,
                    apr_pool_t *pool)
 {
   apr_hash_t *hash = apr_hash_make (pool);
-  svn_boolean_t strict;
 
-  /* If we're not updating, we might be getting new paths from the
-     repository, and we don't want svn_wc_statuses to error on these
-     paths. However, if we're not updating and we see a path that
-     doesn't exist in the wc, we should throw an error */
   if (update)
-    strict = FALSE;
+    {
+      /* Crawl the working copy once, filling the hash with local-mod
+         status structures while describing the tree to the
+         repository; the resulting "dry-run" update adds repos_status
+         information to the same structures.  */
+      SVN_ERR (fill_status_hash_with_update_info (hash, youngest, path,
+                                                  auth_baton, descend,
+                                                  get_all, pool));
+    }
   else
-    strict = TRUE;
-
-  /* Ask the wc to give us a list of svn_wc_status_t structures.
-     These structures contain nothing but information found in the
-     working copy.
-
-     Pass the GET_ALL and DESCEND flags;  this working copy function
-     understands these flags too, and will return the correct set of
-     structures.  */
-  SVN_ERR (svn_wc_statuses (hash, path, descend, get_all, strict, pool));
-
-
-  /* If the caller wants us to contact the repository also... */
-  if (update)    
-    /* Add "dry-run" update information to our existing structures.
-       (Pass the DESCEND flag here, since we may want to ignore update
-       info that is below PATH.)  */
-    SVN_ERR (add_update_info_to_status_hash (hash, youngest, path,
-                                             auth_baton, descend, pool));
-
+    {
+      /* Ask the wc to give us a list of svn_wc_status_t structures.
+         These structures contain nothing but information found in the
+         working copy.
+
+         Pass the GET_ALL and DESCEND flags;  this working copy
+         function understands these flags too, and will return the
+         correct set of structures.
+
+         Since we're not contacting the repository, a path that
+         doesn't exist in the wc is an error; be strict. */
+      SVN_ERR (svn_wc_statuses (hash, path, descend, get_all,
+                                TRUE, pool));
+    }
 
   *statushash = hash;
 
@@ -251,9 +251,6 @@ svn_client_switch (const svn_delta_editor_t *before_editor,
         (*notify_func) (notify_baton, svn_wc_notify_update, path->data);
 
     }  
-  
-  /* Sleep for one second to ensure timestamp integrity. */
-  apr_sleep (APR_USEC_PER_SEC * 1);
 
   if (err)
     return err;
@@ -135,6 +135,7 @@ svn_client_update (const svn_delta_editor_t *before_editor,
     {
       void *ra_baton, *session;
       svn_ra_plugin_t *ra_lib;
+      svn_error_t *unlock_err;
 
       /* Get the RA vtable that matches URL. */
       SVN_ERR (svn_ra_init_ra_libs (&ra_baton, pool));
@@ -159,18 +160,23 @@ svn_client_update (const svn_delta_editor_t *before_editor,
                                   recurse,
                                   wrapped_old_editor, wrapped_old_edit_baton));
 
+      /* Hold the whole tree's locks for the duration of the edit, so
+         the editor's per-directory lock traffic stays in-process. */
+      SVN_ERR (svn_wc_lock_tree (anchor, 0, pool));
+
       /* Drive the reporter structure, describing the revisions within
          PATH.  When we call reporter->finish_report, the
          update_editor will be driven by svn_repos_dir_delta. */
       err = svn_wc_crawl_revisions (path, reporter, report_baton,
                                     TRUE, recurse,
                                     notify_func, notify_baton, pool);
-      
-      /* Sleep for one second to ensure timestamp integrity. */
-      apr_sleep (APR_USEC_PER_SEC * 1);
+
+      unlock_err = svn_wc_unlock_tree (anchor, pool);
 
       if (err)
         return err;
+      else if (unlock_err)
+        return unlock_err;
 
       /* Close the RA session. */
       SVN_ERR (ra_lib->close (session));
@@ -181,6 +187,7 @@ svn_client_update (const svn_delta_editor_t *before_editor,
     {
       apr_status_t apr_err;
       apr_file_t *in = NULL;
+      svn_error_t *unlock_err;
 
       /* Open xml file. */
       apr_err = apr_file_open (&in, xml_src->data, (APR_READ | APR_CREATE),
@@ -189,6 +196,8 @@ svn_client_update (const svn_delta_editor_t *before_editor,
         return svn_error_createf (apr_err, 0, NULL, pool,
                                   "unable to open %s", xml_src->data);
 
+      SVN_ERR (svn_wc_lock_tree (anchor, 0, pool));
+
       /* Do an update by xml-parsing the stream.  An invalid revnum
          means that there will be a revision number in the <delta-pkg>
          tag.  Otherwise, a valid revnum will be stored in the wc,
@@ -200,11 +209,12 @@ svn_client_update (const svn_delta_editor_t *before_editor,
                                       revnum,
                                       pool);
 
-      /* Sleep for one second to ensure timestamp integrity. */
-      apr_sleep (APR_USEC_PER_SEC * 1);
+      unlock_err = svn_wc_unlock_tree (anchor, pool);
 
       if (err)
         return err;
+      else if (unlock_err)
+        return unlock_err;
 
       /* Close XML file. */
       apr_file_close (in);
@@ -0,0 +1,473 @@
+/*
+ * binary_output.c:  an editor that serializes drives as binary frames.
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+#include <string.h>
+
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "delta.h"
+
+/* The wire format is described in delta.h next to the opcode list.
+   This editor is the producing half; binary_parse.c consumes the
+   frames and re-drives an editor on the other end.
+
+   One restriction: the driver must close each file before touching
+   any other file or directory (i.e., no "postfix" text deltas).
+   Text delta frames are emitted as the windows arrive, so an
+   interleaved drive would interleave the frames too.  */
+
+
+struct edit_baton
+{
+  svn_stream_t *output;
+  svn_boolean_t header_done;
+  apr_pool_t *pool;
+};
+
+
+/* Directory and file batons just carry the edit baton around.  */
+struct item_baton
+{
+  struct edit_baton *eb;
+};
+
+
+/* Append REV to BUF, encoded so that SVN_INVALID_REVNUM is zero.  */
+static void
+append_revision (svn_stringbuf_t *buf, svn_revnum_t rev)
+{
+  char ibuf[128], *p;
+
+  p = svn_delta__encode_int (ibuf, (apr_off_t) (rev + 1));
+  svn_stringbuf_appendbytes (buf, ibuf, p - ibuf);
+}
+
+
+/* Append the LEN bytes at DATA to BUF, preceded by the length.  */
+static void
+append_string (svn_stringbuf_t *buf, const char *data, apr_size_t len)
+{
+  char ibuf[128], *p;
+
+  p = svn_delta__encode_int (ibuf, (apr_off_t) len);
+  svn_stringbuf_appendbytes (buf, ibuf, p - ibuf);
+  svn_stringbuf_appendbytes (buf, data, len);
+}
+
+
+/* Write out the magic header if it hasn't been written, then FRAME.  */
+static svn_error_t *
+write_frame (struct edit_baton *eb, const svn_stringbuf_t *frame)
+{
+  apr_size_t len;
+
+  if (! eb->header_done)
+    {
+      char header[5];
+
+      memcpy (header, SVN_DELTA__BIN_MAGIC, 4);
+      header[4] = (char) SVN_DELTA__BIN_VERSION;
+      len = sizeof (header);
+      SVN_ERR (svn_stream_write (eb->output, header, &len));
+      eb->header_done = TRUE;
+    }
+
+  len = frame->len;
+  return svn_stream_write (eb->output, frame->data, &len);
+}
+
+
+/* Start a frame for OPCODE in POOL.  */
+static svn_stringbuf_t *
+start_frame (enum svn_delta__bin_opcode opcode, apr_pool_t *pool)
+{
+  svn_stringbuf_t *frame = svn_stringbuf_create ("", pool);
+  char byte = (char) opcode;
+
+  svn_stringbuf_appendbytes (frame, &byte, 1);
+  return frame;
+}
+
+
+/* Write a frame consisting of OPCODE alone.  */
+static svn_error_t *
+write_simple_frame (struct edit_baton *eb, enum svn_delta__bin_opcode opcode)
+{
+  apr_pool_t *subpool = svn_pool_create (eb->pool);
+  svn_stringbuf_t *frame = start_frame (opcode, subpool);
+  svn_error_t *err;
+
+  err = write_frame (eb, frame);
+  svn_pool_destroy (subpool);
+  return err;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* The editor functions.  */
+
+static svn_error_t *
+set_target_revision (void *edit_baton, svn_revnum_t target_revision)
+{
+  struct edit_baton *eb = edit_baton;
+  apr_pool_t *subpool = svn_pool_create (eb->pool);
+  svn_stringbuf_t *frame = start_frame (svn_delta__bin_target_rev, subpool);
+  svn_error_t *err;
+
+  append_revision (frame, target_revision);
+  err = write_frame (eb, frame);
+  svn_pool_destroy (subpool);
+  return err;
+}
+
+
+static svn_error_t *
+open_root (void *edit_baton,
+           svn_revnum_t base_revision,
+           apr_pool_t *dir_pool,
+           void **root_baton)
+{
+  struct edit_baton *eb = edit_baton;
+  struct item_baton *db = apr_palloc (dir_pool, sizeof (*db));
+  svn_stringbuf_t *frame = start_frame (svn_delta__bin_open_root, dir_pool);
+
+  append_revision (frame, base_revision);
+  SVN_ERR (write_frame (eb, frame));
+
+  db->eb = eb;
+  *root_baton = db;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+delete_entry (const char *path,
+              svn_revnum_t revision,
+              void *parent_baton,
+              apr_pool_t *pool)
+{
+  struct item_baton *db = parent_baton;
+  svn_stringbuf_t *frame = start_frame (svn_delta__bin_delete_entry, pool);
+
+  append_string (frame, path, strlen (path));
+  append_revision (frame, revision);
+  return write_frame (db->eb, frame);
+}
+
+
+/* Common guts of add_directory and add_file.  */
+static svn_error_t *
+add_item (enum svn_delta__bin_opcode opcode,
+          const char *path,
+          void *parent_baton,
+          const char *copyfrom_path,
+          svn_revnum_t copyfrom_revision,
+          apr_pool_t *pool,
+          void **child_baton)
+{
+  struct item_baton *pb = parent_baton;
+  struct item_baton *cb = apr_palloc (pool, sizeof (*cb));
+  svn_stringbuf_t *frame = start_frame (opcode, pool);
+  char flag;
+
+  append_string (frame, path, strlen (path));
+  flag = (copyfrom_path != NULL);
+  svn_stringbuf_appendbytes (frame, &flag, 1);
+  if (copyfrom_path != NULL)
+    {
+      append_string (frame, copyfrom_path, strlen (copyfrom_path));
+      append_revision (frame, copyfrom_revision);
+    }
+  SVN_ERR (write_frame (pb->eb, frame));
+
+  cb->eb = pb->eb;
+  *child_baton = cb;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+add_directory (const char *path,
+               void *parent_baton,
+               const char *copyfrom_path,
+               svn_revnum_t copyfrom_revision,
+               apr_pool_t *dir_pool,
+               void **child_baton)
+{
+  return add_item (svn_delta__bin_add_dir, path, parent_baton,
+                   copyfrom_path, copyfrom_revision, dir_pool, child_baton);
+}
+
+
+/* Common guts of open_directory and open_file.  */
+static svn_error_t *
+open_item (enum svn_delta__bin_opcode opcode,
+           const char *path,
+           void *parent_baton,
+           svn_revnum_t base_revision,
+           apr_pool_t *pool,
+           void **child_baton)
+{
+  struct item_baton *pb = parent_baton;
+  struct item_baton *cb = apr_palloc (pool, sizeof (*cb));
+  svn_stringbuf_t *frame = start_frame (opcode, pool);
+
+  append_string (frame, path, strlen (path));
+  append_revision (frame, base_revision);
+  SVN_ERR (write_frame (pb->eb, frame));
+
+  cb->eb = pb->eb;
+  *child_baton = cb;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+open_directory (const char *path,
+                void *parent_baton,
+                svn_revnum_t base_revision,
+                apr_pool_t *dir_pool,
+                void **child_baton)
+{
+  return open_item (svn_delta__bin_open_dir, path, parent_baton,
+                    base_revision, dir_pool, child_baton);
+}
+
+
+/* Common guts of change_dir_prop and change_file_prop.  */
+static svn_error_t *
+change_prop (enum svn_delta__bin_opcode opcode,
+             void *baton,
+             const char *name,
+             const svn_string_t *value,
+             apr_pool_t *pool)
+{
+  struct item_baton *b = baton;
+  svn_stringbuf_t *frame = start_frame (opcode, pool);
+  char flag;
+
+  append_string (frame, name, strlen (name));
+  flag = (value != NULL);
+  svn_stringbuf_appendbytes (frame, &flag, 1);
+  if (value != NULL)
+    append_string (frame, value->data, value->len);
+  return write_frame (b->eb, frame);
+}
+
+
+static svn_error_t *
+change_dir_prop (void *dir_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  return change_prop (svn_delta__bin_change_dir_prop, dir_baton,
+                      name, value, pool);
+}
+
+
+static svn_error_t *
+close_directory (void *dir_baton)
+{
+  struct item_baton *db = dir_baton;
+
+  return write_simple_frame (db->eb, svn_delta__bin_close_dir);
+}
+
+
+static svn_error_t *
+add_file (const char *path,
+          void *parent_baton,
+          const char *copyfrom_path,
+          svn_revnum_t copyfrom_revision,
+          apr_pool_t *file_pool,
+          void **file_baton)
+{
+  return add_item (svn_delta__bin_add_file, path, parent_baton,
+                   copyfrom_path, copyfrom_revision, file_pool, file_baton);
+}
+
+
+static svn_error_t *
+open_file (const char *path,
+           void *parent_baton,
+           svn_revnum_t base_revision,
+           apr_pool_t *file_pool,
+           void **file_baton)
+{
+  return open_item (svn_delta__bin_open_file, path, parent_baton,
+                    base_revision, file_pool, file_baton);
+}
+
+
+/* ---------------------------------------------------------------- */
+/* Text deltas.  The svndiff encoder writes into this little stream,
+   which frames its output as length-prefixed chunks; closing the
+   stream (which the encoder does at the null window) emits the
+   zero-length terminator chunk.  */
+
+struct chunk_stream_baton
+{
+  struct edit_baton *eb;
+  apr_pool_t *pool;
+};
+
+
+static svn_error_t *
+chunk_write_handler (void *baton, const char *data, apr_size_t *len)
+{
+  struct chunk_stream_baton *csb = baton;
+  char ibuf[128], *p;
+  apr_size_t plen;
+
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  p = svn_delta__encode_int (ibuf, (apr_off_t) *len);
+  plen = p - ibuf;
+  SVN_ERR (svn_stream_write (csb->eb->output, ibuf, &plen));
+  return svn_stream_write (csb->eb->output, data, len);
+}
+
+
+static svn_error_t *
+chunk_close_handler (void *baton)
+{
+  struct chunk_stream_baton *csb = baton;
+  char zero = 0;
+  apr_size_t len = 1;
+
+  return svn_stream_write (csb->eb->output, &zero, &len);
+}
+
+
+static svn_error_t *
+apply_textdelta (void *file_baton,
+                 svn_txdelta_window_handler_t *handler,
+                 void **handler_baton)
+{
+  struct item_baton *fb = file_baton;
+  apr_pool_t *pool = svn_pool_create (fb->eb->pool);
+  struct chunk_stream_baton *csb = apr_palloc (pool, sizeof (*csb));
+  svn_stream_t *chunk_stream;
+
+  SVN_ERR (write_simple_frame (fb->eb, svn_delta__bin_textdelta));
+
+  csb->eb = fb->eb;
+  csb->pool = pool;
+  chunk_stream = svn_stream_create (csb, pool);
+  svn_stream_set_write (chunk_stream, chunk_write_handler);
+  svn_stream_set_close (chunk_stream, chunk_close_handler);
+
+  svn_txdelta_to_svndiff (chunk_stream, pool, handler, handler_baton);
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+change_file_prop (void *file_baton,
+                  const char *name,
+                  const svn_string_t *value,
+                  apr_pool_t *pool)
+{
+  return change_prop (svn_delta__bin_change_file_prop, file_baton,
+                      name, value, pool);
+}
+
+
+static svn_error_t *
+close_file (void *file_baton)
+{
+  struct item_baton *fb = file_baton;
+
+  return write_simple_frame (fb->eb, svn_delta__bin_close_file);
+}
+
+
+static svn_error_t *
+close_edit (void *edit_baton)
+{
+  struct edit_baton *eb = edit_baton;
+  svn_error_t *err;
+
+  err = write_simple_frame (eb, svn_delta__bin_close_edit);
+  if (err == SVN_NO_ERROR)
+    err = svn_stream_close (eb->output);
+  svn_pool_destroy (eb->pool);
+  return err;
+}
+
+
+static svn_error_t *
+abort_edit (void *edit_baton)
+{
+  struct edit_baton *eb = edit_baton;
+  svn_error_t *err;
+
+  err = write_simple_frame (eb, svn_delta__bin_abort_edit);
+  svn_pool_destroy (eb->pool);
+  return err;
+}
+
+
+/* ---------------------------------------------------------------- */
+
+svn_error_t *
+svn_delta_get_binary_editor (svn_stream_t *output,
+                             const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create (pool);
+  struct edit_baton *eb = apr_palloc (subpool, sizeof (*eb));
+  svn_delta_editor_t *binary_editor = svn_delta_default_editor (pool);
+
+  eb->output = output;
+  eb->header_done = FALSE;
+  eb->pool = subpool;
+
+  binary_editor->set_target_revision = set_target_revision;
+  binary_editor->open_root = open_root;
+  binary_editor->delete_entry = delete_entry;
+  binary_editor->add_directory = add_directory;
+  binary_editor->open_directory = open_directory;
+  binary_editor->change_dir_prop = change_dir_prop;
+  binary_editor->close_directory = close_directory;
+  binary_editor->add_file = add_file;
+  binary_editor->open_file = open_file;
+  binary_editor->apply_textdelta = apply_textdelta;
+  binary_editor->change_file_prop = change_file_prop;
+  binary_editor->close_file = close_file;
+  binary_editor->close_edit = close_edit;
+  binary_editor->abort_edit = abort_edit;
+
+  *editor = binary_editor;
+  *edit_baton = eb;
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
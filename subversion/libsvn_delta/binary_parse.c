@@ -0,0 +1,371 @@
+/*
+ * binary_parse.c:  parse binary editor frames and drive an editor.
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+#include <string.h>
+
+#include <apr_tables.h>
+
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "delta.h"
+
+/* This is the consuming half of the binary editor pipe; the format
+   is described in delta.h, and binary_output.c produces it.  Like
+   svn_delta_xml_auto_parse, this retains control and pulls data from
+   its source stream until the edit is complete or an error occurs.  */
+
+
+/* How much we read from the source stream at a time.  */
+#define PARSE_BUFFER_SIZE SVN_STREAM_CHUNK_SIZE
+
+
+/* A buffered reader over the source stream.  */
+struct parse_ctx
+{
+  svn_stream_t *source;
+  char *buf;                    /* PARSE_BUFFER_SIZE bytes */
+  apr_size_t len;               /* valid bytes in BUF */
+  apr_size_t pos;               /* read position in BUF */
+  svn_boolean_t hit_eof;        /* the source has run dry */
+  apr_pool_t *pool;
+};
+
+
+/* Make sure at least one byte is buffered in CTX.  */
+static svn_error_t *
+parse_fill (struct parse_ctx *ctx)
+{
+  if (ctx->pos == ctx->len && ! ctx->hit_eof)
+    {
+      apr_size_t len = PARSE_BUFFER_SIZE;
+
+      SVN_ERR (svn_stream_read (ctx->source, ctx->buf, &len));
+      ctx->pos = 0;
+      ctx->len = len;
+      if (len == 0)
+        ctx->hit_eof = TRUE;
+    }
+  return SVN_NO_ERROR;
+}
+
+
+/* Read one byte into *C; error out if the stream ends first.  */
+static svn_error_t *
+parse_byte (struct parse_ctx *ctx, unsigned char *c)
+{
+  SVN_ERR (parse_fill (ctx));
+  if (ctx->pos == ctx->len)
+    return svn_error_create (SVN_ERR_UNEXPECTED_EOF, 0, NULL, ctx->pool,
+                             "binary delta stream ended mid-frame");
+  *c = (unsigned char) ctx->buf[ctx->pos++];
+  return SVN_NO_ERROR;
+}
+
+
+/* Read an svndiff-encoded integer into *VAL.  */
+static svn_error_t *
+parse_int (struct parse_ctx *ctx, apr_off_t *val)
+{
+  unsigned char c;
+
+  *val = 0;
+  for (;;)
+    {
+      SVN_ERR (parse_byte (ctx, &c));
+      *val = (*val << 7) | (c & 0x7f);
+      if ((c & 0x80) == 0)
+        return SVN_NO_ERROR;
+    }
+}
+
+
+/* Read a revision (encoded as REV + 1) into *REV.  */
+static svn_error_t *
+parse_revision (struct parse_ctx *ctx, svn_revnum_t *rev)
+{
+  apr_off_t val;
+
+  SVN_ERR (parse_int (ctx, &val));
+  *rev = (svn_revnum_t) val - 1;
+  return SVN_NO_ERROR;
+}
+
+
+/* Read a length-prefixed string into *STR, allocated in POOL.  */
+static svn_error_t *
+parse_string (struct parse_ctx *ctx, svn_stringbuf_t **str, apr_pool_t *pool)
+{
+  apr_off_t len;
+  svn_stringbuf_t *s;
+
+  SVN_ERR (parse_int (ctx, &len));
+  if (len < 0)
+    return svn_error_create (SVN_ERR_MALFORMED_FILE, 0, NULL, ctx->pool,
+                             "binary delta stream has negative string length");
+
+  s = svn_stringbuf_create ("", pool);
+  svn_stringbuf_ensure (s, (apr_size_t) len + 1);
+  while (len > 0)
+    {
+      apr_size_t chunk;
+
+      SVN_ERR (parse_fill (ctx));
+      if (ctx->pos == ctx->len)
+        return svn_error_create (SVN_ERR_UNEXPECTED_EOF, 0, NULL, ctx->pool,
+                                 "binary delta stream ended mid-string");
+      chunk = ctx->len - ctx->pos;
+      if ((apr_off_t) chunk > len)
+        chunk = (apr_size_t) len;
+      svn_stringbuf_appendbytes (s, ctx->buf + ctx->pos, chunk);
+      ctx->pos += chunk;
+      len -= chunk;
+    }
+
+  *str = s;
+  return SVN_NO_ERROR;
+}
+
+
+/* Read a text delta: a sequence of length-prefixed svndiff chunks,
+   terminated by a zero-length chunk.  The chunks are pushed at the
+   window handler obtained from EDITOR for FILE_BATON; if the editor
+   declines the delta (NULL handler), the chunks are discarded.  */
+static svn_error_t *
+parse_textdelta (struct parse_ctx *ctx,
+                 const svn_delta_edit_fns_t *editor,
+                 void *file_baton,
+                 apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *svndiff_stream = NULL;
+  apr_pool_t *subpool = svn_pool_create (pool);
+  apr_off_t chunk_len;
+
+  SVN_ERR (editor->apply_textdelta (file_baton, &handler, &handler_baton));
+  if (handler != NULL)
+    svndiff_stream = svn_txdelta_parse_svndiff (handler, handler_baton,
+                                                TRUE, subpool);
+
+  for (;;)
+    {
+      SVN_ERR (parse_int (ctx, &chunk_len));
+      if (chunk_len == 0)
+        break;
+
+      while (chunk_len > 0)
+        {
+          apr_size_t piece;
+
+          SVN_ERR (parse_fill (ctx));
+          if (ctx->pos == ctx->len)
+            return svn_error_create (SVN_ERR_UNEXPECTED_EOF, 0, NULL,
+                                     ctx->pool,
+                                     "binary delta stream ended mid-chunk");
+          piece = ctx->len - ctx->pos;
+          if ((apr_off_t) piece > chunk_len)
+            piece = (apr_size_t) chunk_len;
+          if (svndiff_stream != NULL)
+            SVN_ERR (svn_stream_write (svndiff_stream,
+                                       ctx->buf + ctx->pos, &piece));
+          ctx->pos += piece;
+          chunk_len -= piece;
+        }
+    }
+
+  if (svndiff_stream != NULL)
+    SVN_ERR (svn_stream_close (svndiff_stream));
+
+  svn_pool_destroy (subpool);
+  return SVN_NO_ERROR;
+}
+
+
+/* Set *PARENT to the innermost open directory baton.  */
+static svn_error_t *
+stack_top (apr_array_header_t *dir_stack, void **parent, apr_pool_t *pool)
+{
+  if (dir_stack->nelts == 0)
+    return svn_error_create (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+                             "binary delta stream has no open directory");
+  *parent = APR_ARRAY_IDX (dir_stack, dir_stack->nelts - 1, void *);
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_delta_binary_auto_parse (svn_stream_t *source,
+                             const svn_delta_edit_fns_t *editor,
+                             void *edit_baton,
+                             apr_pool_t *pool)
+{
+  struct parse_ctx ctx;
+  apr_pool_t *subpool = svn_pool_create (pool);
+  apr_pool_t *iterpool = svn_pool_create (subpool);
+  apr_array_header_t *dir_stack
+    = apr_array_make (subpool, 16, sizeof (void *));
+  void *file_baton = NULL;
+  char magic[5];
+  apr_size_t i;
+  unsigned char opcode;
+  svn_boolean_t done = FALSE;
+
+  ctx.source = source;
+  ctx.buf = apr_palloc (subpool, PARSE_BUFFER_SIZE);
+  ctx.len = 0;
+  ctx.pos = 0;
+  ctx.hit_eof = FALSE;
+  ctx.pool = subpool;
+
+  /* Check the magic header.  */
+  for (i = 0; i < sizeof (magic); ++i)
+    SVN_ERR (parse_byte (&ctx, (unsigned char *) &magic[i]));
+  if (memcmp (magic, SVN_DELTA__BIN_MAGIC, 4) != 0
+      || magic[4] != SVN_DELTA__BIN_VERSION)
+    return svn_error_create (SVN_ERR_MALFORMED_FILE, 0, NULL, subpool,
+                             "binary delta stream has invalid header");
+
+  while (! done)
+    {
+      svn_stringbuf_t *name, *value, *copy_path;
+      svn_revnum_t rev;
+      unsigned char flag;
+      void *parent, *child;
+
+      svn_pool_clear (iterpool);
+      SVN_ERR (parse_byte (&ctx, &opcode));
+
+      switch (opcode)
+        {
+        case svn_delta__bin_target_rev:
+          SVN_ERR (parse_revision (&ctx, &rev));
+          SVN_ERR (editor->set_target_revision (edit_baton, rev));
+          break;
+
+        case svn_delta__bin_open_root:
+          SVN_ERR (parse_revision (&ctx, &rev));
+          SVN_ERR (editor->open_root (edit_baton, rev, &child));
+          *((void **) apr_array_push (dir_stack)) = child;
+          break;
+
+        case svn_delta__bin_delete_entry:
+          SVN_ERR (parse_string (&ctx, &name, iterpool));
+          SVN_ERR (parse_revision (&ctx, &rev));
+          SVN_ERR (stack_top (dir_stack, &parent, subpool));
+          SVN_ERR (editor->delete_entry (name, rev, parent));
+          break;
+
+        case svn_delta__bin_add_dir:
+        case svn_delta__bin_add_file:
+          SVN_ERR (parse_string (&ctx, &name, iterpool));
+          SVN_ERR (parse_byte (&ctx, &flag));
+          copy_path = NULL;
+          rev = SVN_INVALID_REVNUM;
+          if (flag)
+            {
+              SVN_ERR (parse_string (&ctx, &copy_path, iterpool));
+              SVN_ERR (parse_revision (&ctx, &rev));
+            }
+          SVN_ERR (stack_top (dir_stack, &parent, subpool));
+          if (opcode == svn_delta__bin_add_dir)
+            {
+              SVN_ERR (editor->add_directory (name, parent, copy_path,
+                                              rev, &child));
+              *((void **) apr_array_push (dir_stack)) = child;
+            }
+          else
+            SVN_ERR (editor->add_file (name, parent, copy_path,
+                                       rev, &file_baton));
+          break;
+
+        case svn_delta__bin_open_dir:
+          SVN_ERR (parse_string (&ctx, &name, iterpool));
+          SVN_ERR (parse_revision (&ctx, &rev));
+          SVN_ERR (stack_top (dir_stack, &parent, subpool));
+          SVN_ERR (editor->open_directory (name, parent, rev, &child));
+          *((void **) apr_array_push (dir_stack)) = child;
+          break;
+
+        case svn_delta__bin_open_file:
+          SVN_ERR (parse_string (&ctx, &name, iterpool));
+          SVN_ERR (parse_revision (&ctx, &rev));
+          SVN_ERR (stack_top (dir_stack, &parent, subpool));
+          SVN_ERR (editor->open_file (name, parent, rev, &file_baton));
+          break;
+
+        case svn_delta__bin_change_dir_prop:
+        case svn_delta__bin_change_file_prop:
+          SVN_ERR (parse_string (&ctx, &name, iterpool));
+          SVN_ERR (parse_byte (&ctx, &flag));
+          value = NULL;
+          if (flag)
+            SVN_ERR (parse_string (&ctx, &value, iterpool));
+          if (opcode == svn_delta__bin_change_dir_prop)
+            {
+              SVN_ERR (stack_top (dir_stack, &parent, subpool));
+              SVN_ERR (editor->change_dir_prop (parent, name, value));
+            }
+          else
+            SVN_ERR (editor->change_file_prop (file_baton, name, value));
+          break;
+
+        case svn_delta__bin_close_dir:
+          SVN_ERR (stack_top (dir_stack, &parent, subpool));
+          apr_array_pop (dir_stack);
+          SVN_ERR (editor->close_directory (parent));
+          break;
+
+        case svn_delta__bin_textdelta:
+          SVN_ERR (parse_textdelta (&ctx, editor, file_baton, subpool));
+          break;
+
+        case svn_delta__bin_close_file:
+          SVN_ERR (editor->close_file (file_baton));
+          file_baton = NULL;
+          break;
+
+        case svn_delta__bin_close_edit:
+          SVN_ERR (editor->close_edit (edit_baton));
+          done = TRUE;
+          break;
+
+        case svn_delta__bin_abort_edit:
+          SVN_ERR (editor->abort_edit (edit_baton));
+          done = TRUE;
+          break;
+
+        default:
+          return svn_error_create (SVN_ERR_MALFORMED_FILE, 0, NULL, subpool,
+                                   "binary delta stream has unknown opcode");
+        }
+    }
+
+  svn_pool_destroy (subpool);
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -0,0 +1,236 @@
+/*
+ * compose_delta.c:  combine delta windows without fulltext expansion.
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+
+#include <apr_general.h>        /* for APR_INLINE */
+
+#include "svn_delta.h"
+#include "svn_pools.h"
+#include "delta.h"
+
+/* ==================================================================== */
+/* Delta window composition.
+
+   Given window A, which builds an intermediate text from a source
+   view, and window B, which builds a target text from that
+   intermediate text, produce a single window that builds the target
+   text directly from A's source view.  Nobody ever materializes the
+   intermediate text; B's source-copy instructions are translated,
+   range by range, into the instructions A used to produce those
+   ranges.
+
+   The translation needs to map an offset in A's target view to the
+   instruction that generated it.  A's instructions generate target
+   data consecutively, so an array of their starting offsets, searched
+   by binary search, does the job.
+
+   A target-copy in A refers to data earlier in A's own target view,
+   so when B's range lands on one of those we simply recurse on the
+   referenced (strictly earlier) range.  Pathological chains of
+   self-referencing copies can blow the translated window up, but
+   windows produced by the generators in this library keep such
+   chains shallow.  */
+
+
+/* The starting offsets, in A's target view, of each of A's ops.
+   OFFS has NUM_OPS + 1 entries; the last one is A's tview_len, so
+   OFFS[i + 1] - OFFS[i] is always the length of op i.  */
+typedef struct offset_index_t
+{
+  int num_ops;
+  apr_size_t *offs;
+} offset_index_t;
+
+
+/* Create an index into the target view offsets of WINDOW's ops,
+   allocated from POOL.  */
+static offset_index_t *
+create_offset_index (const svn_txdelta_window_t *window, apr_pool_t *pool)
+{
+  offset_index_t *ndx = apr_palloc (pool, sizeof (*ndx));
+  apr_size_t offset = 0;
+  int i;
+
+  ndx->num_ops = window->num_ops;
+  ndx->offs = apr_palloc (pool, (ndx->num_ops + 1) * sizeof (*ndx->offs));
+
+  for (i = 0; i < ndx->num_ops; ++i)
+    {
+      ndx->offs[i] = offset;
+      offset += window->ops[i].length;
+    }
+  ndx->offs[ndx->num_ops] = offset;
+
+  return ndx;
+}
+
+
+/* Find the index of the op that generated the byte at OFFSET in the
+   indexed window's target view.  */
+static int
+search_offset_index (const offset_index_t *ndx, apr_size_t offset)
+{
+  int lo = 0, hi = ndx->num_ops;
+
+  assert (offset < ndx->offs[ndx->num_ops]);
+
+  while (lo + 1 < hi)
+    {
+      const int mid = (lo + hi) / 2;
+      if (offset < ndx->offs[mid])
+        hi = mid;
+      else
+        lo = mid;
+    }
+
+  assert (ndx->offs[lo] <= offset && offset < ndx->offs[lo + 1]);
+  return lo;
+}
+
+
+/* Translate the range [OFFSET, OFFSET+LIMIT) of WINDOW_A's target
+   view into ops against WINDOW_A's own inputs, appending them to the
+   ops under construction in BUILD_BATON.  NDX indexes WINDOW_A's
+   ops.  Allocate from POOL.  */
+static void
+copy_source_ops (const svn_txdelta_window_t *window_a,
+                 const offset_index_t *ndx,
+                 apr_size_t offset,
+                 apr_size_t limit,
+                 struct build_ops_baton_t *build_baton,
+                 apr_pool_t *pool)
+{
+  int i = search_offset_index (ndx, offset);
+
+  while (limit > 0)
+    {
+      const svn_txdelta_op_t *op = &window_a->ops[i];
+      const apr_size_t skip = offset - ndx->offs[i];
+      apr_size_t len = op->length - skip;
+
+      if (len > limit)
+        len = limit;
+
+      switch (op->action_code)
+        {
+        case svn_txdelta_source:
+          svn_txdelta__insert_op (build_baton, svn_txdelta_source,
+                                  op->offset + skip, len, NULL, pool);
+          break;
+
+        case svn_txdelta_new:
+          svn_txdelta__insert_op (build_baton, svn_txdelta_new, 0, len,
+                                  window_a->new_data->data
+                                  + op->offset + skip,
+                                  pool);
+          break;
+
+        case svn_txdelta_target:
+          /* A target-copy refers to an earlier range of A's target
+             view; recurse on that range.  An overlapping copy
+             generates its back-reference distance's worth of pattern
+             over and over, so peel it off in pattern-sized chunks,
+             each of which lies strictly before OFFSET and therefore
+             terminates the recursion.  */
+          {
+            const apr_size_t from = op->offset + skip;
+            const apr_size_t pattern = offset - from;
+            apr_size_t remaining = len;
+
+            while (remaining > 0)
+              {
+                apr_size_t chunk = (remaining > pattern
+                                    ? pattern : remaining);
+                copy_source_ops (window_a, ndx, from, chunk,
+                                 build_baton, pool);
+                remaining -= chunk;
+              }
+          }
+          break;
+        }
+
+      offset += len;
+      limit -= len;
+      ++i;
+    }
+}
+
+
+svn_txdelta_window_t *
+svn_txdelta_compose_windows (const svn_txdelta_window_t *window_a,
+                             const svn_txdelta_window_t *window_b,
+                             apr_pool_t *pool)
+{
+  svn_txdelta_window_t *composite;
+  svn_string_t *new_data;
+  offset_index_t *ndx = create_offset_index (window_a, pool);
+  struct build_ops_baton_t bob = { 0 };
+  const svn_txdelta_op_t *op;
+
+  bob.new_data = svn_stringbuf_create ("", pool);
+
+  for (op = window_b->ops; op < window_b->ops + window_b->num_ops; ++op)
+    {
+      switch (op->action_code)
+        {
+        case svn_txdelta_source:
+          /* Copies from the intermediate text are translated into
+             whatever window A did to produce that text.  */
+          copy_source_ops (window_a, ndx, op->offset, op->length,
+                           &bob, pool);
+          break;
+
+        case svn_txdelta_target:
+          /* Copies within B's target view carry over unchanged; the
+             composite's target view is B's.  */
+          svn_txdelta__insert_op (&bob, svn_txdelta_target,
+                                  op->offset, op->length, NULL, pool);
+          break;
+
+        case svn_txdelta_new:
+          svn_txdelta__insert_op (&bob, svn_txdelta_new, 0, op->length,
+                                  window_b->new_data->data + op->offset,
+                                  pool);
+          break;
+        }
+    }
+
+  composite = apr_palloc (pool, sizeof (*composite));
+  composite->sview_offset = window_a->sview_offset;
+  composite->sview_len = window_a->sview_len;
+  composite->tview_len = window_b->tview_len;
+  composite->num_ops = bob.num_ops;
+  composite->ops = bob.ops;
+
+  new_data = apr_palloc (pool, sizeof (*new_data));
+  new_data->data = bob.new_data->data;
+  new_data->len = bob.new_data->len;
+  composite->new_data = new_data;
+
+  return composite;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
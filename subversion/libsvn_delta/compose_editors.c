@@ -400,6 +400,453 @@ change_dir_prop (void *dir_baton,
 }
 
 
+/* A composition tree forwards every call through a wrapper pair per
+   layer, and real drives stack several layers (trace + wrappers +
+   the real editor).  The fused form flattens the tree into its leaf
+   editors once, at drive start: each call is then a single loop over
+   the leaves, and leaves whose implementation of a call is the
+   do-nothing default from svn_delta_default_editor() are skipped
+   outright. */
+
+struct fused_edit_baton
+{
+  /* The leaf editors, in composition order, with their batons. */
+  int count;
+  const svn_delta_editor_t **editors;
+  void **edit_batons;
+
+  /* Bit (1 << i) is set when leaf i implements the corresponding
+     editor function, i.e. when it is neither null nor the default. */
+  apr_uint32_t set_target_revision_mask;
+  apr_uint32_t open_root_mask;
+  apr_uint32_t delete_entry_mask;
+  apr_uint32_t add_directory_mask;
+  apr_uint32_t open_directory_mask;
+  apr_uint32_t change_dir_prop_mask;
+  apr_uint32_t close_directory_mask;
+  apr_uint32_t add_file_mask;
+  apr_uint32_t open_file_mask;
+  apr_uint32_t apply_textdelta_mask;
+  apr_uint32_t change_file_prop_mask;
+  apr_uint32_t close_file_mask;
+  apr_uint32_t close_edit_mask;
+  apr_uint32_t abort_edit_mask;
+};
+
+
+struct fused_dir_baton
+{
+  struct fused_edit_baton *edit_baton;
+  void **dir_batons;            /* one per leaf */
+};
+
+
+struct fused_file_baton
+{
+  struct fused_edit_baton *edit_baton;
+  void **file_batons;           /* one per leaf */
+  apr_pool_t *file_pool;
+};
+
+
+static svn_error_t *
+fused_set_target_revision (void *edit_baton, svn_revnum_t target_revision)
+{
+  struct fused_edit_baton *eb = edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->set_target_revision_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->set_target_revision))
+               (eb->edit_batons[i], target_revision));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_open_root (void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *dir_pool,
+                 void **root_baton)
+{
+  struct fused_edit_baton *eb = edit_baton;
+  struct fused_dir_baton *d = apr_pcalloc (dir_pool, sizeof (*d));
+  int i;
+
+  d->edit_baton = eb;
+  d->dir_batons = apr_pcalloc (dir_pool, eb->count * sizeof (void *));
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->open_root_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->open_root)) (eb->edit_batons[i],
+                                                base_revision,
+                                                dir_pool,
+                                                &(d->dir_batons[i])));
+
+  *root_baton = d;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_delete_entry (const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  struct fused_dir_baton *d = parent_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->delete_entry_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->delete_entry)) (path,
+                                                   revision,
+                                                   d->dir_batons[i],
+                                                   pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_add_directory (const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *dir_pool,
+                     void **child_baton)
+{
+  struct fused_dir_baton *d = parent_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  struct fused_dir_baton *child = apr_pcalloc (dir_pool, sizeof (*child));
+  int i;
+
+  child->edit_baton = eb;
+  child->dir_batons = apr_pcalloc (dir_pool, eb->count * sizeof (void *));
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->add_directory_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->add_directory))
+               (path, d->dir_batons[i], copyfrom_path, copyfrom_revision,
+                dir_pool, &(child->dir_batons[i])));
+
+  *child_baton = child;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_open_directory (const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *dir_pool,
+                      void **child_baton)
+{
+  struct fused_dir_baton *d = parent_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  struct fused_dir_baton *child = apr_pcalloc (dir_pool, sizeof (*child));
+  int i;
+
+  child->edit_baton = eb;
+  child->dir_batons = apr_pcalloc (dir_pool, eb->count * sizeof (void *));
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->open_directory_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->open_directory))
+               (path, d->dir_batons[i], base_revision, dir_pool,
+                &(child->dir_batons[i])));
+
+  *child_baton = child;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_change_dir_prop (void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  struct fused_dir_baton *d = dir_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->change_dir_prop_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->change_dir_prop)) (d->dir_batons[i],
+                                                      name,
+                                                      value,
+                                                      pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_close_directory (void *dir_baton)
+{
+  struct fused_dir_baton *d = dir_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->close_directory_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->close_directory)) (d->dir_batons[i]));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_add_file (const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *file_pool,
+                void **file_baton)
+{
+  struct fused_dir_baton *d = parent_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  struct fused_file_baton *fb = apr_pcalloc (file_pool, sizeof (*fb));
+  int i;
+
+  fb->edit_baton = eb;
+  fb->file_batons = apr_pcalloc (file_pool, eb->count * sizeof (void *));
+  fb->file_pool = file_pool;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->add_file_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->add_file))
+               (path, d->dir_batons[i], copyfrom_path, copyfrom_revision,
+                file_pool, &(fb->file_batons[i])));
+
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_open_file (const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *file_pool,
+                 void **file_baton)
+{
+  struct fused_dir_baton *d = parent_baton;
+  struct fused_edit_baton *eb = d->edit_baton;
+  struct fused_file_baton *fb = apr_pcalloc (file_pool, sizeof (*fb));
+  int i;
+
+  fb->edit_baton = eb;
+  fb->file_batons = apr_pcalloc (file_pool, eb->count * sizeof (void *));
+  fb->file_pool = file_pool;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->open_file_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->open_file))
+               (path, d->dir_batons[i], base_revision, file_pool,
+                &(fb->file_batons[i])));
+
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The window handlers the leaves actually handed back, packed
+   together so each window makes one pass over them. */
+struct fused_handler_set
+{
+  int count;
+  svn_txdelta_window_handler_t *handlers;
+  void **handler_batons;
+};
+
+
+static svn_error_t *
+fused_window_handler (svn_txdelta_window_t *window, void *baton)
+{
+  struct fused_handler_set *hs = baton;
+  int i;
+
+  for (i = 0; i < hs->count; i++)
+    SVN_ERR ((* (hs->handlers[i])) (window, hs->handler_batons[i]));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_apply_textdelta (void *file_baton,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  struct fused_file_baton *fb = file_baton;
+  struct fused_edit_baton *eb = fb->edit_baton;
+  struct fused_handler_set *hs = apr_pcalloc (fb->file_pool, sizeof (*hs));
+  int i;
+
+  hs->handlers = apr_pcalloc (fb->file_pool,
+                              eb->count * sizeof (*(hs->handlers)));
+  hs->handler_batons = apr_pcalloc (fb->file_pool,
+                                    eb->count * sizeof (void *));
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->apply_textdelta_mask & (1 << i))
+      {
+        svn_txdelta_window_handler_t h;
+        void *hb;
+
+        SVN_ERR ((* (eb->editors[i]->apply_textdelta))
+                 (fb->file_batons[i], &h, &hb));
+
+        /* A leaf may decline the text by handing back a null
+           handler; only the live ones get windows. */
+        if (h)
+          {
+            hs->handlers[hs->count] = h;
+            hs->handler_batons[hs->count] = hb;
+            hs->count++;
+          }
+      }
+
+  if (hs->count > 0)
+    {
+      *handler = fused_window_handler;
+      *handler_baton = hs;
+    }
+  else
+    {
+      *handler = NULL;
+      *handler_baton = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_change_file_prop (void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  struct fused_file_baton *fb = file_baton;
+  struct fused_edit_baton *eb = fb->edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->change_file_prop_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->change_file_prop)) (fb->file_batons[i],
+                                                       name,
+                                                       value,
+                                                       pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_close_file (void *file_baton)
+{
+  struct fused_file_baton *fb = file_baton;
+  struct fused_edit_baton *eb = fb->edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->close_file_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->close_file)) (fb->file_batons[i]));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_close_edit (void *edit_baton)
+{
+  struct fused_edit_baton *eb = edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->close_edit_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->close_edit)) (eb->edit_batons[i]));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+fused_abort_edit (void *edit_baton)
+{
+  struct fused_edit_baton *eb = edit_baton;
+  int i;
+
+  for (i = 0; i < eb->count; i++)
+    if (eb->abort_edit_mask & (1 << i))
+      SVN_ERR ((* (eb->editors[i]->abort_edit)) (eb->edit_batons[i]));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Is EDITOR one of ours, i.e. a composed pair whose baton is a
+   struct edit_baton? */
+static int
+is_composed_editor (const svn_delta_editor_t *editor)
+{
+  return (editor->open_root == open_root
+          && editor->close_edit == close_edit);
+}
+
+
+/* Return the number of leaf editors in the composition tree rooted
+   at EDITOR, EDIT_BATON. */
+static int
+count_leaves (const svn_delta_editor_t *editor, void *edit_baton)
+{
+  if (is_composed_editor (editor))
+    {
+      struct edit_baton *eb = edit_baton;
+
+      return (count_leaves (eb->editor_1, eb->edit_baton_1)
+              + count_leaves (eb->editor_2, eb->edit_baton_2));
+    }
+
+  return 1;
+}
+
+
+/* Record the leaves of the composition tree rooted at EDITOR,
+   EDIT_BATON into FUSED_EB, in composition order, starting at index
+   *NEXT (which is advanced past them). */
+static void
+collect_leaves (struct fused_edit_baton *fused_eb,
+                int *next,
+                const svn_delta_editor_t *editor,
+                void *edit_baton)
+{
+  if (is_composed_editor (editor))
+    {
+      struct edit_baton *eb = edit_baton;
+
+      collect_leaves (fused_eb, next, eb->editor_1, eb->edit_baton_1);
+      collect_leaves (fused_eb, next, eb->editor_2, eb->edit_baton_2);
+    }
+  else
+    {
+      fused_eb->editors[*next] = editor;
+      fused_eb->edit_batons[*next] = edit_baton;
+      (*next)++;
+    }
+}
+
+
 
 /*** Public interfaces. ***/
 
@@ -443,6 +890,88 @@ svn_delta_compose_editors (const svn_delta_editor_t **new_editor,
 }
 
 
+void
+svn_delta_fuse_editor (const svn_delta_editor_t **new_editor,
+                       void **new_edit_baton,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_pool_t *pool)
+{
+  struct fused_edit_baton *eb;
+  const svn_delta_editor_t *dflt = svn_delta_default_editor (pool);
+  svn_delta_editor_t *fused;
+  int count, next, i;
+
+  count = count_leaves (editor, edit_baton);
+
+  /* If there is nothing to flatten, or the stack is too deep for the
+     masks (32 leaves -- far beyond any real drive), pass the editor
+     through untouched. */
+  if ((count == 1) || (count > 32))
+    {
+      *new_editor = editor;
+      *new_edit_baton = edit_baton;
+      return;
+    }
+
+  eb = apr_pcalloc (pool, sizeof (*eb));
+  eb->count = count;
+  eb->editors = apr_pcalloc (pool, count * sizeof (*(eb->editors)));
+  eb->edit_batons = apr_pcalloc (pool, count * sizeof (void *));
+
+  next = 0;
+  collect_leaves (eb, &next, editor, edit_baton);
+
+  /* Note which leaves implement which functions, so the dispatchers
+     can skip the do-nothing defaults.  A null function counts as
+     unimplemented too. */
+  for (i = 0; i < count; i++)
+    {
+      const svn_delta_editor_t *e = eb->editors[i];
+
+#define SVN_DELTA__FUSE_MASK(fn) \
+      if (e->fn && (e->fn != dflt->fn)) \
+        eb->fn##_mask |= (1 << i)
+
+      SVN_DELTA__FUSE_MASK (set_target_revision);
+      SVN_DELTA__FUSE_MASK (open_root);
+      SVN_DELTA__FUSE_MASK (delete_entry);
+      SVN_DELTA__FUSE_MASK (add_directory);
+      SVN_DELTA__FUSE_MASK (open_directory);
+      SVN_DELTA__FUSE_MASK (change_dir_prop);
+      SVN_DELTA__FUSE_MASK (close_directory);
+      SVN_DELTA__FUSE_MASK (add_file);
+      SVN_DELTA__FUSE_MASK (open_file);
+      SVN_DELTA__FUSE_MASK (apply_textdelta);
+      SVN_DELTA__FUSE_MASK (change_file_prop);
+      SVN_DELTA__FUSE_MASK (close_file);
+      SVN_DELTA__FUSE_MASK (close_edit);
+      SVN_DELTA__FUSE_MASK (abort_edit);
+
+#undef SVN_DELTA__FUSE_MASK
+    }
+
+  fused = svn_delta_default_editor (pool);
+  fused->set_target_revision = fused_set_target_revision;
+  fused->open_root = fused_open_root;
+  fused->delete_entry = fused_delete_entry;
+  fused->add_directory = fused_add_directory;
+  fused->open_directory = fused_open_directory;
+  fused->change_dir_prop = fused_change_dir_prop;
+  fused->close_directory = fused_close_directory;
+  fused->add_file = fused_add_file;
+  fused->open_file = fused_open_file;
+  fused->apply_textdelta = fused_apply_textdelta;
+  fused->change_file_prop = fused_change_file_prop;
+  fused->close_file = fused_close_file;
+  fused->close_edit = fused_close_edit;
+  fused->abort_edit = fused_abort_edit;
+
+  *new_editor = fused;
+  *new_edit_baton = eb;
+}
+
+
 void
 svn_delta_wrap_editor (const svn_delta_editor_t **new_editor,
                        void **new_edit_baton,
@@ -480,6 +1009,11 @@ svn_delta_wrap_editor (const svn_delta_editor_t **new_editor,
                                  after_editor, after_edit_baton,
                                  pool);
     }
+
+  /* Flatten the nest we just built, so the drive pays one dispatch
+     per call instead of a wrapper frame per layer. */
+  svn_delta_fuse_editor (new_editor, new_edit_baton,
+                         *new_editor, *new_edit_baton, pool);
 }
 
 
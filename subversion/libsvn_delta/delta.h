@@ -34,7 +34,21 @@ extern "C" {
 
 /* Private interface for text deltas. */
 
-struct build_ops_baton_t;
+/* Context/baton for building an operation sequence. */
+struct build_ops_baton_t {
+  int num_ops;                  /* current number of ops */
+  int ops_size;                 /* number of ops allocated */
+  svn_txdelta_op_t *ops;        /* the operations */
+
+  svn_stringbuf_t *new_data;    /* any new data used by the operations */
+
+  apr_pool_t *pool;             /* if non-null, the ops array grows here
+                                   instead of in the pool passed to
+                                   svn_txdelta__insert_op, so recycled op
+                                   storage survives the caller's window
+                                   pool (see
+                                   svn_txdelta_next_window_reuse) */
+};
 
 /* Insert a delta op into the delta window being built via BUILD_BATON. If
    OPCODE is svn_delta_new, bytes from NEW_DATA are copied into the window
@@ -47,8 +61,60 @@ void svn_txdelta__insert_op (struct build_ops_baton_t *build_baton,
                              const char *new_data,
                              apr_pool_t *pool);
 
-/* Create a vdelta window. Allocate temporary data from `pool'. */
+/* Make sure BUILD_BATON's op array has room for at least NUM_OPS ops
+   before any are inserted, so a window whose op count is known (or
+   well estimated) up front is built without any regrow copies.
+   Allocates from BUILD_BATON's pool if it has one, else from POOL. */
+void svn_txdelta__presize_ops (struct build_ops_baton_t *build_baton,
+                               int num_ops,
+                               apr_pool_t *pool);
+
+/* Encode VAL into the buffer P using the variable-length svndiff
+   integer format (see svndiff.c), returning a pointer past the last
+   byte written.  P must have room for at least ten bytes.  */
+char *svn_delta__encode_int (char *p, apr_off_t val);
+
+/* Decode an svndiff-format integer from the range [P..END-1] into
+   *VAL, returning a pointer past the last byte consumed, or NULL if
+   the range ran out before the integer was complete.  */
+const unsigned char *svn_delta__decode_int (apr_off_t *val,
+                                            const unsigned char *p,
+                                            const unsigned char *end);
+
+/* A reusable arena for the vdelta generator's hash tables.  A delta
+   stream produces one table per window; recycling the arrays between
+   windows saves one large allocation pair per window and keeps peak
+   pool memory flat over big files.  */
+typedef struct svn_txdelta__vdelta_arena_t svn_txdelta__vdelta_arena_t;
+
+/* Create a vdelta arena, allocating it (and, over time, its arrays)
+   from POOL.  */
+svn_txdelta__vdelta_arena_t *
+svn_txdelta__vdelta_arena_create (apr_pool_t *pool);
+
+/* Create a vdelta window. Allocate temporary data from `pool'.  If
+   ARENA is non-null, the hash table's arrays are taken from (and
+   returned to) the arena instead of being pool-allocated afresh. */
 void svn_txdelta__vdelta (struct build_ops_baton_t *build_baton,
+                          const char *start,
+                          apr_size_t source_len,
+                          apr_size_t target_len,
+                          svn_txdelta__vdelta_arena_t *arena,
+                          apr_pool_t *pool);
+
+/* Return the length of the longest common prefix of the MAX bytes at
+   A and the MAX bytes at B.  Compares a machine word at a time when
+   the pointers allow it, so long copy extensions run at memory speed
+   rather than byte-loop speed.  */
+apr_size_t svn_txdelta__match_length (const char *a,
+                                      const char *b,
+                                      apr_size_t max);
+
+/* Create a delta window using the rolling-hash match engine (see
+   rdelta.c).  Much faster than vdelta on large windows, at the cost
+   of missing target-internal matches.  Allocate temporary data from
+   `pool'. */
+void svn_txdelta__rdelta (struct build_ops_baton_t *build_baton,
                           const char *start,
                           apr_size_t source_len,
                           apr_size_t target_len,
@@ -56,6 +122,41 @@ void svn_txdelta__vdelta (struct build_ops_baton_t *build_baton,
 
 
 
+/* The binary editor pipe (binary_output.c / binary_parse.c).
+
+   This is a compact framing of an editor drive, for use where both
+   ends are Subversion code and the XML tree-delta format would just
+   burn CPU in escaping and parsing.  The stream starts with the
+   four bytes "SVNB" and a format byte, then carries one frame per
+   editor call: an opcode byte followed by its arguments.  Integers
+   use the svndiff variable-length encoding; strings are a length
+   followed by that many bytes; revisions are encoded as REV + 1 so
+   that SVN_INVALID_REVNUM becomes zero.  Text deltas are shipped as
+   raw svndiff data, cut into length-prefixed chunks and terminated
+   by a zero-length chunk.  */
+
+#define SVN_DELTA__BIN_MAGIC "SVNB"
+#define SVN_DELTA__BIN_VERSION 0
+
+enum svn_delta__bin_opcode
+{
+  svn_delta__bin_target_rev = 1, /* rev */
+  svn_delta__bin_open_root,      /* rev */
+  svn_delta__bin_delete_entry,   /* name, rev */
+  svn_delta__bin_add_dir,        /* name, flag, [copy_path, copy_rev] */
+  svn_delta__bin_open_dir,       /* name, rev */
+  svn_delta__bin_change_dir_prop,/* name, flag, [value] */
+  svn_delta__bin_close_dir,      /* (no args) */
+  svn_delta__bin_add_file,       /* name, flag, [copy_path, copy_rev] */
+  svn_delta__bin_open_file,      /* name, rev */
+  svn_delta__bin_textdelta,      /* svndiff chunks, 0-length terminated */
+  svn_delta__bin_change_file_prop, /* name, flag, [value] */
+  svn_delta__bin_close_file,     /* (no args) */
+  svn_delta__bin_close_edit,     /* (no args) */
+  svn_delta__bin_abort_edit      /* (no args) */
+};
+
+
 /* These are the in-memory tree-delta stackframes; they are used to
  * keep track of a delta's state while the XML stream is being parsed.
  * 
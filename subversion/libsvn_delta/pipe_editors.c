@@ -19,6 +19,8 @@
 
 #include <assert.h>
 #include <apr_pools.h>
+#include <apr_tables.h>
+#include "svn_pools.h"
 #include "svn_delta.h"
 
 
@@ -298,7 +300,520 @@ svn_delta_old_default_pipe_editor (svn_delta_edit_fns_t **new_editor,
 }
 
 
-/* 
+
+/*** A batching pipe editor. ***/
+
+/* The plain pipe editor above forwards every call immediately, one
+   virtual call per event.  The batching variant below queues events
+   and replays them to the wrapped editor in groups, so a consumer
+   with per-call setup costs sees dozens of events per wakeup instead
+   of one.
+
+   The catch is that several editor calls hand back batons which the
+   driver uses in later calls, so those calls can't simply be
+   deferred.  We give the driver a placeholder baton right away and
+   queue the event; when the queue is flushed, events are replayed in
+   order, and each replayed open/add fills in the real baton its
+   placeholder stands for.  Since a child is always opened after its
+   parent, replaying in order means every event finds its target's
+   real baton already resolved.
+
+   Text deltas are not queued: copying windows would cost more than
+   the batching saves.  apply_textdelta flushes the queue (resolving
+   the file's real baton) and hands the driver the wrapped editor's
+   own window handler, so windows stream straight through.  */
+
+
+/* What a queued event was. */
+enum batch_event_code
+{
+  batch_ev_target_revision,
+  batch_ev_open_root,
+  batch_ev_delete_entry,
+  batch_ev_add_directory,
+  batch_ev_open_directory,
+  batch_ev_change_dir_prop,
+  batch_ev_close_directory,
+  batch_ev_add_file,
+  batch_ev_open_file,
+  batch_ev_change_file_prop,
+  batch_ev_close_file
+};
+
+
+struct batch_edit_baton
+{
+  /* The editor we are wrapping. */
+  const svn_delta_edit_fns_t *real_editor;
+  void *real_edit_baton;
+
+  /* Flush the queue when it reaches this many events. */
+  int batch_size;
+
+  /* The queued events, in arrival order; an array of
+     struct batch_event *.  Lives in BATCH_POOL. */
+  apr_array_header_t *queue;
+
+  /* Pool for the editor and its batons. */
+  apr_pool_t *pool;
+
+  /* Subpool holding the queued events and their copied arguments;
+     cleared after each flush. */
+  apr_pool_t *batch_pool;
+};
+
+
+/* Directory and file batons are placeholders: REAL_*_BATON is null
+   until the event that creates it downstream has been replayed. */
+struct batch_dir_baton
+{
+  struct batch_edit_baton *eb;
+  void *real_dir_baton;
+};
+
+struct batch_file_baton
+{
+  struct batch_edit_baton *eb;
+  void *real_file_baton;
+};
+
+
+struct batch_event
+{
+  enum batch_event_code code;
+
+  /* Arguments, as used by the event; unused ones are null/invalid.
+     NAME and VALUE are copies made in BATCH_POOL, since the driver
+     only guarantees its stringbufs for the duration of the call.
+     VALUE doubles as the copyfrom path for add_directory/add_file
+     and as the property value for the prop changes.  */
+  svn_stringbuf_t *name;
+  svn_stringbuf_t *value;
+  svn_revnum_t rev;
+
+  /* The event's directory or file: the parent for adds/opens and
+     delete_entry, the target itself for the prop changes and
+     closes. */
+  struct batch_dir_baton *dir;
+  struct batch_file_baton *file;
+
+  /* For adds/opens, the placeholder whose real baton the replay
+     fills in. */
+  struct batch_dir_baton *new_dir;
+  struct batch_file_baton *new_file;
+};
+
+
+/* Replay all queued events against EB's wrapped editor, in order,
+   then empty the queue. */
+static svn_error_t *
+flush_batch (struct batch_edit_baton *eb)
+{
+  int i;
+
+  for (i = 0; i < eb->queue->nelts; i++)
+    {
+      struct batch_event *ev
+        = ((struct batch_event **) eb->queue->elts)[i];
+
+      switch (ev->code)
+        {
+        case batch_ev_target_revision:
+          SVN_ERR ((* (eb->real_editor->set_target_revision))
+                   (eb->real_edit_baton, ev->rev));
+          break;
+
+        case batch_ev_open_root:
+          SVN_ERR ((* (eb->real_editor->open_root))
+                   (eb->real_edit_baton, ev->rev,
+                    &(ev->new_dir->real_dir_baton)));
+          break;
+
+        case batch_ev_delete_entry:
+          SVN_ERR ((* (eb->real_editor->delete_entry))
+                   (ev->name, ev->rev, ev->dir->real_dir_baton));
+          break;
+
+        case batch_ev_add_directory:
+          SVN_ERR ((* (eb->real_editor->add_directory))
+                   (ev->name, ev->dir->real_dir_baton, ev->value, ev->rev,
+                    &(ev->new_dir->real_dir_baton)));
+          break;
+
+        case batch_ev_open_directory:
+          SVN_ERR ((* (eb->real_editor->open_directory))
+                   (ev->name, ev->dir->real_dir_baton, ev->rev,
+                    &(ev->new_dir->real_dir_baton)));
+          break;
+
+        case batch_ev_change_dir_prop:
+          SVN_ERR ((* (eb->real_editor->change_dir_prop))
+                   (ev->dir->real_dir_baton, ev->name, ev->value));
+          break;
+
+        case batch_ev_close_directory:
+          SVN_ERR ((* (eb->real_editor->close_directory))
+                   (ev->dir->real_dir_baton));
+          break;
+
+        case batch_ev_add_file:
+          SVN_ERR ((* (eb->real_editor->add_file))
+                   (ev->name, ev->dir->real_dir_baton, ev->value, ev->rev,
+                    &(ev->new_file->real_file_baton)));
+          break;
+
+        case batch_ev_open_file:
+          SVN_ERR ((* (eb->real_editor->open_file))
+                   (ev->name, ev->dir->real_dir_baton, ev->rev,
+                    &(ev->new_file->real_file_baton)));
+          break;
+
+        case batch_ev_change_file_prop:
+          SVN_ERR ((* (eb->real_editor->change_file_prop))
+                   (ev->file->real_file_baton, ev->name, ev->value));
+          break;
+
+        case batch_ev_close_file:
+          SVN_ERR ((* (eb->real_editor->close_file))
+                   (ev->file->real_file_baton));
+          break;
+        }
+    }
+
+  svn_pool_clear (eb->batch_pool);
+  eb->queue = apr_array_make (eb->batch_pool, eb->batch_size,
+                              sizeof (struct batch_event *));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Allocate a new event with code CODE in EB's batch pool, copying
+   NAME and VALUE (either may be null) into it, and queue it.  Flush
+   the queue if this filled it. */
+static svn_error_t *
+queue_event (struct batch_event **ev_p,
+             struct batch_edit_baton *eb,
+             enum batch_event_code code,
+             svn_stringbuf_t *name,
+             svn_stringbuf_t *value)
+{
+  struct batch_event *ev = apr_pcalloc (eb->batch_pool, sizeof (*ev));
+
+  ev->code = code;
+  if (name)
+    ev->name = svn_stringbuf_dup (name, eb->batch_pool);
+  if (value)
+    ev->value = svn_stringbuf_dup (value, eb->batch_pool);
+
+  (* (struct batch_event **) apr_array_push (eb->queue)) = ev;
+
+  *ev_p = ev;
+
+  if (eb->queue->nelts >= eb->batch_size)
+    SVN_ERR (flush_batch (eb));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_set_target_revision (void *edit_baton, svn_revnum_t target_revision)
+{
+  struct batch_edit_baton *eb = edit_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, eb, batch_ev_target_revision, NULL, NULL));
+  ev->rev = target_revision;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_open_root (void *edit_baton,
+                 svn_revnum_t base_revision,
+                 void **root_baton)
+{
+  struct batch_edit_baton *eb = edit_baton;
+  struct batch_dir_baton *d = apr_pcalloc (eb->pool, sizeof (*d));
+  struct batch_event *ev;
+
+  d->eb = eb;
+
+  SVN_ERR (queue_event (&ev, eb, batch_ev_open_root, NULL, NULL));
+  ev->rev = base_revision;
+  ev->new_dir = d;
+
+  *root_baton = d;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_delete_entry (svn_stringbuf_t *name,
+                    svn_revnum_t revision,
+                    void *parent_baton)
+{
+  struct batch_dir_baton *d = parent_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_delete_entry, name, NULL));
+  ev->rev = revision;
+  ev->dir = d;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_add_directory (svn_stringbuf_t *name,
+                     void *parent_baton,
+                     svn_stringbuf_t *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     void **child_baton)
+{
+  struct batch_dir_baton *d = parent_baton;
+  struct batch_dir_baton *child = apr_pcalloc (d->eb->pool,
+                                               sizeof (*child));
+  struct batch_event *ev;
+
+  child->eb = d->eb;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_add_directory,
+                        name, copyfrom_path));
+  ev->rev = copyfrom_revision;
+  ev->dir = d;
+  ev->new_dir = child;
+
+  *child_baton = child;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_open_directory (svn_stringbuf_t *name,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      void **child_baton)
+{
+  struct batch_dir_baton *d = parent_baton;
+  struct batch_dir_baton *child = apr_pcalloc (d->eb->pool,
+                                               sizeof (*child));
+  struct batch_event *ev;
+
+  child->eb = d->eb;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_open_directory, name, NULL));
+  ev->rev = base_revision;
+  ev->dir = d;
+  ev->new_dir = child;
+
+  *child_baton = child;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_change_dir_prop (void *dir_baton,
+                       svn_stringbuf_t *name,
+                       svn_stringbuf_t *value)
+{
+  struct batch_dir_baton *d = dir_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_change_dir_prop, name, value));
+  ev->dir = d;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_close_directory (void *dir_baton)
+{
+  struct batch_dir_baton *d = dir_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_close_directory, NULL, NULL));
+  ev->dir = d;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_add_file (svn_stringbuf_t *name,
+                void *parent_baton,
+                svn_stringbuf_t *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                void **file_baton)
+{
+  struct batch_dir_baton *d = parent_baton;
+  struct batch_file_baton *fb = apr_pcalloc (d->eb->pool, sizeof (*fb));
+  struct batch_event *ev;
+
+  fb->eb = d->eb;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_add_file,
+                        name, copyfrom_path));
+  ev->rev = copyfrom_revision;
+  ev->dir = d;
+  ev->new_file = fb;
+
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_open_file (svn_stringbuf_t *name,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 void **file_baton)
+{
+  struct batch_dir_baton *d = parent_baton;
+  struct batch_file_baton *fb = apr_pcalloc (d->eb->pool, sizeof (*fb));
+  struct batch_event *ev;
+
+  fb->eb = d->eb;
+
+  SVN_ERR (queue_event (&ev, d->eb, batch_ev_open_file, name, NULL));
+  ev->rev = base_revision;
+  ev->dir = d;
+  ev->new_file = fb;
+
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_apply_textdelta (void *file_baton,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  struct batch_file_baton *fb = file_baton;
+
+  /* Flush, so the file is open downstream and its real baton is
+     resolved; then let windows stream through untouched. */
+  SVN_ERR (flush_batch (fb->eb));
+
+  SVN_ERR ((* (fb->eb->real_editor->apply_textdelta))
+           (fb->real_file_baton, handler, handler_baton));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_change_file_prop (void *file_baton,
+                        svn_stringbuf_t *name,
+                        svn_stringbuf_t *value)
+{
+  struct batch_file_baton *fb = file_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, fb->eb, batch_ev_change_file_prop,
+                        name, value));
+  ev->file = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_close_file (void *file_baton)
+{
+  struct batch_file_baton *fb = file_baton;
+  struct batch_event *ev;
+
+  SVN_ERR (queue_event (&ev, fb->eb, batch_ev_close_file, NULL, NULL));
+  ev->file = fb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_close_edit (void *edit_baton)
+{
+  struct batch_edit_baton *eb = edit_baton;
+
+  SVN_ERR (flush_batch (eb));
+  SVN_ERR ((* (eb->real_editor->close_edit)) (eb->real_edit_baton));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+batch_abort_edit (void *edit_baton)
+{
+  struct batch_edit_baton *eb = edit_baton;
+
+  /* The wrapped editor never saw the queued events; don't replay
+     them into an edit that is being thrown away. */
+  svn_pool_clear (eb->batch_pool);
+  eb->queue = apr_array_make (eb->batch_pool, eb->batch_size,
+                              sizeof (struct batch_event *));
+
+  SVN_ERR ((* (eb->real_editor->abort_edit)) (eb->real_edit_baton));
+
+  return SVN_NO_ERROR;
+}
+
+
+void
+svn_delta_old_batching_pipe_editor (svn_delta_edit_fns_t **new_editor,
+                                    void **new_edit_baton,
+                                    const svn_delta_edit_fns_t *editor_to_wrap,
+                                    void *edit_baton_to_wrap,
+                                    int batch_size,
+                                    apr_pool_t *pool)
+{
+  struct batch_edit_baton *eb = apr_pcalloc (pool, sizeof (*eb));
+  svn_delta_edit_fns_t *editor = svn_delta_old_default_editor (pool);
+
+  if (batch_size < 1)
+    batch_size = 1;
+
+  /* Set up the editor. */
+  editor->set_target_revision = batch_set_target_revision;
+  editor->open_root = batch_open_root;
+  editor->delete_entry = batch_delete_entry;
+  editor->add_directory = batch_add_directory;
+  editor->open_directory = batch_open_directory;
+  editor->change_dir_prop = batch_change_dir_prop;
+  editor->close_directory = batch_close_directory;
+  editor->add_file = batch_add_file;
+  editor->open_file = batch_open_file;
+  editor->apply_textdelta = batch_apply_textdelta;
+  editor->change_file_prop = batch_change_file_prop;
+  editor->close_file = batch_close_file;
+  editor->close_edit = batch_close_edit;
+  editor->abort_edit = batch_abort_edit;
+
+  /* Set up the edit baton. */
+  eb->real_editor = editor_to_wrap;
+  eb->real_edit_baton = edit_baton_to_wrap;
+  eb->batch_size = batch_size;
+  eb->pool = pool;
+  eb->batch_pool = svn_pool_create (pool);
+  eb->queue = apr_array_make (eb->batch_pool, batch_size,
+                              sizeof (struct batch_event *));
+
+  *new_edit_baton = eb;
+  *new_editor = editor;
+}
+
+
+/*
  * local variables:
  * eval: (load-file "../../tools/dev/svn-dev.el")
  * end:
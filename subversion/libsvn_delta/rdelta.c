@@ -0,0 +1,282 @@
+/*
+ * rdelta.c:  rolling-hash delta generator.
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+#include <string.h>
+
+#include <apr_general.h>        /* for APR_INLINE */
+
+#include "svn_delta.h"
+#include "delta.h"
+
+/* ==================================================================== */
+/* Rolling-hash match engine.
+
+   The vdelta generator (vdelta.c) hashes every four-byte window of
+   both the source and target views and walks collision chains to find
+   matches.  That is thorough, but on large binary windows the chain
+   walking dominates the running time.  This engine trades a little
+   match quality for a lot of speed:
+
+     1. Slice the source view into fixed-size blocks and record an
+        adler32 checksum of each block in a flat, open-addressed
+        slot array.  One hash probe per block, no chains.
+
+     2. Slide an adler32 window of the same size over the target
+        view.  The checksum is "rolled" one byte at a time, so
+        advancing the window is O(1).
+
+     3. When the rolling checksum hits a recorded block, verify the
+        match bytewise, then extend it as far forward as the data
+        allows before emitting a source-copy op.
+
+   Only source matches are found; runs that exist solely within the
+   target come out as plain inserts.  For the large-file case this
+   engine is built for, that is a good bargain.  */
+
+
+/* Size of the blocks we checksum.  */
+#define MATCH_BLOCKSIZE 64
+
+
+/* Information for a source block: its adler32 checksum and the
+   offset of the block in the source view.  An empty slot has
+   POS_PLUS_1 == 0.  */
+typedef struct block_slot_t {
+  apr_uint32_t adlersum;
+  apr_size_t pos_plus_1;
+} block_slot_t;
+
+/* A flat, open-addressed table of block slots.  NUM_SLOTS is always a
+   power of two so we can mask instead of dividing.  */
+typedef struct block_table_t {
+  apr_size_t num_slots;
+  block_slot_t *slots;
+} block_table_t;
+
+
+/* ==================================================================== */
+/* Adler32 implementation.  This is the rolling variant: in addition
+   to initializing a sum over a block, a byte can be rotated out of
+   and into the running sum in constant time.  */
+
+#define ADLER_MOD_BASE 65521
+#define ADLER_MOD_BLOCK_SIZE 5552
+
+
+/* Feed LEN bytes from DATA into the running checksum AD.  */
+static APR_INLINE apr_uint32_t
+adler32_sum (apr_uint32_t ad, const char *data, apr_size_t len)
+{
+  apr_uint32_t s1 = ad & 0xFFFF;
+  apr_uint32_t s2 = ad >> 16;
+  apr_uint32_t count = 0;
+
+  while (len--)
+    {
+      s1 += *((const unsigned char *) data++);
+      s2 += s1;
+      if (++count == ADLER_MOD_BLOCK_SIZE)
+        {
+          s1 %= ADLER_MOD_BASE;
+          s2 %= ADLER_MOD_BASE;
+          count = 0;
+        }
+    }
+
+  return ((s2 % ADLER_MOD_BASE) << 16) | (s1 % ADLER_MOD_BASE);
+}
+
+
+/* Replace the byte C_OUT at the start of the window with the byte
+   C_IN at the end, assuming the window is MATCH_BLOCKSIZE bytes long. */
+static APR_INLINE apr_uint32_t
+adler32_rotate (apr_uint32_t ad, char c_out, char c_in)
+{
+  apr_uint32_t s1 = ad & 0xFFFF;
+  apr_uint32_t s2 = ad >> 16;
+  apr_uint32_t out = (unsigned char) c_out;
+  apr_uint32_t in = (unsigned char) c_in;
+
+  s1 = (s1 - out + in + ADLER_MOD_BASE) % ADLER_MOD_BASE;
+  s2 = (s2 - (MATCH_BLOCKSIZE * out) % ADLER_MOD_BASE + s1
+        + ADLER_MOD_BASE * MATCH_BLOCKSIZE) % ADLER_MOD_BASE;
+
+  return (s2 << 16) | s1;
+}
+
+
+/* ==================================================================== */
+/* Block table.  */
+
+/* Create a table big enough to hold one slot per MATCH_BLOCKSIZE
+   bytes of source data, with room to spare so probe sequences stay
+   short.  Allocate from POOL.  */
+static block_table_t *
+create_block_table (apr_size_t source_len, apr_pool_t *pool)
+{
+  block_table_t *table = apr_palloc (pool, sizeof (*table));
+  apr_size_t nblocks = source_len / MATCH_BLOCKSIZE + 1;
+  apr_size_t i;
+
+  /* Aim for a load factor of one half or less.  */
+  table->num_slots = 1;
+  while (table->num_slots < 2 * nblocks)
+    table->num_slots *= 2;
+
+  table->slots = apr_palloc (pool, table->num_slots * sizeof (*table->slots));
+  for (i = 0; i < table->num_slots; ++i)
+    table->slots[i].pos_plus_1 = 0;
+
+  return table;
+}
+
+
+/* Record the block at offset POS in the source view, whose checksum
+   is ADLERSUM, into TABLE.  On a slot collision the first-inserted
+   block wins; earlier blocks give longer forward extensions.  */
+static APR_INLINE void
+store_block (block_table_t *table, apr_uint32_t adlersum, apr_size_t pos)
+{
+  apr_size_t i = adlersum & (table->num_slots - 1);
+
+  while (table->slots[i].pos_plus_1 != 0)
+    {
+      if (table->slots[i].adlersum == adlersum)
+        return;
+      i = (i + 1) & (table->num_slots - 1);
+    }
+
+  table->slots[i].adlersum = adlersum;
+  table->slots[i].pos_plus_1 = pos + 1;
+}
+
+
+/* Find a source block whose checksum is ADLERSUM.  Return its offset
+   in the source view, or (apr_size_t) -1 if there is none.  */
+static APR_INLINE apr_size_t
+find_block (const block_table_t *table, apr_uint32_t adlersum)
+{
+  apr_size_t i = adlersum & (table->num_slots - 1);
+
+  while (table->slots[i].pos_plus_1 != 0)
+    {
+      if (table->slots[i].adlersum == adlersum)
+        return table->slots[i].pos_plus_1 - 1;
+      i = (i + 1) & (table->num_slots - 1);
+    }
+
+  return (apr_size_t) -1;
+}
+
+
+/* ==================================================================== */
+/* The delta generator itself.  */
+
+void
+svn_txdelta__rdelta (struct build_ops_baton_t *build_baton,
+                     const char *data,
+                     apr_size_t source_len,
+                     apr_size_t target_len,
+                     apr_pool_t *pool)
+{
+  const char *start = data + source_len;
+  const char *end = start + target_len;
+  const char *here = start;       /* Current position in the target. */
+  const char *insert_from = NULL; /* Start of byte range for insertion. */
+  block_table_t *table;
+  apr_uint32_t rolling;
+  apr_size_t pos;
+
+  /* Degenerate case: with too little source data to fill even one
+     block, the whole target view is an insert.  */
+  if (source_len < MATCH_BLOCKSIZE || target_len < MATCH_BLOCKSIZE)
+    {
+      if (target_len > 0)
+        svn_txdelta__insert_op (build_baton, svn_txdelta_new,
+                                0, target_len, start, pool);
+      return;
+    }
+
+  /* Checksum the source blocks.  */
+  table = create_block_table (source_len, pool);
+  for (pos = 0; pos + MATCH_BLOCKSIZE <= source_len; pos += MATCH_BLOCKSIZE)
+    store_block (table, adler32_sum (1, data + pos, MATCH_BLOCKSIZE), pos);
+
+  /* Slide the rolling checksum over the target view.  */
+  rolling = adler32_sum (1, here, MATCH_BLOCKSIZE);
+  while (end - here >= MATCH_BLOCKSIZE)
+    {
+      const char *match;
+      apr_size_t match_len;
+
+      pos = find_block (table, rolling);
+      if (pos != (apr_size_t) -1
+          && memcmp (data + pos, here, MATCH_BLOCKSIZE) == 0)
+        {
+          /* Genuine match; extend it forward as far as it will go.  */
+          apr_size_t max = start - (data + pos) - MATCH_BLOCKSIZE;
+
+          if (max > (apr_size_t) (end - here) - MATCH_BLOCKSIZE)
+            max = (end - here) - MATCH_BLOCKSIZE;
+          match = data + pos;
+          match_len = MATCH_BLOCKSIZE
+            + svn_txdelta__match_length (match + MATCH_BLOCKSIZE,
+                                         here + MATCH_BLOCKSIZE, max);
+
+          /* Commit the pending insert, then the copy.  */
+          if (insert_from != NULL)
+            {
+              svn_txdelta__insert_op (build_baton, svn_txdelta_new,
+                                      0, here - insert_from,
+                                      insert_from, pool);
+              insert_from = NULL;
+            }
+          svn_txdelta__insert_op (build_baton, svn_txdelta_source,
+                                  pos, match_len, NULL, pool);
+
+          here += match_len;
+          if (end - here >= MATCH_BLOCKSIZE)
+            rolling = adler32_sum (1, here, MATCH_BLOCKSIZE);
+          continue;
+        }
+
+      /* No match here; insert this byte and roll onward.  */
+      if (insert_from == NULL)
+        insert_from = here;
+      if (here + MATCH_BLOCKSIZE < end)
+        rolling = adler32_rotate (rolling, here[0], here[MATCH_BLOCKSIZE]);
+      ++here;
+    }
+
+  /* Insert whatever is left over.  */
+  if (insert_from == NULL)
+    insert_from = here;
+  if (insert_from < end)
+    svn_txdelta__insert_op (build_baton, svn_txdelta_new,
+                            0, end - insert_from, insert_from, pool);
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -23,6 +23,11 @@
 #include "svn_io.h"
 #include "delta.h"
 #include "svn_pools.h"
+#include "svn_private_config.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #define NORMAL_BITS 7
 #define LENGTH_BITS 5
@@ -36,6 +41,7 @@
 struct encoder_baton {
   svn_stream_t *output;
   svn_boolean_t header_done;
+  int version;
   apr_pool_t *pool;
 };
 
@@ -57,8 +63,8 @@ struct encoder_baton {
         2000 encodes as [1 0001111] [0 1010000]
 */
 
-static char *
-encode_int (char *p, apr_off_t val)
+char *
+svn_delta__encode_int (char *p, apr_off_t val)
 {
   int n;
   apr_off_t v;
@@ -93,11 +99,40 @@ append_encoded_int (svn_stringbuf_t *header, apr_off_t val, apr_pool_t *pool)
 {
   char buf[128], *p;
 
-  p = encode_int (buf, val);
+  p = svn_delta__encode_int (buf, val);
   svn_stringbuf_appendbytes (header, buf, p - buf);
 }
 
 
+/* Encode the LEN bytes at DATA as a version 1 svndiff section in
+   OUT: the original length as an svndiff integer, followed by either
+   the deflated bytes or, if deflating would not save anything, the
+   raw bytes.  */
+#ifdef HAVE_LIBZ
+static svn_error_t *
+zlib_encode (const char *data,
+             apr_size_t len,
+             svn_stringbuf_t *out,
+             apr_pool_t *pool)
+{
+  uLong comp_len = len + (len / 1000) + 13; /* worst-case deflate growth */
+  char *comp = apr_palloc (pool, comp_len);
+
+  append_encoded_int (out, len, pool);
+  if (len > 0
+      && compress2 ((unsigned char *) comp, &comp_len,
+                    (const unsigned char *) data, len,
+                    Z_DEFAULT_COMPRESSION) == Z_OK
+      && comp_len < len)
+    svn_stringbuf_appendbytes (out, comp, comp_len);
+  else
+    svn_stringbuf_appendbytes (out, data, len);
+
+  return SVN_NO_ERROR;
+}
+#endif /* HAVE_LIBZ */
+
+
 static svn_error_t *
 window_handler (svn_txdelta_window_t *window, void *baton)
 {
@@ -109,12 +144,17 @@ window_handler (svn_txdelta_window_t *window, void *baton)
   const svn_txdelta_op_t *op;
   svn_error_t *err;
   apr_size_t len;
+  const char *newdata_buf;
+  apr_size_t newdata_len;
 
   /* Make sure we write the header.  */
   if (eb->header_done == FALSE)
     {
+      char hbuf[4] = "SVN\0";
+
+      hbuf[3] = (char) eb->version;
       len = 4;
-      err = svn_stream_write (eb->output, "SVN\0", &len);
+      err = svn_stream_write (eb->output, hbuf, &len);
       if (err != SVN_NO_ERROR)
         return err;
       eb->header_done = TRUE;
@@ -155,18 +195,39 @@ window_handler (svn_txdelta_window_t *window, void *baton)
       if (op->length >> 6 == 0)
         *ip++ |= op->length;
       else
-        ip = encode_int (ip + 1, op->length);
+        ip = svn_delta__encode_int (ip + 1, op->length);
       if (op->action_code != svn_txdelta_new)
-        ip = encode_int (ip, op->offset);
+        ip = svn_delta__encode_int (ip, op->offset);
       svn_stringbuf_appendbytes (instructions, ibuf, ip - ibuf);
     }
 
+  /* In the version 1 format, wrap each section in a compressed
+     container.  The window header then carries the on-the-wire
+     section lengths.  */
+  newdata_buf = window->new_data->data;
+  newdata_len = window->new_data->len;
+#ifdef HAVE_LIBZ
+  if (eb->version == 1)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create ("", pool);
+
+      SVN_ERR (zlib_encode (instructions->data, instructions->len,
+                            compressed, pool));
+      instructions = compressed;
+
+      compressed = svn_stringbuf_create ("", pool);
+      SVN_ERR (zlib_encode (newdata_buf, newdata_len, compressed, pool));
+      newdata_buf = compressed->data;
+      newdata_len = compressed->len;
+    }
+#endif /* HAVE_LIBZ */
+
   /* Encode the header.  */
   append_encoded_int (header, window->sview_offset, pool);
   append_encoded_int (header, window->sview_len, pool);
   append_encoded_int (header, window->tview_len, pool);
   append_encoded_int (header, instructions->len, pool);
-  append_encoded_int (header, window->new_data->len, pool);
+  append_encoded_int (header, newdata_len, pool);
 
   /* Write out the window.  */
   len = header->len;
@@ -176,10 +237,10 @@ window_handler (svn_txdelta_window_t *window, void *baton)
       len = instructions->len;
       err = svn_stream_write (eb->output, instructions->data, &len);
     }
-  if (err == SVN_NO_ERROR && window->new_data->len > 0)
+  if (err == SVN_NO_ERROR && newdata_len > 0)
     {
-      len = window->new_data->len;
-      err = svn_stream_write (eb->output, window->new_data->data, &len);
+      len = newdata_len;
+      err = svn_stream_write (eb->output, newdata_buf, &len);
     }
 
   svn_pool_destroy (pool);
@@ -187,23 +248,44 @@ window_handler (svn_txdelta_window_t *window, void *baton)
 }
 
 void
-svn_txdelta_to_svndiff (svn_stream_t *output,
-			apr_pool_t *pool,
-			svn_txdelta_window_handler_t *handler,
-			void **handler_baton)
+svn_txdelta_to_svndiff_version (svn_stream_t *output,
+                                apr_pool_t *pool,
+                                int version,
+                                svn_txdelta_window_handler_t *handler,
+                                void **handler_baton)
 {
   apr_pool_t *subpool = svn_pool_create (pool);
   struct encoder_baton *eb;
 
+  /* Clamp VERSION to what this build can actually encode.  */
+  if (version < 0)
+    version = 0;
+#ifdef HAVE_LIBZ
+  if (version > 1)
+    version = 1;
+#else
+  version = 0;
+#endif
+
   eb = apr_palloc (subpool, sizeof (*eb));
   eb->output = output;
   eb->header_done = FALSE;
+  eb->version = version;
   eb->pool = subpool;
 
   *handler = window_handler;
   *handler_baton = eb;
 }
 
+void
+svn_txdelta_to_svndiff (svn_stream_t *output,
+			apr_pool_t *pool,
+			svn_txdelta_window_handler_t *handler,
+			void **handler_baton)
+{
+  svn_txdelta_to_svndiff_version (output, pool, 0, handler, handler_baton);
+}
+
 
 
 /* ----- svndiff to text delta ----- */
@@ -216,14 +298,13 @@ struct decode_baton
   svn_txdelta_window_handler_t consumer_func;
   void *consumer_baton;
 
-  /* Pool to create subpools from; each developing window will be a
-     subpool.  */
+  /* Pool the decoder lives in, and a scratch subpool which is
+     cleared after each window has been decoded and consumed.  */
   apr_pool_t *pool;
-
-  /* The current subpool which contains our current window-buffer.  */
   apr_pool_t *subpool;
 
-  /* The actual svndiff data buffer, living within subpool.  */
+  /* Leftover svndiff data from a previous write: at most the partial
+     window we are still waiting to complete.  */
   svn_stringbuf_t *buffer;
 
   /* The offset and size of the last source view, so that we can check
@@ -235,6 +316,9 @@ struct decode_baton
      This field keeps track of how many of those bytes we have read.  */
   int header_bytes;
 
+  /* Format version of the stream, from the fourth header byte.  */
+  int version;
+
   /* Do we want an error to occur when we close the stream that
      indicates we didn't send the whole svndiff data?  If you plan to
      not transmit the whole svndiff data stream, you will want this to
@@ -242,16 +326,23 @@ struct decode_baton
   svn_boolean_t error_on_early_close;
 };
 
+/* The highest format version this build can decode.  */
+#ifdef HAVE_LIBZ
+#define DECODABLE_SVNDIFF_VERSION 1
+#else
+#define DECODABLE_SVNDIFF_VERSION 0
+#endif
+
 
 /* Decode an svndiff-encoded integer into VAL and return a pointer to
    the byte after the integer.  The bytes to be decoded live in the
-   range [P..END-1].  See the comment for encode_int earlier in this
+   range [P..END-1].  See the comment for svn_delta__encode_int earlier in this
    file for more detail on the encoding format.  */
 
-static const unsigned char *
-decode_int (apr_off_t *val,
-            const unsigned char *p,
-            const unsigned char *end)
+const unsigned char *
+svn_delta__decode_int (apr_off_t *val,
+                       const unsigned char *p,
+                       const unsigned char *end)
 {
   /* Decode bytes until we're done.  */
   *val = 0;
@@ -292,14 +383,14 @@ decode_instruction (svn_txdelta_op_t *op,
   op->length = *p++ & 0x3f;
   if (op->length == 0)
     {
-      p = decode_int (&val, p, end);
+      p = svn_delta__decode_int (&val, p, end);
       if (p == NULL)
         return NULL;
       op->length = val;
     }
   if (op->action_code != svn_txdelta_new)
     {
-      p = decode_int (&val, p, end);
+      p = svn_delta__decode_int (&val, p, end);
       if (p == NULL)
         return NULL;
       op->offset = val;
@@ -308,6 +399,52 @@ decode_instruction (svn_txdelta_op_t *op,
   return p;
 }
 
+
+/* Decode the version 1 svndiff section at IN (INLEN bytes on the
+   wire) into OUT: read the original length prefix, then inflate the
+   payload, or copy it through if it was stored uncompressed.  */
+#ifdef HAVE_LIBZ
+static svn_error_t *
+zlib_decode (const unsigned char *in,
+             apr_size_t inlen,
+             svn_stringbuf_t *out,
+             apr_pool_t *pool)
+{
+  const unsigned char *payload;
+  apr_off_t val;
+  apr_size_t orig_len;
+
+  payload = svn_delta__decode_int (&val, in, in + inlen);
+  if (payload == NULL || val < 0)
+    return svn_error_create (SVN_ERR_SVNDIFF_CORRUPT_WINDOW, 0, NULL, pool,
+                             "svndiff contains corrupt compressed section");
+  orig_len = val;
+  inlen -= payload - in;
+
+  if (inlen == orig_len)
+    {
+      /* Stored uncompressed.  */
+      svn_stringbuf_appendbytes (out, (const char *) payload, inlen);
+    }
+  else
+    {
+      uLongf zlen = orig_len;
+
+      svn_stringbuf_ensure (out, orig_len);
+      if (uncompress ((unsigned char *) out->data, &zlen,
+                      payload, inlen) != Z_OK
+          || zlen != orig_len)
+        return svn_error_create (SVN_ERR_SVNDIFF_CORRUPT_WINDOW, 0, NULL,
+                                 pool,
+                                 "svndiff compressed section did not inflate");
+      out->len = zlen;
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif /* HAVE_LIBZ */
+
+
 /* Count the instructions in the range [P..END-1] and make sure they
    are valid for the given window lengths.  Return -1 if the
    instructions are invalid; otherwise return the number of
@@ -354,6 +491,146 @@ count_and_verify_instructions (const unsigned char *p,
   return n;
 }
 
+/* Decode one window of svndiff data from the range [P..END-1] and
+   send it to DB's consumer.  Set *CONSUMED to the number of bytes the
+   window occupied on the wire, or to zero if the range does not yet
+   hold a complete window.  Scratch allocations (the instruction
+   array, expanded version 1 containers) happen in DB->subpool, which
+   the caller clears between windows.  */
+static svn_error_t *
+decode_window (apr_size_t *consumed,
+               struct decode_baton *db,
+               const unsigned char *p,
+               const unsigned char *end)
+{
+  const unsigned char *start = p;
+  const unsigned char *insdata, *insend;
+  const char *ndata;
+  apr_off_t val, sview_offset;
+  apr_size_t sview_len, tview_len, inslen, newlen, ndata_len, npos;
+  svn_txdelta_window_t window = { 0 };
+  svn_string_t new_data;
+  svn_txdelta_op_t *ops, *op;
+  int ninst;
+
+  *consumed = 0;
+
+  /* Read the window header, if we have enough bytes for that.  */
+  p = svn_delta__decode_int (&val, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  sview_offset = val;
+
+  p = svn_delta__decode_int (&val, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  sview_len = val;
+
+  p = svn_delta__decode_int (&val, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  tview_len = val;
+
+  p = svn_delta__decode_int (&val, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  inslen = val;
+
+  p = svn_delta__decode_int (&val, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  newlen = val;
+
+  /* Check for integer overflow (don't want to let the input trick
+     us into invalid pointer games using negative numbers).  */
+  /* FIXME: Some of these are apr_size_t, which is
+     unsigned. Should they be apr_ptrdiff_t instead? --xbc */
+  if (sview_offset < 0 || sview_len < 0 || tview_len < 0 || inslen < 0
+      || newlen < 0 || inslen + newlen < 0 || sview_offset + sview_len < 0)
+    return svn_error_create (SVN_ERR_SVNDIFF_CORRUPT_WINDOW, 0, NULL,
+                             db->pool,
+                             "svndiff contains corrupt window header");
+
+  /* Check for source windows which slide backwards.  */
+  if (sview_offset < db->last_sview_offset
+      || (sview_offset + sview_len
+          < db->last_sview_offset + db->last_sview_len))
+    return svn_error_create (SVN_ERR_SVNDIFF_BACKWARD_VIEW, 0, NULL,
+                             db->pool,
+                             "svndiff has backwards-sliding source views");
+
+  /* Wait for more data if we don't have enough bytes for the
+     whole window.  */
+  if ((apr_size_t) (end - p) < inslen + newlen)
+    return SVN_NO_ERROR;
+
+  /* Find the instruction and new-data sections.  In format
+     version 1 they arrive in compressed containers and must be
+     expanded before use.  */
+  insdata = p;
+  insend = p + inslen;
+  ndata = (const char *) p + inslen;
+  ndata_len = newlen;
+#ifdef HAVE_LIBZ
+  if (db->version == 1)
+    {
+      svn_stringbuf_t *insbuf = svn_stringbuf_create ("", db->subpool);
+      svn_stringbuf_t *ndbuf = svn_stringbuf_create ("", db->subpool);
+
+      SVN_ERR (zlib_decode (p, inslen, insbuf, db->subpool));
+      SVN_ERR (zlib_decode (p + inslen, newlen, ndbuf, db->subpool));
+      insdata = (const unsigned char *) insbuf->data;
+      insend = insdata + insbuf->len;
+      ndata = ndbuf->data;
+      ndata_len = ndbuf->len;
+    }
+#endif /* HAVE_LIBZ */
+
+  /* Count the instructions and make sure they are all valid.  */
+  ninst = count_and_verify_instructions (insdata, insend, sview_len,
+                                         tview_len, ndata_len);
+  if (ninst == -1)
+    return svn_error_create (SVN_ERR_SVNDIFF_INVALID_OPS, 0, NULL,
+                             db->pool,
+                             "svndiff contains invalid instructions");
+
+  /* Build the window structure.  */
+  window.sview_offset = sview_offset;
+  window.sview_len = sview_len;
+  window.tview_len = tview_len;
+
+  ops = apr_palloc (db->subpool, ninst * sizeof (*ops));
+  npos = 0;
+  for (op = ops; op < ops + ninst; op++)
+    {
+      insdata = decode_instruction (op, insdata, insend);
+      if (op->action_code == svn_txdelta_new)
+        {
+          op->offset = npos;
+          npos += op->length;
+        }
+    }
+  window.num_ops = ninst;
+  window.ops = ops;
+
+  new_data.data = ndata;
+  new_data.len = ndata_len;
+  window.new_data = &new_data;
+
+  /* Send it off.  The window's views and new data may point straight
+     into the input range, so the consumer must not hang on to them --
+     which the window handler contract already forbids.  */
+  SVN_ERR (db->consumer_func (&window, db->consumer_baton));
+
+  /* Remember the offset and length of the source view for next time.  */
+  db->last_sview_offset = sview_offset;
+  db->last_sview_len = sview_len;
+
+  *consumed = (p + inslen + newlen) - start;
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 write_handler (void *baton,
                const char *buffer,
@@ -361,154 +638,84 @@ write_handler (void *baton,
 {
   struct decode_baton *db = (struct decode_baton *) baton;
   const unsigned char *p, *end;
-  apr_off_t val, sview_offset;
-  apr_size_t sview_len, tview_len, inslen, newlen, remaining, npos;
-  svn_txdelta_op_t *op;
-  int ninst;
+  apr_size_t consumed;
 
-  /* Chew up four bytes at the beginning for the header.  */
+  /* Chew up four bytes at the beginning for the header.  The fourth
+     byte is the format version.  */
   if (db->header_bytes < 4)
     {
       apr_size_t nheader = 4 - db->header_bytes;
+      apr_size_t i;
+
       if (nheader > *len)
         nheader = *len;
-      if (memcmp (buffer, "SVN\0" + db->header_bytes, nheader) != 0)
-        return svn_error_create (SVN_ERR_SVNDIFF_INVALID_HEADER, 
-                                 0, NULL, db->pool,
-                                 "svndiff has invalid header");
+      for (i = 0; i < nheader; i++)
+        {
+          int idx = db->header_bytes + i;
+          unsigned char c = (unsigned char) buffer[i];
+
+          if (idx < 3)
+            {
+              if (c != (unsigned char) "SVN"[idx])
+                return svn_error_create (SVN_ERR_SVNDIFF_INVALID_HEADER,
+                                         0, NULL, db->pool,
+                                         "svndiff has invalid header");
+            }
+          else
+            {
+              if (c > DECODABLE_SVNDIFF_VERSION)
+                return svn_error_create (SVN_ERR_SVNDIFF_INVALID_HEADER,
+                                         0, NULL, db->pool,
+                                         "svndiff has unsupported version");
+              db->version = c;
+            }
+        }
       *len -= nheader;
       buffer += nheader;
       db->header_bytes += nheader;
     }
 
-  /* Concatenate the old with the new.  */
-  svn_stringbuf_appendbytes (db->buffer, buffer, *len);
+  p = (const unsigned char *) buffer;
+  end = p + *len;
 
-  /* We have a buffer of svndiff data that might be good for:
-
-     a) an integral number of windows' worth of data - this is a
-        trivial case.  Make windows from our data and ship them off.
-
-     b) a non-integral number of windows' worth of data - we shall
-        consume the integral portion of the window data, and then
-        somewhere in the following loop the decoding of the svndiff
-        data will run out of stuff to decode, and will simply return
-        SVN_NO_ERROR, anxiously awaiting more data.
-  */
-
-  while (1)
+  /* If no partial window is left over from an earlier write, decode
+     windows straight out of the caller's buffer; nothing gets copied
+     until we run into a window that is still incomplete.  */
+  if (db->buffer->len == 0)
     {
-      apr_pool_t *newpool;
-      svn_txdelta_window_t window = { 0 };
-      svn_string_t new_data;
-      svn_txdelta_op_t *ops;
-
-      /* Read the header, if we have enough bytes for that.  */
-      p = (const unsigned char *) db->buffer->data;
-      end = (const unsigned char *) db->buffer->data + db->buffer->len;
-
-      p = decode_int (&val, p, end);
-      if (p == NULL)
-	return SVN_NO_ERROR;
-      sview_offset = val;
-
-      p = decode_int (&val, p, end);
-      if (p == NULL)
-	return SVN_NO_ERROR;
-      sview_len = val;
+      while (p < end)
+        {
+          SVN_ERR (decode_window (&consumed, db, p, end));
+          if (consumed == 0)
+            break;
+          p += consumed;
+          svn_pool_clear (db->subpool);
+        }
 
-      p = decode_int (&val, p, end);
-      if (p == NULL)
-	return SVN_NO_ERROR;
-      tview_len = val;
+      /* Stash whatever is left of a partial window.  */
+      svn_stringbuf_appendbytes (db->buffer, (const char *) p, end - p);
+      return SVN_NO_ERROR;
+    }
 
-      p = decode_int (&val, p, end);
-      if (p == NULL)
-	return SVN_NO_ERROR;
-      inslen = val;
+  /* Otherwise, append the new data to the pending window and decode
+     from the concatenation.  Once the backlog is gone, later writes
+     take the direct path above again.  */
+  svn_stringbuf_appendbytes (db->buffer, (const char *) p, end - p);
 
-      p = decode_int (&val, p, end);
-      if (p == NULL)
-	return SVN_NO_ERROR;
-      newlen = val;
-
-      /* Check for integer overflow (don't want to let the input trick
-         us into invalid pointer games using negative numbers).  */
-      /* FIXME: Some of these are apr_size_t, which is
-         unsigned. Should they be apr_ptrdiff_t instead? --xbc */
-      if (sview_offset < 0 || sview_len < 0 || tview_len < 0 || inslen < 0
-	  || newlen < 0 || inslen + newlen < 0 || sview_offset + sview_len < 0)
-	return svn_error_create (SVN_ERR_SVNDIFF_CORRUPT_WINDOW, 0, NULL, 
-				 db->pool,
-				 "svndiff contains corrupt window header");
-
-      /* Check for source windows which slide backwards.  */
-      if (sview_offset < db->last_sview_offset
-	  || (sview_offset + sview_len
-	      < db->last_sview_offset + db->last_sview_len))
-	return svn_error_create (SVN_ERR_SVNDIFF_BACKWARD_VIEW, 0, NULL, 
-				 db->pool,
-				 "svndiff has backwards-sliding source views");
-
-      /* Wait for more data if we don't have enough bytes for the
-         whole window.  */
-      if ((apr_size_t) (end - p) < inslen + newlen)
-	return SVN_NO_ERROR;
-
-      /* Count the instructions and make sure they are all valid.  */
-      end = p + inslen;
-      ninst = count_and_verify_instructions (p, end, sview_len, 
-					     tview_len, newlen);
-      if (ninst == -1)
-	return svn_error_create (SVN_ERR_SVNDIFF_INVALID_OPS, 0, NULL, 
-				 db->pool, 
-				 "svndiff contains invalid instructions");
-
-      /* Build the window structure.  */
-      window.sview_offset = sview_offset;
-      window.sview_len = sview_len;
-      window.tview_len = tview_len;
-
-      ops = apr_palloc (db->subpool, ninst * sizeof (*ops));
-      npos = 0;
-      for (op = ops; op < ops + ninst; op++)
-	{
-	  p = decode_instruction (op, p, end);
-	  if (op->action_code == svn_txdelta_new)
-	    {
-	      op->offset = npos;
-	      npos += op->length;
-	    }
-	}
-      window.num_ops = ninst;
-      window.ops = ops;
-
-      new_data.data = (const char *)p;
-      new_data.len = newlen;
-      window.new_data = &new_data;
-
-      /* Send it off.  */
-      SVN_ERR(db->consumer_func (&window, db->consumer_baton));
-
-      /* Make a new subpool and buffer, saving aside the remaining
-         data in the old buffer.  */
-      newpool = svn_pool_create (db->pool);
-      p += newlen;
-      remaining = db->buffer->data + db->buffer->len - (const char *) p;
-      db->buffer = 
-	svn_stringbuf_ncreate ((const char *) p, remaining, newpool);
-
-      /* Remember the offset and length of the source view for next time.  */
-      db->last_sview_offset = sview_offset;
-      db->last_sview_len = sview_len;
-
-      /* We've copied stuff out of the old pool. Toss that pool and use
-         our new pool.
-         ### might be nice to avoid the copy and just use svn_pool_clear
-         ### to get rid of whatever the "other stuff" is. future project...
-      */
-      svn_pool_destroy(db->subpool);
-      db->subpool = newpool;
+  while (db->buffer->len > 0)
+    {
+      SVN_ERR (decode_window (&consumed, db,
+                              (const unsigned char *) db->buffer->data,
+                              ((const unsigned char *) db->buffer->data
+                               + db->buffer->len)));
+      if (consumed == 0)
+        break;
+
+      /* Slide the unconsumed tail up to the front of the buffer.  */
+      memmove (db->buffer->data, db->buffer->data + consumed,
+               db->buffer->len - consumed);
+      db->buffer->len -= consumed;
+      svn_pool_clear (db->subpool);
     }
 
   return SVN_NO_ERROR;
@@ -549,10 +756,11 @@ svn_txdelta_parse_svndiff (svn_txdelta_window_handler_t handler,
   db->consumer_baton = handler_baton;
   db->pool = subpool;
   db->subpool = svn_pool_create (subpool);
-  db->buffer = svn_stringbuf_create ("", db->subpool);
+  db->buffer = svn_stringbuf_create ("", subpool);
   db->last_sview_offset = 0;
   db->last_sview_len = 0;
   db->header_bytes = 0;
+  db->version = 0;
   db->error_on_early_close = error_on_early_close;
   stream = svn_stream_create (db, pool);
   svn_stream_set_write (stream, write_handler);
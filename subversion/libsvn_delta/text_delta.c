@@ -22,6 +22,8 @@
 
 #include <apr_general.h>        /* for APR_INLINE */
 #include <apr_md5.h>            /* for, um...MD5 stuff */
+#include <apr_file_io.h>
+#include <apr_mmap.h>
 
 #include "svn_delta.h"
 #include "svn_io.h"
@@ -29,6 +31,19 @@
 #include "delta.h"
 
 
+/* Source views at least this large are deltified with the
+   rolling-hash engine instead of vdelta.  */
+#define SVN_TXDELTA__RDELTA_THRESHOLD (SVN_STREAM_CHUNK_SIZE / 2)
+
+/* Bounds for the adaptive window size.  A stream starts with a
+   MIN-sized window and doubles it after every window produced, up to
+   MAX; so the Nth window sees match distances of MIN * 2^N bytes.
+   The old fixed size, SVN_STREAM_CHUNK_SIZE, sits in the middle of
+   this range.  */
+#define SVN_TXDELTA__MIN_WINDOW_SIZE (SVN_STREAM_CHUNK_SIZE / 8)
+#define SVN_TXDELTA__MAX_WINDOW_SIZE (SVN_STREAM_CHUNK_SIZE * 8)
+
+
 /* Text delta stream descriptor. */
 
 struct svn_txdelta_stream_t {
@@ -37,10 +52,31 @@ struct svn_txdelta_stream_t {
   svn_stream_t *target;
 
   /* Private data */
+  apr_pool_t *pool;             /* Pool the stream was allocated in. */
   svn_boolean_t more;           /* TRUE if there are more data in the pool. */
   apr_off_t pos;                /* Offset of next read in source file. */
   char *buf;                    /* Buffer for vdelta data. */
+  apr_size_t buf_size;          /* Allocated size of BUF. */
+  apr_size_t window_size;       /* Current window size. */
+  svn_boolean_t fixed_window;   /* Window size was pinned by the caller. */
   apr_size_t saved_source_len;  /* Amount of source data saved in buf. */
+  svn_boolean_t source_done;    /* Source stream has hit end-of-file;
+                                   don't issue further reads on it. */
+  apr_off_t tpos;               /* Amount of target data consumed. */
+  svn_boolean_t unchanged;      /* Target has matched source so far. */
+  svn_txdelta__vdelta_arena_t *vdelta_arena; /* Hash table storage reused
+                                                across windows. */
+  int ops_high_water;           /* Largest op count any window of this
+                                   stream has produced; later windows
+                                   presize their op arrays to it. */
+  apr_off_t nwindows;           /* Number of windows pulled so far;
+                                   this is what a checkpoint records. */
+
+  /* Window storage recycled by svn_txdelta_next_window_reuse; all
+     NULL/empty until the first reuse call. */
+  struct build_ops_baton_t reuse_bob;  /* Op and new-data storage. */
+  svn_txdelta_window_t *reuse_window;  /* The window handed out last time. */
+  svn_string_t *reuse_new_data;        /* Its new-data header. */
 
   apr_md5_ctx_t context;        /* APR's MD5 context container. */
 
@@ -69,30 +105,38 @@ struct apply_baton {
   apr_size_t sbuf_len;          /* Length of SBUF data */
   char *tbuf;                   /* Target buffer */
   apr_size_t tbuf_size;         /* Allocated target buffer space */
-};
-
 
-/* Context/baton for building an operation sequence. */
-
-struct build_ops_baton_t {
-  int num_ops;                  /* current number of ops */
-  int ops_size;                 /* number of ops allocated */
-  svn_txdelta_op_t *ops;        /* the operations */
-
-  svn_stringbuf_t *new_data;    /* any new data used by the operations */
+#if APR_HAS_MMAP
+  /* If the source is a memory-mapped file, the mapping; else NULL.
+     When set, SOURCE is NULL and source views are taken straight out
+     of the mapping, with no buffering or copying at all.  */
+  apr_mmap_t *source_map;
+#endif /* APR_HAS_MMAP */
+
+  apr_md5_ctx_t md5_context;    /* Digest of the target data written
+                                   so far. */
+
+  /* Calculated digest of the complete target data.
+     NOTE:  This is only valid after the NULL (final) window has been
+     handed to the window handler.  */
+  unsigned char digest[MD5_DIGESTSIZE];
+  svn_boolean_t digest_valid;   /* True once DIGEST has been computed. */
 };
 
 
+/* The build_ops baton (see delta.h) lives here;
+   svn_txdelta__insert_op below fills it in.  */
+
 
-/* Allocate a delta window. */
+/* Fill in a delta window from the ops built up in BOB, making
+   NEW_DATA its new-data header.  The window just points at BOB's
+   storage; nothing is copied. */
 
-static svn_txdelta_window_t *
-make_window (apr_pool_t *pool, struct build_ops_baton_t *bob)
+static void
+fill_window (svn_txdelta_window_t *window,
+             svn_string_t *new_data,
+             struct build_ops_baton_t *bob)
 {
-  svn_txdelta_window_t *window;
-  svn_string_t *new_data = apr_palloc (pool, sizeof (*new_data));
-
-  window = apr_palloc (pool, sizeof (*window));
   window->sview_offset = 0;
   window->sview_len = 0;
   window->tview_len = 0;
@@ -106,8 +150,6 @@ make_window (apr_pool_t *pool, struct build_ops_baton_t *bob)
   new_data->data = bob->new_data->data;
   new_data->len = bob->new_data->len;
   window->new_data = new_data;
-
-  return window;
 }
 
 
@@ -124,13 +166,28 @@ svn_txdelta__insert_op (struct build_ops_baton_t *bob,
 {
   svn_txdelta_op_t *op;
 
+  /* Inserts always append their bytes to the end of the new data, so
+     an insert that immediately follows another one can just extend
+     it: same bytes, one op fewer, and smaller svndiff output. */
+  if (opcode == svn_txdelta_new && bob->num_ops > 0)
+    {
+      op = &bob->ops[bob->num_ops - 1];
+      if (op->action_code == svn_txdelta_new)
+        {
+          op->length += length;
+          svn_stringbuf_appendbytes (bob->new_data, new_data, length);
+          return;
+        }
+    }
+
   /* Create space for the new op. */
   if (bob->num_ops == bob->ops_size)
     {
       svn_txdelta_op_t *const old_ops = bob->ops;
       int const new_ops_size = (bob->ops_size == 0
                                 ? 16 : 2 * bob->ops_size);
-      bob->ops = apr_palloc (pool, new_ops_size * sizeof (*bob->ops));
+      bob->ops = apr_palloc (bob->pool ? bob->pool : pool,
+                             new_ops_size * sizeof (*bob->ops));
 
       /* Copy any existing ops into the new array */
       if (old_ops)
@@ -165,6 +222,24 @@ svn_txdelta__insert_op (struct build_ops_baton_t *bob,
 }
 
 
+void
+svn_txdelta__presize_ops (struct build_ops_baton_t *bob,
+                          int num_ops,
+                          apr_pool_t *pool)
+{
+  if (bob->ops_size < num_ops)
+    {
+      svn_txdelta_op_t *const old_ops = bob->ops;
+
+      bob->ops = apr_palloc (bob->pool ? bob->pool : pool,
+                             num_ops * sizeof (*bob->ops));
+      if (old_ops)
+        memcpy (bob->ops, old_ops, bob->num_ops * sizeof (*bob->ops));
+      bob->ops_size = num_ops;
+    }
+}
+
+
 
 /* Allocate a delta stream descriptor. */
 
@@ -175,18 +250,52 @@ svn_txdelta (svn_txdelta_stream_t **stream,
              apr_pool_t *pool)
 {
   *stream = apr_palloc (pool, sizeof (**stream));
-  (*stream)->source = source; 
+  (*stream)->source = source;
   (*stream)->target = target;
+  (*stream)->pool = pool;
   (*stream)->more = TRUE;
   (*stream)->pos = 0;
-  (*stream)->buf = apr_palloc (pool, 3 * SVN_STREAM_CHUNK_SIZE);
+  (*stream)->window_size = SVN_TXDELTA__MIN_WINDOW_SIZE;
+  (*stream)->fixed_window = FALSE;
+  (*stream)->buf_size = 3 * (*stream)->window_size;
+  (*stream)->buf = apr_palloc (pool, (*stream)->buf_size);
   (*stream)->saved_source_len = 0;
+  (*stream)->source_done = FALSE;
+  (*stream)->tpos = 0;
+  (*stream)->unchanged = TRUE;
+  (*stream)->vdelta_arena = svn_txdelta__vdelta_arena_create (pool);
+  (*stream)->ops_high_water = 0;
+  (*stream)->nwindows = 0;
+  (*stream)->reuse_window = NULL;
 
   /* Initialize MD5 digest calculation. */
   apr_md5_init (&((*stream)->context));
 }
 
 
+void
+svn_txdelta_set_window_size (svn_txdelta_stream_t *stream,
+                             apr_size_t window_size)
+{
+  /* Too late to resize once data is in flight.  */
+  if (stream->pos != 0 || stream->saved_source_len != 0)
+    return;
+
+  if (window_size < SVN_TXDELTA__MIN_WINDOW_SIZE)
+    window_size = SVN_TXDELTA__MIN_WINDOW_SIZE;
+  else if (window_size > SVN_TXDELTA__MAX_WINDOW_SIZE)
+    window_size = SVN_TXDELTA__MAX_WINDOW_SIZE;
+
+  stream->window_size = window_size;
+  stream->fixed_window = TRUE;
+  if (stream->buf_size < 3 * window_size)
+    {
+      stream->buf_size = 3 * window_size;
+      stream->buf = apr_palloc (stream->pool, stream->buf_size);
+    }
+}
+
+
 
 /* Pull the next delta window from a stream.
 
@@ -208,11 +317,28 @@ svn_txdelta (svn_txdelta_stream_t **stream,
 
    If we run out of source data before we run out of target data, we
    reuse the final chunk of data for the remaining windows.  No grand
-   scheme at work there; that's just how the code worked out. */
-svn_error_t *
-svn_txdelta_next_window (svn_txdelta_window_t **window,
-                         svn_txdelta_stream_t *stream,
-                         apr_pool_t *pool)
+   scheme at work there; that's just how the code worked out.
+
+   This is the guts of both svn_txdelta_next_window and
+   svn_txdelta_next_window_reuse.  BOB supplies the op storage (its
+   new_data stringbuf may be NULL, in which case one is created in
+   POOL on demand).  RESULT and NEW_DATA, if non-null, are the window
+   and new-data header to fill in; when RESULT is null, both are
+   allocated from POOL.  POOL also holds the match engines' scratch
+   data, so it may be cleared between windows either way.
+
+   If SKIP is set, consume one window's worth of data and update all
+   the stream bookkeeping (position, MD5, window sizing) without
+   running a match engine or building a window; *WINDOW is set to
+   NULL.  This is how svn_txdelta_resume fast-forwards a stream. */
+static svn_error_t *
+next_window (svn_txdelta_window_t **window,
+             svn_txdelta_stream_t *stream,
+             struct build_ops_baton_t *bob,
+             svn_txdelta_window_t *result,
+             svn_string_t *new_data,
+             svn_boolean_t skip,
+             apr_pool_t *pool)
 {
   if (!stream->more)
     {
@@ -231,19 +357,37 @@ svn_txdelta_next_window (svn_txdelta_window_t **window,
     {
       svn_error_t *err;
       apr_size_t total_source_len;
-      apr_size_t new_source_len = SVN_STREAM_CHUNK_SIZE;
-      apr_size_t target_len = SVN_STREAM_CHUNK_SIZE;
-      struct build_ops_baton_t bob = { 0 };
+      apr_size_t new_source_len = stream->window_size;
+      apr_size_t target_len = stream->window_size;
 
       /* If there is no saved source data yet, read an extra half
          window of data this time to get things started. */
       if (stream->saved_source_len == 0)
-        new_source_len += SVN_STREAM_CHUNK_SIZE / 2;
+        new_source_len += stream->window_size / 2;
+
+      /* Read the source stream.  Once it has reported end-of-file,
+         don't keep asking; every later window would otherwise pay for
+         a read that can only come back empty.
+
+         ### A reader thread that fetched the next chunks while the
+         ### match engine chewed on these would overlap I/O latency
+         ### with computation, but it can't be done from here: pools
+         ### aren't thread-safe, and the streams we're handed may do
+         ### arbitrary work on a read (the FS ones open Berkeley DB
+         ### transactions).  Readahead has to stay the OS's job.  */
+      err = SVN_NO_ERROR;
+      if (stream->source_done)
+        new_source_len = 0;
+      else
+        {
+          apr_size_t requested_len = new_source_len;
 
-      /* Read the source stream. */
-      err = svn_stream_read (stream->source,
-                             stream->buf + stream->saved_source_len,
-                             &new_source_len);
+          err = svn_stream_read (stream->source,
+                                 stream->buf + stream->saved_source_len,
+                                 &new_source_len);
+          if (err == SVN_NO_ERROR && new_source_len < requested_len)
+            stream->source_done = TRUE;
+        }
       total_source_len = stream->saved_source_len + new_source_len;
 
       /* Update the MD5 accumulator with the freshly-read data in
@@ -265,39 +409,262 @@ svn_txdelta_next_window (svn_txdelta_window_t **window,
         return err;
       stream->pos += new_source_len;
 
-      /* Forget everything if there's no target data. */
+      /* Forget everything if there's no target data.  Before
+         declaring the streams identical, make sure the source
+         doesn't have unread data beyond the end of the target.  */
       if (target_len == 0)
         {
+          if (stream->unchanged)
+            {
+              char probe;
+              apr_size_t probe_len = 1;
+
+              SVN_ERR (svn_stream_read (stream->source, &probe, &probe_len));
+              if (probe_len != 0)
+                {
+                  apr_md5_update (&(stream->context), &probe, probe_len);
+                  stream->unchanged = FALSE;
+                }
+            }
           *window = NULL;
           stream->more = FALSE;
           return SVN_NO_ERROR;
         }
 
-      /* Compute the delta operations. */
-      bob.new_data = svn_stringbuf_create ("", pool);
-      svn_txdelta__vdelta (&bob, stream->buf,
-                           total_source_len, target_len,
-                           pool);
+      stream->nwindows++;
 
-      /* Create the delta window. */
-      *window = make_window (pool, &bob);
-      (*window)->sview_offset = stream->pos - total_source_len;
-      (*window)->sview_len = total_source_len;
-      (*window)->tview_len = target_len;
+      /* We are going to produce a window; make sure there is storage
+         for it.  The reuse path hands in recycled storage, the plain
+         path lets it come out of POOL. */
+      if (! skip)
+        {
+          if (result == NULL)
+            {
+              result = apr_palloc (pool, sizeof (*result));
+              new_data = apr_palloc (pool, sizeof (*new_data));
+            }
+          if (bob->new_data == NULL)
+            bob->new_data = svn_stringbuf_create ("", pool);
+        }
+
+      /* Fast path: if this target view is byte-identical to the same
+         region of the source, emit a single source-copy op without
+         cranking up a match engine at all.  This keeps track of
+         whether the streams have been identical from the start, so
+         the caller can learn (from svn_txdelta_stream_unchanged)
+         that nothing changed at all.  */
+      if (stream->unchanged
+          && stream->tpos >= stream->pos - (apr_off_t) total_source_len
+          && stream->tpos + (apr_off_t) target_len <= stream->pos)
+        {
+          const apr_size_t off
+            = stream->tpos - (stream->pos - total_source_len);
+
+          if (memcmp (stream->buf + off,
+                      stream->buf + total_source_len, target_len) == 0)
+            {
+              if (skip)
+                *window = NULL;
+              else
+                {
+                  svn_txdelta__insert_op (bob, svn_txdelta_source,
+                                          off, target_len, NULL, pool);
+                  fill_window (result, new_data, bob);
+                  result->sview_offset = stream->pos - total_source_len;
+                  result->sview_len = total_source_len;
+                  result->tview_len = target_len;
+                  *window = result;
+                }
+
+              stream->tpos += target_len;
+              stream->saved_source_len
+                = (total_source_len < stream->window_size)
+                ? total_source_len : stream->window_size;
+              memmove (stream->buf,
+                       stream->buf + total_source_len
+                       - stream->saved_source_len,
+                       stream->saved_source_len);
+              return SVN_NO_ERROR;
+            }
+        }
+      stream->unchanged = FALSE;
+
+      /* Compute the delta operations.  Use the rolling-hash engine
+         for big windows with source data; its flat checksum table
+         beats vdelta's collision chains there by a wide margin.
+         Small windows, and pure inserts, still go through vdelta,
+         which finds target-internal matches too.  */
+      if (skip)
+        *window = NULL;
+      else
+        {
+          /* Poorly matching data (compressed artifacts, say) produces
+             thousands of ops per window; presizing the op array to the
+             stream's high-water mark skips the regrow copies the
+             doubling in svn_txdelta__insert_op would otherwise do for
+             every window after the first. */
+          svn_txdelta__presize_ops (bob, stream->ops_high_water, pool);
+
+          if (total_source_len >= SVN_TXDELTA__RDELTA_THRESHOLD)
+            svn_txdelta__rdelta (bob, stream->buf,
+                                 total_source_len, target_len,
+                                 pool);
+          else
+            svn_txdelta__vdelta (bob, stream->buf,
+                                 total_source_len, target_len,
+                                 stream->vdelta_arena, pool);
+
+          if (bob->num_ops > stream->ops_high_water)
+            stream->ops_high_water = bob->num_ops;
+
+          /* Create the delta window. */
+          fill_window (result, new_data, bob);
+          result->sview_offset = stream->pos - total_source_len;
+          result->sview_len = total_source_len;
+          result->tview_len = target_len;
+          *window = result;
+        }
+      stream->tpos += target_len;
 
       /* Save the last window's worth of data from the source view. */
-      stream->saved_source_len = (total_source_len < SVN_STREAM_CHUNK_SIZE)
-        ? total_source_len : SVN_STREAM_CHUNK_SIZE;
+      stream->saved_source_len = (total_source_len < stream->window_size)
+        ? total_source_len : stream->window_size;
       memmove (stream->buf,
                stream->buf + total_source_len - stream->saved_source_len,
                stream->saved_source_len);
 
+      /* If the target filled this window, there is probably a lot
+         more coming; double the window size so the next window gets
+         longer match distances.  Tiny targets never pay for a big
+         window this way.  */
+      if (! stream->fixed_window
+          && target_len == stream->window_size
+          && stream->window_size < SVN_TXDELTA__MAX_WINDOW_SIZE)
+        {
+          stream->window_size *= 2;
+          if (stream->buf_size < 3 * stream->window_size)
+            {
+              char *old_buf = stream->buf;
+              stream->buf_size = 3 * stream->window_size;
+              stream->buf = apr_palloc (stream->pool, stream->buf_size);
+              memcpy (stream->buf, old_buf, stream->saved_source_len);
+            }
+        }
+
       /* That's it. */
       return SVN_NO_ERROR;
     }
 }
 
 
+svn_error_t *
+svn_txdelta_next_window (svn_txdelta_window_t **window,
+                         svn_txdelta_stream_t *stream,
+                         apr_pool_t *pool)
+{
+  struct build_ops_baton_t bob = { 0 };
+
+  return next_window (window, stream, &bob, NULL, NULL, FALSE, pool);
+}
+
+
+svn_error_t *
+svn_txdelta_next_window_reuse (svn_txdelta_window_t **window,
+                               svn_txdelta_window_t *prev_window,
+                               svn_txdelta_stream_t *stream,
+                               apr_pool_t *pool)
+{
+  /* Only the window this stream handed out last time can be
+     recycled; anything else means the caller is confused. */
+  assert (prev_window == NULL || prev_window == stream->reuse_window);
+
+  /* The first time through, set up the storage that will shuttle
+     back and forth.  It lives as long as the stream does. */
+  if (stream->reuse_window == NULL)
+    {
+      stream->reuse_window = apr_palloc (stream->pool,
+                                         sizeof (*stream->reuse_window));
+      stream->reuse_new_data = apr_palloc (stream->pool,
+                                           sizeof (*stream->reuse_new_data));
+      stream->reuse_bob.num_ops = 0;
+      stream->reuse_bob.ops_size = 0;
+      stream->reuse_bob.ops = NULL;
+      stream->reuse_bob.new_data = svn_stringbuf_create ("", stream->pool);
+      stream->reuse_bob.pool = stream->pool;
+    }
+
+  /* Rewind the op and new-data storage; handing PREV_WINDOW back
+     says the caller is done with the contents it describes. */
+  stream->reuse_bob.num_ops = 0;
+  svn_stringbuf_setempty (stream->reuse_bob.new_data);
+
+  return next_window (window, stream, &stream->reuse_bob,
+                      stream->reuse_window, stream->reuse_new_data,
+                      FALSE, pool);
+}
+
+
+void
+svn_txdelta_checkpoint (svn_txdelta_checkpoint_t *checkpoint,
+                        svn_txdelta_stream_t *stream)
+{
+  checkpoint->window_index = stream->nwindows;
+  checkpoint->source_offset = stream->pos;
+  checkpoint->target_offset = stream->tpos;
+}
+
+
+svn_error_t *
+svn_txdelta_resume (svn_txdelta_stream_t *stream,
+                    const svn_txdelta_checkpoint_t *checkpoint,
+                    apr_pool_t *pool)
+{
+  struct build_ops_baton_t bob = { 0 };
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  if (stream->nwindows != 0)
+    return svn_error_create
+      (SVN_ERR_INCORRECT_PARAMS, 0, NULL, pool,
+       "svn_txdelta_resume: stream has already produced windows");
+
+  while (stream->nwindows < checkpoint->window_index)
+    {
+      svn_txdelta_window_t *window;
+
+      if (! stream->more)
+        return svn_error_create
+          (SVN_ERR_INCORRECT_PARAMS, 0, NULL, pool,
+           "svn_txdelta_resume: checkpoint lies beyond the stream's end");
+
+      SVN_ERR (next_window (&window, stream, &bob, NULL, NULL, TRUE,
+                            subpool));
+      svn_pool_clear (subpool);
+    }
+  svn_pool_destroy (subpool);
+
+  /* If the offsets disagree, the caller is not feeding us the same
+     source and target data the checkpoint was taken against. */
+  if (stream->pos != checkpoint->source_offset
+      || stream->tpos != checkpoint->target_offset)
+    return svn_error_create
+      (SVN_ERR_INCORRECT_PARAMS, 0, NULL, pool,
+       "svn_txdelta_resume: stream data does not match the checkpoint");
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_boolean_t
+svn_txdelta_stream_unchanged (svn_txdelta_stream_t *stream)
+{
+  /* Until the final null window has been pulled, we can't know.  */
+  if (stream->more)
+    return FALSE;
+
+  return stream->unchanged;
+}
+
+
 const unsigned char *
 svn_txdelta_md5_digest (svn_txdelta_stream_t *stream)
 {
@@ -394,12 +761,38 @@ apply_window (svn_txdelta_window_t *window, void *baton)
 
   if (window == NULL)
     {
-      /* We're done; just clean up.  */
+      /* We're done; finish the digest and clean up.  The baton itself
+         outlives AB->pool, so the digest stays available to
+         svn_txdelta_apply_digest after this.  */
+      apr_md5_final (ab->digest, &ab->md5_context);
+      ab->digest_valid = TRUE;
       svn_stream_close (ab->target);
       svn_pool_destroy (ab->pool);
       return SVN_NO_ERROR;
     }
 
+#if APR_HAS_MMAP
+  /* If the source is memory-mapped, apply straight out of the map;
+     no source buffer shuffling is needed at all.  */
+  if (ab->source_map != NULL)
+    {
+      if (window->sview_offset + window->sview_len > ab->source_map->size)
+        return svn_error_create (SVN_ERR_INCOMPLETE_DATA, 0, NULL, ab->pool,
+                                 "Delta source ended unexpectedly");
+
+      size_buffer (&ab->tbuf, &ab->tbuf_size, window->tview_len, ab->pool);
+      apply_instructions (window,
+                          (const char *) ab->source_map->mm
+                          + window->sview_offset,
+                          ab->tbuf);
+
+      apr_md5_update (&ab->md5_context, ab->tbuf, window->tview_len);
+
+      len = window->tview_len;
+      return svn_stream_write (ab->target, ab->tbuf, &len);
+    }
+#endif /* APR_HAS_MMAP */
+
   /* Make sure the source view didn't slide backwards.  */
   assert (window->sview_offset >= ab->sbuf_offset
           && (window->sview_offset + window->sview_len
@@ -447,6 +840,8 @@ apply_window (svn_txdelta_window_t *window, void *baton)
      the target view.  */
   apply_instructions (window, ab->sbuf, ab->tbuf);
 
+  apr_md5_update (&ab->md5_context, ab->tbuf, window->tview_len);
+
   /* Write out the output. */
   len = window->tview_len;
   err = svn_stream_write (ab->target, ab->tbuf, &len);
@@ -465,7 +860,10 @@ svn_txdelta_apply (svn_stream_t *source,
   struct apply_baton *ab;
   assert (pool != NULL);
 
-  ab = apr_palloc (subpool, sizeof (*ab));
+  /* The baton lives in POOL, not the subpool, so that the computed
+     digest is still there after the final window destroys the
+     subpool and its buffers.  */
+  ab = apr_palloc (pool, sizeof (*ab));
   ab->source = source;
   ab->target = target;
   ab->pool = subpool;
@@ -475,11 +873,65 @@ svn_txdelta_apply (svn_stream_t *source,
   ab->sbuf_len = 0;
   ab->tbuf = NULL;
   ab->tbuf_size = 0;
+#if APR_HAS_MMAP
+  ab->source_map = NULL;
+#endif
+  apr_md5_init (&ab->md5_context);
+  ab->digest_valid = FALSE;
   *handler = apply_window;
   *handler_baton = ab;
 }
 
 
+void
+svn_txdelta_apply_file (apr_file_t *source_file,
+                        svn_stream_t *target,
+                        apr_pool_t *pool,
+                        svn_txdelta_window_handler_t *handler,
+                        void **handler_baton)
+{
+#if APR_HAS_MMAP
+  apr_finfo_t finfo;
+
+  /* Map the whole source file if we can; fall through to the
+     streamy, buffered path if we can't.  An empty file can't be
+     mapped, but the plain path handles it fine.  */
+  if (apr_file_info_get (&finfo, APR_FINFO_SIZE, source_file) == APR_SUCCESS
+      && finfo.size > 0)
+    {
+      apr_mmap_t *map;
+
+      if (apr_mmap_create (&map, source_file, 0, finfo.size,
+                           APR_MMAP_READ, pool) == APR_SUCCESS)
+        {
+          struct apply_baton *ab;
+
+          svn_txdelta_apply (svn_stream_empty (pool), target, pool,
+                             handler, handler_baton);
+          ab = *handler_baton;
+          ab->source_map = map;
+          return;
+        }
+    }
+#endif /* APR_HAS_MMAP */
+
+  svn_txdelta_apply (svn_stream_from_aprfile (source_file, pool), target,
+                     pool, handler, handler_baton);
+}
+
+
+const unsigned char *
+svn_txdelta_apply_digest (void *handler_baton)
+{
+  struct apply_baton *ab = handler_baton;
+
+  if (! ab->digest_valid)
+    return NULL;
+
+  return ab->digest;
+}
+
+
 
 /* Convenience routines */
 
@@ -517,18 +969,47 @@ svn_error_t *svn_txdelta_send_stream (svn_stream_t *stream,
                                       void *handler_baton,
                                       apr_pool_t *pool)
 {
-  svn_txdelta_stream_t *txstream;
-
-  /* ### this is a hack. we should simply read from the stream, construct
-     ### some windows, and pass those to the handler. there isn't any reason
-     ### to crank up a full "diff" algorithm just to copy a stream.
-     ###
-     ### will fix RSN. */
-
-  /* Create a delta stream which converts an *empty* bytestream into the
-     target bytestream. */
-  svn_txdelta (&txstream, svn_stream_empty (pool), stream, pool);
-  return svn_txdelta_send_txstream (txstream, handler, handler_baton, pool);
+  char *buf = apr_palloc (pool, SVN_STREAM_CHUNK_SIZE);
+
+  /* There is no source to delta against, so there is nothing for a
+     diff algorithm to find; just read the stream and wrap each chunk
+     in a window holding a single `new' op, the same way
+     svn_txdelta_send_string does.  This is one big sequential read
+     per window, where cranking up the delta machinery would buffer
+     and scan every byte to rediscover the obvious. */
+  while (1)
+    {
+      apr_size_t len = SVN_STREAM_CHUNK_SIZE;
+      svn_txdelta_window_t window = { 0 };
+      svn_txdelta_op_t op;
+      svn_string_t data;
+
+      SVN_ERR (svn_stream_read (stream, buf, &len));
+      if (len == 0)
+        break;
+
+      data.data = buf;
+      data.len = len;
+
+      op.action_code = svn_txdelta_new;
+      op.offset = 0;
+      op.length = len;
+
+      window.tview_len = len;
+      window.num_ops = 1;
+      window.ops = &op;
+      window.new_data = &data;
+
+      SVN_ERR ((*handler) (&window, handler_baton));
+
+      if (len < SVN_STREAM_CHUNK_SIZE)
+        break;
+    }
+
+  /* Push a NULL at the handler, because we're done. */
+  SVN_ERR ((*handler) (NULL, handler_baton));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *svn_txdelta_send_txstream (svn_txdelta_stream_t *txstream,
@@ -536,20 +1017,21 @@ svn_error_t *svn_txdelta_send_txstream (svn_txdelta_stream_t *txstream,
                                         void *handler_baton,
                                         apr_pool_t *pool)
 {
-  svn_txdelta_window_t *window;
+  svn_txdelta_window_t *window = NULL;
 
-  /* create a pool just for the windows */
+  /* create a pool just for the windows' scratch data */
   apr_pool_t *wpool = svn_pool_create (pool);
 
   do
     {
-      /* read in a single delta window */
-      SVN_ERR( svn_txdelta_next_window (&window, txstream, wpool));
+      /* read in a single delta window, recycling the last one's storage */
+      SVN_ERR( svn_txdelta_next_window_reuse (&window, window, txstream,
+                                              wpool));
 
       /* shove it at the handler */
       SVN_ERR( (*handler)(window, handler_baton));
 
-      /* free the window (if any) */
+      /* free the scratch data (the window itself is recycled) */
       svn_pool_clear (wpool);
     }
   while (window != NULL);
@@ -0,0 +1,625 @@
+/*
+ * vcdiff.c -- parse vcdiff-format deltas into txdelta windows
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+#include <string.h>
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "delta.h"
+
+/* Vendor drops often arrive as vcdiff patch sets (the format of
+   xdelta and friends; see notes/old/draft-korn-vcdiff-01.txt).
+   Expanding them to fulltext just to import them throws away the
+   delta the vendor already computed, so this file translates vcdiff
+   windows into svn_txdelta_window_t's on the fly, in the same push
+   style as svn_txdelta_parse_svndiff: write vcdiff bytes into the
+   stream, windows come out of the handler.
+
+   The two formats map onto each other well.  A vcdiff window's
+   source segment becomes the txdelta source view; COPY instructions
+   whose addresses fall in the source segment become source ops,
+   those addressing the target-so-far become target ops, ADDs become
+   new-data ops, and a RUN becomes one byte of new data plus a
+   self-overlapping target copy (which replicates, in both formats).
+   Conveniently, vcdiff's variable-length integers are bit-for-bit
+   the svndiff encoding, so the decoder is shared.
+
+   Three vcdiff features have no txdelta equivalent and are rejected
+   as SVN_ERR_VCDIFF_UNSUPPORTED rather than half-handled: secondary
+   compressors, application-defined code tables, and windows that
+   copy from earlier *target* windows (VCD_TARGET) -- a txdelta
+   source view can only look at the source file.  Encoders working
+   from a source file, which is the vendor-drop case, don't produce
+   any of these.  */
+
+
+/* Header indicator bits. */
+#define VCD_DECOMPRESS 0x01
+#define VCD_CODETABLE  0x02
+
+/* Window indicator bits. */
+#define VCD_SOURCE 0x01
+#define VCD_TARGET 0x02
+
+/* Instruction types. */
+#define VCD_NOOP 0
+#define VCD_ADD  1
+#define VCD_RUN  2
+#define VCD_COPY 3
+
+/* Address cache geometry of the default code table. */
+#define VCD_NEAR_SLOTS 4
+#define VCD_SAME_SLOTS 3
+
+/* The leading magic -- "VCD" with high bits set -- plus a version
+   byte and the header indicator.  */
+#define VCD_HEADER_SIZE 5
+
+
+/* One half of a code table entry: an instruction type, its size (0
+   meaning "size follows as an integer in the instruction section"),
+   and, for COPY, its address mode.  */
+struct vcdiff_inst
+{
+  unsigned char type;
+  unsigned char size;
+  unsigned char mode;
+};
+
+/* The default code table: each instruction byte names up to two
+   packed instructions.  Built on first use by build_code_table;
+   writing the same values twice is harmless, so no lock is needed.  */
+static struct vcdiff_inst code_table[256][2];
+static svn_boolean_t code_table_built = FALSE;
+
+
+/* Fill in the default code table, as laid out in the vcdiff draft:
+   one RUN, the ADDs, sixteen COPYs per address mode, then the
+   ADD+COPY and COPY+ADD pairs.  */
+static void
+build_code_table (void)
+{
+  int i = 0;
+  int mode, size, asize;
+
+  code_table[i][0].type = VCD_RUN;
+  code_table[i][0].size = 0;
+  i++;
+
+  for (size = 0; size <= 17; size++, i++)
+    {
+      code_table[i][0].type = VCD_ADD;
+      code_table[i][0].size = size;
+    }
+
+  for (mode = 0; mode < 2 + VCD_NEAR_SLOTS + VCD_SAME_SLOTS; mode++)
+    for (size = 0; size <= 18; size++)
+      {
+        if (size != 0 && size < 4)
+          continue;
+        code_table[i][0].type = VCD_COPY;
+        code_table[i][0].size = size;
+        code_table[i][0].mode = mode;
+        i++;
+      }
+
+  for (mode = 0; mode < 6; mode++)
+    for (asize = 1; asize <= 4; asize++)
+      for (size = 4; size <= 6; size++)
+        {
+          code_table[i][0].type = VCD_ADD;
+          code_table[i][0].size = asize;
+          code_table[i][1].type = VCD_COPY;
+          code_table[i][1].size = size;
+          code_table[i][1].mode = mode;
+          i++;
+        }
+
+  for (mode = 6; mode < 2 + VCD_NEAR_SLOTS + VCD_SAME_SLOTS; mode++)
+    for (asize = 1; asize <= 4; asize++)
+      {
+        code_table[i][0].type = VCD_ADD;
+        code_table[i][0].size = asize;
+        code_table[i][1].type = VCD_COPY;
+        code_table[i][1].size = 4;
+        code_table[i][1].mode = mode;
+        i++;
+      }
+
+  for (mode = 0; mode < 2 + VCD_NEAR_SLOTS + VCD_SAME_SLOTS; mode++)
+    {
+      code_table[i][0].type = VCD_COPY;
+      code_table[i][0].size = 4;
+      code_table[i][0].mode = mode;
+      code_table[i][1].type = VCD_ADD;
+      code_table[i][1].size = 1;
+      i++;
+    }
+
+  assert (i == 256);
+  code_table_built = TRUE;
+}
+
+
+struct vcdiff_baton
+{
+  /* Where the resulting windows go. */
+  svn_txdelta_window_handler_t consumer_func;
+  void *consumer_baton;
+
+  /* Pool the decoder lives in, and a scratch subpool which is
+     cleared after each window has been decoded and consumed.  */
+  apr_pool_t *pool;
+  apr_pool_t *subpool;
+
+  /* Leftover vcdiff data from a previous write: at most the partial
+     window we are still waiting to complete.  */
+  svn_stringbuf_t *buffer;
+
+  /* How many of the VCD_HEADER_SIZE header bytes we have seen.  */
+  int header_bytes;
+
+  /* Do we want an error when the stream is closed mid-window?  */
+  svn_boolean_t error_on_early_close;
+};
+
+
+/* The state needed to turn one window's COPY addresses into absolute
+   addresses: the near and same caches, reinitialized per window.  */
+struct addr_caches
+{
+  apr_off_t near_cache[VCD_NEAR_SLOTS];
+  apr_off_t same_cache[VCD_SAME_SLOTS * 256];
+  int next_slot;
+};
+
+
+/* Decode one COPY address of mode MODE from the range [*AP..AEND-1],
+   advancing *AP past it.  HERE is the current position in the
+   window's address space (source segment followed by target so far).
+   Update CACHES as the draft specifies.  Return -1 on underrun or a
+   nonsense address.  */
+static apr_off_t
+decode_address (const unsigned char **ap,
+                const unsigned char *aend,
+                int mode,
+                apr_off_t here,
+                struct addr_caches *caches)
+{
+  apr_off_t addr, val;
+
+  if (mode == 0)  /* SELF */
+    {
+      *ap = svn_delta__decode_int (&val, *ap, aend);
+      if (*ap == NULL)
+        return -1;
+      addr = val;
+    }
+  else if (mode == 1)  /* HERE */
+    {
+      *ap = svn_delta__decode_int (&val, *ap, aend);
+      if (*ap == NULL)
+        return -1;
+      addr = here - val;
+    }
+  else if (mode < 2 + VCD_NEAR_SLOTS)  /* NEAR */
+    {
+      *ap = svn_delta__decode_int (&val, *ap, aend);
+      if (*ap == NULL)
+        return -1;
+      addr = caches->near_cache[mode - 2] + val;
+    }
+  else  /* SAME: a single byte indexes the cache */
+    {
+      if (*ap == aend)
+        return -1;
+      addr = caches->same_cache[(mode - 2 - VCD_NEAR_SLOTS) * 256
+                                + **ap];
+      (*ap)++;
+    }
+
+  if (addr < 0 || addr >= here)
+    return -1;
+
+  caches->near_cache[caches->next_slot] = addr;
+  caches->next_slot = (caches->next_slot + 1) % VCD_NEAR_SLOTS;
+  caches->same_cache[addr % (VCD_SAME_SLOTS * 256)] = addr;
+
+  return addr;
+}
+
+
+/* Decode one window of vcdiff data from the range [P..END-1] and
+   send it to DB's consumer.  Set *CONSUMED to the number of bytes
+   the window occupied on the wire, or to zero if the range does not
+   yet hold a complete window.  Scratch allocations happen in
+   DB->subpool, which the caller clears between windows.  */
+static svn_error_t *
+decode_window (apr_size_t *consumed,
+               struct vcdiff_baton *db,
+               const unsigned char *p,
+               const unsigned char *end)
+{
+  const unsigned char *start = p;
+  const unsigned char *data, *dend, *ip, *iend, *ap, *aend;
+  apr_off_t val, source_len, source_pos, delta_len, target_len;
+  apr_off_t data_len, inst_len, addr_len;
+  apr_size_t tpos, npos;
+  int win_ind, delta_ind;
+  struct addr_caches *caches;
+  apr_array_header_t *ops;
+  svn_stringbuf_t *new_data;
+  svn_txdelta_window_t window = { 0 };
+  svn_string_t new_string;
+
+  *consumed = 0;
+
+  if (p == end)
+    return SVN_NO_ERROR;
+  win_ind = *p++;
+
+  if (win_ind & VCD_TARGET)
+    return svn_error_create (SVN_ERR_VCDIFF_UNSUPPORTED, 0, NULL, db->pool,
+                             "vcdiff window copies from earlier target "
+                             "windows");
+
+  source_len = 0;
+  source_pos = 0;
+  if (win_ind & VCD_SOURCE)
+    {
+      p = svn_delta__decode_int (&source_len, p, end);
+      if (p == NULL)
+        return SVN_NO_ERROR;
+      p = svn_delta__decode_int (&source_pos, p, end);
+      if (p == NULL)
+        return SVN_NO_ERROR;
+    }
+
+  /* The delta encoding length covers everything that follows it in
+     the window, so one check tells us whether the window is all
+     here.  */
+  p = svn_delta__decode_int (&delta_len, p, end);
+  if (p == NULL)
+    return SVN_NO_ERROR;
+  if (delta_len < 0)
+    return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW, 0, NULL,
+                             db->pool,
+                             "vcdiff contains corrupt window header");
+  if ((apr_size_t) (end - p) < (apr_size_t) delta_len)
+    return SVN_NO_ERROR;
+  end = p + delta_len;
+
+  p = svn_delta__decode_int (&target_len, p, end);
+  if (p == NULL || p == end)
+    return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW, 0, NULL,
+                             db->pool,
+                             "vcdiff contains corrupt window header");
+  delta_ind = *p++;
+  if (delta_ind != 0)
+    return svn_error_create (SVN_ERR_VCDIFF_UNSUPPORTED, 0, NULL, db->pool,
+                             "vcdiff window uses a secondary compressor");
+
+  p = svn_delta__decode_int (&data_len, p, end);
+  if (p)
+    p = svn_delta__decode_int (&inst_len, p, end);
+  if (p)
+    p = svn_delta__decode_int (&addr_len, p, end);
+  if (p == NULL
+      || data_len < 0 || inst_len < 0 || addr_len < 0
+      || data_len + inst_len + addr_len != end - p)
+    return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW, 0, NULL,
+                             db->pool,
+                             "vcdiff contains corrupt window header");
+
+  data = p;
+  dend = data + data_len;
+  ip = dend;
+  iend = ip + inst_len;
+  ap = iend;
+  aend = ap + addr_len;
+
+  /* Walk the instructions, building up the op list and new data.  */
+  caches = apr_pcalloc (db->subpool, sizeof (*caches));
+  ops = apr_array_make (db->subpool, 16, sizeof (svn_txdelta_op_t));
+  new_data = svn_stringbuf_create ("", db->subpool);
+  tpos = 0;
+  npos = 0;
+
+  while (ip < iend)
+    {
+      int byte = *ip++;
+      int half;
+
+      for (half = 0; half < 2; half++)
+        {
+          const struct vcdiff_inst *inst = &code_table[byte][half];
+          apr_off_t size = inst->size;
+          svn_txdelta_op_t *op;
+
+          if (inst->type == VCD_NOOP)
+            continue;
+
+          if (size == 0)
+            {
+              ip = (const unsigned char *)
+                svn_delta__decode_int (&size, ip, iend);
+              if (ip == NULL || size <= 0)
+                return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW,
+                                         0, NULL, db->pool,
+                                         "vcdiff contains corrupt "
+                                         "instruction");
+            }
+
+          if (inst->type == VCD_ADD)
+            {
+              if (dend - data < size)
+                return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW,
+                                         0, NULL, db->pool,
+                                         "vcdiff data section overrun");
+              svn_stringbuf_appendbytes (new_data,
+                                         (const char *) data, size);
+              data += size;
+
+              op = apr_array_push (ops);
+              op->action_code = svn_txdelta_new;
+              op->offset = npos;
+              op->length = size;
+              npos += size;
+              tpos += size;
+            }
+          else if (inst->type == VCD_RUN)
+            {
+              /* One byte of new data; the rest is a self-overlapping
+                 target copy, which replicates in txdelta exactly as
+                 a RUN does in vcdiff.  */
+              if (data == dend)
+                return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW,
+                                         0, NULL, db->pool,
+                                         "vcdiff data section overrun");
+              svn_stringbuf_appendbytes (new_data,
+                                         (const char *) data, 1);
+              data++;
+
+              op = apr_array_push (ops);
+              op->action_code = svn_txdelta_new;
+              op->offset = npos;
+              op->length = 1;
+              npos++;
+              tpos++;
+
+              if (size > 1)
+                {
+                  op = apr_array_push (ops);
+                  op->action_code = svn_txdelta_target;
+                  op->offset = tpos - 1;
+                  op->length = size - 1;
+                  tpos += size - 1;
+                }
+            }
+          else  /* VCD_COPY */
+            {
+              apr_off_t here = source_len + tpos;
+              apr_off_t addr = decode_address (&ap, aend, inst->mode,
+                                               here, caches);
+
+              if (addr < 0)
+                return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW,
+                                         0, NULL, db->pool,
+                                         "vcdiff contains corrupt "
+                                         "copy address");
+
+              if (addr < source_len)
+                {
+                  /* From the source segment -- and possibly running
+                     past its end into the target, in which case the
+                     tail continues as a target copy from position
+                     zero.  */
+                  apr_off_t src_part = size;
+
+                  if (src_part > source_len - addr)
+                    src_part = source_len - addr;
+
+                  op = apr_array_push (ops);
+                  op->action_code = svn_txdelta_source;
+                  op->offset = addr;
+                  op->length = src_part;
+                  tpos += src_part;
+
+                  if (size > src_part)
+                    {
+                      op = apr_array_push (ops);
+                      op->action_code = svn_txdelta_target;
+                      op->offset = 0;
+                      op->length = size - src_part;
+                      tpos += size - src_part;
+                    }
+                }
+              else
+                {
+                  op = apr_array_push (ops);
+                  op->action_code = svn_txdelta_target;
+                  op->offset = addr - source_len;
+                  op->length = size;
+                  tpos += size;
+                }
+            }
+        }
+    }
+
+  if (data != dend || ap != aend || tpos != (apr_size_t) target_len)
+    return svn_error_create (SVN_ERR_VCDIFF_CORRUPT_WINDOW, 0, NULL,
+                             db->pool,
+                             "vcdiff window does not reconstruct its "
+                             "declared target length");
+
+  window.sview_offset = source_pos;
+  window.sview_len = source_len;
+  window.tview_len = target_len;
+  window.num_ops = ops->nelts;
+  window.ops = (svn_txdelta_op_t *) ops->elts;
+  new_string.data = new_data->data;
+  new_string.len = new_data->len;
+  window.new_data = &new_string;
+
+  SVN_ERR (db->consumer_func (&window, db->consumer_baton));
+
+  *consumed = end - start;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+write_handler (void *baton,
+               const char *buffer,
+               apr_size_t *len)
+{
+  struct vcdiff_baton *db = (struct vcdiff_baton *) baton;
+  const unsigned char *p, *end;
+  apr_size_t consumed;
+
+  /* Chew up the header: three magic bytes, a version, and the header
+     indicator, whose feature bits we don't support.  */
+  if (db->header_bytes < VCD_HEADER_SIZE)
+    {
+      static const unsigned char magic[] = { 0xd6, 0xc3, 0xc4, 0x00 };
+      apr_size_t nheader = VCD_HEADER_SIZE - db->header_bytes;
+      apr_size_t i;
+
+      if (nheader > *len)
+        nheader = *len;
+      for (i = 0; i < nheader; i++)
+        {
+          int idx = db->header_bytes + i;
+          unsigned char c = (unsigned char) buffer[i];
+
+          if (idx < 4)
+            {
+              if (c != magic[idx])
+                return svn_error_create (SVN_ERR_VCDIFF_INVALID_HEADER,
+                                         0, NULL, db->pool,
+                                         "vcdiff has invalid header");
+            }
+          else if (c & (VCD_DECOMPRESS | VCD_CODETABLE))
+            return svn_error_create (SVN_ERR_VCDIFF_UNSUPPORTED,
+                                     0, NULL, db->pool,
+                                     "vcdiff uses a secondary compressor "
+                                     "or custom code table");
+        }
+      *len -= nheader;
+      buffer += nheader;
+      db->header_bytes += nheader;
+    }
+
+  p = (const unsigned char *) buffer;
+  end = p + *len;
+
+  /* If no partial window is left over from an earlier write, decode
+     windows straight out of the caller's buffer; nothing gets copied
+     until we run into a window that is still incomplete.  */
+  if (db->buffer->len == 0)
+    {
+      while (p < end)
+        {
+          SVN_ERR (decode_window (&consumed, db, p, end));
+          if (consumed == 0)
+            break;
+          p += consumed;
+          svn_pool_clear (db->subpool);
+        }
+
+      svn_stringbuf_appendbytes (db->buffer, (const char *) p, end - p);
+      return SVN_NO_ERROR;
+    }
+
+  /* Otherwise, append the new data to the pending window and decode
+     from the concatenation.  */
+  svn_stringbuf_appendbytes (db->buffer, (const char *) p, end - p);
+
+  while (db->buffer->len > 0)
+    {
+      SVN_ERR (decode_window (&consumed, db,
+                              (const unsigned char *) db->buffer->data,
+                              ((const unsigned char *) db->buffer->data
+                               + db->buffer->len)));
+      if (consumed == 0)
+        break;
+
+      memmove (db->buffer->data, db->buffer->data + consumed,
+               db->buffer->len - consumed);
+      db->buffer->len -= consumed;
+      svn_pool_clear (db->subpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+close_handler (void *baton)
+{
+  struct vcdiff_baton *db = (struct vcdiff_baton *) baton;
+  svn_error_t *err;
+
+  if ((db->error_on_early_close)
+      && (db->header_bytes < VCD_HEADER_SIZE || db->buffer->len != 0))
+    return svn_error_create (SVN_ERR_VCDIFF_UNEXPECTED_END, 0, NULL,
+                             db->pool,
+                             "unexpected end of vcdiff input");
+
+  /* Tell the window consumer that we're done, and clean up.  */
+  err = db->consumer_func (NULL, db->consumer_baton);
+  svn_pool_destroy (db->pool);
+  return err;
+}
+
+
+svn_stream_t *
+svn_txdelta_parse_vcdiff (svn_txdelta_window_handler_t handler,
+                          void *handler_baton,
+                          svn_boolean_t error_on_early_close,
+                          apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create (pool);
+  struct vcdiff_baton *db = apr_palloc (pool, sizeof (*db));
+  svn_stream_t *stream;
+
+  if (! code_table_built)
+    build_code_table ();
+
+  db->consumer_func = handler;
+  db->consumer_baton = handler_baton;
+  db->pool = subpool;
+  db->subpool = svn_pool_create (subpool);
+  db->buffer = svn_stringbuf_create ("", subpool);
+  db->header_bytes = 0;
+  db->error_on_early_close = error_on_early_close;
+  stream = svn_stream_create (db, pool);
+  svn_stream_set_write (stream, write_handler);
+  svn_stream_set_close (stream, close_handler);
+  return stream;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -66,24 +66,76 @@ typedef struct hash_table_t {
 } hash_table_t;
 
 
+/* A reusable arena for hash tables.  Holds the table and its two
+   arrays across windows, along with their allocated capacities, so a
+   long-running delta stream performs the big allocations only when a
+   window outgrows every previous one.  */
+struct svn_txdelta__vdelta_arena_t {
+  apr_pool_t *pool;             /* Pool the arrays are grown from. */
+  hash_table_t table;
+  apr_size_t buckets_size;      /* Allocated bucket array capacity. */
+  apr_size_t slots_size;        /* Allocated slots array capacity. */
+};
+
+
+svn_txdelta__vdelta_arena_t *
+svn_txdelta__vdelta_arena_create (apr_pool_t *pool)
+{
+  svn_txdelta__vdelta_arena_t *arena = apr_palloc (pool, sizeof (*arena));
+
+  arena->pool = pool;
+  arena->buckets_size = 0;
+  arena->slots_size = 0;
+  return arena;
+}
+
+
 /* Create a hash table with NUM_SLOTS slots. NUM_SLOTS should be the sum
    of the size of the source and target parts of the delta window.
-   Allocate from POOL. */
+   Take the arrays from ARENA if it is non-null (growing them there
+   as needed), else allocate them from POOL. */
 static hash_table_t *
-create_hash_table (apr_size_t num_slots, apr_pool_t *pool)
+create_hash_table (apr_size_t num_slots,
+                   svn_txdelta__vdelta_arena_t *arena,
+                   apr_pool_t *pool)
 {
   int i;
   apr_size_t j;
-  hash_table_t* table = apr_palloc (pool, sizeof (*table));
+  hash_table_t* table;
+  apr_size_t num_buckets = (num_slots / 3) | 1;
+
+  if (arena == NULL)
+    {
+      table = apr_palloc (pool, sizeof (*table));
+      table->buckets = apr_palloc (pool,
+                                   num_buckets * sizeof (*table->buckets));
+      table->slots = apr_palloc (pool, num_slots * sizeof (*table->slots));
+    }
+  else
+    {
+      /* Reuse the arena's arrays, growing them if this window is
+         bigger than anything we've seen before.  A grown array
+         orphans its predecessor in the arena pool, but the window
+         size is bounded, so this converges after a few windows.  */
+      table = &arena->table;
+      if (arena->buckets_size < num_buckets)
+        {
+          arena->buckets_size = num_buckets;
+          table->buckets = apr_palloc (arena->pool,
+                                       num_buckets
+                                       * sizeof (*table->buckets));
+        }
+      if (arena->slots_size < num_slots)
+        {
+          arena->slots_size = num_slots;
+          table->slots = apr_palloc (arena->pool,
+                                     num_slots * sizeof (*table->slots));
+        }
+    }
 
-  /* This should be a reasonable number of buckets ... */
-  table->num_buckets = (num_slots / 3) | 1;
-  table->buckets = apr_palloc (pool, (table->num_buckets
-                                      * sizeof (*table->buckets)));
+  table->num_buckets = num_buckets;
   for (i = 0; i < table->num_buckets; ++i)
     table->buckets[i] = NULL;
-
-  table->slots = apr_palloc (pool, num_slots * sizeof (*table->slots));
   for (j = 0; j < num_slots; ++j)
     table->slots[j].next = NULL;
 
@@ -169,19 +221,50 @@ store_mapping (hash_table_t *table, const char* key, apr_off_t idx)
    -boundary copies. */
 
 
+/* Return the length of the longest common prefix of A and B, looking
+   at no more than MAX bytes.  When both pointers are misaligned by
+   the same amount we step up to a word boundary bytewise and then
+   compare whole machine words, which is where all the time goes when
+   extending long copies over binary data.  */
+apr_size_t
+svn_txdelta__match_length (const char *a, const char *b, apr_size_t max)
+{
+  const char *a_start = a;
+  const char *a_end = a + max;
+
+  if ((((unsigned long) a ^ (unsigned long) b) & (sizeof (long) - 1)) == 0)
+    {
+      while (a < a_end && ((unsigned long) a & (sizeof (long) - 1)) != 0)
+        {
+          if (*a != *b)
+            return a - a_start;
+          ++a;
+          ++b;
+        }
+      while (a + sizeof (long) <= a_end
+             && *(const long *) a == *(const long *) b)
+        {
+          a += sizeof (long);
+          b += sizeof (long);
+        }
+    }
+
+  while (a < a_end && *a == *b)
+    {
+      ++a;
+      ++b;
+    }
+  return a - a_start;
+}
+
+
 /* Find the length of a match within the data window.
    Note that (match < from && from <= end) must always be true here. */
 
 static APR_INLINE int
 find_match_len (const char *match, const char *from, const char *end)
 {
-  const char *here = from;
-  while (here < end && *match == *here)
-    {
-      ++match;
-      ++here;
-    }
-  return here - from;
+  return svn_txdelta__match_length (match, from, end - from);
 }
 
 
@@ -308,9 +391,11 @@ svn_txdelta__vdelta (struct build_ops_baton_t *build_baton,
                      const char *data,
                      apr_size_t source_len,
                      apr_size_t target_len,
+                     svn_txdelta__vdelta_arena_t *arena,
                      apr_pool_t *pool)
 {
-  hash_table_t *table = create_hash_table (source_len + target_len, pool);
+  hash_table_t *table = create_hash_table (source_len + target_len,
+                                           arena, pool);
 
   vdelta (build_baton, data, data, data + source_len, FALSE, table, pool);
   vdelta (build_baton, data, data + source_len, data + source_len + target_len,
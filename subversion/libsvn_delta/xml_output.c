@@ -44,6 +44,90 @@
 
 
 
+/* ==================================================================== */
+/* Buffered output.
+
+   The serializer below emits each tag as its own little write: a
+   commit over the network turns into thousands of writes of a few
+   dozen bytes apiece.  Rather than teach every function here to
+   batch, we wrap the caller's stream in a gather buffer and flush it
+   in large sequential chunks.  Writes bigger than the buffer (long
+   runs of svndiff data, say) bypass it entirely after a flush, so
+   the data always reaches the real stream in order.  */
+
+/* How much output to gather before writing through.  */
+#define XML_OUTPUT_BUFSIZE SVN_STREAM_CHUNK_SIZE
+
+struct buffered_baton
+{
+  svn_stream_t *real_output;    /* Where flushed data goes. */
+  char *buf;                    /* Gather buffer. */
+  apr_size_t used;              /* Bytes of BUF in use. */
+};
+
+
+/* Write out whatever is sitting in BB's buffer.  */
+static svn_error_t *
+buffered_flush (struct buffered_baton *bb)
+{
+  if (bb->used > 0)
+    {
+      apr_size_t len = bb->used;
+      bb->used = 0;
+      SVN_ERR (svn_stream_write (bb->real_output, bb->buf, &len));
+    }
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+buffered_write (void *baton, const char *data, apr_size_t *len)
+{
+  struct buffered_baton *bb = baton;
+
+  if (bb->used + *len > XML_OUTPUT_BUFSIZE)
+    SVN_ERR (buffered_flush (bb));
+
+  if (*len > XML_OUTPUT_BUFSIZE)
+    return svn_stream_write (bb->real_output, data, len);
+
+  memcpy (bb->buf + bb->used, data, *len);
+  bb->used += *len;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+buffered_close (void *baton)
+{
+  struct buffered_baton *bb = baton;
+
+  SVN_ERR (buffered_flush (bb));
+  return svn_stream_close (bb->real_output);
+}
+
+
+/* Return a stream which gathers writes into big chunks before
+   passing them to REAL_OUTPUT.  Closing the returned stream flushes
+   it and closes REAL_OUTPUT.  */
+static svn_stream_t *
+buffered_output_stream (svn_stream_t *real_output, apr_pool_t *pool)
+{
+  struct buffered_baton *bb = apr_palloc (pool, sizeof (*bb));
+  svn_stream_t *stream;
+
+  bb->real_output = real_output;
+  bb->buf = apr_palloc (pool, XML_OUTPUT_BUFSIZE);
+  bb->used = 0;
+
+  stream = svn_stream_create (bb, pool);
+  svn_stream_set_write (stream, buffered_write);
+  svn_stream_set_close (stream, buffered_close);
+  return stream;
+}
+
+
+
 /* The types of some of the elements we output.  The actual range of
    valid values is always narrower than the full set, but they
    overlap, so it doesn't quite make sense to have a separate
@@ -676,7 +760,7 @@ svn_delta_get_xml_editor (svn_stream_t *output,
   /* Construct an edit baton. */
   eb = apr_palloc (subpool, sizeof (*eb));
   eb->pool = subpool;
-  eb->output = output;
+  eb->output = buffered_output_stream (output, subpool);
   eb->curfile = NULL;
   eb->txdelta_id_counter = 1;
   eb->target_revision = SVN_INVALID_REVNUM;
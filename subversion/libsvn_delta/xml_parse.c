@@ -1504,6 +1504,12 @@ svn_delta_xml_parsebytes (const char *buffer, apr_size_t len, int isFinal,
 
 
 
+/* Ceiling on the read size used by svn_delta_xml_auto_parse below.
+   The pump starts at BUFSIZ and doubles whenever the source keeps its
+   buffer completely full, so a fast pipe is drained in a few large
+   reads while a trickling one never ties up more than a page. */
+#define SVN_DELTA__PARSE_CHUNK_MAX (64 * 1024)
+
 svn_error_t *
 svn_delta_xml_auto_parse (svn_stream_t *source,
                           const svn_delta_edit_fns_t *editor,
@@ -1512,7 +1518,7 @@ svn_delta_xml_auto_parse (svn_stream_t *source,
                           svn_revnum_t base_revision,
                           apr_pool_t *pool)
 {
-  char buf[BUFSIZ];
+  apr_size_t chunk_size = BUFSIZ;
   apr_size_t len;
   int done;
   svn_error_t *err;
@@ -1528,12 +1534,20 @@ svn_delta_xml_auto_parse (svn_stream_t *source,
   if (err)
     return err;
 
-  /* Repeatedly pull data from SOURCE and feed it to the parser,
-     until there's no more data (or we get an error). */
-  
+  /* Repeatedly pull data from SOURCE and feed it to the parser, until
+     there's no more data (or we get an error).  We read straight into
+     expat's own buffer, which spares a copy of every byte that passes
+     through here. */
+
   do {
-    /* Read BUFSIZ bytes into buf using the supplied read function. */
-    len = BUFSIZ;
+    char *buf = svn_xml_get_parse_buffer (delta_parser->svn_parser,
+                                          chunk_size);
+    if (buf == NULL)
+      return svn_error_create (APR_ENOMEM, 0, NULL, pool,
+                               "svn_delta_parse: can't get parse buffer");
+
+    /* Read CHUNK_SIZE bytes into buf using the supplied read function. */
+    len = chunk_size;
     err = svn_stream_read (source, buf, &len);
     if (err)
       return svn_error_quick_wrap (err, "svn_delta_parse: can't read source");
@@ -1541,13 +1555,25 @@ svn_delta_xml_auto_parse (svn_stream_t *source,
     /* We're done if the source stream returned zero bytes read. */
     done = (len == 0);
 
-    /* Push these bytes at the parser */
-    err = svn_delta_xml_parsebytes (buf, len, done, delta_parser);
+    /* Parse the bytes in place */
+    err = svn_xml_parse_buffer (delta_parser->svn_parser, len, done);
     if (err)
       return err;
 
+    /* The source filled everything we offered it; offer more next
+       time around. */
+    if (len == chunk_size && chunk_size < SVN_DELTA__PARSE_CHUNK_MAX)
+      chunk_size *= 2;
+
   } while (! done);
 
+  /* Call `close_edit', just as svn_delta_xml_parsebytes() does on its
+     final push. */
+  err = delta_parser->digger->editor->close_edit
+    (delta_parser->digger->edit_baton);
+  if (err)
+    return err;
+
   svn_delta_free_xml_parser (delta_parser);
   return SVN_NO_ERROR;
 }
@@ -0,0 +1,441 @@
+/* changes-table.c : operations on the `changes' table
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include "apr_strings.h"
+#include "apr_hash.h"
+#include "db.h"
+#include "svn_fs.h"
+#include "fs.h"
+#include "err.h"
+#include "dbt.h"
+#include "trail.h"
+#include "skel.h"
+#include "changes-table.h"
+
+
+/*** Creating and opening the changes table. ***/
+
+int
+svn_fs__open_changes_table (DB **changes_p,
+                            DB_ENV *env,
+                            int create)
+{
+  DB *changes;
+
+  DB_ERR (db_create (&changes, env, 0));
+
+  /* A transaction (or revision) stores one record per changed path,
+     so we allow duplicate keys; appending a record is then a single
+     put, no matter how many changes the key already has.  */
+  DB_ERR (changes->set_flags (changes, DB_DUP));
+
+  /* Even when just opening, pass DB_CREATE: this table was added
+     after the others, and filesystems created before then don't have
+     one.  Creating an empty table on the fly gives them a
+     changed-paths index that reads as "not yet built".  */
+  DB_ERR (changes->open (changes, "changes", 0, DB_BTREE,
+                         create ? (DB_CREATE | DB_EXCL) : DB_CREATE,
+                         0666));
+
+  *changes_p = changes;
+  return 0;
+}
+
+
+
+/*** Keys. ***/
+
+const char *
+svn_fs__changes_rev_key (svn_revnum_t rev, apr_pool_t *pool)
+{
+  /* The `-' keeps this out of the namespace of transaction ids, which
+     are generated over the alphabet [0-9a-z].  */
+  return apr_psprintf (pool, "r-%ld", (long) rev);
+}
+
+
+
+/*** Storing and retrieving changes.  ***/
+
+svn_error_t *
+svn_fs__changes_add (svn_fs_t *fs,
+                     const char *key,
+                     const char *path,
+                     const char *kind,
+                     trail_t *trail)
+{
+  DBT query, value;
+  skel_t *change;
+
+  /* Build a CHANGE skel: ("change" PATH KIND).  */
+  change = svn_fs__make_empty_list (trail->pool);
+  svn_fs__prepend (svn_fs__str_atom (kind, trail->pool), change);
+  svn_fs__prepend (svn_fs__str_atom (path, trail->pool), change);
+  svn_fs__prepend (svn_fs__str_atom ("change", trail->pool), change);
+
+  /* The table allows duplicates, so this appends one more record
+     under KEY.  */
+  SVN_FS__COUNT (fs, db_puts);
+  SVN_ERR (DB_WRAP (fs, "recording change",
+                    fs->changes->put
+                    (fs->changes, trail->db_txn,
+                     svn_fs__str_to_dbt (&query, (char *) key),
+                     svn_fs__skel_to_dbt (&value, change, trail->pool), 0)));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return PATH with a leading slash, allocating in POOL if one must be
+   added.  Change records store paths as the editor layers supplied
+   them; readers expect repository-absolute paths.  */
+static const char *
+rooted_path (const char *path, apr_pool_t *pool)
+{
+  if (path[0] == '/')
+    return path;
+  return apr_pstrcat (pool, "/", path, NULL);
+}
+
+
+/* Fold one change of kind ACTION --- 'A', 'D', or 'R' --- to PATH
+   into CHANGES, collapsing it with whatever net effect is already
+   recorded there for PATH.  */
+static void
+fold_change (apr_hash_t *changes,
+             const char *path,
+             char action,
+             apr_pool_t *pool)
+{
+  void *prev = apr_hash_get (changes, path, APR_HASH_KEY_STRING);
+
+  if (prev)
+    {
+      char prev_action = (char) ((int) prev);
+
+      if (prev_action == 'A' && action == 'D')
+        {
+          /* Added and then deleted within the same change set: the
+             path never really appeared.  */
+          apr_hash_set (changes, path, APR_HASH_KEY_STRING, NULL);
+          return;
+        }
+      else if (prev_action == 'A')
+        /* Modifying something just added is still just an add.  */
+        action = 'A';
+      else if (prev_action == 'D' && action == 'A')
+        /* Deleted and re-added: the path was replaced.  */
+        action = 'R';
+    }
+
+  apr_hash_set (changes, apr_pstrdup (pool, path), APR_HASH_KEY_STRING,
+                (void *) ((int) action));
+}
+
+
+svn_error_t *
+svn_fs__changes_fetch (apr_hash_t **changes_p,
+                       svn_fs_t *fs,
+                       const char *key,
+                       trail_t *trail)
+{
+  DBC *cursor;
+  DBT query, value;
+  int db_err;
+  apr_hash_t *changes;
+
+  SVN_FS__COUNT (fs, db_cursor_ops);
+  SVN_ERR (DB_WRAP (fs, "creating cursor for reading changes",
+                    fs->changes->cursor (fs->changes, trail->db_txn,
+                                         &cursor, 0)));
+
+  /* Position the cursor at the first record for KEY.  */
+  svn_fs__str_to_dbt (&query, (char *) key);
+  do
+    {
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor, &query,
+                              svn_fs__result_dbt_reuse (&value, trail),
+                              DB_SET);
+    }
+  while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+
+  if (db_err == DB_NOTFOUND)
+    {
+      /* Nothing recorded under KEY.  We can't tell an empty change
+         list from a record that was never made, so don't pretend.  */
+      cursor->c_close (cursor);
+      *changes_p = 0;
+      return SVN_NO_ERROR;
+    }
+
+  changes = apr_hash_make (trail->pool);
+
+  while (! db_err)
+    {
+      skel_t *change = svn_fs__parse_skel (value.data, value.size,
+                                           trail->pool);
+      skel_t *path_skel, *kind_skel;
+      const char *path;
+      char action;
+
+      if (! (change
+             && svn_fs__list_length (change) == 3
+             && svn_fs__matches_atom (change->children, "change")))
+        {
+          cursor->c_close (cursor);
+          return svn_error_createf
+            (SVN_ERR_FS_CORRUPT, 0, 0, fs->pool,
+             "malformed change record for key `%s' in filesystem `%s'",
+             key, fs->path);
+        }
+
+      path_skel = change->children->next;
+      kind_skel = path_skel->next;
+
+      path = rooted_path (apr_pstrndup (trail->pool,
+                                        path_skel->data, path_skel->len),
+                          trail->pool);
+
+      if (svn_fs__matches_atom (kind_skel, SVN_FS__CHANGE_ADD))
+        action = 'A';
+      else if (svn_fs__matches_atom (kind_skel, SVN_FS__CHANGE_DELETE))
+        action = 'D';
+      else if (svn_fs__matches_atom (kind_skel, SVN_FS__CHANGE_REPLACE))
+        action = 'R';
+      else
+        {
+          cursor->c_close (cursor);
+          return svn_error_createf
+            (SVN_ERR_FS_CORRUPT, 0, 0, fs->pool,
+             "unknown change kind for key `%s' in filesystem `%s'",
+             key, fs->path);
+        }
+
+      fold_change (changes, path, action, trail->pool);
+
+      do
+        {
+          SVN_FS__COUNT (fs, db_cursor_ops);
+          db_err = cursor->c_get (cursor, &query,
+                                  svn_fs__result_dbt_reuse (&value, trail),
+                                  DB_NEXT_DUP);
+        }
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+    }
+
+  cursor->c_close (cursor);
+
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "reading changes", db_err));
+
+  *changes_p = changes;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs__changes_move (svn_fs_t *fs,
+                      const char *old_key,
+                      const char *new_key,
+                      trail_t *trail)
+{
+  DBC *cursor;
+  DBT query, put_key, value;
+  int db_err;
+
+  SVN_FS__COUNT (fs, db_cursor_ops);
+  SVN_ERR (DB_WRAP (fs, "creating cursor for moving changes",
+                    fs->changes->cursor (fs->changes, trail->db_txn,
+                                         &cursor, 0)));
+
+  svn_fs__str_to_dbt (&query, (char *) old_key);
+  do
+    {
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor, &query,
+                              svn_fs__result_dbt_reuse (&value, trail),
+                              DB_SET);
+    }
+  while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+
+  while (! db_err)
+    {
+      /* Re-file the record under NEW_KEY, then remove the original.
+         The cursor's position is unaffected by the put, which goes
+         through the database handle.  */
+      SVN_FS__COUNT (fs, db_puts);
+      db_err = fs->changes->put
+        (fs->changes, trail->db_txn,
+         svn_fs__str_to_dbt (&put_key, (char *) new_key),
+         &value, 0);
+      if (db_err)
+        break;
+
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_del (cursor, 0);
+      if (db_err)
+        break;
+
+      do
+        {
+          SVN_FS__COUNT (fs, db_cursor_ops);
+          db_err = cursor->c_get (cursor, &query,
+                                  svn_fs__result_dbt_reuse (&value, trail),
+                                  DB_NEXT_DUP);
+        }
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+    }
+
+  cursor->c_close (cursor);
+
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "moving changes", db_err));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs__changes_delete (svn_fs_t *fs,
+                        const char *key,
+                        trail_t *trail)
+{
+  int db_err;
+  DBT query;
+
+  SVN_FS__COUNT (fs, db_puts);
+  db_err = fs->changes->del (fs->changes, trail->db_txn,
+                             svn_fs__str_to_dbt (&query, (char *) key), 0);
+
+  /* If there're no changes for KEY, that is acceptable.  Any other
+     error should be propagated to the caller, though.  */
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "deleting changes", db_err));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Public interface to the changed-paths index.  ***/
+
+struct paths_changed_args
+{
+  apr_hash_t **changes_p;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+};
+
+
+static svn_error_t *
+txn_body_paths_changed (void *baton, trail_t *trail)
+{
+  struct paths_changed_args *args = baton;
+
+  return svn_fs__changes_fetch
+    (args->changes_p, args->fs,
+     svn_fs__changes_rev_key (args->rev, trail->pool),
+     trail);
+}
+
+
+svn_error_t *
+svn_fs_paths_changed (apr_hash_t **changed_paths_p,
+                      svn_fs_t *fs,
+                      svn_revnum_t rev,
+                      apr_pool_t *pool)
+{
+  struct paths_changed_args args;
+
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  args.changes_p = changed_paths_p;
+  args.fs = fs;
+  args.rev = rev;
+
+  return svn_fs__retry_txn (fs, txn_body_paths_changed, &args, pool);
+}
+
+
+struct set_paths_changed_args
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  apr_hash_t *changes;
+};
+
+
+static svn_error_t *
+txn_body_set_paths_changed (void *baton, trail_t *trail)
+{
+  struct set_paths_changed_args *args = baton;
+  const char *key = svn_fs__changes_rev_key (args->rev, trail->pool);
+  apr_hash_index_t *hi;
+
+  /* Replace whatever was recorded before, so rebuilding an already
+     indexed revision is harmless.  */
+  SVN_ERR (svn_fs__changes_delete (args->fs, key, trail));
+
+  for (hi = apr_hash_first (trail->pool, args->changes);
+       hi;
+       hi = apr_hash_next (hi))
+    {
+      const void *hash_key;
+      void *val;
+      const char *kind;
+
+      apr_hash_this (hi, &hash_key, NULL, &val);
+
+      switch ((char) ((int) val))
+        {
+        case 'A': kind = SVN_FS__CHANGE_ADD; break;
+        case 'D': kind = SVN_FS__CHANGE_DELETE; break;
+        default:  kind = SVN_FS__CHANGE_REPLACE; break;
+        }
+
+      SVN_ERR (svn_fs__changes_add (args->fs, key, hash_key, kind, trail));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_set_paths_changed (svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_hash_t *changed_paths,
+                          apr_pool_t *pool)
+{
+  struct set_paths_changed_args args;
+
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  args.fs = fs;
+  args.rev = rev;
+  args.changes = changed_paths;
+
+  return svn_fs__retry_txn (fs, txn_body_set_paths_changed, &args, pool);
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
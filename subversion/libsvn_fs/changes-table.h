@@ -0,0 +1,109 @@
+/* changes-table.h : internal interface to `changes' table
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_CHANGES_TABLE_H
+#define SVN_LIBSVN_FS_CHANGES_TABLE_H
+
+#include "db.h"
+#include "svn_fs.h"
+#include "trail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/*** Creating the `changes' table. ***/
+
+/* Open a `changes' table in ENV.  If CREATE is non-zero, the table
+   must not exist yet.  Either way, create the table if it doesn't
+   exist; older filesystems don't have one.  Set *CHANGES_P to the new
+   table.  Return a Berkeley DB error code.  */
+int svn_fs__open_changes_table (DB **changes_p, DB_ENV *env, int create);
+
+
+/*** Storing and retrieving changes.  ***/
+
+/* The kinds of changes we record.  These are the contents of a
+   CHANGE skel's KIND atom; see `structure'.  */
+#define SVN_FS__CHANGE_ADD      "add"
+#define SVN_FS__CHANGE_DELETE   "delete"
+#define SVN_FS__CHANGE_REPLACE  "replace"
+
+/* Return the key under which the changes for committed revision REV
+   are stored, allocated in POOL.  While a transaction is in progress,
+   its changes are stored under the transaction's own id; this key
+   cannot collide with one of those, since transaction ids never
+   contain a `-'.  */
+const char *svn_fs__changes_rev_key (svn_revnum_t rev, apr_pool_t *pool);
+
+
+/* Record under KEY in FS a change of kind KIND --- one of the
+   SVN_FS__CHANGE_* strings above --- to PATH, as part of TRAIL.
+   Records accumulate: each call appends one more CHANGE record under
+   KEY.  */
+svn_error_t *svn_fs__changes_add (svn_fs_t *fs,
+                                  const char *key,
+                                  const char *path,
+                                  const char *kind,
+                                  trail_t *trail);
+
+
+/* Set *CHANGES_P to a hash describing the changes recorded under KEY
+   in FS, as part of TRAIL.  The hash maps paths (byte strings,
+   beginning with `/') to (void *) 'A', 'D', or 'R', for added,
+   deleted, or replaced.  Multiple records for the same path are
+   collapsed into the one character that describes their net effect.
+
+   If nothing is recorded under KEY, set *CHANGES_P to null; the
+   caller can't tell an empty change list from a record that was
+   never made, so we don't pretend to.  Allocate the hash and its
+   contents in TRAIL->pool.  */
+svn_error_t *svn_fs__changes_fetch (apr_hash_t **changes_p,
+                                    svn_fs_t *fs,
+                                    const char *key,
+                                    trail_t *trail);
+
+
+/* Move all the change records stored under OLD_KEY in FS to NEW_KEY,
+   as part of TRAIL.  Used at commit time to re-file a transaction's
+   accumulated changes under the new revision's key.  */
+svn_error_t *svn_fs__changes_move (svn_fs_t *fs,
+                                   const char *old_key,
+                                   const char *new_key,
+                                   trail_t *trail);
+
+
+/* Delete all the change records stored under KEY in FS, as part of
+   TRAIL.  It is not an error if there are none.  */
+svn_error_t *svn_fs__changes_delete (svn_fs_t *fs,
+                                     const char *key,
+                                     trail_t *trail);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_CHANGES_TABLE_H */
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -15,6 +15,7 @@
  * ====================================================================
  */
 
+#include <stdlib.h>  /* for qsort() */
 #include <string.h>
 #include <assert.h>
 
@@ -38,6 +39,7 @@
 #include "trail.h"
 #include "validate.h"
 #include "id.h"
+#include "proplist.h"
 
 
 /* Initializing a filesystem.  */
@@ -72,6 +74,18 @@ struct dag_node_t
      things for you.  */
   skel_t *node_revision;
 
+  /* The node's parsed PROPLIST skel, or zero if we haven't read it in
+     yet.  This follows the same rules as NODE_REVISION above: it
+     lives in this node's POOL if the node is immutable, or in some
+     trail's pool --- and must be reset to zero when that trail
+     completes --- if the node is mutable.  */
+  skel_t *proplist;
+
+  /* The node's parsed directory ENTRIES list, or zero if we haven't
+     read it in yet.  This follows the same rules as NODE_REVISION
+     and PROPLIST above.  Always zero for non-directory nodes.  */
+  skel_t *entries;
+
 };
 
 
@@ -372,15 +386,15 @@ svn_fs__dag_init_fs (svn_fs_t *fs)
 
 /* Some of these are helpers for functions outside this section. */
 
-/* Given directory NODE_REV in FS, set *ENTRIES to its entries list
-   skel, as part of TRAIL.  The entries list will be allocated in
-   TRAIL->pool.  If NODE_REV is not a directory, return the error
-   SVN_ERR_FS_NOT_DIRECTORY.  */
+/* Given directory NODE_REV in FS, set *RAW to the unparsed concrete
+   representation of its entries list, as part of TRAIL.  If the node
+   has no entries yet, set RAW->data to null.  If NODE_REV is not a
+   directory, return the error SVN_ERR_FS_NOT_DIRECTORY.  */
 static svn_error_t *
-get_dir_entries (skel_t **entries,
-                 svn_fs_t *fs,
-                 skel_t *node_rev,
-                 trail_t *trail)
+get_dir_entries_raw (svn_string_t *raw,
+                     svn_fs_t *fs,
+                     skel_t *node_rev,
+                     trail_t *trail)
 {
   skel_t *header = SVN_FS__NR_HEADER (node_rev);
 
@@ -393,31 +407,17 @@ get_dir_entries (skel_t **entries,
           const char *rep_key = apr_pstrndup (trail->pool,
                                               rep_key_skel->data,
                                               rep_key_skel->len);
-          svn_string_t entries_raw;
-          skel_t *entry;
 
           /* Empty rep key means no entries exist. */
           if ((! rep_key) || (rep_key[0] == '\0'))
             {
-              *entries = svn_fs__make_empty_list (trail->pool);
+              raw->data = NULL;
+              raw->len = 0;
               return SVN_NO_ERROR;
             }
 
           /* Now we have a rep, follow through to get the entries. */
-          SVN_ERR (svn_fs__rep_contents (&entries_raw, fs, rep_key, trail));
-          *entries = svn_fs__parse_skel ((char *) entries_raw.data,
-                                         entries_raw.len,
-                                         trail->pool);
-
-          /* Check entries are well-formed. */
-          for (entry = (*entries)->children; entry; entry = entry->next)
-            {
-              /* ENTRY must be a list of two elements. */
-              if (svn_fs__list_length (entry) != 2)
-                return svn_error_create (SVN_ERR_FS_CORRUPT, 0, 
-                                         NULL, trail->pool,
-                                         "Malformed directory entry.");
-            }
+          SVN_ERR (svn_fs__rep_contents (raw, fs, rep_key, trail));
         }
       else
         return 
@@ -435,6 +435,389 @@ get_dir_entries (skel_t **entries,
 }
 
 
+/* Indexed directory entry lists.
+
+   A plain entries list, as described in `structure', forces readers
+   to walk every entry, so a lookup under a huge directory is O(n)
+   per path component.  Directories written by this code use an
+   indexed form instead:
+
+       (INDEX (ENTRY ...))
+
+   where the entries are sorted by name (byte order), and INDEX is an
+   atom holding the offset of each entry within the entry list's
+   concrete representation, as fixed-width decimal numbers.  A reader
+   that has the raw bytes in hand can binary-search the index and
+   never look at the entries in between.
+
+   Existing repositories still hold plain lists, so every reader here
+   accepts both forms --- the first element of the outer list tells
+   them apart --- and a plain list is quietly rewritten in indexed
+   form the first time the directory changes.  */
+
+/* The width of one index element, in bytes.  */
+#define DIR_INDEX_WIDTH 10
+
+
+/* Compare two entry names byte-wise; this is the order the index
+   writer sorts by, so readers must use it too.  */
+static int
+compare_entry_names (const char *a, apr_size_t a_len,
+                     const char *b, apr_size_t b_len)
+{
+  apr_size_t min_len = (a_len < b_len) ? a_len : b_len;
+  int cmp = memcmp (a, b, min_len);
+
+  if (cmp)
+    return cmp;
+  return (a_len < b_len) ? -1 : (a_len > b_len) ? 1 : 0;
+}
+
+
+/* qsort comparison function for an array of entry skel pointers.  */
+static int
+compare_entry_skels (const void *va, const void *vb)
+{
+  const skel_t *a = *(const skel_t *const *) va;
+  const skel_t *b = *(const skel_t *const *) vb;
+
+  return compare_entry_names (a->children->data, a->children->len,
+                              b->children->data, b->children->len);
+}
+
+
+/* Set *ENTRIES_P to the entries list parsed from the LEN bytes at
+   DATA, accepting either the indexed or the plain form.  Allocate
+   the result in POOL.  */
+static svn_error_t *
+parse_dir_entries (skel_t **entries_p,
+                   const char *data,
+                   apr_size_t len,
+                   apr_pool_t *pool)
+{
+  skel_t *parsed = svn_fs__parse_skel ((char *) data, len, pool);
+
+  if (! parsed || parsed->is_atom)
+    return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, pool,
+                             "Malformed directory entry list.");
+
+  if (parsed->children && parsed->children->is_atom)
+    {
+      /* The indexed form; the entries are the second element.  The
+         index itself is of no use once we've parsed everything.  */
+      skel_t *list = parsed->children->next;
+
+      if (! list || list->is_atom || list->next)
+        return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, pool,
+                                 "Malformed directory entry list.");
+      *entries_p = list;
+    }
+  else
+    *entries_p = parsed;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return the concrete representation of the entries list ENTRIES in
+   the indexed form, allocated in POOL.  ENTRIES need not be sorted;
+   this sorts the output.  An empty list keeps the plain form.  */
+static svn_stringbuf_t *
+unparse_dir_entries (skel_t *entries, apr_pool_t *pool)
+{
+  int count = svn_fs__list_length (entries);
+  skel_t **vec;
+  skel_t *entry;
+  svn_stringbuf_t *list_text, *index_text, *result;
+  char buf[DIR_INDEX_WIDTH + 1];
+  int i;
+
+  if (count == 0)
+    return svn_fs__unparse_skel (entries, pool);
+
+  /* Sort pointers to the entries by name.  */
+  vec = apr_palloc (pool, count * sizeof (*vec));
+  for (i = 0, entry = entries->children; entry; entry = entry->next)
+    vec[i++] = entry;
+  qsort (vec, count, sizeof (*vec), compare_entry_skels);
+
+  /* Build the entry list text and the index in one pass.  */
+  list_text = svn_stringbuf_create ("(", pool);
+  index_text = svn_stringbuf_create ("", pool);
+  for (i = 0; i < count; i++)
+    {
+      sprintf (buf, "%0*lu", DIR_INDEX_WIDTH,
+               (unsigned long) list_text->len);
+      svn_stringbuf_appendcstr (index_text, buf);
+      svn_stringbuf_appendstr (list_text,
+                               svn_fs__unparse_skel (vec[i], pool));
+    }
+  svn_stringbuf_appendcstr (list_text, ")");
+
+  /* Assemble (INDEX ENTRY-LIST).  */
+  result = svn_stringbuf_createf (pool, "(%lu ",
+                                  (unsigned long) index_text->len);
+  svn_stringbuf_appendstr (result, index_text);
+  svn_stringbuf_appendstr (result, list_text);
+  svn_stringbuf_appendcstr (result, ")");
+
+  return result;
+}
+
+
+/* Replace the contents of the mutable representation REP_KEY in FS
+   with the entries list ENTRIES, written in the indexed form, as
+   part of TRAIL.  */
+static svn_error_t *
+write_dir_entries (svn_fs_t *fs,
+                   const char *rep_key,
+                   skel_t *entries,
+                   trail_t *trail)
+{
+  svn_stream_t *ws;
+  svn_stringbuf_t *raw = unparse_dir_entries (entries, trail->pool);
+  apr_size_t len = raw->len;
+
+  SVN_ERR (svn_fs__rep_contents_clear (fs, rep_key, trail));
+  ws = svn_fs__rep_contents_write_stream (fs, rep_key, trail, trail->pool);
+  return svn_stream_write (ws, raw->data, &len);
+}
+
+
+/* Caching the parsed entries lists of mutable directories.
+
+   Every change to a directory in a transaction --- adding an entry,
+   cloning a child, deleting an entry --- used to read the whole
+   entries list from the directory's representation, parse it, apply
+   the one change, and write the list back.  The read and the parse
+   grow with the directory, so committing N files into one directory
+   cost O(N^2) parsing work.  Since this process is the only writer
+   of a transaction's mutable representations (the same assumption
+   the other caches lean on), we can remember the parsed list of each
+   recently touched directory and skip the read and the parse the
+   next time it changes.
+
+   The cache maps mutable representation keys to parsed entries
+   skels.  Each cached list lives in its own subpool so eviction can
+   free it, and a small ring of slots bounds the total footprint.
+   Writes go through to Berkeley DB as before --- only the redundant
+   re-reading is batched away --- so each trail still carries all its
+   own changes, and the whole cache is discarded when a trail aborts,
+   since the last write to a cached list may have been rolled back.
+
+   Representation keys are never reused, and deltifying a
+   representation at commit time changes how its contents are stored,
+   not what they are, so entries cached here stay valid for as long
+   as anyone can ask for them.  */
+
+/* The number of directories whose entries we cache.  */
+#define DIR_CACHE_MAX_KEYS 8
+
+/* One slot in the directory entries cache.  */
+struct dir_cache_entry_t
+{
+  /* The representation key this slot describes, allocated in POOL,
+     or null if the slot is empty.  */
+  const char *key;
+
+  /* The parsed entries list, allocated in POOL.  */
+  skel_t *entries;
+
+  /* The slot's private subpool, cleared when the slot is re-used,
+     or null until the slot is first filled.  */
+  apr_pool_t *pool;
+};
+
+/* The cache of parsed entries lists for a filesystem.  */
+struct svn_fs__dir_cache_t
+{
+  /* The pool the cache and its slot subpools live in; a subpool of
+     the filesystem's pool.  */
+  apr_pool_t *pool;
+
+  /* Maps representation keys onto their dir_cache_entry_t slots.  */
+  apr_hash_t *hash;
+
+  struct dir_cache_entry_t slots[DIR_CACHE_MAX_KEYS];
+
+  /* The next slot to claim for a new directory.  */
+  int idx;
+};
+
+
+/* Return the cached entries list for the representation REP_KEY in
+   FS, or null if we don't have one.  The skel returned is the
+   cache's own copy --- callers must not modify it, and must copy it
+   if they need it beyond the next cache operation.  */
+static skel_t *
+dir_cache_get (svn_fs_t *fs, const char *rep_key)
+{
+  struct dir_cache_entry_t *entry;
+
+  if (! fs->dir_cache)
+    return 0;
+
+  entry = apr_hash_get (fs->dir_cache->hash, rep_key, APR_HASH_KEY_STRING);
+  return entry ? entry->entries : 0;
+}
+
+
+/* Record ENTRIES as the current entries list of the representation
+   REP_KEY in FS, copying both into the cache's own storage.  */
+static void
+dir_cache_set (svn_fs_t *fs, const char *rep_key, skel_t *entries)
+{
+  struct svn_fs__dir_cache_t *cache = fs->dir_cache;
+  struct dir_cache_entry_t *entry;
+
+  if (! cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+
+      cache = apr_pcalloc (pool, sizeof (*cache));
+      cache->pool = pool;
+      cache->hash = apr_hash_make (pool);
+      fs->dir_cache = cache;
+    }
+
+  entry = apr_hash_get (cache->hash, rep_key, APR_HASH_KEY_STRING);
+  if (! entry)
+    {
+      /* Claim the next ring slot, evicting whoever held it.  */
+      entry = &cache->slots[cache->idx];
+      cache->idx = (cache->idx + 1) % DIR_CACHE_MAX_KEYS;
+      if (entry->key)
+        apr_hash_set (cache->hash, entry->key, APR_HASH_KEY_STRING, 0);
+    }
+  else
+    apr_hash_set (cache->hash, entry->key, APR_HASH_KEY_STRING, 0);
+
+  if (! entry->pool)
+    entry->pool = svn_pool_create (cache->pool);
+  else
+    svn_pool_clear (entry->pool);
+
+  entry->key = apr_pstrdup (entry->pool, rep_key);
+  entry->entries = svn_fs__copy_skel (entries, entry->pool);
+  apr_hash_set (cache->hash, entry->key, APR_HASH_KEY_STRING, entry);
+}
+
+
+void
+svn_fs__clear_dir_cache (svn_fs_t *fs)
+{
+  if (fs->dir_cache)
+    {
+      svn_pool_destroy (fs->dir_cache->pool);
+      fs->dir_cache = 0;
+    }
+}
+
+
+/* If NODE_REV's entries list is in FS's directory cache, set
+   *ENTRIES_P to a copy of it allocated in TRAIL->pool and return
+   non-zero; otherwise return zero.  */
+static int
+dir_cache_get_from_node_rev (skel_t **entries_p,
+                             svn_fs_t *fs,
+                             skel_t *node_rev,
+                             trail_t *trail)
+{
+  skel_t *data_key = SVN_FS__NR_DATA_KEY (node_rev);
+  const char *rep_key;
+  skel_t *cached;
+
+  if (! fs->dir_cache || data_key->len == 0)
+    return 0;
+
+  rep_key = apr_pstrndup (trail->pool, data_key->data, data_key->len);
+  cached = dir_cache_get (fs, rep_key);
+  if (! cached)
+    return 0;
+
+  *entries_p = svn_fs__copy_skel (cached, trail->pool);
+  return 1;
+}
+
+
+/* Given directory NODE_REV in FS, set *ENTRIES to its entries list
+   skel, as part of TRAIL.  The entries list will be allocated in
+   TRAIL->pool.  If NODE_REV is not a directory, return the error
+   SVN_ERR_FS_NOT_DIRECTORY.  */
+static svn_error_t *
+get_dir_entries (skel_t **entries,
+                 svn_fs_t *fs,
+                 skel_t *node_rev,
+                 trail_t *trail)
+{
+  svn_string_t entries_raw;
+  skel_t *entry;
+
+  /* If we have the parsed list already, skip the read and the
+     parse.  */
+  if (dir_cache_get_from_node_rev (entries, fs, node_rev, trail))
+    return SVN_NO_ERROR;
+
+  SVN_ERR (get_dir_entries_raw (&entries_raw, fs, node_rev, trail));
+  if (! entries_raw.data)
+    {
+      *entries = svn_fs__make_empty_list (trail->pool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR (parse_dir_entries (entries, entries_raw.data, entries_raw.len,
+                              trail->pool));
+
+  /* Check entries are well-formed. */
+  for (entry = (*entries)->children; entry; entry = entry->next)
+    {
+      /* ENTRY must be a list of two elements. */
+      if (svn_fs__list_length (entry) != 2)
+        return svn_error_create (SVN_ERR_FS_CORRUPT, 0, 
+                                 NULL, trail->pool,
+                                 "Malformed directory entry.");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Clear NODE's cache of its entries list.  */
+static void
+uncache_entries (void *baton)
+{
+  dag_node_t *node = baton;
+
+  node->entries = 0;
+}
+
+
+/* Set NODE's entries list cache to ENTRIES, as part of TRAIL.
+   IS_MUTABLE indicates whether NODE is mutable.  ENTRIES must be
+   allocated in TRAIL->pool.  */
+static void
+cache_entries (dag_node_t *node,
+               skel_t *entries,
+               int is_mutable,
+               trail_t *trail)
+{
+  if (is_mutable)
+    {
+      /* Mutable nodes might have other processes change their
+         entries, so we must throw away this skel once the trail is
+         complete.  */
+      svn_fs__record_completion (trail, uncache_entries, node);
+      node->entries = entries;
+    }
+  else
+    {
+      /* For immutable nodes, we can cache the list permanently, but
+         we need to copy it over into the node's own pool.  */
+      node->entries = svn_fs__copy_skel (entries, node->pool);
+    }
+}
+
+
 /* Search for an entry NAME in directory entries list ENTRIES.
    NAME must be a single path component.
 
@@ -491,17 +874,182 @@ find_dir_entry (skel_t **entry_p,
 /* Set *ENTRY to the skel for entry NAME in PARENT, as part of TRAIL.
    If no such entry, set *ENTRY to null but do not error.  The entry
    is allocated in TRAIL->pool or in the same pool as PARENT; the
-   caller should copy if it cares.  */
+   caller should copy if it cares.
+
+   Rather than parsing the whole entries list, this scans its
+   concrete representation in place and parses only the one entry we
+   were asked for, so looking something up in a big directory costs
+   almost no allocation.  */
 static svn_error_t *
 dir_entry_from_node (skel_t **entry, 
                      dag_node_t *parent,
                      const char *name,
                      trail_t *trail)
 {
-  skel_t *entries;
+  skel_t *node_rev;
+  svn_string_t entries_raw;
+  svn_fs__skel_cursor_t cursor;
+  apr_size_t name_len = strlen (name);
+  const char *elem;
+  apr_size_t elem_len;
+  int state;
 
-  SVN_ERR (svn_fs__dag_dir_entries_skel (&entries, parent, trail));
-  return find_dir_entry (entry, NULL, entries, name, trail);
+  if (! svn_fs__dag_is_directory (parent))
+    return svn_error_create
+      (SVN_ERR_FS_NOT_DIRECTORY, 0, NULL, trail->pool,
+       "Attempted to get entry from non-directory node.");
+
+  /* A list cached on the node itself is already parsed; just search
+     it.  */
+  if (parent->entries)
+    return find_dir_entry (entry, NULL, parent->entries, name, trail);
+
+  SVN_ERR (get_node_revision (&node_rev, parent, trail));
+
+  /* A cached list is already parsed; just search it.  */
+  {
+    skel_t *cached;
+
+    if (dir_cache_get_from_node_rev (&cached, parent->fs, node_rev, trail))
+      return find_dir_entry (entry, NULL, cached, name, trail);
+  }
+
+  SVN_ERR (get_dir_entries_raw (&entries_raw, parent->fs, node_rev, trail));
+
+  *entry = (skel_t *) NULL;
+  if (! entries_raw.data)
+    return SVN_NO_ERROR;
+
+  if (! svn_fs__skel_cursor_open (&cursor, entries_raw.data,
+                                  entries_raw.len))
+    return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+                             "Malformed directory entry list.");
+
+  /* Peek at the first element; an atom means this is the indexed
+     form, and we can binary-search instead of scanning.  */
+  {
+    svn_fs__skel_cursor_t probe = cursor;
+
+    state = svn_fs__skel_cursor_next (&probe, &elem, &elem_len);
+    if (state == -1)
+      return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+                               "Malformed directory entry list.");
+
+    if (state == 1 && *elem != '(')
+      {
+        const char *index, *list_data;
+        apr_size_t index_len, list_len;
+        apr_size_t lo, hi;
+
+        if (! svn_fs__skel_atom_contents (elem, elem_len,
+                                          &index, &index_len)
+            || svn_fs__skel_cursor_next (&probe,
+                                         &list_data, &list_len) != 1
+            || *list_data != '('
+            || index_len % DIR_INDEX_WIDTH != 0)
+          return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL,
+                                   trail->pool,
+                                   "Malformed directory entry list.");
+
+        lo = 0;
+        hi = index_len / DIR_INDEX_WIDTH;
+        while (lo < hi)
+          {
+            apr_size_t mid = lo + (hi - lo) / 2;
+            const char *digit = index + mid * DIR_INDEX_WIDTH;
+            apr_size_t offset = 0;
+            svn_fs__skel_cursor_t entry_cursor, name_cursor;
+            const char *edata, *name_atom, *contents;
+            apr_size_t elen, name_atom_len, contents_len;
+            int cmp, i;
+
+            for (i = 0; i < DIR_INDEX_WIDTH; i++)
+              {
+                if (digit[i] < '0' || digit[i] > '9')
+                  return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL,
+                                           trail->pool,
+                                           "Malformed directory index.");
+                offset = offset * 10 + (digit[i] - '0');
+              }
+            if (offset >= list_len)
+              return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL,
+                                       trail->pool,
+                                       "Malformed directory index.");
+
+            /* Delimit the entry the index points at, and pull out
+               its name.  */
+            entry_cursor.cur = list_data + offset;
+            entry_cursor.end = list_data + list_len;
+            if (svn_fs__skel_cursor_next (&entry_cursor,
+                                          &edata, &elen) != 1
+                || ! svn_fs__skel_cursor_open (&name_cursor, edata, elen)
+                || svn_fs__skel_cursor_next (&name_cursor, &name_atom,
+                                             &name_atom_len) != 1
+                || ! svn_fs__skel_atom_contents (name_atom, name_atom_len,
+                                                 &contents, &contents_len))
+              return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL,
+                                       trail->pool,
+                                       "Malformed directory entry.");
+
+            cmp = compare_entry_names (contents, contents_len,
+                                       name, name_len);
+            if (cmp == 0)
+              {
+                skel_t *found = svn_fs__parse_skel ((char *) edata, elen,
+                                                    trail->pool);
+                if (! found || svn_fs__list_length (found) != 2)
+                  return svn_error_createf
+                    (SVN_ERR_FS_CORRUPT, 0, 0, trail->pool,
+                     "directory entry \"%s\" ill-formed", name);
+
+                *entry = found;
+                return SVN_NO_ERROR;
+              }
+            else if (cmp < 0)
+              lo = mid + 1;
+            else
+              hi = mid;
+          }
+
+        return SVN_NO_ERROR;
+      }
+  }
+
+  while ((state = svn_fs__skel_cursor_next (&cursor, &elem, &elem_len)) == 1)
+    {
+      svn_fs__skel_cursor_t elem_cursor;
+      const char *name_atom, *contents;
+      apr_size_t name_atom_len, contents_len;
+
+      /* Each entry is a list whose first element is the name.  */
+      if (! svn_fs__skel_cursor_open (&elem_cursor, elem, elem_len)
+          || svn_fs__skel_cursor_next (&elem_cursor,
+                                       &name_atom, &name_atom_len) != 1
+          || ! svn_fs__skel_atom_contents (name_atom, name_atom_len,
+                                           &contents, &contents_len))
+        return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+                                 "Malformed directory entry.");
+
+      if (contents_len == name_len
+          && memcmp (contents, name, name_len) == 0)
+        {
+          skel_t *found = svn_fs__parse_skel ((char *) elem, elem_len,
+                                              trail->pool);
+          if (! found || svn_fs__list_length (found) != 2)
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, 0, trail->pool,
+               "directory entry \"%s\" ill-formed", name);
+
+          *entry = found;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (state == -1)
+    return svn_error_create (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+                             "Malformed directory entry list.");
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -565,11 +1113,17 @@ set_entry (dag_node_t *parent,
     skel_t *entries;
     skel_t *entry;
     svn_string_t str;
-    svn_stringbuf_t *unparsed_entries;
     svn_stringbuf_t *id_str = svn_fs_unparse_id (id, trail->pool);
 
-    SVN_ERR (svn_fs__rep_contents (&str, fs, mutable_rep_key, trail));
-    entries = svn_fs__parse_skel ((char *) str.data, str.len, trail->pool);
+    entries = dir_cache_get (fs, mutable_rep_key);
+    if (entries)
+      entries = svn_fs__copy_skel (entries, trail->pool);
+    else
+      {
+        SVN_ERR (svn_fs__rep_contents (&str, fs, mutable_rep_key, trail));
+        SVN_ERR (parse_dir_entries (&entries, str.data, str.len,
+                                    trail->pool));
+      }
     SVN_ERR (find_dir_entry (&entry, NULL, entries, name, trail));
 
     if (entry)
@@ -582,27 +1136,23 @@ set_entry (dag_node_t *parent,
       {
         /* Create a new entry. */
         skel_t *new_entry_skel;
+        svn_fs__skel_builder_t *builder = svn_fs__trail_skel_builder (trail);
 
-        new_entry_skel = svn_fs__make_empty_list (trail->pool);
-        svn_fs__prepend (svn_fs__str_atom (id_str->data, trail->pool),
+        new_entry_skel = svn_fs__build_empty_list (builder);
+        svn_fs__prepend (svn_fs__build_str_atom (builder, id_str->data),
+                         new_entry_skel);
+        svn_fs__prepend (svn_fs__build_str_atom (builder, name),
                          new_entry_skel);
-        svn_fs__prepend (svn_fs__str_atom (name, trail->pool), new_entry_skel);
         svn_fs__prepend (new_entry_skel, entries);
       }
 
-    unparsed_entries = svn_fs__unparse_skel (entries, trail->pool);
-
     /* Replace the old entries list with the new one. */
-    {
-      svn_stream_t *wstream;
-      apr_size_t len;
+    SVN_ERR (write_dir_entries (fs, mutable_rep_key, entries, trail));
 
-      SVN_ERR (svn_fs__rep_contents_clear (fs, mutable_rep_key, trail));
-      wstream = svn_fs__rep_contents_write_stream (fs, mutable_rep_key,
-                                                   trail, trail->pool);
-      len = unparsed_entries->len;
-      svn_stream_write (wstream, unparsed_entries->data, &len);
-    }
+    /* The write succeeded, so the list we have is what's on disk.
+       PARENT is mutable, or we couldn't have gotten here.  */
+    dir_cache_set (fs, mutable_rep_key, entries);
+    cache_entries (parent, entries, 1, trail);
   }
 
   return SVN_NO_ERROR;
@@ -671,6 +1221,7 @@ make_entry (dag_node_t **child_p,
   {
     skel_t *header_skel;
     svn_stringbuf_t *id_str;
+    svn_fs__skel_builder_t *builder = svn_fs__trail_skel_builder (trail);
 
     /* Call .toString() on parent's id -- oops!  This isn't Java! */
     id_str = svn_fs_unparse_id (parent->id, trail->pool);
@@ -688,17 +1239,17 @@ make_entry (dag_node_t **child_p,
        be filled in on demand by other code.  */
 
     /* First, create the HEADER skel */
-    header_skel = svn_fs__make_empty_list (trail->pool);
-    svn_fs__prepend (svn_fs__str_atom ("", trail->pool), header_skel);
+    header_skel = svn_fs__build_empty_list (builder);
+    svn_fs__prepend (svn_fs__build_str_atom (builder, ""), header_skel);
     if (is_dir)
-      svn_fs__prepend (svn_fs__str_atom ("dir", trail->pool), header_skel);
+      svn_fs__prepend (svn_fs__build_str_atom (builder, "dir"), header_skel);
     else
-      svn_fs__prepend (svn_fs__str_atom ("file", trail->pool), header_skel);
-    
+      svn_fs__prepend (svn_fs__build_str_atom (builder, "file"), header_skel);
+
     /* Now, assemble the NODE-REVISION skel. */
-    new_node_skel = svn_fs__make_empty_list (trail->pool);
-    svn_fs__prepend (svn_fs__str_atom ("", trail->pool), new_node_skel);
-    svn_fs__prepend (svn_fs__str_atom ("", trail->pool), new_node_skel);
+    new_node_skel = svn_fs__build_empty_list (builder);
+    svn_fs__prepend (svn_fs__build_str_atom (builder, ""), new_node_skel);
+    svn_fs__prepend (svn_fs__build_str_atom (builder, ""), new_node_skel);
     svn_fs__prepend (header_skel, new_node_skel);
 
     /* All done, skel-wise.  We have a NODE-REVISION skel as described
@@ -733,10 +1284,26 @@ svn_fs__dag_dir_entries_skel (skel_t **entries_p,
     return svn_error_create
       (SVN_ERR_FS_NOT_DIRECTORY, 0, NULL, trail->pool,
        "Attempted to get entry from non-directory node.");
-  
+
+  /* If we've already got the list, there's no need to read and parse
+     the entries rep again.  Note that, as with get_node_revision,
+     this hands the caller a pointer to our cache, not a private copy;
+     see the warnings in dag.h.  */
+  if (node->entries)
+    {
+      *entries_p = node->entries;
+      return SVN_NO_ERROR;
+    }
+
   /* Get the NODE-REVISION for this node. */
   SVN_ERR (get_node_revision (&node_rev, node, trail));
   SVN_ERR (get_dir_entries (entries_p, node->fs, node_rev, trail));
+
+  /* No sense caching an empty list; it's cheaper to rebuild it than
+     to read a rep.  */
+  if ((*entries_p)->children)
+    cache_entries (node, *entries_p, node_rev_is_mutable (node_rev), trail);
+
   return SVN_NO_ERROR;
 }
 
@@ -761,7 +1328,13 @@ svn_fs__dag_dir_entries_hash (apr_hash_t **table_p,
 
       dirent->name = apr_pstrndup (trail->pool, name_skel->data,
                                    name_skel->len);
-      dirent->id = svn_fs_parse_id (id_skel->data, id_skel->len, trail->pool);
+
+      /* A directory's entries mostly point at nodes we've seen
+         before, or will see again from another root, so share the
+         filesystem's canonical parsed copy of each ID rather than
+         allocating one per entry per call.  */
+      dirent->id = svn_fs__parse_id_interned (node->fs, id_skel->data,
+                                              id_skel->len);
 
       apr_hash_set (table, dirent->name, name_skel->len, dirent);
     }
@@ -772,6 +1345,38 @@ svn_fs__dag_dir_entries_hash (apr_hash_t **table_p,
 }
 
 
+svn_error_t *
+svn_fs__dag_dir_entries_iterate (dag_node_t *node,
+                                 svn_fs_dirent_receiver_t receiver,
+                                 void *baton,
+                                 trail_t *trail)
+{
+  skel_t *entries, *entry;
+  svn_fs_dirent_t dirent;
+  svn_stringbuf_t *namebuf = svn_stringbuf_create ("", trail->pool);
+
+  SVN_ERR (svn_fs__dag_dir_entries_skel (&entries, node, trail));
+
+  for (entry = entries->children; entry; entry = entry->next)
+    {
+      skel_t *name_skel = entry->children;
+      skel_t *id_skel   = entry->children->next;
+
+      /* Reuse one dirent and one name buffer for the whole walk;
+         the receiver copies anything it keeps.  */
+      svn_stringbuf_setempty (namebuf);
+      svn_stringbuf_appendbytes (namebuf, name_skel->data, name_skel->len);
+      dirent.name = namebuf->data;
+      dirent.id = svn_fs__parse_id_interned (node->fs, id_skel->data,
+                                             id_skel->len);
+
+      SVN_ERR (receiver (baton, &dirent, trail->pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_fs__dag_set_entry (dag_node_t *node,
                        const char *entry_name,
@@ -800,6 +1405,42 @@ svn_fs__dag_set_entry (dag_node_t *node,
 
 /*** Proplists. ***/
 
+/* Clear NODE's cache of its property list.  */
+static void
+uncache_proplist (void *baton)
+{
+  dag_node_t *node = baton;
+
+  node->proplist = 0;
+}
+
+
+/* Set NODE's property list cache to PROPLIST, as part of TRAIL.
+   IS_MUTABLE indicates whether NODE is mutable.  PROPLIST must be
+   allocated in TRAIL->pool.  */
+static void
+cache_proplist (dag_node_t *node,
+                skel_t *proplist,
+                int is_mutable,
+                trail_t *trail)
+{
+  if (is_mutable)
+    {
+      /* Mutable nodes might have other processes change their
+         properties, so we must throw away this skel once the trail
+         is complete.  */
+      svn_fs__record_completion (trail, uncache_proplist, node);
+      node->proplist = proplist;
+    }
+  else
+    {
+      /* For immutable nodes, we can cache the list permanently, but
+         we need to copy it over into the node's own pool.  */
+      node->proplist = svn_fs__copy_skel (proplist, node->pool);
+    }
+}
+
+
 svn_error_t *
 svn_fs__dag_get_proplist (skel_t **proplist_p,
                           dag_node_t *node,
@@ -807,9 +1448,20 @@ svn_fs__dag_get_proplist (skel_t **proplist_p,
 {
   skel_t *node_rev;
   skel_t *rep_key_skel;
+  skel_t *proplist;
   const char *rep_key;
   svn_string_t propstr;
-  
+
+  /* If we've already got the list, there's no need to read and parse
+     the property rep again.  Note that, as with get_node_revision,
+     this hands the caller a pointer to our cache, not a private copy;
+     see the warnings in dag.h.  */
+  if (node->proplist)
+    {
+      *proplist_p = node->proplist;
+      return SVN_NO_ERROR;
+    }
+
   /* Go get a fresh NODE-REVISION for this node. */
   SVN_ERR (get_node_revision (&node_rev, node, trail));
 
@@ -820,20 +1472,38 @@ svn_fs__dag_get_proplist (skel_t **proplist_p,
      skel. */
   if (rep_key_skel->len == 0)
     {
+      /* No sense caching an empty list; it's cheaper to rebuild it
+         than to read a rep.  */
       *proplist_p = svn_fs__make_empty_list (trail->pool);
       return SVN_NO_ERROR;
     }
 
   rep_key = apr_pstrndup (trail->pool, rep_key_skel->data, rep_key_skel->len);
   SVN_ERR (svn_fs__rep_contents (&propstr, node->fs, rep_key, trail));
-  *proplist_p = svn_fs__parse_skel ((char *) propstr.data,
-                                    propstr.len,
-                                    trail->pool);
+  proplist = svn_fs__parse_skel ((char *) propstr.data,
+                                 propstr.len,
+                                 trail->pool);
+  if (proplist)
+    cache_proplist (node, proplist, node_rev_is_mutable (node_rev), trail);
 
+  *proplist_p = proplist;
   return SVN_NO_ERROR;
 }
 
 
+svn_error_t *
+svn_fs__dag_get_prop (svn_string_t **value_p,
+                      dag_node_t *node,
+                      const char *name,
+                      trail_t *trail)
+{
+  skel_t *proplist;
+
+  SVN_ERR (svn_fs__dag_get_proplist (&proplist, node, trail));
+  return svn_fs__get_prop (value_p, node->fs, proplist, name, trail->pool);
+}
+
+
 svn_error_t *
 svn_fs__dag_set_proplist (dag_node_t *node,
                           skel_t *proplist,
@@ -897,9 +1567,13 @@ svn_fs__dag_set_proplist (dag_node_t *node,
     SVN_ERR (svn_fs__rep_contents_clear (node->fs, mutable_rep_key, trail));
     len = unparsed_props->len;
     SVN_ERR (svn_stream_write (wstream, unparsed_props->data, &len));
-             
+
   }
 
+  /* Since the write succeeded, update the cache.  NODE is mutable, or
+     we'd have bailed out above.  */
+  cache_proplist (node, proplist, 1, trail);
+
   return SVN_NO_ERROR;
 }
 
@@ -1164,8 +1838,14 @@ delete_entry (dag_node_t *parent,
 
   /* Read the representation, then use it to get the string that holds
      the entries list.  Parse that list into a browsable skel. */
-  SVN_ERR (svn_fs__rep_contents (&str, fs, mutable_rep_key, trail));
-  entries = svn_fs__parse_skel ((char *) str.data, str.len, trail->pool);
+  entries = dir_cache_get (fs, mutable_rep_key);
+  if (entries)
+    entries = svn_fs__copy_skel (entries, trail->pool);
+  else
+    {
+      SVN_ERR (svn_fs__rep_contents (&str, fs, mutable_rep_key, trail));
+      SVN_ERR (parse_dir_entries (&entries, str.data, str.len, trail->pool));
+    }
 
   /* Find NAME in the ENTRIES skel.  */
   SVN_ERR (find_dir_entry (&entry, &prev_entry, entries, name, trail));
@@ -1205,20 +1885,13 @@ delete_entry (dag_node_t *parent,
     prev_entry->next = entry->next;
 
   /* Replace the old entries list with the new one. */
-  {
-    svn_stream_t *ws;
-    svn_stringbuf_t *unparsed_entries;
-    apr_size_t len;
+  SVN_ERR (write_dir_entries (fs, mutable_rep_key, entries, trail));
 
-    unparsed_entries = svn_fs__unparse_skel (entries, trail->pool);
+  /* The write succeeded, so the list we have is what's on disk.
+     PARENT is mutable, or we'd have bailed out above.  */
+  dir_cache_set (fs, mutable_rep_key, entries);
+  cache_entries (parent, entries, 1, trail);
 
-    SVN_ERR (svn_fs__rep_contents_clear (fs, mutable_rep_key, trail));
-    ws = svn_fs__rep_contents_write_stream (fs, mutable_rep_key,
-                                            trail, trail->pool);
-    len = unparsed_entries->len;
-    SVN_ERR (svn_stream_write (ws, unparsed_entries->data, &len));
-  }
-    
   return SVN_NO_ERROR;
 }
 
@@ -1483,6 +2156,82 @@ svn_fs__dag_file_length (apr_size_t *length,
 }
 
 
+svn_error_t *
+svn_fs__dag_stored_delta_keys (apr_array_header_t **keys,
+                               dag_node_t *source,
+                               dag_node_t *target,
+                               apr_pool_t *pool,
+                               trail_t *trail)
+{
+  skel_t *source_rev, *target_rev;
+  const char *source_key, *target_key;
+
+  *keys = NULL;
+
+  /* Make sure our nodes are files. */
+  if ((! svn_fs__dag_is_file (source)) || (! svn_fs__dag_is_file (target)))
+    return
+      svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, 0, NULL, trail->pool,
+       "Attempted to get a stored delta between *non*-file nodes.");
+
+  /* Go get fresh node-revisions for both nodes. */
+  SVN_ERR (get_node_revision (&source_rev, source, trail));
+  SVN_ERR (get_node_revision (&target_rev, target, trail));
+
+  /* A node with no data key has empty contents, which are never the
+     base or product of a stored delta. */
+  if (((SVN_FS__NR_DATA_KEY (source_rev))->len == 0)
+      || ((SVN_FS__NR_DATA_KEY (target_rev))->len == 0))
+    return SVN_NO_ERROR;
+
+  source_key = apr_pstrndup (trail->pool,
+                             (SVN_FS__NR_DATA_KEY (source_rev))->data,
+                             (SVN_FS__NR_DATA_KEY (source_rev))->len);
+  target_key = apr_pstrndup (trail->pool,
+                             (SVN_FS__NR_DATA_KEY (target_rev))->data,
+                             (SVN_FS__NR_DATA_KEY (target_rev))->len);
+
+  return svn_fs__rep_stored_delta_keys (keys, target->fs, target_key,
+                                        source_key, pool, trail);
+}
+
+
+svn_error_t *
+svn_fs__dag_file_checksum (unsigned char digest[MD5_DIGESTSIZE],
+                           svn_boolean_t *known_p,
+                           dag_node_t *file,
+                           trail_t *trail)
+{
+  skel_t *node_rev;
+
+  /* Make sure our node is a file. */
+  if (! svn_fs__dag_is_file (file))
+    return
+      svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, 0, NULL, trail->pool,
+       "Attempted to get checksum of a *non*-file node.");
+
+  /* Go get a fresh node-revision for FILE. */
+  SVN_ERR (get_node_revision (&node_rev, file, trail));
+
+  /* Seg-fault protection. */
+  assert (svn_fs__list_length (node_rev) >= 3);
+
+  /* Get the rep key, get the checksum through that. */
+  {
+    const char *rep_key = apr_pstrndup (trail->pool,
+                                        (SVN_FS__NR_DATA_KEY (node_rev))->data,
+                                        (SVN_FS__NR_DATA_KEY (node_rev))->len);
+
+    SVN_ERR (svn_fs__rep_checksum (digest, known_p, file->fs,
+                                   rep_key, trail));
+  }
+
+  return SVN_NO_ERROR;
+}
+
+
 
 
 svn_error_t *
@@ -1532,7 +2281,8 @@ svn_fs__dag_get_edit_stream (svn_stream_t **contents,
   SVN_ERR (svn_fs__get_mutable_rep (&mutable_rep_key, NULL, fs, trail));
   
   /* We made a new rep, so update the node revision. */
-  svn_fs__append (svn_fs__str_atom (mutable_rep_key, trail->pool), 
+  svn_fs__append (svn_fs__build_str_atom (svn_fs__trail_skel_builder (trail),
+                                          mutable_rep_key),
                   node_rev_skel);
   SVN_ERR (svn_fs__put_node_revision (fs, file->id, node_rev_skel, trail));
 
@@ -1601,13 +2351,21 @@ svn_fs__dag_finalize_edits (dag_node_t *file,
 dag_node_t *
 svn_fs__dag_dup (dag_node_t *node,
                  trail_t *trail)
+{
+  return svn_fs__dag_dup_into_pool (node, trail->pool);
+}
+
+
+dag_node_t *
+svn_fs__dag_dup_into_pool (dag_node_t *node,
+                           apr_pool_t *pool)
 {
   /* Allocate our new node. */
-  dag_node_t *new_node = apr_pcalloc (trail->pool, sizeof (*new_node));
+  dag_node_t *new_node = apr_pcalloc (pool, sizeof (*new_node));
 
   new_node->fs = node->fs;
-  new_node->pool = trail->pool;
-  new_node->id = svn_fs__id_copy (node->id, node->pool);
+  new_node->pool = pool;
+  new_node->id = svn_fs__id_copy (node->id, pool);
   new_node->kind = node->kind;
 
   /* Leave new_node->node_revision zero for now, so it'll get read in.
@@ -1707,11 +2465,13 @@ svn_fs__dag_copy (dag_node_t *to_node,
       {
         skel_t *copy_opt;
         char *rev_str = apr_psprintf (trail->pool, "%ld", from_rev);
-        
-        copy_opt = svn_fs__make_empty_list (trail->pool);
-        svn_fs__prepend (svn_fs__str_atom (from_path, trail->pool), copy_opt);
-        svn_fs__prepend (svn_fs__str_atom (rev_str, trail->pool), copy_opt);
-        svn_fs__prepend (svn_fs__str_atom ("copy", trail->pool), copy_opt);
+        svn_fs__skel_builder_t *builder = svn_fs__trail_skel_builder (trail);
+
+        copy_opt = svn_fs__build_empty_list (builder);
+        svn_fs__prepend (svn_fs__build_str_atom (builder, from_path),
+                         copy_opt);
+        svn_fs__prepend (svn_fs__build_str_atom (builder, rev_str), copy_opt);
+        svn_fs__prepend (svn_fs__build_str_atom (builder, "copy"), copy_opt);
         
         /* If the from_node was itself a copy, we don't want to preserve
            that copy history in the new node. */
@@ -1922,8 +2682,9 @@ svn_fs__dag_commit_txn (svn_revnum_t *new_rev,
     skel_t *new_revision_skel;
     svn_stringbuf_t *id_string = svn_fs_unparse_id (root->id, trail->pool);
     skel_t *txn_skel;
-    
-    new_revision_skel = svn_fs__make_empty_list (trail->pool);
+    svn_fs__skel_builder_t *builder = svn_fs__trail_skel_builder (trail);
+
+    new_revision_skel = svn_fs__build_empty_list (builder);
 
     /* PROPLIST */
     SVN_ERR (svn_fs__get_txn (&txn_skel, fs, svn_txn, trail));
@@ -1931,12 +2692,12 @@ svn_fs__dag_commit_txn (svn_revnum_t *new_rev,
                      new_revision_skel);
 
     /* ID */
-    svn_fs__prepend (svn_fs__mem_atom (id_string->data,
-                                       id_string->len, trail->pool),
+    svn_fs__prepend (svn_fs__build_mem_atom (builder, id_string->data,
+                                             id_string->len),
                      new_revision_skel);
 
     /* "revision" */
-    svn_fs__prepend (svn_fs__str_atom ("revision", trail->pool),
+    svn_fs__prepend (svn_fs__build_str_atom (builder, "revision"),
                      new_revision_skel);
 
     SVN_ERR (svn_fs__put_rev (new_rev, fs, new_revision_skel, trail));
@@ -18,6 +18,8 @@
 #ifndef SVN_LIBSVN_FS_DAG_H
 #define SVN_LIBSVN_FS_DAG_H
 
+#include <apr_md5.h>
+
 #include "svn_fs.h"
 #include "db.h"
 #include "skel.h"
@@ -85,10 +87,24 @@ dag_node_t *svn_fs__dag_dup (dag_node_t *node,
                              trail_t *trail);
 
 
+/* Like svn_fs__dag_dup, but allocate the new object in POOL rather
+   than a trail's pool.  Use this to keep a reference to NODE alive
+   beyond the trail it was opened in; the copy carries no cached
+   node revision contents, so it is safe to use it in later trails.  */
+dag_node_t *svn_fs__dag_dup_into_pool (dag_node_t *node,
+                                       apr_pool_t *pool);
+
+
 /* Return the filesystem containing NODE.  */
 svn_fs_t *svn_fs__dag_get_fs (dag_node_t *node);
 
 
+/* Discard FS's in-memory cache of parsed directory entries lists.
+   Called when a trail aborts, since the last write to a cached list
+   may have been rolled back.  */
+void svn_fs__clear_dir_cache (svn_fs_t *fs);
+
+
 /* Set *REV to NODE's revision number, as part of TRAIL.  If NODE has
    never been committed as part of a revision, set *REV to
    SVN_INVALID_REVNUM.  */
@@ -133,6 +149,19 @@ svn_error_t *svn_fs__dag_get_proplist (skel_t **proplist_p,
                                        trail_t *trail);
 
 
+/* Set *VALUE_P to the value of the property named NAME on NODE, as
+   part of TRAIL, or to null if NODE has no property by that name.
+   Allocate the value in TRAIL->pool.
+
+   Prefer this to svn_fs__dag_get_proplist when only one property is
+   wanted; the property list is read at most once per node, no matter
+   how many properties callers ask for.  */
+svn_error_t *svn_fs__dag_get_prop (svn_string_t **value_p,
+                                   dag_node_t *node,
+                                   const char *name,
+                                   trail_t *trail);
+
+
 /* Set the property list of NODE to PROPLIST, as part of TRAIL.  The
    node being changed must be mutable.  This verifies that PROPLIST is
    well-formed.  */
@@ -249,6 +278,16 @@ svn_error_t *svn_fs__dag_dir_entries_hash (apr_hash_t **entries_p,
                                            trail_t *trail);
 
 
+/* Invoke RECEIVER, with BATON, on each of NODE's entries in storage
+   order, as part of TRAIL.  One dirent structure and name buffer are
+   recycled across the calls, so no per-entry storage accumulates;
+   the receiver must copy anything it wants to keep.  */
+svn_error_t *svn_fs__dag_dir_entries_iterate (dag_node_t *node,
+                                              svn_fs_dirent_receiver_t receiver,
+                                              void *baton,
+                                              trail_t *trail);
+
+
 /* Set ENTRY_NAME in NODE to point to ID, as part of TRAIL.
    NODE must be a mutable directory.  ID can refer to a mutable or
    immutable node.  If ENTRY_NAME does not exist, it will be 
@@ -402,6 +441,28 @@ svn_error_t *svn_fs__dag_file_length (apr_size_t *length,
                                       trail_t *trail);
 
 
+/* If the contents of file TARGET are stored as a delta made directly
+   against the contents of file SOURCE, set *KEYS to the string keys
+   holding the delta's svndiff windows, in order; else set *KEYS to
+   null.  Allocate *KEYS in POOL, as part of TRAIL.
+
+   If SOURCE or TARGET is not a file, return SVN_ERR_FS_NOT_FILE.  */
+svn_error_t *svn_fs__dag_stored_delta_keys (apr_array_header_t **keys,
+                                            dag_node_t *source,
+                                            dag_node_t *target,
+                                            apr_pool_t *pool,
+                                            trail_t *trail);
+
+
+/* Set *KNOWN_P to TRUE and DIGEST to the recorded MD5 checksum of the
+   contents of FILE, as part of TRAIL; or set *KNOWN_P to FALSE if no
+   checksum is recorded for the contents.  */
+svn_error_t *svn_fs__dag_file_checksum (unsigned char digest[MD5_DIGESTSIZE],
+                                        svn_boolean_t *known_p,
+                                        dag_node_t *file,
+                                        trail_t *trail);
+
+
 /* Create a new mutable file named NAME in PARENT, as part of TRAIL.
    Set *CHILD_P to a reference to the new node, allocated in
    TRAIL->pool.  The new file's contents are the empty string, and it
@@ -17,9 +17,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include "apr_pools.h"
 #include "db.h"
 #include "dbt.h"
+#include "trail.h"
 
 
 DBT *
@@ -66,6 +68,44 @@ svn_fs__result_dbt (DBT *dbt)
 }
 
 
+DBT *
+svn_fs__result_dbt_reuse (DBT *dbt, trail_t *trail)
+{
+  svn_fs__clear_dbt (dbt);
+  dbt->data = trail->scratch;
+  dbt->ulen = trail->scratch_size;
+  dbt->flags |= DB_DBT_USERMEM;
+
+  return dbt;
+}
+
+
+int
+svn_fs__retry_dbt_reuse (DBT *dbt, trail_t *trail, int db_err)
+{
+  apr_size_t new_size;
+
+  /* Berkeley DB reports a too-small DB_DBT_USERMEM buffer as ENOMEM,
+     with DBT->size set to the length it needs.  Anything else is the
+     caller's business.  */
+  if (db_err != ENOMEM || ! (dbt->flags & DB_DBT_USERMEM))
+    return 0;
+
+  /* Double until the record fits.  The outgrown buffer is orphaned in
+     TRAIL->pool, but the doubling keeps the total waste within a
+     constant factor of the final buffer size.  */
+  new_size = trail->scratch_size ? trail->scratch_size : 512;
+  while (new_size < dbt->size)
+    new_size *= 2;
+
+  trail->scratch = apr_palloc (trail->pool, new_size);
+  trail->scratch_size = new_size;
+
+  svn_fs__result_dbt_reuse (dbt, trail);
+  return 1;
+}
+
+
 /* An APR pool cleanup function that simply applies `free' to its
    argument.  */
 static apr_status_t
@@ -23,6 +23,7 @@
 #include "svn_fs.h"
 #include "db.h"
 #include "skel.h"
+#include "trail.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -67,6 +68,39 @@ DBT *svn_fs__set_dbt (DBT *dbt, void *data, u_int32_t size);
      to be freed when POOL is cleared.  */
 DBT *svn_fs__result_dbt (DBT *dbt);
 
+/* Prepare DBT to hold data returned from Berkeley DB in TRAIL's
+   scratch buffer, rather than in a fresh malloc'd block.  Return DBT.
+
+   This is for the common get-parse-discard cycle, where the raw
+   record is parsed or copied into pool storage right away and the
+   buffer's contents aren't needed afterwards; it saves the
+   malloc/free pair that svn_fs__result_dbt costs per record.  The
+   scratch buffer belongs to the trail, so the next retrieval through
+   this function overwrites it --- don't let anything keep pointing
+   into DBT->data.
+
+   If the buffer turns out to be too small for the record, the
+   database operation fails with ENOMEM; pass the result to
+   svn_fs__retry_dbt_reuse to grow the buffer and decide whether to
+   re-run the operation:
+
+       do
+         db_err = fs->nodes->get (fs->nodes, txn, &key,
+                                  svn_fs__result_dbt_reuse (&value, trail),
+                                  0);
+       while (svn_fs__retry_dbt_reuse (&value, trail, db_err));  */
+DBT *svn_fs__result_dbt_reuse (DBT *dbt, trail_t *trail);
+
+
+/* If DB_ERR says the scratch buffer prepared by
+   svn_fs__result_dbt_reuse was too small for the record, grow the
+   buffer to fit --- geometrically, so it quickly settles at the size
+   of the largest record the trail sees --- re-point DBT at it, and
+   return non-zero, meaning `re-run the database operation'.
+   Otherwise, return zero, leaving DB_ERR for the caller to handle.  */
+int svn_fs__retry_dbt_reuse (DBT *dbt, trail_t *trail, int db_err);
+
+
 /* Arrange for POOL to `track' DBT's data: when POOL is cleared,
    DBT->data will be freed, using `free'.  If DBT->data is zero,
    do nothing.
@@ -34,6 +34,7 @@
 #include "txn-table.h"
 #include "reps-table.h"
 #include "strings-table.h"
+#include "changes-table.h"
 #include "dag.h"
 #include "svn_private_config.h"
 
@@ -129,6 +130,7 @@ cleanup_fs (svn_fs_t *fs)
   SVN_ERR (cleanup_fs_db (fs, &fs->transactions, "transactions"));
   SVN_ERR (cleanup_fs_db (fs, &fs->representations, "representations"));
   SVN_ERR (cleanup_fs_db (fs, &fs->strings, "strings"));
+  SVN_ERR (cleanup_fs_db (fs, &fs->changes, "changes"));
 
   /* Checkpoint any changes.  */
   {
@@ -227,6 +229,18 @@ svn_fs_new (apr_pool_t *parent_pool)
 
   new->warning = default_warning_func;
 
+  /* The default checkpoint policy.  The values are pretty arbitrary;
+     use svn_fs_set_berkeley_checkpoint_policy to change them.  */
+  new->checkpoint_kbytes = 1024;
+  new->checkpoint_minutes = 5;
+
+  /* The default deltification policy: no lower bound, and don't
+     deltify anything larger than the svndiff window size.  See the
+     comments in svn_fs__rep_deltify (reps-strings.c) and issue #531
+     for the reasoning behind the upper bound.  */
+  new->deltify_min_size = 0;
+  new->deltify_max_size = SVN_STREAM_CHUNK_SIZE;
+
   apr_pool_cleanup_register (new->pool, (void *) new,
                              (apr_status_t (*) (void *)) cleanup_fs_apr,
                              apr_pool_cleanup_null);
@@ -245,8 +259,31 @@ svn_fs_set_warning_func (svn_fs_t *fs,
 }
 
 
+void
+svn_fs_set_trusted_reads (svn_fs_t *fs,
+                          svn_boolean_t trusted)
+{
+  fs->trusted_reads = trusted;
+}
+
+
+void
+svn_fs_get_stats (svn_fs_stats_t *stats,
+                  svn_fs_t *fs)
+{
+  *stats = fs->stats;
+}
+
+
+void
+svn_fs_reset_stats (svn_fs_t *fs)
+{
+  memset (&fs->stats, 0, sizeof (fs->stats));
+}
+
+
 svn_error_t *
-svn_fs_set_berkeley_errcall (svn_fs_t *fs, 
+svn_fs_set_berkeley_errcall (svn_fs_t *fs,
                              void (*db_errcall_fcn) (const char *errpfx,
                                                      char *msg))
 {
@@ -257,6 +294,70 @@ svn_fs_set_berkeley_errcall (svn_fs_t *fs,
 }
 
 
+/* Return an SVN_ERR_FS_ALREADY_OPEN error if FS's environment is
+   already open; tuning parameters can only be recorded before then.  */
+static svn_error_t *
+check_env_not_open (svn_fs_t *fs)
+{
+  if (fs->env)
+    return svn_error_create (SVN_ERR_FS_ALREADY_OPEN, 0, 0, fs->pool,
+                             "filesystem object already open");
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_set_berkeley_cache_size (svn_fs_t *fs,
+                                apr_size_t cache_size)
+{
+  SVN_ERR (check_env_not_open (fs));
+  fs->env_cache_size = cache_size;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_set_berkeley_log_dir (svn_fs_t *fs,
+                             const char *log_dir)
+{
+  SVN_ERR (check_env_not_open (fs));
+  fs->env_log_dir = log_dir ? apr_pstrdup (fs->pool, log_dir) : 0;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_set_berkeley_checkpoint_policy (svn_fs_t *fs,
+                                       int kbytes,
+                                       int minutes)
+{
+  fs->checkpoint_kbytes = kbytes;
+  fs->checkpoint_minutes = minutes;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_set_deltification_limits (svn_fs_t *fs,
+                                 apr_size_t min_size,
+                                 apr_size_t max_size)
+{
+  if (max_size && max_size < min_size)
+    return svn_error_create
+      (SVN_ERR_INCORRECT_PARAMS, 0, NULL, fs->pool,
+       "svn_fs_set_deltification_limits: max_size is less than min_size");
+
+  fs->deltify_min_size = min_size;
+  fs->deltify_max_size = max_size;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_fs_close_fs (svn_fs_t *fs)
 {
@@ -368,7 +469,19 @@ allocate_env (svn_fs_t *fs)
      DB_ENV->set_lg_max(). */
   SVN_ERR (DB_WRAP (fs, "setting in-memory log buffer size",
 		    fs->env->set_lg_bsize (fs->env, 256 * 1024)));
-  
+
+  /* Apply whatever tuning the svn_fs_set_berkeley_* functions have
+     recorded; where they haven't, leave Berkeley DB's defaults
+     alone.  */
+  if (fs->env_cache_size)
+    SVN_ERR (DB_WRAP (fs, "setting database cache size",
+                      fs->env->set_cachesize (fs->env, 0,
+                                              fs->env_cache_size, 1)));
+
+  if (fs->env_log_dir)
+    SVN_ERR (DB_WRAP (fs, "setting log file directory",
+                      fs->env->set_lg_dir (fs->env, fs->env_log_dir)));
+
   return SVN_NO_ERROR;
 }
 
@@ -474,6 +587,10 @@ svn_fs_create_berkeley (svn_fs_t *fs, const char *path)
                      svn_fs__open_strings_table (&fs->strings,
                                                  fs->env, 1));
   if (svn_err) goto error;
+  svn_err = DB_WRAP (fs, "creating `changes' table",
+                     svn_fs__open_changes_table (&fs->changes,
+                                                 fs->env, 1));
+  if (svn_err) goto error;
 
   /* Initialize the DAG subsystem. */
   svn_err = svn_fs__dag_init_fs (fs);
@@ -534,8 +651,18 @@ svn_fs_open_berkeley (svn_fs_t *fs, const char *path)
                                                  fs->env, 0));
   if (svn_err) goto error;
 
+  /* The `changes' table was added after the others; filesystems
+     created before then don't have one.  Opening it with DB_CREATE
+     quietly gives such a filesystem an empty changed-paths index,
+     which readers treat as "not yet built" and `svnadmin
+     build-changes' can fill in.  */
+  svn_err = DB_WRAP (fs, "opening `changes' table",
+                     svn_fs__open_changes_table (&fs->changes,
+                                                 fs->env, 0));
+  if (svn_err) goto error;
+
   return SVN_NO_ERROR;
-  
+
  error:
   cleanup_fs (fs);
   return svn_err;
@@ -546,9 +673,12 @@ svn_fs_open_berkeley (svn_fs_t *fs, const char *path)
 /* Running recovery on a Berkeley DB-based filesystem.  */
 
 
-svn_error_t *
-svn_fs_berkeley_recover (const char *path,
-                         apr_pool_t *pool)
+/* The guts of recovery.  If FATAL is non-zero, run catastrophic
+   recovery (replay every log file we have), else plain recovery.  */
+static svn_error_t *
+berkeley_recover (const char *path,
+                  svn_boolean_t fatal,
+                  apr_pool_t *pool)
 {
   int db_err;
   DB_ENV *env;
@@ -558,16 +688,17 @@ svn_fs_berkeley_recover (const char *path,
     return svn_fs__dberr (pool, db_err);
 
   /* Here's the comment copied from db_recover.c:
-   
+
      Initialize the environment -- we don't actually do anything
      else, that all that's needed to run recovery.
-   
+
      Note that we specify a private environment, as we're about to
      create a region, and we don't want to to leave it around.  If
      we leave the region around, the application that should create
      it will simply join it instead, and will then be running with
      incorrectly sized (and probably terribly small) caches.  */
-  db_err = env->open (env, path, (DB_RECOVER | DB_CREATE
+  db_err = env->open (env, path, ((fatal ? DB_RECOVER_FATAL : DB_RECOVER)
+                                  | DB_CREATE
                                   | DB_INIT_LOCK | DB_INIT_LOG
                                   | DB_INIT_MPOOL | DB_INIT_TXN
                                   | DB_PRIVATE),
@@ -583,6 +714,292 @@ svn_fs_berkeley_recover (const char *path,
 }
 
 
+svn_error_t *
+svn_fs_berkeley_recover (const char *path,
+                         apr_pool_t *pool)
+{
+  return berkeley_recover (path, FALSE, pool);
+}
+
+
+
+/* The commit stamp.  */
+
+/* Return the path to the commit stamp file for the filesystem
+   directory PATH, allocated in POOL.  */
+static const char *
+commit_stamp_path (const char *path, apr_pool_t *pool)
+{
+  return apr_psprintf (pool, "%s/" SVN_FS__COMMIT_STAMP, path);
+}
+
+
+svn_error_t *
+svn_fs__stamp_commit (svn_fs_t *fs,
+                      svn_revnum_t new_rev,
+                      apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_stringbuf_t *tmp_path;
+  const char *stamp_path = commit_stamp_path (fs->path, pool);
+  const char *contents = apr_psprintf (pool, "%ld\n", (long int) new_rev);
+  apr_status_t apr_err;
+
+  /* Write the new stamp beside the old one and rename it into place,
+     so a reader never sees a half-written stamp.  */
+  SVN_ERR (svn_io_open_unique_file (&file, &tmp_path, stamp_path,
+                                    ".tmp", FALSE, pool));
+
+  apr_err = apr_file_write_full (file, contents, strlen (contents), NULL);
+  if (apr_err)
+    {
+      apr_file_close (file);
+      return svn_error_createf (apr_err, 0, 0, pool,
+                                "writing commit stamp `%s'", tmp_path->data);
+    }
+
+  apr_err = apr_file_close (file);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "closing commit stamp `%s'", tmp_path->data);
+
+  apr_err = apr_file_rename (tmp_path->data, stamp_path, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "renaming commit stamp into `%s'", stamp_path);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_read_commit_stamp (svn_revnum_t *youngest_p,
+                          const char *path,
+                          apr_pool_t *pool)
+{
+  apr_file_t *file;
+  apr_status_t apr_err;
+  apr_size_t len;
+  char buf[80];
+  const char *stamp_path = commit_stamp_path (path, pool);
+
+  apr_err = apr_file_open (&file, stamp_path, APR_READ, APR_OS_DEFAULT,
+                           pool);
+  if (apr_err && APR_STATUS_IS_ENOENT (apr_err))
+    {
+      /* No commit has been made through a stamp-writing library yet.
+         That's an absence of news, not an error.  */
+      *youngest_p = SVN_INVALID_REVNUM;
+      return SVN_NO_ERROR;
+    }
+  else if (apr_err)
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "opening commit stamp `%s'", stamp_path);
+
+  len = sizeof (buf) - 1;
+  apr_err = apr_file_read (file, buf, &len);
+  apr_file_close (file);
+  if (apr_err && ! APR_STATUS_IS_EOF (apr_err))
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "reading commit stamp `%s'", stamp_path);
+
+  buf[len] = '\0';
+  *youngest_p = SVN_STR_TO_REV (buf);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_wait_for_commit (svn_revnum_t *youngest_p,
+                        const char *path,
+                        svn_revnum_t last_seen,
+                        apr_interval_time_t timeout,
+                        apr_pool_t *pool)
+{
+  apr_time_t deadline = 0;
+
+  if (timeout > 0)
+    deadline = apr_time_now () + timeout;
+
+  while (1)
+    {
+      svn_revnum_t stamped;
+
+      SVN_ERR (svn_fs_read_commit_stamp (&stamped, path, pool));
+
+      if ((SVN_IS_VALID_REVNUM (stamped) && stamped > last_seen)
+          || (deadline && apr_time_now () >= deadline))
+        {
+          *youngest_p = stamped;
+          return SVN_NO_ERROR;
+        }
+
+      apr_sleep (APR_USEC_PER_SEC / 4);  /* microseconds */
+    }
+
+  /* NOTREACHED */
+}
+
+
+
+/* Hot backup of a Berkeley DB-based filesystem.  */
+
+
+svn_error_t *
+svn_fs_berkeley_logfiles (apr_array_header_t **logfiles,
+                          const char *path,
+                          svn_boolean_t only_unused,
+                          apr_pool_t *pool)
+{
+  int db_err;
+  DB_ENV *env;
+  char **filelist, **filename;
+  u_int32_t flags = only_unused ? 0 : DB_ARCH_LOG;
+
+  *logfiles = apr_array_make (pool, 4, sizeof (const char *));
+
+  db_err = db_env_create (&env, 0);
+  if (db_err)
+    return svn_fs__dberr (pool, db_err);
+
+  /* As with recovery, use a private environment so we don't leave a
+     region behind for the live application to join.  Unlike
+     recovery, we must not pass DB_RECOVER: the environment we're
+     asking about may be in use.  */
+  db_err = env->open (env, path, (DB_CREATE
+                                  | DB_INIT_LOG | DB_INIT_MPOOL
+                                  | DB_PRIVATE),
+                      0666);
+  if (db_err)
+    return svn_fs__dberr (pool, db_err);
+
+  db_err = env->log_archive (env, &filelist, flags);
+  if (db_err)
+    {
+      env->close (env, 0);
+      return svn_fs__dberr (pool, db_err);
+    }
+
+  /* A null list just means no log files matched. */
+  if (filelist)
+    {
+      for (filename = filelist; *filename; filename++)
+        (*((const char **) apr_array_push (*logfiles)))
+          = apr_pstrdup (pool, *filename);
+      free (filelist);
+    }
+
+  db_err = env->close (env, 0);
+  if (db_err)
+    return svn_fs__dberr (pool, db_err);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Copy the file NAME from the environment directory SRC_PATH to the
+   environment directory DEST_PATH.  If MISSING_OK is non-zero,
+   quietly do nothing when the source file does not exist.  */
+static svn_error_t *
+copy_env_file (const char *src_path,
+               const char *dest_path,
+               const char *name,
+               svn_boolean_t missing_ok,
+               apr_pool_t *pool)
+{
+  const char *src = apr_psprintf (pool, "%s/%s", src_path, name);
+  const char *dest = apr_psprintf (pool, "%s/%s", dest_path, name);
+
+  if (missing_ok)
+    {
+      enum svn_node_kind kind;
+      SVN_ERR (svn_io_check_path (src, &kind, pool));
+      if (kind == svn_node_none)
+        return SVN_NO_ERROR;
+    }
+
+  return svn_io_copy_file (src, dest, TRUE, pool);
+}
+
+
+svn_error_t *
+svn_fs_berkeley_hotcopy (const char *src_path,
+                         const char *dest_path,
+                         svn_boolean_t incremental,
+                         apr_pool_t *pool)
+{
+  apr_array_header_t *logfiles;
+  enum svn_node_kind kind;
+  int i;
+
+  /* The database files, every one of which must be copied before any
+     log file is --- that ordering is what makes the backup of a live
+     environment recoverable.  */
+  static const char * const tables[]
+    = { "nodes", "revisions", "transactions",
+        "representations", "strings", "changes" };
+
+  /* Make sure the destination directory exists. */
+  SVN_ERR (svn_io_check_path (dest_path, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      apr_status_t apr_err = apr_dir_make (dest_path, APR_OS_DEFAULT, pool);
+      if (apr_err)
+        return svn_error_createf (apr_err, 0, 0, pool,
+                                  "creating directory `%s'", dest_path);
+    }
+
+  if (! incremental)
+    {
+      /* Copy the DB_CONFIG file, if there is one, then the database
+         files themselves.  */
+      SVN_ERR (copy_env_file (src_path, dest_path, "DB_CONFIG", TRUE, pool));
+      for (i = 0; i < (sizeof (tables) / sizeof (tables[0])); i++)
+        SVN_ERR (copy_env_file (src_path, dest_path, tables[i],
+                                FALSE, pool));
+    }
+
+  /* Copy the log files, oldest first and always after the database
+     files.  */
+  SVN_ERR (svn_fs_berkeley_logfiles (&logfiles, src_path, FALSE, pool));
+  for (i = 0; i < logfiles->nelts; i++)
+    {
+      const char *name = ((const char **) logfiles->elts)[i];
+
+      /* A log segment never changes again once Berkeley DB has moved
+         on to its successor, so in incremental mode any segment but
+         the newest one that the backup already holds, at the same
+         size, need not be shipped again.  The newest segment may
+         still be growing, and is always recopied.  */
+      if (incremental && (i < logfiles->nelts - 1))
+        {
+          apr_finfo_t src_finfo, dest_finfo;
+
+          if ((! apr_stat (&src_finfo,
+                           apr_psprintf (pool, "%s/%s", src_path, name),
+                           APR_FINFO_MIN, pool))
+              && (! apr_stat (&dest_finfo,
+                              apr_psprintf (pool, "%s/%s", dest_path, name),
+                              APR_FINFO_MIN, pool))
+              && (src_finfo.size == dest_finfo.size))
+            continue;
+        }
+
+      SVN_ERR (copy_env_file (src_path, dest_path, name, FALSE, pool));
+    }
+
+  /* Finally, run catastrophic recovery on the copy, to bring the
+     database files and the logs into agreement.  (Plain recovery is
+     not enough --- the database files were copied out from under a
+     live environment.)  The copy is a usable filesystem from here
+     on.  */
+  SVN_ERR (berkeley_recover (dest_path, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Deleting a Berkeley DB-based filesystem.  */
 
@@ -46,12 +46,87 @@ struct svn_fs_t {
 
   /* The filesystem's various tables.  See `structure' for details.  */
   DB *nodes, *revisions, *transactions, *representations, *strings;
+  DB *changes;
 
   /* A callback function for printing warning messages, and a baton to
      pass through to it.  */
   svn_fs_warning_callback_t warning;
   void *warning_baton;
 
+  /* Berkeley DB environment tuning, recorded by the
+     svn_fs_set_berkeley_* functions and applied by allocate_env when
+     the environment is created or opened.  Zero / null values mean
+     Berkeley DB's own defaults.  */
+  apr_size_t env_cache_size;
+  const char *env_log_dir;
+
+  /* Checkpoint policy: after committing a trail, checkpoint the log
+     only if CHECKPOINT_KBYTES kilobytes of log data have been
+     written, or CHECKPOINT_MINUTES minutes have passed, since the
+     last checkpoint.  svn_fs_new sets the defaults.  */
+  int checkpoint_kbytes;
+  int checkpoint_minutes;
+
+  /* If non-zero, skip structural re-validation of skels read back
+     from the database on the hot read paths; we wrote them, so they
+     are well-formed unless the database is corrupt, and corruption
+     is what `svnadmin verify' (verify.c) is for.  Writes always
+     validate.  Set by svn_fs_set_trusted_reads.  */
+  int trusted_reads;
+
+  /* Deltification policy: leave a file's representation as fulltext
+     if its contents are smaller than DELTIFY_MIN_SIZE bytes (the
+     rep/string bookkeeping would cost more than the content) or
+     larger than DELTIFY_MAX_SIZE bytes (already-compressed media
+     deltifies poorly, and retrieval cost grows with chain length).
+     svn_fs_new sets the defaults; use
+     svn_fs_set_deltification_limits to change them.  */
+  apr_size_t deltify_min_size;
+  apr_size_t deltify_max_size;
+
+  /* Berkeley DB operation counters and trail timing, read out via
+     svn_fs_get_stats.  Only maintained when the library is compiled
+     with -DSVN_FS_TRAIL_STATS; see the SVN_FS__COUNT macro below.  */
+  svn_fs_stats_t stats;
+
+  /* A cache of parsed NODE-REVISION skels, so that walking a path
+     doesn't hit the `nodes' table for every component of every
+     request.  Created lazily by the node revision accessors in
+     nodes-table.c; null until then.  */
+  struct svn_fs__node_cache_t *node_cache;
+
+  /* A block cache over reads from the `strings' table, so that
+     undeltification doesn't go back to Berkeley DB for every chunk
+     of the same base fulltexts.  Created lazily by
+     svn_fs__string_read; null until then.  */
+  struct svn_fs__string_cache_t *string_cache;
+
+  /* A cache of the youngest revision number and recent revision to
+     root-ID lookups.  Created lazily by the accessors in rev-table.c;
+     null until then.  */
+  struct svn_fs__rev_cache_t *rev_cache;
+
+  /* A cache of recently read or written transaction records, so a
+     large commit doesn't re-read its own transaction's row for every
+     editor call.  Created lazily by txn-table.c; null until then.  */
+  struct svn_fs__txn_cache_t *txn_cache;
+
+  /* A cache of the parsed entries lists of mutable directories, so
+     changing one entry doesn't re-read and re-parse the whole list.
+     Created lazily by dag.c; null until then.  */
+  struct svn_fs__dir_cache_t *dir_cache;
+
+  /* A table of canonical parsed IDs, so hot paths that meet the same
+     IDs over and over share one allocation.  Created lazily by
+     svn_fs__parse_id_interned in id.c; null until then.  */
+  struct svn_fs__id_cache_t *id_cache;
+
+  /* While a read batch is open on this filesystem (see
+     svn_fs_read_batch), the batch's trail; null otherwise.  When this
+     is set, svn_fs__retry_txn runs its body inside this trail instead
+     of opening a Berkeley DB transaction of its own.  */
+  struct trail_t *batch_trail;
+
   /* A kludge for handling errors noticed by APR pool cleanup functions.
 
      The APR pool cleanup functions can only return an apr_status_t
@@ -77,6 +152,38 @@ struct svn_fs_t {
 };
 
 
+/* Statistics instrumentation.  SVN_FS__COUNT (fs, field) bumps the
+   counter FIELD in FS->stats; place it as a statement just before the
+   Berkeley DB call it accounts for.  SVN_FS__STAT_ADD adds AMOUNT to
+   FIELD.  In builds without -DSVN_FS_TRAIL_STATS both reduce to
+   no-ops, so the hot paths carry no cost.  */
+#ifdef SVN_FS_TRAIL_STATS
+#define SVN_FS__COUNT(fs, field) ((fs)->stats.field++)
+#define SVN_FS__STAT_ADD(fs, field, amount) ((fs)->stats.field += (amount))
+#else
+#define SVN_FS__COUNT(fs, field) ((void) 0)
+#define SVN_FS__STAT_ADD(fs, field, amount) ((void) 0)
+#endif /* SVN_FS_TRAIL_STATS */
+
+
+/*** The commit stamp. ***/
+
+/* The name of the commit stamp file, kept alongside the Berkeley DB
+   environment in the filesystem's directory.  It holds the number of
+   the youngest revision as of the last commit made through this
+   library, so pollers can watch for new revisions with a stat and a
+   one-line read instead of a Berkeley DB transaction.  See
+   svn_fs_read_commit_stamp in svn_fs.h.  */
+#define SVN_FS__COMMIT_STAMP "commit-stamp"
+
+/* Record NEW_REV in FS's commit stamp file, replacing the old stamp
+   atomically.  Called from svn_fs_commit_txn once the commit is
+   durable; use POOL for temporary allocations.  */
+svn_error_t *svn_fs__stamp_commit (svn_fs_t *fs,
+                                   svn_revnum_t new_rev,
+                                   apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,280 @@
+/* gc.c : garbage-collecting the `strings' table
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "db.h"
+#include "apr_hash.h"
+#include "apr_tables.h"
+#include "svn_pools.h"
+#include "svn_fs.h"
+#include "fs.h"
+#include "err.h"
+#include "dbt.h"
+#include "skel.h"
+#include "key-gen.h"
+#include "trail.h"
+#include "strings-table.h"
+
+
+/* Aborted transactions and obsolete fulltexts leave records in the
+   `strings' table that no representation refers to any more, so the
+   database grows faster than the logical content does and dead pages
+   crowd live ones out of the cache.
+
+   The collector makes two passes: walk the `representations' table
+   gathering every string key any representation mentions, then walk
+   `strings' and delete the keys that were never mentioned.  Both
+   passes and the deletions run in one trail, so concurrent readers
+   see either all of the dead strings or none of them.  Berkeley DB
+   puts the freed pages on the database's free list for reuse; it
+   cannot return them to the operating system, so the file does not
+   shrink, but it stops growing until the reclaimed space is used
+   up.  */
+
+
+/* Close CURSOR after a scan of TABLE in FS.  Complain if the scan's
+   final error DB_ERR was anything but an ordinary end-of-table, or
+   if closing the cursor itself fails.  */
+static svn_error_t *
+finish_scan (svn_fs_t *fs,
+             const char *table,
+             DBC *cursor,
+             int db_err)
+{
+  int db_c_err = cursor->c_close (cursor);
+
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, apr_psprintf (fs->pool,
+                                        "gc: scanning `%s' table", table),
+                      db_err));
+  SVN_ERR (DB_WRAP (fs, apr_psprintf (fs->pool,
+                                      "gc: scanning `%s' table "
+                                      "(closing cursor)", table),
+                    db_c_err));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Walk the `representations' table of FS as part of TRAIL, adding
+   every string key any representation references to LIVE.  The keys
+   are copied into TRAIL->pool; the values are dummy non-null
+   pointers, since only membership matters.  */
+static svn_error_t *
+collect_rep_refs (apr_hash_t *live,
+                  svn_fs_t *fs,
+                  trail_t *trail)
+{
+  apr_size_t const next_key_len = strlen (svn_fs__next_key_key);
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_ERR (DB_WRAP (fs, "gc: scanning `representations' table "
+                    "(opening cursor)",
+                    fs->representations->cursor (fs->representations,
+                                                 trail->db_txn,
+                                                 &cursor, 0)));
+
+  while (1)
+    {
+      skel_t *rep;
+
+      svn_pool_clear (subpool);
+      do
+        db_err = cursor->c_get (cursor,
+                                svn_fs__result_dbt (&key),
+                                svn_fs__result_dbt_reuse (&value, trail),
+                                flags);
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+
+      /* The table's key-generation row references no strings.  */
+      if (key.size == next_key_len
+          && 0 == memcmp (key.data, svn_fs__next_key_key, next_key_len))
+        continue;
+
+      rep = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! rep)
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+           "gc: malformed representation `%.*s' in filesystem `%s'",
+           (int) key.size, (char *) key.data, fs->path);
+
+      if (svn_fs__matches_atom (rep->children->children, "fulltext"))
+        {
+          skel_t *str_key = rep->children->next;
+
+          apr_hash_set (live,
+                        apr_pstrndup (trail->pool,
+                                      str_key->data, str_key->len),
+                        str_key->len, (void *) 1);
+        }
+      else  /* delta: each entry is (OFFSET (DIFF SIZE CHECKSUM ...)),
+               and DIFF is ("svndiff" STRING-KEY).  */
+        {
+          skel_t *entry;
+
+          for (entry = rep->children->next; entry; entry = entry->next)
+            {
+              skel_t *window = entry->children->next;
+              skel_t *str_key = window->children->children->next;
+
+              apr_hash_set (live,
+                            apr_pstrndup (trail->pool,
+                                          str_key->data, str_key->len),
+                            str_key->len, (void *) 1);
+            }
+        }
+    }
+
+  svn_pool_destroy (subpool);
+  return finish_scan (fs, "representations", cursor, db_err);
+}
+
+
+/* Baton for txn_body_gc.  */
+struct gc_args
+{
+  svn_fs_t *fs;
+  apr_size_t deleted;
+};
+
+
+static svn_error_t *
+txn_body_gc (void *baton,
+             trail_t *trail)
+{
+  struct gc_args *args = baton;
+  svn_fs_t *fs = args->fs;
+  apr_size_t const next_key_len = strlen (svn_fs__next_key_key);
+  apr_size_t const refs_len = strlen (SVN_FS__STRING_REFS_SUFFIX);
+  apr_hash_t *live = apr_hash_make (trail->pool);
+  apr_array_header_t *dead = apr_array_make (trail->pool, 0,
+                                             sizeof (const char *));
+  apr_array_header_t *dead_refs = apr_array_make (trail->pool, 0,
+                                                  sizeof (const char *));
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+  int i;
+
+  args->deleted = 0;
+
+  SVN_ERR (collect_rep_refs (live, fs, trail));
+
+  /* Gather the dead keys before touching anything; deleting records
+     out from under an open cursor is asking for trouble.  Strings
+     are stored as sets of duplicate records, so visit each key only
+     once.  */
+  SVN_ERR (DB_WRAP (fs, "gc: scanning `strings' table (opening cursor)",
+                    fs->strings->cursor (fs->strings, trail->db_txn,
+                                         &cursor, 0)));
+
+  for (db_err = cursor->c_get (cursor,
+                               svn_fs__result_dbt (&key),
+                               svn_fs__nodata_dbt (&value),
+                               DB_FIRST);
+       db_err == 0;
+       db_err = cursor->c_get (cursor,
+                               svn_fs__result_dbt (&key),
+                               svn_fs__nodata_dbt (&value),
+                               DB_NEXT_NODUP))
+    {
+      svn_fs__track_dbt (&key, trail->pool);
+
+      if (key.size == next_key_len
+          && 0 == memcmp (key.data, svn_fs__next_key_key, next_key_len))
+        continue;
+
+      /* A record under "KEY-refs" is a string's reference count, not
+         a string; it lives and dies with the string it counts.  */
+      if (key.size > refs_len
+          && 0 == memcmp ((char *) key.data + key.size - refs_len,
+                          SVN_FS__STRING_REFS_SUFFIX, refs_len))
+        {
+          if (! apr_hash_get (live, key.data, key.size - refs_len))
+            (*((const char **) apr_array_push (dead_refs)))
+              = apr_pstrndup (trail->pool, key.data, key.size);
+          continue;
+        }
+
+      if (! apr_hash_get (live, key.data, key.size))
+        (*((const char **) apr_array_push (dead)))
+          = apr_pstrndup (trail->pool, key.data, key.size);
+    }
+
+  SVN_ERR (finish_scan (fs, "strings", cursor, db_err));
+
+  /* Reference counts of dead strings go first, so the deletes below
+     see uncounted strings and really remove the bytes.  */
+  for (i = 0; i < dead_refs->nelts; i++)
+    {
+      DBT query;
+
+      db_err = fs->strings->del
+        (fs->strings, trail->db_txn,
+         svn_fs__str_to_dbt (&query,
+                             (char *) ((const char **) dead_refs->elts)[i]),
+         0);
+      if (db_err != DB_NOTFOUND)
+        SVN_ERR (DB_WRAP (fs, "gc: deleting dead string reference count",
+                          db_err));
+    }
+
+  for (i = 0; i < dead->nelts; i++)
+    SVN_ERR (svn_fs__string_delete (fs,
+                                    ((const char **) dead->elts)[i],
+                                    trail));
+
+  args->deleted = dead->nelts;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_gc (apr_size_t *deleted_count,
+           svn_fs_t *fs,
+           apr_pool_t *pool)
+{
+  struct gc_args args;
+
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  args.fs = fs;
+  args.deleted = 0;
+  SVN_ERR (svn_fs__retry_txn (fs, txn_body_gc, &args, pool));
+
+  if (deleted_count)
+    *deleted_count = args.deleted;
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -18,7 +18,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "apr_hash.h"
+#include "svn_pools.h"
 #include "svn_fs.h"
+#include "fs.h"
 #include "id.h"
 #include "key-gen.h"
 #include "validate.h"
@@ -46,6 +49,10 @@ svn_fs__id_eq (const svn_fs_id_t *a, const svn_fs_id_t *b)
 {
   int i;
 
+  /* Interned IDs (see svn_fs__parse_id_interned) make this common.  */
+  if (a == b)
+    return 1;
+
   for (i = 0; a[i] == b[i]; i++)
     if (a[i] == -1)
       return 1;
@@ -183,6 +190,32 @@ svn_fs__id_is_parent (const svn_fs_id_t *parent,
 
 /* Parsing and unparsing node ID's.  */
 
+int
+svn_fs__parse_id_into (svn_fs_id_t *id,
+                       const char *data,
+                       apr_size_t data_len)
+{
+  int i = 0;
+  const char *end = data + data_len;
+
+  for (;;)
+    {
+      const char *next;
+      id[i++] = svn_fs__getsize (data, end - data, &next, 100000000);
+      if (next == end)
+        break;
+      if (! next
+          || *next != '.')
+        return 0;
+
+      data = next + 1;
+    }
+
+  id[i] = -1;
+  return i;
+}
+
+
 svn_fs_id_t *
 svn_fs_parse_id (const char *data,
                  apr_size_t data_len,
@@ -190,7 +223,7 @@ svn_fs_parse_id (const char *data,
 {
   svn_fs_id_t *id;
   int id_len;
-  
+
   /* Count the number of components in the ID, and check its syntax.  */
   id_len = svn_fs__count_id_components (data, data_len);
   if (id_len == 0)
@@ -207,28 +240,11 @@ svn_fs_parse_id (const char *data,
         abort(); /* couldn't malloc */
     }
 
-  {
-    int i = 0;
-    const char *end = data + data_len;
-
-    for (;;)
-      {
-        const char *next;
-        id[i++] = svn_fs__getsize (data, end - data, &next, 100000000);
-        if (next == end)
-          break;
-        if (! next
-            || *next != '.')
-          {
-            if (! pool) free (id);
-            return 0;
-          }
-
-        data = next + 1;
-      }
-
-    id[i] = -1;
-  }
+  if (! svn_fs__parse_id_into (id, data, data_len))
+    {
+      if (! pool) free (id);
+      return 0;
+    }
 
   return id;
 }
@@ -259,6 +275,62 @@ svn_fs_unparse_id (const svn_fs_id_t *id,
 }
 
 
+
+/* Interning ID's.  */
+
+/* A table of canonical ID objects for a filesystem, so that hot
+   paths which meet the same IDs over and over --- walking directory
+   entries during dir_delta, for instance --- can share one parsed
+   copy instead of allocating a fresh array per encounter.
+
+   IDs are just names --- they never change or go away while the
+   filesystem object lives --- so nothing here can go stale, and
+   there is no eviction: the table grows with the number of distinct
+   IDs seen, each of which is only a few words long.  */
+struct svn_fs__id_cache_t
+{
+  /* The pool the table and the canonical IDs live in; a subpool of
+     the filesystem's pool.  */
+  apr_pool_t *pool;
+
+  /* Maps unparsed ID strings onto svn_fs_id_t arrays.  */
+  apr_hash_t *hash;
+};
+
+
+svn_fs_id_t *
+svn_fs__parse_id_interned (svn_fs_t *fs,
+                           const char *data,
+                           apr_size_t data_len)
+{
+  struct svn_fs__id_cache_t *cache = fs->id_cache;
+  svn_fs_id_t *id;
+
+  if (! cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+
+      cache = apr_pcalloc (pool, sizeof (*cache));
+      cache->pool = pool;
+      cache->hash = apr_hash_make (pool);
+      fs->id_cache = cache;
+    }
+
+  id = apr_hash_get (cache->hash, data, data_len);
+  if (id)
+    return id;
+
+  id = svn_fs_parse_id (data, data_len, cache->pool);
+  if (! id)
+    return 0;
+
+  apr_hash_set (cache->hash,
+                apr_pstrndup (cache->pool, data, data_len), data_len,
+                id);
+  return id;
+}
+
+
 
 /* Copying ID's.  */
 
@@ -33,6 +33,31 @@ int svn_fs__id_eq (const svn_fs_id_t *a, const svn_fs_id_t *b);
 int svn_fs__id_length (const svn_fs_id_t *id);
 
 
+/* Parse the LEN bytes at DATA as a node or node revision ID, storing
+   the components in ID, which the caller must have sized to hold
+   svn_fs__count_id_components (DATA, LEN) components plus the final
+   -1.  Return the number of components parsed, or zero if DATA is not
+   a well-formed ID.
+
+   Unlike svn_fs_parse_id, this performs no allocation, which matters
+   in code invoked very frequently, like the `nodes' table btree
+   comparator.  */
+int svn_fs__parse_id_into (svn_fs_id_t *id,
+                           const char *data,
+                           apr_size_t len);
+
+
+/* Parse the LEN bytes at DATA as a node or node revision ID, and
+   return FS's canonical copy of that ID, or zero if DATA is not a
+   well-formed ID.  Repeated calls with the same ID return the same
+   object, so equal interned IDs compare equal as pointers and share
+   one allocation.  The returned ID lives as long as FS and must not
+   be modified; copy it first if you need to.  */
+svn_fs_id_t *svn_fs__parse_id_interned (svn_fs_t *fs,
+                                        const char *data,
+                                        apr_size_t len);
+
+
 /* Return the predecessor id to ID, allocated in POOL.  If there is no
    possible predecessor id, return NULL.
 
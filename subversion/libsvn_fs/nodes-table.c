@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "svn_fs.h"
+#include "svn_pools.h"
 
 #include "db.h"
 #include "fs.h"
@@ -94,6 +95,37 @@ parse_node_revision_dbt (const DBT *d)
 }
 
 
+/* The number of ID components compare_nodes_keys can parse into stack
+   buffers.  Node revision ID's from very deeply branched nodes can
+   exceed this; those fall back to `malloc'.  */
+#define MAX_STACK_ID_LEN 32
+
+
+/* Parse a node revision ID from D.  If the ID has no more than
+   BUF_LEN components, parse it into BUF (which must have room for
+   BUF_LEN components plus the final -1) and return BUF; otherwise
+   fall back to an ID allocated with `malloc', which the caller must
+   free.  Return zero if D does not contain a well-formed node
+   revision ID.  */
+static svn_fs_id_t *
+parse_node_revision_dbt_buf (const DBT *d, svn_fs_id_t *buf, int buf_len)
+{
+  int id_len = svn_fs__count_id_components (d->data, d->size);
+
+  /* It must be a node revision ID, not a node ID.  */
+  if (id_len == 0 || (id_len & 1))
+    return 0;
+
+  if (id_len > buf_len)
+    return parse_node_revision_dbt (d);
+
+  if (! svn_fs__parse_id_into (buf, d->data, d->size))
+    return 0;
+
+  return buf;
+}
+
+
 /* The key comparison function for the `nodes' table.
 
    Strictly speaking, this function only needs to handle strings that
@@ -109,9 +141,16 @@ parse_node_revision_dbt (const DBT *d)
    malformed key comes before any well-formed key; and two malformed
    keys come in byte-by-byte order.
 
-   NOTE WELL: this function and its helpers use `malloc' to get space
-   for the parsed node revision ID's.  In general, we try to use pools
-   for everything in Subversion, but in this case it's not practical.
+   Berkeley DB invokes this function for every key comparison it makes
+   while searching or rebalancing the btree, so it's one of the
+   hottest spots in the filesystem.  To avoid allocating on every
+   comparison, we parse the ID's into stack buffers; only ID's too
+   long for the buffers (from very deeply branched nodes) fall back to
+   `malloc'.
+
+   NOTE WELL: the fallback path uses `malloc' to get space for the
+   parsed node revision ID's.  In general, we try to use pools for
+   everything in Subversion, but in this case it's not practical.
    Berkeley DB doesn't provide any way to pass a baton through to the
    btree comparison function.  Even if it did, since Berkeley DB needs
    to invoke the comparison function at pretty arbitrary times, you'd
@@ -125,8 +164,9 @@ parse_node_revision_dbt (const DBT *d)
 static int
 compare_nodes_keys (DB *dummy, const DBT *ak, const DBT *bk)
 {
-  svn_fs_id_t *a = parse_node_revision_dbt (ak);
-  svn_fs_id_t *b = parse_node_revision_dbt (bk);
+  svn_fs_id_t a_buf[MAX_STACK_ID_LEN + 1], b_buf[MAX_STACK_ID_LEN + 1];
+  svn_fs_id_t *a = parse_node_revision_dbt_buf (ak, a_buf, MAX_STACK_ID_LEN);
+  svn_fs_id_t *b = parse_node_revision_dbt_buf (bk, b_buf, MAX_STACK_ID_LEN);
   int result;
 
   /* Two well-formed keys are compared by the rules in `structure'.  */
@@ -143,8 +183,8 @@ compare_nodes_keys (DB *dummy, const DBT *ak, const DBT *bk)
   else
     result = svn_fs__compare_dbt (ak, bk);
 
-  if (a) free (a);
-  if (b) free (b);
+  if (a && a != a_buf) free (a);
+  if (b && b != b_buf) free (b);
 
   return result;
 }
@@ -222,8 +262,8 @@ is_mutable_header (skel_t *skel)
 }
 
 
-static int
-is_valid_node_revision (skel_t *skel)
+int
+svn_fs__is_valid_node_revision (skel_t *skel)
 {
   int len = svn_fs__list_length (skel);
 
@@ -276,16 +316,21 @@ svn_fs__new_node_id (svn_fs_id_t **id_p,
   svn_fs_id_t *id;
 
   /* Create a database cursor.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "choosing new node ID (creating cursor)",
                     fs->nodes->cursor (fs->nodes, trail->db_txn, &cursor, 0)));
 
   /* Find the last entry in the `nodes' table, and increment its node
      number.  */
-  db_err = cursor->c_get (cursor,
-                          svn_fs__result_dbt (&key),
-                          svn_fs__nodata_dbt (&value),
-                          DB_LAST);
-  svn_fs__track_dbt (&key, trail->pool);
+  do
+    {
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor,
+                              svn_fs__result_dbt_reuse (&key, trail),
+                              svn_fs__nodata_dbt (&value),
+                              DB_LAST);
+    }
+  while (svn_fs__retry_dbt_reuse (&key, trail, db_err));
   if (db_err)
     {
       /* Free the cursor.  Ignore any error value --- the error above
@@ -336,7 +381,8 @@ svn_fs__new_node_id (svn_fs_id_t **id_p,
    If DB_TXN is non-zero, perform the operation as part of that
    Berkeley DB transaction.  */
 static int
-last_key_before (DB *db,
+last_key_before (svn_fs_t *fs,
+                 DB *db,
                  DB_TXN *db_txn,
                  DBT *key)
 {
@@ -345,6 +391,7 @@ last_key_before (DB *db,
   DBT temp_key, value;
 
   /* Create a cursor into the table.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   DB_ERR (db->cursor (db, db_txn, &cursor, 0));
 
   /* Position CURSOR to the first table entry at or after KEY.
@@ -353,6 +400,7 @@ last_key_before (DB *db,
   temp_key.data = key->data;
   temp_key.size = key->size;
   svn_fs__nodata_dbt (&value);
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor, &temp_key, &value, DB_SET_RANGE);
   if (db_err && db_err != DB_NOTFOUND)
     {
@@ -366,6 +414,7 @@ last_key_before (DB *db,
      If db_err == DB_NOTFOUND, then we couldn't find any entry at or
      after KEY, so the record we want must be the last record in the
      table.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor, key, svn_fs__nodata_dbt (&value),
                           db_err == DB_NOTFOUND ? DB_LAST : DB_PREV);
   if (db_err)
@@ -406,6 +455,7 @@ svn_fs__new_successor_id (svn_fs_id_t **successor_p,
   new_id[id_len - 1]++;         /* increment the revision number */
 
   /* Check to see if there already exists a node whose ID is NEW_ID.  */
+  SVN_FS__COUNT (fs, db_gets);
   db_err = fs->nodes->get (fs->nodes, db_txn,
                            svn_fs__id_to_dbt (&key, new_id, pool),
                            svn_fs__nodata_dbt (&value),
@@ -437,7 +487,7 @@ svn_fs__new_successor_id (svn_fs_id_t **successor_p,
   new_id[id_len + 1] = 1;
   new_id[id_len + 2] = -1;
   SVN_ERR (DB_WRAP (fs, "checking for next node branch",
-                    last_key_before (fs->nodes, db_txn,
+                    last_key_before (fs, fs->nodes, db_txn,
                                      svn_fs__id_to_dbt (&key, new_id, pool))));
 
   {
@@ -490,6 +540,201 @@ svn_fs__new_successor_id (svn_fs_id_t **successor_p,
 }
 
 
+
+/* Caching NODE-REVISION skels.  */
+
+/* Reading a node revision means a trip through Berkeley DB plus a
+   skel parse, and open_path in tree.c does that for every component
+   of every path it resolves.  Since the same directories come up
+   over and over, we keep a small LRU cache of parsed skels, keyed by
+   the node revision ID.
+
+   Writing a node revision evicts that ID, and an aborted trail
+   throws the whole cache away (see svn_fs__clear_node_cache), since
+   anything read inside the aborted transaction may never have been
+   committed.
+
+   ### todo: the cache can't see writes made by another process
+   sharing the database --- notably another deltifier.  All the
+   current writers go through this filesystem object, but that's an
+   accident of how the code is deployed, not a guarantee.  */
+
+/* How many node revisions to keep cached per filesystem.  */
+#define NODE_CACHE_SIZE 128
+
+/* One cached node revision.  The entry's key, skel, and the entry
+   itself all live in the entry's own subpool, so eviction returns
+   the memory.  */
+typedef struct cache_entry_t
+{
+  const char *key;              /* The node revision ID, unparsed. */
+  apr_size_t key_len;
+  skel_t *skel;                 /* The parsed NODE-REVISION skel. */
+  apr_pool_t *pool;             /* Subpool holding this entry. */
+  struct cache_entry_t *prev;   /* More recently used entry, or null. */
+  struct cache_entry_t *next;   /* Less recently used entry, or null. */
+} cache_entry_t;
+
+struct svn_fs__node_cache_t
+{
+  apr_pool_t *pool;             /* Subpool of fs->pool holding the cache. */
+  apr_hash_t *hash;             /* Map from ID string to cache_entry_t. */
+  cache_entry_t *first;         /* Most recently used entry. */
+  cache_entry_t *last;          /* Least recently used entry. */
+  int count;                    /* Number of entries in the cache. */
+};
+
+
+/* Return FS's node revision cache, creating it if necessary.  */
+static struct svn_fs__node_cache_t *
+get_node_cache (svn_fs_t *fs)
+{
+  if (! fs->node_cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+      struct svn_fs__node_cache_t *cache
+        = apr_pcalloc (pool, sizeof (*cache));
+
+      cache->pool = pool;
+      cache->hash = apr_hash_make (pool);
+      fs->node_cache = cache;
+    }
+  return fs->node_cache;
+}
+
+
+/* Take ENTRY out of CACHE's LRU list.  */
+static void
+cache_unlink (struct svn_fs__node_cache_t *cache, cache_entry_t *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->first = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->last = entry->prev;
+}
+
+
+/* Put ENTRY at the head of CACHE's LRU list.  */
+static void
+cache_link (struct svn_fs__node_cache_t *cache, cache_entry_t *entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->first;
+  if (cache->first)
+    cache->first->prev = entry;
+  cache->first = entry;
+  if (! cache->last)
+    cache->last = entry;
+}
+
+
+/* If FS's cache holds a skel for ID, return a copy of it allocated
+   in POOL, and freshen the entry; else return null.  */
+static skel_t *
+cache_lookup (svn_fs_t *fs, const svn_fs_id_t *id, apr_pool_t *pool)
+{
+  struct svn_fs__node_cache_t *cache = get_node_cache (fs);
+  svn_stringbuf_t *key = svn_fs_unparse_id (id, pool);
+  cache_entry_t *entry = apr_hash_get (cache->hash, key->data, key->len);
+
+  if (! entry)
+    return NULL;
+
+  if (entry != cache->first)
+    {
+      cache_unlink (cache, entry);
+      cache_link (cache, entry);
+    }
+  return svn_fs__copy_skel (entry->skel, pool);
+}
+
+
+/* Record SKEL as the cached node revision for ID in FS, evicting the
+   least recently used entry if the cache is full.  */
+static void
+cache_insert (svn_fs_t *fs, const svn_fs_id_t *id, skel_t *skel)
+{
+  struct svn_fs__node_cache_t *cache = get_node_cache (fs);
+  apr_pool_t *pool;
+  cache_entry_t *entry;
+  svn_stringbuf_t *key;
+
+  if (cache->count >= NODE_CACHE_SIZE)
+    {
+      cache_entry_t *victim = cache->last;
+      cache_unlink (cache, victim);
+      apr_hash_set (cache->hash, victim->key, victim->key_len, NULL);
+      --cache->count;
+      svn_pool_destroy (victim->pool);
+    }
+
+  pool = svn_pool_create (cache->pool);
+  entry = apr_palloc (pool, sizeof (*entry));
+  key = svn_fs_unparse_id (id, pool);
+  entry->key = key->data;
+  entry->key_len = key->len;
+  entry->skel = svn_fs__copy_skel (skel, pool);
+  entry->pool = pool;
+
+  apr_hash_set (cache->hash, entry->key, entry->key_len, entry);
+  cache_link (cache, entry);
+  ++cache->count;
+}
+
+
+/* Forget any cached node revision whose unparsed ID is the KEY_LEN
+   bytes at KEY in FS.  */
+static void
+cache_remove_key (svn_fs_t *fs, const char *key, apr_size_t key_len)
+{
+  struct svn_fs__node_cache_t *cache = fs->node_cache;
+  cache_entry_t *entry;
+
+  if (! cache)
+    return;
+
+  entry = apr_hash_get (cache->hash, key, key_len);
+  if (entry)
+    {
+      cache_unlink (cache, entry);
+      apr_hash_set (cache->hash, entry->key, entry->key_len, NULL);
+      --cache->count;
+      svn_pool_destroy (entry->pool);
+    }
+}
+
+
+/* Forget any cached node revision for ID in FS.  Use POOL for
+   temporary allocation.  */
+static void
+cache_remove (svn_fs_t *fs, const svn_fs_id_t *id, apr_pool_t *pool)
+{
+  svn_stringbuf_t *key;
+
+  if (! fs->node_cache)
+    return;
+
+  key = svn_fs_unparse_id (id, pool);
+  cache_remove_key (fs, key->data, key->len);
+}
+
+
+void
+svn_fs__clear_node_cache (svn_fs_t *fs)
+{
+  if (fs->node_cache)
+    {
+      svn_pool_destroy (fs->node_cache->pool);
+      fs->node_cache = NULL;
+    }
+}
+
+
+
 
 /* Removing node revisions.  */
 svn_error_t *
@@ -498,13 +743,147 @@ svn_fs__delete_nodes_entry (svn_fs_t *fs,
                             trail_t *trail)
 {
   DBT key;
-  
+
+  SVN_FS__COUNT (fs, db_puts);
   SVN_ERR (DB_WRAP (fs, "deleting entry from `nodes' table",
                     fs->nodes->del (fs->nodes,
                                     trail->db_txn,
                                     svn_fs__id_to_dbt (&key, id, trail->pool),
                                     0)));
-  
+  cache_remove (fs, id, trail->pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs__delete_nodes_sweep (apr_size_t *deleted_p,
+                            svn_fs_t *fs,
+                            apr_hash_t *keys,
+                            trail_t *trail)
+{
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  apr_size_t deleted = 0;
+  DBC *cursor;
+  DBT key, value;
+  int db_err, db_c_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_FS__COUNT (fs, db_cursor_ops);
+  SVN_ERR (DB_WRAP (fs, "sweeping `nodes' table (opening cursor)",
+                    fs->nodes->cursor (fs->nodes, trail->db_txn,
+                                       &cursor, 0)));
+
+  while (1)
+    {
+      svn_pool_clear (subpool);
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor,
+                              svn_fs__result_dbt (&key),
+                              svn_fs__nodata_dbt (&value),
+                              flags);
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+
+      if (! apr_hash_get (keys, key.data, key.size))
+        continue;
+
+      SVN_FS__COUNT (fs, db_puts);
+      db_err = cursor->c_del (cursor, 0);
+      if (db_err)
+        break;
+
+      cache_remove_key (fs, key.data, key.size);
+      deleted++;
+    }
+
+  svn_pool_destroy (subpool);
+
+  /* Check for errors, but close the cursor first.  */
+  db_c_err = cursor->c_close (cursor);
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "sweeping `nodes' table", db_err));
+  SVN_ERR (DB_WRAP (fs, "sweeping `nodes' table (closing cursor)",
+                    db_c_err));
+
+  if (deleted_p)
+    *deleted_p = deleted;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs__walk_node_revisions (svn_fs_t *fs,
+                             svn_fs__node_rev_walk_func_t walk_func,
+                             void *walk_baton,
+                             trail_t *trail)
+{
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  DBC *cursor;
+  DBT key, value;
+  int db_err, db_c_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_FS__COUNT (fs, db_cursor_ops);
+  SVN_ERR (DB_WRAP (fs, "walking `nodes' table (opening cursor)",
+                    fs->nodes->cursor (fs->nodes, trail->db_txn,
+                                       &cursor, 0)));
+
+  while (1)
+    {
+      svn_fs_id_t id_buf[MAX_STACK_ID_LEN + 1];
+      svn_fs_id_t *id;
+      skel_t *skel;
+
+      svn_pool_clear (subpool);
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor,
+                              svn_fs__result_dbt (&key),
+                              svn_fs__result_dbt (&value),
+                              flags);
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+      svn_fs__track_dbt (&value, subpool);
+
+      id = parse_node_revision_dbt_buf (&key, id_buf, MAX_STACK_ID_LEN);
+      if (! id)
+        {
+          err = svn_fs__err_corrupt_nodes_key (fs);
+          break;
+        }
+
+      skel = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! skel
+          || (! fs->trusted_reads
+              && ! svn_fs__is_valid_node_revision (skel)))
+        err = svn_fs__err_corrupt_node_revision (fs, id);
+      else
+        err = walk_func (walk_baton, id, skel, trail);
+
+      if (id != id_buf)
+        free (id);
+      if (err)
+        break;
+    }
+
+  svn_pool_destroy (subpool);
+
+  /* Check for errors, but close the cursor first.  */
+  db_c_err = cursor->c_close (cursor);
+  if (err)
+    return err;
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "walking `nodes' table", db_err));
+  SVN_ERR (DB_WRAP (fs, "walking `nodes' table (closing cursor)",
+                    db_c_err));
+
   return SVN_NO_ERROR;
 }
 
@@ -524,11 +903,23 @@ svn_fs__get_node_revision (skel_t **skel_p,
   int db_err;
   DBT key, value;
 
-  db_err = fs->nodes->get (fs->nodes, trail->db_txn,
-                           svn_fs__id_to_dbt (&key, id, trail->pool),
-                           svn_fs__result_dbt (&value),
-                           0);
-  svn_fs__track_dbt (&value, trail->pool);
+  /* Hand back the cached skel if we have one.  */
+  skel = cache_lookup (fs, id, trail->pool);
+  if (skel)
+    {
+      *skel_p = skel;
+      return SVN_NO_ERROR;
+    }
+
+  do
+    {
+      SVN_FS__COUNT (fs, db_gets);
+      db_err = fs->nodes->get (fs->nodes, trail->db_txn,
+                               svn_fs__id_to_dbt (&key, id, trail->pool),
+                               svn_fs__result_dbt_reuse (&value, trail),
+                               0);
+    }
+  while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
 
   /* If there's no such node, return an appropriately specific error.  */
   if (db_err == DB_NOTFOUND)
@@ -540,9 +931,17 @@ svn_fs__get_node_revision (skel_t **skel_p,
   /* Parse and check the NODE-REVISION skel.  */
   skel = svn_fs__parse_skel (value.data, value.size, trail->pool);
   if (! skel
-      || ! is_valid_node_revision (skel))
+      || (! fs->trusted_reads
+          && ! svn_fs__is_valid_node_revision (skel)))
     return svn_fs__err_corrupt_node_revision (fs, id);
 
+  /* The parsed skel points into the trail's scratch buffer, which the
+     next retrieval overwrites; copy it into pool storage before
+     anyone hangs onto it.  */
+  skel = svn_fs__copy_skel (skel, trail->pool);
+
+  cache_insert (fs, id, skel);
+
   *skel_p = skel;
   return SVN_NO_ERROR;
 }
@@ -558,15 +957,21 @@ svn_fs__put_node_revision (svn_fs_t *fs,
   apr_pool_t *pool = trail->pool;
   DBT key, value;
 
-  if (! is_valid_node_revision (skel))
+  if (! svn_fs__is_valid_node_revision (skel))
     return svn_fs__err_corrupt_node_revision (fs, id);
 
+  SVN_FS__COUNT (fs, db_puts);
   SVN_ERR (DB_WRAP (fs, "storing node revision",
                     fs->nodes->put (fs->nodes, db_txn,
                                     svn_fs__id_to_dbt (&key, id, pool),
                                     svn_fs__skel_to_dbt (&value, skel, pool),
                                     0)));
 
+  /* The old skel is dead; don't let anyone read it from the cache.
+     We don't cache the new skel here --- this trail might yet abort,
+     and the next reader will repopulate the entry.  */
+  cache_remove (fs, id, pool);
+
   return 0;
 }
 
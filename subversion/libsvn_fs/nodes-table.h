@@ -63,6 +63,46 @@ svn_error_t *svn_fs__delete_nodes_entry (svn_fs_t *fs,
                                          trail_t *trail);
 
 
+/* Delete from FS's `nodes' table every node revision whose unparsed
+   ID appears as a key in KEYS (a hash whose keys are ID strings and
+   whose values are anything non-null), as part of TRAIL.  Set
+   *DELETED_P (if it is non-null) to the number of entries removed.
+
+   This makes one sequential cursor pass over the table, so deleting
+   the nodes of many dead transactions costs a single sweep rather
+   than a btree lookup per node.  Like svn_fs__delete_nodes_entry,
+   this does not check mutability; the caller must put only doomed
+   IDs in KEYS.  */
+svn_error_t *svn_fs__delete_nodes_sweep (apr_size_t *deleted_p,
+                                         svn_fs_t *fs,
+                                         apr_hash_t *keys,
+                                         trail_t *trail);
+
+
+/* A callback for svn_fs__walk_node_revisions.  ID is the parsed node
+   revision ID and SKEL its well-formed NODE-REVISION skel; both live
+   in scratch storage that is reclaimed as soon as the callback
+   returns, so anything the callback keeps must be copied.  */
+typedef svn_error_t *(*svn_fs__node_rev_walk_func_t) (void *baton,
+                                                      const svn_fs_id_t *id,
+                                                      skel_t *skel,
+                                                      trail_t *trail);
+
+
+/* Call WALK_FUNC, passing WALK_BATON, for every node revision in
+   FS's `nodes' table, in ID order, as part of TRAIL.
+
+   A single cursor sweeps the table sequentially, so visiting N node
+   revisions costs one pass rather than the N separate btree descents
+   that N calls to svn_fs__get_node_revision would make.  Deltifying
+   sweeps, verification and the like should scan this way.  */
+svn_error_t *svn_fs__walk_node_revisions (svn_fs_t *fs,
+                                          svn_fs__node_rev_walk_func_t
+                                            walk_func,
+                                          void *walk_baton,
+                                          trail_t *trail);
+
+
 /* Set *SUCCESSOR_P to the ID of an immediate successor to node
    revision ID in FS that does not exist yet, as part of TRAIL.
    Allocate *SUCCESSOR_P in TRAIL->pool.
@@ -102,6 +142,16 @@ svn_error_t *svn_fs__put_node_revision (svn_fs_t *fs,
                                         trail_t *trail);
 
 
+/* Return non-zero iff SKEL is a well-formed NODE-REVISION skel.  */
+int svn_fs__is_valid_node_revision (skel_t *skel);
+
+
+/* Discard FS's in-memory cache of NODE-REVISION skels.  Called when
+   a trail aborts, since skels read within the aborted transaction
+   may never have been committed.  */
+void svn_fs__clear_node_cache (svn_fs_t *fs);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -31,16 +31,21 @@ extern "C" {
 
 /* Get the value of the property NAME in PROPLIST, storing it in
    *VALUE_P.  Do all necessary allocations in POOL.  If NAME is not
-   found in PROPLIST, set *VALUE_P to NULL.  */
+   found in PROPLIST, set *VALUE_P to NULL.  FS is the filesystem
+   PROPLIST was read from; its trusted-reads setting governs whether
+   PROPLIST's structure is re-validated first.  */
 svn_error_t *svn_fs__get_prop (svn_string_t **value_p,
+                               svn_fs_t *fs,
                                skel_t *proplist,
                                const char *name,
                                apr_pool_t *pool);
 
 /* Set *PROP_HASH to a hash table mapping const char * names to
    svn_stringbuf_t * values, based on PROPLIST.  The hash table and
-   its name/value pairs are all allocated in POOL.  */
+   its name/value pairs are all allocated in POOL.  FS is the
+   filesystem PROPLIST was read from, as with svn_fs__get_prop.  */
 svn_error_t *svn_fs__make_prop_hash (apr_hash_t **prop_hash,
+                                     svn_fs_t *fs,
                                      skel_t *proplist,
                                      apr_pool_t *pool);
 
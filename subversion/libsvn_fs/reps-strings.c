@@ -94,11 +94,101 @@ rep_set_mutable_flag (skel_t *rep, apr_pool_t *pool)
 {
   if (! rep_is_mutable (rep))
     svn_fs__append (svn_fs__str_atom ("mutable", pool), rep->children);
-    
+
   return;
 }
 
 
+/* Find the ("md5" DIGEST) flag in REP's header, if any.  Return the
+   flag skel, or NULL if the header records no checksum.  */
+static skel_t *
+rep_checksum_flag (skel_t *rep)
+{
+  skel_t *flag = rep->children->children->next;
+
+  while (flag)
+    {
+      if ((! flag->is_atom)
+          && svn_fs__matches_atom (flag->children, "md5"))
+        return flag;
+
+      flag = flag->next;
+    }
+
+  return NULL;
+}
+
+
+/* If REP's header records a fulltext checksum, copy it into DIGEST
+   and return TRUE; else return FALSE and leave DIGEST alone.  */
+static int
+rep_get_checksum (unsigned char digest[MD5_DIGESTSIZE], skel_t *rep)
+{
+  skel_t *flag = rep_checksum_flag (rep);
+
+  if (flag
+      && flag->children->next
+      && flag->children->next->is_atom
+      && flag->children->next->len == MD5_DIGESTSIZE)
+    {
+      memcpy (digest, flag->children->next->data, MD5_DIGESTSIZE);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+/* Record DIGEST as the checksum of REP's full contents, by adding an
+   ("md5" DIGEST) flag to REP's header, replacing any checksum already
+   there.  Allocate the flag in POOL; it is advisable that POOL be at
+   least as long-lived as the pool REP is allocated in.  */
+static void
+rep_set_checksum (skel_t *rep,
+                  const unsigned char digest[MD5_DIGESTSIZE],
+                  apr_pool_t *pool)
+{
+  skel_t *flag = rep_checksum_flag (rep);
+
+  if (! flag)
+    {
+      flag = svn_fs__make_empty_list (pool);
+      svn_fs__prepend (svn_fs__str_atom ("md5", pool), flag);
+      svn_fs__append (flag, rep->children);
+    }
+
+  /* Hang the digest off the "md5" atom, dropping any old digest.  */
+  flag->children->next = svn_fs__mem_atom (digest, MD5_DIGESTSIZE, pool);
+}
+
+
+/* Remove any recorded checksum from REP's header.  Return TRUE if a
+   checksum was there to remove, FALSE if the header had none.  Call
+   this whenever REP's contents change out from under a previously
+   recorded checksum.  */
+static int
+rep_clear_checksum (skel_t *rep)
+{
+  skel_t *prev = rep->children->children;
+  skel_t *flag = prev->next;
+
+  while (flag)
+    {
+      if ((! flag->is_atom)
+          && svn_fs__matches_atom (flag->children, "md5"))
+        {
+          prev->next = flag->next;
+          return TRUE;
+        }
+
+      prev = flag;
+      flag = flag->next;
+    }
+
+  return FALSE;
+}
+
+
 /* Return a `fulltext' rep skel which references the string STR_KEY,
    performing allocations in POOL.  If MUTABLE is non-zero, make the
    representation mutable.  If non-NULL, STR_KEY will be copied into
@@ -668,25 +758,25 @@ svn_fs__get_mutable_rep (const char **new_rep,
           return SVN_NO_ERROR;
         }
 
-      /* If REP is not mutable, we have to make a mutable copy.  It is
-         a deep copy -- we copy the immutable rep's data.  Note that
-         we copy it as fulltext, no matter how the immutable rep
+      /* If REP is not mutable, we have to make a mutable copy.  Note
+         that we make it fulltext, no matter how the immutable rep
          represents the data.  */
       if (rep_is_fulltext (rep_skel))
         {
-          /* The easy case -- copy the fulltext string directly. */
-          const char *old_str, *new_str;
+          /* The easy case -- share the fulltext string.  The new rep
+             is just another reference to the same bytes; most
+             mutable copies are cleared and rewritten, or thrown away
+             with an aborted transaction, without their inherited
+             contents ever being read, so usually nothing is ever
+             duplicated at all.  Whoever writes through the new rep
+             gives it a private string first (see
+             svn_fs__string_unshare).  */
+          const char *old_str;
 
-          /* Step 1:  Copy the string to which the rep refers. */
           SVN_ERR (fulltext_string_key (&old_str, rep_skel, trail->pool));
-          SVN_ERR (svn_fs__string_copy (fs, &new_str, old_str, trail));
-          
-          /* Step 2:  Make this rep mutable. */
+          SVN_ERR (svn_fs__string_addref (fs, old_str, trail));
+
           rep_set_mutable_flag (rep_skel, trail->pool);
-          
-          /* Step 3:  Change the string key to which this rep points. */
-          rep_skel->children->next->data = new_str;
-          rep_skel->children->next->len = strlen (new_str);
         }
       else
         {
@@ -834,6 +924,17 @@ struct rep_read_baton
   /* Used for temporary allocations, iff `trail' (above) is null.  */
   apr_pool_t *pool;
 
+  /* Digest of the data read through this stream so far.  Only
+     maintained when `checking_checksum' is set.  */
+  apr_md5_ctx_t md5_context;
+
+  /* True iff this stream started at offset zero and has not yet hit
+     the end of the contents; such a stream sees the rep's full
+     contents in order, so when it does hit the end, its digest can be
+     checked against the checksum recorded in the rep's header.
+     Streams that start mid-contents never check.  */
+  svn_boolean_t checking_checksum;
+
 };
 
 
@@ -852,6 +953,9 @@ rep_read_get_baton (svn_fs_t *fs,
   b->pool = pool;
   b->rep_key = rep_key;
   b->offset = offset;
+  b->checking_checksum = (rep_key != NULL) && (offset == 0);
+  if (b->checking_checksum)
+    apr_md5_init (&b->md5_context);
 
   return b;
 }
@@ -919,6 +1023,22 @@ svn_fs__rep_contents_size (apr_size_t *size_p,
 }
 
 
+svn_error_t *
+svn_fs__rep_checksum (unsigned char digest[MD5_DIGESTSIZE],
+                      svn_boolean_t *known_p,
+                      svn_fs_t *fs,
+                      const char *rep,
+                      trail_t *trail)
+{
+  skel_t *rep_skel;
+
+  SVN_ERR (svn_fs__read_rep (&rep_skel, fs, rep, trail));
+  *known_p = rep_get_checksum (digest, rep_skel) ? TRUE : FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_fs__rep_contents (svn_string_t *str,
                       svn_fs_t *fs,
@@ -994,11 +1114,35 @@ txn_body_read_rep (void *baton, trail_t *trail)
 }
 
 
+struct read_checksum_args
+{
+  struct rep_read_baton *rb;                /* Whose rep.          */
+  unsigned char digest[MD5_DIGESTSIZE];     /* The recorded value. */
+  svn_boolean_t known;                      /* Was one recorded?   */
+};
+
+
+/* BATON is of type `read_checksum_args':
+   Fetch the checksum recorded for BATON->rb->rep_key in
+   BATON->rb->fs, as part of TRAIL.  */
+static svn_error_t *
+txn_body_read_checksum (void *baton, trail_t *trail)
+{
+  struct read_checksum_args *args = baton;
+
+  SVN_ERR (svn_fs__rep_checksum (args->digest, &args->known,
+                                 args->rb->fs, args->rb->rep_key, trail));
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 rep_read_contents (void *baton, char *buf, apr_size_t *len)
 {
   struct rep_read_baton *rb = baton;
   struct read_rep_args args;
+  apr_size_t len_requested = *len;
 
   args.rb = rb;
   args.buf = buf;
@@ -1012,7 +1156,45 @@ rep_read_contents (void *baton, char *buf, apr_size_t *len)
                                 txn_body_read_rep,
                                 &args,
                                 rb->pool));
-  
+
+  if (rb->checking_checksum)
+    {
+      /* Fold the data into the digest only after the read has
+         succeeded, so a retried deadlock doesn't count bytes twice.  */
+      apr_md5_update (&rb->md5_context, buf, *len);
+
+      /* A short read means we just saw the last of the contents; if
+         the rep's header recorded a checksum, this is the moment to
+         compare.  A rep written before checksums existed, or one
+         still being written, records none and is passed through
+         unchecked.  */
+      if (*len < len_requested)
+        {
+          struct read_checksum_args csargs;
+          unsigned char digest[MD5_DIGESTSIZE];
+
+          rb->checking_checksum = FALSE;
+          apr_md5_final (digest, &rb->md5_context);
+
+          csargs.rb = rb;
+          if (rb->trail)
+            SVN_ERR (txn_body_read_checksum (&csargs, rb->trail));
+          else
+            SVN_ERR (svn_fs__retry_txn (rb->fs,
+                                        txn_body_read_checksum,
+                                        &csargs,
+                                        rb->pool));
+
+          if (csargs.known
+              && (memcmp (digest, csargs.digest, MD5_DIGESTSIZE) != 0))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, NULL,
+               rb->trail ? rb->trail->pool : rb->pool,
+               "rep_read_contents: checksum mismatch on rep \"%s\"",
+               rb->rep_key);
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -1027,14 +1209,25 @@ struct rep_write_baton
 
   /* The representation skel whose contents we want to write. */
   const char *rep_key;
-  
+
   /* If present, do the write as part of this trail, and use trail's
-     pool.  Otherwise, see `pool' below.  */ 
+     pool.  Otherwise, see `pool' below.  */
   trail_t *trail;
 
   /* Used for temporary allocations, iff `trail' (above) is null.  */
   apr_pool_t *pool;
 
+  /* Digest of the data written through this stream so far.  When the
+     stream is closed, the final digest is recorded in the rep's
+     header; every writer starts from an empty rep, so the stream's
+     digest is the digest of the rep's full contents.  */
+  apr_md5_ctx_t md5_context;
+
+  /* Set once the stream's first write has gone through, after which
+     the rep is known to own its string outright, and later writes
+     can skip the shared-string check.  */
+  svn_boolean_t unshared;
+
 };
 
 
@@ -1051,6 +1244,7 @@ rep_write_get_baton (svn_fs_t *fs,
   b->trail = trail;
   b->pool = pool;
   b->rep_key = rep_key;
+  apr_md5_init (&b->md5_context);
 
   return b;
 }
@@ -1058,7 +1252,9 @@ rep_write_get_baton (svn_fs_t *fs,
 
 
 /* Write LEN bytes from BUF into the string represented via REP_KEY
-   in FS, starting at OFFSET in that string, as part of TRAIL.
+   in FS, starting at OFFSET in that string, as part of TRAIL.  If
+   CHECK_SHARED is set, first make sure the rep owns its string
+   outright, giving it a private copy if the string is shared.
 
    If the representation is not mutable, return the error
    SVN_FS_REP_NOT_MUTABLE. */
@@ -1067,10 +1263,11 @@ rep_write (svn_fs_t *fs,
            const char *rep_key,
            const char *buf,
            apr_size_t len,
+           svn_boolean_t check_shared,
            trail_t *trail)
 {
   skel_t *rep;
-        
+
   SVN_ERR (svn_fs__read_rep (&rep, fs, rep_key, trail));
 
   if (! rep_is_mutable (rep))
@@ -1081,7 +1278,32 @@ rep_write (svn_fs_t *fs,
   if (rep_is_fulltext (rep))
     {
       const char *str_key;
+
+      /* Appending invalidates any checksum recorded for the old
+         contents; drop it so nobody trusts it later.  The writer's
+         close function records a fresh one.  */
+      if (rep_clear_checksum (rep))
+        SVN_ERR (svn_fs__write_rep (fs, rep_key, rep, trail));
+
       SVN_ERR (fulltext_string_key (&str_key, rep, trail->pool));
+
+      /* A string inherited from another rep via
+         svn_fs__get_mutable_rep may be shared with it; we mustn't
+         append to those bytes.  */
+      if (check_shared)
+        {
+          const char *new_key = str_key;
+
+          SVN_ERR (svn_fs__string_unshare (fs, &new_key, TRUE, trail));
+          if (strcmp (new_key, str_key) != 0)
+            {
+              rep->children->next->data = new_key;
+              rep->children->next->len = strlen (new_key);
+              SVN_ERR (svn_fs__write_rep (fs, rep_key, rep, trail));
+              str_key = new_key;
+            }
+        }
+
       SVN_ERR (svn_fs__string_append (fs, &str_key, len, buf, trail));
     }
   else
@@ -1121,6 +1343,7 @@ txn_body_write_rep (void *baton, trail_t *trail)
                       args->wb->rep_key,
                       args->buf,
                       args->len,
+                      ! args->wb->unshared,
                       trail));
 
   return SVN_NO_ERROR;
@@ -1148,7 +1371,65 @@ rep_write_contents (void *baton, const char *buf, apr_size_t *len)
                                 txn_body_write_rep,
                                 &args,
                                 wb->pool));
-  
+
+  /* The write committed, so the rep owns its string now; later
+     writes needn't recheck.  (Only set this after the whole trail
+     has succeeded --- a retried deadlock rolls the unsharing back.)  */
+  wb->unshared = TRUE;
+
+  /* Fold the data into the stream's digest only after the write has
+     succeeded, so a retried deadlock doesn't count bytes twice.  */
+  apr_md5_update (&wb->md5_context, buf, *len);
+
+  return SVN_NO_ERROR;
+}
+
+
+struct record_checksum_args
+{
+  struct rep_write_baton *wb;               /* Whose rep.       */
+  unsigned char digest[MD5_DIGESTSIZE];     /* What to record.  */
+};
+
+
+/* BATON is of type `record_checksum_args':
+   Record BATON->digest in the header of BATON->wb->rep_key's
+   representation in BATON->wb->fs, as part of TRAIL.  */
+static svn_error_t *
+txn_body_record_checksum (void *baton, trail_t *trail)
+{
+  struct record_checksum_args *args = baton;
+  skel_t *rep;
+
+  SVN_ERR (svn_fs__read_rep (&rep, args->wb->fs, args->wb->rep_key, trail));
+  rep_set_checksum (rep, args->digest, trail->pool);
+  SVN_ERR (svn_fs__write_rep (args->wb->fs, args->wb->rep_key, rep, trail));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Close function for the rep write stream: finish the stream's digest
+   and record it in the rep's header, so readers can verify the
+   contents came back intact.  */
+static svn_error_t *
+rep_write_close_contents (void *baton)
+{
+  struct rep_write_baton *wb = baton;
+  struct record_checksum_args args;
+
+  args.wb = wb;
+  apr_md5_final (args.digest, &wb->md5_context);
+
+  /* If we got a trail, use it; else make one. */
+  if (wb->trail)
+    SVN_ERR (txn_body_record_checksum (&args, wb->trail));
+  else
+    SVN_ERR (svn_fs__retry_txn (wb->fs,
+                                txn_body_record_checksum,
+                                &args,
+                                wb->pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -1168,7 +1449,9 @@ svn_fs__rep_contents_read_stream (svn_fs_t *fs,
   svn_stream_t *rs = svn_stream_create (rb, pool);
   svn_stream_set_read (rs, rep_read_contents);
 
-  return rs;
+  /* Readers tend to nibble; stage the contents so each trip into the
+     database pulls a sizable chunk. */
+  return svn_stream_buffered (rs, 0, pool);
 }
 
                                        
@@ -1183,6 +1466,7 @@ svn_fs__rep_contents_write_stream (svn_fs_t *fs,
 
   svn_stream_t *ws = svn_stream_create (wb, pool);
   svn_stream_set_write (ws, rep_write_contents);
+  svn_stream_set_close (ws, rep_write_close_contents);
 
   return ws;
 }
@@ -1206,12 +1490,33 @@ svn_fs__rep_contents_clear (svn_fs_t *fs,
 
   if (rep_is_fulltext (rep_skel))
     {
+      /* Any recorded checksum described the old contents; drop it. */
+      if (rep_clear_checksum (rep_skel))
+        SVN_ERR (svn_fs__write_rep (fs, rep, rep_skel, trail));
+
       SVN_ERR (fulltext_string_key (&str_key, rep_skel, trail->pool));
 
       /* If rep is already clear, just return success. */
       if ((str_key == NULL) || (str_key[0] == '\0'))
         return SVN_NO_ERROR;
 
+      /* If the string is shared with another rep, we mustn't clear
+         it in place.  Drop our reference and point the rep at a
+         fresh string instead --- which is born empty, so there is
+         nothing left to clear.  */
+      {
+        const char *new_key = str_key;
+
+        SVN_ERR (svn_fs__string_unshare (fs, &new_key, FALSE, trail));
+        if (strcmp (new_key, str_key) != 0)
+          {
+            rep_skel->children->next->data = new_key;
+            rep_skel->children->next->len = strlen (new_key);
+            SVN_ERR (svn_fs__write_rep (fs, rep, rep_skel, trail));
+            return SVN_NO_ERROR;
+          }
+      }
+
       /* Else, clear it. */
       SVN_ERR (svn_fs__string_clear (fs, str_key, trail));
     }
@@ -1242,37 +1547,6 @@ svn_fs__rep_contents_clear (svn_fs_t *fs,
 
 /*** Deltified storage. ***/
 
-/* Baton for svn_write_fn_t write_string(). */
-struct write_string_baton
-{
-  /* The fs where lives the string we're writing. */
-  svn_fs_t *fs;
-
-  /* The key of the string we're writing to.  Typically this is
-     initialized to NULL, so svn_fs__string_append() can fill in a
-     value. */
-  const char *key;
-
-  /* The trail we're writing in. */
-  trail_t *trail;
-};
-
-
-/* Function of type `svn_write_fn_t', for writing to a string;
-   BATON is `struct write_string_baton *'.
-
-   On the first call, BATON->key is null.  A new string key in
-   BATON->fs is chosen and stored in BATON->key; each call appends
-   *LEN bytes from DATA onto the string.  *LEN is never changed; if
-   the write fails to write all *LEN bytes, an error is returned.  */
-static svn_error_t *
-write_string (void *baton, const char *data, apr_size_t *len)
-{
-  struct write_string_baton *wb = baton;
-  return svn_fs__string_append (wb->fs, &(wb->key), *len, data, wb->trail);
-}
-
-
 /* Baton for svn_write_fn_t write_string_set(). */
 struct write_svndiff_strings_baton
 {
@@ -1357,6 +1631,77 @@ typedef struct window_write_t
 } window_write_t;
 
 
+/* Set *KEY_P to the key of the representation that delta rep REP_SKEL
+   is deltified against, allocated in POOL; or to null if REP_SKEL is
+   a fulltext rep or a self-compressed delta.  */
+static svn_error_t *
+delta_base_key (const char **key_p, skel_t *rep_skel, apr_pool_t *pool)
+{
+  skel_t *base;
+
+  *key_p = NULL;
+  if (! rep_is_delta (rep_skel))
+    return SVN_NO_ERROR;
+
+  /* All the windows of a delta rep are made against the same base, so
+     the first window's REP-KEY speaks for the whole rep.  */
+  base = rep_skel->children->next->children->next->children
+           ->next->next->next;
+  if (base)
+    *key_p = apr_pstrndup (pool, base->data, base->len);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Choose the representation in FS that TARGET should really be
+   deltified against, given that SOURCE is its nearest deltifiable
+   neighbor, and set *BASE_P to its key (allocated in TRAIL->pool),
+   all as part of TRAIL.
+
+   If every rep were deltified against its immediate neighbor, the
+   delta chain leading from an old rep to the nearest fulltext would
+   grow by one with every deltification, and reconstructing revision 1
+   of an N-revision file would apply N - 1 deltas.  So instead we
+   place deltas the way a skip list places links: a rep that would sit
+   D delta applications away from the fulltext is deltified against
+   the ancestor at distance D-with-its-lowest-set-bit-cleared.  A
+   chain then holds at most one rep per bit of D, so reconstructing
+   any rep applies O(log N) deltas, at a modest cost in delta size
+   (the chosen base is farther away, so the diffs are a bit bigger).  */
+static svn_error_t *
+choose_delta_base (const char **base_p,
+                   svn_fs_t *fs,
+                   const char *source,
+                   trail_t *trail)
+{
+  apr_array_header_t *chain;
+  const char *key = source;
+  apr_size_t distance, desired;
+
+  /* Walk SOURCE's delta chain down to the fulltext, remembering each
+     rep key along the way.  CHAIN->nelts - 1 - i is the number of
+     delta applications separating chain[i] from the fulltext.  */
+  chain = apr_array_make (trail->pool, 4, sizeof (key));
+  while (key)
+    {
+      skel_t *rep_skel;
+
+      (*((const char **)(apr_array_push (chain)))) = key;
+      SVN_ERR (svn_fs__read_rep (&rep_skel, fs, key, trail));
+      SVN_ERR (delta_base_key (&key, rep_skel, trail->pool));
+    }
+
+  /* TARGET would sit one step beyond SOURCE; clear the lowest set bit
+     of that distance to find the base it should point to instead.  */
+  distance = chain->nelts;
+  desired = distance & (distance - 1);
+  *base_p = ((const char **)(chain->elts))[chain->nelts - 1 - desired];
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_fs__rep_deltify (svn_fs_t *fs,
                      const char *target,
@@ -1380,7 +1725,7 @@ svn_fs__rep_deltify (svn_fs_t *fs,
   void *new_target_handler_baton;
   
   /* yes, we do windows */
-  svn_txdelta_window_t *window;
+  svn_txdelta_window_t *window = NULL;
 
   /* The current offset into the fulltext that our window is about to
      write.  This doubles, after all windows are written, as the
@@ -1408,20 +1753,27 @@ svn_fs__rep_deltify (svn_fs_t *fs,
        "svn_fs__rep_deltify: attempt to deltify \"%s\" against itself",
        target);
 
-  /* To favor time over space, we don't currently deltify files that
-     are larger than the svndiff window size.  This might seem
-     counterintuitive, but most files are smaller than a window
-     anyway, and until we write the delta combiner or something
-     approaching it, the cost of retrieval for large files becomes
-     simply prohibitive after about 10 or so revisions.  See issue
-     #531 for more details. */
+  /* Size policy: files below FS->deltify_min_size stay fulltext
+     because the rep/string bookkeeping would outweigh the content,
+     and files above FS->deltify_max_size stay fulltext to favor time
+     over space.  The latter might seem counterintuitive, but most
+     files are smaller than a window anyway, and until we write the
+     delta combiner or something approaching it, the cost of
+     retrieval for large files becomes simply prohibitive after about
+     10 or so revisions.  See issue #531 for more details. */
   {
     apr_size_t size;
     SVN_ERR (svn_fs__rep_contents_size (&size, fs, target, trail));
-    if (size > SVN_STREAM_CHUNK_SIZE)
+    if (size < fs->deltify_min_size)
+      return SVN_NO_ERROR;
+    if (fs->deltify_max_size && size > fs->deltify_max_size)
       return SVN_NO_ERROR;
   }
 
+  /* SOURCE is just the nearest neighbor; pick the rep we'll actually
+     delta against with skip-delta placement, so chains stay short.  */
+  SVN_ERR (choose_delta_base (&source, fs, source, trail));
+
   /* Set up a handler for the svndiff data, which will write each
      window to its own string in the `strings' table. */
   new_target_baton.fs = fs;
@@ -1452,8 +1804,10 @@ svn_fs__rep_deltify (svn_fs_t *fs,
       new_target_baton.size = 0;
       new_target_baton.key = NULL;
 
-      /* Fetch the next window of txdelta data. */
-      SVN_ERR (svn_txdelta_next_window (&window, txdelta_stream, wpool));
+      /* Fetch the next window of txdelta data, recycling the last
+         window's storage. */
+      SVN_ERR (svn_txdelta_next_window_reuse (&window, window,
+                                              txdelta_stream, wpool));
 
       /* Send off this package to be written as svndiff data. */
       SVN_ERR (new_target_handler (window, new_target_handler_baton));
@@ -1471,7 +1825,7 @@ svn_fs__rep_deltify (svn_fs_t *fs,
           tview_off += window->tview_len;
           diffsize += ww->svndiff_len;
            
-          /* Free the window. */
+          /* Free the window's scratch data. */
           svn_pool_clear (wpool);
         }
 
@@ -1590,6 +1944,10 @@ svn_fs__rep_deltify (svn_fs_t *fs,
     svn_fs__prepend (svn_fs__str_atom ("delta", trail->pool), header);
     svn_fs__prepend (header, rep);
 
+    /* The digest covers the whole fulltext the windows reconstruct,
+       so it doubles as the rep's contents checksum.  */
+    rep_set_checksum (rep, digest, trail->pool);
+
     /* Write out the new representation. */
     SVN_ERR (svn_fs__write_rep (fs, target, rep, trail));
     SVN_ERR (delete_strings (orig_str_keys, fs, trail));
@@ -1599,6 +1957,11 @@ svn_fs__rep_deltify (svn_fs_t *fs,
 }
 
 
+/* How many reconstruction buffers svn_fs__rep_undeltify fills before
+   flushing them to the strings table in one gathered write.  */
+#define UNDELTIFY_GATHER 4
+#define UNDELTIFY_BUFSIZE 65536
+
 svn_error_t *
 svn_fs__rep_undeltify (svn_fs_t *fs,
                        const char *rep,
@@ -1606,12 +1969,13 @@ svn_fs__rep_undeltify (svn_fs_t *fs,
 {
   /* ### todo:  Make this thing `delta'-aware! */
   svn_stream_t *source_stream; /* stream to read the source */
-  svn_stream_t *target_stream; /* stream to write the fulltext */
-  struct write_string_baton target_baton;
+  svn_fs__string_chunk_t chunks[UNDELTIFY_GATHER];
+  const char *new_key = NULL;
   apr_array_header_t *orig_keys;
   skel_t *rep_skel;
-  unsigned char buf[65536];
+  char *bufs;
   apr_size_t len;
+  int nchunks;
 
   /* Read the rep skel. */
   SVN_ERR (svn_fs__read_rep (&rep_skel, fs, rep, trail));
@@ -1623,37 +1987,56 @@ svn_fs__rep_undeltify (svn_fs_t *fs,
   /* Get the original string keys from REP (so we can delete them after
      we write our new skel out. */
   SVN_ERR (delta_string_keys (&orig_keys, rep_skel, trail->pool));
-  
-  /* Set up a string to receive the svndiff data. */
-  target_baton.fs = fs;
-  target_baton.trail = trail;
-  target_baton.key = NULL;
-  target_stream = svn_stream_create (&target_baton, trail->pool);
-  svn_stream_set_write (target_stream, write_string);
 
   /* Set up the source stream. */
   source_stream = svn_fs__rep_contents_read_stream (fs, rep, 0,
                                                     trail, trail->pool);
+
+  /* Loop, reconstructing the fulltext a buffer at a time, and
+     appending the gathered buffers as larger records, rather than
+     doing a database put per buffer. */
+  bufs = apr_palloc (trail->pool, UNDELTIFY_GATHER * UNDELTIFY_BUFSIZE);
   do
     {
-      apr_size_t len_read;
-
-      len = sizeof (buf);
-      SVN_ERR (svn_stream_read (source_stream, buf, &len));
-      len_read = len;
-      SVN_ERR (svn_stream_write (target_stream, buf, &len));
-      if (len_read != len)
-        return svn_error_createf 
-          (SVN_ERR_FS_GENERAL, 0, NULL, trail->pool,
-           "svn_fs__rep_undeltify: Error writing fulltext contents");
+      nchunks = 0;
+      do
+        {
+          char *buf = bufs + nchunks * UNDELTIFY_BUFSIZE;
+
+          len = UNDELTIFY_BUFSIZE;
+          SVN_ERR (svn_stream_read (source_stream, buf, &len));
+          if (len == 0)
+            break;
+
+          chunks[nchunks].data = buf;
+          chunks[nchunks].len = len;
+          nchunks++;
+        }
+      while ((len == UNDELTIFY_BUFSIZE) && (nchunks < UNDELTIFY_GATHER));
+
+      if (nchunks > 0)
+        SVN_ERR (svn_fs__string_appendv (fs, &new_key, chunks, nchunks,
+                                         trail));
     }
-  while (len);
+  while (len == UNDELTIFY_BUFSIZE);
 
-  /* Now `target_baton.key' has the key of the new string.  We
-     should hook it into the representation.  So we make a new rep,
-     write it out... */
-  rep_skel = make_fulltext_rep_skel (target_baton.key, 0, trail->pool);
-  SVN_ERR (svn_fs__write_rep (fs, rep, rep_skel, trail));
+  /* An empty fulltext still needs a string record to refer to. */
+  if (new_key == NULL)
+    SVN_ERR (svn_fs__string_append (fs, &new_key, 0, NULL, trail));
+
+  /* Now `new_key' has the key of the new string.  We should hook it
+     into the representation.  So we make a new rep, write it out... */
+  {
+    unsigned char digest[MD5_DIGESTSIZE];
+    skel_t *new_rep_skel = make_fulltext_rep_skel (new_key, 0, trail->pool);
+
+    /* The contents are unchanged, just stored differently, so the old
+       rep's checksum carries straight over.  */
+    if (rep_get_checksum (digest, rep_skel))
+      rep_set_checksum (new_rep_skel, digest, trail->pool);
+
+    SVN_ERR (svn_fs__write_rep (fs, rep, new_rep_skel, trail));
+  }
 
   /* ...then we delete our original strings. */
   SVN_ERR (delete_strings (orig_keys, fs, trail));
@@ -1661,6 +2044,110 @@ svn_fs__rep_undeltify (svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+
+
+/*** Serving stored deltas directly. ***/
+
+svn_error_t *
+svn_fs__rep_stored_delta_keys (apr_array_header_t **keys,
+                               svn_fs_t *fs,
+                               const char *target,
+                               const char *source,
+                               apr_pool_t *pool,
+                               trail_t *trail)
+{
+  skel_t *rep;
+  const char *base;
+
+  *keys = NULL;
+
+  SVN_ERR (svn_fs__read_rep (&rep, fs, target, trail));
+  if (! rep_is_delta (rep))
+    return SVN_NO_ERROR;
+
+  /* All the windows of a delta rep are made against the same base; if
+     that base is not SOURCE, the stored diff is of no use to us.  */
+  SVN_ERR (delta_base_key (&base, rep, trail->pool));
+  if ((base == NULL) || (strcmp (base, source) != 0))
+    return SVN_NO_ERROR;
+
+  return delta_string_keys (keys, rep, pool);
+}
+
+
+/* Baton for txn_body_read_string_chunk(). */
+struct read_string_chunk_args
+{
+  svn_fs_t *fs;
+  const char *key;     /* string to read from */
+  char *buf;           /* where to put the data */
+  apr_size_t offset;   /* where to start reading */
+  apr_size_t len;      /* in: bytes wanted; out: bytes read */
+};
+
+
+static svn_error_t *
+txn_body_read_string_chunk (void *baton, trail_t *trail)
+{
+  struct read_string_chunk_args *args = baton;
+
+  return svn_fs__string_read (args->fs, args->key, args->buf,
+                              args->offset, &(args->len), trail);
+}
+
+
+svn_error_t *
+svn_fs__send_stored_delta (svn_fs_t *fs,
+                           const apr_array_header_t *keys,
+                           svn_txdelta_window_handler_t handler,
+                           void *handler_baton,
+                           apr_pool_t *pool)
+{
+  svn_stream_t *wstream;
+  struct read_string_chunk_args args;
+  char chunk[4096];
+  apr_size_t amt;
+  int i;
+
+  /* A parsing stream turns the raw svndiff data back into windows and
+     pushes them at HANDLER as they are decoded.  */
+  wstream = svn_txdelta_parse_svndiff (handler, handler_baton, TRUE, pool);
+
+  /* The stored strings carry bare window data; the parser expects the
+     svndiff stream header first.  */
+  chunk[0] = 'S';
+  chunk[1] = 'V';
+  chunk[2] = 'N';
+  chunk[3] = '\0';
+  amt = 4;
+  SVN_ERR (svn_stream_write (wstream, chunk, &amt));
+
+  /* Stream each window's string through the parser, in order.  Each
+     read happens in a one-off trail, so we never hold a Berkeley DB
+     transaction open across a call into the window consumer.  */
+  args.fs = fs;
+  args.buf = chunk;
+  for (i = 0; i < keys->nelts; i++)
+    {
+      args.key = ((const char **) keys->elts)[i];
+      args.offset = 0;
+
+      do
+        {
+          args.len = sizeof (chunk);
+          SVN_ERR (svn_fs__retry_txn (fs, txn_body_read_string_chunk,
+                                      &args, pool));
+          args.offset += args.len;
+          amt = args.len;
+          SVN_ERR (svn_stream_write (wstream, chunk, &amt));
+        }
+      while (args.len == sizeof (chunk));
+    }
+
+  /* Closing the stream hands the final null window to HANDLER.  */
+  return svn_stream_close (wstream);
+}
+
 
 /* 
  * local variables:
@@ -18,6 +18,8 @@
 #ifndef SVN_LIBSVN_FS_REPS_STRINGS_H
 #define SVN_LIBSVN_FS_REPS_STRINGS_H
 
+#include <apr_md5.h>
+
 #include "db.h"
 #include "svn_io.h"
 #include "svn_fs.h"
@@ -50,8 +52,9 @@ extern "C" {
    else set *NEW_REP to a new rep key allocated in TRAIL->pool.
 
    In the latter case, if REP refers to an immutable representation,
-   then *NEW_REP refers to a mutable copy of it (a deep copy,
-   including the rep's contents); else if REP is the empty string or
+   then *NEW_REP refers to a mutable copy of it (sharing the
+   immutable rep's string until the copy is first written, at which
+   point it gets its own); else if REP is the empty string or
    null, *NEW_REP refers to a new, empty mutable representation
    (containing a new, empty string).
 
@@ -107,9 +110,25 @@ svn_error_t *svn_fs__rep_contents (svn_string_t *str,
                                    trail_t *trail);
 
 
+/* Set *KNOWN_P to TRUE and DIGEST to the MD5 checksum recorded for
+   REP's contents in FS, as part of TRAIL; or set *KNOWN_P to FALSE if
+   no checksum is recorded.  A rep written before checksums existed,
+   or one whose contents are still being written, records none.  */
+svn_error_t *svn_fs__rep_checksum (unsigned char digest[MD5_DIGESTSIZE],
+                                   svn_boolean_t *known_p,
+                                   svn_fs_t *fs,
+                                   const char *rep,
+                                   trail_t *trail);
+
+
 /* Return a stream to read the contents of REP.  Allocate the stream
    in POOL, and start reading at OFFSET in the rep's contents.
 
+   A stream that starts at offset zero checks the contents against the
+   rep's recorded checksum, if any, as the read that reaches the end
+   of the contents completes; a mismatch is returned as
+   SVN_ERR_FS_CORRUPT.
+
    If TRAIL is non-null, the stream's reads are part of TRAIL;
    otherwise, each read happens in an internal, one-off trail. 
    POOL may be TRAIL->pool.  */
@@ -126,6 +145,11 @@ svn_stream_t *svn_fs__rep_contents_read_stream (svn_fs_t *fs,
    If the rep already has contents, the stream will append.  You can
    use svn_fs__rep_contents_clear() to clear the contents first.
 
+   Closing the stream records the MD5 checksum of the data written
+   through it in the rep's header, where subsequent readers verify it.
+   Close the stream only if it has seen the rep's complete contents,
+   i.e. writing started from an empty rep.
+
    If TRAIL is non-null, the stream's writes are part of TRAIL;
    otherwise, each write happens in an internal, one-off trail.
    POOL may be TRAIL->pool.
@@ -169,6 +193,36 @@ svn_error_t *svn_fs__rep_undeltify (svn_fs_t *fs,
                                     trail_t *trail);
 
 
+/* If TARGET in FS is stored as a delta made directly against SOURCE,
+   set *KEYS to the string keys holding the delta's svndiff windows,
+   in order; else set *KEYS to null.  Allocate *KEYS in POOL, as part
+   of TRAIL.
+
+   A non-null *KEYS means the stored windows reconstruct TARGET's full
+   contents from SOURCE's, so they can be served verbatim by
+   svn_fs__send_stored_delta instead of recomputing the delta.  */
+svn_error_t *svn_fs__rep_stored_delta_keys (apr_array_header_t **keys,
+                                            svn_fs_t *fs,
+                                            const char *target,
+                                            const char *source,
+                                            apr_pool_t *pool,
+                                            trail_t *trail);
+
+
+/* Send the svndiff data held by the strings KEYS in FS -- as returned
+   by svn_fs__rep_stored_delta_keys -- as txdelta windows to
+   HANDLER/HANDLER_BATON, followed by the final null window.  Do
+   temporary allocation in POOL.
+
+   Each read happens in its own one-off trail, so no database
+   transaction is held open across calls into HANDLER.  */
+svn_error_t *svn_fs__send_stored_delta (svn_fs_t *fs,
+                                        const apr_array_header_t *keys,
+                                        svn_txdelta_window_handler_t handler,
+                                        void *handler_baton,
+                                        apr_pool_t *pool);
+
+
 
 #ifdef __cplusplus
 }
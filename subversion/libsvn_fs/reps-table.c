@@ -71,6 +71,7 @@ svn_fs__read_rep (skel_t **skel_p,
   int db_err;
   DBT query, result;
 
+  SVN_FS__COUNT (fs, db_gets);
   db_err = fs->representations->get
     (fs->representations,
      trail->db_txn,
@@ -104,6 +105,7 @@ svn_fs__write_rep (svn_fs_t *fs,
 {
   DBT query, result;
 
+  SVN_FS__COUNT (fs, db_puts);
   SVN_ERR (DB_WRAP (fs, "storing representation",
                     fs->representations->put
                     (fs->representations, trail->db_txn,
@@ -140,6 +142,7 @@ svn_fs__write_new_rep (const char **key,
 
   /* Get the current value associated with `next-key'.  */
   svn_fs__str_to_dbt (&query, (char *) svn_fs__next_key_key);
+  SVN_FS__COUNT (fs, db_gets);
   SVN_ERR (DB_WRAP (fs, "allocating new representation (getting next-key)",
                     fs->representations->get (fs->representations,
                                               trail->db_txn,
@@ -156,6 +159,7 @@ svn_fs__write_new_rep (const char **key,
   /* Bump to future key. */
   len = result.size;
   svn_fs__next_key (result.data, &len, next_key);
+  SVN_FS__COUNT (fs, db_puts);
   db_err = fs->representations->put
     (fs->representations, trail->db_txn,
      svn_fs__str_to_dbt (&query, (char *) svn_fs__next_key_key),
@@ -174,6 +178,7 @@ svn_fs__delete_rep (svn_fs_t *fs, const char *key, trail_t *trail)
   int db_err;
   DBT query;
 
+  SVN_FS__COUNT (fs, db_puts);
   db_err = fs->representations->del
     (fs->representations, trail->db_txn,
      svn_fs__str_to_dbt (&query, (char *) key), 0);
@@ -17,10 +17,12 @@
 
 #include <db.h>
 #include "svn_fs.h"
+#include "svn_pools.h"
 #include "fs.h"
 #include "err.h"
 #include "dbt.h"
 #include "skel.h"
+#include "id.h"
 #include "proplist.h"
 #include "validate.h"
 #include "rev-table.h"
@@ -44,12 +46,96 @@ int svn_fs__open_revisions_table (DB **revisions_p,
 }
 
 
+
+/* Caching revision lookups.  */
+
+/* A committed revision never changes its root ID, and mod_dav_svn
+   resolves the same head revision once per request, so it pays to
+   remember the youngest revision number and a handful of recent
+   revision-to-root-ID mappings, instead of fetching and parsing the
+   revision skel from Berkeley DB every time.
+
+   When a trail aborts, whatever it read may never really have
+   happened, so aborted trails discard the whole cache; see
+   svn_fs__clear_rev_cache.
+
+   ### todo: like the node revision and string caches, this cache
+   can't see commits made against the same database by other
+   processes; see the note in nodes-table.c.  */
+
+#define REV_CACHE_SIZE 16
+
+/* One cached revision-to-root-ID mapping.  */
+typedef struct rev_cache_entry_t
+{
+  /* The revision this slot describes, or SVN_INVALID_REVNUM if the
+     slot is empty.  */
+  svn_revnum_t rev;
+
+  /* The ID of REV's root directory.  */
+  svn_fs_id_t *root_id;
+
+  /* A subpool holding ROOT_ID, cleared when the slot is re-used.
+     Null until the slot is first filled.  */
+  apr_pool_t *pool;
+
+} rev_cache_entry_t;
+
+
+struct svn_fs__rev_cache_t
+{
+  /* A subpool of the filesystem's pool, holding the cache.  */
+  apr_pool_t *pool;
+
+  /* The youngest revision in the filesystem, or SVN_INVALID_REVNUM
+     if we haven't looked it up yet.  */
+  svn_revnum_t youngest;
+
+  /* Recently resolved root IDs, direct-mapped by revision number.  */
+  rev_cache_entry_t entries[REV_CACHE_SIZE];
+};
+
+
+/* Return FS's revision cache, creating it if necessary.  */
+static struct svn_fs__rev_cache_t *
+get_rev_cache (svn_fs_t *fs)
+{
+  if (! fs->rev_cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+      struct svn_fs__rev_cache_t *cache
+        = apr_pcalloc (pool, sizeof (*cache));
+      int i;
+
+      cache->pool = pool;
+      cache->youngest = SVN_INVALID_REVNUM;
+      for (i = 0; i < REV_CACHE_SIZE; i++)
+        cache->entries[i].rev = SVN_INVALID_REVNUM;
+
+      fs->rev_cache = cache;
+    }
+
+  return fs->rev_cache;
+}
+
+
+void
+svn_fs__clear_rev_cache (svn_fs_t *fs)
+{
+  if (fs->rev_cache)
+    {
+      svn_pool_destroy (fs->rev_cache->pool);
+      fs->rev_cache = NULL;
+    }
+}
+
+
 
 /* Storing and retrieving filesystem revisions.  */
 
 
-static int
-is_valid_filesystem_revision (skel_t *skel)
+int
+svn_fs__is_valid_filesystem_revision (skel_t *skel)
 {
   int len = svn_fs__list_length (skel);
 
@@ -85,11 +171,16 @@ svn_fs__get_rev (skel_t **skel_p,
      numbers begin with one.  */
   db_recno_t recno = rev + 1;
 
-  db_err = fs->revisions->get (fs->revisions, trail->db_txn,
-                               svn_fs__set_dbt (&key, &recno, sizeof (recno)),
-                               svn_fs__result_dbt (&value),
-                               0);
-  svn_fs__track_dbt (&value, trail->pool);
+  do
+    {
+      SVN_FS__COUNT (fs, db_gets);
+      db_err = fs->revisions->get (fs->revisions, trail->db_txn,
+                                   svn_fs__set_dbt (&key, &recno,
+                                                    sizeof (recno)),
+                                   svn_fs__result_dbt_reuse (&value, trail),
+                                   0);
+    }
+  while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
 
   /* If there's no such revision, return an appropriately specific error.  */
   if (db_err == DB_NOTFOUND)
@@ -101,10 +192,13 @@ svn_fs__get_rev (skel_t **skel_p,
   /* Parse and check the REVISION skel.  */
   skel = svn_fs__parse_skel (value.data, value.size, trail->pool);
   if (! skel
-      || ! is_valid_filesystem_revision (skel))
+      || (! fs->trusted_reads
+          && ! svn_fs__is_valid_filesystem_revision (skel)))
     return svn_fs__err_corrupt_fs_revision (fs, rev);
 
-  *skel_p = skel;
+  /* The parsed skel points into the trail's scratch buffer; copy it
+     into pool storage before the next retrieval overwrites it.  */
+  *skel_p = svn_fs__copy_skel (skel, trail->pool);
   return SVN_NO_ERROR;
 }
 
@@ -120,9 +214,10 @@ svn_fs__put_rev (svn_revnum_t *rev,
   db_recno_t recno = 0;
 
   /* xbc FIXME: Need a useful revision number here. */
-  if (! is_valid_filesystem_revision (skel))
+  if (! svn_fs__is_valid_filesystem_revision (skel))
     return svn_fs__err_corrupt_fs_revision (fs, -1);
 
+  SVN_FS__COUNT (fs, db_puts);
   db_err = fs->revisions->put (fs->revisions, trail->db_txn,
                                svn_fs__recno_dbt(&key, &recno),
                                svn_fs__skel_to_dbt (&value, skel, trail->pool),
@@ -133,6 +228,11 @@ svn_fs__put_rev (svn_revnum_t *rev,
      Revisions are numbered starting with zero; Berkeley DB record
      numbers begin with one.  */
   *rev = recno - 1;
+
+  /* We're now the youngest revision.  If this trail later aborts, the
+     whole revision cache is discarded; see svn_fs__clear_rev_cache.  */
+  get_rev_cache (fs)->youngest = *rev;
+
   return SVN_NO_ERROR;
 }
 
@@ -143,9 +243,24 @@ svn_fs__rev_get_root (svn_fs_id_t **root_id_p,
                       svn_revnum_t rev,
                       trail_t *trail)
 {
+  struct svn_fs__rev_cache_t *cache;
+  rev_cache_entry_t *entry;
   skel_t *skel;
   svn_fs_id_t *id;
 
+  if (! SVN_IS_VALID_REVNUM (rev))
+    return svn_fs__err_dangling_rev (fs, rev);
+
+  /* A committed revision's root ID never changes, so a cached mapping
+     is good for as long as the cache lives.  */
+  cache = get_rev_cache (fs);
+  entry = &cache->entries[rev % REV_CACHE_SIZE];
+  if (entry->rev == rev)
+    {
+      *root_id_p = svn_fs__id_copy (entry->root_id, trail->pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR (svn_fs__get_rev (&skel, fs, rev, trail));
 
   id = svn_fs_parse_id (skel->children->next->data,
@@ -156,6 +271,14 @@ svn_fs__rev_get_root (svn_fs_id_t **root_id_p,
   if (id == NULL)
     return svn_fs__err_corrupt_fs_revision (fs, -1);
 
+  /* Remember the mapping, evicting whatever last used this slot.  */
+  if (entry->pool)
+    svn_pool_clear (entry->pool);
+  else
+    entry->pool = svn_pool_create (cache->pool);
+  entry->root_id = svn_fs__id_copy (id, entry->pool);
+  entry->rev = rev;
+
   *root_id_p = id;
   return SVN_NO_ERROR;
 }
@@ -175,15 +298,29 @@ svn_fs__youngest_rev (svn_revnum_t *youngest_p,
   DBC *cursor = 0;
   DBT key, value;
   db_recno_t recno;
+  struct svn_fs__rev_cache_t *cache;
 
   SVN_ERR (svn_fs__check_fs (fs));
 
+  /* If we've already learned the youngest revision, don't go back to
+     the database for it.  Commits through this process keep the
+     cached value current (see svn_fs__put_rev), and aborted trails
+     discard it.  */
+  cache = get_rev_cache (fs);
+  if (SVN_IS_VALID_REVNUM (cache->youngest))
+    {
+      *youngest_p = cache->youngest;
+      return SVN_NO_ERROR;
+    }
+
   /* Create a database cursor.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "getting youngest revision (creating cursor)",
                     fs->revisions->cursor (fs->revisions, trail->db_txn,
                                            &cursor, 0)));
 
   /* Find the last entry in the `revisions' table.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor,
                           svn_fs__recno_dbt (&key, &recno),
                           svn_fs__nodata_dbt (&value),
@@ -220,6 +357,7 @@ svn_fs__youngest_rev (svn_revnum_t *youngest_p,
      Revisions are numbered starting with zero; Berkeley DB record
      numbers begin with one.  */
   *youngest_p = recno - 1;
+  cache->youngest = *youngest_p;
   return SVN_NO_ERROR;
 }
 
@@ -285,6 +423,7 @@ txn_body_revision_prop (void *baton,
 
   /* Return the results of the generic property getting function. */
   return svn_fs__get_prop (args->value_p,
+                           args->fs,
                            proplist,
                            args->propname,
                            trail->pool);
@@ -335,6 +474,7 @@ txn_body_revision_proplist (void *baton, trail_t *trail)
 
   /* Return the results of the generic property hash getting function. */
   return svn_fs__make_prop_hash (args->table_p,
+                                 args->fs,
                                  proplist,
                                  trail->pool);
 }
@@ -385,7 +525,8 @@ svn_fs__set_rev_prop (svn_fs_t *fs,
 
     /* Update the filesystem revision with the new skel that reflects
        our property edits. */
-    db_err = fs->revisions->put 
+    SVN_FS__COUNT (fs, db_puts);
+    db_err = fs->revisions->put
       (fs->revisions, trail->db_txn,
        svn_fs__set_dbt (&query, &recno, sizeof (recno)),
        svn_fs__skel_to_dbt (&result, skel, trail->pool), 0);
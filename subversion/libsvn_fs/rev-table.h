@@ -78,6 +78,16 @@ svn_error_t *svn_fs__youngest_rev (svn_revnum_t *youngest_p,
                                    trail_t *trail);
 
 
+/* Discard FS's in-memory cache of revision lookups.  Called when a
+   trail aborts, since revisions read within the aborted transaction
+   may never have been committed.  */
+void svn_fs__clear_rev_cache (svn_fs_t *fs);
+
+
+/* Return non-zero iff SKEL is a well-formed REVISION skel.  */
+int svn_fs__is_valid_filesystem_revision (skel_t *skel);
+
+
 /* Set property NAME to VALUE on REV in FS, as part of TRAIL.  */
 svn_error_t *svn_fs__set_rev_prop (svn_fs_t *fs,
                                    svn_revnum_t rev,
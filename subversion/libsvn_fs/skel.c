@@ -256,57 +256,235 @@ explicit_atom (const char *data,
 }
 
 
+
+/* Scanning skels in place.  */
+
+/* Return a pointer to the first byte past the skel beginning at DATA,
+   or null if the bytes between DATA and END don't begin with a
+   well-formed skel.  This walks the concrete representation without
+   building any skel_t objects, which is what makes the lazy cursor
+   below cheap.  */
+static const char *
+scan (const char *data, const char *end)
+{
+  char c;
+
+  if (data >= end)
+    return 0;
+
+  c = *data;
+
+  /* A list: skip the paren, then scan elements until the close.  */
+  if (c == '(')
+    {
+      data++;
+      for (;;)
+        {
+          while (data < end
+                 && skel_char_type[(unsigned char) *data] == type_space)
+            data++;
+
+          if (data >= end)
+            return 0;
+
+          if (*data == ')')
+            return data + 1;
+
+          data = scan (data, end);
+          if (! data)
+            return 0;
+        }
+    }
+
+  /* An atom with implicit length: skip to the first delimiter.  */
+  if (skel_char_type[(unsigned char) c] == type_name)
+    {
+      while (++data < end
+             && skel_char_type[(unsigned char) *data] != type_space
+             && skel_char_type[(unsigned char) *data] != type_paren)
+        ;
+      return data;
+    }
+
+  /* An atom with explicit length.  */
+  {
+    const char *next;
+    apr_size_t size;
+
+    size = svn_fs__getsize (data, end - data, &next, end - data);
+    data = next;
+    if (! data)
+      return 0;
+    if (data >= end || skel_char_type[(unsigned char) *data] != type_space)
+      return 0;
+    data++;
+    if (data + size > end)
+      return 0;
+    return data + size;
+  }
+}
+
+
+int
+svn_fs__skel_cursor_open (svn_fs__skel_cursor_t *cursor,
+                          const char *data,
+                          apr_size_t len)
+{
+  if (len == 0 || *data != '(')
+    return 0;
+
+  cursor->cur = data + 1;
+  cursor->end = data + len;
+  return 1;
+}
+
+
+int
+svn_fs__skel_cursor_next (svn_fs__skel_cursor_t *cursor,
+                          const char **data_p,
+                          apr_size_t *len_p)
+{
+  const char *data = cursor->cur;
+  const char *next;
+
+  while (data < cursor->end
+         && skel_char_type[(unsigned char) *data] == type_space)
+    data++;
+
+  if (data >= cursor->end)
+    return -1;
+
+  if (*data == ')')
+    {
+      cursor->cur = data + 1;
+      return 0;
+    }
+
+  next = scan (data, cursor->end);
+  if (! next)
+    return -1;
+
+  *data_p = data;
+  *len_p = next - data;
+  cursor->cur = next;
+  return 1;
+}
+
+
+int
+svn_fs__skel_atom_contents (const char *data,
+                            apr_size_t len,
+                            const char **contents_p,
+                            apr_size_t *contents_len_p)
+{
+  const char *end = data + len;
+
+  if (len == 0 || *data == '(')
+    return 0;
+
+  if (skel_char_type[(unsigned char) *data] == type_name)
+    {
+      const char *next = scan (data, end);
+      if (! next)
+        return 0;
+      *contents_p = data;
+      *contents_len_p = next - data;
+      return 1;
+    }
+
+  /* Explicit length: the contents are the bytes after the count and
+     the whitespace character.  */
+  {
+    const char *next;
+    apr_size_t size;
+
+    size = svn_fs__getsize (data, end - data, &next, end - data);
+    data = next;
+    if (! data
+        || data >= end
+        || skel_char_type[(unsigned char) *data] != type_space)
+      return 0;
+    data++;
+    if (data + size > end)
+      return 0;
+    *contents_p = data;
+    *contents_len_p = size;
+    return 1;
+  }
+}
+
+
+
 
 /* Unparsing skeletons.  */
 
-static apr_size_t estimate_unparsed_size (skel_t *);
-static svn_stringbuf_t *unparse (skel_t *, svn_stringbuf_t *,
-                              apr_pool_t *);
+static int use_implicit (skel_t *);
+static apr_size_t skel_size (skel_t *);
+static void unparse (skel_t *, char **);
 
 
 svn_stringbuf_t *
 svn_fs__unparse_skel (skel_t *skel, apr_pool_t *pool)
 {
   svn_stringbuf_t *str;
-  
-  /* Allocate a string to hold the data.  */
+  char *p;
+
+  /* Measure the skel, then make a single allocation of exactly the
+     right size.  Reallocation is expensive in pools --- the old
+     buffer is simply orphaned --- and a big directory skel used to
+     go through many geometric regrows and copies on its way out.  */
   str = apr_palloc (pool, sizeof (*str));
   str->pool = pool;
-  str->blocksize = estimate_unparsed_size (skel) + 200;
+  str->len = skel_size (skel);
+  str->blocksize = str->len + 1;
   str->data = apr_palloc (pool, str->blocksize);
-  str->len = 0;
 
-  return unparse (skel, str, pool);
+  p = str->data;
+  unparse (skel, &p);
+  if (p != str->data + str->len)
+    abort ();
+  str->data[str->len] = '\0';
+
+  return str;
 }
 
 
-/* Return an estimate of the number of bytes that the external
-   representation of SKEL will occupy.  Since reallocing is expensive
-   in pools, it's worth trying to get the buffer size right the first
-   time.  */
+/* Return the exact number of bytes the external representation of
+   SKEL occupies.  This must agree with what unparse emits, byte for
+   byte.  */
 static apr_size_t
-estimate_unparsed_size (skel_t *skel)
+skel_size (skel_t *skel)
 {
   if (skel->is_atom)
     {
-      if (skel->len < 100)
-        /* If we have to use the explicit-length form, that'll be
-           two bytes for the length, one byte for the space, and 
-           the contents.  */
-        return skel->len + 3;
-      else
-        return skel->len + 30;
+      apr_size_t length_len;
+      apr_size_t n;
+
+      if (use_implicit (skel))
+        return skel->len;
+
+      /* Explicit-length form: the length in decimal, a space, and
+         the contents.  */
+      length_len = 1;
+      for (n = skel->len; n >= 10; n /= 10)
+        length_len++;
+
+      return length_len + 1 + skel->len;
     }
   else
     {
-      int total_len;
+      apr_size_t total_len;
       skel_t *child;
 
-      /* Allow space for opening and closing parens, and a space
-         between each pair of elements.  */
+      /* Opening and closing parens, and a space between each pair of
+         elements.  */
       total_len = 2;
       for (child = skel->children; child; child = child->next)
-        total_len += estimate_unparsed_size (child) + 1;
+        {
+          total_len += skel_size (child);
+          if (child->next)
+            total_len++;
+        }
 
       return total_len;
     }
@@ -345,60 +523,54 @@ use_implicit (skel_t *skel)
 }
 
 
-/* Append the concrete representation of SKEL to the string STR.
-   Grow S with new space from POOL as necessary.  */
-static svn_stringbuf_t *
-unparse (skel_t *skel, svn_stringbuf_t *str, apr_pool_t *pool)
+/* Copy the concrete representation of SKEL into the buffer at *P,
+   advancing *P past the bytes written.  The caller must have sized
+   the buffer using skel_size; no bounds are checked here.  */
+static void
+unparse (skel_t *skel, char **p)
 {
   if (skel->is_atom)
     {
-      /* Append an atom to STR.  */
+      /* Emit an atom.  */
       if (use_implicit (skel))
-        svn_stringbuf_appendbytes (str, skel->data, skel->len);
+        {
+          memcpy (*p, skel->data, skel->len);
+          *p += skel->len;
+        }
       else
         {
-          /* Append the length to STR.  */
-          char buf[200];
+          /* Emit the length, a space, and the atom's contents.  */
           int length_len;
 
-          length_len = svn_fs__putsize (buf, sizeof (buf), skel->len);
+          length_len = svn_fs__putsize (*p, skel_size (skel), skel->len);
           if (! length_len)
             abort ();
+          *p += length_len;
 
-          /* Make sure we have room for the length, the space, and the
-             atom's contents.  */
-          svn_stringbuf_ensure (str,
-                             str->len + length_len + 1 + skel->len);
-          svn_stringbuf_appendbytes (str, buf, length_len);
-          str->data[str->len++] = ' ';
-          svn_stringbuf_appendbytes (str, skel->data, skel->len);
+          *(*p)++ = ' ';
+          memcpy (*p, skel->data, skel->len);
+          *p += skel->len;
         }
     }
   else
     {
-      /* Append a list to STR.  */
+      /* Emit a list.  */
       skel_t *child;
 
       /* Emit an opening parenthesis.  */
-      svn_stringbuf_ensure (str, str->len + 1);
-      str->data[str->len++] = '(';
-      
-      /* Append each element.  Emit a space between each pair of elements.  */
+      *(*p)++ = '(';
+
+      /* Emit each element, with a space between each pair of elements.  */
       for (child = skel->children; child; child = child->next)
         {
-          unparse (child, str, pool);
+          unparse (child, p);
           if (child->next)
-            {
-              svn_stringbuf_ensure (str, str->len + 1);
-              str->data[str->len++] = ' ';
-            }
+            *(*p)++ = ' ';
         }
 
       /* Emit a closing parenthesis.  */
-      svn_stringbuf_appendbytes (str, ")", 1);
+      *(*p)++ = ')';
     }
-
-  return str;
 }
 
 
@@ -481,6 +653,90 @@ svn_fs__append (skel_t *skel, skel_t *list_skel)
 }
 
 
+
+/* Slab-allocating skel builders.  */
+
+/* How many skel_t nodes a builder grabs from its pool at a time. */
+#define SKEL_BUILDER_SLAB_SIZE 64
+
+struct svn_fs__skel_builder_t
+{
+  apr_pool_t *pool;   /* where slabs come from */
+  skel_t *slab;       /* current slab of SKEL_BUILDER_SLAB_SIZE nodes */
+  int used;           /* nodes handed out of SLAB so far */
+};
+
+
+svn_fs__skel_builder_t *
+svn_fs__skel_builder_create (apr_pool_t *pool)
+{
+  svn_fs__skel_builder_t *builder = apr_palloc (pool, sizeof (*builder));
+
+  builder->pool = pool;
+  builder->slab = apr_palloc (pool,
+                              SKEL_BUILDER_SLAB_SIZE
+                              * sizeof (*builder->slab));
+  builder->used = 0;
+  return builder;
+}
+
+
+/* Hand out the next node from BUILDER's slab, going to the pool for
+   a fresh slab when it runs dry.  Exhausted slabs stay behind in the
+   pool, so every node handed out remains valid.  */
+static skel_t *
+builder_node (svn_fs__skel_builder_t *builder)
+{
+  skel_t *node;
+
+  if (builder->used == SKEL_BUILDER_SLAB_SIZE)
+    {
+      builder->slab = apr_palloc (builder->pool,
+                                  SKEL_BUILDER_SLAB_SIZE
+                                  * sizeof (*builder->slab));
+      builder->used = 0;
+    }
+
+  node = &builder->slab[builder->used++];
+  memset (node, 0, sizeof (*node));
+  return node;
+}
+
+
+skel_t *
+svn_fs__build_str_atom (svn_fs__skel_builder_t *builder,
+                        const char *str)
+{
+  skel_t *skel = builder_node (builder);
+
+  skel->is_atom = 1;
+  skel->data = str;
+  skel->len = strlen (str);
+  return skel;
+}
+
+
+skel_t *
+svn_fs__build_mem_atom (svn_fs__skel_builder_t *builder,
+                        const char *addr,
+                        apr_size_t len)
+{
+  skel_t *skel = builder_node (builder);
+
+  skel->is_atom = 1;
+  skel->data = addr;
+  skel->len = len;
+  return skel;
+}
+
+
+skel_t *
+svn_fs__build_empty_list (svn_fs__skel_builder_t *builder)
+{
+  return builder_node (builder);
+}
+
+
 
 /* Examining skels.  */
 
@@ -120,6 +120,41 @@ skel_t *svn_fs__parse_skel (char *data, apr_size_t len,
                             apr_pool_t *pool);
 
 
+/* A cursor for reading the elements of a list skel straight out of
+   its concrete representation, without building skel_t objects.
+   This is worthwhile for big lists --- directory entry lists, mainly
+   --- when the caller only cares about a few elements: scanning an
+   element is just pointer arithmetic, and only the elements the
+   caller actually parses cost any allocation.  */
+typedef struct svn_fs__skel_cursor_t {
+  const char *cur;              /* The next unscanned byte. */
+  const char *end;              /* End of the buffer. */
+} svn_fs__skel_cursor_t;
+
+
+/* Position CURSOR at the first element of the list skel whose
+   concrete representation is the LEN bytes at DATA.  Return zero if
+   the data doesn't begin with a list.  */
+int svn_fs__skel_cursor_open (svn_fs__skel_cursor_t *cursor,
+                              const char *data, apr_size_t len);
+
+
+/* Delimit the next element of CURSOR's list: set *DATA_P and *LEN_P
+   to the extent of the element's concrete representation, suitable
+   for handing to svn_fs__parse_skel, and return 1.  Return 0 at the
+   end of the list, or -1 if the data is malformed.  */
+int svn_fs__skel_cursor_next (svn_fs__skel_cursor_t *cursor,
+                              const char **data_p, apr_size_t *len_p);
+
+
+/* If the LEN bytes at DATA are the concrete representation of an
+   atom, set *CONTENTS_P and *CONTENTS_LEN_P to the atom's contents
+   and return 1; else return 0.  */
+int svn_fs__skel_atom_contents (const char *data, apr_size_t len,
+                                const char **contents_p,
+                                apr_size_t *contents_len_p);
+
+
 /* Create an atom skel whose contents are the C string STR, allocated
    from POOL.  */
 skel_t *svn_fs__str_atom (const char *str, apr_pool_t *pool);
@@ -144,6 +179,29 @@ void svn_fs__prepend (skel_t *skel, skel_t *list);
 void svn_fs__append (skel_t *skel, skel_t *list);
 
 
+/* A slab allocator for skel_t nodes.  svn_fs__str_atom and friends
+   cost one pool allocation per node, which adds up when a caller
+   assembles big skels record after record --- the commit-side
+   writers in dag.c, chiefly.  A builder hands nodes out of arrays
+   instead, going to its pool once per SKEL_BUILDER_SLAB_SIZE nodes.
+   Nodes live as long as the builder's pool; there is no way to free
+   one early.  */
+typedef struct svn_fs__skel_builder_t svn_fs__skel_builder_t;
+
+/* Return a new builder, drawing its slabs from POOL.  */
+svn_fs__skel_builder_t *svn_fs__skel_builder_create (apr_pool_t *pool);
+
+/* The builder-backed counterparts of svn_fs__str_atom,
+   svn_fs__mem_atom, and svn_fs__make_empty_list.  As with those,
+   atoms point at the caller's bytes; only the skel_t node itself
+   comes from the builder.  */
+skel_t *svn_fs__build_str_atom (svn_fs__skel_builder_t *builder,
+                                const char *str);
+skel_t *svn_fs__build_mem_atom (svn_fs__skel_builder_t *builder,
+                                const char *addr, apr_size_t len);
+skel_t *svn_fs__build_empty_list (svn_fs__skel_builder_t *builder);
+
+
 /* Return a string whose contents are a concrete representation of
    SKEL.  Allocate the string from POOL.  */
 svn_stringbuf_t *svn_fs__unparse_skel (skel_t *skel, apr_pool_t *pool);
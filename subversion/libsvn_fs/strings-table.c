@@ -15,6 +15,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include "db.h"
 #include "svn_fs.h"
 #include "fs.h"
@@ -75,6 +77,7 @@ locate_key (apr_size_t *length,
   int db_err;
   DBT result;
 
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "creating cursor for reading a string",
                     fs->strings->cursor (fs->strings, trail->db_txn,
                                          cursor, 0)));
@@ -85,6 +88,7 @@ locate_key (apr_size_t *length,
   result.flags |= DB_DBT_USERMEM;
 
   /* Advance the cursor to the key that we're looking for. */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = (*cursor)->c_get (*cursor, query, &result, DB_SET);
 
   /* We don't need to svn_fs__track_dbt() the result, because nothing
@@ -112,6 +116,7 @@ locate_key (apr_size_t *length,
          we need to re-run the operation to make it happen. */
       svn_fs__clear_dbt (&rerun);
       rerun.flags |= DB_DBT_USERMEM | DB_DBT_PARTIAL;
+      SVN_FS__COUNT (fs, db_cursor_ops);
       SVN_ERR (DB_WRAP (fs, "rerunning cursor move",
                         (*cursor)->c_get (*cursor, query, &rerun, DB_SET)));
     }
@@ -123,7 +128,7 @@ locate_key (apr_size_t *length,
 }
 
 static int
-get_next_length (apr_size_t *length, DBC *cursor, DBT *query)
+get_next_length (apr_size_t *length, svn_fs_t *fs, DBC *cursor, DBT *query)
 {
   DBT result;
   int db_err;
@@ -135,6 +140,7 @@ get_next_length (apr_size_t *length, DBC *cursor, DBT *query)
 
   /* Note: this may change the QUERY DBT, but that's okay: we're going
      to be sticking with the same key anyways.  */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor, query, &result, DB_NEXT_DUP);
 
   /* Note that we exit on DB_NOTFOUND. The caller uses that to end a loop. */
@@ -152,6 +158,7 @@ get_next_length (apr_size_t *length, DBC *cursor, DBT *query)
          we need to re-run the operation to make it happen. */
       svn_fs__clear_dbt (&rerun);
       rerun.flags |= DB_DBT_USERMEM | DB_DBT_PARTIAL;
+      SVN_FS__COUNT (fs, db_cursor_ops);
       db_err = cursor->c_get (cursor, query, &rerun, DB_NEXT_DUP);
     }
 
@@ -199,7 +206,7 @@ string_read (svn_fs_t *fs,
     {
       offset -= length;
 
-      db_err = get_next_length (&length, cursor, &query);
+      db_err = get_next_length (&length, fs, cursor, &query);
 
       /* No more records? They tried to read past the end. */
       if (db_err == DB_NOTFOUND)
@@ -221,6 +228,7 @@ string_read (svn_fs_t *fs,
   result.doff = offset;
   result.dlen = *len;
   result.flags |= (DB_DBT_USERMEM | DB_DBT_PARTIAL);
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor, &query, &result, DB_CURRENT);
   if (db_err)
     goto cursor_error;
@@ -239,13 +247,15 @@ cursor_error:
 }
 
 
-svn_error_t *
-svn_fs__string_read (svn_fs_t *fs,
-                     const char *key,
-                     char *buf,
-                     apr_off_t offset,
-                     apr_size_t *len,
-                     trail_t *trail)
+/* The guts of svn_fs__string_read: read *LEN bytes of KEY's string
+   into BUF, starting at OFFSET, straight from the database.  */
+static svn_error_t *
+string_read_all (svn_fs_t *fs,
+                 const char *key,
+                 char *buf,
+                 apr_off_t offset,
+                 apr_size_t *len,
+                 trail_t *trail)
 {
   apr_size_t amt_read = 0;
 
@@ -270,6 +280,241 @@ svn_fs__string_read (svn_fs_t *fs,
 }
 
 
+
+/* Caching string blocks.  */
+
+/* Undeltification reads the same base fulltexts over and over ---
+   once per file derived from them --- and each read is a Berkeley DB
+   cursor dance.  We keep an LRU cache of fixed-size blocks of string
+   data, keyed by string key and block number, so those re-reads are
+   served from memory.
+
+   Writes to a string evict all of its blocks, and an aborted trail
+   throws the whole cache away (see svn_fs__clear_string_cache), for
+   the same reason the node revision cache does.  */
+
+/* The size of one cached block.  */
+#define STRING_CACHE_BLOCK_SIZE 65536
+
+/* How many blocks to keep cached per filesystem.  */
+#define STRING_CACHE_SIZE 32
+
+/* One cached block, in its own subpool so eviction returns the
+   memory.  */
+typedef struct block_entry_t
+{
+  const char *key;              /* The string's key. */
+  const char *hash_key;         /* KEY plus the block number. */
+  apr_size_t hash_key_len;
+  char *data;                   /* STRING_CACHE_BLOCK_SIZE bytes. */
+  apr_size_t len;               /* How much of DATA is valid; less
+                                   than the block size only at the
+                                   end of the string. */
+  apr_pool_t *pool;             /* Subpool holding this entry. */
+  struct block_entry_t *prev;   /* More recently used entry, or null. */
+  struct block_entry_t *next;   /* Less recently used entry, or null. */
+} block_entry_t;
+
+struct svn_fs__string_cache_t
+{
+  apr_pool_t *pool;             /* Subpool of fs->pool holding the cache. */
+  apr_hash_t *hash;             /* Map from hash key to block_entry_t. */
+  block_entry_t *first;         /* Most recently used entry. */
+  block_entry_t *last;          /* Least recently used entry. */
+  int count;                    /* Number of entries in the cache. */
+};
+
+
+/* Return FS's string block cache, creating it if necessary.  */
+static struct svn_fs__string_cache_t *
+get_string_cache (svn_fs_t *fs)
+{
+  if (! fs->string_cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+      struct svn_fs__string_cache_t *cache
+        = apr_pcalloc (pool, sizeof (*cache));
+
+      cache->pool = pool;
+      cache->hash = apr_hash_make (pool);
+      fs->string_cache = cache;
+    }
+  return fs->string_cache;
+}
+
+
+/* Take ENTRY out of CACHE's LRU list.  */
+static void
+block_unlink (struct svn_fs__string_cache_t *cache, block_entry_t *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->first = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->last = entry->prev;
+}
+
+
+/* Put ENTRY at the head of CACHE's LRU list.  */
+static void
+block_link (struct svn_fs__string_cache_t *cache, block_entry_t *entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->first;
+  if (cache->first)
+    cache->first->prev = entry;
+  cache->first = entry;
+  if (! cache->last)
+    cache->last = entry;
+}
+
+
+/* Set *ENTRY_P to the cached block BLOCK of the string KEY in FS,
+   reading it from the database as part of TRAIL if it isn't cached
+   yet.  */
+static svn_error_t *
+get_block (block_entry_t **entry_p,
+           svn_fs_t *fs,
+           const char *key,
+           apr_off_t block,
+           trail_t *trail)
+{
+  struct svn_fs__string_cache_t *cache = get_string_cache (fs);
+  const char *hash_key = apr_psprintf (trail->pool, "%s:%lu",
+                                       key, (unsigned long) block);
+  apr_size_t hash_key_len = strlen (hash_key);
+  block_entry_t *entry = apr_hash_get (cache->hash, hash_key, hash_key_len);
+  apr_pool_t *pool;
+
+  if (entry)
+    {
+      if (entry != cache->first)
+        {
+          block_unlink (cache, entry);
+          block_link (cache, entry);
+        }
+      *entry_p = entry;
+      return SVN_NO_ERROR;
+    }
+
+  if (cache->count >= STRING_CACHE_SIZE)
+    {
+      block_entry_t *victim = cache->last;
+      block_unlink (cache, victim);
+      apr_hash_set (cache->hash, victim->hash_key, victim->hash_key_len,
+                    NULL);
+      --cache->count;
+      svn_pool_destroy (victim->pool);
+    }
+
+  pool = svn_pool_create (cache->pool);
+  entry = apr_palloc (pool, sizeof (*entry));
+  entry->key = apr_pstrdup (pool, key);
+  entry->hash_key = apr_pstrdup (pool, hash_key);
+  entry->hash_key_len = hash_key_len;
+  entry->data = apr_palloc (pool, STRING_CACHE_BLOCK_SIZE);
+  entry->len = STRING_CACHE_BLOCK_SIZE;
+  entry->pool = pool;
+
+  SVN_ERR (string_read_all (fs, key, entry->data,
+                            block * STRING_CACHE_BLOCK_SIZE,
+                            &entry->len, trail));
+
+  apr_hash_set (cache->hash, entry->hash_key, entry->hash_key_len, entry);
+  block_link (cache, entry);
+  ++cache->count;
+
+  *entry_p = entry;
+  return SVN_NO_ERROR;
+}
+
+
+/* Forget all cached blocks of the string KEY in FS.  */
+static void
+evict_string (svn_fs_t *fs, const char *key)
+{
+  struct svn_fs__string_cache_t *cache = fs->string_cache;
+  apr_hash_index_t *hi;
+
+  if (! cache)
+    return;
+
+  /* A null pool makes apr_hash_first use the hash's internal
+     iterator, so evicting doesn't grow the cache pool.  */
+  for (hi = apr_hash_first (NULL, cache->hash);
+       hi;
+       hi = apr_hash_next (hi))
+    {
+      void *val;
+      block_entry_t *entry;
+
+      apr_hash_this (hi, NULL, NULL, &val);
+      entry = val;
+      if (strcmp (entry->key, key) == 0)
+        {
+          block_unlink (cache, entry);
+          apr_hash_set (cache->hash, entry->hash_key, entry->hash_key_len,
+                        NULL);
+          --cache->count;
+          svn_pool_destroy (entry->pool);
+        }
+    }
+}
+
+
+void
+svn_fs__clear_string_cache (svn_fs_t *fs)
+{
+  if (fs->string_cache)
+    {
+      svn_pool_destroy (fs->string_cache->pool);
+      fs->string_cache = NULL;
+    }
+}
+
+
+svn_error_t *
+svn_fs__string_read (svn_fs_t *fs,
+                     const char *key,
+                     char *buf,
+                     apr_off_t offset,
+                     apr_size_t *len,
+                     trail_t *trail)
+{
+  apr_size_t amt_read = 0;
+
+  while (amt_read < *len)
+    {
+      apr_off_t block = (offset + amt_read) / STRING_CACHE_BLOCK_SIZE;
+      apr_size_t block_off = (offset + amt_read) % STRING_CACHE_BLOCK_SIZE;
+      apr_size_t chunk;
+      block_entry_t *entry;
+
+      SVN_ERR (get_block (&entry, fs, key, block, trail));
+
+      /* A read past the end of the string?  */
+      if (block_off >= entry->len)
+        break;
+
+      chunk = entry->len - block_off;
+      if (chunk > *len - amt_read)
+        chunk = *len - amt_read;
+      memcpy (buf + amt_read, entry->data + block_off, chunk);
+      amt_read += chunk;
+
+      /* A short block is the last block of the string.  */
+      if (entry->len < STRING_CACHE_BLOCK_SIZE)
+        break;
+    }
+
+  *len = amt_read;
+  return SVN_NO_ERROR;
+}
+
+
 /* Get the current 'next-key' value and bump the record. */
 static svn_error_t *
 get_key_and_bump (svn_fs_t *fs, const char **key, trail_t *trail)
@@ -289,24 +534,31 @@ get_key_and_bump (svn_fs_t *fs, const char **key, trail_t *trail)
      this database allows duplicates, we can't do an arbitrary 'put' to
      write the new value -- that would append, not overwrite.  */
 
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "creating cursor for reading a string",
                     fs->strings->cursor (fs->strings, trail->db_txn,
                                          &cursor, 0)));
 
   /* Advance the cursor to 'next-key' and read it. */
 
-  db_err = cursor->c_get (cursor,
-                          svn_fs__str_to_dbt (&query,
-                                              (char *) svn_fs__next_key_key),
-                          svn_fs__result_dbt (&result),
-                          DB_SET);
+  do
+    {
+      SVN_FS__COUNT (fs, db_cursor_ops);
+      db_err = cursor->c_get (cursor,
+                              svn_fs__str_to_dbt (&query,
+                                                  (char *)
+                                                  svn_fs__next_key_key),
+                              svn_fs__result_dbt_reuse (&result, trail),
+                              DB_SET);
+    }
+  while (svn_fs__retry_dbt_reuse (&result, trail, db_err));
+
   if (db_err)
     {
       cursor->c_close (cursor);
       return DB_WRAP (fs, "getting next-key value", db_err);
     }
 
-  svn_fs__track_dbt (&result, trail->pool);
   *key = apr_pstrndup (trail->pool, result.data, result.size);
 
   /* Bump to future key. */
@@ -314,6 +566,7 @@ get_key_and_bump (svn_fs_t *fs, const char **key, trail_t *trail)
   svn_fs__next_key (result.data, &key_len, next_key);
 
   /* Shove the new key back into the database, at the cursor position. */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_put (cursor, &query,
                           svn_fs__str_to_dbt (&result, (char *) next_key),
                           DB_CURRENT);
@@ -323,6 +576,27 @@ get_key_and_bump (svn_fs_t *fs, const char **key, trail_t *trail)
   return DB_WRAP (fs, "bumping next string key", db_err);
 }
 
+/* Append the LEN bytes at BUF as one new record of string KEY in FS,
+   as part of TRAIL.  */
+static svn_error_t *
+string_put_record (svn_fs_t *fs,
+                   const char *key,
+                   const char *buf,
+                   apr_size_t len,
+                   trail_t *trail)
+{
+  DBT query, result;
+
+  SVN_FS__COUNT (fs, db_puts);
+  return DB_WRAP (fs, "appending string",
+                  fs->strings->put
+                  (fs->strings, trail->db_txn,
+                   svn_fs__str_to_dbt (&query, (char *) key),
+                   svn_fs__set_dbt (&result, (void *) buf, len),
+                   0));
+}
+
+
 svn_error_t *
 svn_fs__string_append (svn_fs_t *fs,
                        const char **key,
@@ -330,8 +604,6 @@ svn_fs__string_append (svn_fs_t *fs,
                        const char *buf,
                        trail_t *trail)
 {
-  DBT query, result;
-
   /* If the passed-in key is NULL, we graciously generate a new string
      using the value of the `next-key' record in the strings table. */
   if (*key == NULL)
@@ -340,12 +612,83 @@ svn_fs__string_append (svn_fs_t *fs,
     }
 
   /* Store a new record into the database. */
-  SVN_ERR (DB_WRAP (fs, "appending string",
-                    fs->strings->put
-                    (fs->strings, trail->db_txn,
-                     svn_fs__str_to_dbt (&query, (char *) (*key)),
-                     svn_fs__set_dbt (&result, (void *) buf, len),
-                     0)));
+  SVN_ERR (string_put_record (fs, *key, buf, len, trail));
+
+  evict_string (fs, *key);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs__string_appendv (svn_fs_t *fs,
+                        const char **key,
+                        const svn_fs__string_chunk_t *chunks,
+                        int nchunks,
+                        trail_t *trail)
+{
+  char *staging = NULL;
+  apr_size_t staged = 0;
+  int put_something = 0;
+  int i;
+
+  /* If the passed-in key is NULL, we graciously generate a new string
+     using the value of the `next-key' record in the strings table. */
+  if (*key == NULL)
+    {
+      SVN_ERR (get_key_and_bump (fs, key, trail));
+    }
+
+  for (i = 0; i < nchunks; i++)
+    {
+      const char *data = chunks[i].data;
+      apr_size_t len = chunks[i].len;
+
+      while (len > 0)
+        {
+          apr_size_t take;
+
+          /* A chunk that fills a whole record all by itself can go to
+             the database directly, with no gathering copy.  */
+          if (staged == 0 && len >= SVN_FS__STRING_RECORD_SIZE)
+            {
+              SVN_ERR (string_put_record (fs, *key, data,
+                                          SVN_FS__STRING_RECORD_SIZE,
+                                          trail));
+              put_something = 1;
+              data += SVN_FS__STRING_RECORD_SIZE;
+              len -= SVN_FS__STRING_RECORD_SIZE;
+              continue;
+            }
+
+          /* Otherwise, gather into the staging buffer... */
+          take = SVN_FS__STRING_RECORD_SIZE - staged;
+          if (take > len)
+            take = len;
+          if (! staging)
+            staging = apr_palloc (trail->pool, SVN_FS__STRING_RECORD_SIZE);
+          memcpy (staging + staged, data, take);
+          staged += take;
+          data += take;
+          len -= take;
+
+          /* ...and flush it whenever it fills a whole record.  */
+          if (staged == SVN_FS__STRING_RECORD_SIZE)
+            {
+              SVN_ERR (string_put_record (fs, *key, staging, staged, trail));
+              put_something = 1;
+              staged = 0;
+            }
+        }
+    }
+
+  /* Flush whatever's left over.  If the chunks held no data at all,
+     store an empty record anyway, so the string exists --- that's
+     what svn_fs__string_append does for a zero-length append.  */
+  if (staged > 0 || ! put_something)
+    SVN_ERR (string_put_record (fs, *key, staging, staged, trail));
+
+  evict_string (fs, *key);
 
   return SVN_NO_ERROR;
 }
@@ -362,6 +705,7 @@ svn_fs__string_clear (svn_fs_t *fs,
   svn_fs__str_to_dbt (&query, (char *)key);
 
   /* Torch the prior contents */
+  SVN_FS__COUNT (fs, db_puts);
   db_err = fs->strings->del (fs->strings, trail->db_txn, &query, 0);
 
   /* If there's no such node, return an appropriately specific error.  */
@@ -379,6 +723,9 @@ svn_fs__string_clear (svn_fs_t *fs,
   result.size = 0;
   result.flags |= DB_DBT_USERMEM;
 
+  evict_string (fs, key);
+
+  SVN_FS__COUNT (fs, db_puts);
   return DB_WRAP (fs, "storing empty contents",
                   fs->strings->put (fs->strings, trail->db_txn,
                                     &query, &result, 0));
@@ -404,7 +751,7 @@ svn_fs__string_size (apr_size_t *size,
   total = length;
   while (1)
     {
-      db_err = get_next_length (&length, cursor, &query);
+      db_err = get_next_length (&length, fs, cursor, &query);
 
       /* No more records? Then return the total length. */
       if (db_err == DB_NOTFOUND)
@@ -422,14 +769,156 @@ svn_fs__string_size (apr_size_t *size,
 }
 
 
+
+/* String reference counts.
+
+   svn_fs__get_mutable_rep used to copy a whole fulltext string just
+   to give the new mutable rep its own bytes, although the copy is
+   usually cleared and rewritten, or discarded with an aborted
+   transaction, without its inherited contents ever being read.
+   Instead, representations may share one string, with the sharing
+   tallied here: a record stored under the out-of-band key
+   "KEY-refs" holds the string's reference count as a decimal
+   number.  No record means a count of one, so the unshared majority
+   of strings pay nothing.  Deleting a shared string just decrements
+   the count; the bytes go away with the last reference.
+
+   A shared string must never be modified in place --- the sharers
+   would all see the change.  svn_fs__string_unshare gives a writer
+   a private string to scribble on.  */
+
+/* Return the key of the record holding string KEY's reference
+   count, allocated in POOL.  */
+static const char *
+refcount_key (const char *key, apr_pool_t *pool)
+{
+  return apr_pstrcat (pool, key, SVN_FS__STRING_REFS_SUFFIX, NULL);
+}
+
+
+/* Set *COUNT to the number of references to string KEY in FS, as
+   part of TRAIL.  A string with no reference count record has
+   exactly one reference.  */
+static svn_error_t *
+read_refcount (int *count,
+               svn_fs_t *fs,
+               const char *key,
+               trail_t *trail)
+{
+  int db_err;
+  DBT query, result;
+
+  SVN_FS__COUNT (fs, db_gets);
+  db_err = fs->strings->get
+    (fs->strings, trail->db_txn,
+     svn_fs__str_to_dbt (&query, (char *) refcount_key (key, trail->pool)),
+     svn_fs__result_dbt (&result), 0);
+  svn_fs__track_dbt (&result, trail->pool);
+
+  if (db_err == DB_NOTFOUND)
+    {
+      *count = 1;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR (DB_WRAP (fs, "reading string reference count", db_err));
+
+  *count = atoi (apr_pstrndup (trail->pool, result.data, result.size));
+  return SVN_NO_ERROR;
+}
+
+
+/* Record COUNT as the number of references to string KEY in FS, as
+   part of TRAIL.  A count of one removes the record --- no record
+   means one reference.  */
+static svn_error_t *
+write_refcount (svn_fs_t *fs,
+                const char *key,
+                int count,
+                trail_t *trail)
+{
+  int db_err;
+  DBT query, result;
+
+  /* The strings table allows duplicates, so a plain put would
+     append a second count rather than replace the old one; delete
+     any old record first.  */
+  svn_fs__str_to_dbt (&query, (char *) refcount_key (key, trail->pool));
+
+  SVN_FS__COUNT (fs, db_puts);
+  db_err = fs->strings->del (fs->strings, trail->db_txn, &query, 0);
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, "deleting old string reference count", db_err));
+
+  if (count <= 1)
+    return SVN_NO_ERROR;
+
+  SVN_FS__COUNT (fs, db_puts);
+  return DB_WRAP (fs, "storing string reference count",
+                  fs->strings->put
+                  (fs->strings, trail->db_txn, &query,
+                   svn_fs__str_to_dbt (&result,
+                                       apr_psprintf (trail->pool,
+                                                     "%d", count)),
+                   0));
+}
+
+
+svn_error_t *
+svn_fs__string_addref (svn_fs_t *fs,
+                       const char *key,
+                       trail_t *trail)
+{
+  int count;
+
+  SVN_ERR (read_refcount (&count, fs, key, trail));
+  return write_refcount (fs, key, count + 1, trail);
+}
+
+
+svn_error_t *
+svn_fs__string_unshare (svn_fs_t *fs,
+                        const char **key,
+                        svn_boolean_t keep_contents,
+                        trail_t *trail)
+{
+  int count;
+
+  SVN_ERR (read_refcount (&count, fs, *key, trail));
+  if (count == 1)
+    return SVN_NO_ERROR;
+
+  /* Somebody else holds the bytes too; leave them theirs and switch
+     to a private string.  */
+  SVN_ERR (write_refcount (fs, *key, count - 1, trail));
+
+  if (keep_contents)
+    return svn_fs__string_copy (fs, key, *key, trail);
+  else
+    {
+      const char *new_key = NULL;
+      SVN_ERR (svn_fs__string_append (fs, &new_key, 0, NULL, trail));
+      *key = new_key;
+      return SVN_NO_ERROR;
+    }
+}
+
+
 svn_error_t *
 svn_fs__string_delete (svn_fs_t *fs,
                        const char *key,
                        trail_t *trail)
 {
   int db_err;
+  int count;
   DBT query;
 
+  /* A shared string survives its deleters until the last one; just
+     drop one reference.  */
+  SVN_ERR (read_refcount (&count, fs, key, trail));
+  if (count > 1)
+    return write_refcount (fs, key, count - 1, trail);
+
+  SVN_FS__COUNT (fs, db_puts);
   db_err = fs->strings->del (fs->strings, trail->db_txn,
                              svn_fs__str_to_dbt (&query, (char *) key), 0);
 
@@ -442,6 +931,8 @@ svn_fs__string_delete (svn_fs_t *fs,
   /* Handle any other error conditions.  */
   SVN_ERR (DB_WRAP (fs, "deleting string", db_err));
 
+  evict_string (fs, key);
+
   return SVN_NO_ERROR;
 }
 
@@ -460,6 +951,7 @@ svn_fs__string_copy (svn_fs_t *fs,
 
   SVN_ERR (get_key_and_bump (fs, new_key, trail));
 
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "creating cursor for reading a string",
                     fs->strings->cursor (fs->strings, trail->db_txn,
                                          &cursor, 0)));
@@ -470,6 +962,7 @@ svn_fs__string_copy (svn_fs_t *fs,
   svn_fs__clear_dbt (&result);
 
   /* Move to the first record and fetch its data (under BDB's mem mgmt). */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   db_err = cursor->c_get (cursor, &query, &result, DB_SET);
   if (db_err)
     {
@@ -487,6 +980,7 @@ svn_fs__string_copy (svn_fs_t *fs,
       */
 
       /* Write the data to the database */
+      SVN_FS__COUNT (fs, db_puts);
       db_err = fs->strings->put (fs->strings, trail->db_txn,
                                  &copykey, &result, 0);
       if (db_err)
@@ -497,6 +991,7 @@ svn_fs__string_copy (svn_fs_t *fs,
 
       /* Read the next chunk. Terminate loop if we're done. */
       svn_fs__clear_dbt (&result);
+      SVN_FS__COUNT (fs, db_cursor_ops);
       db_err = cursor->c_get (cursor, &query, &result, DB_NEXT_DUP);
       if (db_err == DB_NOTFOUND)
         break;
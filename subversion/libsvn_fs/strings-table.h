@@ -69,6 +69,13 @@ svn_error_t *svn_fs__string_read (svn_fs_t *fs,
                                   trail_t *trail);
 
 
+/* Discard FS's in-memory cache of string blocks.  Called when a
+ * trail aborts, since blocks read within the aborted transaction may
+ * never have been committed.
+ */
+void svn_fs__clear_string_cache (svn_fs_t *fs);
+
+
 /* Set *SIZE to the size in bytes of string KEY in FS, as part of
  * TRAIL.
  *
@@ -98,6 +105,38 @@ svn_error_t *svn_fs__string_append (svn_fs_t *fs,
                                     trail_t *trail);
 
 
+/* The record size svn_fs__string_appendv coalesces gathered data
+   into.  Larger records mean fewer Berkeley DB puts (and less log
+   traffic) for the same data; smaller records mean finer-grained
+   reads.  Overridable at build time.  */
+#ifndef SVN_FS__STRING_RECORD_SIZE
+#define SVN_FS__STRING_RECORD_SIZE 102400
+#endif
+
+
+/* One chunk of data for svn_fs__string_appendv.  */
+typedef struct svn_fs__string_chunk_t
+{
+  const char *data;
+  apr_size_t len;
+} svn_fs__string_chunk_t;
+
+
+/* Append the data in the NCHUNKS gathered CHUNKS to string *KEY in
+ * FS, as part of TRAIL, coalescing the data into records of up to
+ * SVN_FS__STRING_RECORD_SIZE bytes, rather than writing one record
+ * per chunk as repeated svn_fs__string_append calls would.
+ *
+ * Key handling is the same as for svn_fs__string_append: if *KEY is
+ * null, create a new string and store the new key in *KEY (allocating
+ * it in TRAIL->pool).  */
+svn_error_t *svn_fs__string_appendv (svn_fs_t *fs,
+                                     const char **key,
+                                     const svn_fs__string_chunk_t *chunks,
+                                     int nchunks,
+                                     trail_t *trail);
+
+
 /* Make string KEY in FS zero length, as part of TRAIL.
  * If the string does not exist, return SVN_ERR_FS_NO_SUCH_STRING.
  */
@@ -107,17 +146,54 @@ svn_error_t *svn_fs__string_clear (svn_fs_t *fs,
 
 
 /* Delete string KEY from FS, as part of TRAIL.
+ *
+ * Strings are reference counted: if KEY has more than one reference
+ * (see svn_fs__string_addref), this just drops one of them, and the
+ * bytes survive for the string's remaining holders.
  *
  * If string KEY does not exist, return SVN_ERR_FS_NO_SUCH_STRING.
  *
  * WARNING: Deleting a string renders unusable any representations
  * that refer to it.  Be careful.
- */ 
+ */
 svn_error_t *svn_fs__string_delete (svn_fs_t *fs,
                                     const char *key,
                                     trail_t *trail);
 
 
+/* The suffix appended to a string's key to form the key of the
+ * record holding its reference count.  Generated string keys never
+ * contain a hyphen, so --- as with `next-key' --- these records can
+ * never collide with a real string.  */
+#define SVN_FS__STRING_REFS_SUFFIX "-refs"
+
+
+/* Add a reference to string KEY in FS, as part of TRAIL.  KEY must
+ * name an existing string.
+ *
+ * Each reference absorbs one svn_fs__string_delete; the bytes are
+ * only really removed when the last reference is deleted.
+ * Representations that share one string take a reference apiece.
+ *
+ * A string with more than one reference must never be modified in
+ * place; call svn_fs__string_unshare before writing.  */
+svn_error_t *svn_fs__string_addref (svn_fs_t *fs,
+                                    const char *key,
+                                    trail_t *trail);
+
+
+/* If string *KEY in FS has more than one reference, drop this
+ * caller's reference and set *KEY to the key of a private
+ * replacement, allocated in TRAIL->pool: a copy of the old contents
+ * if KEEP_CONTENTS is set, a new empty string otherwise.  If *KEY is
+ * unshared, leave it untouched.  Call this before modifying a string
+ * that might be shared.  */
+svn_error_t *svn_fs__string_unshare (svn_fs_t *fs,
+                                     const char **key,
+                                     svn_boolean_t keep_contents,
+                                     trail_t *trail);
+
+
 /* Copy the contents of the string referred to by KEY in FS into a new
  * record, returning the new record's key in *NEW_KEY.  All
  * allocations (including *NEW_KEY) occur in TRAIL->pool.  */
@@ -17,10 +17,17 @@
 
 #include "db.h"
 #include "apr_pools.h"
+#include "apr_time.h"
 #include "svn_pools.h"
 #include "svn_fs.h"
 #include "fs.h"
 #include "err.h"
+#include "skel.h"
+#include "nodes-table.h"
+#include "strings-table.h"
+#include "rev-table.h"
+#include "txn-table.h"
+#include "dag.h"
 #include "trail.h"
 
 
@@ -51,6 +58,10 @@ begin_trail (trail_t **trail_p,
 
   trail->pool = svn_pool_create (pool);
   trail->undo = 0;
+#ifdef SVN_FS_TRAIL_STATS
+  fs->stats.trails++;
+  trail->start_time = apr_time_now ();
+#endif
   SVN_ERR (DB_WRAP (fs, "beginning Berkeley DB transaction",
                     fs->env->txn_begin (fs->env, 0, &trail->db_txn, 0)));
 
@@ -73,7 +84,18 @@ abort_trail (trail_t *trail,
 
   SVN_ERR (DB_WRAP (fs, "aborting Berkeley DB transaction",
                     trail->db_txn->abort (trail->db_txn)));
- 
+
+  /* The node revision, string, revision, transaction, and directory
+     entry caches may hold data read or written within this
+     transaction, which never really happened.  Toss them.  */
+  svn_fs__clear_node_cache (fs);
+  svn_fs__clear_string_cache (fs);
+  svn_fs__clear_rev_cache (fs);
+  svn_fs__clear_txn_cache (fs);
+  svn_fs__clear_dir_cache (fs);
+
+  SVN_FS__STAT_ADD (fs, trail_time, apr_time_now () - trail->start_time);
+
   svn_pool_destroy (trail->pool);
 
   return SVN_NO_ERROR;
@@ -98,11 +120,15 @@ commit_trail (trail_t *trail,
   SVN_ERR (DB_WRAP (fs, "committing Berkeley DB transaction",
                     trail->db_txn->commit (trail->db_txn, 0)));
 
-  /* Do a checkpoint here, if enough has gone on.
-     The checkpoint parameters below are pretty arbitrary.  Perhaps
-     there should be an svn_fs_berkeley_mumble function to set them.  */
+  /* Do a checkpoint here, if enough has gone on.  The parameters
+     default to 1024k / 5 minutes; use
+     svn_fs_set_berkeley_checkpoint_policy to change them.  */
   SVN_ERR (DB_WRAP (fs, "checkpointing after Berkeley DB transaction",
-                    fs->env->txn_checkpoint (fs->env, 1024, 5, 0)));
+                    fs->env->txn_checkpoint (fs->env,
+                                             fs->checkpoint_kbytes,
+                                             fs->checkpoint_minutes, 0)));
+
+  SVN_FS__STAT_ADD (fs, trail_time, apr_time_now () - trail->start_time);
 
   /* We don't destroy the pool; we assume it contains stuff which will
      be useful beyond the transaction.  */
@@ -116,11 +142,19 @@ svn_fs__retry_txn (svn_fs_t *fs,
                    void *baton,
                    apr_pool_t *pool)
 {
+  /* If a read batch is open on FS, just run the body inside the
+     batch's transaction; beginning a nested transaction here would
+     forfeit the batching, and committing it would release the batch's
+     locks.  A deadlock simply propagates out of the batch body, and
+     svn_fs_read_batch retries the whole batch.  */
+  if (fs->batch_trail)
+    return (*txn_body) (baton, fs->batch_trail);
+
   for (;;)
     {
       trail_t *trail;
       svn_error_t *svn_err;
-      
+
       SVN_ERR (begin_trail (&trail, fs, pool));
 
       /* Do the body of the transaction.  */
@@ -144,6 +178,53 @@ svn_fs__retry_txn (svn_fs_t *fs,
         }
 
       /* We deadlocked.  Abort the transaction, and try again.  */
+      SVN_FS__STAT_ADD (fs, deadlocks, 1);
+      SVN_ERR (abort_trail (trail, fs));
+    }
+}
+
+
+svn_error_t *
+svn_fs_read_batch (svn_fs_t *fs,
+                   svn_error_t *(*batch_body) (void *baton,
+                                               apr_pool_t *pool),
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  for (;;)
+    {
+      trail_t *trail;
+      svn_error_t *svn_err;
+
+      SVN_ERR (begin_trail (&trail, fs, pool));
+
+      /* Do the body of the batch.  Any filesystem reads the body
+         makes reach svn_fs__retry_txn, which sees FS->batch_trail and
+         runs inside our transaction rather than opening its own.  */
+      fs->batch_trail = trail;
+      svn_err = (*batch_body) (baton, trail->pool);
+      fs->batch_trail = NULL;
+
+      if (! svn_err)
+        {
+          /* The batch succeeded!  Commit it.  */
+          SVN_ERR (commit_trail (trail, fs));
+
+          return SVN_NO_ERROR;
+        }
+
+      /* Is this a real error, or do we just need to retry?  */
+      if (svn_err->apr_err != SVN_ERR_BERKELEY_DB
+          || svn_err->src_err != DB_LOCK_DEADLOCK)
+        {
+          /* Ignore any error returns.  The first error is more valuable.  */
+          abort_trail (trail, fs);
+          return svn_err;
+        }
+
+      /* We deadlocked.  Abort the transaction, and run the whole
+         batch again.  */
+      SVN_FS__STAT_ADD (fs, deadlocks, 1);
       SVN_ERR (abort_trail (trail, fs));
     }
 }
@@ -183,6 +264,15 @@ svn_fs__record_completion (trail_t *trail,
 }
 
 
+struct svn_fs__skel_builder_t *
+svn_fs__trail_skel_builder (trail_t *trail)
+{
+  if (! trail->skel_builder)
+    trail->skel_builder = svn_fs__skel_builder_create (trail->pool);
+  return trail->skel_builder;
+}
+
+
 
 /* 
  * local variables:
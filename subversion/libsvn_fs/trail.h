@@ -20,6 +20,7 @@
 
 #include "db.h"
 #include "apr_pools.h"
+#include "apr_time.h"
 #include "svn_fs.h"
 
 #ifdef __cplusplus
@@ -141,6 +142,23 @@ struct trail_t
   /* A record of the side-effects to be undone in various
      circumstances.  */
   struct undo *undo;
+
+  /* A scratch buffer for retrieving Berkeley DB records via
+     svn_fs__result_dbt_reuse, shared by all the operations in this
+     trail and grown geometrically as records demand.  Null until the
+     first retrieval needs it.  */
+  char *scratch;
+  apr_size_t scratch_size;
+
+  /* A slab allocator for skel_t nodes, shared by all the skel
+     construction this trail's operations do.  Null until the first
+     call to svn_fs__trail_skel_builder.  */
+  struct svn_fs__skel_builder_t *skel_builder;
+
+  /* When this trail's Berkeley DB transaction was begun.  Only set
+     when the library is compiled with -DSVN_FS_TRAIL_STATS, for the
+     trail-time accounting in the filesystem's statistics.  */
+  apr_time_t start_time;
 };
 typedef struct trail_t trail_t;
 
@@ -169,7 +187,12 @@ typedef struct trail_t trail_t;
    One benefit of using this function is that it makes it easy to
    ensure that whatever transactions a filesystem function starts, it
    either aborts or commits before it returns.  If we don't somehow
-   complete all our transactions, later operations could deadlock.  */
+   complete all our transactions, later operations could deadlock.
+
+   Exception: while a read batch is open on FS (see
+   svn_fs_read_batch), TXN_BODY is simply run inside the batch's
+   trail, and committing, aborting, and deadlock retry all happen at
+   the batch level instead.  */
 svn_error_t *svn_fs__retry_txn (svn_fs_t *fs,
                                 svn_error_t *(*txn_body) (void *baton,
                                                           trail_t *trail),
@@ -217,7 +240,15 @@ void svn_fs__record_undo (trail_t *trail,
 void svn_fs__record_completion (trail_t *trail,
                                 void (*func) (void *baton),
                                 void *baton);
-                                     
+
+
+/* Return TRAIL's skel builder (see skel.h), creating it in
+   TRAIL->pool on first use.  Skels built with it stay valid until
+   the trail completes --- long enough even for node-revision skels,
+   which set_node_revision caches on dag nodes for the rest of the
+   trail.  */
+struct svn_fs__skel_builder_t *svn_fs__trail_skel_builder (trail_t *trail);
+
 
 
 #ifdef __cplusplus
@@ -45,6 +45,7 @@
 #include "trail.h"
 #include "txn-table.h"
 #include "rev-table.h"
+#include "changes-table.h"
 #include "nodes-table.h"
 #include "node-rev.h"
 #include "txn.h"
@@ -83,6 +84,15 @@ typedef enum root_kind_t {
   id_root
 } root_kind_t;
 
+
+/* The number of directory lookups a revision root remembers; see the
+   node_cache members of svn_fs_root_t, below.  Keep this small: the
+   cache exists to catch svn_repos_dir_delta-style access patterns,
+   where consecutive calls open sibling paths under a common parent,
+   not to hold whole trees in memory.  */
+#define NODE_CACHE_MAX_KEYS 32
+
+
 struct svn_fs_root_t
 {
 
@@ -110,6 +120,18 @@ struct svn_fs_root_t
      afresh every time, since the root may have been cloned, or
      the transaction may have disappeared altogether.  */
   dag_node_t *root_dir;
+
+  /* For revision roots, a cache of recent path lookups: a hash
+     mapping directory paths (as open_path walks them) onto struct
+     node_cache_entry_t values, created lazily by the first
+     insertion, and a ring of the cached paths so the oldest entry
+     can be evicted once all NODE_CACHE_MAX_KEYS slots are full.
+     Only revision roots are cached: their nodes are immutable, so
+     entries never go stale.  Transaction roots get no cache, since
+     their nodes may be cloned at any moment.  */
+  apr_hash_t *node_cache;
+  const char *node_cache_keys[NODE_CACHE_MAX_KEYS];
+  int node_cache_idx;
 };
 
 
@@ -127,6 +149,8 @@ make_root (svn_fs_t *fs,
   apr_pool_t *subpool = svn_pool_create (pool);
   svn_fs_root_t *root = apr_pcalloc (subpool, sizeof (*root));
 
+  svn_pool_tag (subpool, "fs:root");
+
   root->fs = fs;
   root->pool = pool;
 
@@ -419,6 +443,93 @@ next_entry_name (const char **next_p,
 }
 
 
+/* Caching path lookups in revision roots.  */
+
+
+/* One slot in a revision root's path lookup cache.  */
+struct node_cache_entry_t
+{
+  /* The dag node this path refers to, allocated in POOL.  */
+  dag_node_t *node;
+
+  /* The slot's private subpool, holding NODE and the path it is
+     cached under; cleared when the slot is re-used for some other
+     path.  */
+  apr_pool_t *pool;
+};
+
+
+/* If the node PATH refers to in ROOT is in ROOT's lookup cache,
+   return a copy of it allocated in TRAIL->pool; otherwise, return
+   zero.  */
+static dag_node_t *
+dag_node_cache_get (svn_fs_root_t *root,
+                    const char *path,
+                    trail_t *trail)
+{
+  struct node_cache_entry_t *entry;
+
+  if (root->kind != revision_root || ! root->node_cache)
+    return 0;
+
+  entry = apr_hash_get (root->node_cache, path, APR_HASH_KEY_STRING);
+  if (! entry)
+    return 0;
+
+  return svn_fs__dag_dup (entry->node, trail);
+}
+
+
+/* Remember NODE as the node PATH refers to in ROOT.  Does nothing
+   for roots other than revision roots, whose nodes are the only ones
+   guaranteed not to change out from under the cache.  */
+static void
+dag_node_cache_set (svn_fs_root_t *root,
+                    const char *path,
+                    dag_node_t *node)
+{
+  struct node_cache_entry_t *entry;
+  const char *cache_path;
+
+  if (root->kind != revision_root)
+    return;
+
+  if (! root->node_cache)
+    root->node_cache = apr_hash_make (root->pool);
+
+  /* The node an immutable path refers to never changes, so if the
+     path is already cached, there is nothing to update.  */
+  if (apr_hash_get (root->node_cache, path, APR_HASH_KEY_STRING))
+    return;
+
+  /* Claim the next slot in the ring, evicting whatever it held.
+     Each slot keeps a private subpool, so evicting one entry frees
+     its storage without disturbing the others.  */
+  if (root->node_cache_keys[root->node_cache_idx])
+    {
+      const char *old_path = root->node_cache_keys[root->node_cache_idx];
+
+      entry = apr_hash_get (root->node_cache, old_path, APR_HASH_KEY_STRING);
+      apr_hash_set (root->node_cache, old_path, APR_HASH_KEY_STRING, 0);
+      svn_pool_clear (entry->pool);
+    }
+  else
+    {
+      entry = apr_palloc (root->pool, sizeof (*entry));
+      entry->pool = svn_pool_create (root->pool);
+      svn_pool_tag (entry->pool, "fs:node-cache");
+    }
+
+  cache_path = apr_pstrdup (entry->pool, path);
+  entry->node = svn_fs__dag_dup_into_pool (node, entry->pool);
+
+  root->node_cache_keys[root->node_cache_idx] = cache_path;
+  root->node_cache_idx = ((root->node_cache_idx + 1)
+                          % NODE_CACHE_MAX_KEYS);
+  apr_hash_set (root->node_cache, cache_path, APR_HASH_KEY_STRING, entry);
+}
+
+
 /* Flags for open_path.  */
 typedef enum open_path_flags_t {
 
@@ -468,6 +579,10 @@ open_path (parent_path_t **parent_path_p,
   /* The portion of PATH we haven't traversed yet.  */
   const char *rest = path;
 
+  /* The portion of PATH we have traversed, in canonical form; this is
+     what we cache lookups under.  */
+  const char *path_so_far = "";
+
   if (svn_fs_is_id_root (root))
     {
       dag_node_t *node;
@@ -512,35 +627,46 @@ open_path (parent_path_t **parent_path_p,
             child = here;
           else
             {
-              /* If we found a directory entry, follow it.  */
-              svn_error_t *svn_err = svn_fs__dag_open (&child, here,
-                                                       entry, trail);
-              
-              /* "file not found" requires special handling.  */
-              if (svn_err && svn_err->apr_err == SVN_ERR_FS_NOT_FOUND)
-                {
-                  /* If this was the last path component, and the caller
-                     said it was optional, then don't return an error;
-                     just put a zero node pointer in the path.  */
+              path_so_far = apr_pstrcat (pool, path_so_far, "/", entry, NULL);
 
-                  svn_error_clear_all (svn_err);
+              /* Did some recent lookup already open this entry?  */
+              child = dag_node_cache_get (root, path_so_far, trail);
 
-                  if ((flags & open_path_last_optional)
-                      && (! next || *next == '\0'))
+              if (! child)
+                {
+                  /* If we found a directory entry, follow it.  */
+                  svn_error_t *svn_err = svn_fs__dag_open (&child, here,
+                                                           entry, trail);
+
+                  /* "file not found" requires special handling.  */
+                  if (svn_err && svn_err->apr_err == SVN_ERR_FS_NOT_FOUND)
                     {
-                      parent_path = make_parent_path (0, entry,
-                                                      parent_path, pool);
-                      break;
+                      /* If this was the last path component, and the caller
+                         said it was optional, then don't return an error;
+                         just put a zero node pointer in the path.  */
+
+                      svn_error_clear_all (svn_err);
+
+                      if ((flags & open_path_last_optional)
+                          && (! next || *next == '\0'))
+                        {
+                          parent_path = make_parent_path (0, entry,
+                                                          parent_path, pool);
+                          break;
+                        }
+                      else
+                        /* Build a better error message than
+                           svn_fs__dag_open can provide, giving the root
+                           and full path name.  */
+                        return not_found (root, path);
                     }
-                  else
-                    /* Build a better error message than svn_fs__dag_open
-                       can provide, giving the root and full path name.  */
-                    return not_found (root, path);
+
+                  /* Other errors we return normally.  */
+                  SVN_ERR (svn_err);
+
+                  dag_node_cache_set (root, path_so_far, child);
                 }
-              
-              /* Other errors we return normally.  */
-              SVN_ERR (svn_err);
-              
+
               parent_path = make_parent_path (child, entry, parent_path, pool);
             }
           
@@ -881,16 +1007,13 @@ txn_body_node_prop (void *baton,
 {
   struct node_prop_args *args = baton;
   dag_node_t *node;
-  skel_t *proplist;
 
   SVN_ERR (get_dag (&node, args->root, args->path, trail));
-  SVN_ERR (svn_fs__dag_get_proplist (&proplist, node, trail));
 
-  /* Return the results of the generic property getting function. */
-  return svn_fs__get_prop (args->value_p,
-                           proplist,
-                           args->propname,
-                           trail->pool);
+  /* The dag layer caches the property list, so asking for one
+     property doesn't re-read the whole list on every call. */
+  return svn_fs__dag_get_prop (args->value_p, node,
+                               args->propname, trail);
 }
 
 
@@ -935,6 +1058,7 @@ txn_body_node_proplist (void *baton, trail_t *trail)
 
   /* Return the results of the generic property hash getting function. */
   return svn_fs__make_prop_hash (args->table_p,
+                                 args->root->fs,
                                  proplist,
                                  trail->pool);
 }
@@ -982,6 +1106,10 @@ txn_body_change_node_prop (void *baton,
   SVN_ERR (svn_fs__set_prop (proplist, args->name, args->value, trail->pool));
   SVN_ERR (svn_fs__dag_set_proplist (parent_path->node, proplist, trail));
 
+  /* Make a record of this modification in the changes table. */
+  SVN_ERR (add_change (args->root, args->path, SVN_FS__CHANGE_REPLACE,
+                       trail));
+
   return SVN_NO_ERROR;
 }
 
@@ -1012,6 +1140,7 @@ svn_fs_change_node_prop (svn_fs_root_t *root,
 struct things_changed_args
 {
   int *changed_p;
+  int *contents_changed_p;   /* only used by txn_body_things_changed */
   svn_fs_root_t *root1;
   svn_fs_root_t *root2;
   const char *path1;
@@ -1160,11 +1289,15 @@ merge (const char **conflict_p,
   *conflict_p = NULL;
 
   /* Base cases:
-   * Either no change made in source, or same change as made in target.
-   * Both mean nothing to merge here.
+   * Either no change made in source, or target already descends from
+   * source --- which covers the same-change-in-both case --- so
+   * everything that happened in source is part of target's history
+   * already.  Both mean nothing to merge here, and since the check is
+   * a walk of two ID's already in memory, we skip such subtrees
+   * without ever reading them.
    */
   if (svn_fs__id_eq (ancestor_id, source_id)
-      || (svn_fs__id_eq (source_id, target_id)))
+      || svn_fs__id_is_ancestor (source_id, target_id))
     return SVN_NO_ERROR;
 
   /* Else proceed, knowing all three are distinct node revisions.
@@ -1190,7 +1323,8 @@ merge (const char **conflict_p,
    *       {
    *         if (source entry points to different id than E)
    *           {
-   *             if (target entry points to same id as ancestor E)
+   *             if (target entry points to same id as ancestor E,
+   *                 or source entry descends from target entry)
    *               change target to point to same id as source entry;
    *             else if ((target entry id different from source)
    *                      && (target entry not descended from source))
@@ -1307,12 +1441,12 @@ merge (const char **conflict_p,
           if (! svn_fs__id_eq (a_entry->id, s_entry->id))
             {
               /* ... and if target entry has not changed,
-                 - OR - if target descends from ancestor, and source
-                 descends from target... */
+                 - OR - if source descends from target, so that taking
+                 source is a fast-forward that loses none of target's
+                 history... */
               if ( (svn_fs__id_eq (a_entry->id, t_entry->id))
-                   || ( (svn_fs__id_is_ancestor(a_entry->id, t_entry->id)) 
-                        && (svn_fs__id_is_ancestor(t_entry->id,
-                                                   s_entry->id))) )
+                   || (svn_fs__id_is_ancestor (t_entry->id,
+                                               s_entry->id)) )
                 {
                   /* ### kff todo: what about svn_fs__dag_link()
                      instead of svn_fs__dag_set_entry()?  The cycle
@@ -1753,6 +1887,14 @@ txn_body_commit (void *baton, trail_t *trail)
   /* Else, commit the txn. */
   SVN_ERR (svn_fs__dag_commit_txn (&(args->new_rev), fs, txn_name, trail));
 
+  /* Re-file the changed-path records accumulated during the
+     transaction under the new revision's key, so `svn log' and
+     friends can find them by revision number.  */
+  SVN_ERR (svn_fs__changes_move (fs, txn_name,
+                                 svn_fs__changes_rev_key (args->new_rev,
+                                                          trail->pool),
+                                 trail));
+
   return SVN_NO_ERROR;
 }
 
@@ -1874,7 +2016,20 @@ svn_fs_commit_txn (const char **conflict_p,
         return err;
       else
         {
+          svn_error_t *stamp_err;
+
           *new_rev = commit_args.new_rev;
+
+          /* Note the new revision in the commit stamp file, for the
+             benefit of pollers watching the filesystem from outside
+             (see svn_fs_read_commit_stamp).  This is best-effort: the
+             Berkeley transaction above is already durable, and
+             failing the call over a stamp write would only trick the
+             caller into re-committing work that's committed.  */
+          stamp_err = svn_fs__stamp_commit (fs, *new_rev, pool);
+          if (stamp_err)
+            svn_error_clear_all (stamp_err);
+
           break;
         }
     }
@@ -1996,12 +2151,69 @@ svn_fs_dir_entries (apr_hash_t **table_p,
   args.root    = root;
   args.path    = path;
   SVN_ERR (svn_fs__retry_txn (root->fs, txn_body_dir_entries, &args, pool));
-  
+
   *table_p = table;
   return SVN_NO_ERROR;
 }
 
 
+struct dir_entries_iterate_args
+{
+  svn_fs_root_t *root;
+  const char *path;
+  svn_fs_dirent_receiver_t receiver;
+  void *receiver_baton;
+};
+
+
+static svn_error_t *
+txn_body_dir_entries_iterate (void *baton,
+                              trail_t *trail)
+{
+  struct dir_entries_iterate_args *args = baton;
+  parent_path_t *parent_path;
+
+  SVN_ERR (open_path (&parent_path, args->root, args->path, 0, trail));
+  return svn_fs__dag_dir_entries_iterate (parent_path->node,
+                                          args->receiver,
+                                          args->receiver_baton,
+                                          trail);
+}
+
+
+svn_error_t *
+svn_fs_dir_entries_iterate (svn_fs_root_t *root,
+                            const char *path,
+                            svn_fs_dirent_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *pool)
+{
+  struct dir_entries_iterate_args args;
+
+  args.root           = root;
+  args.path           = path;
+  args.receiver       = receiver;
+  args.receiver_baton = receiver_baton;
+  return svn_fs__retry_txn (root->fs, txn_body_dir_entries_iterate,
+                            &args, pool);
+}
+
+
+
+/* Record in FS's `changes' table that ROOT's transaction changed
+   PATH, with a change of kind KIND --- one of the SVN_FS__CHANGE_*
+   strings --- as part of TRAIL.  The record is filed under the
+   transaction's id; txn_body_commit re-files the accumulated records
+   under the new revision's key when the transaction commits.  */
+static svn_error_t *
+add_change (svn_fs_root_t *root,
+            const char *path,
+            const char *kind,
+            trail_t *trail)
+{
+  return svn_fs__changes_add (root->fs, root->txn, path, kind, trail);
+}
+
 
 struct make_dir_args
 {
@@ -2031,10 +2243,13 @@ txn_body_make_dir (void *baton,
   /* Create the subdirectory.  */
   SVN_ERR (make_path_mutable (root, parent_path->parent, path, trail));
   SVN_ERR (svn_fs__dag_make_dir (&sub_dir,
-                                 parent_path->parent->node, 
+                                 parent_path->parent->node,
                                  parent_path->entry,
                                  trail));
 
+  /* Make a record of this modification in the changes table. */
+  SVN_ERR (add_change (root, path, SVN_FS__CHANGE_ADD, trail));
+
   return SVN_NO_ERROR;
 }
 
@@ -2101,6 +2316,9 @@ txn_body_delete (void *baton,
                                    trail));
     }
 
+  /* Make a record of this modification in the changes table. */
+  SVN_ERR (add_change (root, path, SVN_FS__CHANGE_DELETE, trail));
+
   return SVN_NO_ERROR;
 }
 
@@ -2194,6 +2412,9 @@ txn_body_copy (void *baton,
                                  svn_fs_revision_root_revision (from_root),
                                  from_path,
                                  trail));
+
+      /* Make a record of this modification in the changes table. */
+      SVN_ERR (add_change (to_root, to_path, SVN_FS__CHANGE_ADD, trail));
     }
   else
     {
@@ -2347,10 +2568,13 @@ txn_body_make_file (void *baton,
   /* Create the file.  */
   SVN_ERR (make_path_mutable (root, parent_path->parent, path, trail));
   SVN_ERR (svn_fs__dag_make_file (&child,
-                                  parent_path->parent->node, 
+                                  parent_path->parent->node,
                                   parent_path->entry,
                                   trail));
 
+  /* Make a record of this modification in the changes table. */
+  SVN_ERR (add_change (root, path, SVN_FS__CHANGE_ADD, trail));
+
   return SVN_NO_ERROR;
 }
 
@@ -2407,6 +2631,53 @@ svn_fs_file_length (apr_off_t *length_p,
 }
 
 
+struct file_checksum_args
+{
+  svn_fs_root_t *root;
+  const char *path;
+  unsigned char *digest;    /* OUT parameter */
+  svn_boolean_t known;      /* OUT parameter */
+};
+
+static svn_error_t *
+txn_body_file_checksum (void *baton,
+                        trail_t *trail)
+{
+  struct file_checksum_args *args = baton;
+  dag_node_t *file;
+
+  /* First create a dag_node_t from the root/path pair. */
+  SVN_ERR (get_dag (&file, args->root, args->path, trail));
+
+  /* Now fetch its checksum */
+  return svn_fs__dag_file_checksum (args->digest, &args->known,
+                                    file, trail);
+}
+
+svn_error_t *
+svn_fs_file_md5_checksum (unsigned char digest[],
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *pool)
+{
+  struct file_checksum_args args;
+
+  args.root = root;
+  args.path = path;
+  args.digest = digest;
+  SVN_ERR (svn_fs__retry_txn (root->fs, txn_body_file_checksum,
+                              &args, pool));
+
+  /* A file committed before checksums existed has none recorded;
+     hand back all zeros, which is not a valid MD5 digest, so the
+     caller can tell the difference. */
+  if (! args.known)
+    memset (digest, 0, MD5_DIGESTSIZE);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* --- Machinery for svn_fs_file_contents() ---  */
 
 
@@ -2572,11 +2843,15 @@ window_consumer (svn_txdelta_window_t *window, void *baton)
       svn_stringbuf_set (tb->target_string, "");
     }
 
-  /* Is the window NULL?  If so, we're done, and we need to tell the
-     dag subsystem that we're finished with our edits. */
+  /* Is the window NULL?  If so, we're done: close the target stream,
+     which records the checksum of the new contents in the rep, and
+     tell the dag subsystem that we're finished with our edits. */
   if (! window)
-    SVN_ERR (svn_fs__retry_txn (svn_fs_root_fs (tb->root),
-                                txn_body_finalize_edits, tb, tb->pool));
+    {
+      SVN_ERR (svn_stream_close (tb->target_stream));
+      SVN_ERR (svn_fs__retry_txn (svn_fs_root_fs (tb->root),
+                                  txn_body_finalize_edits, tb, tb->pool));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2624,6 +2899,8 @@ txn_body_apply_textdelta (void *baton, trail_t *trail)
                      &(tb->interpreter),
                      &(tb->interpreter_baton));
 
+  /* Make a record of this modification in the changes table. */
+  SVN_ERR (add_change (tb->root, tb->path, SVN_FS__CHANGE_REPLACE, trail));
 
   return SVN_NO_ERROR;
 
@@ -2723,6 +3000,57 @@ svn_fs_contents_changed (int *changed_p,
 }
 
 
+static svn_error_t *
+txn_body_things_changed (void *baton, trail_t *trail)
+{
+  struct things_changed_args *args = baton;
+  parent_path_t *parent_path_1, *parent_path_2;
+
+  SVN_ERR (open_path (&parent_path_1, args->root1, args->path1, 0, trail));
+  SVN_ERR (open_path (&parent_path_2, args->root2, args->path2, 0, trail));
+
+  SVN_ERR (svn_fs__things_different (args->changed_p,
+                                     args->contents_changed_p,
+                                     parent_path_1->node,
+                                     parent_path_2->node,
+                                     trail));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_things_changed (int *props_changed_p,
+                       int *contents_changed_p,
+                       svn_fs_root_t *root1,
+                       const char *path1,
+                       svn_fs_root_t *root2,
+                       const char *path2,
+                       apr_pool_t *pool)
+{
+  struct things_changed_args args;
+
+  /* Check that roots are in the same fs. */
+  if ((svn_fs_root_fs (root1)) != (svn_fs_root_fs (root2)))
+    return svn_error_create
+      (SVN_ERR_FS_GENERAL, 0, NULL, pool,
+       "Asking things changed in two different filesystems.");
+
+  args.root1              = root1;
+  args.root2              = root2;
+  args.path1              = path1;
+  args.path2              = path2;
+  args.changed_p          = props_changed_p;
+  args.contents_changed_p = contents_changed_p;
+  args.pool               = pool;
+
+  SVN_ERR (svn_fs__retry_txn (root1->fs, txn_body_things_changed,
+                              &args, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Public interface to computing file text deltas.  */
 
@@ -2756,6 +3084,83 @@ svn_fs_get_file_delta_stream (svn_txdelta_stream_t **stream_p,
 }
 
 
+struct stored_delta_args
+{
+  apr_array_header_t **keys;
+  svn_fs_root_t *source_root;
+  const char *source_path;
+  svn_fs_root_t *target_root;
+  const char *target_path;
+  apr_pool_t *pool;
+};
+
+
+static svn_error_t *
+txn_body_stored_delta_keys (void *baton, trail_t *trail)
+{
+  struct stored_delta_args *args = baton;
+  parent_path_t *source_parent_path, *target_parent_path;
+
+  SVN_ERR (open_path (&source_parent_path, args->source_root,
+                      args->source_path, 0, trail));
+  SVN_ERR (open_path (&target_parent_path, args->target_root,
+                      args->target_path, 0, trail));
+
+  return svn_fs__dag_stored_delta_keys (args->keys,
+                                        source_parent_path->node,
+                                        target_parent_path->node,
+                                        args->pool, trail);
+}
+
+
+/* Note:  like svn_fs_get_file_delta_stream, this function may call
+   back into public FS API interfaces, because outside of the rep-key
+   lookup it does not use trails.  */
+svn_error_t *
+svn_fs_send_file_delta (svn_txdelta_window_handler_t handler,
+                        void *handler_baton,
+                        svn_fs_root_t *source_root,
+                        const char *source_path,
+                        svn_fs_root_t *target_root,
+                        const char *target_path,
+                        apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *delta_stream;
+  apr_array_header_t *keys = NULL;
+
+  /* If the filesystem already stores TARGET's contents as a delta
+     made directly against SOURCE's contents, serve the stored svndiff
+     windows straight out of storage instead of recomputing them from
+     the two fulltexts.  */
+  if (source_root && source_path
+      && (svn_fs_root_fs (source_root) == svn_fs_root_fs (target_root)))
+    {
+      struct stored_delta_args args;
+
+      args.keys        = &keys;
+      args.source_root = source_root;
+      args.source_path = source_path;
+      args.target_root = target_root;
+      args.target_path = target_path;
+      args.pool        = pool;
+
+      SVN_ERR (svn_fs__retry_txn (target_root->fs, txn_body_stored_delta_keys,
+                                  &args, pool));
+    }
+
+  if (keys)
+    return svn_fs__send_stored_delta (target_root->fs, keys,
+                                      handler, handler_baton, pool);
+
+  /* No stored delta; compute one.  */
+  SVN_ERR (svn_fs_get_file_delta_stream (&delta_stream,
+                                         source_root, source_path,
+                                         target_root, target_path, pool));
+  return svn_txdelta_send_txstream (delta_stream, handler, handler_baton,
+                                    pool);
+}
+
+
 
 
 /* Determining the revisions in which a given path was changed. */
@@ -2832,6 +3237,45 @@ txn_body_revisions_changed (void *baton, trail_t *trail)
   return SVN_NO_ERROR;
 }
 
+/* Baton for batch_body_revisions_changed. */
+struct revisions_changed_batch_args
+{
+  struct revisions_changed_args *args;
+  svn_fs_root_t *root;
+  const apr_array_header_t *paths;
+};
+
+/* A batch body for svn_fs_read_batch: look up the node-id for each of
+   the paths, then walk their histories, all inside one Berkeley DB
+   transaction.  Everything here just reads, and rebuilds its in-memory
+   results from scratch, so re-running it after a deadlock is safe. */
+static svn_error_t *
+batch_body_revisions_changed (void *baton, apr_pool_t *pool)
+{
+  struct revisions_changed_batch_args *bargs = baton;
+  struct revisions_changed_args *args = bargs->args;
+  int i;
+  svn_fs_id_t *tmp_id;
+  const char *this_path;
+
+  args->ids = apr_array_make (pool, 1, sizeof (svn_fs_id_t *));
+
+  /* Get the node-id for each PATH under ROOT. */
+  for (i = 0; i < bargs->paths->nelts; i++)
+    {
+      this_path = APR_ARRAY_IDX(bargs->paths, i, const char *);
+      SVN_ERR (svn_fs_node_id (&tmp_id, bargs->root, this_path, pool));
+      *((svn_fs_id_t **) apr_array_push (args->ids))
+        = svn_fs__id_copy (tmp_id, pool);
+    }
+
+  /* Call the real function; this joins the batch's trail. */
+  SVN_ERR (svn_fs__retry_txn (args->fs, txn_body_revisions_changed,
+                              args, pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_revisions_changed (apr_array_header_t **revs,
                           svn_fs_root_t *root,
@@ -2839,29 +3283,24 @@ svn_fs_revisions_changed (apr_array_header_t **revs,
                           apr_pool_t *pool)
 {
   struct revisions_changed_args args;
+  struct revisions_changed_batch_args bargs;
   svn_fs_t *fs = svn_fs_root_fs (root);
-  int i;
-  svn_fs_id_t *tmp_id;
-  const char *this_path;
   apr_pool_t *subpool = svn_pool_create (pool);
 
-  /* Populate the baton. */
+  svn_pool_tag (subpool, "fs:revisions-changed");
+
+  /* Populate the batons. */
   args.revs = revs;
   args.fs = fs;
   args.pool = pool;
-  args.ids = apr_array_make (subpool, 1, sizeof (svn_fs_id_t *));
-
-  /* Get the node-id for each PATH under ROOT. */
-  for (i = 0; i < paths->nelts; i++)
-    {
-      this_path = APR_ARRAY_IDX(paths, i, const char *);
-      SVN_ERR (svn_fs_node_id (&tmp_id, root, this_path, subpool));
-      *((svn_fs_id_t **) apr_array_push (args.ids)) 
-        = svn_fs__id_copy (tmp_id, subpool);
-    }
-
-  /* Call the real function under the umbrella of a trail. */
-  SVN_ERR (svn_fs__retry_txn (fs, txn_body_revisions_changed, &args, subpool));
+  bargs.args = &args;
+  bargs.root = root;
+  bargs.paths = paths;
+
+  /* Do all the lookups in a single read batch, so each path doesn't
+     pay for a Berkeley DB transaction of its own. */
+  SVN_ERR (svn_fs_read_batch (fs, batch_body_revisions_changed, &bargs,
+                              subpool));
 
   /* Destroy all memory used, except the revisions array */
   svn_pool_destroy(subpool);
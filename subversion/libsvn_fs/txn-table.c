@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "db.h"
+#include "svn_pools.h"
 #include "fs.h"
 #include "err.h"
 #include "key-gen.h"
@@ -60,8 +61,121 @@ svn_fs__open_transactions_table (DB **transactions_p,
 }
 
 
-static int
-is_valid_transaction (skel_t *skel)
+/* Caching transaction records.  */
+
+/* The number of transaction records we cache per filesystem.  A
+   process almost always drives a single transaction at a time ---
+   the point of the cache is that a big commit reads its own record
+   once instead of once per editor call --- but leave a little room
+   for overlap.  */
+#define TXN_CACHE_SIZE 4
+
+
+/* One slot in the transaction record cache.  */
+typedef struct txn_cache_entry_t
+{
+  /* The name of the transaction this slot describes, allocated in
+     POOL, or null if the slot is empty.  */
+  const char *name;
+
+  /* The transaction's parsed TRANSACTION skel, allocated in POOL.  */
+  skel_t *txn_skel;
+
+  /* The slot's private subpool, cleared when the slot is re-used,
+     or null until the slot is first filled.  */
+  apr_pool_t *pool;
+} txn_cache_entry_t;
+
+
+/* A cache of recently read or written transaction records.
+
+   ### todo: a record cached here could go stale if another process
+   modifies the transaction behind our back.  We already depend on a
+   single process driving any given transaction, so this doesn't make
+   matters worse, but it's one more thing to revisit if that ever
+   changes.  */
+struct svn_fs__txn_cache_t
+{
+  /* The pool the cache and its slot subpools live in; a subpool of
+     the filesystem's pool.  */
+  apr_pool_t *pool;
+
+  txn_cache_entry_t entries[TXN_CACHE_SIZE];
+};
+
+
+/* Return the cache slot SVN_TXN maps to in FS's transaction cache,
+   creating the cache first if it doesn't exist yet.  */
+static txn_cache_entry_t *
+get_txn_cache_slot (svn_fs_t *fs, const char *svn_txn)
+{
+  const char *p;
+  unsigned int hash = 0;
+
+  if (! fs->txn_cache)
+    {
+      apr_pool_t *pool = svn_pool_create (fs->pool);
+
+      fs->txn_cache = apr_pcalloc (pool, sizeof (*fs->txn_cache));
+      fs->txn_cache->pool = pool;
+    }
+
+  for (p = svn_txn; *p; p++)
+    hash = hash * 33 + (unsigned char) *p;
+
+  return &fs->txn_cache->entries[hash % TXN_CACHE_SIZE];
+}
+
+
+/* Record TXN_SKEL as the parsed transaction record of SVN_TXN in FS's
+   cache, copying both into the slot's subpool.  */
+static void
+cache_txn (svn_fs_t *fs, const char *svn_txn, skel_t *txn_skel)
+{
+  txn_cache_entry_t *entry = get_txn_cache_slot (fs, svn_txn);
+
+  if (! entry->pool)
+    entry->pool = svn_pool_create (fs->txn_cache->pool);
+  else
+    svn_pool_clear (entry->pool);
+
+  entry->name = apr_pstrdup (entry->pool, svn_txn);
+  entry->txn_skel = svn_fs__copy_skel (txn_skel, entry->pool);
+}
+
+
+/* Forget any cached record of SVN_TXN in FS.  */
+static void
+evict_txn (svn_fs_t *fs, const char *svn_txn)
+{
+  txn_cache_entry_t *entry;
+
+  if (! fs->txn_cache)
+    return;
+
+  entry = get_txn_cache_slot (fs, svn_txn);
+  if (entry->name && strcmp (entry->name, svn_txn) == 0)
+    {
+      svn_pool_clear (entry->pool);
+      entry->name = 0;
+      entry->txn_skel = 0;
+    }
+}
+
+
+void
+svn_fs__clear_txn_cache (svn_fs_t *fs)
+{
+  if (fs->txn_cache)
+    {
+      svn_pool_destroy (fs->txn_cache->pool);
+      fs->txn_cache = 0;
+    }
+}
+
+
+int
+svn_fs__is_valid_transaction (skel_t *skel)
 {
   int len = svn_fs__list_length (skel);
 
@@ -111,17 +225,21 @@ put_txn (svn_fs_t *fs,
   svn_fs__prepend (svn_fs__str_atom ("transaction", pool), txn_skel);
 
   /* Sanity check.  */
-  if (! is_valid_transaction (txn_skel))
+  if (! svn_fs__is_valid_transaction (txn_skel))
     abort ();
 
   /* Only in the context of this function do we know that the DB call
      will not attempt to modify svn_txn, so the cast belongs here.  */
   svn_fs__str_to_dbt (&key, (char *) svn_txn);
   svn_fs__skel_to_dbt (&value, txn_skel, pool);
+  SVN_FS__COUNT (fs, db_puts);
   SVN_ERR (DB_WRAP (fs, "storing transaction record",
                     fs->transactions->put (fs->transactions, trail->db_txn,
                                            &key, &value, 0)));
 
+  /* The record we just wrote is what the next read should see.  */
+  cache_txn (fs, svn_txn, txn_skel);
+
   return SVN_NO_ERROR;
 }
 
@@ -141,6 +259,7 @@ allocate_txn_id (char **id_p,
 
   /* Get the current value associated with the `next-id' key in the
      transactions table.  */
+  SVN_FS__COUNT (fs, db_gets);
   SVN_ERR (DB_WRAP (fs, "allocating new transaction ID (getting `next-id')",
                     fs->transactions->get (fs->transactions, trail->db_txn,
                                            &key,
@@ -166,6 +285,7 @@ allocate_txn_id (char **id_p,
     int buf_len;
 
     buf_len = svn_fs__putsize (buf, sizeof (buf), next_id + 1);
+    SVN_FS__COUNT (fs, db_puts);
     SVN_ERR (DB_WRAP (fs, "allocating new transaction ID (setting `next-id')",
                       fs->transactions->put (fs->transactions, trail->db_txn,
                                              &key,
@@ -204,10 +324,13 @@ svn_fs__delete_txn (svn_fs_t *fs,
   DBT key;
 
   svn_fs__str_to_dbt (&key, (char *) svn_txn);
+  SVN_FS__COUNT (fs, db_puts);
   SVN_ERR (DB_WRAP (fs, "deleting entry from `transactions' table",
                     fs->transactions->del (fs->transactions,
                                            trail->db_txn, &key, 0)));
 
+  evict_txn (fs, svn_txn);
+
   return SVN_NO_ERROR;
 }
 
@@ -222,8 +345,22 @@ svn_fs__get_txn (skel_t **txn_skel,
   int db_err;
   skel_t *transaction;
 
+  /* Consult the cache first.  Hand back a copy, since callers (and
+     put_txn) rearrange the skels they're given.  */
+  if (fs->txn_cache)
+    {
+      txn_cache_entry_t *entry = get_txn_cache_slot (fs, svn_txn);
+
+      if (entry->name && strcmp (entry->name, svn_txn) == 0)
+        {
+          *txn_skel = svn_fs__copy_skel (entry->txn_skel, trail->pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
   /* Only in the context of this function do we know that the DB call
      will not attempt to modify svn_txn, so the cast belongs here.  */
+  SVN_FS__COUNT (fs, db_gets);
   db_err = fs->transactions->get (fs->transactions, trail->db_txn,
                                   svn_fs__str_to_dbt (&key, (char *) svn_txn),
                                   svn_fs__result_dbt (&value),
@@ -236,9 +373,12 @@ svn_fs__get_txn (skel_t **txn_skel,
 
   transaction = svn_fs__parse_skel (value.data, value.size, trail->pool);
   if (! transaction
-      || ! is_valid_transaction (transaction))
+      || (! fs->trusted_reads
+          && ! svn_fs__is_valid_transaction (transaction)))
     return svn_fs__err_corrupt_txn (fs, svn_txn);
 
+  cache_txn (fs, svn_txn, transaction);
+
   *txn_skel = transaction;
   return SVN_NO_ERROR;
 }
@@ -298,6 +438,22 @@ svn_fs__get_txn_ids (svn_fs_id_t **root_id_p,
 }
 
 
+svn_error_t *
+svn_fs__get_txn_prop (svn_string_t **value_p,
+                      svn_fs_t *fs,
+                      const char *svn_txn,
+                      const char *propname,
+                      trail_t *trail)
+{
+  skel_t *txn_skel;
+
+  SVN_ERR (svn_fs__get_txn (&txn_skel, fs, svn_txn, trail));
+  return svn_fs__get_prop (value_p, fs,
+                           get_proplist_from_txn_skel (txn_skel),
+                           propname, trail->pool);
+}
+
+
 svn_error_t *
 svn_fs__set_txn_root (svn_fs_t *fs,
                       const char *svn_txn,
@@ -357,6 +513,7 @@ svn_error_t *svn_fs__get_txn_list (char ***names_p,
   names = apr_pcalloc (pool, names_size * sizeof (*names));
 
   /* Create a database cursor to list the transaction names. */
+  SVN_FS__COUNT (fs, db_cursor_ops);
   SVN_ERR (DB_WRAP (fs, "reading transaction list (opening cursor)",
                     fs->transactions->cursor (fs->transactions, trail->db_txn,
                                               &cursor, 0)));
@@ -372,6 +529,7 @@ svn_error_t *svn_fs__get_txn_list (char ***names_p,
                                svn_fs__nodata_dbt (&value),
                                DB_NEXT))
     {
+      SVN_FS__COUNT (fs, db_cursor_ops);
       svn_fs__track_dbt (&key, trail->pool);
 
       /* Ignore the "next-id" key. */
@@ -428,17 +586,8 @@ txn_body_txn_prop (void *baton,
 {
   struct txn_prop_args *args = baton;
 
-  skel_t *skel;
-  skel_t *proplist;
-  
-  SVN_ERR (svn_fs__get_txn (&skel, args->fs, args->id, trail));
-  proplist = get_proplist_from_txn_skel (skel);
-
-  /* Return the results of the generic property getting function. */
-  return svn_fs__get_prop (args->value_p,
-                           proplist,
-                           args->propname,
-                           trail->pool);
+  return svn_fs__get_txn_prop (args->value_p, args->fs, args->id,
+                               args->propname, trail);
 }
 
 
@@ -485,6 +634,7 @@ txn_body_txn_proplist (void *baton, trail_t *trail)
 
   /* Return the results of the generic property hash getting function. */
   return svn_fs__make_prop_hash (args->table_p,
+                                 args->fs,
                                  proplist,
                                  trail->pool);
 }
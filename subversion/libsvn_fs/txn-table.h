@@ -79,6 +79,17 @@ svn_error_t *svn_fs__get_txn_ids (svn_fs_id_t **root_id_p,
                                   trail_t *trail);
 
 
+/* Set *VALUE_P to the value of the property PROPNAME on the
+   Subversion transaction SVN_TXN in FS, as part of TRAIL, or to null
+   if the transaction has no such property.  Allocate *VALUE_P in
+   TRAIL->pool.  */
+svn_error_t *svn_fs__get_txn_prop (svn_string_t **value_p,
+                                   svn_fs_t *fs,
+                                   const char *svn_txn,
+                                   const char *propname,
+                                   trail_t *trail);
+
+
 /* Set the root directory of the Subversion transaction SVN_TXN in FS
    to ROOT_ID, as part of TRAIL.  Do any necessary temporary
    allocation in TRAIL->pool.  */
@@ -97,6 +108,16 @@ svn_fs__set_txn_base (svn_fs_t *fs,
                       trail_t *trail);
 
 
+/* Return non-zero iff SKEL is a well-formed TRANSACTION skel.  */
+int svn_fs__is_valid_transaction (skel_t *skel);
+
+
+/* Discard FS's in-memory cache of transaction records.  Called when
+   a trail aborts, since records read or written within the aborted
+   transaction may never have been committed.  */
+void svn_fs__clear_txn_cache (svn_fs_t *fs);
+
+
 /* Set *NAMES_P to a null-terminated array of strings, giving the
    names of all currently active transactions in FS, as part of TRAIL.
    Allocate the array and the names in TRAIL->pool.  */
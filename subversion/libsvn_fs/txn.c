@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "apr_strings.h"
+#include "apr_hash.h"
 #include "apr_tables.h"
 #include "apr_pools.h"
 
@@ -32,6 +33,10 @@
 #include "trail.h"
 #include "rev-table.h"
 #include "txn-table.h"
+#include "nodes-table.h"
+#include "node-rev.h"
+#include "reps-strings.h"
+#include "changes-table.h"
 #include "tree.h"
 
 
@@ -222,6 +227,7 @@ txn_body_abort_txn (void *baton, trail_t *trail)
                                 txn_name, trail));
   SVN_ERR (svn_fs__dag_delete_if_mutable (txn->fs, root_id, trail));
   SVN_ERR (svn_fs__delete_txn (txn->fs, txn->id, trail));
+  SVN_ERR (svn_fs__changes_delete (txn->fs, txn->id, trail));
 
   return SVN_NO_ERROR;
 }
@@ -237,6 +243,233 @@ svn_fs_abort_txn (svn_fs_txn_t *txn)
 }
 
 
+
+/* Purging dead transactions. */
+
+/* Aborting deletes a transaction's mutable nodes one at a time,
+   interleaving btree lookups and deletions across the `nodes',
+   `representations', and `strings' tables.  That's fine for one
+   transaction, but a repository that has quietly accreted hundreds
+   of dead transactions deserves better: the purge below first
+   *collects* everything the doomed transactions own, then deletes
+   the node revisions in a single sequential pass over the `nodes'
+   table, so the cost is one table sweep no matter how many
+   transactions die.  */
+
+/* Add the mutable node revisions reachable from ID in FS to NODES
+   (a hash mapping unparsed ID strings to non-null), and the keys of
+   the mutable representations those nodes reference to REPS, as
+   part of TRAIL.  Everything is allocated in TRAIL->pool.  */
+static svn_error_t *
+collect_purged_nodes (apr_hash_t *nodes,
+                      apr_array_header_t *reps,
+                      svn_fs_t *fs,
+                      svn_fs_id_t *id,
+                      trail_t *trail)
+{
+  svn_boolean_t is_mutable;
+  dag_node_t *node;
+  skel_t *node_rev;
+
+  SVN_ERR (svn_fs__dag_get_node (&node, fs, id, trail));
+
+  /* An immutable node belongs to some revision; it and everything
+     below it stay.  */
+  SVN_ERR (svn_fs__dag_check_mutable (&is_mutable, node, trail));
+  if (! is_mutable)
+    return SVN_NO_ERROR;
+
+  /* Recurse on directories... */
+  if (svn_fs__dag_is_directory (node))
+    {
+      skel_t *entries, *entry;
+      SVN_ERR (svn_fs__dag_dir_entries_skel (&entries, node, trail));
+
+      for (entry = entries->children; entry; entry = entry->next)
+        {
+          skel_t *id_skel = entry->children->next;
+          svn_fs_id_t *this_id
+            = svn_fs_parse_id (id_skel->data, id_skel->len, trail->pool);
+
+          SVN_ERR (collect_purged_nodes (nodes, reps, fs, this_id, trail));
+        }
+    }
+
+  /* ... then record the node itself, and its rep keys.  Mutable
+     representations are never shared between nodes, so there's no
+     risk of collecting a key twice.  */
+  SVN_ERR (svn_fs__get_node_revision (&node_rev, fs, id, trail));
+
+  {
+    skel_t *rep_keys[3];
+    int i;
+
+    rep_keys[0] = SVN_FS__NR_PROP_KEY (node_rev);
+    rep_keys[1] = SVN_FS__NR_DATA_KEY (node_rev);
+    rep_keys[2] = SVN_FS__NR_EDIT_KEY (node_rev);
+
+    for (i = 0; i < 3; i++)
+      if (rep_keys[i] && rep_keys[i]->len != 0)
+        (*((const char **) apr_array_push (reps)))
+          = apr_pstrndup (trail->pool, rep_keys[i]->data, rep_keys[i]->len);
+  }
+
+  {
+    svn_stringbuf_t *unparsed_id = svn_fs_unparse_id (id, trail->pool);
+    apr_hash_set (nodes, unparsed_id->data, unparsed_id->len, (void *) 1);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Purge the transactions whose names appear in NAMES (an array of
+   `const char *' elements) from FS, as part of TRAIL.  */
+static svn_error_t *
+purge_txns (svn_fs_t *fs,
+            apr_array_header_t *names,
+            trail_t *trail)
+{
+  apr_hash_t *nodes = apr_hash_make (trail->pool);
+  apr_array_header_t *reps = apr_array_make (trail->pool, 0,
+                                             sizeof (const char *));
+  int i;
+
+  if (names->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Gather everything the doomed transactions own.  These are pure
+     reads; nothing is touched until the collection is complete.  */
+  for (i = 0; i < names->nelts; i++)
+    {
+      const char *name = ((const char **) names->elts)[i];
+      svn_fs_id_t *root_id, *base_root_id;
+
+      SVN_ERR (svn_fs__get_txn_ids (&root_id, &base_root_id,
+                                    fs, name, trail));
+      SVN_ERR (collect_purged_nodes (nodes, reps, fs, root_id, trail));
+    }
+
+  /* One pass over the `nodes' table deletes every collected node.  */
+  SVN_ERR (svn_fs__delete_nodes_sweep (NULL, fs, nodes, trail));
+
+  /* Deleting a mutable representation also deletes the strings it
+     references, so this leaves nothing for svn_fs_gc to find.  */
+  for (i = 0; i < reps->nelts; i++)
+    SVN_ERR (svn_fs__delete_rep_if_mutable (fs,
+                                            ((const char **) reps->elts)[i],
+                                            trail));
+
+  /* Finally, the transaction records themselves, and their changes.  */
+  for (i = 0; i < names->nelts; i++)
+    {
+      const char *name = ((const char **) names->elts)[i];
+
+      SVN_ERR (svn_fs__delete_txn (fs, name, trail));
+      SVN_ERR (svn_fs__changes_delete (fs, name, trail));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+struct purge_txns_args
+{
+  svn_fs_t *fs;
+  apr_array_header_t *names;
+};
+
+
+static svn_error_t *
+txn_body_purge_txns (void *baton, trail_t *trail)
+{
+  struct purge_txns_args *args = baton;
+
+  return purge_txns (args->fs, args->names, trail);
+}
+
+
+svn_error_t *
+svn_fs_purge_txns (apr_size_t *purged_count,
+                   svn_fs_t *fs,
+                   apr_array_header_t *names,
+                   apr_pool_t *pool)
+{
+  struct purge_txns_args args;
+
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  args.fs = fs;
+  args.names = names;
+  SVN_ERR (svn_fs__retry_txn (fs, txn_body_purge_txns, &args, pool));
+
+  if (purged_count)
+    *purged_count = names->nelts;
+  return SVN_NO_ERROR;
+}
+
+
+struct purge_old_txns_args
+{
+  svn_fs_t *fs;
+  apr_time_t cutoff;
+  apr_size_t purged;
+};
+
+
+static svn_error_t *
+txn_body_purge_old_txns (void *baton, trail_t *trail)
+{
+  struct purge_old_txns_args *args = baton;
+  apr_array_header_t *doomed = apr_array_make (trail->pool, 0,
+                                               sizeof (const char *));
+  char **names;
+  int i;
+
+  SVN_ERR (svn_fs__get_txn_list (&names, args->fs, trail->pool, trail));
+
+  for (i = 0; names[i]; i++)
+    {
+      svn_string_t *date;
+
+      SVN_ERR (svn_fs__get_txn_prop (&date, args->fs, names[i],
+                                     SVN_PROP_REVISION_DATE, trail));
+
+      /* Transactions get a creation datestamp at birth (see
+         svn_fs_begin_txn); one with no datestamp predates the
+         datestamps themselves, and can only be ancient.  */
+      if (date && svn_time_from_nts (date->data) >= args->cutoff)
+        continue;
+
+      (*((const char **) apr_array_push (doomed))) = names[i];
+    }
+
+  args->purged = doomed->nelts;
+  return purge_txns (args->fs, doomed, trail);
+}
+
+
+svn_error_t *
+svn_fs_purge_old_txns (apr_size_t *purged_count,
+                       svn_fs_t *fs,
+                       apr_time_t cutoff,
+                       apr_pool_t *pool)
+{
+  struct purge_old_txns_args args;
+
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  args.fs = fs;
+  args.cutoff = cutoff;
+  args.purged = 0;
+  SVN_ERR (svn_fs__retry_txn (fs, txn_body_purge_old_txns, &args, pool));
+
+  if (purged_count)
+    *purged_count = args.purged;
+  return SVN_NO_ERROR;
+}
+
+
 
 /*** Opening transactions. ***/
 
@@ -0,0 +1,619 @@
+/* verify.c : checking the integrity of a filesystem's tables
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "db.h"
+#include "apr_hash.h"
+#include "svn_pools.h"
+#include "svn_fs.h"
+#include "fs.h"
+#include "err.h"
+#include "dbt.h"
+#include "skel.h"
+#include "validate.h"
+#include "key-gen.h"
+#include "trail.h"
+#include "strings-table.h"
+#include "nodes-table.h"
+#include "rev-table.h"
+#include "txn-table.h"
+
+
+/* The kind of verification this file does --- walking each table
+   once with a cursor, validating every record's syntax, and checking
+   that cross-table references resolve --- is deliberately shallow: it
+   never undeltifies file contents, so its running time is
+   proportional to the raw size of the tables, not to the cost of
+   reconstructing every fulltext.  A tree walk with `svnlook' remains
+   the way to check the actual data.  */
+
+
+/* The state shared by the table scans: the set of keys each table
+   turned out to contain, for checking references between tables.
+
+   The hash values are all dummy non-null pointers; only membership
+   matters.  All keys are copied into the trail's pool.  */
+struct verify_info
+{
+  svn_fs_t *fs;
+
+  /* Keys present in the `strings' table.  */
+  apr_hash_t *string_keys;
+
+  /* Keys present in the `representations' table.  */
+  apr_hash_t *rep_keys;
+
+  /* Keys (unparsed node revision IDs) present in the `nodes' table.  */
+  apr_hash_t *node_keys;
+
+  /* Representation keys referenced from delta windows, mapped to the
+     key of some representation that referenced them.  Delta windows
+     can refer to representations we haven't scanned yet, so these
+     checks are deferred until the whole table has been read.  */
+  apr_hash_t *pending_rep_refs;
+};
+
+
+/* The `transactions' table's bookkeeping row, as in txn-table.c.  */
+static const char next_id_key[] = "next-id";
+
+
+
+/* Validating REPRESENTATION skels.  */
+
+
+/* Return non-zero iff SKEL is a well-formed CHECKSUM skel,
+   i.e. ("md5" BYTES).  */
+static int
+is_valid_checksum (skel_t *skel)
+{
+  return (svn_fs__list_length (skel) == 2
+          && svn_fs__matches_atom (skel->children, "md5")
+          && skel->children->next->is_atom);
+}
+
+
+/* Return non-zero iff SKEL is a well-formed WINDOW skel,
+   i.e. (DIFF SIZE CHECKSUM [REP-KEY [REP-OFFSET]]).  */
+static int
+is_valid_window (skel_t *skel)
+{
+  int len = svn_fs__list_length (skel);
+  skel_t *diff;
+
+  if (len < 3 || len > 5)
+    return 0;
+
+  /* DIFF ::= ("svndiff" STRING-KEY) */
+  diff = skel->children;
+  if (! (svn_fs__list_length (diff) == 2
+         && svn_fs__matches_atom (diff->children, "svndiff")
+         && diff->children->next->is_atom))
+    return 0;
+
+  if (! skel->children->next->is_atom
+      || ! is_valid_checksum (skel->children->next->next))
+    return 0;
+
+  if (len >= 4 && ! skel->children->next->next->next->is_atom)
+    return 0;
+  if (len == 5 && ! skel->children->next->next->next->next->is_atom)
+    return 0;
+
+  return 1;
+}
+
+
+/* Return non-zero iff SKEL is a well-formed REPRESENTATION skel.  */
+static int
+is_valid_representation (skel_t *skel)
+{
+  int len = svn_fs__list_length (skel);
+  skel_t *header;
+  skel_t *flag;
+
+  if (len < 2)
+    return 0;
+
+  /* The header is ("fulltext" FLAG ...) or ("delta" FLAG ...).  */
+  header = skel->children;
+  if (svn_fs__list_length (header) < 1)
+    return 0;
+  for (flag = header->children->next; flag; flag = flag->next)
+    if (! flag->is_atom)
+      return 0;
+
+  if (svn_fs__matches_atom (header->children, "fulltext"))
+    return (len == 2 && skel->children->next->is_atom);
+
+  if (svn_fs__matches_atom (header->children, "delta"))
+    {
+      skel_t *entry;
+
+      /* Each remaining element is (OFFSET WINDOW).  */
+      for (entry = skel->children->next; entry; entry = entry->next)
+        {
+          if (svn_fs__list_length (entry) != 2
+              || ! entry->children->is_atom
+              || ! is_valid_window (entry->children->next))
+            return 0;
+        }
+      return 1;
+    }
+
+  return 0;
+}
+
+
+
+/* The table scans.  */
+
+
+/* Close CURSOR, and complain about the scan of TABLE in FS if either
+   the scan's final error DB_ERR wasn't an ordinary end-of-table, or
+   closing the cursor itself fails.  */
+static svn_error_t *
+finish_scan (svn_fs_t *fs,
+             const char *table,
+             DBC *cursor,
+             int db_err)
+{
+  int db_c_err = cursor->c_close (cursor);
+
+  if (db_err != DB_NOTFOUND)
+    SVN_ERR (DB_WRAP (fs, apr_psprintf (fs->pool,
+                                        "verifying `%s' table", table),
+                      db_err));
+  SVN_ERR (DB_WRAP (fs, apr_psprintf (fs->pool,
+                                      "verifying `%s' table "
+                                      "(closing cursor)", table),
+                    db_c_err));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Walk the `strings' table of INFO->fs, collecting the set of keys
+   present, as part of TRAIL.  The contents themselves are opaque, so
+   there is nothing to validate; we only need to know which keys exist
+   so representation references can be checked.  */
+static svn_error_t *
+verify_strings (struct verify_info *info,
+                trail_t *trail)
+{
+  svn_fs_t *fs = info->fs;
+  apr_size_t const next_key_len = strlen (svn_fs__next_key_key);
+  apr_size_t const refs_len = strlen (SVN_FS__STRING_REFS_SUFFIX);
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+
+  SVN_ERR (DB_WRAP (fs, "verifying `strings' table (opening cursor)",
+                    fs->strings->cursor (fs->strings, trail->db_txn,
+                                         &cursor, 0)));
+
+  /* Strings are stored as sets of duplicate records, so visit each
+     key only once.  */
+  for (db_err = cursor->c_get (cursor,
+                               svn_fs__result_dbt (&key),
+                               svn_fs__nodata_dbt (&value),
+                               DB_FIRST);
+       db_err == 0;
+       db_err = cursor->c_get (cursor,
+                               svn_fs__result_dbt (&key),
+                               svn_fs__nodata_dbt (&value),
+                               DB_NEXT_NODUP))
+    {
+      svn_fs__track_dbt (&key, trail->pool);
+
+      if (key.size == next_key_len
+          && 0 == memcmp (key.data, svn_fs__next_key_key, next_key_len))
+        continue;
+
+      /* A record under "KEY-refs" is a string's reference count, not
+         a string.  The string itself sorts before its count record,
+         so it must already have been seen.  */
+      if (key.size > refs_len
+          && 0 == memcmp ((char *) key.data + key.size - refs_len,
+                          SVN_FS__STRING_REFS_SUFFIX, refs_len))
+        {
+          if (! apr_hash_get (info->string_keys,
+                              key.data, key.size - refs_len))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+               "reference count `%.*s' counts a non-existent string "
+               "in filesystem `%s'",
+               (int) key.size, (const char *) key.data, fs->path);
+          continue;
+        }
+
+      apr_hash_set (info->string_keys,
+                    apr_pstrndup (trail->pool, key.data, key.size),
+                    key.size, (void *) 1);
+    }
+
+  return finish_scan (fs, "strings", cursor, db_err);
+}
+
+
+/* Walk the `representations' table of INFO->fs as part of TRAIL,
+   checking that every record parses as a well-formed REPRESENTATION
+   skel and that every string it references exists.  References to
+   other representations are recorded in INFO->pending_rep_refs for
+   checking once the whole table has been seen.  */
+static svn_error_t *
+verify_reps (struct verify_info *info,
+             trail_t *trail)
+{
+  svn_fs_t *fs = info->fs;
+  apr_size_t const next_key_len = strlen (svn_fs__next_key_key);
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_ERR (DB_WRAP (fs, "verifying `representations' table (opening cursor)",
+                    fs->representations->cursor (fs->representations,
+                                                 trail->db_txn,
+                                                 &cursor, 0)));
+
+  while (1)
+    {
+      const char *key_str;
+      skel_t *rep;
+
+      svn_pool_clear (subpool);
+      do
+        db_err = cursor->c_get (cursor,
+                                svn_fs__result_dbt (&key),
+                                svn_fs__result_dbt_reuse (&value, trail),
+                                flags);
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+
+      if (key.size == next_key_len
+          && 0 == memcmp (key.data, svn_fs__next_key_key, next_key_len))
+        continue;
+
+      key_str = apr_pstrndup (trail->pool, key.data, key.size);
+      apr_hash_set (info->rep_keys, key_str, key.size, (void *) 1);
+
+      rep = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! rep || ! is_valid_representation (rep))
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+           "malformed representation `%s' in filesystem `%s'",
+           key_str, fs->path);
+
+      if (svn_fs__matches_atom (rep->children->children, "fulltext"))
+        {
+          skel_t *str_key = rep->children->next;
+
+          if (! apr_hash_get (info->string_keys, str_key->data, str_key->len))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+               "representation `%s' references non-existent string `%.*s'",
+               key_str, (int) str_key->len, str_key->data);
+        }
+      else  /* delta */
+        {
+          skel_t *entry;
+
+          for (entry = rep->children->next; entry; entry = entry->next)
+            {
+              skel_t *window = entry->children->next;
+              skel_t *str_key = window->children->children->next;
+              skel_t *rep_ref = window->children->next->next->next;
+
+              if (! apr_hash_get (info->string_keys,
+                                  str_key->data, str_key->len))
+                return svn_error_createf
+                  (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+                   "representation `%s' references non-existent "
+                   "string `%.*s'",
+                   key_str, (int) str_key->len, str_key->data);
+
+              if (rep_ref)
+                apr_hash_set (info->pending_rep_refs,
+                              apr_pstrndup (trail->pool,
+                                            rep_ref->data, rep_ref->len),
+                              rep_ref->len, key_str);
+            }
+        }
+    }
+
+  svn_pool_destroy (subpool);
+  return finish_scan (fs, "representations", cursor, db_err);
+}
+
+
+/* Check the representation references deferred by verify_reps,
+   reporting against INFO->fs; use TRAIL->pool for error messages.  */
+static svn_error_t *
+verify_pending_rep_refs (struct verify_info *info,
+                         trail_t *trail)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first (trail->pool, info->pending_rep_refs);
+       hi;
+       hi = apr_hash_next (hi))
+    {
+      const void *ref;
+      apr_ssize_t ref_len;
+      void *referrer;
+
+      apr_hash_this (hi, &ref, &ref_len, &referrer);
+      if (! apr_hash_get (info->rep_keys, ref, ref_len))
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+           "representation `%s' references non-existent representation `%s'",
+           (const char *) referrer, (const char *) ref);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Walk the `nodes' table of INFO->fs as part of TRAIL, checking that
+   every key is a syntactically valid node revision ID, that every
+   record parses as a well-formed NODE-REVISION skel, and that the
+   representations it references exist.  */
+static svn_error_t *
+verify_nodes (struct verify_info *info,
+              trail_t *trail)
+{
+  svn_fs_t *fs = info->fs;
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_ERR (DB_WRAP (fs, "verifying `nodes' table (opening cursor)",
+                    fs->nodes->cursor (fs->nodes, trail->db_txn,
+                                       &cursor, 0)));
+
+  while (1)
+    {
+      const char *key_str;
+      int components;
+      skel_t *node_rev;
+      skel_t *rep_key;
+
+      svn_pool_clear (subpool);
+      do
+        db_err = cursor->c_get (cursor,
+                                svn_fs__result_dbt (&key),
+                                svn_fs__result_dbt_reuse (&value, trail),
+                                flags);
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+
+      key_str = apr_pstrndup (trail->pool, key.data, key.size);
+
+      /* Node revision IDs have an even number of components.  */
+      components = svn_fs__count_id_components (key.data, key.size);
+      if (components == 0 || components % 2 == 1)
+        return svn_fs__err_corrupt_nodes_key (fs);
+
+      apr_hash_set (info->node_keys, key_str, key.size, (void *) 1);
+
+      node_rev = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! node_rev || ! svn_fs__is_valid_node_revision (node_rev))
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+           "malformed node revision `%s' in filesystem `%s'",
+           key_str, fs->path);
+
+      /* Check the PROP-KEY, DATA-KEY, and EDIT-DATA-KEY references.
+         An empty key means the node has no such representation
+         yet.  */
+      for (rep_key = node_rev->children->next; rep_key;
+           rep_key = rep_key->next)
+        {
+          if (rep_key->len == 0)
+            continue;
+
+          if (! apr_hash_get (info->rep_keys, rep_key->data, rep_key->len))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+               "node revision `%s' references non-existent "
+               "representation `%.*s'",
+               key_str, (int) rep_key->len, rep_key->data);
+        }
+    }
+
+  svn_pool_destroy (subpool);
+  return finish_scan (fs, "nodes", cursor, db_err);
+}
+
+
+/* Walk the `revisions' table of INFO->fs as part of TRAIL, checking
+   that every record parses as a well-formed REVISION skel and that
+   its root node exists in the `nodes' table.  */
+static svn_error_t *
+verify_revisions (struct verify_info *info,
+                  trail_t *trail)
+{
+  svn_fs_t *fs = info->fs;
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  DBC *cursor;
+  DBT key, value;
+  db_recno_t recno;
+  int db_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_ERR (DB_WRAP (fs, "verifying `revisions' table (opening cursor)",
+                    fs->revisions->cursor (fs->revisions, trail->db_txn,
+                                           &cursor, 0)));
+
+  while (1)
+    {
+      skel_t *revision;
+      skel_t *id_skel;
+
+      svn_pool_clear (subpool);
+      do
+        db_err = cursor->c_get (cursor,
+                                svn_fs__recno_dbt (&key, &recno),
+                                svn_fs__result_dbt_reuse (&value, trail),
+                                flags);
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      revision = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! revision || ! svn_fs__is_valid_filesystem_revision (revision))
+        return svn_fs__err_corrupt_fs_revision (fs, recno - 1);
+
+      id_skel = revision->children->next;
+      if (! apr_hash_get (info->node_keys, id_skel->data, id_skel->len))
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+           "revision %lu references non-existent root node `%.*s'",
+           (unsigned long) (recno - 1), (int) id_skel->len, id_skel->data);
+    }
+
+  svn_pool_destroy (subpool);
+  return finish_scan (fs, "revisions", cursor, db_err);
+}
+
+
+/* Walk the `transactions' table of INFO->fs as part of TRAIL,
+   checking that every record parses as a well-formed TRANSACTION skel
+   and that its root and base root nodes exist.  */
+static svn_error_t *
+verify_transactions (struct verify_info *info,
+                     trail_t *trail)
+{
+  svn_fs_t *fs = info->fs;
+  apr_size_t const next_id_key_len = strlen (next_id_key);
+  apr_pool_t *subpool = svn_pool_create (trail->pool);
+  DBC *cursor;
+  DBT key, value;
+  int db_err;
+  u_int32_t flags = DB_FIRST;
+
+  SVN_ERR (DB_WRAP (fs, "verifying `transactions' table (opening cursor)",
+                    fs->transactions->cursor (fs->transactions, trail->db_txn,
+                                              &cursor, 0)));
+
+  while (1)
+    {
+      const char *key_str;
+      skel_t *transaction;
+      skel_t *id_skel;
+
+      svn_pool_clear (subpool);
+      do
+        db_err = cursor->c_get (cursor,
+                                svn_fs__result_dbt (&key),
+                                svn_fs__result_dbt_reuse (&value, trail),
+                                flags);
+      while (svn_fs__retry_dbt_reuse (&value, trail, db_err));
+      if (db_err)
+        break;
+      flags = DB_NEXT;
+
+      svn_fs__track_dbt (&key, subpool);
+
+      if (key.size == next_id_key_len
+          && 0 == memcmp (key.data, next_id_key, next_id_key_len))
+        continue;
+
+      key_str = apr_pstrndup (trail->pool, key.data, key.size);
+
+      transaction = svn_fs__parse_skel (value.data, value.size, subpool);
+      if (! transaction || ! svn_fs__is_valid_transaction (transaction))
+        return svn_fs__err_corrupt_txn (fs, key_str);
+
+      /* Check the ROOT-ID and BASE-ROOT-ID references.  */
+      for (id_skel = transaction->children->next;
+           id_skel->next;
+           id_skel = id_skel->next)
+        {
+          if (! apr_hash_get (info->node_keys, id_skel->data, id_skel->len))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, 0, NULL, trail->pool,
+               "transaction `%s' references non-existent root node `%.*s'",
+               key_str, (int) id_skel->len, id_skel->data);
+        }
+    }
+
+  svn_pool_destroy (subpool);
+  return finish_scan (fs, "transactions", cursor, db_err);
+}
+
+
+
+/* The public entry point.  */
+
+
+static svn_error_t *
+txn_body_verify (void *baton,
+                 trail_t *trail)
+{
+  struct verify_info info;
+
+  info.fs = baton;
+  info.string_keys = apr_hash_make (trail->pool);
+  info.rep_keys = apr_hash_make (trail->pool);
+  info.node_keys = apr_hash_make (trail->pool);
+  info.pending_rep_refs = apr_hash_make (trail->pool);
+
+  /* Scan the tables bottom-up, so each table's references can be
+     checked against the key sets gathered from the tables below
+     it.  */
+  SVN_ERR (verify_strings (&info, trail));
+  SVN_ERR (verify_reps (&info, trail));
+  SVN_ERR (verify_pending_rep_refs (&info, trail));
+  SVN_ERR (verify_nodes (&info, trail));
+  SVN_ERR (verify_revisions (&info, trail));
+  SVN_ERR (verify_transactions (&info, trail));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_verify (svn_fs_t *fs,
+               apr_pool_t *pool)
+{
+  SVN_ERR (svn_fs__check_fs (fs));
+
+  return svn_fs__retry_txn (fs, txn_body_verify, fs, pool);
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -38,23 +38,28 @@
    ### by more than one loader. However, we can ignore that until we
    ### actually run into a conflict within the scheme portion of a URL. */
 
-/* ### if we want to lazy-load the RA libraries, then we will need to
-   ### know the RA libraries' URL schemes *before* loading them. the
-   ### current implementation just loads everything, and asks the libraries
-   ### what they handle. */
-
-
 
 static const struct ra_lib_defn {
   /* the name of this RA library (e.g. "dav" or "local") */
   const char *ra_name;
 
+  /* the URL schemes the library handles, as a space-separated list.
+     Listed here, rather than asked of the library, so that we can
+     tell which library a URL wants *without* loading any of them:
+     loading ra_dav drags in all of neon, which is real startup time
+     for a command that never touches a URL.  A library may register
+     fewer schemes than it claims here (ra_dav only registers `https'
+     when built against SSL); URLs in the missing scheme then simply
+     come up unrecognized. */
+  const char *schemes;
+
   /* the initialization function if linked in; otherwise, NULL */
   svn_ra_init_func_t initfunc;
 
 } ra_libraries[] = {
   {
     "dav",
+    "http https",
 #ifdef SVN_LIBSVN_CLIENT_LINKS_RA_DAV
     svn_ra_dav_init
 #endif
@@ -62,6 +67,7 @@ static const struct ra_lib_defn {
 
   {
     "local",
+    "file",
 #ifdef SVN_LIBSVN_CLIENT_LINKS_RA_LOCAL
     svn_ra_local_init
 #endif
@@ -73,6 +79,23 @@ static const struct ra_lib_defn {
   { NULL }
 };
 
+#define RA_LIBRARIES_COUNT (sizeof (ra_libraries) / sizeof (ra_libraries[0]))
+
+
+/* The baton handed out by svn_ra_init_ra_libs: the scheme-to-vtable
+   hash for whatever libraries have been loaded so far, plus what we
+   need to load the rest on demand. */
+struct ra_baton
+{
+  apr_hash_t *ra_library_hash;
+
+  /* the pool libraries get loaded into (they live as long as it does) */
+  apr_pool_t *pool;
+
+  /* parallel to ra_libraries: have we tried loading this one yet? */
+  svn_boolean_t loaded[RA_LIBRARIES_COUNT];
+};
+
 
 static svn_error_t *
 load_ra_module (svn_ra_init_func_t *func,
@@ -125,55 +148,74 @@ load_ra_module (svn_ra_init_func_t *func,
 }
 
 
-/* -------------------------------------------------------------- */
-
-/*** Public Interfaces ***/
-
-svn_error_t *
-svn_ra_init_ra_libs (void **ra_baton,
-                     apr_pool_t *pool)
+/* Return TRUE iff URL's scheme (the part before the first colon)
+   appears in SCHEMES, a space-separated list. */
+static svn_boolean_t
+scheme_in_list (const char *url, const char *schemes)
 {
-  const struct ra_lib_defn *defn;
-  apr_hash_t *ra_library_hash;
+  const char *colon = strchr (url, ':');
+  apr_size_t len;
+  const char *p = schemes;
 
-  /* Our baton is a hash table that maps repository URL schemes to the
-     ra_plugin vtable that will handle it. */
-  ra_library_hash = apr_hash_make (pool);
+  if (! colon)
+    return FALSE;
+  len = colon - url;
 
-  for (defn = ra_libraries; defn->ra_name != NULL; ++defn)
+  while (*p)
     {
-      svn_ra_init_func_t initfunc = defn->initfunc;
+      const char *end = p;
 
-      if (initfunc == NULL)
-        {
-          /* see if we can find a dynload module */
-          SVN_ERR( load_ra_module (&initfunc, defn->ra_name, pool) );
-        }
+      while (*end && (*end != ' '))
+        ++end;
+      if (((apr_size_t) (end - p) == len) && (memcmp (p, url, len) == 0))
+        return TRUE;
+      p = *end ? end + 1 : end;
+    }
 
-      if (initfunc != NULL)
-        {
-          /* linked in or successfully dynloaded */
+  return FALSE;
+}
 
-          SVN_ERR( (*initfunc)(SVN_RA_ABI_VERSION, pool, ra_library_hash) );
 
-        }
+/* Load and initialize ra_libraries[IDX] into B's hash, unless it has
+   been tried before. */
+static svn_error_t *
+load_ra_library (struct ra_baton *b, int idx)
+{
+  svn_ra_init_func_t initfunc = ra_libraries[idx].initfunc;
+
+  if (b->loaded[idx])
+    return SVN_NO_ERROR;
+  b->loaded[idx] = TRUE;
+
+  if (initfunc == NULL)
+    {
+      /* see if we can find a dynload module */
+      SVN_ERR( load_ra_module (&initfunc, ra_libraries[idx].ra_name,
+                               b->pool) );
+    }
+
+  if (initfunc != NULL)
+    {
+      /* linked in or successfully dynloaded */
+
+      SVN_ERR( (*initfunc)(SVN_RA_ABI_VERSION, b->pool,
+                           b->ra_library_hash) );
     }
 
-  /* Return the (opaque) list. */
-  *ra_baton = ra_library_hash;
   return SVN_NO_ERROR;
 }
 
 
-svn_error_t *
-svn_ra_get_ra_library (svn_ra_plugin_t **library,
-                       void *ra_baton,
-                       const char *URL,
-                       apr_pool_t *pool)
+/* Set *LIBRARY to the vtable in HASH whose scheme matches URL and
+   return TRUE, or return FALSE if no loaded library matches. */
+static svn_boolean_t
+lookup_ra_library (svn_ra_plugin_t **library,
+                   apr_hash_t *hash,
+                   const char *URL,
+                   apr_pool_t *pool)
 {
   apr_hash_index_t *this;
-  apr_hash_t *hash = ra_baton;
-  
+
   /* Figure out which RA library key matches URL */
   for (this = apr_hash_first (pool, hash); this; this = apr_hash_next (this))
     {
@@ -189,11 +231,61 @@ svn_ra_get_ra_library (svn_ra_plugin_t **library,
       /* case-sensitive scheme comparison */
       if (memcmp (keystr, URL, keylen) == 0 && URL[keylen] == ':')
         {
-          *library = (svn_ra_plugin_t *) val;          
-          return SVN_NO_ERROR; 
+          *library = (svn_ra_plugin_t *) val;
+          return TRUE;
         }
     }
-    
+
+  return FALSE;
+}
+
+
+/* -------------------------------------------------------------- */
+
+/*** Public Interfaces ***/
+
+svn_error_t *
+svn_ra_init_ra_libs (void **ra_baton,
+                     apr_pool_t *pool)
+{
+  struct ra_baton *b = apr_pcalloc (pool, sizeof (*b));
+
+  /* Our baton is a hash table that maps repository URL schemes to the
+     ra_plugin vtable that will handle it --- but don't load anything
+     yet.  Each library's schemes are listed in ra_libraries, so
+     svn_ra_get_ra_library can tell which library a URL wants and
+     pull it in then; an operation that never mentions a URL never
+     pays for loading any of them. */
+  b->ra_library_hash = apr_hash_make (pool);
+  b->pool = pool;
+
+  /* Return the (opaque) baton. */
+  *ra_baton = b;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_ra_get_ra_library (svn_ra_plugin_t **library,
+                       void *ra_baton,
+                       const char *URL,
+                       apr_pool_t *pool)
+{
+  struct ra_baton *b = ra_baton;
+  int i;
+
+  /* Already loaded? */
+  if (lookup_ra_library (library, b->ra_library_hash, URL, pool))
+    return SVN_NO_ERROR;
+
+  /* Load whichever libraries claim URL's scheme, and look again. */
+  for (i = 0; ra_libraries[i].ra_name != NULL; ++i)
+    if (scheme_in_list (URL, ra_libraries[i].schemes))
+      SVN_ERR (load_ra_library (b, i));
+
+  if (lookup_ra_library (library, b->ra_library_hash, URL, pool))
+    return SVN_NO_ERROR;
+
   /* Couldn't find a match... */
   *library = NULL;
   return svn_error_createf (SVN_ERR_RA_ILLEGAL_URL, 0, NULL, pool,
@@ -228,10 +320,20 @@ svn_ra_print_ra_libraries (svn_stringbuf_t **descriptions,
 {
   const svn_ra_plugin_t *prev_ra_lib;
   apr_hash_index_t *this;
-  apr_hash_t *hash = ra_baton;
-  int count = apr_hash_count (hash);
-  ra_lib_list_t *list = apr_pcalloc (pool, count * sizeof (*list));
+  struct ra_baton *b = ra_baton;
+  apr_hash_t *hash;
+  ra_lib_list_t *list;
+  int count;
   int idx = 0;
+  int i;
+
+  /* The caller wants to see everything there is, so load it all. */
+  for (i = 0; ra_libraries[i].ra_name != NULL; ++i)
+    SVN_ERR (load_ra_library (b, i));
+
+  hash = b->ra_library_hash;
+  count = apr_hash_count (hash);
+  list = apr_pcalloc (pool, count * sizeof (*list));
 
   /* Copy the RA library list into an array. */
   for (this = apr_hash_first (pool, hash); this; this = apr_hash_next (this))
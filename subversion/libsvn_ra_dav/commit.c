@@ -22,6 +22,11 @@
 #include <apr_hash.h>
 #include <apr_uuid.h>
 #include <apr_portable.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 #define APR_WANT_STDIO
 #define APR_WANT_STRFUNC
@@ -69,6 +74,11 @@ typedef struct
 
 } resource_t;
 
+#if APR_HAS_THREADS
+/* defined below, with the rest of the parallel PUT pipeline */
+struct put_queue;
+#endif
+
 typedef struct
 {
   svn_ra_session_t *ras;
@@ -97,6 +107,10 @@ typedef struct
   /* The author (also according to the repository) of this commit. */
   const char **committed_author;
 
+#if APR_HAS_THREADS
+  struct put_queue *put_queue;  /* parallel PUT pipeline, or null */
+#endif
+
 } commit_ctx_t;
 
 typedef struct
@@ -105,6 +119,7 @@ typedef struct
   resource_t *rsrc;
   apr_table_t *prop_changes; /* name/values pairs of changed (or new) properties. */
   apr_array_header_t *prop_deletes; /* names of properties to delete. */
+  svn_boolean_t put_queued;  /* this file's PUT went to a worker */
 } resource_baton_t;
 
 typedef struct
@@ -135,6 +150,16 @@ static const ne_propname fetch_props[] =
 
 static const ne_propname log_message_prop = { SVN_PROP_PREFIX, "log" };
 
+/* How many extra connections a commit may use to upload file bodies
+   in parallel; see svn_ra_dav_set_put_workers.  Zero means upload
+   serially on the session's own connection, as always. */
+static int put_workers = 0;
+
+void svn_ra_dav_set_put_workers(int num_workers)
+{
+  put_workers = num_workers;
+}
+
 
 static svn_stringbuf_t *escape_url(const char *url, apr_pool_t *pool)
 {
@@ -202,7 +227,7 @@ static svn_error_t * get_version_url(commit_ctx_t *cc,
 
       SVN_ERR( svn_ra_dav__get_baseline_info(NULL,
                                              &bc_url, &bc_relative, NULL,
-                                             cc->ras->sess,
+                                             cc->ras,
                                              rsrc->url,
                                              revision,
                                              pool));
@@ -387,6 +412,7 @@ static svn_error_t * checkout_resource(commit_ctx_t *cc, resource_t *res)
                       "<D:href>%s</D:href>"
                       "</D:activity-set></D:checkout>", cc->activity_url);
   ne_set_request_body_buffer(req, body, strlen(body));
+  cc->ras->stats.bytes_sent += strlen(body);
 
   /* 
    * We have different const qualifiers here. locn is const char *,
@@ -533,6 +559,7 @@ static svn_error_t * do_proppatch(svn_ra_session_t *ras,
   req = ne_request_create(ras->sess, "PROPPATCH", url_str->data);
 
   ne_set_request_body_buffer(req, body->data, ne_buffer_size(body));
+  ras->stats.bytes_sent += ne_buffer_size(body);
   ne_add_request_header(req, "Content-Type", "text/xml; charset=UTF-8");
 
   /* run the request and get the resulting status code (and svn_error_t) */
@@ -680,7 +707,7 @@ static svn_error_t * commit_add_dir(const char *path,
          relative path under that BC.  */
       SVN_ERR( svn_ra_dav__get_baseline_info(NULL,
                                              &bc_url, &bc_relative, NULL,
-                                             parent->cc->ras->sess,
+                                             parent->cc->ras,
                                              copyfrom_path,
                                              copyfrom_revision,
                                              dir_pool));
@@ -826,7 +853,7 @@ static svn_error_t * commit_add_file(const char *path,
          relative path under that BC.  */
       SVN_ERR( svn_ra_dav__get_baseline_info(NULL,
                                              &bc_url, &bc_relative, NULL,
-                                             parent->cc->ras->sess,
+                                             parent->cc->ras,
                                              copyfrom_path,
                                              copyfrom_revision,
                                              file_pool));
@@ -889,6 +916,367 @@ static svn_error_t * commit_open_file(const char *path,
   return NULL;
 }
 
+/* Send the svndiff spooled behind FDESC (already rewound) to URL
+   (already escaped) as a PUT on SESS.  Allocate any error in POOL. */
+static svn_error_t * put_file_body(ne_session *sess,
+                                   const char *url,
+                                   int fdesc,
+                                   apr_pool_t *pool)
+{
+  ne_request *req;
+  int code;
+
+  /* create/prep the request */
+  req = ne_request_create(sess, "PUT", url);
+  if (req == NULL)
+    {
+      return svn_error_createf(SVN_ERR_RA_CREATING_REQUEST, 0, NULL,
+                               pool,
+                               "Could not create a PUT request (%s)",
+                               url);
+    }
+
+  /* ### use a symbolic name somewhere for this MIME type? */
+  ne_add_request_header(req, "Content-Type", SVN_SVNDIFF_MIME_TYPE);
+
+  /* Give the filedescriptor to neon. */
+  ne_set_request_body_fd(req, fdesc);
+
+  /* run the request and get the resulting status code (and svn_error_t) */
+  return svn_ra_dav__request_dispatch(&code, req, sess,
+                                      "PUT", url, pool);
+}
+
+
+#if APR_HAS_THREADS
+
+/** The parallel PUT pipeline **/
+
+/* A commit spends most of its wall clock PUTting file bodies: one
+   blocking round trip after another, all on the session's single
+   connection.  When workers are requested (svn_ra_dav_set_put_workers),
+   commit_stream_close instead hands the finished svndiff to a small
+   pool of worker threads -- each with its own connection to the
+   server, spawned by svn_ra_dav__spawn_session -- and the editor
+   drive moves straight on to the next file.
+
+   DAV constrains the ordering in only three places.  A resource must
+   be CHECKOUTed before its PUT; the editor thread already did that,
+   serially, long before the svndiff was finished.  A PROPPATCH must
+   not race the PUT on the same resource, so commit_close_file drains
+   the queue first (but only when this file's PUT was queued and there
+   are properties to patch).  And the MERGE that creates the new
+   revision must come after every PUT, so commit_close_edit drains and
+   shuts the workers down before merging.  PUTs to distinct working
+   resources are unordered, which is the whole point.
+
+   The workers share the session's auth callback, which session.c
+   serializes with ras->auth_lock. */
+
+/* How many uploads may be waiting before commit_stream_close blocks.
+   This also bounds the number of tmpfiles held open. */
+#define PUT_QUEUE_MAX 32
+
+/* Cap on worker connections. */
+#define PUT_WORKERS_MAX 4
+
+/* One queued upload.  The node itself lives in the session pool, so
+   it survives the reaping of the job; URL and any error live in POOL,
+   the put_baton's subpool.  That subpool hangs off the session pool,
+   so only the editor thread may create or destroy it -- a worker only
+   allocates from it. */
+struct put_job
+{
+  const char *url;              /* escaped working resource url */
+  apr_file_t *tmpfile;          /* the spooled svndiff.  the editor
+                                   thread closes it after the job
+                                   finishes; the worker touches only
+                                   the descriptor below. */
+  int fdesc;
+  apr_pool_t *pool;
+  svn_error_t *err;
+  svn_boolean_t finished;
+  struct put_job *next;         /* jobs not yet reaped */
+};
+
+struct put_worker
+{
+  struct put_queue *queue;
+  ne_session *sess;             /* this worker's own connection */
+  apr_thread_t *thread;
+};
+
+struct put_queue
+{
+  struct put_job *jobs[PUT_QUEUE_MAX];  /* a ring buffer */
+  int head;                   /* next job a worker will take */
+  int count;                  /* jobs waiting */
+  int active;                 /* jobs being uploaded right now */
+  svn_boolean_t done;         /* no more jobs are coming */
+  svn_error_t *err;           /* first error any job produced */
+  struct put_job *unreaped;   /* jobs whose tmpfile/pool still exist */
+  struct put_worker workers[PUT_WORKERS_MAX];
+  int nworkers;
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+};
+
+
+static void * put_worker_loop(apr_thread_t *thread, void *data)
+{
+  struct put_worker *w = data;
+  struct put_queue *q = w->queue;
+
+  apr_thread_mutex_lock(q->lock);
+  while (1)
+    {
+      struct put_job *job;
+      svn_error_t *err;
+
+      while ((q->count == 0) && (! q->done))
+        apr_thread_cond_wait(q->cond, q->lock);
+      if (q->count == 0)
+        break;
+
+      job = q->jobs[q->head];
+      q->head = (q->head + 1) % PUT_QUEUE_MAX;
+      q->count--;
+
+      /* Once an upload has failed, just mark the rest finished,
+         unrun; the editor thread still cleans them up. */
+      if (q->err)
+        {
+          job->finished = TRUE;
+          apr_thread_cond_broadcast(q->cond);
+          continue;
+        }
+
+      q->active++;
+      apr_thread_mutex_unlock(q->lock);
+
+      err = put_file_body(w->sess, job->url, job->fdesc, job->pool);
+
+      apr_thread_mutex_lock(q->lock);
+      q->active--;
+      job->err = err;
+      job->finished = TRUE;
+      if (err && (! q->err))
+        q->err = err;
+      apr_thread_cond_broadcast(q->cond);
+    }
+  apr_thread_mutex_unlock(q->lock);
+
+  apr_thread_exit(thread, 0);
+  return NULL;
+}
+
+
+/* Clean up every finished job: close its tmpfile (deleting it) and
+   toss its pool.  Call with the queue lock held.  A failed job's pool
+   stays alive, since the error lives there; it is a subpool of the
+   session pool, so it goes away with the session regardless. */
+static void reap_put_jobs(struct put_queue *q)
+{
+  struct put_job **jp = &q->unreaped;
+
+  while (*jp != NULL)
+    {
+      struct put_job *job = *jp;
+
+      if (! job->finished)
+        {
+          jp = &job->next;
+          continue;
+        }
+
+      *jp = job->next;
+      (void) apr_file_close(job->tmpfile);
+      if (job->err == SVN_NO_ERROR)
+        svn_pool_destroy(job->pool);
+    }
+}
+
+
+static svn_error_t * shutdown_put_queue(commit_ctx_t *cc);
+
+/* A cleanup on the session pool: an aborted commit never reaches
+   commit_close_edit, and the workers must be gone before the pool
+   takes the lock and condition variable down with it. */
+static apr_status_t cleanup_put_queue(void *data)
+{
+  commit_ctx_t *cc = data;
+
+  svn_error_clear_all(shutdown_put_queue(cc));
+  return APR_SUCCESS;
+}
+
+
+/* Set *QUEUE_P to CC's put queue, spawning the worker sessions and
+   threads if this is the first call. */
+static svn_error_t * get_put_queue(struct put_queue **queue_p,
+                                   commit_ctx_t *cc)
+{
+  struct put_queue *q = cc->put_queue;
+
+  if (q == NULL)
+    {
+      apr_status_t apr_err;
+      svn_error_t *err = SVN_NO_ERROR;
+      int nworkers = put_workers;
+      int i;
+
+      if (nworkers > PUT_WORKERS_MAX)
+        nworkers = PUT_WORKERS_MAX;
+
+      q = apr_pcalloc(cc->ras->pool, sizeof(*q));
+      apr_err = apr_thread_mutex_create(&q->lock, APR_THREAD_MUTEX_DEFAULT,
+                                        cc->ras->pool);
+      if (! apr_err)
+        apr_err = apr_thread_cond_create(&q->cond, cc->ras->pool);
+      for (i = 0; (! apr_err) && (! err) && (i < nworkers); i++)
+        {
+          struct put_worker *w = &q->workers[q->nworkers];
+
+          w->queue = q;
+          err = svn_ra_dav__spawn_session(&w->sess, cc->ras, cc->ras->pool);
+          if (err)
+            break;
+          apr_err = apr_thread_create(&w->thread, NULL, put_worker_loop,
+                                      w, cc->ras->pool);
+          if (! apr_err)
+            q->nworkers++;
+        }
+      if (apr_err || err)
+        {
+          /* Shoot down any workers that did start, lest they outlive
+             the commit. */
+          if (q->nworkers > 0)
+            {
+              apr_thread_mutex_lock(q->lock);
+              q->done = TRUE;
+              apr_thread_cond_broadcast(q->cond);
+              apr_thread_mutex_unlock(q->lock);
+              for (i = 0; i < q->nworkers; i++)
+                {
+                  apr_status_t ignored;
+                  (void) apr_thread_join(&ignored, q->workers[i].thread);
+                }
+            }
+          if (err)
+            return err;
+          return svn_error_create(apr_err, 0, NULL, cc->ras->pool,
+                                  "get_put_queue: can't start PUT worker");
+        }
+      cc->put_queue = q;
+
+      /* Cleanups run LIFO, so this joins the workers before the lock
+         and condition variable above are destroyed. */
+      apr_pool_cleanup_register(cc->ras->pool, cc, cleanup_put_queue,
+                                apr_pool_cleanup_null);
+    }
+
+  *queue_p = q;
+  return SVN_NO_ERROR;
+}
+
+
+/* Queue the upload described by PB, URL and FDESC on one of CC's
+   workers, blocking while the queue is full. */
+static svn_error_t * queue_put_job(commit_ctx_t *cc,
+                                   put_baton_t *pb,
+                                   const char *url,
+                                   int fdesc)
+{
+  struct put_queue *q;
+  struct put_job *job;
+
+  SVN_ERR( get_put_queue(&q, cc) );
+
+  job = apr_pcalloc(cc->ras->pool, sizeof(*job));
+  job->url = url;
+  job->tmpfile = pb->tmpfile;
+  job->fdesc = fdesc;
+  job->pool = pb->pool;
+
+  apr_thread_mutex_lock(q->lock);
+  while (q->count == PUT_QUEUE_MAX)
+    apr_thread_cond_wait(q->cond, q->lock);
+  reap_put_jobs(q);
+  q->jobs[(q->head + q->count) % PUT_QUEUE_MAX] = job;
+  q->count++;
+  job->next = q->unreaped;
+  q->unreaped = job;
+  apr_thread_cond_broadcast(q->cond);
+  apr_thread_mutex_unlock(q->lock);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/* Wait until every queued PUT has finished, clean up after them, and
+   return the first error any of them produced.  A no-op when no
+   uploads were ever queued. */
+static svn_error_t * drain_put_queue(commit_ctx_t *cc)
+{
+#if APR_HAS_THREADS
+  struct put_queue *q = cc->put_queue;
+  svn_error_t *err;
+
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock(q->lock);
+  while ((q->count > 0) || (q->active > 0))
+    apr_thread_cond_wait(q->cond, q->lock);
+  reap_put_jobs(q);
+  err = q->err;
+  q->err = SVN_NO_ERROR;
+  apr_thread_mutex_unlock(q->lock);
+
+  return err;
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+
+/* Drain the queue, then shut the worker threads down.  (Their
+   connections die with the session pool.)  Safe to call again, and
+   when the pipeline never started. */
+static svn_error_t * shutdown_put_queue(commit_ctx_t *cc)
+{
+#if APR_HAS_THREADS
+  struct put_queue *q = cc->put_queue;
+  svn_error_t *err;
+  int i;
+
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  err = drain_put_queue(cc);
+
+  apr_thread_mutex_lock(q->lock);
+  q->done = TRUE;
+  apr_thread_cond_broadcast(q->cond);
+  apr_thread_mutex_unlock(q->lock);
+
+  for (i = 0; i < q->nworkers; i++)
+    {
+      apr_status_t ignored;
+      (void) apr_thread_join(&ignored, q->workers[i].thread);
+    }
+
+  cc->put_queue = NULL;
+
+  return err;
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+
 static svn_error_t * commit_stream_write(void *baton,
                                          const char *data, apr_size_t *len)
 {
@@ -901,6 +1289,10 @@ static svn_error_t * commit_stream_write(void *baton,
     return svn_error_create(status, 0, NULL, pb->pool,
                             "Could not write svndiff to temp file.");
 
+  /* every spooled byte is destined for a PUT body, so charge it to
+     the upload tally now, while we still know the count. */
+  pb->file->cc->ras->stats.bytes_sent += *len;
+
   return NULL;
 }
 
@@ -909,27 +1301,12 @@ static svn_error_t * commit_stream_close(void *baton)
   put_baton_t *pb = baton;
   commit_ctx_t *cc = pb->file->cc;
   resource_t *rsrc = pb->file->rsrc;
-  ne_request *req;
   int fdesc;
-  int code;
   apr_status_t status;
   svn_error_t *err;
   apr_off_t offset = 0;
   svn_stringbuf_t *url_str = escape_url(rsrc->wr_url, pb->pool);
 
-  /* create/prep the request */
-  req = ne_request_create(cc->ras->sess, "PUT", url_str->data);
-  if (req == NULL)
-    {
-      return svn_error_createf(SVN_ERR_RA_CREATING_REQUEST, 0, NULL,
-                               pb->pool,
-                               "Could not create a PUT request (%s)",
-                               url_str->data);
-    }
-
-  /* ### use a symbolic name somewhere for this MIME type? */
-  ne_add_request_header(req, "Content-Type", SVN_SVNDIFF_MIME_TYPE);
-
   /* Rewind the tmpfile. */
   status = apr_file_seek(pb->tmpfile, APR_SET, &offset);
   if (status)
@@ -947,12 +1324,18 @@ static svn_error_t * commit_stream_close(void *baton)
                               "Couldn't get file-descriptor of tmpfile.");
     }
 
-  /* Give the filedescriptor to neon. */
-  ne_set_request_body_fd(req, fdesc);
+#if APR_HAS_THREADS
+  if (put_workers > 0)
+    {
+      /* Hand the upload to a worker connection.  A later drain closes
+         the tmpfile and tosses pb->pool. */
+      SVN_ERR( queue_put_job(cc, pb, url_str->data, fdesc) );
+      pb->file->put_queued = TRUE;
+      return NULL;
+    }
+#endif
 
-  /* run the request and get the resulting status code (and svn_error_t) */
-  err = svn_ra_dav__request_dispatch(&code, req, cc->ras->sess,
-                                     "PUT", url_str->data, cc->ras->pool);
+  err = put_file_body(cc->ras->sess, url_str->data, fdesc, cc->ras->pool);
 
   /* we're done with the file.  this should delete it. */
   (void) apr_file_close(pb->tmpfile);
@@ -1032,6 +1415,13 @@ static svn_error_t * commit_close_file(void *file_baton)
 {
   resource_baton_t *file = file_baton;
 
+  /* A PROPPATCH must not race the PUT on the same resource.  (PUTs
+     on *different* resources are unordered, so files without prop
+     changes don't wait at all.) */
+  if (file->put_queued
+      && (file->prop_changes != NULL || file->prop_deletes != NULL))
+    SVN_ERR( drain_put_queue(file->cc) );
+
   /* Perform all of the property changes on the file. Note that we
      checked out the file when the first prop change was noted. */
   SVN_ERR( do_proppatch(file->cc->ras, file->rsrc, file) );
@@ -1044,6 +1434,10 @@ static svn_error_t * commit_close_edit(void *edit_baton)
 {
   commit_ctx_t *cc = edit_baton;
 
+  /* The MERGE below creates the new revision from the activity, so
+     every queued PUT must land first. */
+  SVN_ERR( shutdown_put_queue(cc) );
+
   /* ### different pool? */
   SVN_ERR( svn_ra_dav__merge_activity(cc->new_rev,
                                       cc->committed_date,
@@ -36,6 +36,7 @@
 
 #include "svn_error.h"
 #include "svn_pools.h"
+#include "svn_base64.h"
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "svn_ra.h"
@@ -109,6 +110,12 @@ typedef struct {
   /* The version resource URL for this directory. */
   const char *vsn_url;
 
+  /* A subpool which lives only as long as this directory is open. The
+     pathbuf and vsn_url live here, so closing the directory releases
+     them; memory use is bounded by the depth of the tree rather than
+     the size of the report. */
+  apr_pool_t *pool;
+
   /* A buffer which stores the relative directory name. We also use this
      for temporary construction relative file names. */
   svn_stringbuf_t *pathbuf;
@@ -135,8 +142,23 @@ typedef struct {
   svn_stringbuf_t *cpathstr;
   svn_stringbuf_t *href;
 
+  /* These serve the current file's inline text delta, when the server
+     sends one: the editor's window handler, a base64-decoding stream
+     feeding the svndiff parser that drives it, and a subpool (of the
+     session pool) holding the decoders. All NULL/unset outside such a
+     file. */
+  svn_txdelta_window_handler_t whandler;
+  void *whandler_baton;
+  svn_stream_t *svndiff_decoder;
+  apr_pool_t *delta_pool;
+
   vsn_url_helper vuh;
 
+  /* Scratch pool for per-entry work (file fetches, property fetches).
+     We clear it as each entry finishes, so these allocations don't
+     accumulate over the life of a large report. */
+  apr_pool_t *scratch;
+
   svn_error_t *err;
 
 } report_baton_t;
@@ -144,6 +166,14 @@ typedef struct {
 static const char report_head[] = "<S:update-report xmlns:S=\""
                                    SVN_XML_NAMESPACE
                                    "\">" DEBUG_CR;
+
+/* the same report, but inviting the server to inline file contents as
+   base64 svndiff elements instead of leaving us one GET per file. */
+static const char report_head_send_all[] =
+                                  "<S:update-report send-all=\"true\" "
+                                   "xmlns:S=\""
+                                   SVN_XML_NAMESPACE
+                                   "\">" DEBUG_CR;
 static const char report_tail[] = "</S:update-report>" DEBUG_CR;
 
 static const struct ne_xml_elm report_elements[] =
@@ -162,6 +192,7 @@ static const struct ne_xml_elm report_elements[] =
   { SVN_XML_NAMESPACE, "fetch-props", ELEM_fetch_props, 0 },
   { SVN_XML_NAMESPACE, "remove-prop", ELEM_remove_prop, 0 },
   { SVN_XML_NAMESPACE, "fetch-file", ELEM_fetch_file, 0 },
+  { SVN_XML_NAMESPACE, "txdelta", ELEM_txdelta, NE_XML_CDATA },
   { SVN_XML_NAMESPACE, "prop", ELEM_prop, 0 },
 
   { "DAV:", "version-name", ELEM_version_name, NE_XML_CDATA },
@@ -341,8 +372,126 @@ static void add_props(const svn_ra_dav_resource_t *r,
 }
                       
 
+/* A deep-PROPFIND cache: everything the checkout walk will want to know
+   about the subtree under one URL, fetched in a single round trip.
+   RESOURCES maps each resource's url to its svn_ra_dav_resource_t;
+   ENTRIES maps a collection's url to an array of the resources directly
+   inside it. */
+typedef struct {
+  apr_hash_t *resources;
+  apr_hash_t *entries;
+} subtree_props_t;
+
+/* Try to fetch the properties for the entire subtree under URL with a
+   single depth-infinity PROPFIND, returning them as a cache for
+   fetch_dirents to draw on.  mod_dav refuses infinite-depth PROPFINDs
+   unless the administrator has switched them on, so on any failure just
+   return NULL: each directory then pays its own depth-1 PROPFIND as
+   before. */
+static subtree_props_t *fetch_subtree_props(svn_ra_session_t *ras,
+                                            const char *url,
+                                            apr_pool_t *pool)
+{
+  subtree_props_t *subtree = apr_palloc(pool, sizeof(*subtree));
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  err = svn_ra_dav__get_props(&subtree->resources, ras->sess, url,
+                              NE_DEPTH_INFINITE, NULL,
+                              NULL /* allprop */, pool);
+  if (err)
+    {
+      svn_error_clear_all(err);
+      return NULL;
+    }
+
+  /* index the resources by the collection holding them. a resource's
+     parent key matches the parent's own url: both are built from the
+     hrefs of this one response, decoded and stripped the same way. */
+  subtree->entries = apr_hash_make(pool);
+  for (hi = apr_hash_first(pool, subtree->resources); hi;
+       hi = apr_hash_next(hi))
+    {
+      void *val;
+      svn_ra_dav_resource_t *r;
+      const char *slash;
+      const char *parent;
+      apr_array_header_t *ents;
+
+      apr_hash_this(hi, NULL, NULL, &val);
+      r = val;
+
+      slash = strrchr(r->url, '/');
+      if (slash == NULL)
+        continue;
+      parent = apr_pstrndup(pool, r->url, slash - r->url);
+
+      ents = apr_hash_get(subtree->entries, parent, APR_HASH_KEY_STRING);
+      if (ents == NULL)
+        {
+          ents = apr_array_make(pool, 4, sizeof(svn_ra_dav_resource_t *));
+          apr_hash_set(subtree->entries, parent, APR_HASH_KEY_STRING, ents);
+        }
+      *(svn_ra_dav_resource_t **)apr_array_push(ents) = r;
+    }
+
+  return subtree;
+}
+
+/* Dispatch one resource R found in the collection whose url-path is
+   PATH: hand the collection's own properties to SETTER with DIR_BATON,
+   push subdirectories onto SUBDIRS (when RECURSE), and collect files
+   into FILES. */
+static svn_error_t * process_dirent(svn_ra_dav_resource_t *r,
+                                    const char *path,
+                                    void *dir_baton,
+                                    svn_boolean_t recurse,
+                                    apr_array_header_t *subdirs,
+                                    apr_array_header_t *files,
+                                    prop_setter_t setter,
+                                    vsn_url_helper *vuh,
+                                    apr_pool_t *pool)
+{
+  if (r->is_collection)
+    {
+      if (uri_compare(path, r->url) == 0)
+        {
+          /* don't insert "this dir" into the set of subdirs */
+
+          /* this is the directory itself, and the PROPFIND response
+             carries its properties right along with its entries --
+             set them here, so the caller need not spend a separate
+             depth-0 PROPFIND round trip asking for them. */
+          add_props(r, setter, dir_baton, pool);
+
+          /* store the version URL for this resource */
+          SVN_ERR( store_vsn_url(r, dir_baton, setter, vuh) );
+        }
+      else
+        {
+          if (recurse)
+            {
+              subdir_t *subdir = apr_palloc(pool, sizeof(*subdir));
+
+              subdir->rsrc = r;
+              subdir->parent_baton = dir_baton;
+
+              PUSH_SUBDIR(subdirs, subdir);
+            }
+        }
+    }
+  else
+    {
+      svn_ra_dav_resource_t **file = apr_array_push(files);
+      *file = r;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t * fetch_dirents(svn_ra_session_t *ras,
                                    const char *url,
+                                   subtree_props_t *subtree,
                                    void *dir_baton,
                                    svn_boolean_t recurse,
                                    apr_array_header_t *subdirs,
@@ -354,6 +503,49 @@ static svn_error_t * fetch_dirents(svn_ra_session_t *ras,
   apr_hash_t *dirents;
   struct uri parsed_url;
   apr_hash_index_t *hi;
+  svn_ra_dav_resource_t *self = NULL;
+
+  uri_parse(url, &parsed_url, NULL);
+
+  if (subtree != NULL)
+    {
+      /* look this collection up in the deep-PROPFIND cache, under the
+         same key form the cache's resources were stored with. */
+      char *path = apr_pstrdup(pool, parsed_url.path);
+      apr_size_t len = strlen(path);
+
+      if (len > 1 && path[len - 1] == '/')
+        path[len - 1] = '\0';
+      self = apr_hash_get(subtree->resources, path, APR_HASH_KEY_STRING);
+
+      /* if the cache somehow cannot resolve this url, just go ask the
+         server about it. */
+    }
+
+  if (self != NULL)
+    {
+      apr_array_header_t *ents;
+      int i;
+
+      /* the whole subtree is already in hand: this collection's own
+         properties and its entry list cost no round trip at all. */
+      SVN_ERR( process_dirent(self, parsed_url.path, dir_baton, recurse,
+                              subdirs, files, setter, vuh, pool) );
+
+      ents = apr_hash_get(subtree->entries, self->url, APR_HASH_KEY_STRING);
+      for (i = 0; ents != NULL && i < ents->nelts; i++)
+        {
+          svn_ra_dav_resource_t *r
+            = ((svn_ra_dav_resource_t **)ents->elts)[i];
+
+          SVN_ERR( process_dirent(r, parsed_url.path, dir_baton, recurse,
+                                  subdirs, files, setter, vuh, pool) );
+        }
+
+      uri_free(&parsed_url);
+
+      return SVN_NO_ERROR;
+    }
 
   /* Fetch all properties so we can snarf ones out of the svn:custom
    * namspace. */
@@ -383,8 +575,6 @@ static svn_error_t * fetch_dirents(svn_ra_session_t *ras,
    * :-)
    */
 
-  uri_parse(url, &parsed_url, NULL);
-
   for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
     {
       void *val;
@@ -393,33 +583,8 @@ static svn_error_t * fetch_dirents(svn_ra_session_t *ras,
       apr_hash_this(hi, NULL, NULL, &val);
       r = val;
 
-      if (r->is_collection)
-        {
-          if (uri_compare(parsed_url.path, r->url) == 0)
-            {
-              /* don't insert "this dir" into the set of subdirs */
-
-              /* store the version URL for this resource */
-              SVN_ERR( store_vsn_url(r, dir_baton, setter, vuh) );
-            }
-          else
-            {
-              if (recurse)
-                {
-                  subdir_t *subdir = apr_palloc(pool, sizeof(*subdir));
-
-                  subdir->rsrc = r;
-                  subdir->parent_baton = dir_baton;
-
-                  PUSH_SUBDIR(subdirs, subdir);
-                }
-            }
-        }
-      else
-        {
-          svn_ra_dav_resource_t **file = apr_array_push(files);
-          *file = r;
-        }
+      SVN_ERR( process_dirent(r, parsed_url.path, dir_baton, recurse,
+                              subdirs, files, setter, vuh, pool) );
     }
 
   uri_free(&parsed_url);
@@ -434,12 +599,15 @@ static svn_error_t *custom_get_request(ne_session *sess,
                                        void *subctx,
                                        svn_ra_get_wc_prop_func_t get_wc_prop,
                                        void *cb_baton,
+                                       apr_off_t *received,
                                        apr_pool_t *pool)
 {
   custom_get_ctx_t cgc = { 0 };
   const char *delta_base;
   ne_request *req;
+  svn_ra_dav__gzip_t *gzip;
   svn_error_t *err;
+  svn_error_t *gzip_err;
   int code;
 
   /* See if we can get a version URL for this resource. This will refer to
@@ -473,8 +641,10 @@ static svn_error_t *custom_get_request(ne_session *sess,
       ne_add_request_header(req, SVN_DAV_DELTA_BASE_HEADER, delta_base);
     }
 
-  /* add in a reader to capture the body of the response. */
-  ne_add_response_body_reader(req, ne_accept_2xx, reader, &cgc);
+  /* add in a reader to capture the body of the response. The server
+     is invited to gzip the body; the decoder hands READER the plain
+     bytes either way. */
+  gzip = svn_ra_dav__gzip_response(req, reader, &cgc, received, pool);
 
   /* complete initialization of the body reading context */
   cgc.subctx = subctx;
@@ -486,6 +656,12 @@ static svn_error_t *custom_get_request(ne_session *sess,
   if (cgc.ctype.value != NULL)
     free(cgc.ctype.value);
 
+  /* if the decoder tripped over a corrupt compressed body, whatever
+     the reader made of the garbage is beside the point. */
+  gzip_err = svn_ra_dav__gzip_error(gzip);
+  if (gzip_err)
+    return gzip_err;
+
   /* if there was an error writing the contents, then return it rather
      than Neon-related errors */
   if (cgc.err)
@@ -528,9 +704,11 @@ static void fetch_file_reader(void *userdata, const char *buf, size_t len)
 
   if (!cgc->checked_type)
     {
-
-      if (!strcmp(cgc->ctype.type, "application") && 
-          !strcmp(cgc->ctype.subtype, "vnd.svn-svndiff"))
+      /* a response without a Content-Type is treated as a fulltext;
+         only an explicit svndiff type switches us into delta mode. */
+      if (cgc->ctype.type != NULL
+          && !strcmp(cgc->ctype.type, "application")
+          && !strcmp(cgc->ctype.subtype, "vnd.svn-svndiff"))
         {
           /* we are receiving an svndiff. set things up. */
           frc->stream = svn_txdelta_parse_svndiff(frc->handler,
@@ -603,6 +781,7 @@ static svn_error_t *simple_fetch_file(ne_session *sess,
                                       const svn_delta_edit_fns_t *editor,
                                       svn_ra_get_wc_prop_func_t get_wc_prop,
                                       void *cb_baton,
+                                      apr_off_t *received,
                                       apr_pool_t *pool)
 {
   file_read_ctx_t frc = { 0 };
@@ -629,7 +808,7 @@ static svn_error_t *simple_fetch_file(ne_session *sess,
 
   SVN_ERR( custom_get_request(sess, url_str->data, relpath,
                               fetch_file_reader, &frc,
-                              get_wc_prop, cb_baton, pool) );
+                              get_wc_prop, cb_baton, received, pool) );
 
   /* close the handler, since the file reading completed successfully. */
   SVN_ERR( (*frc.handler)(NULL, frc.handler_baton) );
@@ -642,6 +821,7 @@ static svn_error_t *fetch_file(ne_session *sess,
                                void *dir_baton,
                                vsn_url_helper *vuh,
                                const svn_delta_edit_fns_t *editor,
+                               apr_off_t *received,
                                apr_pool_t *pool)
 {
   const char *bc_url = rsrc->url;    /* url in the Baseline Collection */
@@ -660,7 +840,7 @@ static svn_error_t *fetch_file(ne_session *sess,
      simple_fetch_file() params related to fetching version URLs (for
      fetching deltas) */
   err = simple_fetch_file(sess, bc_url, NULL, TRUE, file_baton, editor,
-                          NULL, NULL, pool);
+                          NULL, NULL, received, pool);
   if (err)
     {
       /* ### do we really need to bother with closing the file_baton? */
@@ -701,7 +881,7 @@ static svn_error_t * begin_checkout(svn_ra_session_t *ras,
                                         pool) );
 
   SVN_ERR( svn_ra_dav__get_baseline_info(&is_dir, &bc_url, &bc_relative,
-                                         target_rev, ras->sess,
+                                         target_rev, ras,
                                          ras->root.path, revision, pool) );
   if (!is_dir)
     {
@@ -772,6 +952,63 @@ add_prop_to_hash (void *baton,
 }
 
 
+/* Set *PROPS to the property hash for the resource at URL, built the
+   way the get_file interface promises: fs props with the custom
+   prefix stripped, the checked-in version url as a 'wc' prop, and
+   the recognized 'entry' props.  Allocate in POOL. */
+static svn_error_t *
+get_file_props(svn_ra_session_t *ras,
+               const char *url,
+               apr_hash_t **props,
+               apr_pool_t *pool)
+{
+  svn_ra_dav_resource_t *rsrc;
+  apr_hash_index_t *hi;
+
+  SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, ras->sess, url,
+                                          NULL, NULL /* all props */,
+                                          pool) );
+
+  *props = apr_hash_make(pool);
+
+  for (hi = apr_hash_first(pool, rsrc->propset);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const void *key;
+      void *val;
+
+      apr_hash_this(hi, &key, NULL, &val);
+
+      /* If the property starts with "svn:custom:", then it's a
+         normal user-controlled property coming from the fs.  Just
+         strip off this prefix and add to the hash. */
+#define NSLEN (sizeof(SVN_PROP_CUSTOM_PREFIX) - 1)
+      if (strncmp(key, SVN_PROP_CUSTOM_PREFIX, NSLEN) == 0)
+        apr_hash_set(*props, &((const char *)key)[NSLEN],
+                     APR_HASH_KEY_STRING,
+                     svn_string_create(val, pool));
+#undef NSLEN
+
+      else if (strcmp(key, SVN_RA_DAV__PROP_CHECKED_IN) == 0)
+        /* For files, we currently only have one 'wc' prop. */
+        apr_hash_set(*props, SVN_RA_DAV__LP_VSN_URL, APR_HASH_KEY_STRING,
+                     svn_string_create(val, pool));
+
+      else
+        /* If it's one of the 'entry' props, this func will
+           recognize the DAV name & add it to the hash mapped to a
+           new name recognized by libsvn_wc. */
+        SVN_ERR( set_special_wc_prop ((const char *) key,
+                                      (const char *) val,
+                                      add_prop_to_hash, *props,
+                                      pool) );
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *svn_ra_dav__get_file(void *session_baton,
                                   const char *path,
                                   svn_revnum_t revision,
@@ -779,8 +1016,6 @@ svn_error_t *svn_ra_dav__get_file(void *session_baton,
                                   svn_revnum_t *fetched_rev,
                                   apr_hash_t **props)
 {
-  svn_ra_dav_resource_t *rsrc;
-  apr_hash_index_t *hi;
   svn_stringbuf_t *url_str;
   const char *final_url;
   svn_ra_session_t *ras = (svn_ra_session_t *) session_baton;
@@ -804,7 +1039,7 @@ svn_error_t *svn_ra_dav__get_file(void *session_baton,
       SVN_ERR (svn_ra_dav__get_baseline_info(NULL,
                                              &bc_url, &bc_relative,
                                              &got_rev,
-                                             ras->sess,
+                                             ras,
                                              url_str->data, revision,
                                              ras->pool));
 
@@ -817,54 +1052,86 @@ svn_error_t *svn_ra_dav__get_file(void *session_baton,
         *fetched_rev = got_rev;
     }
 
-  /* Fetch the file, shoving it at the provided stream. */
+  /* Fetch the file, shoving it at the provided stream.
+
+     Note: we pass NULL for the wc prop callback, and thus never
+     advertise a delta base. The caller handed us a plain stream to
+     dump fulltext into; unlike the update editor, we have no base
+     text to apply an svndiff against, so we must not invite one. */
   SVN_ERR( custom_get_request(ras->sess, final_url, path,
                               get_file_reader, stream,
-                              ras->callbacks->get_wc_prop,
-                              ras->callback_baton, ras->pool) );
+                              NULL, NULL,
+                              &ras->stats.bytes_received, ras->pool) );
 
   if (props)
+    SVN_ERR( get_file_props(ras, final_url, props, ras->pool) );
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *svn_ra_dav__get_files(void *session_baton,
+                                   const apr_array_header_t *paths,
+                                   svn_revnum_t revision,
+                                   svn_boolean_t want_props,
+                                   svn_ra_file_receiver_t receiver,
+                                   void *receiver_baton)
+{
+  svn_ra_session_t *ras = (svn_ra_session_t *) session_baton;
+  svn_revnum_t got_rev = revision;
+  const char *base_url = ras->url;
+  apr_pool_t *subpool;
+  int i;
+
+  /* If the batch is pinned to a revision, resolve the baseline
+     collection holding that revision once, up front; each file is
+     then one plain GET inside the collection, instead of repeating
+     the baseline PROPFINDs per file the way a loop over get_file()
+     would. */
+  if (SVN_IS_VALID_REVNUM(revision))
     {
-      SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, ras->sess, final_url, 
-                                              NULL, NULL /* all props */, 
-                                              ras->pool) ); 
+      svn_string_t bc_url, bc_relative;
+      svn_stringbuf_t *final_bc_url;
 
-      *props = apr_hash_make(ras->pool);
+      SVN_ERR( svn_ra_dav__get_baseline_info(NULL,
+                                             &bc_url, &bc_relative,
+                                             &got_rev,
+                                             ras,
+                                             ras->url, revision,
+                                             ras->pool) );
 
-      for (hi = apr_hash_first(ras->pool, rsrc->propset); 
-           hi; 
-           hi = apr_hash_next(hi)) 
-        {
-          const void *key;
-          void *val;
+      final_bc_url = svn_stringbuf_create_from_string(&bc_url, ras->pool);
+      svn_path_add_component_nts (final_bc_url, bc_relative.data);
+      base_url = final_bc_url->data;
+    }
 
-          apr_hash_this(hi, &key, NULL, &val);
+  /* The requests all ride the session's one persistent connection,
+     back to back --- as close to pipelining as neon lets us get. */
+  subpool = svn_pool_create(ras->pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = (((const char **)(paths)->elts)[i]);
+      svn_stringbuf_t *url_str = svn_stringbuf_create(base_url, subpool);
+      apr_hash_t *props = NULL;
+      svn_stream_t *contents;
 
-          /* If the property starts with "svn:custom:", then it's a
-             normal user-controlled property coming from the fs.  Just
-             strip off this prefix and add to the hash. */
-#define NSLEN (sizeof(SVN_PROP_CUSTOM_PREFIX) - 1)
-          if (strncmp(key, SVN_PROP_CUSTOM_PREFIX, NSLEN) == 0)
-            apr_hash_set(*props, &((const char *)key)[NSLEN], 
-                         APR_HASH_KEY_STRING, 
-                         svn_string_create(val, ras->pool));    
-#undef NSLEN
-          
-          else if (strcmp(key, SVN_RA_DAV__PROP_CHECKED_IN) == 0)
-            /* For files, we currently only have one 'wc' prop. */
-            apr_hash_set(*props, SVN_RA_DAV__LP_VSN_URL, APR_HASH_KEY_STRING, 
-                         svn_string_create(val, ras->pool));
-          
-          else
-            /* If it's one of the 'entry' props, this func will
-               recognize the DAV name & add it to the hash mapped to a
-               new name recognized by libsvn_wc. */
-            SVN_ERR( set_special_wc_prop ((const char *) key,
-                                          (const char *) val,
-                                          add_prop_to_hash, *props, 
-                                          ras->pool) );
-        }
+      svn_path_add_component_nts (url_str, path);
+
+      if (want_props)
+        SVN_ERR( get_file_props(ras, url_str->data, &props, subpool) );
+
+      SVN_ERR( (*receiver)(receiver_baton, path, got_rev, props,
+                           &contents, subpool) );
+
+      if (contents)
+        SVN_ERR( custom_get_request(ras->sess, url_str->data, path,
+                                    get_file_reader, contents,
+                                    NULL, NULL,
+                                    &ras->stats.bytes_received, subpool) );
+
+      svn_pool_clear(subpool);
     }
+  svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
 }
@@ -889,6 +1156,7 @@ svn_error_t * svn_ra_dav__do_checkout(void *session_baton,
   subdir_t *subdir;
   apr_array_header_t *subdirs;  /* subdirs to scan (subdir_t *) */
   apr_array_header_t *files;    /* files to grab (svn_ra_dav_resource_t *) */
+  subtree_props_t *subtree;     /* deep-PROPFIND cache, or null */
   apr_pool_t *subpool;
 
   /* ### use quick_wrap rather than SVN_ERR on some of these? */
@@ -901,6 +1169,12 @@ svn_error_t * svn_ra_dav__do_checkout(void *session_baton,
   SVN_ERR( begin_checkout(ras, revision, &activity_url, &target_rev,
                           &bc_root) );
 
+  /* grab the whole tree's properties in one deep PROPFIND if the
+     server will let us; the walk below then needs no per-directory
+     PROPFINDs at all. the cache has to outlive the whole edit, so it
+     lives in ras->pool along with the rest of the walk state. */
+  subtree = recurse ? fetch_subtree_props(ras, bc_root, ras->pool) : NULL;
+
   /* all the files we checkout will have TARGET_REV for the revision */
   SVN_ERR( (*editor->set_target_revision)(edit_baton, target_rev) );
 
@@ -986,14 +1260,6 @@ svn_error_t * svn_ra_dav__do_checkout(void *session_baton,
           this_baton = root_baton;
         }
 
-      SVN_ERR (svn_ra_dav__get_props_resource(&rsrc,
-                                              ras->sess,
-                                              url,
-                                              NULL,
-                                              NULL,
-                                              subpool));
-      add_props(rsrc, editor->change_dir_prop, this_baton, subpool);
-
       /* finished processing the directory. clear out the gunk. */
       svn_pool_clear(subpool);
 
@@ -1003,8 +1269,14 @@ svn_error_t * svn_ra_dav__do_checkout(void *session_baton,
       subdir->parent_baton = this_baton;
       PUSH_SUBDIR(subdirs, subdir);
 
-      err = fetch_dirents(ras, url, this_baton, recurse, subdirs, files,
-                          editor->change_dir_prop, &vuh, ras->pool);
+      /* one depth-1 PROPFIND does it all: the entries to recurse into,
+         plus this directory's own properties and version URL.  (We used
+         to ask for the directory's properties with an extra depth-0
+         PROPFIND first, costing a round trip per directory.)  And when
+         the deep PROPFIND above succeeded, even that round trip is
+         already paid for. */
+      err = fetch_dirents(ras, url, subtree, this_baton, recurse, subdirs,
+                          files, editor->change_dir_prop, &vuh, ras->pool);
       if (err)
         return svn_error_quick_wrap(err, "could not fetch directory entries");
 
@@ -1024,7 +1296,7 @@ svn_error_t * svn_ra_dav__do_checkout(void *session_baton,
 
           /* ### should we close the dir batons first? */
           SVN_ERR_W( fetch_file(ras->sess, rsrc, this_baton, &vuh, editor,
-                                subpool),
+                                &ras->stats.bytes_received, subpool),
                      "could not checkout a file");
 
           /* trash the per-file stuff. */
@@ -1062,7 +1334,7 @@ svn_error_t *svn_ra_dav__get_latest_revnum(void *session_baton,
   /* we don't need any of the baseline URLs and stuff, but this does
      give us the latest revision number */
   SVN_ERR( svn_ra_dav__get_baseline_info(NULL, NULL, NULL, latest_revnum,
-                                         ras->sess, ras->root.path,
+                                         ras, ras->root.path,
                                          SVN_INVALID_REVNUM, ras->pool) );
 
   SVN_ERR( svn_ra_dav__maybe_store_auth_info(ras) );
@@ -1156,6 +1428,7 @@ static int validate_element(void *userdata,
     case ELEM_open_file:
       if (child == ELEM_checked_in
           || child == ELEM_fetch_file
+          || child == ELEM_txdelta
           || child == ELEM_prop
           || child == ELEM_fetch_props
           || child == ELEM_remove_prop)
@@ -1165,6 +1438,7 @@ static int validate_element(void *userdata,
 
     case ELEM_add_file:
       if (child == ELEM_checked_in
+          || child == ELEM_txdelta
           || child == ELEM_prop)
         return NE_XML_VALID;
       else
@@ -1200,13 +1474,15 @@ static const char *get_attr(const char **atts, const char *which)
   return NULL;
 }
 
-static void push_dir(report_baton_t *rb, void *baton, svn_stringbuf_t *pathbuf)
+static void push_dir(report_baton_t *rb, void *baton, svn_stringbuf_t *pathbuf,
+                     apr_pool_t *pool)
 {
   dir_item_t *di = (dir_item_t *)apr_array_push(rb->dirs);
 
   memset(di, 0, sizeof(*di));
   di->baton = baton;
   di->pathbuf = pathbuf;
+  di->pool = pool;
 }
 
 
@@ -1223,6 +1499,7 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
   dir_item_t *parent_dir;
   void *new_dir_baton;
   svn_stringbuf_t *pathbuf;
+  apr_pool_t *subpool;
 
   switch (elm->id)
     {
@@ -1240,7 +1517,10 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
       base = SVN_STR_TO_REV(att);
       if (rb->dirs->nelts == 0)
         {
-          pathbuf = svn_stringbuf_create(".", rb->ras->pool);
+          /* Each open directory gets a subpool of its parent's; closing
+             the directory tosses it. */
+          subpool = svn_pool_create(rb->ras->pool);
+          pathbuf = svn_stringbuf_create(".", subpool);
           CHKERR( (*rb->editor->open_root)(rb->edit_baton, base,
                                          &new_dir_baton) );
         }
@@ -1252,7 +1532,8 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
 
           parent_dir = &TOP_DIR(rb);
 
-          pathbuf = svn_stringbuf_dup(parent_dir->pathbuf, rb->ras->pool);
+          subpool = svn_pool_create(parent_dir->pool);
+          pathbuf = svn_stringbuf_dup(parent_dir->pathbuf, subpool);
           svn_path_add_component(pathbuf, rb->namestr);
 
           CHKERR( (*rb->editor->open_directory)(rb->namestr,
@@ -1261,7 +1542,7 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
         }
 
       /* push the new baton onto the directory baton stack */
-      push_dir(rb, new_dir_baton, pathbuf);
+      push_dir(rb, new_dir_baton, pathbuf, subpool);
 
       /* Property fetching is NOT implied in replacement. */
       TOP_DIR(rb).fetch_props = FALSE;
@@ -1285,14 +1566,15 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
 
       parent_dir = &TOP_DIR(rb);
 
-      pathbuf = svn_stringbuf_dup(parent_dir->pathbuf, rb->ras->pool);
+      subpool = svn_pool_create(parent_dir->pool);
+      pathbuf = svn_stringbuf_dup(parent_dir->pathbuf, subpool);
       svn_path_add_component(pathbuf, rb->namestr);
 
       CHKERR( (*rb->editor->add_directory)(rb->namestr, parent_dir->baton,
                                            cpath, crev, &new_dir_baton) );
 
       /* push the new baton onto the directory baton stack */
-      push_dir(rb, new_dir_baton, pathbuf);
+      push_dir(rb, new_dir_baton, pathbuf, subpool);
 
       /* Property fetching is implied in addition. */
       TOP_DIR(rb).fetch_props = TRUE;
@@ -1391,7 +1673,8 @@ static int start_element(void *userdata, const struct ne_xml_elm *elm,
                                 rb->file_baton, rb->editor,
                                 rb->ras->callbacks->get_wc_prop,
                                 rb->ras->callback_baton,
-                                rb->ras->pool) );
+                                &rb->ras->stats.bytes_received,
+                                rb->scratch) );
       break;
 
     case ELEM_delete_entry:
@@ -1432,11 +1715,11 @@ add_node_props (report_baton_t *rb)
                                               rb->href->data,
                                               NULL,
                                               NULL,
-                                              rb->ras->pool));
-      add_props(rsrc, 
-                rb->editor->change_file_prop, 
+                                              rb->scratch));
+      add_props(rsrc,
+                rb->editor->change_file_prop,
                 rb->file_baton,
-                rb->ras->pool);
+                rb->scratch);
     }
   else
     {
@@ -1449,11 +1732,11 @@ add_node_props (report_baton_t *rb)
                                               TOP_DIR(rb).vsn_url,
                                               NULL,
                                               NULL,
-                                              rb->ras->pool));
-      add_props(rsrc, 
-                rb->editor->change_dir_prop, 
-                TOP_DIR(rb).baton, 
-                rb->ras->pool);
+                                              rb->scratch));
+      add_props(rsrc,
+                rb->editor->change_dir_prop,
+                TOP_DIR(rb).baton,
+                rb->scratch);
     }
     
   return SVN_NO_ERROR;
@@ -1476,28 +1759,44 @@ static int end_element(void *userdata,
       /* fetch node props as necessary. */
       CHKERR( add_node_props (rb) );
 
-      /* close the topmost directory, and pop it from the stack */
+      /* close the topmost directory, and pop it from the stack. the
+         directory is finished, so everything we allocated for it can go. */
       CHKERR( (*rb->editor->close_directory)(TOP_DIR(rb).baton) );
+      svn_pool_destroy(TOP_DIR(rb).pool);
       --rb->dirs->nelts;
+      svn_pool_clear(rb->scratch);
       break;
 
     case ELEM_add_file:
       /* we wait until the close element to do the work. this allows us to
          retrieve the href before fetching. */
 
-      /* fetch file */
-      CHKERR( simple_fetch_file(rb->ras->sess2, rb->href->data,
-                                TOP_DIR(rb).pathbuf->data,
-                                rb->fetch_content,
-                                rb->file_baton, rb->editor,
-                                rb->ras->callbacks->get_wc_prop,
-                                rb->ras->callback_baton,
-                                rb->ras->pool) );
+      /* fetch file, unless an inline delta already carried its contents */
+      if (rb->whandler == NULL)
+        CHKERR( simple_fetch_file(rb->ras->sess2, rb->href->data,
+                                  TOP_DIR(rb).pathbuf->data,
+                                  rb->fetch_content,
+                                  rb->file_baton, rb->editor,
+                                  rb->ras->callbacks->get_wc_prop,
+                                  rb->ras->callback_baton,
+                                  &rb->ras->stats.bytes_received,
+                                  rb->scratch) );
 
 
       /*** FALLTHRU ***/
 
     case ELEM_open_file:
+      /* wrap up the inline delta, if the server sent one. closing the
+         decoder flushes any base64 remainder, checks that the svndiff
+         stream was complete, and sends the final NULL window. */
+      if (rb->whandler != NULL)
+        {
+          CHKERR( svn_stream_close(rb->svndiff_decoder) );
+          rb->whandler = NULL;
+          rb->svndiff_decoder = NULL;
+          svn_pool_destroy(rb->delta_pool);
+        }
+
       /* fetch node props as necessary. */
       CHKERR( add_node_props (rb) );
 
@@ -1507,6 +1806,42 @@ static int end_element(void *userdata,
 
       /* Yank this file out of the directory's path buffer. */
       svn_path_remove_component(TOP_DIR(rb).pathbuf);
+
+      /* the file is finished; toss its scratch allocations. */
+      svn_pool_clear(rb->scratch);
+      break;
+
+    case ELEM_txdelta:
+      /* inline file contents: each element is a base64-encoded slice
+         of the file's svndiff stream. */
+      if (!rb->fetch_content)
+        break;
+
+      {
+        apr_size_t len;
+
+        /* the first slice for a file sets up the editor's window
+           handler and the decoding streams feeding it. the decoders
+           get their own subpool, since we clear the scratch pool per
+           slice. */
+        if (rb->whandler == NULL)
+          {
+            CHKERR( (*rb->editor->apply_textdelta)(rb->file_baton,
+                                                   &rb->whandler,
+                                                   &rb->whandler_baton) );
+            rb->delta_pool = svn_pool_create(rb->ras->pool);
+            rb->svndiff_decoder = svn_base64_decode(
+                svn_txdelta_parse_svndiff(rb->whandler, rb->whandler_baton,
+                                          TRUE, rb->delta_pool),
+                rb->delta_pool);
+          }
+
+        /* write the slice straight out of the XML parser's buffer;
+           the base64 decoder carries any partial group over to the
+           next slice, so the split points don't matter. */
+        len = strlen(cdata);
+        CHKERR( svn_stream_write(rb->svndiff_decoder, cdata, &len) );
+      }
       break;
 
     case NE_ELM_href:
@@ -1526,7 +1861,7 @@ static int end_element(void *userdata,
           /* save away the URL in case a fetch-props arrives after all of
              the subdir processing. we will need this copy of the URL to
              fetch the properties (i.e. rb->href will be toast by then). */
-          TOP_DIR(rb).vsn_url = apr_pmemdup(rb->ras->pool,
+          TOP_DIR(rb).vsn_url = apr_pmemdup(TOP_DIR(rb).pool,
                                             rb->href->data, rb->href->len + 1);
         }
       else
@@ -1542,8 +1877,8 @@ static int end_element(void *userdata,
     case ELEM_creator_displayname:
       {
         /* The name of the xml tag is the property that we want to set. */
-        svn_stringbuf_t *tagname = 
-          svn_stringbuf_create (elm->nspace, rb->ras->pool); 
+        svn_stringbuf_t *tagname =
+          svn_stringbuf_create (elm->nspace, rb->scratch);
         svn_stringbuf_appendcstr (tagname, elm->name);
 
         CHKERR( set_special_wc_prop (tagname->data, 
@@ -1554,7 +1889,7 @@ static int end_element(void *userdata,
                                       rb->file_baton ?
                                         rb->file_baton :
                                         TOP_DIR(rb).baton,
-                                      rb->ras->pool) );      
+                                      rb->scratch) );
         break;
       }
 
@@ -1656,6 +1991,11 @@ static svn_error_t * reporter_finish_report(void *report_baton)
   rb->vuh.name = svn_stringbuf_create(SVN_RA_DAV__LP_VSN_URL, rb->ras->pool);
   rb->vuh.value = MAKE_BUFFER(rb->ras->pool);
 
+  /* per-entry work happens in here; we clear it as each entry finishes,
+     so the editor drive runs in bounded memory no matter how large the
+     report is. */
+  rb->scratch = svn_pool_create(rb->ras->pool);
+
   /* Rewind the tmpfile. */
   status = apr_file_seek(rb->tmpfile, APR_SET, &offset);
   if (status)
@@ -1682,6 +2022,8 @@ static svn_error_t * reporter_finish_report(void *report_baton)
   /* we're done with the file */
   (void) apr_file_close(rb->tmpfile);
 
+  svn_pool_destroy(rb->scratch);
+
   if (err != NULL)
     return err;
   if (rb->err != NULL)
@@ -1751,9 +2093,14 @@ make_reporter (void *session_baton,
      ### will ensure that the file always gets tossed, even if we exit
      ### with an error. */
 
-  /* prep the file */
-  status = apr_file_write_full(rb->tmpfile,
-                               report_head, sizeof(report_head) - 1, NULL);
+  /* prep the file. ask for inline deltas only when we mean to fetch
+     contents at all; a status run would just throw them away. */
+  if (fetch_content)
+    status = apr_file_write_full(rb->tmpfile, report_head_send_all,
+                                 sizeof(report_head_send_all) - 1, NULL);
+  else
+    status = apr_file_write_full(rb->tmpfile,
+                                 report_head, sizeof(report_head) - 1, NULL);
   if (status)
     {
       msg = "Could not write the header for the temporary report file.";
@@ -216,6 +216,7 @@ svn_error_t * svn_ra_dav__get_log(void *session_baton,
                                   svn_revnum_t start,
                                   svn_revnum_t end,
                                   svn_boolean_t discover_changed_paths,
+                                  int limit,
                                   svn_log_message_receiver_t receiver,
                                   void *receiver_baton)
 {
@@ -234,6 +235,7 @@ svn_error_t * svn_ra_dav__get_log(void *session_baton,
   svn_ra_session_t *ras = session_baton;
   svn_stringbuf_t *request_body = svn_stringbuf_create("", ras->pool);
   struct log_baton lb;
+  svn_error_t *err;
 
   /* ### todo: I don't understand why the static, file-global
      variables shared by update and status are called `report_head'
@@ -276,7 +278,15 @@ svn_error_t * svn_ra_dav__get_log(void *session_baton,
                                apr_psprintf(ras->pool,
                                             "<S:discover-changed-paths/>"));
     }
-    
+  if (limit > 0)
+    {
+      /* Older servers simply skip elements they don't know, so this
+         degrades to an unbounded log against them. */
+      svn_stringbuf_appendcstr(request_body,
+                               apr_psprintf(ras->pool,
+                                            "<S:limit>%d</S:limit>", limit));
+    }
+
   for (i = 0; i < paths->nelts; i++)
     {
       const char *this_path = (((svn_stringbuf_t **)paths->elts)[i])->data;
@@ -292,24 +302,38 @@ svn_error_t * svn_ra_dav__get_log(void *session_baton,
 
   lb.receiver = receiver;
   lb.receiver_baton = receiver_baton;
+  lb.err = SVN_NO_ERROR;
   lb.subpool = svn_pool_create (ras->pool);
   reset_log_item (&lb);
 
-  SVN_ERR( svn_ra_dav__parsed_request(ras,
-                                      "REPORT",
-                                      ras->root.path,
-                                      request_body->data,
-                                      0,  /* ignored */
-                                      log_report_elements, 
-                                      log_validate,
-                                      log_start_element,
-                                      log_end_element,
-                                      &lb,
-                                      ras->pool) );
-  
+  /* The items stream: log_end_element invokes RECEIVER as each
+     log-item closes and recycles the subpool behind it, so memory
+     stays flat no matter how long the revision range is. */
+  err = svn_ra_dav__parsed_request(ras,
+                                   "REPORT",
+                                   ras->root.path,
+                                   request_body->data,
+                                   0,  /* ignored */
+                                   log_report_elements,
+                                   log_validate,
+                                   log_start_element,
+                                   log_end_element,
+                                   &lb,
+                                   ras->pool);
+
   svn_pool_destroy (lb.subpool);
 
-  return SVN_NO_ERROR;
+  if (lb.err)
+    {
+      /* The receiver failed, and aborting the parse is what made the
+         request complain; the receiver's error is the one worth
+         reporting. */
+      if (err)
+        svn_error_clear_all (err);
+      return lb.err;
+    }
+
+  return err;
 }
 
 
@@ -446,24 +446,81 @@ svn_error_t * svn_ra_dav__get_one_prop(const svn_string_t **propval,
   return SVN_NO_ERROR;
 }
 
+/* What the session's startprop_cache remembers about a public url
+   path: the results of STEP 1 of svn_ra_dav__get_baseline_info. */
+typedef struct {
+  const char *vcc;          /* version-controlled-configuration url */
+  const char *relpath;      /* baseline-relative-path (plus loppings) */
+} startprop_cache_t;
+
+/* What the session's bc_cache remembers about a revision: the results
+   of STEP 2.  A revision never changes, so these never go stale;
+   the HEAD does, so it is never cached. */
+typedef struct {
+  const char *bc_url;       /* the baseline collection */
+  const char *vsn_name;     /* its DAV:version-name, or null */
+} bc_cache_t;
+
+/* Pull DAV:baseline-collection and DAV:version-name out of RSRC, a
+   Baseline fetched with baseline_props.  The version name may
+   legitimately be absent; *VSN_NAME_P is set to null then. */
+static svn_error_t *extract_baseline_props(const char **bc_url_p,
+                                           const char **vsn_name_p,
+                                           const svn_ra_dav_resource_t *rsrc,
+                                           apr_pool_t *pool)
+{
+  *bc_url_p = apr_hash_get(rsrc->propset,
+                           SVN_RA_DAV__PROP_BASELINE_COLLECTION,
+                           APR_HASH_KEY_STRING);
+  if (*bc_url_p == NULL)
+    {
+      /* ### better error reporting... */
+      /* ### need an SVN_ERR here */
+      return svn_error_create(APR_EGENERAL, 0, NULL, pool,
+                              "DAV:baseline-collection was not present "
+                              "on the baseline resource.");
+    }
+
+  *vsn_name_p = apr_hash_get(rsrc->propset,
+                             SVN_RA_DAV__PROP_VERSION_NAME,
+                             APR_HASH_KEY_STRING);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_dav__get_baseline_info(svn_boolean_t *is_dir,
                                            svn_string_t *bc_url,
                                            svn_string_t *bc_relative,
                                            svn_revnum_t *latest_rev,
-                                           ne_session *sess,
+                                           svn_ra_session_t *ras,
                                            const char *url,
                                            svn_revnum_t revision,
                                            apr_pool_t *pool)
 {
+  ne_session *sess = ras->sess;
   svn_ra_dav_resource_t *rsrc;
-  const char *vcc;
+  const char *vcc = NULL;
+  const char *url_path;
+  const char *bc_url_str;
+  const char *vsn_name;
   struct uri parsed_url;
-  svn_string_t *my_bc_url, *my_bc_relative;
+  svn_string_t *my_bc_url, *my_bc_relative = NULL;
   const char *lopped_path = "";
+  startprop_cache_t *start;
 
   /* ### we may be able to replace some/all of this code with an
      ### expand-property REPORT when that is available on the server. */
 
+  /* Rediscovering the same baseline over and over is pure fixed
+     overhead, so the answers are cached on the session: STEP 1 keyed
+     by the public url, STEP 2 keyed by the revision.  Callers love to
+     ask several times per operation (copied files in a commit, for
+     one). */
+  if (ras->startprop_cache == NULL)
+    ras->startprop_cache = apr_hash_make(ras->pool);
+  if (ras->bc_cache == NULL)
+    ras->bc_cache = apr_hash_make(ras->pool);
+
   /* -------------------------------------------------------------------
      STEP 1
 
@@ -487,87 +544,128 @@ svn_error_t *svn_ra_dav__get_baseline_info(svn_boolean_t *is_dir,
   /* Split the url into it's component pieces (schema, host, path,
      etc).  We want the path part. */
   uri_parse (url, &parsed_url, NULL);
+  url_path = apr_pstrdup(pool, parsed_url.path);
+  uri_free(&parsed_url);
+
+  start = apr_hash_get(ras->startprop_cache, url_path, APR_HASH_KEY_STRING);
+  if (start != NULL)
+    {
+      vcc = start->vcc;
+      my_bc_relative = svn_string_create (start->relpath, pool);
+    }
+  else if (bc_relative == NULL && is_dir == NULL
+           && strcmp(url_path, ras->root.path) == 0
+           && ras->callbacks->get_wc_prop != NULL)
+    {
+      /* Only the VCC is needed here, and that one never moves: an
+         earlier session may have left it in the working copy for us. */
+      const svn_string_t *value;
+
+      SVN_ERR( (*ras->callbacks->get_wc_prop)(ras->callback_baton, "",
+                                              SVN_RA_DAV__LP_VCC_URL,
+                                              &value, pool) );
+      if (value != NULL)
+        vcc = value->data;
+    }
 
   /* ### do we want to optimize the props we fetch, based on what the
      ### user has requested? i.e. omit resourcetype when is_dir is NULL
      ### and omit relpath when bc_relative is NULL. */
 
-  {
-    /* Try to get the starting_props from the public url.  If the
-       resource no longer exists in HEAD, we'll get a failure.  That's
-       fine: just keep removing components and trying to get the
-       starting_props from parent directories. */
-    svn_error_t *err;
-    svn_stringbuf_t *path_s = svn_stringbuf_create (parsed_url.path, pool);
-
-    while (! svn_path_is_empty (path_s))
-      {
-        err = svn_ra_dav__get_props_resource(&rsrc, sess, path_s->data,
-                                             NULL, starting_props, pool);
-        if (! err)
-          break;   /* found an existing parent! */
-
-        if (err->apr_err != SVN_ERR_RA_REQUEST_FAILED)
-          return err;  /* found a _real_ error */
-
-        /* else... lop off the basename and try again. */
-        lopped_path = svn_path_join (lopped_path,
-                                     svn_path_basename (path_s->data, pool),
-                                     pool);
-        svn_path_remove_component (path_s);
-
-      }
-
-    if (svn_path_is_empty (path_s))
-      /* entire URL was bogus;  not a single part of it exists in
-         the repository!  */
-      return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, 0, NULL, pool,
-                               "No part of path '%s' was found in"
-                               "repository HEAD.", parsed_url.path);
-  }
-
-  uri_free(&parsed_url);
-
-  vcc = apr_hash_get(rsrc->propset, SVN_RA_DAV__PROP_VCC, APR_HASH_KEY_STRING);
   if (vcc == NULL)
     {
-      /* ### better error reporting... */
+      /* Try to get the starting_props from the public url.  If the
+         resource no longer exists in HEAD, we'll get a failure.  That's
+         fine: just keep removing components and trying to get the
+         starting_props from parent directories. */
+      svn_error_t *err;
+      const char *relative_path;
+      svn_stringbuf_t *path_s = svn_stringbuf_create (url_path, pool);
+
+      while (! svn_path_is_empty (path_s))
+        {
+          err = svn_ra_dav__get_props_resource(&rsrc, sess, path_s->data,
+                                               NULL, starting_props, pool);
+          if (! err)
+            break;   /* found an existing parent! */
 
-      /* ### need an SVN_ERR here */
-      return svn_error_create(APR_EGENERAL, 0, NULL, pool,
-                              "The VCC property was not found on the "
-                              "resource.");
+          if (err->apr_err != SVN_ERR_RA_REQUEST_FAILED)
+            return err;  /* found a _real_ error */
+
+          /* else... lop off the basename and try again. */
+          lopped_path = svn_path_join (lopped_path,
+                                       svn_path_basename (path_s->data, pool),
+                                       pool);
+          svn_path_remove_component (path_s);
+
+        }
+
+      if (svn_path_is_empty (path_s))
+        /* entire URL was bogus;  not a single part of it exists in
+           the repository!  */
+        return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, 0, NULL, pool,
+                                 "No part of path '%s' was found in"
+                                 "repository HEAD.", url_path);
+
+      vcc = apr_hash_get(rsrc->propset, SVN_RA_DAV__PROP_VCC,
+                         APR_HASH_KEY_STRING);
+      if (vcc == NULL)
+        {
+          /* ### better error reporting... */
+
+          /* ### need an SVN_ERR here */
+          return svn_error_create(APR_EGENERAL, 0, NULL, pool,
+                                  "The VCC property was not found on the "
+                                  "resource.");
+        }
+
+      relative_path = apr_hash_get(rsrc->propset,
+                                   SVN_RA_DAV__PROP_BASELINE_RELPATH,
+                                   APR_HASH_KEY_STRING);
+      if (relative_path == NULL)
+        {
+          /* ### better error reporting... */
+          /* ### need an SVN_ERR here */
+          return svn_error_create(APR_EGENERAL, 0, NULL, pool,
+                                  "The relative-path property was not "
+                                  "found on the resource.");
+        }
+
+      /* Allocate our own bc_relative path.  Don't forget to tack on
+         the parts we lopped off in order to find the VCC... */
+      my_bc_relative = svn_string_create (svn_path_join (relative_path,
+                                                         lopped_path, pool),
+                                          pool);
+
+      /* remember the answers for the rest of this session... */
+      start = apr_palloc(ras->pool, sizeof(*start));
+      start->vcc = apr_pstrdup(ras->pool, vcc);
+      start->relpath = apr_pstrdup(ras->pool, my_bc_relative->data);
+      apr_hash_set(ras->startprop_cache,
+                   apr_pstrdup(ras->pool, url_path),
+                   APR_HASH_KEY_STRING, start);
+
+      /* ...and leave the (stable) VCC in the working copy for the
+         sessions after it. */
+      if (strcmp(url_path, ras->root.path) == 0
+          && ras->callbacks->set_wc_prop != NULL)
+        {
+          svn_string_t value;
+
+          value.data = vcc;
+          value.len = strlen(vcc);
+          SVN_ERR( (*ras->callbacks->set_wc_prop)(ras->callback_baton, "",
+                                                  SVN_RA_DAV__LP_VCC_URL,
+                                                  &value, pool) );
+        }
     }
 
-  /* Allocate our own bc_relative path. */
-  my_bc_relative = svn_string_create ("", pool);
-  {
-    const char *relative_path;
-    
-    relative_path = apr_hash_get(rsrc->propset,
-                                 SVN_RA_DAV__PROP_BASELINE_RELPATH,
-                                 APR_HASH_KEY_STRING);
-    if (relative_path == NULL)
-      {
-        /* ### better error reporting... */        
-        /* ### need an SVN_ERR here */
-        return svn_error_create(APR_EGENERAL, 0, NULL, pool,
-                                "The relative-path property was not "
-                                "found on the resource.");
-      }
-    
-    /* don't forget to tack on the parts we lopped off in order
-       to find the VCC... */
-    my_bc_relative->data = svn_path_join (relative_path, lopped_path, pool);
-    my_bc_relative->len = strlen(my_bc_relative->data);
-  }
- 
   /* if they want the relative path (could be, they're just trying to find
      the baseline collection), then return it */
   if (bc_relative != NULL)
     {
       bc_relative->data = my_bc_relative->data;
-      bc_relative->len = my_bc_relative->len;     
+      bc_relative->len = my_bc_relative->len;
     }
 
   /* shortcut: no need to do more work if the data isn't needed. */
@@ -612,59 +710,61 @@ svn_error_t *svn_ra_dav__get_baseline_info(svn_boolean_t *is_dir,
 
       /* ### do we want to optimize the props we fetch, based on what the
          ### user asked for? i.e. omit version-name if latest_rev is NULL */
-      SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, sess, 
+      SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, sess,
                                               baseline->data, NULL,
                                               baseline_props, pool) );
+
+      SVN_ERR( extract_baseline_props(&bc_url_str, &vsn_name, rsrc, pool) );
     }
   else
     {
       /* Fetch a specific revision */
 
+      bc_cache_t *bc;
       char label[20];
 
       /* ### send Label hdr, get DAV:baseline-collection [from the baseline] */
 
       apr_snprintf(label, sizeof(label), "%ld", revision);
 
-      /* ### do we want to optimize the props we fetch, based on what the
-         ### user asked for? i.e. omit version-name if latest_rev is NULL */
-      SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, sess, vcc, label,
-                                              baseline_props, pool) );
+      bc = apr_hash_get(ras->bc_cache, label, APR_HASH_KEY_STRING);
+      if (bc == NULL)
+        {
+          /* ### do we want to optimize the props we fetch, based on what
+             ### the user asked for? i.e. omit version-name if latest_rev
+             ### is NULL */
+          SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, sess, vcc, label,
+                                                  baseline_props, pool) );
+
+          SVN_ERR( extract_baseline_props(&bc_url_str, &vsn_name,
+                                          rsrc, pool) );
+
+          bc = apr_palloc(ras->pool, sizeof(*bc));
+          bc->bc_url = apr_pstrdup(ras->pool, bc_url_str);
+          bc->vsn_name = vsn_name ? apr_pstrdup(ras->pool, vsn_name) : NULL;
+          apr_hash_set(ras->bc_cache, apr_pstrdup(ras->pool, label),
+                       APR_HASH_KEY_STRING, bc);
+        }
+
+      bc_url_str = bc->bc_url;
+      vsn_name = bc->vsn_name;
     }
 
-  /* rsrc now points at the Baseline. We will checkout from the
-     DAV:baseline-collection.  The revision we are checking out is in
-     DAV:version-name */
-  
+  /* We will checkout from the DAV:baseline-collection.  The revision
+     we are checking out is in DAV:version-name */
+
   /* Allocate our own copy of bc_url regardless. */
-  my_bc_url = svn_string_create ("", pool);
-  my_bc_url->data = apr_hash_get(rsrc->propset,
-                                 SVN_RA_DAV__PROP_BASELINE_COLLECTION,
-                                 APR_HASH_KEY_STRING);
-  if (my_bc_url->data == NULL)
-    {
-      /* ### better error reporting... */
-      /* ### need an SVN_ERR here */
-      return svn_error_create(APR_EGENERAL, 0, NULL, pool,
-                              "DAV:baseline-collection was not present "
-                              "on the baseline resource.");
-    }
-  my_bc_url->len = strlen(my_bc_url->data);
+  my_bc_url = svn_string_create (bc_url_str, pool);
 
   /* maybe return bc_url to the caller */
   if (bc_url != NULL)
     {
       bc_url->data = my_bc_url->data;
-      bc_url->len = my_bc_url->len;     
-    }  
+      bc_url->len = my_bc_url->len;
+    }
 
   if (latest_rev != NULL)
     {
-      const char *vsn_name;
-
-      vsn_name = apr_hash_get(rsrc->propset,
-                              SVN_RA_DAV__PROP_VERSION_NAME,
-                              APR_HASH_KEY_STRING);
       if (vsn_name == NULL)
         {
           /* ### better error reporting... */
@@ -685,7 +785,7 @@ svn_error_t *svn_ra_dav__get_baseline_info(svn_boolean_t *is_dir,
                                         pool);
       SVN_ERR( svn_ra_dav__get_props_resource(&rsrc, sess, full_bc_url,
                                               NULL, starting_props, pool));
-      
+
       *is_dir = rsrc->is_collection;
     }
 
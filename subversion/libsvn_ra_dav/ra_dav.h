@@ -23,6 +23,9 @@
 
 #include <apr_pools.h>
 #include <apr_tables.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
 
 #include <ne_request.h>
 #include <ne_uri.h>
@@ -48,10 +51,33 @@ typedef struct {
 
   ne_session *sess;           /* HTTP session to server */
   ne_session *sess2;
-  
+
+  /* The connection-pool entry these sessions are borrowed from; see
+     session.c.  Closing the RA session parks the connections there
+     instead of destroying them. */
+  struct session_pool_entry *pool_entry;
+
   const svn_ra_callbacks_t *callbacks;  /* callbacks to get auth data */
   void *callback_baton;
 
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *auth_lock;  /* the PUT workers' sessions share the
+                                     auth callback; see session.c */
+#endif
+
+  /* Session-level caches of the baseline discovery performed by
+     svn_ra_dav__get_baseline_info(); see props.c.  Created on first
+     use, entries allocated in POOL. */
+  apr_hash_t *startprop_cache;  /* public url path -> vcc/relpath pair */
+  apr_hash_t *bc_cache;         /* revision (as text) -> baseline
+                                   collection info */
+
+  /* Wire-level transfer statistics, accumulated across every neon
+     session owned by this RA session (sess, sess2, and any PUT worker
+     sessions).  The workers bump these without locking, so under a
+     parallel commit the counts are approximate; see session.c. */
+  svn_ra_stats_t stats;
+
 } svn_ra_session_t;
 
 
@@ -88,6 +114,14 @@ svn_error_t * svn_ra_dav__get_file(
   svn_revnum_t *fetched_rev,
   apr_hash_t **props);
 
+svn_error_t * svn_ra_dav__get_files(
+  void *session_baton,
+  const apr_array_header_t *paths,
+  svn_revnum_t revision,
+  svn_boolean_t want_props,
+  svn_ra_file_receiver_t receiver,
+  void *receiver_baton);
+
 svn_error_t * svn_ra_dav__abort_commit(
  void *session_baton,
  void *edit_baton);
@@ -135,6 +169,7 @@ svn_error_t * svn_ra_dav__get_log(
   svn_revnum_t start,
   svn_revnum_t end,
   svn_boolean_t discover_changed_paths,
+  int limit,
   svn_log_message_receiver_t receiver,
   void *receiver_baton);
 
@@ -160,6 +195,10 @@ svn_error_t *svn_ra_dav__do_check_path(
 /* store the URL of the version resource (from the DAV:checked-in property) */
 #define SVN_RA_DAV__LP_VSN_URL          SVN_RA_DAV__LP_NAMESPACE "version-url"
 
+/* store the URL of the version-controlled configuration (it never moves,
+   so later sessions can skip rediscovering it) */
+#define SVN_RA_DAV__LP_VCC_URL          SVN_RA_DAV__LP_NAMESPACE "vcc-url"
+
 
 /*
 ** SVN_RA_DAV__PROP_*: properties that we fetch from the server
@@ -224,7 +263,7 @@ svn_error_t * svn_ra_dav__get_one_prop(const svn_string_t **propval,
 
 /* Get various Baseline-related information for a given "public" URL.
 
-   Given a Neon session SESS and a URL, return whether the URL is a
+   Given a session RAS and a URL, return whether the URL is a
    directory in *IS_DIR.  IS_DIR may be NULL if this flag is unneeded.
 
    REVISION may be SVN_INVALID_REVNUM to indicate that the operation
@@ -249,12 +288,15 @@ svn_error_t * svn_ra_dav__get_one_prop(const svn_string_t **propval,
    Note: a Baseline Collection is a complete tree for a specified Baseline.
    DeltaV baselines correspond one-to-one to Subversion revisions. Thus,
    the entire state of a revision can be found in a Baseline Collection.
+
+   Discovery results are cached on RAS, so asking again about a URL or
+   a specific revision costs no round trips.
 */
 svn_error_t *svn_ra_dav__get_baseline_info(svn_boolean_t *is_dir,
                                            svn_string_t *bc_url,
                                            svn_string_t *bc_relative,
                                            svn_revnum_t *latest_rev,
-                                           ne_session *sess,
+                                           svn_ra_session_t *ras,
                                            const char *url,
                                            svn_revnum_t revision,
                                            apr_pool_t *pool);
@@ -335,6 +377,7 @@ enum {
   ELEM_open_directory,
   ELEM_open_file,
   ELEM_target_revision,
+  ELEM_txdelta,       /* inline file delta in an update report */
   ELEM_update_report,
   ELEM_prop,
   ELEM_name_version_name,
@@ -372,6 +415,15 @@ svn_error_t *
 svn_ra_dav__maybe_store_auth_info (svn_ra_session_t *ras);
 
 
+/* Set *SESS_P to another connection to RAS's server, wired up the
+   same way as RAS->sess: proxy, ssl, auth callback, user-agent, and
+   a cleanup registered on POOL.  The commit editor's PUT workers use
+   these to upload in parallel. */
+svn_error_t *svn_ra_dav__spawn_session(ne_session **sess_p,
+                                       svn_ra_session_t *ras,
+                                       apr_pool_t *pool);
+
+
 /* Create an error object for an error from neon in the given session,
    where the return code from neon was RETCODE, and CONTEXT describes
    what was being attempted. */
@@ -399,6 +451,34 @@ svn_ra_dav__request_dispatch(int *code,
                              apr_pool_t *pool);
 
 
+/* An opaque gzip decoder for response bodies, created by
+   svn_ra_dav__gzip_response(). */
+typedef struct svn_ra_dav__gzip_t svn_ra_dav__gzip_t;
+
+/* Invite the server to gzip the response body of REQUEST, and arrange
+   for READER to see the decoded bytes.  READER and USERDATA are hooked
+   up exactly as ne_add_response_body_reader() would hook them with the
+   ne_accept_2xx accepter; if the server sends the body plain, the
+   bytes simply pass straight through.  The decoder lives in POOL.
+
+   If RECEIVED is non-null, the size of the body as it came off the
+   wire -- the compressed size, when the server did compress -- is
+   added to *RECEIVED as the response arrives.
+
+   (Without zlib this just registers READER and returns NULL, which
+   svn_ra_dav__gzip_error() accepts.) */
+svn_ra_dav__gzip_t *svn_ra_dav__gzip_response(ne_request *request,
+                                              ne_block_reader reader,
+                                              void *userdata,
+                                              apr_off_t *received,
+                                              apr_pool_t *pool);
+
+/* Return the error GZIP ran into -- a corrupt or truncated compressed
+   body -- or SVN_NO_ERROR.  Call this after dispatching the request;
+   when it returns an error, whatever the reader received is suspect. */
+svn_error_t *svn_ra_dav__gzip_error(svn_ra_dav__gzip_t *gzip);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
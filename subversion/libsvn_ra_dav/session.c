@@ -46,6 +46,60 @@ static apr_status_t cleanup_session(void *sess)
 }
 
 
+/* Wire accounting, via neon's request hooks.  One of these batons is
+   attached to each neon session we create; a single neon session runs
+   one request at a time, so the start timestamp needs no locking.
+   The PUT workers' sessions all point at the same RAS, though, and
+   bump its counters unlocked -- under a parallel commit the totals
+   are close, not exact. */
+typedef struct {
+  svn_ra_session_t *ras;
+  apr_time_t request_start;
+} stats_hook_baton;
+
+
+/* An ne_pre_send_fn: count the request and its header bytes, and note
+   when it hit the wire.  (Bodies are counted where they are attached,
+   since neon does not show them to this hook.) */
+static void stats_pre_send(void *userdata, ne_buffer *header)
+{
+  stats_hook_baton *shb = userdata;
+
+  shb->ras->stats.requests++;
+  shb->ras->stats.bytes_sent += ne_buffer_size(header);
+  shb->request_start = apr_time_now();
+}
+
+
+/* An ne_post_send_fn: charge the whole round trip -- send, server
+   think time, and response transfer -- to network_time. */
+static int stats_post_send(void *userdata, const ne_status *status)
+{
+  stats_hook_baton *shb = userdata;
+
+  shb->ras->stats.network_time += apr_time_now() - shb->request_start;
+  return NE_OK;
+}
+
+
+/* Hook SESS up to RAS's transfer statistics, returning the hook baton
+   so a caller can re-point it later.  The baton lives in POOL, which
+   must outlive SESS.  RAS may be null, as long as it is filled in
+   before the first request. */
+static stats_hook_baton *register_stats_hooks(svn_ra_session_t *ras,
+                                              ne_session *sess,
+                                              apr_pool_t *pool)
+{
+  stats_hook_baton *shb = apr_pcalloc(pool, sizeof(*shb));
+
+  shb->ras = ras;
+  ne_hook_pre_send(sess, stats_pre_send, shb);
+  ne_hook_post_send(sess, stats_post_send, shb);
+
+  return shb;
+}
+
+
 /* A neon-session callback to 'pull' authentication data when
    challenged.  In turn, this routine 'pulls' the data from the client
    callbacks if needed.  */
@@ -57,12 +111,19 @@ static int request_auth(void *userdata, const char *realm, int attempt,
   svn_ra_simple_password_authenticator_t *authenticator = NULL;
   svn_ra_session_t *ras = userdata;
 
-  if (attempt > 1) 
+  if (attempt > 1)
     {
       /* Only use two retries. */
       return -1;
     }
 
+#if APR_HAS_THREADS
+  /* The PUT workers' sessions share this callback, and it allocates
+     from the session pool; one challenge at a time. */
+  if (ras->auth_lock)
+    apr_thread_mutex_lock(ras->auth_lock);
+#endif
+
   /* ### my only worry is that we're not catching any svn_errors from
      get_authenticator, get_username, get_password... */
 
@@ -81,10 +142,171 @@ static int request_auth(void *userdata, const char *realm, int attempt,
   apr_cpystrn(username, uname, NE_ABUFSIZ);
   apr_cpystrn(password, pword, NE_ABUFSIZ);
 
+#if APR_HAS_THREADS
+  if (ras->auth_lock)
+    apr_thread_mutex_unlock(ras->auth_lock);
+#endif
+
   return 0;
 }
 
 
+/*** The connection pool. ***/
+
+/* A pair of neon sessions kept after svn_ra_dav__close, so a later
+   open to the same server can skip the TCP connect and SSL handshake.
+   If the server has dropped the kept-alive connection in the
+   meantime, neon reconnects transparently on the next request. */
+struct session_pool_entry {
+  const char *key;              /* where the connection goes and how it
+                                   gets there; see session_pool_key() */
+
+  ne_session *sess;             /* the two sessions an RA session uses */
+  ne_session *sess2;
+
+  /* The RA session currently borrowing the connections.  The auth and
+     stats callbacks reach it through here, so reuse only re-points
+     this (and the hook batons below) instead of re-registering the
+     callbacks -- neon hooks cannot be unregistered, and re-binding
+     the auth callback would reset neon's auth state and force a fresh
+     challenge on the reused connection. */
+  svn_ra_session_t *ras;
+  stats_hook_baton *shb;
+  stats_hook_baton *shb2;
+
+  svn_boolean_t in_use;         /* claimed by a live RA session */
+
+  struct session_pool_entry *next;
+};
+
+/* The pool itself: created on first use and never destroyed, so idle
+   connections stay available until the process exits.  The lock is
+   created together with the pool, so anything that spawns threads
+   must open a session once first. */
+static apr_pool_t *session_pool_pool = NULL;
+static struct session_pool_entry *session_pool = NULL;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *session_pool_lock = NULL;
+#endif
+
+
+/* Serialize access to the pool.  No-ops until the pool machinery
+   exists. */
+static void lock_session_pool(void)
+{
+#if APR_HAS_THREADS
+  if (session_pool_lock)
+    apr_thread_mutex_lock(session_pool_lock);
+#endif
+}
+
+static void unlock_session_pool(void)
+{
+#if APR_HAS_THREADS
+  if (session_pool_lock)
+    apr_thread_mutex_unlock(session_pool_lock);
+#endif
+}
+
+
+/* Make sure the pool machinery exists.  Allocate any error in POOL. */
+static svn_error_t *session_pool_init(apr_pool_t *pool)
+{
+  if (session_pool_pool == NULL)
+    {
+      session_pool_pool = svn_pool_create(NULL);
+
+#if APR_HAS_THREADS
+      {
+        apr_status_t apr_err
+          = apr_thread_mutex_create(&session_pool_lock,
+                                    APR_THREAD_MUTEX_DEFAULT,
+                                    session_pool_pool);
+        if (apr_err)
+          return svn_error_create(apr_err, 0, NULL, pool,
+                                  "could not create session pool mutex");
+      }
+#endif
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return the key identifying a connection: where it goes and how it
+   gets there.  (The *who* is whatever identity the client's auth
+   callbacks supply, and that is one identity per process, so it needs
+   no part in the key.)  Allocate in POOL. */
+static const char *session_pool_key(const char *scheme,
+                                    const char *host,
+                                    int port,
+                                    const char *proxy_host,
+                                    int proxy_port,
+                                    apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s://%s:%d via %s:%d",
+                      scheme, host, port,
+                      proxy_host ? proxy_host : "", proxy_port);
+}
+
+
+/* Claim an idle entry for KEY, or return null if there is none. */
+static struct session_pool_entry *session_pool_claim(const char *key)
+{
+  struct session_pool_entry *entry;
+
+  lock_session_pool();
+  for (entry = session_pool; entry; entry = entry->next)
+    if ((! entry->in_use) && (strcmp(entry->key, key) == 0))
+      {
+        entry->in_use = TRUE;
+        break;
+      }
+  unlock_session_pool();
+
+  return entry;
+}
+
+
+/* Enter a freshly created session pair into the pool, claimed, and
+   return its entry. */
+static struct session_pool_entry *
+session_pool_add(const char *key,
+                 ne_session *sess,
+                 ne_session *sess2,
+                 stats_hook_baton *shb,
+                 stats_hook_baton *shb2)
+{
+  struct session_pool_entry *entry
+    = apr_pcalloc(session_pool_pool, sizeof(*entry));
+
+  entry->key = apr_pstrdup(session_pool_pool, key);
+  entry->sess = sess;
+  entry->sess2 = sess2;
+  entry->shb = shb;
+  entry->shb2 = shb2;
+  entry->in_use = TRUE;
+
+  lock_session_pool();
+  entry->next = session_pool;
+  session_pool = entry;
+  unlock_session_pool();
+
+  return entry;
+}
+
+
+/* A neon-session callback: like request_auth, but reached through the
+   pool entry, which outlives any one RA session. */
+static int pooled_request_auth(void *userdata, const char *realm, int attempt,
+                               char *username, char *password)
+{
+  struct session_pool_entry *entry = userdata;
+
+  return request_auth(entry->ras, realm, attempt, username, password);
+}
+
+
 /* A neon-session callback to validate the SSL certificate when the CA
    is unknown or there are other SSL certificate problems. */
 static int ssl_set_verify_callback(void *userdata, int failures,
@@ -307,6 +529,65 @@ static int proxy_auth(void *userdata,
  * call and make this halfway sane. */
 
 
+svn_error_t *svn_ra_dav__spawn_session(ne_session **sess_p,
+                                       svn_ra_session_t *ras,
+                                       apr_pool_t *pool)
+{
+  ne_session *sess;
+  const char *proxy_host;
+  int proxy_port;
+  const char *proxy_username;
+  const char *proxy_password;
+
+  /* RAS->root was sanity-checked (and its port defaulted) back when
+     the session was opened, so there is a lot less to do here. */
+  SVN_ERR( get_proxy(&proxy_host,
+                     &proxy_port,
+                     &proxy_username,
+                     &proxy_password,
+                     ras->root.host,
+                     pool) );
+
+  sess = ne_session_create(ras->root.scheme, ras->root.host, ras->root.port);
+
+  if (proxy_host)
+    {
+      if (proxy_port == -1)
+        proxy_port = 80;
+
+      ne_session_proxy(sess, proxy_host, proxy_port);
+
+      if (proxy_username)
+        {
+          /* Allocate the baton in pool, not on stack, so it will
+             last till whenever Neon needs it. */
+          struct proxy_auth_baton *pab = apr_palloc(pool, sizeof (*pab));
+
+          pab->username = proxy_username;
+          pab->password = proxy_password ? proxy_password : "";
+
+          ne_set_proxy_auth(sess, proxy_auth, pab);
+        }
+    }
+
+  if (strcasecmp(ras->root.scheme, "https") == 0)
+    ne_ssl_set_verify(sess, ssl_set_verify_callback, NULL);
+
+  /* make sure we will eventually destroy the session */
+  apr_pool_cleanup_register(pool, sess, cleanup_session, apr_pool_cleanup_null);
+
+  ne_set_useragent(sess, "SVN/" SVN_VERSION);
+
+  ne_set_server_auth(sess, request_auth, ras);
+
+  /* the worker's traffic counts toward the parent session's totals */
+  register_stats_hooks(ras, sess, pool);
+
+  *sess_p = sess;
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 svn_ra_dav__open (void **session_baton,
                   svn_stringbuf_t *repos_URL,
@@ -320,6 +601,12 @@ svn_ra_dav__open (void **session_baton,
   struct uri uri = { 0 };
   svn_ra_session_t *ras;
   int is_ssl_session;
+  const char *proxy_host;
+  int proxy_port;
+  const char *proxy_username;
+  const char *proxy_password;
+  const char *pool_key;
+  struct session_pool_entry *pool_entry;
 
   /* Sanity check the URI */
   if (uri_parse(repository, &uri, NULL) 
@@ -373,69 +660,97 @@ svn_ra_dav__open (void **session_baton,
       uri.port = 80;
     }
 
-  /* Create two neon session objects, and set their properties... */
-  sess = ne_session_create(uri.scheme, uri.host, uri.port);
-  sess2 = ne_session_create(uri.scheme, uri.host, uri.port);
+  SVN_ERR( session_pool_init(pool) );
 
-  /* If there's a proxy for this URL, use it. */
-  {
-    const char *proxy_host;
-    int proxy_port;
-    const char *proxy_username;
-    const char *proxy_password;
-    
-    SVN_ERR( get_proxy(&proxy_host,
-                       &proxy_port,
-                       &proxy_username,
-                       &proxy_password,
-                       uri.host,
-                       pool) );
-
-    if (proxy_port == -1)
-      proxy_port = 80;
-
-    if (proxy_host)
-      {
-        ne_session_proxy(sess, proxy_host, proxy_port);
-        ne_session_proxy(sess2, proxy_host, proxy_port);
-
-        if (proxy_username)
-          {
-            /* Allocate the baton in pool, not on stack, so it will
-               last till whenever Neon needs it. */
-            struct proxy_auth_baton *pab = apr_palloc(pool, sizeof (*pab));
-
-            pab->username = proxy_username;
-            pab->password = proxy_password ? proxy_password : "";
-        
-            ne_set_proxy_auth(sess, proxy_auth, pab);
-            ne_set_proxy_auth(sess2, proxy_auth, pab);
-          }
-      }
-  }
+  /* Look up any proxy for this URL; it configures new sessions, and
+     connections through different proxies must not be confused in the
+     pool, so it is part of the pool key as well. */
+  SVN_ERR( get_proxy(&proxy_host,
+                     &proxy_port,
+                     &proxy_username,
+                     &proxy_password,
+                     uri.host,
+                     pool) );
 
-  /* For SSL connections, when the CA certificate is not known for the
-     server certificate or the server cert has other verification
-     problems, neon will fail the connection unless we add a callback
-     to tell it to ignore the problem.  */
-  if (is_ssl_session)
+  if (proxy_port == -1)
+    proxy_port = 80;
+
+  pool_key = session_pool_key(uri.scheme, uri.host, uri.port,
+                              proxy_host, proxy_port, pool);
+
+  pool_entry = session_pool_claim(pool_key);
+  if (pool_entry)
     {
-      ne_ssl_set_verify(sess, ssl_set_verify_callback, NULL);
-      ne_ssl_set_verify(sess2, ssl_set_verify_callback, NULL);
+      /* A previous operation already talked to this server; its
+         connections are still warm, so there is no TCP connect, no
+         SSL handshake, and no fresh auth challenge to pay for. */
+      sess = pool_entry->sess;
+      sess2 = pool_entry->sess2;
     }
+  else
+    {
+      stats_hook_baton *shb, *shb2;
 
-#if 0
-  /* Turn off persistent connections. */
-  ne_set_persist(sess, 0);
-  ne_set_persist(sess2, 0);
-#endif
+      /* Create two neon session objects, and set their properties... */
+      sess = ne_session_create(uri.scheme, uri.host, uri.port);
+      sess2 = ne_session_create(uri.scheme, uri.host, uri.port);
 
-  /* make sure we will eventually destroy the session */
-  apr_pool_cleanup_register(pool, sess, cleanup_session, apr_pool_cleanup_null);
-  apr_pool_cleanup_register(pool, sess2, cleanup_session, apr_pool_cleanup_null);
+      if (proxy_host)
+        {
+          ne_session_proxy(sess, proxy_host, proxy_port);
+          ne_session_proxy(sess2, proxy_host, proxy_port);
+
+          if (proxy_username)
+            {
+              /* Allocate the baton in the pool's own pool, not on
+                 stack, so it will last as long as the sessions
+                 themselves. */
+              struct proxy_auth_baton *pab
+                = apr_palloc(session_pool_pool, sizeof (*pab));
+
+              pab->username = apr_pstrdup(session_pool_pool,
+                                          proxy_username);
+              pab->password = proxy_password
+                ? apr_pstrdup(session_pool_pool, proxy_password) : "";
+
+              ne_set_proxy_auth(sess, proxy_auth, pab);
+              ne_set_proxy_auth(sess2, proxy_auth, pab);
+            }
+        }
 
-  ne_set_useragent(sess, "SVN/" SVN_VERSION);
-  ne_set_useragent(sess2, "SVN/" SVN_VERSION);
+      /* For SSL connections, when the CA certificate is not known for
+         the server certificate or the server cert has other
+         verification problems, neon will fail the connection unless
+         we add a callback to tell it to ignore the problem.  */
+      if (is_ssl_session)
+        {
+          ne_ssl_set_verify(sess, ssl_set_verify_callback, NULL);
+          ne_ssl_set_verify(sess2, ssl_set_verify_callback, NULL);
+        }
+
+      /* neon defaults to persistent connections, but be explicit: the
+         connection pool is pointless if the connection drops between
+         operations. */
+      ne_set_persist(sess, 1);
+      ne_set_persist(sess2, 1);
+
+      ne_set_useragent(sess, "SVN/" SVN_VERSION);
+      ne_set_useragent(sess2, "SVN/" SVN_VERSION);
+
+      /* Wire up the transfer statistics; the hook batons get pointed
+         at the RA session below.  No pool cleanup destroys these
+         sessions -- they are deliberately kept open, parked in the
+         connection pool, until the process exits. */
+      shb = register_stats_hooks(NULL, sess, session_pool_pool);
+      shb2 = register_stats_hooks(NULL, sess2, session_pool_pool);
+
+      pool_entry = session_pool_add(pool_key, sess, sess2, shb, shb2);
+
+      /* Register the authentication 'pull' callback, routed through
+         the pool entry so reuse does not disturb neon's auth state. */
+      ne_set_server_auth(sess, pooled_request_auth, pool_entry);
+      ne_set_server_auth(sess2, pooled_request_auth, pool_entry);
+    }
 
   /* clean up trailing slashes from the URL */
   len = strlen(uri.path);
@@ -452,13 +767,31 @@ svn_ra_dav__open (void **session_baton,
   ras->callbacks = callbacks;
   ras->callback_baton = callback_baton;
 
+#if APR_HAS_THREADS
+  {
+    /* The commit editor's PUT workers may spawn more sessions sharing
+       the auth callback below; the lock keeps their challenges from
+       trampling each other. */
+    apr_status_t apr_err = apr_thread_mutex_create(&ras->auth_lock,
+                                                   APR_THREAD_MUTEX_DEFAULT,
+                                                   pool);
+    if (apr_err)
+      return svn_error_create(apr_err, 0, NULL, pool,
+                              "could not create auth mutex");
+  }
+#endif
+
   /* note that ras->username and ras->password are still NULL at this
      point. */
 
 
-  /* Register an authentication 'pull' callback with the neon sessions */
-  ne_set_server_auth(sess, request_auth, ras);
-  ne_set_server_auth(sess2, request_auth, ras);
+  /* Point the pool entry's callbacks at this RA session: auth pulls
+     and transfer statistics both reach it through the entry.  (RAS
+     was pcalloc'd, so the counters start at zero.) */
+  ras->pool_entry = pool_entry;
+  pool_entry->ras = ras;
+  pool_entry->shb->ras = ras;
+  pool_entry->shb2->ras = ras;
 
 
   *session_baton = ras;
@@ -472,11 +805,26 @@ static svn_error_t *svn_ra_dav__close (void *session_baton)
 {
   svn_ra_session_t *ras = session_baton;
 
-  (void) apr_pool_cleanup_run(ras->pool, ras->sess, cleanup_session);
-  (void) apr_pool_cleanup_run(ras->pool, ras->sess2, cleanup_session);
+  /* Don't tear the connections down; park them in the pool, where the
+     next open to this server will find them still warm. */
+  lock_session_pool();
+  ras->pool_entry->in_use = FALSE;
+  unlock_session_pool();
+
   return NULL;
 }
 
+
+static svn_error_t *svn_ra_dav__get_stats (void *session_baton,
+                                           svn_ra_stats_t *stats)
+{
+  svn_ra_session_t *ras = session_baton;
+
+  *stats = ras->stats;
+  return SVN_NO_ERROR;
+}
+
+
 static const svn_ra_plugin_t dav_plugin = {
   "ra_dav",
   "Module for accessing a repository via WebDAV (DeltaV) protocol.",
@@ -486,13 +834,15 @@ static const svn_ra_plugin_t dav_plugin = {
   svn_ra_dav__get_dated_revision,
   svn_ra_dav__get_commit_editor,
   svn_ra_dav__get_file,
+  svn_ra_dav__get_files,
   svn_ra_dav__do_checkout,
   svn_ra_dav__do_update,
   svn_ra_dav__do_switch,
   svn_ra_dav__do_status,
   NULL,
   svn_ra_dav__get_log,
-  svn_ra_dav__do_check_path
+  svn_ra_dav__do_check_path,
+  svn_ra_dav__get_stats
 };
 
 svn_error_t *svn_ra_dav_init(int abi_version,
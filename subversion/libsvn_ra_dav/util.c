@@ -16,6 +16,7 @@
  * ====================================================================
  */
 
+#define APR_WANT_MEMFUNC
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
 
@@ -23,6 +24,11 @@
 
 #include "svn_string.h"
 #include "svn_xml.h"
+#include "svn_private_config.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #include "ra_dav.h"
 
@@ -207,6 +213,408 @@ static int end_err_element(void *userdata, const struct ne_xml_elm *elm,
 
 
 
+/** Compressed response bodies **/
+
+#ifdef HAVE_LIBZ
+
+/* States for the streaming gzip decoder.  RFC 1952 framing: a fixed
+   ten byte header, some optional fields, the raw deflate data, then
+   an eight byte trailer holding a CRC and the inflated length. */
+enum {
+  GZ_START,                     /* haven't looked at the headers yet */
+  GZ_PASS,                      /* response is not gzipped; pass through */
+  GZ_HEADER,                    /* reading the fixed header */
+  GZ_XLEN,                      /* reading the "extra" field length */
+  GZ_EXTRA,                     /* skipping the "extra" field */
+  GZ_NAME,                      /* skipping the original file name */
+  GZ_COMMENT,                   /* skipping the comment field */
+  GZ_HCRC,                      /* skipping the header CRC */
+  GZ_BODY,                      /* inflating the deflate data */
+  GZ_TRAILER,                   /* reading the trailer */
+  GZ_DONE                       /* trailer verified; expect nothing more */
+};
+
+/* Flag bits from the FLG byte of the member header. */
+#define GZ_FHCRC    0x02
+#define GZ_FEXTRA   0x04
+#define GZ_FNAME    0x08
+#define GZ_FCOMMENT 0x10
+
+/* How much inflated data to build up before handing it onward. */
+#define GZ_BUFSIZE 16384
+
+struct svn_ra_dav__gzip_t {
+  ne_block_reader reader;       /* the reader the caller wanted */
+  void *userdata;               /* ... and its baton */
+
+  apr_off_t *received;          /* if non-null, tally of wire bytes */
+
+  apr_pool_t *pool;             /* where to allocate an error */
+  svn_error_t *err;             /* a corrupt or truncated stream */
+
+  char *encoding;               /* the Content-Encoding response header */
+  int mode;                     /* one of the GZ_* states */
+  int flags;                    /* optional fields still to be skipped */
+  apr_size_t count;             /* bytes consumed in the current state */
+  apr_size_t extra_len;         /* length of the "extra" field */
+  unsigned char head[10];       /* collects the member header */
+  unsigned char tail[8];        /* collects the member trailer */
+
+  z_stream zstr;                /* inflate state, live only in GZ_BODY */
+  int zstr_live;
+  uLong crc;                    /* running CRC of the inflated bytes */
+  uLong total;                  /* number of inflated bytes */
+};
+
+
+/* An APR pool cleanup: release whatever the decoder still holds. */
+static apr_status_t gzip_cleanup(void *baton)
+{
+  svn_ra_dav__gzip_t *gz = baton;
+
+  if (gz->zstr_live)
+    inflateEnd(&gz->zstr);
+  if (gz->encoding != NULL)
+    free(gz->encoding);
+  return APR_SUCCESS;
+}
+
+
+/* Enter the state after part of the member header has been consumed:
+   the optional fields named in GZ->flags, in their defined order, and
+   then the deflate data itself. */
+static void gzip_next_field(svn_ra_dav__gzip_t *gz)
+{
+  gz->count = 0;
+  if (gz->flags & GZ_FEXTRA)
+    {
+      gz->flags &= ~GZ_FEXTRA;
+      gz->mode = GZ_XLEN;
+    }
+  else if (gz->flags & GZ_FNAME)
+    {
+      gz->flags &= ~GZ_FNAME;
+      gz->mode = GZ_NAME;
+    }
+  else if (gz->flags & GZ_FCOMMENT)
+    {
+      gz->flags &= ~GZ_FCOMMENT;
+      gz->mode = GZ_COMMENT;
+    }
+  else if (gz->flags & GZ_FHCRC)
+    {
+      gz->flags &= ~GZ_FHCRC;
+      gz->mode = GZ_HCRC;
+    }
+  else
+    {
+      /* a negative window size tells zlib the data is raw deflate,
+         without the zlib wrapper -- gzip supplies its own framing. */
+      memset(&gz->zstr, 0, sizeof(gz->zstr));
+      if (inflateInit2(&gz->zstr, -MAX_WBITS) != Z_OK)
+        {
+          gz->err = svn_error_create(SVN_ERR_RA_REQUEST_FAILED, 0, NULL,
+                                     gz->pool,
+                                     "could not initialize zlib to "
+                                     "decompress the response");
+          return;
+        }
+      gz->zstr_live = 1;
+      gz->mode = GZ_BODY;
+    }
+}
+
+
+/* An ne_block_reader: inflate a gzipped response body, handing the
+   result to the real reader.  A response that arrives uncompressed
+   passes straight through. */
+static void gzip_reader(void *userdata, const char *buf, size_t len)
+{
+  svn_ra_dav__gzip_t *gz = userdata;
+
+  /* account for the bytes as they came off the wire, i.e. before any
+     decompression inflates them. */
+  if (gz->received != NULL)
+    *gz->received += len;
+
+  if (gz->err)
+    return;
+
+  if (gz->mode == GZ_START)
+    gz->mode = (gz->encoding != NULL
+                && strcasecmp(gz->encoding, "gzip") == 0)
+      ? GZ_HEADER : GZ_PASS;
+
+  if (gz->mode == GZ_PASS)
+    {
+      (*gz->reader)(gz->userdata, buf, len);
+      return;
+    }
+
+  if (len == 0)
+    {
+      /* end of the response: the gzip stream must have ended, too. */
+      if (gz->mode != GZ_DONE)
+        gz->err = svn_error_create(SVN_ERR_RA_REQUEST_FAILED, 0, NULL,
+                                   gz->pool,
+                                   "compressed response was truncated");
+      else
+        (*gz->reader)(gz->userdata, buf, 0);
+      return;
+    }
+
+  while (len > 0)
+    {
+      switch (gz->mode)
+        {
+        case GZ_HEADER:
+          gz->head[gz->count++] = (unsigned char) *buf++;
+          len--;
+          if (gz->count == sizeof(gz->head))
+            {
+              if (gz->head[0] != 0x1f || gz->head[1] != 0x8b
+                  || gz->head[2] != Z_DEFLATED
+                  || (gz->head[3] & 0xe0) != 0)  /* reserved flag bits */
+                {
+                  gz->err = svn_error_create(SVN_ERR_RA_REQUEST_FAILED, 0,
+                                             NULL, gz->pool,
+                                             "response claimed to be "
+                                             "gzipped, but is not");
+                  return;
+                }
+              gz->flags = gz->head[3];
+              gzip_next_field(gz);
+              if (gz->err)
+                return;
+            }
+          break;
+
+        case GZ_XLEN:
+          gz->extra_len |= ((apr_size_t) (unsigned char) *buf++)
+            << (8 * gz->count++);
+          len--;
+          if (gz->count == 2)
+            {
+              if (gz->extra_len == 0)
+                {
+                  gzip_next_field(gz);
+                  if (gz->err)
+                    return;
+                }
+              else
+                {
+                  gz->count = 0;
+                  gz->mode = GZ_EXTRA;
+                }
+            }
+          break;
+
+        case GZ_EXTRA:
+          {
+            apr_size_t chunk = gz->extra_len - gz->count;
+
+            if (chunk > len)
+              chunk = len;
+            buf += chunk;
+            len -= chunk;
+            gz->count += chunk;
+            if (gz->count == gz->extra_len)
+              {
+                gzip_next_field(gz);
+                if (gz->err)
+                  return;
+              }
+          }
+          break;
+
+        case GZ_NAME:
+        case GZ_COMMENT:
+          {
+            const char *end = memchr(buf, '\0', len);
+
+            if (end == NULL)
+              len = 0;
+            else
+              {
+                len -= end + 1 - buf;
+                buf = end + 1;
+                gzip_next_field(gz);
+                if (gz->err)
+                  return;
+              }
+          }
+          break;
+
+        case GZ_HCRC:
+          /* don't bother verifying the header CRC; the data CRC in the
+             trailer covers what we actually care about. */
+          buf++;
+          len--;
+          if (++gz->count == 2)
+            {
+              gzip_next_field(gz);
+              if (gz->err)
+                return;
+            }
+          break;
+
+        case GZ_BODY:
+          {
+            char outbuf[GZ_BUFSIZE];
+            int zerr = Z_OK;
+
+            gz->zstr.next_in = (Bytef *) buf;
+            gz->zstr.avail_in = (uInt) len;
+            while (gz->zstr.avail_in > 0 && zerr != Z_STREAM_END)
+              {
+                apr_size_t produced;
+
+                gz->zstr.next_out = (Bytef *) outbuf;
+                gz->zstr.avail_out = sizeof(outbuf);
+                zerr = inflate(&gz->zstr, Z_NO_FLUSH);
+                if (zerr != Z_OK && zerr != Z_STREAM_END)
+                  {
+                    gz->err = svn_error_createf(SVN_ERR_RA_REQUEST_FAILED, 0,
+                                                NULL, gz->pool,
+                                                "compressed response did "
+                                                "not inflate (zlib error "
+                                                "%d)", zerr);
+                    return;
+                  }
+                produced = sizeof(outbuf) - gz->zstr.avail_out;
+                if (produced > 0)
+                  {
+                    gz->crc = crc32(gz->crc, (Bytef *) outbuf,
+                                    (uInt) produced);
+                    gz->total += produced;
+                    (*gz->reader)(gz->userdata, outbuf, produced);
+                  }
+              }
+            buf += len - gz->zstr.avail_in;
+            len = gz->zstr.avail_in;
+            if (zerr == Z_STREAM_END)
+              {
+                inflateEnd(&gz->zstr);
+                gz->zstr_live = 0;
+                gz->count = 0;
+                gz->mode = GZ_TRAILER;
+              }
+          }
+          break;
+
+        case GZ_TRAILER:
+          gz->tail[gz->count++] = (unsigned char) *buf++;
+          len--;
+          if (gz->count == sizeof(gz->tail))
+            {
+              uLong crc = ((uLong) gz->tail[0]
+                           | ((uLong) gz->tail[1] << 8)
+                           | ((uLong) gz->tail[2] << 16)
+                           | ((uLong) gz->tail[3] << 24));
+              uLong isize = ((uLong) gz->tail[4]
+                             | ((uLong) gz->tail[5] << 8)
+                             | ((uLong) gz->tail[6] << 16)
+                             | ((uLong) gz->tail[7] << 24));
+
+              if (crc != (gz->crc & 0xffffffff)
+                  || isize != (gz->total & 0xffffffff))
+                {
+                  gz->err = svn_error_create(SVN_ERR_RA_REQUEST_FAILED, 0,
+                                             NULL, gz->pool,
+                                             "compressed response failed "
+                                             "its integrity check");
+                  return;
+                }
+              gz->mode = GZ_DONE;
+            }
+          break;
+
+        case GZ_DONE:
+          /* servers do not send multi-member streams; anything after
+             the trailer is garbage. */
+          gz->err = svn_error_create(SVN_ERR_RA_REQUEST_FAILED, 0, NULL,
+                                     gz->pool,
+                                     "unexpected data after the "
+                                     "compressed response");
+          return;
+        }
+    }
+}
+
+#else /* ! HAVE_LIBZ */
+
+/* Without zlib there is no decoder in the way, but the wire accounting
+   still wants to see the bytes go by. */
+typedef struct {
+  ne_block_reader reader;       /* the reader the caller wanted */
+  void *userdata;               /* ... and its baton */
+  apr_off_t *received;          /* tally of wire bytes */
+} counting_reader_baton_t;
+
+static void counting_reader(void *userdata, const char *buf, size_t len)
+{
+  counting_reader_baton_t *crb = userdata;
+
+  *crb->received += len;
+  (*crb->reader)(crb->userdata, buf, len);
+}
+
+#endif /* HAVE_LIBZ */
+
+
+svn_ra_dav__gzip_t *svn_ra_dav__gzip_response(ne_request *request,
+                                              ne_block_reader reader,
+                                              void *userdata,
+                                              apr_off_t *received,
+                                              apr_pool_t *pool)
+{
+#ifdef HAVE_LIBZ
+  svn_ra_dav__gzip_t *gz = apr_pcalloc(pool, sizeof(*gz));
+
+  gz->reader = reader;
+  gz->userdata = userdata;
+  gz->received = received;
+  gz->pool = pool;
+  gz->mode = GZ_START;
+  gz->crc = crc32(0, Z_NULL, 0);
+  apr_pool_cleanup_register(pool, gz, gzip_cleanup, apr_pool_cleanup_null);
+
+  ne_add_request_header(request, "Accept-Encoding", "gzip");
+  ne_add_response_header_handler(request, "Content-Encoding",
+                                 ne_duplicate_header, &gz->encoding);
+  ne_add_response_body_reader(request, ne_accept_2xx, gzip_reader, gz);
+
+  return gz;
+#else
+  /* without zlib we could not decode anything, so do not ask for it. */
+  if (received != NULL)
+    {
+      counting_reader_baton_t *crb = apr_palloc(pool, sizeof(*crb));
+
+      crb->reader = reader;
+      crb->userdata = userdata;
+      crb->received = received;
+      ne_add_response_body_reader(request, ne_accept_2xx,
+                                  counting_reader, crb);
+    }
+  else
+    ne_add_response_body_reader(request, ne_accept_2xx, reader, userdata);
+  return NULL;
+#endif
+}
+
+
+svn_error_t *svn_ra_dav__gzip_error(svn_ra_dav__gzip_t *gzip)
+{
+#ifdef HAVE_LIBZ
+  if (gzip != NULL && gzip->err != NULL)
+    return gzip->err;
+#endif
+  return SVN_NO_ERROR;
+}
+
+
+
 svn_error_t *svn_ra_dav__parsed_request(svn_ra_session_t *ras,
                                         const char *method,
                                         const char *url,
@@ -222,6 +630,7 @@ svn_error_t *svn_ra_dav__parsed_request(svn_ra_session_t *ras,
   ne_request *req;
   ne_xml_parser *success_parser;
   ne_xml_parser *error_parser;
+  svn_ra_dav__gzip_t *gzip;
   int rv;
   int code;
   const char *msg;
@@ -234,9 +643,16 @@ svn_error_t *svn_ra_dav__parsed_request(svn_ra_session_t *ras,
   req = ne_request_create(ras->sess, method, url);
 
   if (body != NULL)
-    ne_set_request_body_buffer(req, body, strlen(body));
+    {
+      ne_set_request_body_buffer(req, body, strlen(body));
+      ras->stats.bytes_sent += strlen(body);
+    }
   else
-    ne_set_request_body_fd(req, fd);
+    {
+      /* ### an fd-fed body never shows up in stats.bytes_sent; we do
+         ### not know its size here. */
+      ne_set_request_body_fd(req, fd);
+    }
 
   /* ### use a symbolic name somewhere for this MIME type? */
   ne_add_request_header(req, "Content-Type", "text/xml");
@@ -252,10 +668,11 @@ svn_error_t *svn_ra_dav__parsed_request(svn_ra_session_t *ras,
                       start_err_element, end_err_element, pc); 
 
   /* Register the "main" accepter and body-reader with the request --
-     the one to use when the HTTP status is 2XX */
-  ne_add_response_body_reader(req, ne_accept_2xx, 
-                              ne_xml_parse_v, success_parser);
-    
+     the one to use when the HTTP status is 2XX.  The server is invited
+     to gzip the body; the decoder feeds the parser the plain XML. */
+  gzip = svn_ra_dav__gzip_response(req, ne_xml_parse_v, success_parser,
+                                   &ras->stats.bytes_received, pool);
+
   /* Register the "error" accepter and body-reader with the request --
      the one to use when HTTP status is *not* 2XX */   
   ne_add_response_body_reader(req, ra_dav_error_accepter,
@@ -273,6 +690,12 @@ svn_error_t *svn_ra_dav__parsed_request(svn_ra_session_t *ras,
       goto error;
     }
 
+  /* if the decoder tripped over a corrupt compressed body, whatever
+     the parser made of the garbage is beside the point. */
+  err = svn_ra_dav__gzip_error(gzip);
+  if (err != SVN_NO_ERROR)
+    goto error;
+
   if (pc->err != NULL)
     {
       /* The HTTP status code wasn't 2XX, so the error-parser built an
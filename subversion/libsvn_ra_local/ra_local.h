@@ -65,6 +65,11 @@ typedef struct svn_ra_local__session_baton_t
   const svn_ra_callbacks_t *callbacks;
   void *callback_baton;
 
+  /* Reporter state (open revision roots, a spare report baton)
+     shared by all the report drives made on this session.  Created
+     the first time a drive needs it. */
+  svn_repos_report_cache_t *report_cache;
+
 } svn_ra_local__session_baton_t;
 
 
@@ -148,10 +148,13 @@ svn_ra_local__open (void **session_baton,
                                       session->pool),
              "Unable to open an ra_local session to URL");
 
-  /* Open the filesystem at located at environment `repos_path' */
-  SVN_ERR (svn_repos_open (&(session->repos),
-                           session->repos_path->data,
-                           session->pool));
+  /* Open the filesystem at located at environment `repos_path'.
+     Going through the process-wide cache means we share the handle
+     split_URL just opened, instead of opening the Berkeley DB
+     environment a second time. */
+  SVN_ERR (svn_repos_open_cached (&(session->repos),
+                                  session->repos_path->data,
+                                  session->pool));
 
   /* Cache the filesystem object from the repos here for
      convenience. */
@@ -328,17 +331,25 @@ svn_ra_local__do_update (void *session_baton,
   /* Pass back our reporter */
   *reporter = &ra_local_reporter;
 
+  /* All the drives on this session share one cache of reporter
+     state, so N sequential updates open their common revision roots
+     once, not N times. */
+  if (! sbaton->report_cache)
+    sbaton->report_cache = svn_repos_report_cache_create (sbaton->pool);
+
   /* Build a reporter baton. */
   return svn_repos_begin_report (report_baton,
                                  revnum_to_update_to,
                                  sbaton->username,
-                                 sbaton->repos, 
+                                 sbaton->repos,
                                  sbaton->fs_path->data,
-                                 target, 
+                                 target,
                                  switch_path->data,
                                  TRUE, /* send text-deltas */
                                  recurse,
                                  pipe_editor, pipe_edit_baton,
+                                 sbaton->report_cache,
+                                 NULL, /* no path filter */
                                  sbaton->pool);
 }
 
@@ -421,17 +432,23 @@ svn_ra_local__do_switch (void *session_baton,
   /* Pass back our reporter */
   *reporter = &ra_local_reporter;
 
+  /* Share reporter state with the session's other drives. */
+  if (! sbaton->report_cache)
+    sbaton->report_cache = svn_repos_report_cache_create (sbaton->pool);
+
   /* Build a reporter baton. */
   return svn_repos_begin_report (report_baton,
                                  revnum_to_update_to,
                                  sbaton->username,
-                                 sbaton->repos, 
+                                 sbaton->repos,
                                  sbaton->fs_path->data,
                                  target,
                                  switch_fs_path->data,
                                  TRUE, /* we want text-deltas */
                                  recurse,
                                  pipe_editor, pipe_edit_baton,
+                                 sbaton->report_cache,
+                                 NULL, /* no path filter */
                                  sbaton->pool);
 }
 
@@ -465,17 +482,23 @@ svn_ra_local__do_status (void *session_baton,
   /* Pass back our reporter */
   *reporter = &ra_local_reporter;
 
+  /* Share reporter state with the session's other drives. */
+  if (! sbaton->report_cache)
+    sbaton->report_cache = svn_repos_report_cache_create (sbaton->pool);
+
   /* Build a reporter baton. */
   return svn_repos_begin_report (report_baton,
                                  revnum_to_update_to,
                                  sbaton->username,
-                                 sbaton->repos, 
+                                 sbaton->repos,
                                  sbaton->fs_path->data,
                                  target,
                                  switch_path->data,
                                  FALSE, /* don't send text-deltas */
                                  recurse,
                                  status_editor, status_baton,
+                                 sbaton->report_cache,
+                                 NULL, /* no path filter */
                                  sbaton->pool);
 }
 
@@ -486,6 +509,7 @@ svn_ra_local__get_log (void *session_baton,
                        svn_revnum_t start,
                        svn_revnum_t end,
                        svn_boolean_t discover_changed_paths,
+                       int limit,
                        svn_log_message_receiver_t receiver,
                        void *receiver_baton)
 {
@@ -520,6 +544,7 @@ svn_ra_local__get_log (void *session_baton,
                              start,
                              end,
                              discover_changed_paths,
+                             limit,
                              receiver,
                              receiver_baton,
                              sbaton->pool);
@@ -559,24 +584,15 @@ svn_ra_local__do_check_path (svn_node_kind_t *kind,
 
 
 
-/* Getting just one file. */
-static svn_error_t *
-svn_ra_local__get_file (void *session_baton,
-                        const char *path,
-                        svn_revnum_t revision,
-                        svn_stream_t *stream,
-                        svn_revnum_t *fetched_rev,
-                        apr_hash_t **props)
+/* Return SBATON's fs_path with PATH (which may be NULL) appended,
+   allocated in POOL. */
+static svn_stringbuf_t *
+abs_fs_path (svn_ra_local__session_baton_t *sbaton,
+             const char *path,
+             apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
-  svn_stream_t *contents;
-  svn_revnum_t youngest_rev;
-  char buf[SVN_STREAM_CHUNK_SIZE];
-  apr_size_t rlen, wlen;
-  svn_ra_local__session_baton_t *sbaton = session_baton;
-
-  svn_stringbuf_t *abs_path 
-    = svn_stringbuf_create_from_string (sbaton->fs_path, sbaton->pool);
+  svn_stringbuf_t *abs_path
+    = svn_stringbuf_create_from_string (sbaton->fs_path, pool);
 
   /* ### Not sure if this counts as a workaround or not.  The
      session baton uses the empty string to mean root, and not
@@ -591,28 +607,30 @@ svn_ra_local__get_file (void *session_baton,
   if (path)
     svn_path_add_component_nts (abs_path, path);
 
-  /* Open the revision's root. */
-  if (! SVN_IS_VALID_REVNUM (revision))
-    {
-      SVN_ERR (svn_fs_youngest_rev (&youngest_rev, sbaton->fs, sbaton->pool));
-      SVN_ERR (svn_fs_revision_root (&root, sbaton->fs,
-                                     youngest_rev, sbaton->pool));
-      if (fetched_rev != NULL)
-        *fetched_rev = youngest_rev;
-    }
-  else
-    SVN_ERR (svn_fs_revision_root (&root, sbaton->fs,
-                                   revision, sbaton->pool));
+  return abs_path;
+}
+
+
+/* Push the contents of the file at ABS_PATH in ROOT at the caller's
+   STREAM.  Use POOL for temporary allocations. */
+static svn_error_t *
+push_file_contents (svn_fs_root_t *root,
+                    const char *abs_path,
+                    svn_stream_t *stream,
+                    apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  char buf[SVN_STREAM_CHUNK_SIZE];
+  apr_size_t rlen, wlen;
 
   /* Get a stream representing the file's contents. */
-  SVN_ERR (svn_fs_file_contents (&contents, root,
-                                 abs_path->data, sbaton->pool));
+  SVN_ERR (svn_fs_file_contents (&contents, root, abs_path, pool));
 
   /* Now push data from the fs stream back at the caller's stream. */
   while (1)
     {
       /* read a maximum number of bytes from the file, please. */
-      rlen = SVN_STREAM_CHUNK_SIZE; 
+      rlen = SVN_STREAM_CHUNK_SIZE;
       SVN_ERR (svn_stream_read (contents, buf, &rlen));
 
       /* write however many bytes you read, please. */
@@ -623,11 +641,11 @@ svn_ra_local__get_file (void *session_baton,
           /* Uh oh, didn't write as many bytes as we read, and no
              error was returned.  According to the docstring, this
              should never happen. */
-          return 
+          return
             svn_error_create (SVN_ERR_UNEXPECTED_EOF, 0, NULL,
-                              sbaton->pool, "Error writing to svn_stream.");
+                              pool, "Error writing to svn_stream.");
         }
-      
+
       if (rlen != SVN_STREAM_CHUNK_SIZE)
         {
           /* svn_stream_read didn't throw an error, yet it didn't read
@@ -637,51 +655,142 @@ svn_ra_local__get_file (void *session_baton,
         }
     }
 
+  return SVN_NO_ERROR;
+}
+
+
+/* Set *PROPS to the full property hash for the file at ABS_PATH in
+   ROOT: the fs props, plus the non-tweakable metadata the get_file
+   interface promises.  Allocate the hash and its contents in POOL. */
+static svn_error_t *
+get_file_props (apr_hash_t **props,
+                svn_fs_root_t *root,
+                svn_stringbuf_t *abs_path,
+                apr_pool_t *pool)
+{
+  svn_revnum_t committed_rev;
+  svn_string_t *committed_date, *last_author;
+  svn_stringbuf_t *value;
+  svn_string_t *abs_path_s;
+  char *revision_str = NULL;
+
+  /* Create a hash with props attached to the fs node. */
+  SVN_ERR (svn_fs_node_proplist (props, root, abs_path->data, pool));
+
+  /* Now add some non-tweakable metadata to the hash as well... */
+
+  /* The so-called 'entryprops' with info about CR & friends. */
+  abs_path_s = svn_string_create_from_buf (abs_path, pool);
+  SVN_ERR (svn_repos_get_committed_info (&committed_rev,
+                                         &committed_date,
+                                         &last_author,
+                                         root, abs_path_s,
+                                         pool));
+
+  revision_str = apr_psprintf (pool, "%ld", committed_rev);
+  value = svn_stringbuf_create (revision_str, pool);
+  apr_hash_set (*props, SVN_PROP_ENTRY_COMMITTED_REV,
+                APR_HASH_KEY_STRING, value);
+
+  if (committed_date)
+    value = svn_stringbuf_create_from_string (committed_date, pool);
+  else
+    value = NULL;
+  apr_hash_set (*props, SVN_PROP_ENTRY_COMMITTED_DATE,
+                APR_HASH_KEY_STRING, value);
+
+  if (last_author)
+    value = svn_stringbuf_create_from_string (last_author, pool);
+  else
+    value = NULL;
+  apr_hash_set (*props, SVN_PROP_ENTRY_LAST_AUTHOR,
+                APR_HASH_KEY_STRING, value);
+
+  /* We have no 'wcprops' in ra_local, but might someday. */
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Getting just one file. */
+static svn_error_t *
+svn_ra_local__get_file (void *session_baton,
+                        const char *path,
+                        svn_revnum_t revision,
+                        svn_stream_t *stream,
+                        svn_revnum_t *fetched_rev,
+                        apr_hash_t **props)
+{
+  svn_fs_root_t *root;
+  svn_revnum_t youngest_rev;
+  svn_ra_local__session_baton_t *sbaton = session_baton;
+  svn_stringbuf_t *abs_path = abs_fs_path (sbaton, path, sbaton->pool);
+
+  /* Open the revision's root. */
+  if (! SVN_IS_VALID_REVNUM (revision))
+    {
+      SVN_ERR (svn_fs_youngest_rev (&youngest_rev, sbaton->fs, sbaton->pool));
+      SVN_ERR (svn_fs_revision_root (&root, sbaton->fs,
+                                     youngest_rev, sbaton->pool));
+      if (fetched_rev != NULL)
+        *fetched_rev = youngest_rev;
+    }
+  else
+    SVN_ERR (svn_fs_revision_root (&root, sbaton->fs,
+                                   revision, sbaton->pool));
+
+  SVN_ERR (push_file_contents (root, abs_path->data, stream, sbaton->pool));
+
   if (props)
+    SVN_ERR (get_file_props (props, root, abs_path, sbaton->pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Getting a whole batch of files. */
+static svn_error_t *
+svn_ra_local__get_files (void *session_baton,
+                         const apr_array_header_t *paths,
+                         svn_revnum_t revision,
+                         svn_boolean_t want_props,
+                         svn_ra_file_receiver_t receiver,
+                         void *receiver_baton)
+{
+  svn_fs_root_t *root;
+  apr_pool_t *subpool;
+  svn_ra_local__session_baton_t *sbaton = session_baton;
+  int i;
+
+  /* Resolve the revision and open its root once for the whole batch;
+     everything per-file happens in a subpool cleared between
+     files. */
+  if (! SVN_IS_VALID_REVNUM (revision))
+    SVN_ERR (svn_fs_youngest_rev (&revision, sbaton->fs, sbaton->pool));
+  SVN_ERR (svn_fs_revision_root (&root, sbaton->fs, revision, sbaton->pool));
+
+  subpool = svn_pool_create (sbaton->pool);
+  for (i = 0; i < paths->nelts; i++)
     {
-      svn_revnum_t committed_rev;
-      svn_string_t *committed_date, *last_author;
-      svn_stringbuf_t *value;
-      svn_string_t *abs_path_s;
-      char *revision_str = NULL;
-
-      /* Create a hash with props attached to the fs node. */
-      SVN_ERR (svn_fs_node_proplist (props, root, abs_path->data,
-                                     sbaton->pool));
-      
-      /* Now add some non-tweakable metadata to the hash as well... */
-    
-      /* The so-called 'entryprops' with info about CR & friends. */
-      abs_path_s = svn_string_create_from_buf (abs_path, sbaton->pool);
-      SVN_ERR (svn_repos_get_committed_info (&committed_rev,
-                                             &committed_date,
-                                             &last_author,
-                                             root, abs_path_s,
-                                             sbaton->pool));
-
-
-      revision_str = apr_psprintf (sbaton->pool, "%ld", committed_rev);
-      value = svn_stringbuf_create (revision_str, sbaton->pool);
-      apr_hash_set (*props, SVN_PROP_ENTRY_COMMITTED_REV, 
-                    APR_HASH_KEY_STRING, value);
-                    
-      if (committed_date)
-        value = svn_stringbuf_create_from_string (committed_date,
-                                                  sbaton->pool);
-      else
-        value = NULL;
-      apr_hash_set (*props, SVN_PROP_ENTRY_COMMITTED_DATE, 
-                    APR_HASH_KEY_STRING, value);
-      
-      if (last_author)
-        value = svn_stringbuf_create_from_string (last_author, sbaton->pool);
-      else
-        value = NULL;
-      apr_hash_set (*props, SVN_PROP_ENTRY_LAST_AUTHOR, 
-                    APR_HASH_KEY_STRING, value);
-            
-      /* We have no 'wcprops' in ra_local, but might someday. */
+      const char *path = (((const char **)(paths)->elts)[i]);
+      svn_stringbuf_t *abs_path = abs_fs_path (sbaton, path, subpool);
+      apr_hash_t *props = NULL;
+      svn_stream_t *contents;
+
+      if (want_props)
+        SVN_ERR (get_file_props (&props, root, abs_path, subpool));
+
+      SVN_ERR (receiver (receiver_baton, path, revision, props,
+                         &contents, subpool));
+
+      if (contents)
+        SVN_ERR (push_file_contents (root, abs_path->data, contents,
+                                     subpool));
+
+      svn_pool_clear (subpool);
     }
+  svn_pool_destroy (subpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -690,7 +799,20 @@ svn_ra_local__get_file (void *session_baton,
 
 /** The ra_plugin **/
 
-static const svn_ra_plugin_t ra_local_plugin = 
+/* There is no wire here, so there is nothing to count. */
+static svn_error_t *
+svn_ra_local__get_stats (void *session_baton,
+                         svn_ra_stats_t *stats)
+{
+  stats->requests = 0;
+  stats->bytes_sent = 0;
+  stats->bytes_received = 0;
+  stats->network_time = 0;
+  return SVN_NO_ERROR;
+}
+
+
+static const svn_ra_plugin_t ra_local_plugin =
 {
   "ra_local",
   "Module for accessing a repository on local disk.",
@@ -700,13 +822,15 @@ static const svn_ra_plugin_t ra_local_plugin =
   svn_ra_local__get_dated_revision,
   svn_ra_local__get_commit_editor,
   svn_ra_local__get_file,
+  svn_ra_local__get_files,
   svn_ra_local__do_checkout,
   svn_ra_local__do_update,
   svn_ra_local__do_switch,
   svn_ra_local__do_status,
   NULL,
   svn_ra_local__get_log,
-  svn_ra_local__do_check_path
+  svn_ra_local__do_check_path,
+  svn_ra_local__get_stats
 };
 
 
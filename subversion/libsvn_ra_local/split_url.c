@@ -19,8 +19,25 @@
 #include "ra_local.h"
 #include <assert.h>
 #include <string.h>
+#include <apr_hash.h>
 #include "svn_pools.h"
 
+
+/* A process-wide cache of resolutions already made, mapping URL path
+   portions (const char *) onto the repository root paths (const char *)
+   discovered for them, so that a process opening many ra_local
+   sessions walks the ancestor-probing loop below only once per URL.
+   Entries are just two small strings; the cache is never trimmed.
+   Both hash and entries live in SPLIT_CACHE_POOL, a top-level pool
+   created on first use.
+
+   ### todo: no mutex protects this cache (see the similar comment in
+   repos.c); multithreaded callers must serialize access
+   themselves. */
+static apr_pool_t *split_cache_pool = NULL;
+static apr_hash_t *split_cache = NULL;
+
+
 svn_error_t *
 svn_ra_local__split_URL (const svn_string_t **repos_path,
                          const svn_string_t **fs_path,
@@ -60,6 +77,40 @@ svn_ra_local__split_URL (const svn_string_t **repos_path,
       (SVN_ERR_RA_ILLEGAL_URL, 0, NULL, pool, 
        ("svn_ra_local__split_URL: URL contains unsupported hostname"));
 
+  /* Create the resolution cache the first time through. */
+  if (! split_cache)
+    {
+      split_cache_pool = svn_pool_create (NULL);
+      split_cache = apr_hash_make (split_cache_pool);
+    }
+
+  /* If this URL has been resolved before, just make sure the
+     repository is still there --- a cache hit in svn_repos_open_cached
+     costs a stat, not a Berkeley DB environment open --- and hand back
+     the remembered answer. */
+  {
+    const char *cached_root
+      = apr_hash_get (split_cache, path, APR_HASH_KEY_STRING);
+
+    if (cached_root)
+      {
+        err = svn_repos_open_cached (&repos, cached_root, subpool);
+        if (err == SVN_NO_ERROR)
+          {
+            SVN_ERR (svn_repos_close (repos));
+            *repos_path = svn_string_create (cached_root, pool);
+            *fs_path = svn_string_create (path + strlen (cached_root), pool);
+            svn_pool_destroy (subpool);
+            return SVN_NO_ERROR;
+          }
+
+        /* The repository has moved out from under its URL.  Drop the
+           entry and probe afresh. */
+        svn_error_clear_all (err);
+        apr_hash_set (split_cache, path, APR_HASH_KEY_STRING, NULL);
+      }
+  }
+
   /* Duplicate the URL, starting at the top of the path */
   url = svn_stringbuf_create ((const char *)path, subpool);
 
@@ -67,8 +118,9 @@ svn_ra_local__split_URL (const svn_string_t **repos_path,
      the last component from the URL, then try again. */
   while (1)
     {
-      /* Attempt to open a repository at URL. */
-      err = svn_repos_open (&repos, url->data, subpool);
+      /* Attempt to open a repository at URL.  Use the process-wide
+         cache, so the session proper can share the handle we find. */
+      err = svn_repos_open_cached (&repos, url->data, subpool);
 
       /* Hey, cool, we were successfully.  Stop loopin'. */
       if (err == SVN_NO_ERROR)
@@ -97,6 +149,12 @@ svn_ra_local__split_URL (const svn_string_t **repos_path,
      really going to do anything with it. */
   SVN_ERR (svn_repos_close (repos));
 
+  /* Remember the resolution, so the next session opened on this URL
+     skips the probing loop altogether. */
+  apr_hash_set (split_cache, apr_pstrdup (split_cache_pool, path),
+                APR_HASH_KEY_STRING,
+                apr_pstrdup (split_cache_pool, url->data));
+
   /* What remains of URL after being hacked at in the previous step is
      REPOS_PATH.  FS_PATH is what we've hacked off in the process.  We
      need to make sure these are allocated in the -original- pool. */
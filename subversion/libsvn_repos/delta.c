@@ -17,6 +17,8 @@
  */
 
 
+#include <string.h>
+
 #include "svn_types.h"
 #include "svn_delta.h"
 #include "svn_fs.h"
@@ -24,6 +26,7 @@
 #include "apr_hash.h"
 #include "svn_repos.h"
 #include "svn_pools.h"
+#include "repos.h"
 
 
 
@@ -49,6 +52,9 @@ struct context {
   svn_boolean_t recurse;
   svn_boolean_t use_copyfrom_args;
   int target_is_rev;
+  svn_path_index_t *paths;     /* interned paths for the whole traversal */
+  svn_repos_path_filter_t *filter;   /* subtrees to walk, or NULL for all */
+  svn_repos__report_base_t *base;    /* in-memory report base, or NULL */
 };
 
 
@@ -100,7 +106,8 @@ static svn_error_t *delta_proplists (struct context *c,
 /* Constructing deltas for file constents.  */
 static svn_error_t *send_text_delta (struct context *c,
                                      void *file_baton,
-                                     svn_txdelta_stream_t *delta_stream,
+                                     const char *source_path,
+                                     const char *target_path,
                                      apr_pool_t *pool);
 
 static svn_error_t *delta_files (struct context *c, 
@@ -118,67 +125,336 @@ static svn_error_t *delete (struct context *c,
 
 static svn_error_t *add_file_or_dir (struct context *c, 
                                      void *dir_baton, 
-                                     const char *source_parent, 
+                                     svn_indexed_path_t *source_parent, 
                                      const char *source_entry,
-                                     const char *target_parent, 
+                                     svn_indexed_path_t *target_parent, 
                                      const char *target_entry,
                                      apr_pool_t *pool);
 
 static svn_error_t *replace_file_or_dir (struct context *c, 
                                          void *dir_baton,
-                                         const char *source_parent, 
+                                         svn_indexed_path_t *source_parent, 
                                          const char *source_entry,
-                                         const char *target_parent,
+                                         svn_indexed_path_t *target_parent,
                                          const char *target_entry,
                                          apr_pool_t *pool);
 
 static svn_error_t *find_nearest_entry (svn_fs_dirent_t **s_entry,
                                         int *distance,
                                         struct context *c, 
-                                        const char *source_parent, 
-                                        const char *target_parent,
+                                        svn_indexed_path_t *source_parent, 
+                                        svn_indexed_path_t *target_parent,
                                         const svn_fs_dirent_t *t_entry,
                                         apr_pool_t *pool);
 
 static svn_error_t *delta_dirs (struct context *c, 
                                 void *dir_baton,
-                                const char *source_path, 
-                                const char *target_path,
+                                svn_indexed_path_t *source_path, 
+                                svn_indexed_path_t *target_path,
                                 apr_pool_t *pool);
 
 
 
 static svn_error_t *
-not_a_dir_error (const char *role, 
+not_a_dir_error (const char *role,
                  const char *path,
                  apr_pool_t *pool)
 {
-  return svn_error_createf 
+  return svn_error_createf
     (SVN_ERR_FS_NOT_DIRECTORY, 0, 0, pool,
      "not_a_dir_error: invalid %s directory '%s'",
      role, path ? path : "(null)");
 }
 
 
-/* Public interface to computing directory deltas.  */
-svn_error_t *
-svn_repos_dir_delta (svn_fs_root_t *src_root,
-                     const char *src_parent_dir,
-                     const char *src_entry,
-                     apr_hash_t *src_revs,
-                     svn_fs_root_t *tgt_root,
-                     const char *tgt_path,
-                     const svn_delta_edit_fns_t *editor,
-                     void *edit_baton,
-                     svn_boolean_t text_deltas,
-                     svn_boolean_t recurse,
-                     svn_boolean_t use_copyfrom_args,
+
+/* Path filters.  See svn_repos.h for the public story.  */
+
+struct svn_repos_path_filter_t
+{
+  apr_array_header_t *includes;   /* (const char *) path prefixes */
+  apr_array_header_t *excludes;   /* (const char *) path prefixes */
+  apr_pool_t *pool;
+};
+
+
+svn_repos_path_filter_t *
+svn_repos_path_filter_create (apr_pool_t *pool)
+{
+  svn_repos_path_filter_t *filter = apr_palloc (pool, sizeof (*filter));
+
+  filter->includes = apr_array_make (pool, 4, sizeof (const char *));
+  filter->excludes = apr_array_make (pool, 4, sizeof (const char *));
+  filter->pool = pool;
+  return filter;
+}
+
+
+void
+svn_repos_path_filter_include (svn_repos_path_filter_t *filter,
+                               const char *prefix)
+{
+  (*((const char **) apr_array_push (filter->includes)))
+    = apr_pstrdup (filter->pool, prefix);
+}
+
+
+void
+svn_repos_path_filter_exclude (svn_repos_path_filter_t *filter,
+                               const char *prefix)
+{
+  (*((const char **) apr_array_push (filter->excludes)))
+    = apr_pstrdup (filter->pool, prefix);
+}
+
+
+/* Return non-zero iff PATH is PREFIX itself or lies below it.
+   Leading slashes on either side are ignored, so "/trunk/www"
+   matches the prefix "trunk".  An empty prefix matches everything. */
+static int
+path_under_prefix (const char *path, const char *prefix)
+{
+  apr_size_t len;
+
+  while (*path == '/')
+    path++;
+  while (*prefix == '/')
+    prefix++;
+
+  len = strlen (prefix);
+  if (len == 0)
+    return 1;
+  if (strncmp (path, prefix, len) != 0)
+    return 0;
+  return ((path[len] == '\0') || (path[len] == '/'));
+}
+
+
+/* Return non-zero iff FILTER says the delta walk should visit PATH.
+   A null FILTER passes everything.  An ancestor of an include prefix
+   counts as wanted, since the walk has to open it to reach the
+   included subtree below. */
+static int
+path_filter_wanted (svn_repos_path_filter_t *filter, const char *path)
+{
+  int i;
+
+  if (! filter)
+    return 1;
+
+  for (i = 0; i < filter->excludes->nelts; i++)
+    if (path_under_prefix (path, APR_ARRAY_IDX (filter->excludes, i,
+                                                const char *)))
+      return 0;
+
+  if (filter->includes->nelts == 0)
+    return 1;
+
+  for (i = 0; i < filter->includes->nelts; i++)
+    {
+      const char *prefix = APR_ARRAY_IDX (filter->includes, i, const char *);
+
+      if (path_under_prefix (path, prefix)
+          || path_under_prefix (prefix, path))
+        return 1;
+    }
+
+  return 0;
+}
+
+
+/* The in-memory report base.  See svn_repos__report_base_t in
+   repos.h for the story; the functions here are how the delta walk
+   reads the base without a transaction to mirror it.  */
+
+/* Set *ROOT_P to the root PATH's contents should be read from under
+   C's source tree: C->source_root plainly, or, when the walk runs
+   over an in-memory report base, the root of the revision PATH's
+   nearest reported ancestor named.  Set *ROOT_P to null if the base
+   deletes PATH.  */
+static svn_error_t *
+resolve_source (svn_fs_root_t **root_p,
+                struct context *c,
+                const char *path,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *ancestor;
+  svn_revnum_t rev = SVN_INVALID_REVNUM;
+  apr_size_t reported_len = 0;
+  int i;
+
+  if (! c->base)
+    {
+      *root_p = c->source_root;
+      return SVN_NO_ERROR;
+    }
+
+  /* Find the nearest reported ancestor, the way
+     get_revision_from_hash does, but remember how deep it sits. */
+  ancestor = svn_stringbuf_create (path, pool);
+  while (1)
+    {
+      void *val = apr_hash_get (c->source_rev_diffs, ancestor->data,
+                                APR_HASH_KEY_STRING);
+      if (val)
+        {
+          rev = *((svn_revnum_t *) val);
+          reported_len = ancestor->len;
+          break;
+        }
+      if (svn_path_is_empty (ancestor))
+        break;
+      svn_path_remove_component (ancestor);
+    }
+
+  /* A deletion reported at or below the nearest reported ancestor
+     hides the path, just as svn_fs_delete_tree hid it in the old
+     mirror transaction. */
+  for (i = 0; i < c->base->deletes->nelts; i++)
+    {
+      const char *doomed = APR_ARRAY_IDX (c->base->deletes, i,
+                                          const char *);
+
+      if (path_under_prefix (path, doomed)
+          && strlen (doomed) >= reported_len)
+        {
+          *root_p = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (! SVN_IS_VALID_REVNUM (rev))
+    {
+      *root_p = c->source_root;
+      return SVN_NO_ERROR;
+    }
+
+  *root_p = apr_hash_get (c->base->rev_roots, &rev, sizeof (rev));
+  if (! *root_p)
+    return svn_error_createf
+      (SVN_ERR_FS_NO_SUCH_REVISION, 0, 0, pool,
+       "resolve_source: no root for revision %ld in the report base",
+       rev);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return non-zero iff, under C's in-memory report base, some
+   reported path strictly below PATH names a revision other than
+   PATH_REV, or a reported deletion lies below PATH.  A divergent
+   subtree means a source node id read from an ancestor's revision
+   root doesn't vouch for everything the client has underneath, so
+   the walk must descend rather than skip.  Only call this when
+   C->base is set.  Use POOL for iteration.  */
+static int
+base_subtree_divergent (struct context *c,
+                        const char *path,
+                        svn_revnum_t path_rev,
+                        apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  int i;
+
+  for (i = 0; i < c->base->deletes->nelts; i++)
+    if (path_under_prefix (APR_ARRAY_IDX (c->base->deletes, i, const char *),
+                           path))
+      return 1;
+
+  /* The reporter collapses entries shadowed by an equal-revision
+     ancestor, so this hash is as small as the working copy's
+     revision mixture allows. */
+  for (hi = apr_hash_first (pool, c->source_rev_diffs); hi;
+       hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      if (path_under_prefix (key, path)
+          && (strcmp (key, path) != 0)
+          && (*((svn_revnum_t *) val) != path_rev))
+        return 1;
+    }
+
+  return 0;
+}
+
+
+/* Make S_ENTRIES --- LIST_ROOT's listing of SOURCE_PATH --- match
+   C's in-memory report base: entries the client reported deleted
+   disappear, and an entry whose own resolution lands in a different
+   revision root gets its id re-read from there, so the id
+   comparisons in delta_dirs judge what the client really has.  Only
+   call this when C->base is set.  */
+static svn_error_t *
+base_adjust_entries (struct context *c,
+                     apr_hash_t *s_entries,
+                     svn_fs_root_t *list_root,
+                     svn_indexed_path_t *source_path,
                      apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_array_header_t *doomed = apr_array_make (pool, 4,
+                                               sizeof (const char *));
+  int i;
+
+  for (hi = apr_hash_first (pool, s_entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+      svn_fs_dirent_t *entry;
+      svn_indexed_path_t *full_path;
+      svn_fs_root_t *root;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      entry = val;
+
+      full_path = svn_path_index_join (c->paths, source_path, entry->name);
+      SVN_ERR (resolve_source (&root, c, full_path->path, pool));
+      if (! root)
+        (*((const char **) apr_array_push (doomed))) = key;
+      else if (root != list_root)
+        SVN_ERR (svn_fs_node_id (&entry->id, root, full_path->path, pool));
+    }
+
+  /* Now that the iteration is over, it's safe to delete the hidden
+     entries. */
+  for (i = 0; i < doomed->nelts; i++)
+    apr_hash_set (s_entries, APR_ARRAY_IDX (doomed, i, const char *),
+                  APR_HASH_KEY_STRING, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Public interface to computing directory deltas.  */
+
+/* The body shared by svn_repos_dir_delta and
+   svn_repos__dir_delta_base; BASE is null for a plain walk of
+   SRC_ROOT, and the report base SRC_ROOT stands in for otherwise.
+   Arguments are as for svn_repos_dir_delta.  */
+static svn_error_t *
+do_dir_delta (svn_fs_root_t *src_root,
+              svn_repos__report_base_t *base,
+              const char *src_parent_dir,
+              const char *src_entry,
+              apr_hash_t *src_revs,
+              svn_fs_root_t *tgt_root,
+              const char *tgt_path,
+              const svn_delta_edit_fns_t *editor,
+              void *edit_baton,
+              svn_boolean_t text_deltas,
+              svn_boolean_t recurse,
+              svn_boolean_t use_copyfrom_args,
+              svn_repos_path_filter_t *filter,
+              apr_pool_t *pool)
 {
   void *root_baton;
   struct context c;
   svn_stringbuf_t *tgt_parent_dir, *tgt_entry;
   svn_stringbuf_t *src_fullpath;
+  svn_fs_root_t *s_root;
   svn_fs_id_t *src_id, *tgt_id;
   svn_error_t *err;
   int distance;
@@ -209,6 +485,19 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
       svn_path_split (tempbuf, &tgt_parent_dir, &tgt_entry, pool);
     }
 
+  /* Setup our pseudo-global structure here.  We need these variables
+     throughout the deltafication process, so pass them around by
+     reference to all the helper functions. */
+  c.editor = editor;
+  c.source_root = src_root;
+  c.source_rev_diffs = src_revs;
+  c.target_root = tgt_root;
+  c.target_is_rev = svn_fs_is_revision_root (tgt_root);
+  c.recurse = recurse;
+  c.text_deltas = text_deltas;
+  c.filter = filter;
+  c.base = base;
+
   /* Make sure that parent dirs are really directories under both the
      source and target roots.  This also doubles as an existence
      check.  Obviously, an empty parent path is the root of the
@@ -217,7 +506,10 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
   if (! svn_path_is_empty (tempbuf))
     {
       int s_dir, t_dir;
-      SVN_ERR (svn_fs_is_dir (&s_dir, src_root, src_parent_dir, pool));
+      SVN_ERR (resolve_source (&s_root, &c, src_parent_dir, pool));
+      if (! s_root)
+        return not_a_dir_error ("source parent", src_parent_dir, pool);
+      SVN_ERR (svn_fs_is_dir (&s_dir, s_root, src_parent_dir, pool));
       SVN_ERR (svn_fs_is_dir (&t_dir, tgt_root, tgt_parent_dir->data, pool));
       if ((! s_dir) || (! t_dir))
         return not_a_dir_error ("source parent", src_parent_dir, pool);
@@ -225,22 +517,18 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
   if (! svn_path_is_empty (tgt_parent_dir))
     {
       int s_dir, t_dir;
-      SVN_ERR (svn_fs_is_dir (&s_dir, src_root, tgt_parent_dir->data, pool));
+      SVN_ERR (resolve_source (&s_root, &c, tgt_parent_dir->data, pool));
+      if (! s_root)
+        return not_a_dir_error ("target parent", tgt_parent_dir->data, pool);
+      SVN_ERR (svn_fs_is_dir (&s_dir, s_root, tgt_parent_dir->data, pool));
       SVN_ERR (svn_fs_is_dir (&t_dir, tgt_root, tgt_parent_dir->data, pool));
       if ((! s_dir) || (! t_dir))
         return not_a_dir_error ("target parent", tgt_parent_dir->data, pool);
     }
-  
-  /* Setup our pseudo-global structure here.  We need these variables
-     throughout the deltafication process, so pass them around by
-     reference to all the helper functions. */
-  c.editor = editor;
-  c.source_root = src_root;
-  c.source_rev_diffs = src_revs;
-  c.target_root = tgt_root;
-  c.target_is_rev = svn_fs_is_revision_root (tgt_root);
-  c.recurse = recurse;
-  c.text_deltas = text_deltas;
+
+  /* A path index shared by the whole traversal; every full path the
+     recursion constructs is interned here exactly once. */
+  c.paths = svn_path_index_create (pool);
 
 #if SVN_REPOS_SUPPORT_COPY_FROM_ARGS
   c.use_copyfrom_args = use_copyfrom_args;
@@ -281,7 +569,14 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
           return err;
         }
     }
-  err = svn_fs_node_id (&src_id, src_root, src_fullpath->data, pool);
+  SVN_ERR (resolve_source (&s_root, &c, src_fullpath->data, pool));
+  if (! s_root)
+    /* The report base deleted the source; treat it like a vanished
+       node, which the handling just below re-adds. */
+    err = svn_error_create (SVN_ERR_FS_NOT_FOUND, 0, 0, pool,
+                            src_fullpath->data);
+  else
+    err = svn_fs_node_id (&src_id, s_root, src_fullpath->data, pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_FS_NOT_FOUND)
@@ -292,7 +587,8 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
           SVN_ERR (add_file_or_dir (&c, root_baton,
                                     NULL,
                                     NULL,
-                                    tgt_parent_dir->data,
+                                    svn_path_index_get (c.paths,
+                                                        tgt_parent_dir->data),
                                     tgt_entry->data,
                                     pool));
         }
@@ -306,6 +602,18 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
       /* Use the distance between the node ids to determine the best
          way to update the requested entry. */
       distance = svn_fs_id_distance (src_id, tgt_id);
+
+      /* Identical ids only vouch for the revision the source id was
+         read from; if the report base diverges somewhere underneath,
+         descend anyway. */
+      if (distance == 0
+          && c.base
+          && base_subtree_divergent (&c, src_fullpath->data,
+                                     get_revision_from_hash
+                                     (src_revs, src_fullpath->data, pool),
+                                     pool))
+        distance = 1;
+
       if (distance == 0)
         {
           /* They're the same node!  No-op (you gotta love those). */
@@ -317,7 +625,8 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
           SVN_ERR (delete (&c, root_baton, src_entry, pool));
           SVN_ERR (add_file_or_dir (&c, root_baton,
                                     NULL, NULL,
-                                    tgt_parent_dir->data,
+                                    svn_path_index_get (c.paths,
+                                                        tgt_parent_dir->data),
                                     tgt_entry->data,
                                     pool));
         }
@@ -326,9 +635,11 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
           /* The nodes are at least related.  Just open the one
              with the other. */
           SVN_ERR (replace_file_or_dir (&c, root_baton,
-                                        src_parent_dir,
+                                        svn_path_index_get (c.paths,
+                                                            src_parent_dir),
                                         src_entry,
-                                        tgt_parent_dir->data,
+                                        svn_path_index_get (c.paths,
+                                                            tgt_parent_dir->data),
                                         tgt_entry->data,
                                         pool));
         }
@@ -337,7 +648,8 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
     {
       /* There is no entry given, so update the whole parent directory. */
       SVN_ERR (delta_dirs (&c, root_baton,
-                           src_fullpath->data, tgt_path,
+                           svn_path_index_get (c.paths, src_fullpath->data),
+                           svn_path_index_get (c.paths, tgt_path),
                            pool));
     }
 
@@ -354,6 +666,48 @@ svn_repos_dir_delta (svn_fs_root_t *src_root,
 }
 
 
+svn_error_t *
+svn_repos_dir_delta (svn_fs_root_t *src_root,
+                     const char *src_parent_dir,
+                     const char *src_entry,
+                     apr_hash_t *src_revs,
+                     svn_fs_root_t *tgt_root,
+                     const char *tgt_path,
+                     const svn_delta_edit_fns_t *editor,
+                     void *edit_baton,
+                     svn_boolean_t text_deltas,
+                     svn_boolean_t recurse,
+                     svn_boolean_t use_copyfrom_args,
+                     svn_repos_path_filter_t *filter,
+                     apr_pool_t *pool)
+{
+  return do_dir_delta (src_root, NULL, src_parent_dir, src_entry, src_revs,
+                       tgt_root, tgt_path, editor, edit_baton, text_deltas,
+                       recurse, use_copyfrom_args, filter, pool);
+}
+
+
+svn_error_t *
+svn_repos__dir_delta_base (svn_repos__report_base_t *base,
+                           const char *src_parent_dir,
+                           const char *src_entry,
+                           apr_hash_t *src_revs,
+                           svn_fs_root_t *tgt_root,
+                           const char *tgt_path,
+                           const svn_delta_edit_fns_t *editor,
+                           void *edit_baton,
+                           svn_boolean_t text_deltas,
+                           svn_boolean_t recurse,
+                           svn_boolean_t use_copyfrom_args,
+                           svn_repos_path_filter_t *filter,
+                           apr_pool_t *pool)
+{
+  return do_dir_delta (base->base_root, base, src_parent_dir, src_entry,
+                       src_revs, tgt_root, tgt_path, editor, edit_baton,
+                       text_deltas, recurse, use_copyfrom_args, filter, pool);
+}
+
+
 
 /* Retrieving the base revision from the path/revision hash.  */
 
@@ -378,7 +732,22 @@ get_revision_from_hash (apr_hash_t *hash, const char *path,
     {
       revision = *((svn_revnum_t *) val);
       if (SVN_IS_VALID_REVNUM(revision))
-        return revision;      
+        return revision;
+    }
+
+  /* A working copy that's all at one revision reports only the root
+     (the reporter collapses entries shadowed by their parents), so
+     don't bother walking up component by component when the root
+     entry is all there is.  */
+  if (apr_hash_count (hash) == 1)
+    {
+      val = apr_hash_get (hash, "", APR_HASH_KEY_STRING);
+      if (val)
+        {
+          revision = *((svn_revnum_t *) val);
+          if (SVN_IS_VALID_REVNUM(revision))
+            return revision;
+        }
     }
 
   /* Make a copy of our path that we can hack on. */
@@ -462,9 +831,20 @@ delta_proplists (struct context *c,
   apr_hash_t *t_props = 0;
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
+  svn_fs_root_t *s_root = NULL;
 
-  /* Make a subpool for local allocations. */ 
+  /* Make a subpool for local allocations. */
   subpool = svn_pool_create (pool);
+  svn_pool_tag (subpool, "repos:delta-proplists");
+
+  if (source_path)
+    {
+      SVN_ERR (resolve_source (&s_root, c, source_path, subpool));
+      if (! s_root)
+        /* The report base deleted the source; delta against
+           nothing. */
+        source_path = NULL;
+    }
 
   if (source_path && target_path)
     {
@@ -474,7 +854,7 @@ delta_proplists (struct context *c,
       SVN_ERR (svn_fs_props_changed (&changed,
                                      c->target_root,
                                      target_path,
-                                     c->source_root,
+                                     s_root,
                                      source_path,
                                      subpool));
       if (! changed)
@@ -486,8 +866,8 @@ delta_proplists (struct context *c,
 
   /* Get the source file's properties */
   if (source_path)
-    SVN_ERR (svn_fs_node_proplist 
-             (&s_props, c->source_root, source_path,
+    SVN_ERR (svn_fs_node_proplist
+             (&s_props, s_root, source_path,
               subpool));
 
   /* Get the target file's properties */
@@ -555,28 +935,43 @@ delta_proplists (struct context *c,
 
 
 /* Change the contents of FILE_BATON in C->editor, according to the
-   text delta from DELTA_STREAM.  */
+   text delta that turns SOURCE_PATH's contents into TARGET_PATH's.
+   SOURCE_PATH may be null, meaning the delta is against the empty
+   file.  */
 static svn_error_t *
 send_text_delta (struct context *c,
                  void *file_baton,
-                 svn_txdelta_stream_t *delta_stream,
+                 const char *source_path,
+                 const char *target_path,
                  apr_pool_t *pool)
 {
   svn_txdelta_window_handler_t delta_handler;
   void *delta_handler_baton;
+  svn_fs_root_t *s_root = NULL;
+
+  if (source_path)
+    {
+      SVN_ERR (resolve_source (&s_root, c, source_path, pool));
+      if (! s_root)
+        source_path = NULL;
+    }
 
   /* Get a handler that will apply the delta to the file.  */
-  SVN_ERR (c->editor->apply_textdelta 
+  SVN_ERR (c->editor->apply_textdelta
            (file_baton, &delta_handler, &delta_handler_baton));
 
-  
+
   if (c->text_deltas)
     {
-      /* Deliver the delta stream to the file.  */
-      SVN_ERR (svn_txdelta_send_txstream (delta_stream,
-                                          delta_handler,
-                                          delta_handler_baton,
-                                          pool));
+      /* Deliver the delta straight from the filesystem, which serves
+         it out of storage when it already holds the target deltified
+         against exactly this source.  */
+      SVN_ERR (svn_fs_send_file_delta (delta_handler,
+                                       delta_handler_baton,
+                                       source_path ? s_root : NULL,
+                                       source_path,
+                                       c->target_root, target_path,
+                                       pool));
     }
   else
     {
@@ -597,54 +992,50 @@ delta_files (struct context *c, void *file_baton,
              const char *target_path,
              apr_pool_t *pool)
 {
-  svn_txdelta_stream_t *delta_stream;
   apr_pool_t *subpool;
+  int props_changed = 1;
+  int contents_changed = 1;
 
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create (pool);
-
-  /* Compare the files' property lists.  */
-  SVN_ERR (delta_proplists (c, source_path, target_path,
-                            change_file_prop, file_baton, subpool));
-
-  /* ### this is too much work if !c->text_deltas. there is no reason to
-     ### ask the FS for a delta stream if we aren't going to use it. */
+  svn_pool_tag (subpool, "repos:delta-files");
 
   if (source_path)
     {
-      int changed;
+      svn_fs_root_t *s_root;
 
-      /* Is this deltification worth our time? */
-      SVN_ERR (svn_fs_contents_changed (&changed,
+      SVN_ERR (resolve_source (&s_root, c, source_path, subpool));
+      if (! s_root)
+        source_path = NULL;
+      else
+        /* Ask about the properties and the text in a single
+           filesystem transaction; asking with the two separate
+           predicates would walk both paths through the node
+           hierarchy twice.  */
+        SVN_ERR (svn_fs_things_changed (&props_changed,
+                                        &contents_changed,
                                         c->target_root,
                                         target_path,
-                                        c->source_root,
+                                        s_root,
                                         source_path,
                                         subpool));
-      if (! changed)
-        {
-          svn_pool_destroy (subpool);
-          return SVN_NO_ERROR;
-        }
-
-      /* Get a delta stream turning SOURCE_PATH's contents into
-         TARGET_PATH's contents.  */
-      SVN_ERR (svn_fs_get_file_delta_stream 
-               (&delta_stream, 
-                c->source_root, source_path,
-                c->target_root, target_path,
-                subpool));
     }
-  else
+
+  /* Compare the files' property lists.  */
+  if (props_changed)
+    SVN_ERR (delta_proplists (c, source_path, target_path,
+                              change_file_prop, file_baton, subpool));
+
+  if (source_path && (! contents_changed))
     {
-      /* Get a delta stream turning an empty file into one having
-         TARGET_PATH's contents.  */
-      SVN_ERR (svn_fs_get_file_delta_stream 
-               (&delta_stream, 0, 0,
-                c->target_root, target_path, subpool));
+      svn_pool_destroy (subpool);
+      return SVN_NO_ERROR;
     }
 
-  SVN_ERR (send_text_delta (c, file_baton, delta_stream, subpool));
+  /* Send the delta turning SOURCE_PATH's contents (or the empty
+     file's, if there is no source) into TARGET_PATH's contents.  */
+  SVN_ERR (send_text_delta (c, file_baton, source_path, target_path,
+                            subpool));
 
   /* Cleanup. */
   svn_pool_destroy (subpool);
@@ -678,15 +1069,16 @@ delete (struct context *c,
    calls.  Pass DIR_BATON through to editor functions that require it.  */
 static svn_error_t *
 add_file_or_dir (struct context *c, void *dir_baton,
-                 const char *source_parent,
+                 svn_indexed_path_t *source_parent,
                  const char *source_entry,
-                 const char *target_parent,
+                 svn_indexed_path_t *target_parent,
                  const char *target_entry,
                  apr_pool_t *pool)
 {
   int is_dir;
-  svn_stringbuf_t *target_full_path;
-  svn_stringbuf_t *source_full_path;
+  svn_indexed_path_t *target_full_path;
+  svn_indexed_path_t *source_full_path;
+  svn_stringbuf_t *copyfrom_path = NULL;
   svn_revnum_t base_revision = SVN_INVALID_REVNUM;
 
   /* ### change the delta interface */
@@ -696,22 +1088,23 @@ add_file_or_dir (struct context *c, void *dir_baton,
     abort();
 
   /* Get the target's full path */
-  target_full_path = svn_stringbuf_create (target_parent, pool);
-  svn_path_add_component_nts (target_full_path, target_entry);
+  target_full_path = svn_path_index_join (c->paths, target_parent,
+                                          target_entry);
 
   /* Is the target a file or a directory?  */
   SVN_ERR (svn_fs_is_dir (&is_dir, c->target_root, 
-                          target_full_path->data, pool));
+                          target_full_path->path, pool));
 
   if (source_parent && source_entry)
     {
       /* Get the source's full path */
-      source_full_path = svn_stringbuf_create (source_parent, pool);
-      svn_path_add_component_nts (source_full_path, source_entry);
+      source_full_path = svn_path_index_join (c->paths, source_parent,
+                                              source_entry);
+      copyfrom_path = svn_stringbuf_create (source_full_path->path, pool);
 
       /* Get the base revision for the entry from the hash. */
       base_revision = get_revision_from_hash (c->source_rev_diffs,
-                                              source_full_path->data,
+                                              source_full_path->path,
                                               pool);
     }
   else
@@ -724,10 +1117,9 @@ add_file_or_dir (struct context *c, void *dir_baton,
 
       SVN_ERR (c->editor->add_directory 
                (namebuf, dir_baton, 
-                source_full_path, base_revision, &subdir_baton));
+                copyfrom_path, base_revision, &subdir_baton));
       SVN_ERR (delta_dirs (c, subdir_baton,
-                           source_full_path ? source_full_path->data : NULL,
-                           target_full_path->data, pool));
+                           source_full_path, target_full_path, pool));
       SVN_ERR (c->editor->close_directory (subdir_baton));
     }
   else
@@ -736,10 +1128,10 @@ add_file_or_dir (struct context *c, void *dir_baton,
 
       SVN_ERR (c->editor->add_file 
                (namebuf, dir_baton, 
-                source_full_path, base_revision, &file_baton));
+                copyfrom_path, base_revision, &file_baton));
       SVN_ERR (delta_files (c, file_baton,
-                            source_full_path ? source_full_path->data : NULL,
-                            target_full_path->data, pool));
+                            source_full_path ? source_full_path->path : NULL,
+                            target_full_path->path, pool));
       SVN_ERR (c->editor->close_file (file_baton));
     }
 
@@ -753,15 +1145,15 @@ add_file_or_dir (struct context *c, void *dir_baton,
 static svn_error_t *
 replace_file_or_dir (struct context *c, 
                      void *dir_baton,
-                     const char *target_parent, 
+                     svn_indexed_path_t *target_parent, 
                      const char *target_entry,
-                     const char *source_parent, 
+                     svn_indexed_path_t *source_parent, 
                      const char *source_entry,
                      apr_pool_t *pool)
 {
   int is_dir;
-  svn_stringbuf_t *source_full_path = 0;
-  svn_stringbuf_t *target_full_path = 0;
+  svn_indexed_path_t *source_full_path;
+  svn_indexed_path_t *target_full_path;
   svn_revnum_t base_revision = SVN_INVALID_REVNUM;
 
   /* ### change the delta interface */
@@ -774,20 +1166,20 @@ replace_file_or_dir (struct context *c,
     abort();
 
   /* Get the target's full path */
-  target_full_path = svn_stringbuf_create (target_parent, pool);
-  svn_path_add_component_nts (target_full_path, target_entry);
+  target_full_path = svn_path_index_join (c->paths, target_parent,
+                                          target_entry);
 
   /* Is the target a file or a directory?  */
   SVN_ERR (svn_fs_is_dir (&is_dir, c->target_root, 
-                          target_full_path->data, pool));
+                          target_full_path->path, pool));
 
   /* Get the source's full path */
-  source_full_path = svn_stringbuf_create (source_parent, pool);
-  svn_path_add_component_nts (source_full_path, source_entry);
+  source_full_path = svn_path_index_join (c->paths, source_parent,
+                                          source_entry);
 
   /* Get the base revision for the entry from the hash. */
   base_revision = get_revision_from_hash (c->source_rev_diffs,
-                                          source_full_path->data,
+                                          source_full_path->path,
                                           pool);
 
   namebuf = svn_stringbuf_create (target_entry, pool);
@@ -798,7 +1190,7 @@ replace_file_or_dir (struct context *c,
       SVN_ERR (c->editor->open_directory 
                (namebuf, dir_baton, base_revision, &subdir_baton));
       SVN_ERR (delta_dirs (c, subdir_baton,
-                           source_full_path->data, target_full_path->data,
+                           source_full_path, target_full_path,
                            pool));
       SVN_ERR (c->editor->close_directory (subdir_baton));
     }
@@ -809,7 +1201,7 @@ replace_file_or_dir (struct context *c,
       SVN_ERR (c->editor->open_file 
                (namebuf, dir_baton, base_revision, &file_baton));
       SVN_ERR (delta_files (c, file_baton,
-                            source_full_path->data, target_full_path->data,
+                            source_full_path->path, target_full_path->path,
                             pool));
       SVN_ERR (c->editor->close_file (file_baton));
     }
@@ -827,8 +1219,8 @@ static svn_error_t *
 find_nearest_entry (svn_fs_dirent_t **s_entry,
                     int *distance,
                     struct context *c, 
-                    const char *source_parent, 
-                    const char *target_parent,
+                    svn_indexed_path_t *source_parent, 
+                    svn_indexed_path_t *target_parent,
                     const svn_fs_dirent_t *t_entry,
                     apr_pool_t *pool)
 {
@@ -836,16 +1228,17 @@ find_nearest_entry (svn_fs_dirent_t **s_entry,
   apr_hash_index_t *hi;
   int best_distance = -1;
   svn_fs_dirent_t *best_entry = NULL;
-  svn_stringbuf_t *source_full_path;
-  svn_stringbuf_t *target_full_path;
+  svn_indexed_path_t *source_full_path;
+  svn_indexed_path_t *target_full_path;
+  svn_fs_root_t *s_root;
   int t_is_dir;
   apr_pool_t *subpool;
   
   /* Make a subpool for local allocations */
   subpool = svn_pool_create (pool);
+  svn_pool_tag (subpool, "repos:find-nearest-entry");
 
   /* If there's no source to search, return a failed ancestor hunt. */
-  source_full_path = svn_stringbuf_create ("", subpool);
   if (! source_parent)
     {
       *s_entry = 0;
@@ -854,19 +1247,31 @@ find_nearest_entry (svn_fs_dirent_t **s_entry,
       return SVN_NO_ERROR;
     }
 
+  /* Which root does the source parent live in?  (The nearest-entry
+     hunt is an id-distance heuristic, so we don't bother re-resolving
+     each individual entry.) */
+  SVN_ERR (resolve_source (&s_root, c, source_parent->path, subpool));
+  if (! s_root)
+    {
+      *s_entry = 0;
+      *distance = -1;
+      svn_pool_destroy (subpool);
+      return SVN_NO_ERROR;
+    }
+
   /* Get the list of entries in source.  Note that we are using the
      pool that was passed in instead of the subpool...we're returning
      a reference to an item in this hash, and it would suck to blow it
      away before our caller gets a chance to see it.  */
-  SVN_ERR (svn_fs_dir_entries (&s_entries, c->source_root,
-                               source_parent, pool));
+  SVN_ERR (svn_fs_dir_entries (&s_entries, s_root,
+                               source_parent->path, pool));
 
-  target_full_path = svn_stringbuf_create (target_parent, subpool);
-  svn_path_add_component_nts (target_full_path, t_entry->name);
+  target_full_path = svn_path_index_join (c->paths, target_parent,
+                                          t_entry->name);
 
   /* Is the target a file or a directory?  */
   SVN_ERR (svn_fs_is_dir (&t_is_dir, c->target_root, 
-                          target_full_path->data, subpool));
+                          target_full_path->path, subpool));
 
   /* Find the closest relative to TARGET_ENTRY in SOURCE.
      
@@ -888,12 +1293,12 @@ find_nearest_entry (svn_fs_dirent_t **s_entry,
       apr_hash_this (hi, &key, &klen, &val);
       this_entry = val;
 
-      svn_stringbuf_set (source_full_path, source_parent);
-      svn_path_add_component_nts (source_full_path, this_entry->name);
+      source_full_path = svn_path_index_join (c->paths, source_parent,
+                                              this_entry->name);
 
       /* Is this entry a file or a directory?  */
-      SVN_ERR (svn_fs_is_dir (&s_is_dir, c->source_root, 
-                              source_full_path->data, subpool));
+      SVN_ERR (svn_fs_is_dir (&s_is_dir, s_root,
+                              source_full_path->path, subpool));
 
       /* If we aren't looking at the same node type, skip this
          entry. */
@@ -937,8 +1342,8 @@ find_nearest_entry (svn_fs_dirent_t **s_entry,
 static svn_error_t *
 delta_dirs (struct context *c, 
             void *dir_baton,
-            const char *source_path, 
-            const char *target_path,
+            svn_indexed_path_t *source_path, 
+            svn_indexed_path_t *target_path,
             apr_pool_t *pool)
 {
   apr_hash_t *s_entries = 0, *t_entries = 0;
@@ -946,14 +1351,16 @@ delta_dirs (struct context *c,
   apr_pool_t *subpool;
 
   /* Compare the property lists.  */
-  SVN_ERR (delta_proplists (c, source_path, target_path,
+  SVN_ERR (delta_proplists (c,
+                            source_path ? source_path->path : NULL,
+                            target_path ? target_path->path : NULL,
                             change_dir_prop, dir_baton, pool));
 
   /* Get the list of entries in each of source and target.  */
   if (target_path)
     {
       SVN_ERR (svn_fs_dir_entries (&t_entries, c->target_root,
-                                   target_path, pool));
+                                   target_path->path, pool));
     }
   else
     {
@@ -963,12 +1370,22 @@ delta_dirs (struct context *c,
 
   if (source_path)
     {
-      SVN_ERR (svn_fs_dir_entries (&s_entries, c->source_root,
-                                   source_path, pool));
+      svn_fs_root_t *s_root;
+
+      SVN_ERR (resolve_source (&s_root, c, source_path->path, pool));
+      if (s_root)
+        {
+          SVN_ERR (svn_fs_dir_entries (&s_entries, s_root,
+                                       source_path->path, pool));
+          if (c->base)
+            SVN_ERR (base_adjust_entries (c, s_entries, s_root,
+                                          source_path, pool));
+        }
     }
 
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create (pool);
+  svn_pool_tag (subpool, "repos:delta-dirs");
 
   /* Loop over the hash of entries in the target, searching for its
      partner in the source.  If we find the matching partner entry,
@@ -986,14 +1403,24 @@ delta_dirs (struct context *c,
       const void *key;
       void *val;
       apr_ssize_t klen;
-      svn_stringbuf_t *target_fullpath =
-        svn_stringbuf_create (target_path, subpool);
+      svn_indexed_path_t *target_fullpath;
           
       /* KEY is the entry name in target, VAL the dirent */
       apr_hash_this (hi, &key, &klen, &val);
       t_entry = val;
 
-      svn_path_add_component_nts (target_fullpath, t_entry->name);
+      target_fullpath = svn_path_index_join (c->paths, target_path,
+                                             t_entry->name);
+
+      /* If a path filter rules this entry out, neither side of the
+         walk touches it: no editor calls, no node access, and no
+         delete when the leftover-source sweep below runs. */
+      if (! path_filter_wanted (c->filter, target_fullpath->path))
+        {
+          if (s_entries)
+            apr_hash_set (s_entries, key, klen, NULL);
+          continue;
+        }
 
       /* Can we find something with the same name in the source
          entries hash? */
@@ -1002,30 +1429,55 @@ delta_dirs (struct context *c,
         {
           int distance;
           int is_dir;
-          SVN_ERR (svn_fs_is_dir (&is_dir,
-                                  c->target_root, target_fullpath->data,
-                                  subpool));
 
-          if (c->recurse || !is_dir)
+          /* Check the distance between the ids before touching the
+             filesystem again.
+
+             0 means they are the same id.  Since a node's id changes
+             whenever anything beneath it changes, the two subtrees
+             are identical, and we can skip them without even looking
+             inside --- this is what keeps the cost of a delta
+             proportional to the size of the change, rather than the
+             size of the tree.
+
+             -1 means they are unrelated, so try to find an ancestor
+             elsewhere in the directory.  Theoretically, using an
+             ancestor as a baseline will reduce the size of the deltas.
+
+             Any other positive value means the nodes are related
+             through ancestry, so go ahead and do the replace
+             directly.  */
+          distance = svn_fs_id_distance (s_entry->id, t_entry->id);
+
+          /* Over an in-memory report base, equal ids only vouch for
+             the revision the source id was read from; if the client
+             reported deeper paths at other revisions (or deleted
+             some), descend anyway. */
+          if (distance == 0 && c->base)
             {
+              svn_indexed_path_t *source_fullpath
+                = svn_path_index_join (c->paths, source_path,
+                                       t_entry->name);
+
+              if (base_subtree_divergent (c, source_fullpath->path,
+                                          get_revision_from_hash
+                                          (c->source_rev_diffs,
+                                           source_fullpath->path, subpool),
+                                          subpool))
+                distance = 1;
+            }
 
-              /* Check the distance between the ids.  
-
-                 0 means they are the same id, and this is a noop.
-
-                 -1 means they are unrelated, so try to find an ancestor
-                 elsewhere in the directory.  Theoretically, using an
-                 ancestor as a baseline will reduce the size of the deltas.
+          if (distance == 0)
+            {
+              /* no-op */
+            }
+          else if (distance == -1)
+            {
+              SVN_ERR (svn_fs_is_dir (&is_dir,
+                                      c->target_root, target_fullpath->path,
+                                      subpool));
 
-                 Any other positive value means the nodes are related
-                 through ancestry, so go ahead and do the replace
-                 directly.  */
-              distance = svn_fs_id_distance (s_entry->id, t_entry->id);
-              if (distance == 0)
-                {
-                  /* no-op */
-                }
-              else if (distance == -1)
+              if (c->recurse || !is_dir)
                 {
                   svn_fs_dirent_t *best_entry;
                   int best_distance = distance;
@@ -1065,7 +1517,14 @@ delta_dirs (struct context *c,
                                 subpool));
                     } 
                 }
-              else
+            }
+          else
+            {
+              SVN_ERR (svn_fs_is_dir (&is_dir,
+                                      c->target_root, target_fullpath->path,
+                                      subpool));
+
+              if (c->recurse || !is_dir)
                 {
                   SVN_ERR (replace_file_or_dir
                            (c, dir_baton, 
@@ -1084,7 +1543,7 @@ delta_dirs (struct context *c,
         {
           int is_dir;
           SVN_ERR (svn_fs_is_dir (&is_dir, c->target_root,
-                                  target_fullpath->data, subpool));
+                                  target_fullpath->path, subpool));
 
           if (c->recurse || !is_dir)
             {
@@ -1136,19 +1595,37 @@ delta_dirs (struct context *c,
           const void *key;
           void *val;
           apr_ssize_t klen;
-          svn_stringbuf_t *source_fullpath = svn_stringbuf_create (source_path,
-                                                                   subpool);
+          svn_indexed_path_t *source_fullpath;
+          svn_fs_root_t *s_root;
           int is_dir;
           
           /* KEY is the entry name in source, VAL the dirent */
           apr_hash_this (hi, &key, &klen, &val);
           s_entry = val;
-          svn_path_add_component_nts (source_fullpath, s_entry->name);
+
+          /* The filter speaks in target-tree paths, so test the
+             entry's would-be path under TARGET_PATH before deleting
+             it.  (Entries the filter pruned from the target loop
+             above were already removed from this hash.) */
+          if (c->filter)
+            {
+              svn_indexed_path_t *p
+                = svn_path_index_join (c->paths, target_path, s_entry->name);
+
+              if (! path_filter_wanted (c->filter, p->path))
+                continue;
+            }
+
+          source_fullpath = svn_path_index_join (c->paths, source_path,
+                                                 s_entry->name);
+
+          SVN_ERR (resolve_source (&s_root, c, source_fullpath->path,
+                                   subpool));
 
           /* Do we actually want to delete the dir if we're non-recursive? */
           SVN_ERR (svn_fs_is_dir (&is_dir,
-                                  c->source_root,
-                                  source_fullpath->data,
+                                  s_root,
+                                  source_fullpath->path,
                                   subpool));
 
           if (c->recurse || !is_dir)
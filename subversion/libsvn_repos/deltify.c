@@ -0,0 +1,181 @@
+/* deltify.c : queued deltification of committed data
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "apr_pools.h"
+#include "apr_file_io.h"
+#include "apr_strings.h"
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "repos.h"
+
+
+/* Deltification takes real CPU and database time, and running it
+   inside the committer's call path (say, from a post-commit hook)
+   makes every big commit wait for it.  Instead, the hook can append
+   the revision and path to a queue file in the repository, and some
+   other process --- a cron job running `svnadmin rundeltify', for
+   example --- does the actual work later.
+
+   The queue is a plain text file, one "REVISION PATH" entry per
+   line, appended to with O_APPEND so concurrent committers don't
+   need to take a lock.  The drainer renames the queue aside before
+   working through it, so new entries accumulate in a fresh file
+   while it runs; if a drain dies partway, the renamed file is picked
+   up again by the next drain.  */
+
+
+/* Return the path of REPOS's deltification queue file, allocated in
+   POOL.  */
+static const char *
+deltify_queue_path (svn_repos_t *repos, apr_pool_t *pool)
+{
+  return apr_pstrcat (pool,
+                      repos->path, "/" SVN_REPOS__DELTIFY_QUEUE,
+                      NULL);
+}
+
+
+svn_error_t *
+svn_repos_deltify_enqueue (svn_repos_t *repos,
+                           svn_revnum_t revision,
+                           const char *path,
+                           apr_pool_t *pool)
+{
+  const char *queue_path = deltify_queue_path (repos, pool);
+  const char *line = apr_psprintf (pool, "%ld %s\n",
+                                   (long int) revision, path);
+  apr_file_t *queue_file;
+  apr_status_t apr_err;
+
+  apr_err = apr_file_open (&queue_file, queue_path,
+                           APR_WRITE | APR_APPEND | APR_CREATE,
+                           APR_OS_DEFAULT, pool);
+  if (! APR_STATUS_IS_SUCCESS (apr_err))
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "opening deltification queue `%s'",
+                              queue_path);
+
+  apr_err = apr_file_write_full (queue_file, line, strlen (line), NULL);
+  if (! APR_STATUS_IS_SUCCESS (apr_err))
+    {
+      apr_file_close (queue_file);
+      return svn_error_createf (apr_err, 0, 0, pool,
+                                "writing deltification queue `%s'",
+                                queue_path);
+    }
+
+  apr_err = apr_file_close (queue_file);
+  if (! APR_STATUS_IS_SUCCESS (apr_err))
+    return svn_error_createf (apr_err, 0, 0, pool,
+                              "closing deltification queue `%s'",
+                              queue_path);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_deltify_drain (svn_repos_t *repos,
+                         apr_pool_t *pool)
+{
+  const char *queue_path = deltify_queue_path (repos, pool);
+  const char *working_path = apr_pstrcat (pool, queue_path, ".working",
+                                          NULL);
+  enum svn_node_kind kind;
+  svn_stringbuf_t *contents;
+  apr_pool_t *subpool;
+  char *line, *next;
+
+  /* Pick up a working file left behind by an earlier drain that
+     died, before claiming any new work.  */
+  SVN_ERR (svn_io_check_path (working_path, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      apr_status_t apr_err;
+
+      SVN_ERR (svn_io_check_path (queue_path, &kind, pool));
+      if (kind == svn_node_none)
+        return SVN_NO_ERROR;
+
+      /* Move the queue aside, so committers can keep appending to a
+         fresh one while we work.  */
+      apr_err = apr_file_rename (queue_path, working_path, pool);
+      if (! APR_STATUS_IS_SUCCESS (apr_err))
+        return svn_error_createf (apr_err, 0, 0, pool,
+                                  "renaming deltification queue `%s'",
+                                  queue_path);
+    }
+
+  SVN_ERR (svn_string_from_file (&contents, working_path, pool));
+
+  subpool = svn_pool_create (pool);
+  for (line = contents->data; line && *line; line = next)
+    {
+      char *eol = strchr (line, '\n');
+      char *sep;
+      svn_revnum_t revision;
+      const char *target;
+      svn_fs_root_t *root;
+      int is_dir;
+
+      if (eol)
+        {
+          *eol = '\0';
+          next = eol + 1;
+        }
+      else
+        next = NULL;
+
+      if (*line == '\0')
+        continue;
+
+      sep = strchr (line, ' ');
+      if (! sep)
+        return svn_error_createf (SVN_ERR_MALFORMED_FILE, 0, 0, pool,
+                                  "malformed deltification queue entry `%s'",
+                                  line);
+      *sep = '\0';
+      revision = SVN_STR_TO_REV (line);
+      target = sep + 1;
+
+      SVN_ERR (svn_fs_revision_root (&root, repos->fs, revision, subpool));
+      SVN_ERR (svn_fs_is_dir (&is_dir, root, target, subpool));
+      SVN_ERR (svn_fs_deltify (root, target, is_dir, subpool));
+
+      svn_pool_clear (subpool);
+    }
+  svn_pool_destroy (subpool);
+
+  /* All done; the working file's entries are deltified.  */
+  SVN_ERR (svn_io_remove_file (working_path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
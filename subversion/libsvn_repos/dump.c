@@ -0,0 +1,942 @@
+/* dump.c --- writing and reading portable repository dump streams
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include "apr_strings.h"
+#include "apr_hash.h"
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_path.h"
+#include "svn_sorts.h"
+#include "svn_delta.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "repos.h"
+
+
+/* The dump stream is a sequence of records, each a block of RFC822ish
+   headers, a blank line, the record's content, and another blank
+   line.  A revision record carries the revision's property list; it
+   is followed by one node record for each path the revision changed.
+   A node record's content is a property block (how to change the
+   node's properties) followed by an svndiff-format text delta (how to
+   change a file's contents, relative to its previous contents ---
+   thus "delta cost instead of full-file cost").
+
+   A property block is a series of entries in svn_hash_write's
+   key/value format --- "K <length>", name, "V <length>", value ---
+   plus "D <length>"/name entries for deleted properties, terminated
+   by a line reading "END".
+
+   The records for revisions your repository already has are skipped
+   when loading, so dumping from revision zero and loading the result
+   into a backup repository is always safe, and dumping from the
+   backup's youngest revision gives an incremental backup.  */
+
+#define DUMP_MAGIC_HEADER      "SVN-fs-dump-format-version"
+#define DUMP_FORMAT_VERSION    1
+
+#define DUMP_H_REVISION        "Revision-number"
+#define DUMP_H_NODE_PATH       "Node-path"
+#define DUMP_H_NODE_KIND       "Node-kind"
+#define DUMP_H_NODE_ACTION     "Node-action"
+#define DUMP_H_PROP_LENGTH     "Prop-content-length"
+#define DUMP_H_TEXT_LENGTH     "Text-content-length"
+#define DUMP_H_CONTENT_LENGTH  "Content-length"
+
+
+/*** Helper streams and formatted output. ***/
+
+/* A write handler that appends everything written to the
+   svn_stringbuf_t BATON, so a record's content can be measured before
+   its headers go out. */
+static svn_error_t *
+write_to_stringbuf (void *baton, const char *data, apr_size_t *len)
+{
+  svn_stringbuf_appendbytes (baton, data, *len);
+  return SVN_NO_ERROR;
+}
+
+
+/* Return a writable stream which collects its output in BUF. */
+static svn_stream_t *
+stringbuf_stream (svn_stringbuf_t *buf, apr_pool_t *pool)
+{
+  svn_stream_t *stream = svn_stream_create (buf, pool);
+  svn_stream_set_write (stream, write_to_stringbuf);
+  return stream;
+}
+
+
+/* Write a printf-style formatted string to STREAM.  Use POOL for
+   temporary allocation. */
+static svn_error_t *
+stream_printf (svn_stream_t *stream,
+               apr_pool_t *pool,
+               const char *fmt,
+               ...)
+{
+  const char *buf;
+  va_list ap;
+  apr_size_t len;
+
+  va_start (ap, fmt);
+  buf = apr_pvsprintf (pool, fmt, ap);
+  va_end (ap);
+
+  len = strlen (buf);
+  return svn_stream_write (stream, buf, &len);
+}
+
+
+/*** Dumping. ***/
+
+/* Append to BUF a property block turning the property list OLD_PROPS
+   (which may be NULL, meaning no properties) into NEW_PROPS.  Use
+   POOL for temporary allocation. */
+static void
+write_prop_block (svn_stringbuf_t *buf,
+                  apr_hash_t *old_props,
+                  apr_hash_t *new_props,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  /* Set every property whose value is new or different. */
+  for (hi = apr_hash_first (pool, new_props); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+      const char *name;
+      svn_string_t *value, *old_value;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      name = key;
+      value = val;
+
+      old_value = old_props
+        ? apr_hash_get (old_props, name, APR_HASH_KEY_STRING) : NULL;
+      if (old_value
+          && (old_value->len == value->len)
+          && (! memcmp (old_value->data, value->data, value->len)))
+        continue;
+
+      svn_stringbuf_appendcstr
+        (buf, apr_psprintf (pool, "K %" APR_SIZE_T_FMT "\n%s\n",
+                            strlen (name), name));
+      svn_stringbuf_appendcstr
+        (buf, apr_psprintf (pool, "V %" APR_SIZE_T_FMT "\n", value->len));
+      svn_stringbuf_appendbytes (buf, value->data, value->len);
+      svn_stringbuf_appendcstr (buf, "\n");
+    }
+
+  /* Delete every property that's gone. */
+  if (old_props)
+    for (hi = apr_hash_first (pool, old_props); hi; hi = apr_hash_next (hi))
+      {
+        const void *key;
+        const char *name;
+
+        apr_hash_this (hi, &key, NULL, NULL);
+        name = key;
+
+        if (! apr_hash_get (new_props, name, APR_HASH_KEY_STRING))
+          svn_stringbuf_appendcstr
+            (buf, apr_psprintf (pool, "D %" APR_SIZE_T_FMT "\n%s\n",
+                                strlen (name), name));
+      }
+
+  svn_stringbuf_appendcstr (buf, "END\n");
+}
+
+
+/* Append to BUF an svndiff-format delta turning the contents of PATH
+   under FROM_ROOT (or the empty string, if FROM_ROOT is NULL) into
+   the contents of PATH under TO_ROOT.  Use POOL for temporary
+   allocation.
+
+   Note that this buffers one file's svndiff in memory; deltas are
+   small, and it's what lets the record's length headers precede its
+   content. */
+static svn_error_t *
+write_text_delta (svn_stringbuf_t *buf,
+                  svn_fs_root_t *from_root,
+                  svn_fs_root_t *to_root,
+                  const char *path,
+                  apr_pool_t *pool)
+{
+  svn_stream_t *source, *target;
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  if (from_root)
+    SVN_ERR (svn_fs_file_contents (&source, from_root, path, pool));
+  else
+    source = svn_stream_empty (pool);
+  SVN_ERR (svn_fs_file_contents (&target, to_root, path, pool));
+
+  svn_txdelta (&delta_stream, source, target, pool);
+  svn_txdelta_to_svndiff (stringbuf_stream (buf, pool), pool,
+                          &handler, &handler_baton);
+  SVN_ERR (svn_txdelta_send_txstream (delta_stream, handler, handler_baton,
+                                      pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Write to STREAM a node record for PATH (which begins with '/', as
+   in the hash svn_fs_paths_changed returns), carrying ACTION ("add",
+   "change", "delete", or "replace"), with content built from
+   FROM_ROOT (the revision before, or NULL for "add") and TO_ROOT.
+   Use POOL for temporary allocation.  */
+static svn_error_t *
+dump_node (svn_stream_t *stream,
+           svn_fs_root_t *from_root,
+           svn_fs_root_t *to_root,
+           const char *path,
+           const char *action,
+           apr_pool_t *pool)
+{
+  svn_stringbuf_t *propbuf = NULL, *textbuf = NULL;
+  apr_size_t content_len = 0;
+  int is_dir = 0;
+
+  /* Strip the leading slash; the dump format stores paths relative to
+     the repository root. */
+  SVN_ERR (stream_printf (stream, pool, DUMP_H_NODE_PATH ": %s\n",
+                          (*path == '/') ? path + 1 : path));
+
+  if (strcmp (action, "delete") != 0)
+    {
+      SVN_ERR (svn_fs_is_dir (&is_dir, to_root, path, pool));
+      SVN_ERR (stream_printf (stream, pool, DUMP_H_NODE_KIND ": %s\n",
+                              is_dir ? "dir" : "file"));
+    }
+  SVN_ERR (stream_printf (stream, pool, DUMP_H_NODE_ACTION ": %s\n",
+                          action));
+
+  if (strcmp (action, "delete") != 0)
+    {
+      apr_hash_t *old_props = NULL, *new_props;
+      int changed;
+
+      /* Property block, but only if something actually changed. */
+      if (from_root)
+        SVN_ERR (svn_fs_props_changed (&changed, from_root, path,
+                                       to_root, path, pool));
+      else
+        changed = 1;
+      if (changed)
+        {
+          if (from_root)
+            SVN_ERR (svn_fs_node_proplist (&old_props, from_root, path,
+                                           pool));
+          SVN_ERR (svn_fs_node_proplist (&new_props, to_root, path, pool));
+          propbuf = svn_stringbuf_create ("", pool);
+          write_prop_block (propbuf, old_props, new_props, pool);
+          content_len += propbuf->len;
+        }
+
+      /* Text delta, for files whose contents changed. */
+      if (! is_dir)
+        {
+          if (from_root)
+            SVN_ERR (svn_fs_contents_changed (&changed, from_root, path,
+                                              to_root, path, pool));
+          else
+            changed = 1;
+          if (changed)
+            {
+              textbuf = svn_stringbuf_create ("", pool);
+              SVN_ERR (write_text_delta (textbuf, from_root, to_root,
+                                         path, pool));
+              content_len += textbuf->len;
+            }
+        }
+
+      if (propbuf)
+        SVN_ERR (stream_printf (stream, pool,
+                                DUMP_H_PROP_LENGTH ": %" APR_SIZE_T_FMT "\n",
+                                propbuf->len));
+      if (textbuf)
+        SVN_ERR (stream_printf (stream, pool,
+                                DUMP_H_TEXT_LENGTH ": %" APR_SIZE_T_FMT "\n",
+                                textbuf->len));
+    }
+
+  SVN_ERR (stream_printf (stream, pool,
+                          DUMP_H_CONTENT_LENGTH ": %" APR_SIZE_T_FMT "\n\n",
+                          content_len));
+
+  if (propbuf)
+    {
+      apr_size_t len = propbuf->len;
+      SVN_ERR (svn_stream_write (stream, propbuf->data, &len));
+    }
+  if (textbuf)
+    {
+      apr_size_t len = textbuf->len;
+      SVN_ERR (svn_stream_write (stream, textbuf->data, &len));
+    }
+
+  SVN_ERR (stream_printf (stream, pool, "\n"));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Like log.c:detect_changed --- store in CHANGED, as keys, the
+   '/'-rooted paths at or below NODE that changed, mapped to (void *)
+   'A', 'D', or 'R'.  Used when a revision predates the changed-paths
+   index. */
+static void
+collect_changed (apr_hash_t *changed,
+                 svn_repos_node_t *node,
+                 svn_stringbuf_t *path,
+                 apr_pool_t *pool)
+{
+  if (node->sibling)
+    collect_changed (changed, node->sibling, path, pool);
+
+  if (node->name && *(node->name))
+    svn_path_add_component_nts (path, node->name);
+
+  if (node->child)
+    collect_changed (changed, node->child, path, pool);
+
+  /* Directory opens with no prop mods are just bubble-up. */
+  if (! ((node->kind == svn_node_dir)
+         && (node->action == 'R')
+         && (! node->prop_mod)))
+    apr_hash_set (changed,
+                  apr_pstrdup (pool, path->data), path->len,
+                  (void *) ((int) node->action));
+
+  svn_path_remove_component (path);
+  if (path->len == 0)
+    svn_stringbuf_appendcstr (path, "/");
+}
+
+
+/* Set *CHANGED_P to a hash of the paths changed in REV of FS, as
+   svn_fs_paths_changed would return it, falling back on a dir_delta
+   walk when REV predates the changed-paths index.  Use POOL for all
+   allocations. */
+static svn_error_t *
+get_changed_paths (apr_hash_t **changed_p,
+                   svn_fs_t *fs,
+                   svn_revnum_t rev,
+                   apr_pool_t *pool)
+{
+  SVN_ERR (svn_fs_paths_changed (changed_p, fs, rev, pool));
+  if (! *changed_p)
+    {
+      const svn_delta_edit_fns_t *editor;
+      svn_fs_root_t *oldroot, *newroot;
+      void *edit_baton;
+
+      *changed_p = apr_hash_make (pool);
+      SVN_ERR (svn_fs_revision_root (&oldroot, fs, rev - 1, pool));
+      SVN_ERR (svn_fs_revision_root (&newroot, fs, rev, pool));
+      SVN_ERR (svn_repos_node_editor (&editor, &edit_baton, fs,
+                                      oldroot, newroot, pool, pool));
+      SVN_ERR (svn_repos_dir_delta (oldroot, "", NULL, NULL,
+                                    newroot, "",
+                                    editor, edit_baton,
+                                    FALSE, TRUE, FALSE, NULL, pool));
+      collect_changed (*changed_p,
+                       svn_repos_node_from_baton (edit_baton),
+                       svn_stringbuf_create ("/", pool),
+                       pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Write to STREAM the revision record and node records for revision
+   REV of FS.  SORTED is a scratch array for path sorting, reused
+   across revisions.  Use POOL for temporary allocation. */
+static svn_error_t *
+dump_revision (svn_stream_t *stream,
+               svn_fs_t *fs,
+               svn_revnum_t rev,
+               apr_array_header_t *sorted,
+               apr_pool_t *pool)
+{
+  apr_hash_t *rev_props;
+  svn_stringbuf_t *propbuf = svn_stringbuf_create ("", pool);
+
+  /* The revision record, carrying the revision's property list. */
+  SVN_ERR (svn_fs_revision_proplist (&rev_props, fs, rev, pool));
+  write_prop_block (propbuf, NULL, rev_props, pool);
+
+  SVN_ERR (stream_printf (stream, pool, DUMP_H_REVISION ": %ld\n", rev));
+  SVN_ERR (stream_printf (stream, pool,
+                          DUMP_H_PROP_LENGTH ": %" APR_SIZE_T_FMT "\n",
+                          propbuf->len));
+  SVN_ERR (stream_printf (stream, pool,
+                          DUMP_H_CONTENT_LENGTH ": %" APR_SIZE_T_FMT "\n\n",
+                          propbuf->len));
+  {
+    apr_size_t len = propbuf->len;
+    SVN_ERR (svn_stream_write (stream, propbuf->data, &len));
+  }
+  SVN_ERR (stream_printf (stream, pool, "\n"));
+
+  /* The node records, in path order, so that a directory's record
+     precedes the records for things inside it. */
+  if (rev > 0)
+    {
+      apr_hash_t *changed;
+      svn_fs_root_t *from_root, *to_root;
+      int i;
+
+      SVN_ERR (get_changed_paths (&changed, fs, rev, pool));
+      svn_sort_hash_keys (sorted, changed, svn_sort_compare_items_as_paths,
+                          pool);
+
+      SVN_ERR (svn_fs_revision_root (&from_root, fs, rev - 1, pool));
+      SVN_ERR (svn_fs_revision_root (&to_root, fs, rev, pool));
+
+      for (i = 0; i < sorted->nelts; i++)
+        {
+          svn_item_t *item = &APR_ARRAY_IDX (sorted, i, svn_item_t);
+          const char *path = item->key;
+          char action = (char) ((int) item->value);
+
+          switch (action)
+            {
+            case 'A':
+              SVN_ERR (dump_node (stream, NULL, to_root, path, "add",
+                                  pool));
+              break;
+            case 'D':
+              SVN_ERR (dump_node (stream, from_root, to_root, path,
+                                  "delete", pool));
+              break;
+            default:  /* 'R' */
+              {
+                /* If the node changed kinds, a "change" can't express
+                   it; replace it outright. */
+                svn_node_kind_t old_kind
+                  = svn_fs_check_path (from_root, path, pool);
+                svn_node_kind_t new_kind
+                  = svn_fs_check_path (to_root, path, pool);
+
+                if (old_kind != new_kind)
+                  SVN_ERR (dump_node (stream, NULL, to_root, path,
+                                      "replace", pool));
+                else
+                  SVN_ERR (dump_node (stream, from_root, to_root, path,
+                                      "change", pool));
+              }
+              break;
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_dump_fs (svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs = repos->fs;
+  svn_revnum_t youngest, rev;
+  apr_pool_t *subpool = svn_pool_create (pool);
+  apr_array_header_t *sorted
+    = apr_array_make (pool, 1, sizeof (svn_item_t));
+
+  SVN_ERR (svn_fs_youngest_rev (&youngest, fs, pool));
+
+  /* Default to dumping the whole history. */
+  if (! SVN_IS_VALID_REVNUM (start_rev))
+    start_rev = 0;
+  if (! SVN_IS_VALID_REVNUM (end_rev))
+    end_rev = youngest;
+
+  if ((start_rev > end_rev) || (end_rev > youngest))
+    return svn_error_createf
+      (SVN_ERR_FS_NO_SUCH_REVISION, 0, NULL, pool,
+       "svn_repos_dump_fs: bad revision range %ld:%ld (youngest is %ld)",
+       start_rev, end_rev, youngest);
+
+  SVN_ERR (stream_printf (stream, pool, DUMP_MAGIC_HEADER ": %d\n\n",
+                          DUMP_FORMAT_VERSION));
+
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      SVN_ERR (dump_revision (stream, fs, rev, sorted, subpool));
+      svn_pool_clear (subpool);
+    }
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Loading. ***/
+
+/* Read a line from STREAM into *LINE_P (without the newline),
+   allocated in POOL.  Set *EOF_P if the stream ends before any bytes
+   are read. */
+static svn_error_t *
+read_line (svn_stringbuf_t **line_p,
+           svn_boolean_t *eof_p,
+           svn_stream_t *stream,
+           apr_pool_t *pool)
+{
+  svn_stringbuf_t *line = svn_stringbuf_create ("", pool);
+
+  *eof_p = FALSE;
+  while (1)
+    {
+      char c;
+      apr_size_t len = 1;
+
+      SVN_ERR (svn_stream_read (stream, &c, &len));
+      if (len == 0)
+        {
+          if (line->len == 0)
+            *eof_p = TRUE;
+          break;
+        }
+      if (c == '\n')
+        break;
+      svn_stringbuf_appendbytes (line, &c, 1);
+    }
+
+  *line_p = line;
+  return SVN_NO_ERROR;
+}
+
+
+/* Read LEN bytes from STREAM into BUF (which must have room for
+   them), erroring out if the stream ends early. */
+static svn_error_t *
+read_content (char *buf,
+              apr_size_t len,
+              svn_stream_t *stream,
+              apr_pool_t *pool)
+{
+  while (len > 0)
+    {
+      apr_size_t chunk = len;
+
+      SVN_ERR (svn_stream_read (stream, buf, &chunk));
+      if (chunk == 0)
+        return svn_error_create
+          (SVN_ERR_UNEXPECTED_EOF, 0, NULL, pool,
+           "svn_repos_load_fs: dump stream ended mid-record");
+      buf += chunk;
+      len -= chunk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Read a record's header block from STREAM --- "Name: value" lines up
+   to a blank line --- into a hash mapping header names onto values,
+   both allocated in POOL.  Leading blank lines are skipped.  Set
+   *EOF_P and return an empty hash if the stream is exhausted
+   instead. */
+static svn_error_t *
+read_header_block (apr_hash_t **headers_p,
+                   svn_boolean_t *eof_p,
+                   svn_stream_t *stream,
+                   apr_pool_t *pool)
+{
+  apr_hash_t *headers = apr_hash_make (pool);
+
+  while (1)
+    {
+      svn_stringbuf_t *line;
+      char *colon;
+
+      SVN_ERR (read_line (&line, eof_p, stream, pool));
+      if (*eof_p)
+        break;
+      if (line->len == 0)
+        {
+          if (apr_hash_count (headers) == 0)
+            continue;           /* skip blank lines between records */
+          break;
+        }
+
+      colon = strchr (line->data, ':');
+      if ((! colon) || (colon[1] != ' '))
+        return svn_error_createf
+          (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+           "svn_repos_load_fs: malformed dump header `%s'", line->data);
+      *colon = '\0';
+      apr_hash_set (headers, line->data, APR_HASH_KEY_STRING, colon + 2);
+    }
+
+  *headers_p = headers;
+  return SVN_NO_ERROR;
+}
+
+
+/* Parse the property block in the LEN bytes at DATA, appending
+   properties to set to *PROPS (a hash mapping names onto svn_string_t
+   values) and names to delete to *DELETED (an array of const char *).
+   Allocate in POOL. */
+static svn_error_t *
+parse_prop_block (apr_hash_t *props,
+                  apr_array_header_t *deleted,
+                  const char *data,
+                  apr_size_t len,
+                  apr_pool_t *pool)
+{
+  const char *p = data;
+  const char *end = data + len;
+
+  while (p < end)
+    {
+      char kind;
+      apr_size_t item_len;
+      const char *item;
+      const char *newline = memchr (p, '\n', end - p);
+
+      if (! newline)
+        break;
+
+      if ((newline - p == 3) && (! memcmp (p, "END", 3)))
+        return SVN_NO_ERROR;
+
+      if (((*p != 'K') && (*p != 'V') && (*p != 'D')) || (p[1] != ' '))
+        break;
+      kind = *p;
+      item_len = atol (p + 2);
+      p = newline + 1;
+      if (p + item_len + 1 > end)
+        break;
+      item = apr_pstrndup (pool, p, item_len);
+      p += item_len + 1;        /* skip the trailing newline too */
+
+      if (kind == 'K')
+        {
+          /* A name; a value must follow immediately. */
+          if ((p >= end) || (*p != 'V'))
+            break;
+          newline = memchr (p, '\n', end - p);
+          if (! newline)
+            break;
+          item_len = atol (p + 2);
+          p = newline + 1;
+          if (p + item_len + 1 > end)
+            break;
+          apr_hash_set (props, item, APR_HASH_KEY_STRING,
+                        svn_string_ncreate (p, item_len, pool));
+          p += item_len + 1;
+        }
+      else if (kind == 'D')
+        (*((const char **) apr_array_push (deleted))) = item;
+      else
+        break;                  /* a 'V' with no preceding 'K' */
+    }
+
+  return svn_error_create
+    (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+     "svn_repos_load_fs: malformed property block in dump stream");
+}
+
+
+/* The loader's running state: the transaction being built for the
+   revision currently being read, if any. */
+struct load_baton
+{
+  svn_fs_t *fs;
+
+  /* The revision number the current revision record claims, and the
+     transaction mirroring it; TXN is null between revisions, and when
+     the record's revision is one the filesystem already has. */
+  svn_revnum_t rev;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+
+  /* The revision record's property list, applied after commit. */
+  apr_hash_t *rev_props;
+
+  /* The pool TXN lives in, destroyed when the revision closes. */
+  apr_pool_t *txn_pool;
+};
+
+
+/* Commit B's pending transaction, if any, verify it produced the
+   revision its record promised, and install the dumped revision
+   properties.  Use POOL for temporary allocation. */
+static svn_error_t *
+close_revision (struct load_baton *b, apr_pool_t *pool)
+{
+  const char *conflict;
+  svn_revnum_t new_rev;
+  apr_hash_index_t *hi;
+
+  if (! b->txn)
+    return SVN_NO_ERROR;
+
+  SVN_ERR (svn_fs_commit_txn (&conflict, &new_rev, b->txn));
+  if (new_rev != b->rev)
+    return svn_error_createf
+      (SVN_ERR_FS_GENERAL, 0, NULL, pool,
+       "svn_repos_load_fs: committed revision %ld, but the dump stream "
+       "says %ld", new_rev, b->rev);
+
+  /* The dumped properties (including svn:date) override whatever the
+     commit itself set. */
+  for (hi = apr_hash_first (pool, b->rev_props); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      SVN_ERR (svn_fs_change_rev_prop (b->fs, new_rev, key, val, pool));
+    }
+
+  b->txn = NULL;
+  b->txn_root = NULL;
+  svn_pool_destroy (b->txn_pool);
+  b->txn_pool = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Apply the node record described by HEADERS, whose content is the
+   LEN bytes at CONTENT, to B's transaction.  PROP_LEN of the content
+   is a property block; the rest is an svndiff text delta.  Use POOL
+   for temporary allocation. */
+static svn_error_t *
+load_node (struct load_baton *b,
+           apr_hash_t *headers,
+           const char *content,
+           apr_size_t prop_len,
+           apr_size_t len,
+           apr_pool_t *pool)
+{
+  const char *path = apr_hash_get (headers, DUMP_H_NODE_PATH,
+                                   APR_HASH_KEY_STRING);
+  const char *action = apr_hash_get (headers, DUMP_H_NODE_ACTION,
+                                     APR_HASH_KEY_STRING);
+  const char *kind = apr_hash_get (headers, DUMP_H_NODE_KIND,
+                                   APR_HASH_KEY_STRING);
+  int is_dir = kind && (! strcmp (kind, "dir"));
+
+  if ((! path) || (! action))
+    return svn_error_create
+      (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+       "svn_repos_load_fs: node record missing a path or action");
+
+  if ((! strcmp (action, "delete")) || (! strcmp (action, "replace")))
+    SVN_ERR (svn_fs_delete_tree (b->txn_root, path, pool));
+
+  if ((! strcmp (action, "add")) || (! strcmp (action, "replace")))
+    {
+      if (is_dir)
+        SVN_ERR (svn_fs_make_dir (b->txn_root, path, pool));
+      else
+        SVN_ERR (svn_fs_make_file (b->txn_root, path, pool));
+    }
+
+  if (! strcmp (action, "delete"))
+    return SVN_NO_ERROR;
+
+  /* Properties. */
+  if (prop_len > 0)
+    {
+      apr_hash_t *props = apr_hash_make (pool);
+      apr_array_header_t *deleted
+        = apr_array_make (pool, 4, sizeof (const char *));
+      apr_hash_index_t *hi;
+      int i;
+
+      SVN_ERR (parse_prop_block (props, deleted, content, prop_len, pool));
+      for (hi = apr_hash_first (pool, props); hi; hi = apr_hash_next (hi))
+        {
+          const void *key;
+          void *val;
+
+          apr_hash_this (hi, &key, NULL, &val);
+          SVN_ERR (svn_fs_change_node_prop (b->txn_root, path, key, val,
+                                            pool));
+        }
+      for (i = 0; i < deleted->nelts; i++)
+        SVN_ERR (svn_fs_change_node_prop
+                 (b->txn_root, path,
+                  APR_ARRAY_IDX (deleted, i, const char *), NULL, pool));
+    }
+
+  /* Text. */
+  if (len > prop_len)
+    {
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *svndiff_stream;
+      apr_size_t text_len = len - prop_len;
+
+      SVN_ERR (svn_fs_apply_textdelta (&handler, &handler_baton,
+                                       b->txn_root, path, pool));
+      svndiff_stream = svn_txdelta_parse_svndiff (handler, handler_baton,
+                                                  TRUE, pool);
+      SVN_ERR (svn_stream_write (svndiff_stream, content + prop_len,
+                                 &text_len));
+      SVN_ERR (svn_stream_close (svndiff_stream));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_load_fs (svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   apr_pool_t *pool)
+{
+  struct load_baton b;
+  svn_revnum_t youngest;
+  svn_stringbuf_t *line;
+  svn_boolean_t eof;
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  b.fs = repos->fs;
+  b.txn = NULL;
+  b.txn_root = NULL;
+  b.txn_pool = NULL;
+  b.rev = SVN_INVALID_REVNUM;
+  b.rev_props = NULL;
+
+  SVN_ERR (svn_fs_youngest_rev (&youngest, b.fs, pool));
+
+  /* Check the magic header. */
+  SVN_ERR (read_line (&line, &eof, stream, pool));
+  if (eof
+      || strncmp (line->data, DUMP_MAGIC_HEADER ": ",
+                  strlen (DUMP_MAGIC_HEADER ": "))
+      || (atoi (line->data + strlen (DUMP_MAGIC_HEADER ": "))
+          > DUMP_FORMAT_VERSION))
+    return svn_error_create
+      (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+       "svn_repos_load_fs: input is not a Subversion dump stream, "
+       "or its format is too new");
+
+  while (1)
+    {
+      apr_hash_t *headers;
+      const char *val;
+      apr_size_t content_len = 0, prop_len = 0;
+      char *content = NULL;
+
+      SVN_ERR (read_header_block (&headers, &eof, stream, subpool));
+      if (eof)
+        break;
+
+      if ((val = apr_hash_get (headers, DUMP_H_CONTENT_LENGTH,
+                               APR_HASH_KEY_STRING)))
+        content_len = atol (val);
+      if ((val = apr_hash_get (headers, DUMP_H_PROP_LENGTH,
+                               APR_HASH_KEY_STRING)))
+        prop_len = atol (val);
+
+      if ((val = apr_hash_get (headers, DUMP_H_REVISION,
+                               APR_HASH_KEY_STRING)))
+        {
+          /* A new revision record closes the one before it. */
+          SVN_ERR (close_revision (&b, subpool));
+          b.rev = SVN_STR_TO_REV (val);
+
+          if (b.rev <= youngest)
+            {
+              /* We already have this revision; skip its records.
+                 This is what makes an incremental stream loadable
+                 from the beginning, and a load resumable. */
+              content = apr_palloc (subpool, content_len ? content_len : 1);
+              SVN_ERR (read_content (content, content_len, stream, subpool));
+            }
+          else if (b.rev != youngest + 1)
+            return svn_error_createf
+              (SVN_ERR_FS_NO_SUCH_REVISION, 0, NULL, pool,
+               "svn_repos_load_fs: dump stream wants to create revision "
+               "%ld, but the filesystem's youngest is %ld", b.rev, youngest);
+          else
+            {
+              b.txn_pool = svn_pool_create (pool);
+              SVN_ERR (svn_fs_begin_txn (&b.txn, b.fs, youngest,
+                                         b.txn_pool));
+              SVN_ERR (svn_fs_txn_root (&b.txn_root, b.txn, b.txn_pool));
+
+              b.rev_props = apr_hash_make (b.txn_pool);
+              content = apr_palloc (subpool, content_len ? content_len : 1);
+              SVN_ERR (read_content (content, content_len, stream, subpool));
+              SVN_ERR (parse_prop_block
+                       (b.rev_props,
+                        apr_array_make (subpool, 1, sizeof (const char *)),
+                        content, prop_len, b.txn_pool));
+              youngest = b.rev;
+            }
+        }
+      else if (apr_hash_get (headers, DUMP_H_NODE_PATH,
+                             APR_HASH_KEY_STRING))
+        {
+          content = apr_palloc (subpool, content_len ? content_len : 1);
+          SVN_ERR (read_content (content, content_len, stream, subpool));
+
+          /* Apply the record, unless we're skipping this revision. */
+          if (b.txn)
+            SVN_ERR (load_node (&b, headers, content, prop_len,
+                                content_len, subpool));
+        }
+      else
+        return svn_error_create
+          (SVN_ERR_MALFORMED_FILE, 0, NULL, pool,
+           "svn_repos_load_fs: unrecognized record in dump stream");
+
+      svn_pool_clear (subpool);
+    }
+
+  /* Close the final revision. */
+  SVN_ERR (close_revision (&b, subpool));
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
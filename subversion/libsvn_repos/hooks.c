@@ -20,7 +20,9 @@
 #include <ctype.h>
 
 #include "apr_pools.h"
+#include "apr_strings.h"
 #include "apr_file_io.h"
+#include "apr_thread_proc.h"
 
 #include "svn_pools.h"
 #include "svn_error.h"
@@ -37,30 +39,42 @@
 
 /*** Hook drivers. ***/
 
+/* Note that the spawn itself is already as light as APR lets it be:
+   the hook is exec'd directly (no shell), with an empty environment,
+   and its arguments ride in on argv --- there is no temp-file
+   indirection to pay for.  The only per-spawn setup worth reusing is
+   our own stdio handles, which live on REPOS once opened.  */
 static svn_error_t *
-run_cmd_with_output (const char *cmd,
+run_cmd_with_output (svn_repos_t *repos,
+                     const char *cmd,
                      const char **args,
                      int *exitcode,
                      apr_exit_why_e *exitwhy,
                      apr_pool_t *pool)
 {
-  apr_file_t *outhandle, *errhandle;
   apr_status_t apr_err;
-  
-  /* Get an apr_file_t representing stdout and stderr. */
-  apr_err = apr_file_open_stdout (&outhandle, pool);
-  if (apr_err)
-    return svn_error_create 
-      (apr_err, 0, NULL, pool,
-       "run_cmd_with_output: can't open handle to stdout");
-  apr_err = apr_file_open_stderr (&errhandle, pool);
-  if (apr_err)
-    return svn_error_create 
-      (apr_err, 0, NULL, pool,
-       "run_cmd_with_output: can't open handle to stderr");
+
+  /* Get an apr_file_t representing stdout and stderr; every hook this
+     handle ever runs uses the same two. */
+  if (! repos->hook_stdout)
+    {
+      apr_err = apr_file_open_stdout (&repos->hook_stdout, repos->pool);
+      if (apr_err)
+        return svn_error_create
+          (apr_err, 0, NULL, pool,
+           "run_cmd_with_output: can't open handle to stdout");
+    }
+  if (! repos->hook_stderr)
+    {
+      apr_err = apr_file_open_stderr (&repos->hook_stderr, repos->pool);
+      if (apr_err)
+        return svn_error_create
+          (apr_err, 0, NULL, pool,
+           "run_cmd_with_output: can't open handle to stderr");
+    }
 
   return svn_io_run_cmd (".", cmd, args, exitcode, exitwhy, FALSE,
-                         NULL, outhandle, errhandle, pool);
+                         NULL, repos->hook_stdout, repos->hook_stderr, pool);
 }
 
 
@@ -85,7 +99,7 @@ run_start_commit_hook (svn_repos_t *repos,
       args[2] = user;
       args[3] = NULL;
 
-      if ((err = run_cmd_with_output (hook, args, NULL, NULL, pool)))
+      if ((err = run_cmd_with_output (repos, hook, args, NULL, NULL, pool)))
         {
           return svn_error_createf 
             (SVN_ERR_REPOS_HOOK_FAILURE, 0, err, pool,
@@ -120,7 +134,8 @@ run_pre_commit_hook (svn_repos_t *repos,
       args[2] = txn_name;
       args[3] = NULL;
 
-      if ((err = run_cmd_with_output (hook, args, &exitcode, &exitwhy, pool)))
+      if ((err = run_cmd_with_output (repos, hook, args, &exitcode,
+                                      &exitwhy, pool)))
         {
           return svn_error_createf 
             (SVN_ERR_REPOS_HOOK_FAILURE, 0, err, pool,
@@ -138,8 +153,86 @@ run_pre_commit_hook (svn_repos_t *repos,
 }
 
 
+/* Detached hooks we have started but not yet reaped.  The pool code
+   is told APR_KILL_NEVER for these, so nothing ever waits for them
+   implicitly; in a long-lived server process each one would sit as a
+   zombie until the worker exited.  Instead, every new detached hook
+   first sweeps this table with a non-blocking wait.  */
+#define MAX_DETACHED 32
+static apr_proc_t detached_procs[MAX_DETACHED];
+static int num_detached = 0;
+
+/* Reap any detached hooks that have finished, without blocking.  */
+static void
+reap_detached (void)
+{
+  int i = 0;
+
+  while (i < num_detached)
+    {
+      apr_status_t apr_err
+        = apr_proc_wait (&detached_procs[i], NULL, NULL, APR_NOWAIT);
+
+      if (APR_STATUS_IS_CHILD_NOTDONE (apr_err))
+        i++;
+      else
+        detached_procs[i] = detached_procs[--num_detached];
+    }
+}
+
+/* Start CMD with ARGS without waiting for it to finish, appending its
+   output to the file LOGFILE_PATH.  Use POOL for any temporary
+   allocations.  */
+static svn_error_t *
+run_cmd_detached (const char *cmd,
+                  const char **args,
+                  const char *logfile_path,
+                  apr_pool_t *pool)
+{
+  apr_file_t *loghandle;
+  apr_proc_t proc;
+  apr_status_t apr_err;
+
+  reap_detached ();
+  if (num_detached == MAX_DETACHED)
+    {
+      /* The table is full of still-running hooks; block on the oldest
+         rather than lose track of a child. */
+      apr_proc_wait (&detached_procs[0], NULL, NULL, APR_WAIT);
+      detached_procs[0] = detached_procs[--num_detached];
+    }
+
+  /* Send the hook's output to a log file; there may be no one around
+     to read it by the time it appears. */
+  apr_err = apr_file_open (&loghandle, logfile_path,
+                           (APR_WRITE | APR_CREATE | APR_APPEND),
+                           APR_OS_DEFAULT,
+                           pool);
+  if (apr_err)
+    return svn_error_createf
+      (apr_err, 0, NULL, pool,
+       "run_cmd_detached: can't open log file `%s'", logfile_path);
+
+  /* The child holds its own descriptor for the log file, so it
+     doesn't matter that ours evaporates with POOL. */
+  SVN_ERR (svn_io_start_cmd (&proc, ".", cmd, args, FALSE,
+                             NULL, loghandle, loghandle, pool));
+
+  /* Remember the child so a later sweep can reap it. */
+  detached_procs[num_detached++] = proc;
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Run the post-commit hook for REPOS.  Use POOL for any temporary
-   allocations.  If the hook fails, run SVN_ERR_REPOS_HOOK_FAILURE.  */
+   allocations.  If the hook fails, run SVN_ERR_REPOS_HOOK_FAILURE.
+
+   If the file SVN_REPOS__HOOK_POST_COMMIT_ASYNC exists in REPOS's
+   hooks directory, don't wait for the hook to finish; instead, append
+   its output to SVN_REPOS__HOOK_POST_COMMIT_LOG there.  This keeps
+   slow notification pipelines (mail, mirror pushes) out of the commit
+   round trip.  */
 static svn_error_t  *
 run_post_commit_hook (svn_repos_t *repos,
                       svn_revnum_t rev,
@@ -148,10 +241,15 @@ run_post_commit_hook (svn_repos_t *repos,
   enum svn_node_kind kind;
   const char *hook = svn_repos_post_commit_hook (repos, pool);
 
-  if ((! svn_io_check_path (hook, &kind, pool)) 
+  if ((! svn_io_check_path (hook, &kind, pool))
       && (kind == svn_node_file))
     {
       svn_error_t *err;
+      enum svn_node_kind async_kind;
+      const char *hook_dir = svn_repos_hook_dir (repos, pool);
+      const char *async_path
+        = apr_pstrcat (pool, hook_dir,
+                       "/" SVN_REPOS__HOOK_POST_COMMIT_ASYNC, NULL);
       const char *args[4];
 
       args[0] = hook;
@@ -159,9 +257,21 @@ run_post_commit_hook (svn_repos_t *repos,
       args[2] = apr_psprintf (pool, "%lu", rev);
       args[3] = NULL;
 
-      if ((err = run_cmd_with_output (hook, args, NULL, NULL, pool)))
+      if ((! svn_io_check_path (async_path, &async_kind, pool))
+          && (async_kind == svn_node_file))
         {
-          return svn_error_createf 
+          const char *logfile_path
+            = apr_pstrcat (pool, hook_dir,
+                           "/" SVN_REPOS__HOOK_POST_COMMIT_LOG, NULL);
+
+          err = run_cmd_detached (hook, args, logfile_path, pool);
+        }
+      else
+        err = run_cmd_with_output (repos, hook, args, NULL, NULL, pool);
+
+      if (err)
+        {
+          return svn_error_createf
             (SVN_ERR_REPOS_HOOK_FAILURE, 0, err, pool,
              "run_post_commit_hook: error running cmd `%s'", hook);
         }
@@ -91,6 +91,14 @@ SOURCE=.\delta.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\deltify.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\dump.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\hooks.c
 # End Source File
 # Begin Source File
@@ -103,6 +111,10 @@ SOURCE=.\node_tree.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\replay.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\reporter.c
 # End Source File
 # Begin Source File
@@ -96,6 +96,7 @@ svn_repos_get_logs (svn_repos_t *repos,
                     svn_revnum_t start,
                     svn_revnum_t end,
                     svn_boolean_t discover_changed_paths,
+                    int limit,
                     svn_log_message_receiver_t receiver,
                     void *receiver_baton,
                     apr_pool_t *pool)
@@ -105,6 +106,7 @@ svn_repos_get_logs (svn_repos_t *repos,
   apr_hash_t *changed_paths = NULL;
   svn_fs_t *fs = repos->fs;
   apr_array_header_t *revs = NULL;
+  int sent = 0;
 
   /* If no START revision was given, use HEAD. */
   if (! SVN_IS_VALID_REVNUM (start))
@@ -186,37 +188,52 @@ svn_repos_get_logs (svn_repos_t *repos,
 #ifndef SVN_REPOS_ALLOW_LOG_WITH_PATHS
       discover_changed_paths = FALSE;
 #else      
-      if ((this_rev > 0) && 
+      if ((this_rev > 0) &&
           (discover_changed_paths || (paths && paths->nelts > 0)))
         {
-          const svn_delta_edit_fns_t *editor;
-          svn_fs_root_t *oldroot, *newroot;
-          void *edit_baton;
-
-          changed_paths = apr_hash_make (subpool);
-          
-          /* Use a dir_deltas run with the node editor between the
-             current revision and its immediate predecessor to see
-             what changed in this revision.
-
-             ### todo: not sure this needs an editor and dir_deltas.
-             Might be easier to just walk the one revision tree,
-             looking at created-rev fields... */
-          SVN_ERR (svn_fs_revision_root (&oldroot, fs, this_rev - 1, subpool));
-          SVN_ERR (svn_fs_revision_root (&newroot, fs, this_rev, subpool));
-          SVN_ERR (svn_repos_node_editor (&editor, &edit_baton, fs,
-                                          oldroot, newroot, subpool, subpool));
-          SVN_ERR (svn_repos_dir_delta (oldroot, "", NULL, NULL,
-                                        newroot, "",
-                                        editor, edit_baton,
-                                        FALSE, TRUE, FALSE, subpool));
-          detect_changed (changed_paths,
-                          svn_repos_node_from_baton (edit_baton),
-                          svn_stringbuf_create ("/", subpool),
-                          subpool);
-
-          /* ### Feels slightly bogus to assume "/" as the right start
-             for repository style. */
+          /* Ask the filesystem's changed-paths index first; commits
+             maintain it, so for indexed revisions this is a couple of
+             table lookups instead of a tree walk.  */
+          SVN_ERR (svn_fs_paths_changed (&changed_paths, fs, this_rev,
+                                         subpool));
+
+          if (! changed_paths)
+            {
+              /* This revision predates the index (see `svnadmin
+                 build-changes').  Fall back on comparing the revision
+                 with its predecessor.  */
+              const svn_delta_edit_fns_t *editor;
+              svn_fs_root_t *oldroot, *newroot;
+              void *edit_baton;
+
+              changed_paths = apr_hash_make (subpool);
+
+              /* Use a dir_deltas run with the node editor between the
+                 current revision and its immediate predecessor to see
+                 what changed in this revision.
+
+                 ### todo: not sure this needs an editor and dir_deltas.
+                 Might be easier to just walk the one revision tree,
+                 looking at created-rev fields... */
+              SVN_ERR (svn_fs_revision_root (&oldroot, fs, this_rev - 1,
+                                             subpool));
+              SVN_ERR (svn_fs_revision_root (&newroot, fs, this_rev,
+                                             subpool));
+              SVN_ERR (svn_repos_node_editor (&editor, &edit_baton, fs,
+                                              oldroot, newroot,
+                                              subpool, subpool));
+              SVN_ERR (svn_repos_dir_delta (oldroot, "", NULL, NULL,
+                                            newroot, "",
+                                            editor, edit_baton,
+                                            FALSE, TRUE, FALSE, NULL, subpool));
+              detect_changed (changed_paths,
+                              svn_repos_node_from_baton (edit_baton),
+                              svn_stringbuf_create ("/", subpool),
+                              subpool);
+
+              /* ### Feels slightly bogus to assume "/" as the right
+                 start for repository style. */
+            }
         }
 
 #endif /* SVN_REPOS_ALLOW_LOG_WITH_PATHS */
@@ -227,7 +244,67 @@ svn_repos_get_logs (svn_repos_t *repos,
                             author ? author->data : "",
                             date ? date->data : "",
                             message ? message->data : ""));
-      
+
+      /* Stop walking revisions once the caller has all it asked for. */
+      if ((limit > 0) && (++sent >= limit))
+        break;
+
+      svn_pool_clear (subpool);
+    }
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_build_changes (svn_repos_t *repos,
+                         apr_pool_t *pool)
+{
+  svn_fs_t *fs = repos->fs;
+  svn_revnum_t youngest, this_rev;
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  SVN_ERR (svn_fs_youngest_rev (&youngest, fs, pool));
+
+  /* Revision zero is always an empty tree, so there is nothing to
+     index for it.  */
+  for (this_rev = 1; this_rev <= youngest; this_rev++)
+    {
+      apr_hash_t *changed_paths;
+      const svn_delta_edit_fns_t *editor;
+      svn_fs_root_t *oldroot, *newroot;
+      void *edit_baton;
+
+      /* Skip revisions the index already covers. */
+      SVN_ERR (svn_fs_paths_changed (&changed_paths, fs, this_rev, subpool));
+      if (changed_paths)
+        {
+          svn_pool_clear (subpool);
+          continue;
+        }
+
+      /* Discover the changes the hard way, by comparing the revision
+         with its predecessor... */
+      changed_paths = apr_hash_make (subpool);
+      SVN_ERR (svn_fs_revision_root (&oldroot, fs, this_rev - 1, subpool));
+      SVN_ERR (svn_fs_revision_root (&newroot, fs, this_rev, subpool));
+      SVN_ERR (svn_repos_node_editor (&editor, &edit_baton, fs,
+                                      oldroot, newroot, subpool, subpool));
+      SVN_ERR (svn_repos_dir_delta (oldroot, "", NULL, NULL,
+                                    newroot, "",
+                                    editor, edit_baton,
+                                    FALSE, TRUE, FALSE, NULL, subpool));
+      detect_changed (changed_paths,
+                      svn_repos_node_from_baton (edit_baton),
+                      svn_stringbuf_create ("/", subpool),
+                      subpool);
+
+      /* ...and record them. */
+      SVN_ERR (svn_fs_set_paths_changed (fs, this_rev, changed_paths,
+                                         subpool));
+
       svn_pool_clear (subpool);
     }
 
@@ -25,6 +25,7 @@
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
 #include "apr_pools.h"
+#include "svn_pools.h"
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_path.h"
@@ -127,6 +128,14 @@ struct edit_baton
   svn_fs_root_t *base_root;
   apr_pool_t *pool;
   apr_pool_t *node_pool;
+
+  /* Scratch space for the current editor drive --- batons, paths, and
+     the like.  Created by open_root, destroyed by close_edit, so the
+     caller's pools stay flat no matter how many drives they see.
+     (The nodes themselves go into NODE_POOL; they have to outlive the
+     drive, since the caller walks them afterwards.) */
+  apr_pool_t *drive_pool;
+
   svn_repos_node_t *node;
 };
 
@@ -147,14 +156,8 @@ struct file_baton
 };
 
 
-struct window_handler_baton
-{
-  svn_repos_node_t *node;
-};
-
-
 static svn_error_t *
-delete_entry (svn_stringbuf_t *name, 
+delete_entry (svn_stringbuf_t *name,
               svn_revnum_t revision,
               void *parent_baton)
 {
@@ -165,11 +168,12 @@ delete_entry (svn_stringbuf_t *name,
   int is_dir;
 
   /* Construct the full path of this entry based on its parent. */
-  full_path = svn_stringbuf_dup (d->path, eb->pool);
+  full_path = svn_stringbuf_dup (d->path, eb->drive_pool);
   svn_path_add_component (full_path, name);
 
   /* Was this a dir or file (we have to check the base root for this one) */
-  SVN_ERR (svn_fs_is_dir (&is_dir, eb->base_root, full_path->data, eb->pool));
+  SVN_ERR (svn_fs_is_dir (&is_dir, eb->base_root, full_path->data,
+                          eb->drive_pool));
 
   /* Get (or create) the change node and update it. */
   node = find_child_by_name (d->node, name->data);
@@ -192,9 +196,14 @@ open_root (void *edit_baton,
               void **root_baton)
 {
   struct edit_baton *eb = (struct edit_baton *) edit_baton;
-  struct dir_baton *d = apr_pcalloc (eb->pool, sizeof (*d));
+  struct dir_baton *d;
 
-  d->path = (svn_stringbuf_t *) svn_stringbuf_create ("", eb->pool);
+  /* All the editor's scratch allocations for this drive live here;
+     close_edit throws the whole lot away at once. */
+  eb->drive_pool = svn_pool_create (eb->pool);
+
+  d = apr_pcalloc (eb->drive_pool, sizeof (*d));
+  d->path = (svn_stringbuf_t *) svn_stringbuf_create ("", eb->drive_pool);
   d->edit_baton = eb;
   d->node = (eb->node = create_node ("", eb->node_pool));
   d->node->kind = svn_node_dir;
@@ -213,10 +222,10 @@ open_directory (svn_stringbuf_t *name,
 {
   struct dir_baton *pd = (struct dir_baton *) parent_baton;
   struct edit_baton *eb = (struct edit_baton *) pd->edit_baton;
-  struct dir_baton *d = apr_pcalloc (pd->edit_baton->pool, sizeof (*d));
+  struct dir_baton *d = apr_pcalloc (eb->drive_pool, sizeof (*d));
 
   /* Construct the full path of the new directory */
-  d->path = svn_stringbuf_dup (pd->path, eb->pool);
+  d->path = svn_stringbuf_dup (pd->path, eb->drive_pool);
   svn_path_add_component (d->path, name);
 
   /* Fill in other baton members */
@@ -239,10 +248,10 @@ add_directory (svn_stringbuf_t *name,
 {
   struct dir_baton *pd = (struct dir_baton *) parent_baton;
   struct edit_baton *eb = (struct edit_baton *) pd->edit_baton;
-  struct dir_baton *d = apr_pcalloc (pd->edit_baton->pool, sizeof (*d));
+  struct dir_baton *d = apr_pcalloc (eb->drive_pool, sizeof (*d));
 
   /* Construct the full path of the new directory */
-  d->path = svn_stringbuf_dup (pd->path, eb->pool);
+  d->path = svn_stringbuf_dup (pd->path, eb->drive_pool);
   svn_path_add_component (d->path, name);
 
   /* Fill in other baton members */
@@ -264,10 +273,10 @@ open_file (svn_stringbuf_t *name,
 {
   struct dir_baton *pd = (struct dir_baton *) parent_baton;
   struct edit_baton *eb = (struct edit_baton *) pd->edit_baton;
-  struct file_baton *fb = apr_pcalloc (pd->edit_baton->pool, sizeof (*fb));
+  struct file_baton *fb = apr_pcalloc (eb->drive_pool, sizeof (*fb));
 
   /* Construct the full path of the new directory */
-  fb->path = svn_stringbuf_dup (pd->path, eb->pool);
+  fb->path = svn_stringbuf_dup (pd->path, eb->drive_pool);
   svn_path_add_component (fb->path, name);
 
   /* Fill in other baton members */
@@ -290,10 +299,10 @@ add_file (svn_stringbuf_t *name,
 {
   struct dir_baton *pd = (struct dir_baton *) parent_baton;
   struct edit_baton *eb = (struct edit_baton *) pd->edit_baton;
-  struct file_baton *fb = apr_pcalloc (pd->edit_baton->pool, sizeof (*fb));
+  struct file_baton *fb = apr_pcalloc (eb->drive_pool, sizeof (*fb));
 
   /* Construct the full path of the new directory */
-  fb->path = svn_stringbuf_dup (pd->path, eb->pool);
+  fb->path = svn_stringbuf_dup (pd->path, eb->drive_pool);
   svn_path_add_component (fb->path, name);
 
   /* Fill in other baton members */
@@ -315,18 +324,18 @@ window_handler (svn_txdelta_window_t *window, void *baton)
 
 
 static svn_error_t *
-apply_textdelta (void *file_baton, 
+apply_textdelta (void *file_baton,
                  svn_txdelta_window_handler_t *handler,
                  void **handler_baton)
 {
   struct file_baton *fb = (struct file_baton *) file_baton;
-  struct edit_baton *eb = (struct edit_baton *) fb->dir_baton->edit_baton;
-  struct window_handler_baton *whb = apr_palloc (eb->pool, sizeof (*whb));
 
-  whb->node = fb->node;
-  whb->node->text_mod = TRUE;
+  /* We only care that the text changed, not what changed, so note the
+     fact now and hand back a do-nothing window handler --- no need to
+     allocate a baton of its own for that. */
+  fb->node->text_mod = TRUE;
   *handler = window_handler;
-  *handler_baton = whb;
+  *handler_baton = fb;
 
   return SVN_NO_ERROR;
 }
@@ -347,7 +356,7 @@ change_file_prop (void *file_baton,
 
 static svn_error_t *
 change_dir_prop (void *parent_baton,
-                 svn_stringbuf_t *name, 
+                 svn_stringbuf_t *name,
                  svn_stringbuf_t *value)
 {
   struct dir_baton *d = (struct dir_baton *) parent_baton;
@@ -357,6 +366,21 @@ change_dir_prop (void *parent_baton,
 }
 
 
+static svn_error_t *
+close_edit (void *edit_baton)
+{
+  struct edit_baton *eb = (struct edit_baton *) edit_baton;
+
+  /* The drive is over; all the batons are dead, so reclaim their
+     scratch space.  The node tree lives on in NODE_POOL for the
+     caller. */
+  svn_pool_destroy (eb->drive_pool);
+  eb->drive_pool = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_repos_node_editor (const svn_delta_edit_fns_t **editor,
                        void **edit_baton,
@@ -380,6 +404,7 @@ svn_repos_node_editor (const svn_delta_edit_fns_t **editor,
   my_editor->apply_textdelta     = apply_textdelta;
   my_editor->change_file_prop    = change_file_prop;
   my_editor->change_dir_prop     = change_dir_prop;
+  my_editor->close_edit          = close_edit;
 
   /* Set up the edit baton. */
   my_edit_baton = apr_pcalloc (pool, sizeof (*my_edit_baton));
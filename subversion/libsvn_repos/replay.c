@@ -0,0 +1,110 @@
+/*
+ * replay.c:   driving an editor once per revision over a range
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+#include "svn_types.h"
+#include "svn_delta.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_pools.h"
+
+#include "repos.h"
+
+
+/* Replaying a range of revisions is just a sequence of dir_delta
+   drives, one from each revision's predecessor to the revision
+   itself.  The trick worth having an interface for is that
+   consecutive drives share a root: revision N is the target of one
+   drive and the source of the next.  By keeping N's root object open
+   across both drives, we open each root once instead of twice, and
+   the directory lookups dir_delta made while *producing* revision N
+   are still sitting in that root's node cache when the next drive
+   *reads* revision N.  See the node_cache comments in
+   libsvn_fs/tree.c.
+
+   Each root lives in its own subpool, and we hold at most two roots
+   open at a time, so replaying a thousand revisions uses no more
+   memory than replaying one.  */
+
+svn_error_t *
+svn_repos_replay_range (svn_repos_t *repos,
+                        svn_revnum_t start_rev,
+                        svn_revnum_t end_rev,
+                        svn_boolean_t text_deltas,
+                        svn_repos_replay_editor_cb_t editor_cb,
+                        void *cb_baton,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs = repos->fs;
+  svn_revnum_t youngest, rev;
+  svn_fs_root_t *src_root, *tgt_root;
+  apr_pool_t *src_pool, *tgt_pool, *subpool;
+
+  SVN_ERR (svn_fs_youngest_rev (&youngest, fs, pool));
+
+  /* Validate the revision range. */
+  if ((start_rev < 1) || (end_rev > youngest) || (start_rev > end_rev))
+    return svn_error_createf
+      (SVN_ERR_FS_NO_SUCH_REVISION, 0, NULL, pool,
+       "svn_repos_replay_range: bad revision range %ld:%ld (youngest %ld)",
+       (long int) start_rev, (long int) end_rev, (long int) youngest);
+
+  /* Open the root we'll diff the first revision against. */
+  src_pool = svn_pool_create (pool);
+  SVN_ERR (svn_fs_revision_root (&src_root, fs, start_rev - 1, src_pool));
+
+  subpool = svn_pool_create (pool);
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      const svn_delta_edit_fns_t *editor;
+      void *edit_baton;
+
+      /* The target root gets its own pool so it can outlive this
+         iteration and serve as the next one's source. */
+      tgt_pool = svn_pool_create (pool);
+      SVN_ERR (svn_fs_revision_root (&tgt_root, fs, rev, tgt_pool));
+
+      /* Ask the caller for this revision's editor, and drive it. */
+      SVN_ERR (editor_cb (&editor, &edit_baton, rev, cb_baton, subpool));
+      SVN_ERR (svn_repos_dir_delta (src_root, "", NULL, NULL,
+                                    tgt_root, "",
+                                    editor, edit_baton,
+                                    text_deltas, TRUE, FALSE, NULL, subpool));
+
+      /* Retire the old source; the target becomes the next source,
+         node cache and all. */
+      svn_pool_destroy (src_pool);
+      src_pool = tgt_pool;
+      src_root = tgt_root;
+
+      svn_pool_clear (subpool);
+    }
+
+  svn_pool_destroy (subpool);
+  svn_pool_destroy (src_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
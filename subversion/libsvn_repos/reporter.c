@@ -16,22 +16,50 @@
  * ====================================================================
  */
 
+#include "apr_tables.h"
 #include "svn_path.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
 #include "repos.h"
 
+/* Reporter state shared by successive report drives on one RA
+   session.  See svn_repos_report_cache_create in svn_repos.h. */
+struct svn_repos_report_cache_t
+{
+  /* Revision roots already opened on the session's filesystem,
+     mapping revnums (keyed by value) onto svn_fs_root_t objects.  The
+     roots live in POOL below, the same place an uncached drive would
+     have opened them. */
+  apr_hash_t *rev_roots;
+
+  /* A report baton whose drive has finished, ready to be reused by
+     the next svn_repos_begin_report call, or NULL. */
+  struct svn_repos_report_baton_t *spare_baton;
+
+  /* The session-lifetime pool the cache was created in. */
+  apr_pool_t *pool;
+};
+
+
 /* A structure used by the routines within the `reporter' vtable,
    driven by the client as it describes its working copy revisions. */
 typedef struct svn_repos_report_baton_t
 {
-  /* The transaction being built in the repository, a mirror of the
-     working copy. */
+  /* The repository the update is drawn from. */
   svn_repos_t *repos;
-  svn_fs_txn_t *txn;
-  svn_fs_root_t *txn_root;
 
-  /* Which user is doing the update (building the temporary txn) */
+  /* Whether the first set_path call --- the one that establishes the
+     base revision --- has arrived yet. */
+  svn_boolean_t reported;
+
+  /* The revision the drive is based on, from that first call. */
+  svn_revnum_t base_revision;
+
+  /* Paths the client reported as deleted (const char *), in the same
+     form as the keys of PATH_REV_HASH below. */
+  apr_array_header_t *deletes;
+
+  /* Which user is doing the update. */
   const char *username;
 
   /* The fs path under which all reporting will happen */
@@ -61,16 +89,76 @@ typedef struct svn_repos_report_baton_t
   const svn_delta_edit_fns_t *update_editor;
   void *update_edit_baton; 
 
-  /* This hash describes the mixed revisions in the transaction; it
+  /* This hash describes the mixed revisions the client reported; it
      maps pathnames (char *) to revision numbers (svn_revnum_t). */
   apr_hash_t *path_rev_hash;
 
+  /* Subtrees the delta walk should be pruned to, or NULL for all. */
+  svn_repos_path_filter_t *path_filter;
+
+  /* State shared with the session's other report drives, or NULL. */
+  svn_repos_report_cache_t *cache;
+
   /* Pool from the session baton. */
   apr_pool_t *pool;
 
 } svn_repos_report_baton_t;
 
 
+svn_repos_report_cache_t *
+svn_repos_report_cache_create (apr_pool_t *pool)
+{
+  svn_repos_report_cache_t *cache = apr_pcalloc (pool, sizeof (*cache));
+
+  cache->rev_roots = apr_hash_make (pool);
+  cache->pool = pool;
+  return cache;
+}
+
+
+/* Set *ROOT to the root of REVISION of the filesystem reported on by
+   RBATON, consulting (and filling) the session's report cache if
+   there is one. */
+static svn_error_t *
+get_revision_root (svn_fs_root_t **root,
+                   svn_repos_report_baton_t *rbaton,
+                   svn_revnum_t revision)
+{
+  svn_fs_root_t *rev_root;
+
+  if (! rbaton->cache)
+    return svn_fs_revision_root (root, rbaton->repos->fs,
+                                 revision, rbaton->pool);
+
+  rev_root = apr_hash_get (rbaton->cache->rev_roots,
+                           &revision, sizeof (revision));
+  if (! rev_root)
+    {
+      svn_revnum_t *key;
+
+      SVN_ERR (svn_fs_revision_root (&rev_root, rbaton->repos->fs,
+                                     revision, rbaton->cache->pool));
+      key = apr_palloc (rbaton->cache->pool, sizeof (*key));
+      *key = revision;
+      apr_hash_set (rbaton->cache->rev_roots, key, sizeof (*key), rev_root);
+    }
+
+  *root = rev_root;
+  return SVN_NO_ERROR;
+}
+
+
+/* The drive using RBATON is over; if the session keeps a report
+   cache, offer it the baton for the next drive to reuse. */
+static void
+retire_report_baton (svn_repos_report_baton_t *rbaton)
+{
+  rbaton->reported = FALSE;
+  if (rbaton->cache && (! rbaton->cache->spare_baton))
+    rbaton->cache->spare_baton = rbaton;
+}
+
+
 svn_error_t *
 svn_repos_set_path (void *report_baton,
                     const char *path,
@@ -81,8 +169,8 @@ svn_repos_set_path (void *report_baton,
   svn_repos_report_baton_t *rbaton = report_baton;
   svn_revnum_t *rev_ptr = apr_palloc (rbaton->pool, sizeof(*rev_ptr));
 
-  /* If this is the very first call, no txn exists yet. */
-  if (! rbaton->txn)
+  /* If this is the very first call, no base revision is set yet. */
+  if (! rbaton->reported)
     {
       /* ### need to change svn_path_is_empty() */
       svn_stringbuf_t *pathbuf = svn_stringbuf_create (path, rbaton->pool);
@@ -90,32 +178,23 @@ svn_repos_set_path (void *report_baton,
       /* Sanity check: make that we didn't call this with real data
          before simply informing the reporter of our base revision. */
       if (! svn_path_is_empty (pathbuf))
-        return 
+        return
           svn_error_create
           (SVN_ERR_RA_BAD_REVISION_REPORT, 0, NULL, rbaton->pool,
            "svn_repos_set_path: initial revision report was bogus.");
 
-      /* Start a transaction based on REVISION. */
-      SVN_ERR (svn_repos_fs_begin_txn_for_update (&(rbaton->txn),
-                                                  rbaton->repos,
-                                                  revision,
-                                                  rbaton->username,
-                                                  rbaton->pool));
-      SVN_ERR (svn_fs_txn_root (&(rbaton->txn_root), rbaton->txn,
-                                rbaton->pool));
-      
-      /* In our hash, map the root of the txn ("") to the initial base
-         revision. */
+      /* The drive will be based on REVISION; nothing to build. */
+      rbaton->reported = TRUE;
+      rbaton->base_revision = revision;
+
+      /* In our hash, map the root of the report ("") to the initial
+         base revision. */
       *rev_ptr = revision;
       apr_hash_set (rbaton->path_rev_hash, "", APR_HASH_KEY_STRING, rev_ptr);
     }
 
-  else  /* this is not the first call to set_path. */ 
+  else  /* this is not the first call to set_path. */
     {
-      /* Create the "from" root and path. */
-      SVN_ERR (svn_fs_revision_root (&from_root, rbaton->repos->fs,
-                                     revision, rbaton->pool));
-
       /* The path we are dealing with is the anchor (where the
          reporter is rooted) + target (the top-level thing being
          reported) + path (stuff relative to the target...this is the
@@ -126,14 +205,21 @@ svn_repos_set_path (void *report_baton,
         svn_path_add_component (from_path, rbaton->target);
       svn_path_add_component_nts (from_path, path);
 
-      /* Copy into our txn. */
-      SVN_ERR (svn_fs_link (from_root, from_path->data,
-                            rbaton->txn_root, from_path->data, rbaton->pool));
-      
+      /* The old transaction build (svn_fs_link) would have failed
+         here on a path that never existed in REVISION; keep that
+         check, without the write. */
+      SVN_ERR (get_revision_root (&from_root, rbaton, revision));
+      if (svn_fs_check_path (from_root, from_path->data, rbaton->pool)
+          == svn_node_none)
+        return svn_error_createf
+          (SVN_ERR_FS_NOT_FOUND, 0, NULL, rbaton->pool,
+           "svn_repos_set_path: `%s' is not in revision %ld",
+           from_path->data, revision);
+
       /* Remember this path in our hashtable. */
       *rev_ptr = revision;
       apr_hash_set (rbaton->path_rev_hash, from_path->data,
-                    from_path->len, rev_ptr);    
+                    from_path->len, rev_ptr);
 
     }
 
@@ -159,10 +245,9 @@ svn_repos_delete_path (void *report_baton,
     svn_path_add_component (delete_path, rbaton->target);
   svn_path_add_component_nts (delete_path, path);
 
-
-  /* Remove the file or directory (recursively) from the txn. */
-  SVN_ERR (svn_fs_delete_tree (rbaton->txn_root, delete_path->data, 
-                               rbaton->pool));
+  /* Record the deletion; the delta walk reads everything at or below
+     the path as absent. */
+  (*((const char **) apr_array_push (rbaton->deletes))) = delete_path->data;
 
   return SVN_NO_ERROR;
 }
@@ -170,41 +255,133 @@ svn_repos_delete_path (void *report_baton,
 
 
 
+/* Remove from HASH every path whose nearest reported ancestor was
+   reported at the same revision.  Such entries are shadows: when
+   dir_delta looks up a base revision (see get_revision_from_hash in
+   delta.c), a missing path falls back on its nearest ancestor's
+   revision, so dropping them changes no answer.  A large
+   mostly-single-revision working copy reports thousands of paths but
+   collapses to a handful of entries, which keeps the hash small for
+   the many lookups the delta walk makes.  Use POOL for temporary
+   allocations.  */
+static void
+collapse_redundant_reports (apr_hash_t *hash, apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_array_header_t *doomed = apr_array_make (pool, 16,
+                                               sizeof (const char *));
+  svn_stringbuf_t *ancestor = svn_stringbuf_create ("", pool);
+  int i;
+
+  for (hi = apr_hash_first (pool, hash); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      apr_ssize_t klen;
+      void *val;
+      svn_revnum_t rev;
+
+      apr_hash_this (hi, &key, &klen, &val);
+      rev = *((svn_revnum_t *) val);
+
+      /* The root entry anchors the fallback chain; keep it. */
+      if (klen == 0)
+        continue;
+
+      /* Find the nearest reported ancestor, the way the delta walk
+         will once this entry is gone. */
+      svn_stringbuf_set (ancestor, key);
+      while (! svn_path_is_empty (ancestor))
+        {
+          svn_revnum_t *ancestor_rev;
+
+          svn_path_remove_component (ancestor);
+          ancestor_rev = apr_hash_get (hash, ancestor->data, ancestor->len);
+          if (ancestor_rev)
+            {
+              if (*ancestor_rev == rev)
+                (*((const char **) apr_array_push (doomed))) = key;
+              break;
+            }
+        }
+    }
+
+  /* Now that the iteration is over, it's safe to delete the shadowed
+     entries. */
+  for (i = 0; i < doomed->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX (doomed, i, const char *);
+      apr_hash_set (hash, path, APR_HASH_KEY_STRING, NULL);
+    }
+}
+
+
 svn_error_t *
 svn_repos_finish_report (void *report_baton)
 {
   svn_fs_root_t *rev_root;
+  svn_repos__report_base_t base;
+  apr_hash_index_t *hi;
   svn_repos_report_baton_t *rbaton = (svn_repos_report_baton_t *) report_baton;
 
   /* If nothing was described, then we have an error */
-  if (rbaton->txn == NULL)
+  if (! rbaton->reported)
     return svn_error_create(SVN_ERR_REPOS_NO_DATA_FOR_REPORT, 0, NULL,
                             rbaton->pool,
-                            "svn_repos_finish_report: no transaction was "
-                            "present, meaning no data was provided.");
+                            "svn_repos_finish_report: no base revision was "
+                            "set, meaning no data was provided.");
 
   /* Get the root of the revision we want to update to. */
-  SVN_ERR (svn_fs_revision_root (&rev_root, rbaton->repos->fs,
-                                 rbaton->revnum_to_update_to,
-                                 rbaton->pool));
+  SVN_ERR (get_revision_root (&rev_root, rbaton,
+                              rbaton->revnum_to_update_to));
+
+  /* Throw out reports that just repeat their parent's revision,
+     before the delta walk starts querying the hash. */
+  collapse_redundant_reports (rbaton->path_rev_hash, rbaton->pool);
+
+  /* Open a root for every revision the (collapsed) report names; the
+     delta walk resolves each source path to one of these.  Mirroring
+     the report in a transaction used to make every update write to
+     the database; this in-memory base never does. */
+  base.rev_roots = apr_hash_make (rbaton->pool);
+  for (hi = apr_hash_first (rbaton->pool, rbaton->path_rev_hash); hi;
+       hi = apr_hash_next (hi))
+    {
+      void *val;
+      svn_revnum_t rev;
+      svn_revnum_t *key;
+      svn_fs_root_t *root;
+
+      apr_hash_this (hi, NULL, NULL, &val);
+      rev = *((svn_revnum_t *) val);
+      if (apr_hash_get (base.rev_roots, &rev, sizeof (rev)))
+        continue;
+
+      SVN_ERR (get_revision_root (&root, rbaton, rev));
+      key = apr_palloc (rbaton->pool, sizeof (*key));
+      *key = rev;
+      apr_hash_set (base.rev_roots, key, sizeof (*key), root);
+    }
+  SVN_ERR (get_revision_root (&base.base_root, rbaton,
+                              rbaton->base_revision));
+  base.deletes = rbaton->deletes;
 
   /* Drive the update-editor. */
-  SVN_ERR (svn_repos_dir_delta (rbaton->txn_root, 
-                                rbaton->base_path, 
-                                rbaton->target ? 
-                                rbaton->target->data : NULL,
-                                rbaton->path_rev_hash,
-                                rev_root, 
-                                rbaton->tgt_path,
-                                rbaton->update_editor,
-                                rbaton->update_edit_baton,
-                                rbaton->text_deltas,
-                                rbaton->recurse,
-                                FALSE,
-                                rbaton->pool));
-  
-  /* Still here?  Great!  Throw out the transaction. */
-  SVN_ERR (svn_fs_abort_txn (rbaton->txn));
+  SVN_ERR (svn_repos__dir_delta_base (&base,
+                                      rbaton->base_path,
+                                      rbaton->target ?
+                                      rbaton->target->data : NULL,
+                                      rbaton->path_rev_hash,
+                                      rev_root,
+                                      rbaton->tgt_path,
+                                      rbaton->update_editor,
+                                      rbaton->update_edit_baton,
+                                      rbaton->text_deltas,
+                                      rbaton->recurse,
+                                      FALSE,
+                                      rbaton->path_filter,
+                                      rbaton->pool));
+
+  retire_report_baton (rbaton);
 
   return SVN_NO_ERROR;
 }
@@ -216,11 +393,8 @@ svn_repos_abort_report (void *report_baton)
 {
   svn_repos_report_baton_t *rbaton = (svn_repos_report_baton_t *) report_baton;
 
-  /* if we have a transaction, then abort it */
-  if (rbaton->txn != NULL)
-    {
-      SVN_ERR (svn_fs_abort_txn (rbaton->txn));
-    }
+  /* Nothing to tear down; the base is all in memory. */
+  retire_report_baton (rbaton);
 
   return SVN_NO_ERROR;
 }
@@ -240,12 +414,25 @@ svn_repos_begin_report (void **report_baton,
                         svn_boolean_t recurse,
                         const svn_delta_edit_fns_t *editor,
                         void *edit_baton,
+                        svn_repos_report_cache_t *cache,
+                        svn_repos_path_filter_t *filter,
                         apr_pool_t *pool)
 {
   svn_repos_report_baton_t *rbaton;
 
-  /* Build a reporter baton. */
-  rbaton = apr_pcalloc (pool, sizeof(*rbaton));
+  /* Build a reporter baton, reusing the last drive's if the session
+     keeps one around. */
+  if (cache && cache->spare_baton)
+    {
+      rbaton = cache->spare_baton;
+      cache->spare_baton = NULL;
+    }
+  else
+    rbaton = apr_pcalloc (pool, sizeof(*rbaton));
+
+  rbaton->reported = FALSE;
+  rbaton->base_revision = SVN_INVALID_REVNUM;
+  rbaton->deletes = apr_array_make (pool, 4, sizeof (const char *));
   rbaton->revnum_to_update_to = revnum;
   rbaton->update_editor = editor;
   rbaton->update_edit_baton = edit_baton;
@@ -253,6 +440,8 @@ svn_repos_begin_report (void **report_baton,
   rbaton->repos = repos;
   rbaton->text_deltas = text_deltas;
   rbaton->recurse = recurse;
+  rbaton->path_filter = filter;
+  rbaton->cache = cache;
   rbaton->pool = pool;
 
   /* Copy these since we're keeping them past the end of this function call.
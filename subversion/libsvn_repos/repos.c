@@ -387,6 +387,14 @@ create_hooks (svn_repos_t *repos, const char *path, apr_pool_t *pool)
       "`" SVN_REPOS__HOOK_POST_COMMIT ".exe', but the basic idea is\n"
       "# the same.\n"
       "# \n"
+      "# Normally the commit waits for this hook to finish.  If a file\n"
+      "# named `" SVN_REPOS__HOOK_POST_COMMIT_ASYNC "' exists in this "
+      "directory, the hook is\n"
+      "# run detached instead --- the commit returns immediately, and "
+      "the\n"
+      "# hook's output is appended to `"
+      SVN_REPOS__HOOK_POST_COMMIT_LOG "' here.\n"
+      "# \n"
       "# Here is an example hook script, for a Unix /bin/sh interpreter:\n"
       "#\n"
       "# REPOS=${1}\n"
@@ -685,8 +693,208 @@ svn_repos_open (svn_repos_t **repos_p,
 }
 
 
+/*** Caching open repositories. ***/
+
+/* A process-wide cache of open repository handles, mapping repository
+   paths (const char *) onto repos_cache_entry structures, so that
+   servers which open the same repository once per request pay for the
+   Berkeley DB environment open only once.  Both hash and entries live
+   in REPOS_CACHE_POOL, a top-level pool created on first use.
+
+   ### todo: no mutex protects this cache (see the similar comment in
+   svn_error.c); multithreaded callers must serialize access
+   themselves. */
+static apr_pool_t *repos_cache_pool = NULL;
+static apr_hash_t *repos_cache = NULL;
+
+/* The cap on the number of cached handles: negative for "no limit",
+   zero for "no caching at all".  See svn_repos_set_cache_size. */
+static int repos_cache_max = -1;
+
+/* A counter bumped on every cache hit or insertion, giving each entry
+   a cheap "when was this last wanted" stamp for eviction. */
+static apr_uint32_t repos_cache_tick = 0;
+
+struct repos_cache_entry
+{
+  /* The open repository handle, allocated in SUBPOOL. */
+  svn_repos_t *repos;
+
+  /* The subpool of REPOS_CACHE_POOL holding everything about this
+     entry, so a stale entry can be thrown out by itself. */
+  apr_pool_t *subpool;
+
+  /* The number of callers currently holding this handle. */
+  int refcount;
+
+  /* The value of REPOS_CACHE_TICK when this handle was last handed
+     out; the idle entry with the smallest stamp goes first when the
+     cache is over its size limit. */
+  apr_uint32_t last_used;
+};
+
+
+void
+svn_repos_set_cache_size (int max_handles)
+{
+  repos_cache_max = max_handles;
+}
+
+
+/* Throw out least recently used idle entries until the cache holds
+   fewer than REPOS_CACHE_MAX handles, making room for one more.
+   Entries someone still holds a reference to are left alone. */
+static void
+enforce_cache_size (apr_pool_t *pool)
+{
+  while ((int) apr_hash_count (repos_cache) >= repos_cache_max)
+    {
+      apr_hash_index_t *hi;
+      struct repos_cache_entry *victim = NULL;
+      const void *victim_key = NULL;
+
+      for (hi = apr_hash_first (pool, repos_cache); hi;
+           hi = apr_hash_next (hi))
+        {
+          const void *key;
+          void *val;
+          struct repos_cache_entry *ent;
+
+          apr_hash_this (hi, &key, NULL, &val);
+          ent = val;
+          if (ent->refcount == 0
+              && (victim == NULL || ent->last_used < victim->last_used))
+            {
+              victim = ent;
+              victim_key = key;
+            }
+        }
+
+      /* Every handle is in use; let the cache run over its limit
+         rather than yank a repository out from under a caller. */
+      if (victim == NULL)
+        return;
+
+      apr_hash_set (repos_cache, victim_key, APR_HASH_KEY_STRING, NULL);
+      svn_pool_destroy (victim->subpool);
+    }
+}
+
+
+/* A pool cleanup to release one caller's reference to the cached
+   repository handle ARG.  The handle itself stays open, ready for the
+   next caller. */
+static apr_status_t
+release_cached_repos (void *arg)
+{
+  struct repos_cache_entry *entry = arg;
+  entry->refcount--;
+  return APR_SUCCESS;
+}
+
+
+svn_error_t *
+svn_repos_open_cached (svn_repos_t **repos_p,
+                       const char *path,
+                       apr_pool_t *pool)
+{
+  struct repos_cache_entry *entry;
+
+  /* A cache size of zero means caching is switched off. */
+  if (repos_cache_max == 0)
+    return svn_repos_open (repos_p, path, pool);
+
+  /* Create the cache the first time through. */
+  if (! repos_cache)
+    {
+      repos_cache_pool = svn_pool_create (NULL);
+      repos_cache = apr_hash_make (repos_cache_pool);
+    }
+
+  entry = apr_hash_get (repos_cache, path, APR_HASH_KEY_STRING);
+  if (entry)
+    {
+      enum svn_node_kind kind;
+      const char *lockfile_path = svn_repos_db_lockfile (entry->repos, pool);
+
+      /* Make sure the repository is still where we left it; a stat of
+         the db lockfile is far cheaper than reopening the Berkeley
+         environment. */
+      if ((! svn_io_check_path (lockfile_path, &kind, pool))
+          && (kind == svn_node_file))
+        {
+          entry->refcount++;
+          entry->last_used = ++repos_cache_tick;
+          apr_pool_cleanup_register (pool, entry, release_cached_repos,
+                                     apr_pool_cleanup_null);
+          *repos_p = entry->repos;
+          return SVN_NO_ERROR;
+        }
+
+      /* The repository has moved out from under its handle.  Toss the
+         entry --- if no one is still using it --- and fall through to
+         a fresh open. */
+      apr_hash_set (repos_cache, path, APR_HASH_KEY_STRING, NULL);
+      if (entry->refcount == 0)
+        svn_pool_destroy (entry->subpool);
+    }
+
+  /* If PATH doesn't even have a db lockfile, it's probably not a
+     repository at all; let a plain, uncached open generate the error
+     (or the surprise), rather than littering the cache pool for every
+     bogus path probed --- svn_ra_local__split_URL tries each parent
+     of a URL in turn until one opens. */
+  {
+    enum svn_node_kind kind;
+    const char *lockfile_path
+      = apr_psprintf (pool, "%s/%s/%s",
+                      path, SVN_REPOS__LOCK_DIR, SVN_REPOS__DB_LOCKFILE);
+
+    if (svn_io_check_path (lockfile_path, &kind, pool)
+        || (kind != svn_node_file))
+      return svn_repos_open (repos_p, path, pool);
+  }
+
+  /* Make room if a cache size limit is in force. */
+  if (repos_cache_max > 0)
+    enforce_cache_size (pool);
+
+  /* Open the repository in a subpool of the cache's pool, so the
+     handle can outlive POOL and serve later callers. */
+  {
+    apr_pool_t *subpool = svn_pool_create (repos_cache_pool);
+    svn_repos_t *repos;
+    svn_error_t *err;
+
+    err = svn_repos_open (&repos, path, subpool);
+    if (err)
+      {
+        /* The error is allocated in SUBPOOL, so the subpool must
+           outlive this return; the stray allocation is the price of a
+           failed open. */
+        return err;
+      }
+    repos->cached = TRUE;
+
+    entry = apr_pcalloc (subpool, sizeof (*entry));
+    entry->repos = repos;
+    entry->subpool = subpool;
+    entry->refcount = 1;
+    entry->last_used = ++repos_cache_tick;
+    apr_hash_set (repos_cache, apr_pstrdup (subpool, path),
+                  APR_HASH_KEY_STRING, entry);
+    apr_pool_cleanup_register (pool, entry, release_cached_repos,
+                               apr_pool_cleanup_null);
+
+    *repos_p = repos;
+  }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
-svn_repos_delete (const char *path, 
+svn_repos_delete (const char *path,
                   apr_pool_t *pool)
 {
   apr_status_t apr_err;
@@ -708,6 +916,12 @@ svn_repos_delete (const char *path,
 svn_error_t *
 svn_repos_close (svn_repos_t *repos)
 {
+  /* A handle from svn_repos_open_cached stays open for the next
+     caller; the reference is released by the pool cleanup registered
+     there. */
+  if (repos->cached)
+    return SVN_NO_ERROR;
+
   /* Shut down the filesystem. */
   svn_fs_close_fs (repos->fs);
 
@@ -20,7 +20,9 @@
 
 #include "apr_pools.h"
 #include "apr_hash.h"
+#include "apr_file_io.h"
 #include "svn_fs.h"
+#include "svn_repos.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +43,10 @@ extern "C" {
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
 
+/* The deltification queue file, in the repository's top-level
+   directory.  See deltify.c. */
+#define SVN_REPOS__DELTIFY_QUEUE "deltify-queue"
+
 /* In the repository hooks directory, look for these files. */
 #define SVN_REPOS__HOOK_START_COMMIT    "start-commit"
 #define SVN_REPOS__HOOK_PRE_COMMIT      "pre-commit"
@@ -51,6 +57,13 @@ extern "C" {
 /* The extension added to the names of example hook scripts. */
 #define SVN_REPOS__HOOK_DESC_EXT        ".tmpl"
 
+/* If this file exists in the hooks directory, the post-commit hook is
+   run detached --- the commit doesn't wait for it to finish, and its
+   output is appended to SVN_REPOS__HOOK_POST_COMMIT_LOG instead of
+   going back to the client.  */
+#define SVN_REPOS__HOOK_POST_COMMIT_ASYNC  "post-commit-async"
+#define SVN_REPOS__HOOK_POST_COMMIT_LOG    "post-commit.log"
+
 
 /* The Repository object, created by svn_repos_open() and
    svn_repos_create(), allocated in POOL. */
@@ -80,9 +93,77 @@ struct svn_repos_t
   /* A pool, filled with allocated memory, a diving board, and a tube
      slide. */
   apr_pool_t *pool;
+
+  /* TRUE iff this handle lives in the process-wide repository cache
+     (see svn_repos_open_cached), in which case svn_repos_close leaves
+     it open for the next caller. */
+  svn_boolean_t cached;
+
+  /* A lazily built mirror of revision datestamps, so dated-revision
+     lookups probe memory instead of re-reading proplists from the
+     filesystem: DATE_CACHE[rev] holds revision REV's `svn:date' as
+     an apr_time_t, or 0 for not-fetched-yet.  DATE_CACHE_SIZE slots
+     are allocated; the array grows as the filesystem does.  See
+     rev_hunt.c. */
+  apr_time_t *date_cache;
+  svn_revnum_t date_cache_size;
+
+  /* Handles on our own stdout and stderr, lazily opened the first
+     time a hook is spawned and reused for every spawn after that;
+     see hooks.c.  NULL until then. */
+  apr_file_t *hook_stdout;
+  apr_file_t *hook_stderr;
 };
 
 
+/*** The reporter's in-memory base state. ***/
+
+/* The base state a report drive compares the target revision
+   against: one base revision, overlaid with the client's
+   mixed-revision paths and deletions.  The reporter used to mirror
+   this state in a real Berkeley DB transaction --- one svn_fs_link
+   per reported path, aborted when the drive finished --- so every
+   update wrote to the database and left dead-transaction garbage
+   behind.  Modeled in memory, the update path never writes at all.
+   Built by reporter.c, walked by svn_repos__dir_delta_base. */
+typedef struct svn_repos__report_base_t
+{
+  /* The root of the revision the drive is based on --- the revision
+     from the report's first set_path call. */
+  svn_fs_root_t *base_root;
+
+  /* The root of every revision the report named, keyed by revision
+     number (keyed by value).  Always holds the base revision. */
+  apr_hash_t *rev_roots;
+
+  /* Paths the client reported as deleted (const char *), in the same
+     form as the keys of the path/revision hash. */
+  apr_array_header_t *deletes;
+} svn_repos__report_base_t;
+
+
+/* Exactly svn_repos_dir_delta (see svn_repos.h), except that the
+   source tree is described by BASE together with SRC_REVS --- the
+   same path/revision hash --- instead of a transaction root.  Each
+   source path's contents are read from the root of the revision its
+   nearest reported ancestor named, and paths under a reported
+   deletion read as absent. */
+svn_error_t *
+svn_repos__dir_delta_base (svn_repos__report_base_t *base,
+                           const char *src_parent_dir,
+                           const char *src_entry,
+                           apr_hash_t *src_revs,
+                           svn_fs_root_t *tgt_root,
+                           const char *tgt_path,
+                           const svn_delta_edit_fns_t *editor,
+                           void *edit_baton,
+                           svn_boolean_t text_deltas,
+                           svn_boolean_t recurse,
+                           svn_boolean_t use_copyfrom_args,
+                           svn_repos_path_filter_t *filter,
+                           apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
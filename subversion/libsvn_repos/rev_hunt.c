@@ -42,24 +42,64 @@
 
 /* helper for svn_repos_dated_revision().
 
-   Set *TM to the apr_time_t datestamp on revision REV in FS. */
+   Set *TM to the apr_time_t datestamp on revision REV in
+   REPOS's filesystem, of which YOUNGEST is the youngest revision.
+
+   Datestamps are mirrored on the repository handle as they are
+   fetched, so a probe of a revision any earlier lookup through this
+   handle has seen is a pure memory read; only first-time probes pay
+   for a proplist read from the filesystem.  With the process-wide
+   handle cache this adds up fast for tools that resolve dates
+   constantly.  (A stale slot can't survive: a revision's datestamp
+   is set when the revision is committed, and the mirror is only ever
+   filled from the filesystem.)  */
 static svn_error_t *
 get_time (apr_time_t *tm,
-          svn_fs_t *fs,
+          svn_repos_t *repos,
           svn_revnum_t rev,
+          svn_revnum_t youngest,
           apr_pool_t *pool)
 {
   svn_string_t *date_str;
 
-  SVN_ERR (svn_fs_revision_prop (&date_str, fs, rev, SVN_PROP_REVISION_DATE,
-                                 pool));
-  if (! date_str)    
+  if (rev < repos->date_cache_size && repos->date_cache[rev] != 0)
+    {
+      *tm = repos->date_cache[rev];
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR (svn_fs_revision_prop (&date_str, repos->fs, rev,
+                                 SVN_PROP_REVISION_DATE, pool));
+  if (! date_str)
     return svn_error_createf
       (SVN_ERR_FS_GENERAL, 0, NULL, pool,
        "failed to find tm on revision %ld", rev);
 
   *tm = svn_time_from_nts (date_str->data);
 
+  /* Grow the mirror to cover the filesystem as it stands now.  Grow
+     at least geometrically, so a long-lived handle watching a busy
+     repository doesn't reallocate on every new revision. */
+  if (rev >= repos->date_cache_size)
+    {
+      svn_revnum_t new_size = repos->date_cache_size * 2;
+      apr_time_t *new_cache;
+
+      if (new_size < youngest + 1)
+        new_size = youngest + 1;
+
+      new_cache = apr_pcalloc (repos->pool,
+                               new_size * sizeof (*new_cache));
+      if (repos->date_cache)
+        memcpy (new_cache, repos->date_cache,
+                repos->date_cache_size * sizeof (*new_cache));
+      repos->date_cache = new_cache;
+      repos->date_cache_size = new_size;
+    }
+
+  if (*tm != 0)
+    repos->date_cache[rev] = *tm;
+
   return SVN_NO_ERROR;
 }
 
@@ -82,7 +122,7 @@ svn_repos_dated_revision (svn_revnum_t *revision,
   while (rev_bot <= rev_top)
     {
       rev_mid = (rev_top + rev_bot) / 2;
-      SVN_ERR (get_time (&this_time, fs, rev_mid, pool));
+      SVN_ERR (get_time (&this_time, repos, rev_mid, rev_latest, pool));
       
       if (this_time > tm)/* we've overshot */
         {
@@ -95,7 +135,8 @@ svn_repos_dated_revision (svn_revnum_t *revision,
             }
 
           /* see if time falls between rev_mid and rev_mid-1: */
-          SVN_ERR (get_time (&previous_time, fs, rev_mid - 1, pool));
+          SVN_ERR (get_time (&previous_time, repos, rev_mid - 1,
+                             rev_latest, pool));
           if (previous_time <= tm)
             {
               *revision = rev_mid - 1;
@@ -116,7 +157,8 @@ svn_repos_dated_revision (svn_revnum_t *revision,
             }
           
           /* see if time falls between rev_mid and rev_mid+1: */
-          SVN_ERR (get_time (&next_time, fs, rev_mid + 1, pool));
+          SVN_ERR (get_time (&next_time, repos, rev_mid + 1,
+                             rev_latest, pool));
           if (next_time > tm)
             {
               *revision = rev_mid + 1;
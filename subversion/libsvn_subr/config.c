@@ -232,6 +232,41 @@ for_each_option (svn_config_t *cfg, void *baton, apr_pool_t *pool,
 }
 
 
+/* Baton for raw_iter_callback. */
+struct raw_iter_baton
+{
+  void *real_baton;
+  svn_boolean_t (*callback) (void *baton, const char *section,
+                             const char *option, const char *value);
+};
+
+
+/* Adapt a for_each_option callback into the table-entry-free form
+   that svn_config__for_each promises its callers. */
+static svn_boolean_t
+raw_iter_callback (void *baton, cfg_section_t *section, cfg_option_t *option)
+{
+  struct raw_iter_baton *ib = baton;
+  return ib->callback (ib->real_baton, section->name,
+                       option->name, option->value);
+}
+
+
+void
+svn_config__for_each (svn_config_t *cfg, void *baton, apr_pool_t *pool,
+                      svn_boolean_t callback (void *baton,
+                                              const char *section,
+                                              const char *option,
+                                              const char *value))
+{
+  struct raw_iter_baton ib;
+
+  ib.real_baton = baton;
+  ib.callback = callback;
+  for_each_option (cfg, &ib, pool, raw_iter_callback);
+}
+
+
 
 static svn_boolean_t
 merge_callback (void *baton, cfg_section_t *section, cfg_option_t *option)
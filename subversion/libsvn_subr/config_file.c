@@ -19,9 +19,12 @@
 
 
 #define APR_WANT_STDIO
+#define APR_WANT_STRFUNC
+#define APR_WANT_MEMFUNC
 #include <apr_want.h>
 
 #include <apr_lib.h>
+#include <apr_strings.h>
 #include "config_impl.h"
 #include "svn_io.h"
 #include "svn_types.h"
@@ -326,6 +329,257 @@ svn_config__user_config_path (const char **path_p,
 }
 
 
+/*** Compiled configuration cache. ***/
+
+/* A parsed config file is dumped to a sibling cache file, so the next
+ * invocation can replay the parse results instead of repeating the
+ * character-at-a-time grind above.  The cache records the source
+ * file's mtime and is honored only while that still matches.  The
+ * format borrows the counted-string register of svn_hash_write:
+ *
+ *   SVN config cache 1
+ *   M <mtime>
+ *   S <nlength>
+ *   section name (a string of <nlength> bytes, followed by a newline)
+ *   K <nlength>
+ *   option name
+ *   V <vlength>
+ *   value
+ *   [... etc, etc ...]
+ *   END
+ *
+ * An S line switches the current section; the K/V pairs that follow
+ * belong to it.  Anything unexpected -- wrong magic, stale mtime,
+ * truncation -- just means "no cache", and we fall back to parsing.
+ */
+
+#define SVN_CONFIG__CACHE_MAGIC "SVN config cache 1\n"
+#define SVN_CONFIG__CACHE_SUFFIX ".cache"
+
+/* The size of the chunks the cache is slurped down in. */
+#define SVN_CONFIG__CACHE_BLOCKSIZE 4096
+
+
+/* One (section, option, value) triple replayed from a cache file. */
+struct cache_entry
+{
+  const char *section;
+  const char *option;
+  const char *value;
+};
+
+
+/* Parse a counted string at *P (bounded by END): a length line
+   starting with LETTER, then that many bytes and a newline.  Set *STR
+   to the string, NUL-terminated in place, and advance *P past it.
+   Return FALSE if the bytes at *P are anything else. */
+static svn_boolean_t
+read_counted_string (char **p, char *end, char letter, const char **str)
+{
+  char *eol = memchr (*p, '\n', end - *p);
+  int len;
+
+  if (eol == NULL || (*p)[0] != letter || (*p)[1] != ' ')
+    return FALSE;
+
+  len = atoi (*p + 2);
+  *p = eol + 1;
+  if (len < 0
+      || (apr_size_t) (end - *p) < (apr_size_t) len + 1
+      || (*p)[len] != '\n')
+    return FALSE;
+
+  (*p)[len] = '\0';
+  *str = *p;
+  *p += len + 1;
+  return TRUE;
+}
+
+
+/* Try to load CFG from FILE's cache, which is fresh only if it
+   records MTIME.  Return TRUE iff the cache was fresh and completely
+   replayed into CFG.  Use POOL for scratchwork. */
+static svn_boolean_t
+read_cache_file (svn_config_t *cfg, const char *file,
+                 apr_time_t mtime, apr_pool_t *pool)
+{
+  apr_file_t *f;
+  apr_status_t apr_err;
+  svn_stringbuf_t *buffer;
+  apr_array_header_t *entries;
+  const char *section = NULL;
+  char *p, *end, *eol;
+  int i;
+
+  apr_err = apr_file_open (&f, apr_pstrcat (pool, file,
+                                            SVN_CONFIG__CACHE_SUFFIX, NULL),
+                           APR_READ, APR_OS_DEFAULT, pool);
+  if (apr_err)
+    return FALSE;
+
+  /* Slurp the whole cache; it is small, and the strings can then be
+     used in place, as in svn_hash_read. */
+  buffer = svn_stringbuf_create ("", pool);
+  do
+    {
+      apr_size_t len = SVN_CONFIG__CACHE_BLOCKSIZE;
+
+      svn_stringbuf_ensure (buffer, buffer->len + len);
+      apr_err = apr_file_read (f, buffer->data + buffer->len, &len);
+      if (apr_err && ! APR_STATUS_IS_EOF (apr_err))
+        {
+          apr_file_close (f);
+          return FALSE;
+        }
+      buffer->len += len;
+    }
+  while (! apr_err);
+  apr_file_close (f);
+
+  p = buffer->data;
+  end = buffer->data + buffer->len;
+
+  /* Check the magic. */
+  if ((apr_size_t) (end - p) < sizeof (SVN_CONFIG__CACHE_MAGIC) - 1
+      || memcmp (p, SVN_CONFIG__CACHE_MAGIC,
+                 sizeof (SVN_CONFIG__CACHE_MAGIC) - 1) != 0)
+    return FALSE;
+  p += sizeof (SVN_CONFIG__CACHE_MAGIC) - 1;
+
+  /* Check the recorded mtime. */
+  eol = memchr (p, '\n', end - p);
+  if (eol == NULL || p[0] != 'M' || p[1] != ' ')
+    return FALSE;
+  *eol = '\0';
+  if (apr_atoi64 (p + 2) != mtime)
+    return FALSE;
+  p = eol + 1;
+
+  /* Collect the entries first, and apply them only after seeing END,
+     so a truncated cache cannot leave CFG half-filled. */
+  entries = apr_array_make (pool, 16, sizeof (struct cache_entry));
+  while (1)
+    {
+      if ((end - p) >= 4 && memcmp (p, "END\n", 4) == 0)
+        break;
+
+      if ((end - p) > 0 && p[0] == 'S')
+        {
+          if (! read_counted_string (&p, end, 'S', &section))
+            return FALSE;
+        }
+      else
+        {
+          struct cache_entry *entry;
+
+          if (section == NULL)
+            return FALSE;
+          entry = apr_array_push (entries);
+          entry->section = section;
+          if (! read_counted_string (&p, end, 'K', &entry->option)
+              || ! read_counted_string (&p, end, 'V', &entry->value))
+            return FALSE;
+        }
+    }
+
+  for (i = 0; i < entries->nelts; i++)
+    {
+      struct cache_entry *entry = &APR_ARRAY_IDX (entries, i,
+                                                  struct cache_entry);
+      svn_config_set (cfg, entry->section, entry->option, entry->value);
+    }
+
+  return TRUE;
+}
+
+
+/* Baton for write_cache_callback. */
+struct write_cache_baton
+{
+  apr_file_t *file;
+  const char *section;          /* last section written, or null */
+  svn_boolean_t write_error;
+};
+
+
+/* An svn_config__for_each callback: write one option to the cache,
+   preceded by an S line if the section has changed. */
+static svn_boolean_t
+write_cache_callback (void *baton, const char *section,
+                      const char *option, const char *value)
+{
+  struct write_cache_baton *wb = baton;
+
+  if (wb->section == NULL || strcmp (wb->section, section) != 0)
+    {
+      if (apr_file_printf (wb->file, "S %lu\n%s\n",
+                           (unsigned long) strlen (section), section) < 0)
+        {
+          wb->write_error = TRUE;
+          return TRUE;
+        }
+      wb->section = section;
+    }
+
+  if (apr_file_printf (wb->file, "K %lu\n%s\nV %lu\n%s\n",
+                       (unsigned long) strlen (option), option,
+                       (unsigned long) strlen (value), value) < 0)
+    {
+      wb->write_error = TRUE;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+/* Write CFG, freshly parsed from FILE which had mtime MTIME, to
+   FILE's cache.  The cache is a luxury: on any failure (a read-only
+   configuration area, say), clean up and return without complaint. */
+static void
+write_cache_file (svn_config_t *cfg, const char *file,
+                  apr_time_t mtime, apr_pool_t *pool)
+{
+  const char *cache_path = apr_pstrcat (pool, file,
+                                        SVN_CONFIG__CACHE_SUFFIX, NULL);
+  svn_stringbuf_t *tmp_name;
+  apr_file_t *f;
+  struct write_cache_baton wb;
+  apr_status_t apr_err;
+  svn_error_t *err;
+
+  /* Write to a unique temporary and rename into place, so a reader
+     can never see a half-written cache. */
+  err = svn_io_open_unique_file (&f, &tmp_name, cache_path, ".tmp",
+                                 FALSE, pool);
+  if (err)
+    {
+      svn_error_clear_all (err);
+      return;
+    }
+
+  wb.file = f;
+  wb.section = NULL;
+  wb.write_error = FALSE;
+
+  if (apr_file_printf (f, SVN_CONFIG__CACHE_MAGIC
+                       "M %" APR_TIME_T_FMT "\n", mtime) < 0)
+    wb.write_error = TRUE;
+  else
+    svn_config__for_each (cfg, &wb, pool, write_cache_callback);
+
+  if (! wb.write_error
+      && apr_file_printf (f, "END\n") < 0)
+    wb.write_error = TRUE;
+
+  apr_err = apr_file_close (f);
+
+  if (wb.write_error || apr_err
+      || apr_file_rename (tmp_name->data, cache_path, pool))
+    apr_file_remove (tmp_name->data, pool);
+}
+
+
 
 /*** Exported interfaces. ***/
 
@@ -336,13 +590,36 @@ svn_config__parse_file (svn_config_t *cfg, const char *file,
   svn_error_t *err = SVN_NO_ERROR;
   parse_context_t ctx;
   int ch, count;
+  apr_finfo_t finfo;
+  svn_boolean_t have_mtime;
+  FILE *fd;
+
+  /* A fresh parse of FILE can be replayed from its compiled cache,
+     sparing every invocation the grind below.  (CFG is always freshly
+     created when we get it -- svn_config_read makes a new config even
+     for a merge -- so replaying the cache alone yields exactly FILE's
+     contents.)  The mtime fetched here also validates the cache we
+     may write after parsing. */
+  {
+    apr_pool_t *subpool = svn_pool_create (cfg->pool);
+
+    have_mtime = (apr_stat (&finfo, file, APR_FINFO_MTIME, subpool)
+                  == APR_SUCCESS);
+    if (have_mtime && read_cache_file (cfg, file, finfo.mtime, subpool))
+      {
+        svn_pool_destroy (subpool);
+        return SVN_NO_ERROR;
+      }
+    svn_pool_destroy (subpool);
+  }
+
   /* "Why," you ask yourself, "is he using stdio FILE's instead of
      apr_file_t's?"  The answer is simple: newline translation.  For
      all that it has an APR_BINARY flag, APR doesn't do newline
      translation in files.  The only portable way I know to get
      translated text files is to use the standard stdio library. */
 
-  FILE *fd = fopen (file, "rt");
+  fd = fopen (file, "rt");
   if (fd == NULL)
     {
       if (errno != ENOENT)
@@ -439,6 +716,12 @@ svn_config__parse_file (svn_config_t *cfg, const char *file,
 
   svn_pool_destroy (ctx.pool);
   fclose (fd);
+
+  /* Compile what we just parsed, so the next invocation can skip all
+     of the above.  Failure to write the cache is no failure at all. */
+  if (err == SVN_NO_ERROR && have_mtime)
+    write_cache_file (cfg, file, finfo.mtime, cfg->pool);
+
   return err;
 }
 
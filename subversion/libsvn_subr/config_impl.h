@@ -62,6 +62,19 @@ svn_error_t *svn_config__parse_file (svn_config_t *cfg,
                                      svn_boolean_t must_exist);
 
 
+/* Invoke CALLBACK with BATON for every option in CFG, passing the
+   section name, the option name, and the raw (unexpanded) value.
+   Stop early if CALLBACK returns TRUE.  Iteration state is allocated
+   in POOL.  This exists for the benefit of the compiled config cache
+   in config_file.c, which has no business knowing about the table
+   entry structs private to config.c. */
+void svn_config__for_each (svn_config_t *cfg, void *baton, apr_pool_t *pool,
+                           svn_boolean_t callback (void *baton,
+                                                   const char *section,
+                                                   const char *option,
+                                                   const char *value));
+
+
 #ifdef SVN_WIN32
 /* Read sections and options from the Windows Registry. */
 svn_error_t *svn_config__parse_registry (svn_config_t *cfg,
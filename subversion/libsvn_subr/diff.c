@@ -0,0 +1,784 @@
+/*
+ * diff.c:   built-in line-based diff engine
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+#include <limits.h>
+#include <apr_pools.h>
+#include <apr_general.h>        /* for APR_INLINE */
+#include <apr_file_io.h>
+#include "svn_types.h"
+#include "svn_string.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+
+/* This is a plain unified-diff engine, so that "svn diff" needn't
+   fork an external diff program once per changed file.  It computes
+   a minimal edit script with the divide-and-conquer refinement of
+   Myers' O(ND) algorithm --- find the middle snake of the shortest
+   edit path using a forward and a backward search that each go at
+   most half way, then recurse on the two halves --- so memory stays
+   linear in the size of the files no matter how different they are.
+
+   The result is expressed as a "changed" flag per line of each file,
+   from which the unified hunks are trivially read off. */
+
+
+/* How many lines of context to show around each hunk. */
+#define DIFF_CONTEXT 3
+
+
+/* A line of input: TEXT points into the file's buffer and LEN counts
+   the bytes up to and including the newline.  The last line of a file
+   may lack the newline; since LEN includes it when present, two lines
+   compare equal only if their newline situation matches too. */
+struct diff_line
+{
+  const char *text;
+  apr_size_t len;
+};
+
+
+/* The state threaded through the divide-and-conquer recursion. */
+struct diff_ctx
+{
+  struct diff_line *a;        /* the left file's lines */
+  struct diff_line *b;        /* the right file's lines */
+  svn_boolean_t *changed_a;   /* per-line: deleted from the left? */
+  svn_boolean_t *changed_b;   /* per-line: added on the right? */
+  int *vf;                    /* forward diagonal vector */
+  int *vb;                    /* backward diagonal vector */
+  int voffset;                /* index of diagonal 0 in vf and vb */
+};
+
+
+static APR_INLINE svn_boolean_t
+lines_equal (const struct diff_line *x, const struct diff_line *y)
+{
+  return ((x->len == y->len)
+          && (memcmp (x->text, y->text, x->len) == 0));
+}
+
+
+/* Split BUF of length LEN into lines, returning them in *LINES_P
+   (allocated in POOL) and their number in *NLINES_P. */
+static void
+split_lines (struct diff_line **lines_p,
+             int *nlines_p,
+             const char *buf,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  struct diff_line *lines;
+  int nlines = 0;
+  const char *p, *end = buf + len;
+
+  /* Count the lines, then fill in the array. */
+  for (p = buf; p < end; nlines++)
+    {
+      const char *eol = memchr (p, '\n', end - p);
+      p = eol ? (eol + 1) : end;
+    }
+
+  lines = apr_palloc (pool, (nlines ? nlines : 1) * sizeof (*lines));
+
+  nlines = 0;
+  for (p = buf; p < end; nlines++)
+    {
+      const char *eol = memchr (p, '\n', end - p);
+      lines[nlines].text = p;
+      lines[nlines].len = (eol ? (eol + 1) : end) - p;
+      p = eol ? (eol + 1) : end;
+    }
+
+  *lines_p = lines;
+  *nlines_p = nlines;
+}
+
+
+/* Find the middle snake of the shortest edit path between the N lines
+   of CTX->a starting at A0 and the M lines of CTX->b starting at B0,
+   returning a point (*PX,*PY) on it in absolute line indices.  The
+   caller guarantees N and M are positive and that the first and last
+   line pairs differ.
+
+   Diagonal k holds the points where x - y == k, for x in [0,N] and y
+   in [0,M]; vf[k] is the furthest x a forward path from (0,0) has
+   reached on it, vb[k] the smallest x a backward path from (N,M) has
+   reached.  The searched band of diagonals widens by one on each side
+   per step, clipped to the valid range, with sentinel values just
+   outside it so the neighbor comparisons need no boundary cases. */
+static void
+find_middle_snake (struct diff_ctx *ctx,
+                   int a0, int n,
+                   int b0, int m,
+                   int *px, int *py)
+{
+  int *vf = ctx->vf + ctx->voffset;
+  int *vb = ctx->vb + ctx->voffset;
+  int delta = n - m;
+  int odd = delta & 1;
+  int fmin = 0, fmax = 0;           /* forward band, around diagonal 0 */
+  int bmin = delta, bmax = delta;   /* backward band, around diagonal delta */
+  int d, k, x, y;
+
+  vf[0] = 0;
+  vb[delta] = n;
+
+  for (d = 1; d <= n + m; d++)
+    {
+      /* Widen the forward band and extend its paths. */
+      if (fmin > -m)
+        vf[--fmin - 1] = -1;
+      else
+        ++fmin;
+      if (fmax < n)
+        vf[++fmax + 1] = -1;
+      else
+        --fmax;
+      for (k = fmax; k >= fmin; k -= 2)
+        {
+          if (vf[k - 1] >= vf[k + 1])
+            x = vf[k - 1] + 1;
+          else
+            x = vf[k + 1];
+          y = x - k;
+          while (x < n && y < m
+                 && lines_equal (&ctx->a[a0 + x], &ctx->b[b0 + y]))
+            {
+              x++;
+              y++;
+            }
+          vf[k] = x;
+
+          if (odd && bmin <= k && k <= bmax && vb[k] <= x)
+            {
+              *px = a0 + x;
+              *py = b0 + y;
+              return;
+            }
+        }
+
+      /* Likewise for the backward band. */
+      if (bmin > -m)
+        vb[--bmin - 1] = INT_MAX;
+      else
+        ++bmin;
+      if (bmax < n)
+        vb[++bmax + 1] = INT_MAX;
+      else
+        --bmax;
+      for (k = bmax; k >= bmin; k -= 2)
+        {
+          if (vb[k - 1] < vb[k + 1])
+            x = vb[k - 1];
+          else
+            x = vb[k + 1] - 1;
+          y = x - k;
+          while (x > 0 && y > 0
+                 && lines_equal (&ctx->a[a0 + x - 1], &ctx->b[b0 + y - 1]))
+            {
+              x--;
+              y--;
+            }
+          vb[k] = x;
+
+          if (! odd && fmin <= k && k <= fmax && x <= vf[k])
+            {
+              *px = a0 + x;
+              *py = b0 + y;
+              return;
+            }
+        }
+    }
+
+  /* Unreachable --- the searches must meet within n + m steps --- but
+     deleting everything and inserting everything is always a correct
+     answer. */
+  *px = a0;
+  *py = b0 + m;
+}
+
+
+/* Mark the changed lines between the N lines of CTX->a starting at A0
+   and the M lines of CTX->b starting at B0. */
+static void
+diff_compare (struct diff_ctx *ctx,
+              int a0, int n,
+              int b0, int m)
+{
+  int x, y, i;
+
+  /* Strip the common prefix and suffix; only the middle needs the
+     expensive treatment. */
+  while (n > 0 && m > 0 && lines_equal (&ctx->a[a0], &ctx->b[b0]))
+    {
+      a0++;
+      b0++;
+      n--;
+      m--;
+    }
+  while (n > 0 && m > 0
+         && lines_equal (&ctx->a[a0 + n - 1], &ctx->b[b0 + m - 1]))
+    {
+      n--;
+      m--;
+    }
+
+  if (n == 0)
+    {
+      for (i = 0; i < m; i++)
+        ctx->changed_b[b0 + i] = TRUE;
+      return;
+    }
+  if (m == 0)
+    {
+      for (i = 0; i < n; i++)
+        ctx->changed_a[a0 + i] = TRUE;
+      return;
+    }
+
+  find_middle_snake (ctx, a0, n, b0, m, &x, &y);
+
+  if ((x == a0 && y == b0) || (x == a0 + n && y == b0 + m))
+    {
+      /* A degenerate split would recurse forever; the whole range
+         differs, so just say so. */
+      for (i = 0; i < n; i++)
+        ctx->changed_a[a0 + i] = TRUE;
+      for (i = 0; i < m; i++)
+        ctx->changed_b[b0 + i] = TRUE;
+      return;
+    }
+
+  diff_compare (ctx, a0, x - a0, b0, y - b0);
+  diff_compare (ctx, x, a0 + n - x, y, b0 + m - y);
+}
+
+
+/* Write LINE to OUTFILE prefixed with PREFIX, flagging a missing
+   newline the way diff does. */
+static svn_error_t *
+output_line (apr_file_t *outfile,
+             char prefix,
+             const struct diff_line *line,
+             apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+  apr_size_t len = line->len;
+
+  apr_err = apr_file_putc (prefix, outfile);
+  if (! apr_err)
+    apr_err = apr_file_write (outfile, line->text, &len);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "output_line: error writing diff output");
+
+  if (line->len == 0 || line->text[line->len - 1] != '\n')
+    apr_file_printf (outfile, "\n\\ No newline at end of file\n");
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Print one side of a hunk header: START is a zero-based line index,
+   COUNT the number of lines.  diff's convention is one-based, with
+   ",1" left implicit and an empty range naming the line before it. */
+static void
+output_range (apr_file_t *outfile, int start, int count)
+{
+  if (count == 1)
+    apr_file_printf (outfile, "%d", start + 1);
+  else
+    apr_file_printf (outfile, "%d,%d",
+                     (count == 0) ? start : start + 1, count);
+}
+
+
+/* Write the unified hunks implied by the changed flags in CTX to
+   OUTFILE, preceding the first one with a "---"/"+++" header built
+   from FROM_LABEL and TO_LABEL.  N and M are the line counts of the
+   two files. */
+static svn_error_t *
+output_unified (struct diff_ctx *ctx,
+                int n, int m,
+                const char *from_label,
+                const char *to_label,
+                apr_file_t *outfile,
+                apr_pool_t *pool)
+{
+  svn_boolean_t wrote_header = FALSE;
+  int i = 0, j = 0;
+
+  while (i < n || j < m)
+    {
+      int hunk_i, hunk_j, end_i, end_j, gap;
+
+      /* Skip the unchanged run before the next hunk. */
+      if (i < n && ! ctx->changed_a[i]
+          && j < m && ! ctx->changed_b[j])
+        {
+          i++;
+          j++;
+          continue;
+        }
+
+      /* A hunk starts at most DIFF_CONTEXT lines back. */
+      hunk_i = (i > DIFF_CONTEXT) ? i - DIFF_CONTEXT : 0;
+      hunk_j = (j > DIFF_CONTEXT) ? j - DIFF_CONTEXT : 0;
+
+      /* Find where it ends: keep swallowing changes until a gap of
+         unchanged lines big enough to separate two hunks' context. */
+      end_i = i;
+      end_j = j;
+      gap = 0;
+      while (end_i < n || end_j < m)
+        {
+          if (end_i < n && ctx->changed_a[end_i])
+            {
+              end_i++;
+              gap = 0;
+            }
+          else if (end_j < m && ctx->changed_b[end_j])
+            {
+              end_j++;
+              gap = 0;
+            }
+          else
+            {
+              if (gap >= 2 * DIFF_CONTEXT)
+                break;
+              end_i++;
+              end_j++;
+              gap++;
+            }
+        }
+
+      /* Trim the trailing unchanged run down to context size. */
+      if (gap > DIFF_CONTEXT)
+        {
+          end_i -= gap - DIFF_CONTEXT;
+          end_j -= gap - DIFF_CONTEXT;
+        }
+
+      if (! wrote_header)
+        {
+          apr_file_printf (outfile, "--- %s\n", from_label);
+          apr_file_printf (outfile, "+++ %s\n", to_label);
+          wrote_header = TRUE;
+        }
+
+      apr_file_printf (outfile, "@@ -");
+      output_range (outfile, hunk_i, end_i - hunk_i);
+      apr_file_printf (outfile, " +");
+      output_range (outfile, hunk_j, end_j - hunk_j);
+      apr_file_printf (outfile, " @@\n");
+
+      i = hunk_i;
+      j = hunk_j;
+      while (i < end_i || j < end_j)
+        {
+          if (i < end_i && ctx->changed_a[i])
+            {
+              SVN_ERR (output_line (outfile, '-', &ctx->a[i], pool));
+              i++;
+            }
+          else if (j < end_j && ctx->changed_b[j])
+            {
+              SVN_ERR (output_line (outfile, '+', &ctx->b[j], pool));
+              j++;
+            }
+          else
+            {
+              SVN_ERR (output_line (outfile, ' ', &ctx->a[i], pool));
+              i++;
+              j++;
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+
+svn_error_t *
+svn_io_diff_files (const char *from,
+                   const char *to,
+                   const char *from_label,
+                   const char *to_label,
+                   apr_file_t *outfile,
+                   apr_pool_t *pool)
+{
+  struct diff_ctx ctx;
+  svn_stringbuf_t *from_contents, *to_contents;
+  int n, m, vsize;
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  SVN_ERR (svn_string_from_file (&from_contents, from, subpool));
+  SVN_ERR (svn_string_from_file (&to_contents, to, subpool));
+
+  split_lines (&ctx.a, &n, from_contents->data, from_contents->len, subpool);
+  split_lines (&ctx.b, &m, to_contents->data, to_contents->len, subpool);
+
+  ctx.changed_a = apr_pcalloc (subpool, (n ? n : 1) * sizeof (svn_boolean_t));
+  ctx.changed_b = apr_pcalloc (subpool, (m ? m : 1) * sizeof (svn_boolean_t));
+
+  /* The diagonal vectors span every diagonal of the full problem,
+     plus one sentinel slot on each end; subproblems reuse them. */
+  vsize = n + m + 3;
+  ctx.vf = apr_palloc (subpool, vsize * sizeof (int));
+  ctx.vb = apr_palloc (subpool, vsize * sizeof (int));
+  ctx.voffset = m + 1;
+
+  diff_compare (&ctx, 0, n, 0, m);
+
+  SVN_ERR (output_unified (&ctx, n, m,
+                           from_label ? from_label : from,
+                           to_label ? to_label : to,
+                           outfile, subpool));
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Three-way merging. ***/
+
+/* One edit between a base file and one derived side of a merge:
+   base lines [base_lo, base_hi) were replaced by the side's lines
+   [side_lo, side_hi).  Either range may be empty (pure insertion or
+   deletion). */
+struct merge_hunk
+{
+  int base_lo, base_hi;
+  int side_lo, side_hi;
+};
+
+
+/* Read the maximal changed runs off a pair of changed-flag vectors
+   (as produced by diff_compare) into an array of merge_hunk. */
+static apr_array_header_t *
+collect_hunks (const svn_boolean_t *changed_base, int n,
+               const svn_boolean_t *changed_side, int m,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *hunks
+    = apr_array_make (pool, 4, sizeof (struct merge_hunk));
+  int i = 0, j = 0;
+
+  while (i < n || j < m)
+    {
+      if ((i < n && changed_base[i]) || (j < m && changed_side[j]))
+        {
+          struct merge_hunk *hunk = apr_array_push (hunks);
+
+          hunk->base_lo = i;
+          hunk->side_lo = j;
+          while (i < n && changed_base[i])
+            i++;
+          while (j < m && changed_side[j])
+            j++;
+          hunk->base_hi = i;
+          hunk->side_hi = j;
+        }
+      else
+        {
+          /* An unchanged line on both sides; walk past it. */
+          i++;
+          j++;
+        }
+    }
+
+  return hunks;
+}
+
+
+/* True iff lines [x_lo, x_hi) of X match lines [y_lo, y_hi) of Y. */
+static svn_boolean_t
+ranges_equal (const struct diff_line *x, int x_lo, int x_hi,
+              const struct diff_line *y, int y_lo, int y_hi)
+{
+  if (x_hi - x_lo != y_hi - y_lo)
+    return FALSE;
+  while (x_lo < x_hi)
+    if (! lines_equal (&x[x_lo++], &y[y_lo++]))
+      return FALSE;
+  return TRUE;
+}
+
+
+/* Where merged output goes.  A line without a terminating newline
+   only stays that way if nothing follows it; if more output comes, a
+   newline is supplied first so the result stays line-structured. */
+struct merge_output
+{
+  apr_file_t *file;
+  svn_boolean_t missing_newline;
+};
+
+
+static svn_error_t *
+merge_write (struct merge_output *out,
+             const char *buf,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+  apr_size_t written;
+
+  if (out->missing_newline)
+    {
+      written = 1;
+      apr_err = apr_file_write (out->file, "\n", &written);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "merge_write: error writing merged result");
+      out->missing_newline = FALSE;
+    }
+
+  written = len;
+  apr_err = apr_file_write (out->file, buf, &written);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "merge_write: error writing merged result");
+
+  if (len > 0 && buf[len - 1] != '\n')
+    out->missing_newline = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+merge_write_lines (struct merge_output *out,
+                   const struct diff_line *lines,
+                   int lo, int hi,
+                   apr_pool_t *pool)
+{
+  int i;
+
+  for (i = lo; i < hi; i++)
+    SVN_ERR (merge_write (out, lines[i].text, lines[i].len, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_io_merge_files (const char *mine,
+                    const char *older,
+                    const char *yours,
+                    const char *mine_label,
+                    const char *older_label,
+                    const char *yours_label,
+                    apr_file_t *merged,
+                    svn_boolean_t *conflicted,
+                    apr_pool_t *pool)
+{
+  struct diff_ctx dm, dy;
+  struct merge_output out;
+  svn_stringbuf_t *older_contents, *mine_contents, *yours_contents;
+  struct diff_line *older_lines;
+  apr_array_header_t *mine_hunks, *yours_hunks;
+  struct merge_hunk *mh, *yh;
+  int n_older, n_mine, n_yours, vsize;
+  int o, m, y, h1, h2;
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  /* Labels fall back to sensible defaults if not specified, same as
+     svn_io_run_diff3. */
+  if (mine_label == NULL)
+    mine_label = ".working";
+  if (older_label == NULL)
+    older_label = ".old";
+  if (yours_label == NULL)
+    yours_label = ".new";
+
+  SVN_ERR (svn_string_from_file (&older_contents, older, subpool));
+  SVN_ERR (svn_string_from_file (&mine_contents, mine, subpool));
+  SVN_ERR (svn_string_from_file (&yours_contents, yours, subpool));
+
+  split_lines (&older_lines, &n_older,
+               older_contents->data, older_contents->len, subpool);
+  dm.a = dy.a = older_lines;
+  split_lines (&dm.b, &n_mine,
+               mine_contents->data, mine_contents->len, subpool);
+  split_lines (&dy.b, &n_yours,
+               yours_contents->data, yours_contents->len, subpool);
+
+  /* Diff the base against each side separately. */
+  dm.changed_a = apr_pcalloc (subpool,
+                              (n_older ? n_older : 1)
+                              * sizeof (svn_boolean_t));
+  dm.changed_b = apr_pcalloc (subpool,
+                              (n_mine ? n_mine : 1) * sizeof (svn_boolean_t));
+  vsize = n_older + n_mine + 3;
+  dm.vf = apr_palloc (subpool, vsize * sizeof (int));
+  dm.vb = apr_palloc (subpool, vsize * sizeof (int));
+  dm.voffset = n_mine + 1;
+  diff_compare (&dm, 0, n_older, 0, n_mine);
+
+  dy.changed_a = apr_pcalloc (subpool,
+                              (n_older ? n_older : 1)
+                              * sizeof (svn_boolean_t));
+  dy.changed_b = apr_pcalloc (subpool,
+                              (n_yours ? n_yours : 1)
+                              * sizeof (svn_boolean_t));
+  vsize = n_older + n_yours + 3;
+  dy.vf = apr_palloc (subpool, vsize * sizeof (int));
+  dy.vb = apr_palloc (subpool, vsize * sizeof (int));
+  dy.voffset = n_yours + 1;
+  diff_compare (&dy, 0, n_older, 0, n_yours);
+
+  mine_hunks = collect_hunks (dm.changed_a, n_older,
+                              dm.changed_b, n_mine, subpool);
+  yours_hunks = collect_hunks (dy.changed_a, n_older,
+                               dy.changed_b, n_yours, subpool);
+  mh = (struct merge_hunk *) mine_hunks->elts;
+  yh = (struct merge_hunk *) yours_hunks->elts;
+
+  /* Walk the two hunk lists in base order, fusing hunks whose base
+     ranges overlap or abut into chunks.  A chunk touched from only
+     one side merges cleanly; a chunk touched from both sides merges
+     cleanly only if the two sides agree, and otherwise gets the full
+     three-part conflict markers, diff3 -A style. */
+  out.file = merged;
+  out.missing_newline = FALSE;
+  *conflicted = FALSE;
+  o = m = y = 0;
+  h1 = h2 = 0;
+
+  while (h1 < mine_hunks->nelts || h2 < yours_hunks->nelts)
+    {
+      int chunk_lo, chunk_hi;
+      int use1 = 0, use2 = 0;
+      int m_delta = 0, y_delta = 0;
+      int m_lo, m_hi, y_lo, y_hi;
+      svn_boolean_t absorbed;
+
+      /* Start the chunk at the earliest unconsumed hunk. */
+      chunk_lo = n_older + 1;
+      if (h1 < mine_hunks->nelts && mh[h1].base_lo < chunk_lo)
+        chunk_lo = mh[h1].base_lo;
+      if (h2 < yours_hunks->nelts && yh[h2].base_lo < chunk_lo)
+        chunk_lo = yh[h2].base_lo;
+      chunk_hi = chunk_lo;
+
+      do
+        {
+          absorbed = FALSE;
+          while (h1 + use1 < mine_hunks->nelts
+                 && mh[h1 + use1].base_lo <= chunk_hi)
+            {
+              const struct merge_hunk *hunk = &mh[h1 + use1];
+              if (hunk->base_hi > chunk_hi)
+                chunk_hi = hunk->base_hi;
+              m_delta += (hunk->side_hi - hunk->side_lo)
+                         - (hunk->base_hi - hunk->base_lo);
+              use1++;
+              absorbed = TRUE;
+            }
+          while (h2 + use2 < yours_hunks->nelts
+                 && yh[h2 + use2].base_lo <= chunk_hi)
+            {
+              const struct merge_hunk *hunk = &yh[h2 + use2];
+              if (hunk->base_hi > chunk_hi)
+                chunk_hi = hunk->base_hi;
+              y_delta += (hunk->side_hi - hunk->side_lo)
+                         - (hunk->base_hi - hunk->base_lo);
+              use2++;
+              absorbed = TRUE;
+            }
+        }
+      while (absorbed);
+
+      /* Copy the stable stretch leading up to the chunk. */
+      SVN_ERR (merge_write_lines (&out, older_lines, o, chunk_lo, subpool));
+      m += chunk_lo - o;
+      y += chunk_lo - o;
+
+      /* Both ends of the chunk are synchronization points, so each
+         side's corresponding range is the base range shifted by the
+         insertions and deletions its hunks made. */
+      m_lo = m;
+      m_hi = m + (chunk_hi - chunk_lo) + m_delta;
+      y_lo = y;
+      y_hi = y + (chunk_hi - chunk_lo) + y_delta;
+
+      if (use2 == 0
+          || ranges_equal (dm.b, m_lo, m_hi, dy.b, y_lo, y_hi))
+        {
+          /* Only mine changed, or both made the same change. */
+          SVN_ERR (merge_write_lines (&out, dm.b, m_lo, m_hi, subpool));
+        }
+      else if (use1 == 0)
+        {
+          /* Only yours changed. */
+          SVN_ERR (merge_write_lines (&out, dy.b, y_lo, y_hi, subpool));
+        }
+      else
+        {
+          /* Both changed, differently: a conflict. */
+          const char *marker;
+
+          marker = apr_psprintf (subpool, "<<<<<<< %s\n", mine_label);
+          SVN_ERR (merge_write (&out, marker, strlen (marker), subpool));
+          SVN_ERR (merge_write_lines (&out, dm.b, m_lo, m_hi, subpool));
+
+          marker = apr_psprintf (subpool, "||||||| %s\n", older_label);
+          SVN_ERR (merge_write (&out, marker, strlen (marker), subpool));
+          SVN_ERR (merge_write_lines (&out, older_lines,
+                                      chunk_lo, chunk_hi, subpool));
+
+          SVN_ERR (merge_write (&out, "=======\n", 8, subpool));
+          SVN_ERR (merge_write_lines (&out, dy.b, y_lo, y_hi, subpool));
+
+          marker = apr_psprintf (subpool, ">>>>>>> %s\n", yours_label);
+          SVN_ERR (merge_write (&out, marker, strlen (marker), subpool));
+
+          *conflicted = TRUE;
+        }
+
+      o = chunk_hi;
+      m = m_hi;
+      y = y_hi;
+      h1 += use1;
+      h2 += use2;
+    }
+
+  /* And the stable tail. */
+  SVN_ERR (merge_write_lines (&out, older_lines, o, n_older, subpool));
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
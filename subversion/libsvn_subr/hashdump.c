@@ -20,6 +20,7 @@
 
 #include <stdio.h>       /* for sprintf() */
 #include <stdlib.h>
+#include <string.h>      /* for memchr() */
 #include <apr_pools.h>
 #include <apr_hash.h>
 #include <apr_file_io.h>
@@ -106,9 +107,14 @@ svn_hash_write (apr_hash_t *hash,
                 apr_pool_t *pool)
 {
   apr_hash_index_t *this;      /* current hash entry */
-  apr_status_t err;
+  svn_stringbuf_t *out;
   char buf[SVN_KEYLINE_MAXLEN];
 
+  /* Serialize the whole table into one buffer first; a property
+     file's worth of K/V lines is not worth a dozen separate write
+     syscalls. */
+  out = svn_stringbuf_create ("", pool);
+
   for (this = apr_hash_first (pool, hash); this; this = apr_hash_next (this))
     {
       const void *key;
@@ -123,46 +129,23 @@ svn_hash_write (apr_hash_t *hash,
 
       /* Output name length, then name. */
 
-      err = apr_file_write_full (destfile, "K ", 2, NULL);
-      if (err) return err;
-
-      sprintf (buf, "%ld%n", (long int) keylen, &bytes_used);
-      err = apr_file_write_full (destfile, buf, bytes_used, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, "\n", 1, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, (char *) key, keylen, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, "\n", 1, NULL);
-      if (err) return err;
+      sprintf (buf, "K %ld\n%n", (long int) keylen, &bytes_used);
+      svn_stringbuf_appendbytes (out, buf, bytes_used);
+      svn_stringbuf_appendbytes (out, key, keylen);
+      svn_stringbuf_appendbytes (out, "\n", 1);
 
       /* Output value length, then value. */
 
       vallen = (size_t) (*unpack_func) (&valstring, val); /* secret decoder! */
-      err = apr_file_write_full (destfile, "V ", 2, NULL);
-      if (err) return err;
-
-      sprintf (buf, "%ld%n", (long int) vallen, &bytes_used);
-      err = apr_file_write_full (destfile, buf, bytes_used, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, "\n", 1, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, valstring, vallen, NULL);
-      if (err) return err;
-
-      err = apr_file_write_full (destfile, "\n", 1, NULL);
-      if (err) return err;
+      sprintf (buf, "V %ld\n%n", (long int) vallen, &bytes_used);
+      svn_stringbuf_appendbytes (out, buf, bytes_used);
+      svn_stringbuf_appendbytes (out, valstring, vallen);
+      svn_stringbuf_appendbytes (out, "\n", 1);
     }
 
-  err = apr_file_write_full (destfile, "END\n", 4, NULL);
-  if (err) return err;
+  svn_stringbuf_appendbytes (out, "END\n", 4);
 
-  return APR_SUCCESS;
+  return apr_file_write_full (destfile, out->data, out->len, NULL);
 }
 
 
@@ -205,6 +188,10 @@ svn_io_read_length_line (apr_file_t *file, char *buf, apr_size_t *limit)
 }
 
 
+/* The size of the chunks svn_hash_read gulps the file down in. */
+#define SVN_HASH_READ_BLOCKSIZE 4096
+
+
 apr_status_t
 svn_hash_read (apr_hash_t *hash, 
                void * (*pack_func) (size_t len,
@@ -214,72 +201,96 @@ svn_hash_read (apr_hash_t *hash,
                apr_pool_t *pool)
 {
   apr_status_t err;
-  char buf[SVN_KEYLINE_MAXLEN];
-  apr_size_t num_read;
-  char c;
+  svn_stringbuf_t *buffer;
+  char *p, *end, *eol;
   void *package;
-  int first_time = 1;
-  
 
-  while (1)
+  /* Slurp the rest of the file into memory and parse the buffer,
+     rather than crawling through the file a character at a time.
+     Note that this consumes the file through EOF even if the dumped
+     hash ends before that; nobody stores anything after the END
+     line.  The buffer shares POOL's lifetime, so keys and values can
+     point straight into it. */
+  buffer = svn_stringbuf_create ("", pool);
+  do
     {
-      /* Read a key length line.  Might be END, though. */
-      apr_size_t len = sizeof(buf);
+      apr_size_t len = SVN_HASH_READ_BLOCKSIZE;
 
-      err = svn_io_read_length_line (srcfile, buf, &len);
-      if ((err == APR_EOF) && first_time)
-        /* We got an EOF on our very first attempt to read, which
-           means it's a zero-byte file.  No problem, just go home. */        
-        return APR_SUCCESS;
-      else if (err)
-        /* Any other circumstance is a genuine error. */
+      svn_stringbuf_ensure (buffer, buffer->len + len);
+      err = apr_file_read (srcfile, buffer->data + buffer->len, &len);
+      if (err && ! APR_STATUS_IS_EOF(err))
         return err;
+      buffer->len += len;
+    }
+  while (! err);
 
-      first_time = 0;
+  p = buffer->data;
+  end = buffer->data + buffer->len;
 
-      if ((len == 3)
-          && (buf[0] == 'E')       /* We've reached the end of the  */
-          && (buf[1] == 'N')       /* dumped hash table, so leave.  */
-          && (buf[2] == 'D'))
+  /* A zero-byte file is an empty hash.  No problem, just go home. */
+  if (p == end)
+    return APR_SUCCESS;
+
+  while (1)
+    {
+      /* Read a key length line.  Might be END, though. */
+      eol = memchr (p, '\n', end - p);
+      if (! eol)
+        /* The file ran out where a length line should have been. */
+        return APR_EOF;
+      if (eol - p >= SVN_KEYLINE_MAXLEN)
+        /* todo: make a custom error "SVN_LENGTH_TOO_LONG" or something? */
+        return SVN_WARNING;
+
+      if (((eol - p) == 3)
+          && (p[0] == 'E')         /* We've reached the end of the  */
+          && (p[1] == 'N')         /* dumped hash table, so leave.  */
+          && (p[2] == 'D'))
         {
           return APR_SUCCESS;
         }
-      else if ((buf[0] == 'K') && (buf[1] == ' '))
+      else if ((p[0] == 'K') && (p[1] == ' '))
         {
           /* Get the length of the key */
-          size_t keylen = (size_t) atoi (buf + 2);
-
-          /* Now read that much into a buffer, + 1 byte for null terminator */
-          void *keybuf = apr_palloc (pool, keylen + 1);
-          err = apr_file_read_full (srcfile, keybuf, keylen, &num_read);
-          if (err) return err;
-          ((char *) keybuf)[keylen] = '\0';
-
-          /* Suck up extra newline after key data */
-          err = apr_file_getc (&c, srcfile);
-          if (err) return err;
-          if (c != '\n') return SVN_ERR_MALFORMED_FILE;
+          size_t keylen = (size_t) atoi (p + 2);
+          char *keybuf;
+
+          /* The key, its newline, and at least "V \n" must fit. */
+          p = eol + 1;
+          if ((apr_size_t) (end - p) < keylen + 1)
+            return APR_EOF;
+          if (p[keylen] != '\n')
+            return SVN_ERR_MALFORMED_FILE;
+
+          /* Null-terminate the key in place, overwriting its
+             newline; the buffer lives as long as the hash does. */
+          keybuf = p;
+          keybuf[keylen] = '\0';
+          p += keylen + 1;
 
           /* Read a val length line */
-          len = sizeof(buf);
-          err = svn_io_read_length_line (srcfile, buf, &len);
-          if (err) return err;
+          eol = memchr (p, '\n', end - p);
+          if (! eol)
+            return APR_EOF;
+          if (eol - p >= SVN_KEYLINE_MAXLEN)
+            return SVN_WARNING;
 
-          if ((buf[0] == 'V') && (buf[1] == ' '))
+          if ((p[0] == 'V') && (p[1] == ' '))
             {
               /* Get the length of the value */
-              int vallen = atoi (buf + 2);
-
-              /* Again, 1 extra byte for the null termination. */
-              void *valbuf = apr_palloc (pool, vallen + 1);
-              err = apr_file_read_full (srcfile, valbuf, vallen, &num_read);
-              if (err) return err;
-              ((char *) valbuf)[vallen] = '\0';
-
-              /* Suck up extra newline after val data */
-              err = apr_file_getc (&c, srcfile);
-              if (err) return err;
-              if (c != '\n') return SVN_ERR_MALFORMED_FILE;
+              int vallen = atoi (p + 2);
+              char *valbuf;
+
+              p = eol + 1;
+              if ((end - p) < vallen + 1)
+                return APR_EOF;
+              if (p[vallen] != '\n')
+                return SVN_ERR_MALFORMED_FILE;
+
+              /* Null-terminate the value in place, like the key. */
+              valbuf = p;
+              valbuf[vallen] = '\0';
+              p += vallen + 1;
 
               /* Send the val data for packaging... */
               package = (void *) (*pack_func) (vallen, valbuf, pool);
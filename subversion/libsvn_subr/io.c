@@ -20,14 +20,19 @@
 
 #include <stdio.h>
 #include <string.h>
+#ifndef SVN_WIN32
+#include <unistd.h>   /* for link() */
+#endif
 #include <assert.h>
 #include <errno.h>
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_file_info.h>
+#include <apr_mmap.h>
 #include <apr_strings.h>
 #include <apr_thread_proc.h>
 #include <apr_portable.h>
+#include <apr_md5.h>
 #include "svn_types.h"
 #include "svn_path.h"
 #include "svn_string.h"
@@ -82,6 +87,86 @@ svn_io_check_path (const char *path,
 }
 
 
+svn_error_t *
+svn_io_check_paths (enum svn_node_kind *kinds,
+                    const char *parent_path,
+                    const char *const *names,
+                    int num_names,
+                    apr_pool_t *pool)
+{
+  apr_status_t status;
+  apr_dir_t *this_dir;
+  apr_finfo_t this_entry;
+  apr_int32_t flags = APR_FINFO_TYPE | APR_FINFO_NAME;
+  int i, remaining;
+
+  /* Until a directory entry says otherwise, a name doesn't exist. */
+  remaining = 0;
+  for (i = 0; i < num_names; i++)
+    {
+      kinds[i] = svn_node_none;
+      if (names[i])
+        remaining++;
+    }
+
+  if (remaining == 0)
+    return SVN_NO_ERROR;
+
+  if (parent_path[0] == '\0')
+    parent_path = ".";
+
+  status = apr_dir_open (&this_dir, parent_path, pool);
+  if (status)
+    return
+      svn_error_createf (status, 0, NULL, pool,
+                         "svn_io_check_paths:  failed to open dir '%s'",
+                         parent_path);
+
+  for (status = apr_dir_read (&this_entry, flags, this_dir);
+       APR_STATUS_IS_SUCCESS (status);
+       status = apr_dir_read (&this_entry, flags, this_dir))
+    {
+      for (i = 0; i < num_names; i++)
+        {
+          if (names[i] && (strcmp (this_entry.name, names[i]) == 0))
+            {
+              if (this_entry.filetype == APR_REG)
+                kinds[i] = svn_node_file;
+              else if (this_entry.filetype == APR_DIR)
+                kinds[i] = svn_node_dir;
+              else
+                /* ### symlinks, etc. land here, just as they do in
+                   svn_io_get_dirents. */
+                kinds[i] = svn_node_unknown;
+
+              remaining--;
+            }
+        }
+
+      /* Every name is accounted for; don't read the rest of the
+         directory just to throw it away. */
+      if (remaining == 0)
+        break;
+    }
+
+  if (! (APR_STATUS_IS_SUCCESS (status))
+      && ! (APR_STATUS_IS_ENOENT (status)))
+    return
+      svn_error_createf (status, 0, NULL, pool,
+                         "svn_io_check_paths:  error while reading dir '%s'",
+                         parent_path);
+
+  status = apr_dir_close (this_dir);
+  if (status)
+    return
+      svn_error_createf (status, 0, NULL, pool,
+                         "svn_io_check_paths:  failed to close dir '%s'",
+                         parent_path);
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_io_open_unique_file (apr_file_t **f,
                          svn_stringbuf_t **unique_name,
@@ -93,6 +178,7 @@ svn_io_open_unique_file (apr_file_t **f,
   char number_buf[6];
   int i;
   apr_size_t iterating_portion_idx;
+  unsigned int iterating_portion_start;
 
   /* The random portion doesn't have to be very random; it's just to
      avoid a series of collisions where someone has filename NAME and
@@ -127,6 +213,15 @@ svn_io_open_unique_file (apr_file_t **f,
                             apr_psprintf (pool, ".%s.00000%s",
                                           random_portion, suffix));
 
+  /* Start the iterating portion at a pseudo-random spot instead of
+     00001, so that the first exclusive create almost always succeeds
+     no matter how many stale temp files are already squatting in the
+     directory.  Probing 00001, 00002, ... meant N leftover files cost
+     N failed opens on every call; now the counter only has to walk
+     on a genuine collision. */
+  iterating_portion_start =
+    (unsigned int) apr_time_now () % 99999;
+
   for (i = 1; i <= 99999; i++)
     {
       apr_status_t apr_err;
@@ -136,7 +231,8 @@ svn_io_open_unique_file (apr_file_t **f,
         flag |= APR_DELONCLOSE;
 
       /* Tweak last attempted name to get the next one. */
-      sprintf (number_buf, "%05d", i);
+      sprintf (number_buf, "%05u",
+               (unsigned int) (iterating_portion_start + i) % 100000);
       (*unique_name)->data[iterating_portion_idx + 0] = number_buf[0];
       (*unique_name)->data[iterating_portion_idx + 1] = number_buf[1];
       (*unique_name)->data[iterating_portion_idx + 2] = number_buf[2];
@@ -194,6 +290,69 @@ svn_io_copy_file (const char *src,
   apr_int32_t options = APR_OS_DEFAULT;
 #endif
 
+#if APR_HAS_MMAP && !defined(SVN_WIN32)
+  /* Fast path: map the source and hand the kernel its own page cache
+     back in a single write, rather than shoveling the bytes through
+     a userspace buffer one block at a time the way apr_file_copy
+     does.  Anything that goes wrong here --- an unmappable
+     filesystem, an empty file --- just drops through to the portable
+     copy below. */
+  {
+    apr_file_t *s, *d;
+    apr_finfo_t finfo;
+    apr_mmap_t *map;
+    apr_fileperms_t perms;
+
+    if (apr_file_open (&s, src, APR_READ, APR_OS_DEFAULT, pool))
+      goto portable_copy;
+
+    if (apr_file_info_get (&finfo, APR_FINFO_SIZE | APR_FINFO_PROT, s)
+        || (finfo.size == 0))
+      {
+        apr_file_close (s);
+        goto portable_copy;
+      }
+
+    perms = copy_perms ? finfo.protection : APR_OS_DEFAULT;
+    if (apr_file_open (&d, dst, APR_WRITE | APR_CREATE | APR_TRUNCATE,
+                       perms, pool))
+      {
+        apr_file_close (s);
+        goto portable_copy;
+      }
+
+    /* Tell the filesystem the final size before writing a byte; it
+       can lay the destination out contiguously instead of extending
+       it a block at a time.  If it can't, no harm done. */
+    apr_file_trunc (d, finfo.size);
+
+    if (apr_mmap_create (&map, s, 0, (apr_size_t) finfo.size,
+                         APR_MMAP_READ, pool))
+      {
+        apr_file_close (d);
+        apr_file_close (s);
+        goto portable_copy;
+      }
+
+    apr_err = apr_file_write_full (d, map->mm, (apr_size_t) finfo.size, NULL);
+    apr_mmap_delete (map);
+    apr_file_close (s);
+
+    if (apr_err)
+      apr_file_close (d);
+    else
+      apr_err = apr_file_close (d);
+
+    if (! apr_err)
+      return SVN_NO_ERROR;
+
+    /* The write itself failed; a retry through the portable copy
+       will hit the same wall and report it from one place. */
+  }
+
+ portable_copy:
+#endif /* APR_HAS_MMAP && ! SVN_WIN32 */
+
   apr_err = apr_file_copy (src, dst, options, pool);
   if (apr_err)
     return svn_error_createf
@@ -203,6 +362,27 @@ svn_io_copy_file (const char *src,
 }
 
 
+svn_error_t *
+svn_io_link_or_copy_file (const char *src,
+                          const char *dst,
+                          apr_pool_t *pool)
+{
+#ifndef SVN_WIN32
+  /* A hard link shares the bytes for free.  That's only safe for
+     files nobody ever modifies in place, so callers must know what
+     they're sharing; replacing either name by rename() quietly
+     dissolves the link and leaves the other name untouched. */
+  if (link (src, dst) == 0)
+    return SVN_NO_ERROR;
+
+  /* Cross-device, no permission, a filesystem without hard links...
+     whatever the reason, fall back to an honest copy. */
+#endif /* ! SVN_WIN32 */
+
+  return svn_io_copy_file (src, dst, TRUE, pool);
+}
+
+
 svn_error_t *
 svn_io_append_file (svn_stringbuf_t *src, svn_stringbuf_t *dst, apr_pool_t *pool)
 {
@@ -349,6 +529,26 @@ svn_io_file_affected_time (apr_time_t *apr_time,
 }
 
 
+svn_error_t *
+svn_io_file_size (apr_off_t *size,
+                  const char *path,
+                  apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
+
+  apr_err = apr_stat (&finfo, path, APR_FINFO_MIN, pool);
+  if (apr_err)
+    return svn_error_createf
+      (apr_err, 0, NULL, pool,
+       "svn_io_file_size: cannot stat %s", path);
+
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_io_filesizes_different_p (svn_boolean_t *different_p,
                               const char *file1,
@@ -390,6 +590,62 @@ svn_io_filesizes_different_p (svn_boolean_t *different_p,
 }
 
 
+svn_error_t *
+svn_io_file_checksum (svn_stringbuf_t **checksum_p,
+                      const char *file,
+                      apr_pool_t *pool)
+{
+  apr_md5_ctx_t context;
+  apr_file_t *f = NULL;
+  apr_status_t apr_err;
+  char buf[BUFSIZ];
+  apr_size_t len;
+  unsigned char digest[MD5_DIGESTSIZE];
+  char hex_digest[(MD5_DIGESTSIZE * 2) + 1] = { 0 };
+  const char *hex = "0123456789abcdef";
+  int i;
+
+  apr_md5_init (&context);
+
+  apr_err = apr_file_open (&f, file, APR_READ, APR_OS_DEFAULT, pool);
+  if (apr_err)
+    return svn_error_createf
+      (apr_err, 0, NULL, pool,
+       "svn_io_file_checksum: error opening %s", file);
+
+  do
+    {
+      len = sizeof (buf);
+      apr_err = apr_file_read (f, buf, &len);
+      if (apr_err && !APR_STATUS_IS_EOF(apr_err))
+        return svn_error_createf
+          (apr_err, 0, NULL, pool,
+           "svn_io_file_checksum: error reading %s", file);
+      apr_md5_update (&context, buf, len);
+    }
+  while (! APR_STATUS_IS_EOF(apr_err));
+
+  apr_err = apr_file_close (f);
+  if (apr_err)
+    return svn_error_createf
+      (apr_err, 0, NULL, pool,
+       "svn_io_file_checksum: error closing %s", file);
+
+  apr_md5_final (digest, &context);
+
+  /* Convert the binary digest to readable hexadecimal. */
+  for (i = 0; i < MD5_DIGESTSIZE; i++)
+    {
+      hex_digest[i * 2] = hex[digest[i] >> 4];
+      hex_digest[(i * 2) + 1] = hex[digest[i] & 0x0f];
+    }
+
+  *checksum_p = svn_stringbuf_create (hex_digest, pool);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /*** Permissions and modes. ***/
 
@@ -646,6 +902,114 @@ svn_stream_t *svn_stream_from_stdio (FILE *fp, apr_pool_t *pool)
   return stream;
 }
 
+
+/*** Buffered stream adapter ***/
+struct baton_buffered {
+  svn_stream_t *source;
+  char *buf;                    /* data staged from SOURCE */
+  apr_size_t bufsize;           /* allocated size of BUF */
+  apr_size_t begin, end;        /* unread data is BUF[begin..end) */
+  svn_boolean_t source_done;    /* SOURCE reported end of input */
+};
+
+
+static svn_error_t *
+read_handler_buffered (void *baton, char *buffer, apr_size_t *len)
+{
+  struct baton_buffered *btn = baton;
+  apr_size_t want = *len;
+  apr_size_t total = 0;
+
+  while (want > 0)
+    {
+      apr_size_t available = btn->end - btn->begin;
+
+      if (available > 0)
+        {
+          apr_size_t chunk = (available < want) ? available : want;
+
+          memcpy (buffer + total, btn->buf + btn->begin, chunk);
+          btn->begin += chunk;
+          total += chunk;
+          want -= chunk;
+        }
+      else if (btn->source_done)
+        break;
+      else if (want >= btn->bufsize)
+        {
+          /* A read this big gains nothing from staging; pass it
+             through. */
+          apr_size_t direct = want;
+
+          SVN_ERR (svn_stream_read (btn->source, buffer + total, &direct));
+          total += direct;
+          if (direct < want)
+            btn->source_done = TRUE;
+          want -= direct;
+        }
+      else
+        {
+          /* Refill.  Ask SOURCE for a whole buffer no matter how
+             little the caller wants right now; the reads that follow
+             become memcpys. */
+          apr_size_t refill = btn->bufsize;
+
+          SVN_ERR (svn_stream_read (btn->source, btn->buf, &refill));
+          btn->begin = 0;
+          btn->end = refill;
+          if (refill < btn->bufsize)
+            btn->source_done = TRUE;
+        }
+    }
+
+  *len = total;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+write_handler_buffered (void *baton, const char *data, apr_size_t *len)
+{
+  struct baton_buffered *btn = baton;
+
+  return svn_stream_write (btn->source, data, len);
+}
+
+
+static svn_error_t *
+close_handler_buffered (void *baton)
+{
+  struct baton_buffered *btn = baton;
+
+  return svn_stream_close (btn->source);
+}
+
+
+svn_stream_t *
+svn_stream_buffered (svn_stream_t *source,
+                     apr_size_t bufsize,
+                     apr_pool_t *pool)
+{
+  struct baton_buffered *baton;
+  svn_stream_t *stream;
+
+  if (bufsize == 0)
+    bufsize = SVN_STREAM_CHUNK_SIZE;
+
+  baton = apr_palloc (pool, sizeof (*baton));
+  baton->source = source;
+  baton->buf = apr_palloc (pool, bufsize);
+  baton->bufsize = bufsize;
+  baton->begin = 0;
+  baton->end = 0;
+  baton->source_done = FALSE;
+  stream = svn_stream_create (baton, pool);
+  svn_stream_set_read (stream, read_handler_buffered);
+  svn_stream_set_write (stream, write_handler_buffered);
+  svn_stream_set_close (stream, close_handler_buffered);
+  return stream;
+}
+
 
 /* TODO write test for these two functions, then refactor. */
 
@@ -885,19 +1249,17 @@ svn_io_get_dirents (apr_hash_t **dirents,
 
 
 svn_error_t *
-svn_io_run_cmd (const char *path,
-                const char *cmd,
-                const char *const *args,
-                int *exitcode,
-                apr_exit_why_e *exitwhy,
-                svn_boolean_t inherit,
-                apr_file_t *infile,
-                apr_file_t *outfile,
-                apr_file_t *errfile,
-                apr_pool_t *pool)
+svn_io_start_cmd (apr_proc_t *cmd_proc,
+                  const char *path,
+                  const char *cmd,
+                  const char *const *args,
+                  svn_boolean_t inherit,
+                  apr_file_t *infile,
+                  apr_file_t *outfile,
+                  apr_file_t *errfile,
+                  apr_pool_t *pool)
 {
   apr_status_t apr_err;
-  apr_proc_t cmd_proc;
   apr_procattr_t *cmdproc_attr;
 
   /* Create the process attributes. */
@@ -905,7 +1267,7 @@ svn_io_run_cmd (const char *path,
   if (! APR_STATUS_IS_SUCCESS (apr_err))
     return svn_error_createf
       (apr_err, 0, NULL, pool,
-       "svn_io_run_cmd: error creating %s process attributes",
+       "svn_io_start_cmd: error creating %s process attributes",
        cmd);
 
   /* Make sure we invoke cmd directly, not through a shell. */
@@ -915,7 +1277,7 @@ svn_io_run_cmd (const char *path,
   if (! APR_STATUS_IS_SUCCESS (apr_err))
     return svn_error_createf 
       (apr_err, 0, NULL, pool,
-       "svn_io_run_cmd: error setting %s process cmdtype",
+       "svn_io_start_cmd: error setting %s process cmdtype",
        cmd);
 
   /* Set the process's working directory. */
@@ -925,7 +1287,7 @@ svn_io_run_cmd (const char *path,
       if (! APR_STATUS_IS_SUCCESS (apr_err))
         return svn_error_createf 
           (apr_err, 0, NULL, pool,
-           "svn_io_run_cmd: error setting %s process directory",
+           "svn_io_start_cmd: error setting %s process directory",
            cmd);
     }
 
@@ -940,7 +1302,7 @@ svn_io_run_cmd (const char *path,
       if (! APR_STATUS_IS_SUCCESS (apr_err))
         return svn_error_createf 
           (apr_err, 0, NULL, pool,
-           "svn_io_run_cmd: error setting %s process child input",
+           "svn_io_start_cmd: error setting %s process child input",
            cmd);
     }
   if (outfile)
@@ -949,7 +1311,7 @@ svn_io_run_cmd (const char *path,
       if (! APR_STATUS_IS_SUCCESS (apr_err))
         return svn_error_createf 
           (apr_err, 0, NULL, pool,
-           "svn_io_run_cmd: error setting %s process child outfile",
+           "svn_io_start_cmd: error setting %s process child outfile",
            cmd);
     }
   if (errfile)
@@ -958,18 +1320,44 @@ svn_io_run_cmd (const char *path,
       if (! APR_STATUS_IS_SUCCESS (apr_err))
         return svn_error_createf 
           (apr_err, 0, NULL, pool,
-           "svn_io_run_cmd: error setting %s process child errfile",
+           "svn_io_start_cmd: error setting %s process child errfile",
            cmd);
     }
 
   /* Start the cmd command. */ 
-  apr_err = apr_proc_create (&cmd_proc, cmd, args, NULL, cmdproc_attr, pool);
+  apr_err = apr_proc_create (cmd_proc, cmd, args, NULL, cmdproc_attr, pool);
   if (! APR_STATUS_IS_SUCCESS (apr_err))
     return svn_error_createf 
       (apr_err, 0, NULL, pool,
-       "svn_io_run_cmd: error starting %s process",
+       "svn_io_start_cmd: error starting %s process",
        cmd);
 
+  /* The caller may never wait for the process, so make sure pool
+     cleanup doesn't try to kill it either. */
+  apr_pool_note_subprocess (pool, cmd_proc, APR_KILL_NEVER);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_io_run_cmd (const char *path,
+                const char *cmd,
+                const char *const *args,
+                int *exitcode,
+                apr_exit_why_e *exitwhy,
+                svn_boolean_t inherit,
+                apr_file_t *infile,
+                apr_file_t *outfile,
+                apr_file_t *errfile,
+                apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+  apr_proc_t cmd_proc;
+
+  SVN_ERR (svn_io_start_cmd (&cmd_proc, path, cmd, args, inherit,
+                             infile, outfile, errfile, pool));
+
   /* Wait for the cmd command to finish. */
   apr_err = apr_proc_wait (&cmd_proc, exitcode, exitwhy, APR_WAIT);
   if (APR_STATUS_IS_CHILD_NOTDONE (apr_err))
@@ -20,6 +20,7 @@
 
 #include <string.h>
 #include <assert.h>
+#include <apr_hash.h>
 #include "svn_string.h"
 #include "svn_path.h"
 #include "svn_private_config.h"         /* for SVN_PATH_LOCAL_SEPARATOR */
@@ -262,6 +263,140 @@ char *svn_path_join_many (apr_pool_t *pool, const char *base, ...)
 }
 
 
+
+/*** Interned paths. ***/
+
+struct svn_path_index_t
+{
+  apr_pool_t *pool;     /* holds the index and every path it interns */
+  apr_hash_t *paths;    /* full path -> svn_indexed_path_t * */
+};
+
+
+/* Make a new entry for PATH (of length LEN, already allocated in
+   INDEX->pool) with the given PARENT, and enter it in the full-path
+   table. */
+static svn_indexed_path_t *
+new_entry (svn_path_index_t *index,
+           const char *path,
+           apr_size_t len,
+           svn_indexed_path_t *parent)
+{
+  svn_indexed_path_t *entry = apr_palloc (index->pool, sizeof (*entry));
+
+  entry->path = path;
+  entry->len = len;
+  entry->parent = parent;
+  entry->children = NULL;
+  apr_hash_set (index->paths, path, len, entry);
+
+  return entry;
+}
+
+
+/* Return the entry for the first LEN bytes of PATH, interning it
+   first if need be.  Ancestors are interned along the way, so the
+   parent chain is complete no matter how a path first arrives. */
+static svn_indexed_path_t *
+index_path (svn_path_index_t *index,
+            const char *path,
+            apr_size_t len)
+{
+  svn_indexed_path_t *entry = apr_hash_get (index->paths, path, len);
+  svn_indexed_path_t *parent = NULL;
+  apr_size_t i;
+
+  if (entry)
+    return entry;
+
+  if (len > 0)
+    {
+      /* Hunt for the last separator; the prefix before it (or the
+         empty path, if there is none) is this entry's parent. */
+      for (i = len; i > 0; i--)
+        if (path[i - 1] == SVN_PATH_SEPARATOR)
+          break;
+
+      parent = index_path (index, path, i ? i - 1 : 0);
+    }
+
+  return new_entry (index, apr_pstrmemdup (index->pool, path, len),
+                    len, parent);
+}
+
+
+svn_path_index_t *
+svn_path_index_create (apr_pool_t *pool)
+{
+  svn_path_index_t *index = apr_palloc (pool, sizeof (*index));
+
+  index->pool = pool;
+  index->paths = apr_hash_make (pool);
+
+  return index;
+}
+
+
+svn_indexed_path_t *
+svn_path_index_get (svn_path_index_t *index,
+                    const char *path)
+{
+  return index_path (index, path, strlen (path));
+}
+
+
+svn_indexed_path_t *
+svn_path_index_join (svn_path_index_t *index,
+                     svn_indexed_path_t *base,
+                     const char *component)
+{
+  svn_indexed_path_t *entry;
+  apr_size_t blen, clen;
+  char *path;
+
+  /* The same special cases as svn_path_join. */
+  if (base->len == 0 || *component == SVN_PATH_SEPARATOR)
+    return svn_path_index_get (index, component);
+  if (*component == '\0')
+    return base;
+
+  clen = strlen (component);
+
+  /* The common case: a join this index has already seen.  One probe
+     of BASE's component table, and no path is assembled at all. */
+  if (base->children)
+    {
+      entry = apr_hash_get (base->children, component, clen);
+      if (entry)
+        return entry;
+    }
+  else
+    base->children = apr_hash_make (index->pool);
+
+  /* First time down this edge.  Build the full path the way
+     svn_path_join does, and check whether some other route has
+     already interned the same spelling. */
+  blen = base->len;
+  if (base->path[blen - 1] == SVN_PATH_SEPARATOR)
+    --blen;
+
+  path = apr_palloc (index->pool, blen + 1 + clen + 1);
+  memcpy (path, base->path, blen);
+  path[blen] = SVN_PATH_SEPARATOR;
+  memcpy (path + blen + 1, component, clen + 1);
+
+  entry = apr_hash_get (index->paths, path, blen + 1 + clen);
+  if (! entry)
+    entry = new_entry (index, path, blen + 1 + clen, base);
+
+  /* Remember the edge, keyed on the component's spelling inside the
+     interned path, which lives as long as the table does. */
+  apr_hash_set (base->children, entry->path + entry->len - clen, clen, entry);
+
+  return entry;
+}
+
+
 
 static void
 add_component_internal (svn_stringbuf_t *path,
@@ -545,36 +680,28 @@ apr_array_header_t *
 svn_path_decompose (const svn_stringbuf_t *path,
                     apr_pool_t *pool)
 {
-  apr_size_t i, oldi;
+  const char *rest = path->data;
+  svn_string_t component;
 
-  apr_array_header_t *components = 
+  apr_array_header_t *components =
     apr_array_make (pool, 1, sizeof(svn_stringbuf_t *));
 
-  i = oldi = 0;
-
   if (svn_path_is_empty (path))
     return components;
 
   /* If PATH is absolute, store the '/' as the first component. */
-  if (path->data[i] == SVN_PATH_SEPARATOR)
+  if (rest[0] == SVN_PATH_SEPARATOR)
     {
       char dirsep = SVN_PATH_SEPARATOR;
       store_component (components, &dirsep, sizeof (dirsep), pool);
-      i++;
-      oldi++;
+      rest++;
     }
 
-  while (i <= path->len)
-    {
-      if ((path->data[i] == SVN_PATH_SEPARATOR) || (path->data[i] == '\0'))
-        {
-          store_component (components, path->data + oldi, i - oldi, pool);
-          i++;
-          oldi = i;  /* skipping past the dirsep */
-          continue;
-        }
-      i++;
-    }
+  /* The tokenizer just points into PATH; only store_component's
+     stringbuf copies survive this function. */
+  while (svn_cstring_next_token (&component, &rest, SVN_PATH_SEPARATOR,
+                                 FALSE))
+    store_component (components, component.data, component.len, pool);
 
   return components;
 }
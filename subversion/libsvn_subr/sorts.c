@@ -96,20 +96,19 @@ svn_sort_compare_revisions (const void *a, const void *b)
 }
 
 
-#ifndef apr_hash_sort_keys
-
 /* see svn_sorts.h for documentation */
-apr_array_header_t *
-apr_hash_sorted_keys (apr_hash_t *ht,
-                      int (*comparison_func) (const svn_item_t *,
-                                              const svn_item_t *),
-                      apr_pool_t *pool)
+void
+svn_sort_hash_keys (apr_array_header_t *ary,
+                    apr_hash_t *ht,
+                    int (*comparison_func) (const svn_item_t *,
+                                            const svn_item_t *),
+                    apr_pool_t *pool)
 {
   apr_hash_index_t *hi;
-  apr_array_header_t *ary;
 
-  /* allocate an array with only one element to begin with. */
-  ary = apr_array_make (pool, 1, sizeof(svn_item_t));
+  /* Reuse whatever element storage ARY has already grown; the items
+     only hold pointers into HT, so there is nothing to free. */
+  ary->nelts = 0;
 
   /* loop over hash table and push all keys into the array */
   for (hi = apr_hash_first (pool, ht); hi; hi = apr_hash_next (hi))
@@ -122,6 +121,24 @@ apr_hash_sorted_keys (apr_hash_t *ht,
   /* now quicksort the array.  */
   qsort (ary->elts, ary->nelts, ary->elt_size,
          (int (*)(const void *, const void *))comparison_func);
+}
+
+
+#ifndef apr_hash_sort_keys
+
+/* see svn_sorts.h for documentation */
+apr_array_header_t *
+apr_hash_sorted_keys (apr_hash_t *ht,
+                      int (*comparison_func) (const svn_item_t *,
+                                              const svn_item_t *),
+                      apr_pool_t *pool)
+{
+  /* Size the array for the whole hash up front; growing it by
+     doubling would strand the outgrown element buffers in POOL. */
+  apr_array_header_t *ary
+    = apr_array_make (pool, apr_hash_count (ht), sizeof(svn_item_t));
+
+  svn_sort_hash_keys (ary, ht, comparison_func, pool);
 
   return ary;
 }
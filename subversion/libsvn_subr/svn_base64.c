@@ -73,12 +73,23 @@ encode_bytes (svn_stringbuf_t *str, const char *data, apr_size_t len,
 {
   char group[4];
   const char *p = data, *end = data + len;
-
-  /* Keep encoding three-byte groups until we run out.  */
-  while (*inbuflen + (end - p) >= 3)
+  apr_size_t ngroups;
+
+  /* Resize the buffer once for everything this call will append:
+     four output bytes per complete group, plus a newline for every
+     BASE64_LINELEN output bytes.  All the whole-group work below can
+     then write straight into the buffer. */
+  ngroups = (*inbuflen + len) / 3;
+  svn_stringbuf_ensure (str, str->len + (ngroups * 4)
+                        + (ngroups * 4 / BASE64_LINELEN) + 2);
+
+  /* Finish off the group left over from the last call, if any.  */
+  if (*inbuflen > 0)
     {
-      memcpy (inbuf + *inbuflen, p, 3 - *inbuflen);
-      p += (3 - *inbuflen);
+      while (*inbuflen < 3 && p < end)
+        inbuf[(*inbuflen)++] = *p++;
+      if (*inbuflen < 3)
+        return;
       encode_group (inbuf, group);
       svn_stringbuf_appendbytes (str, group, 4);
       *inbuflen = 0;
@@ -90,6 +101,30 @@ encode_bytes (svn_stringbuf_t *str, const char *data, apr_size_t len,
         }
     }
 
+  /* Encode the rest a line at a time, straight out of DATA and
+     straight into the buffer. */
+  while (end - p >= 3)
+    {
+      char *out = str->data + str->len;
+      apr_size_t group_count = (BASE64_LINELEN - *linelen) / 4;
+      apr_size_t i;
+
+      if (group_count > (apr_size_t) (end - p) / 3)
+        group_count = (end - p) / 3;
+
+      for (i = 0; i < group_count; i++, p += 3, out += 4)
+        encode_group ((const unsigned char *) p, out);
+      str->len = out - str->data;
+      *linelen += group_count * 4;
+
+      if (*linelen == BASE64_LINELEN)
+        {
+          str->data[str->len++] = '\n';
+          *linelen = 0;
+        }
+    }
+  str->data[str->len] = '\0';
+
   /* Tack any extra input onto *INBUF.  */
   memcpy (inbuf + *inbuflen, p, end - p);
   *inbuflen += (end - p);
@@ -205,6 +240,31 @@ struct decode_baton {
 };
 
 
+/* The value of each base64 digit, indexed by unsigned char, with -1
+   marking the bytes that aren't base64 digits at all.  One load per
+   input byte replaces the strchr through base64tab the decoder used
+   to do.  ('=' is not in the table; it ends the data and is handled
+   on its own.)  */
+static const signed char base64val[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+  -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
 /* Base64-decode a group.  IN needs to have four bytes and OUT needs
    to have room for three bytes.  The input bytes must already have
    been decoded from base64tab into the range 0..63.  The four
@@ -228,11 +288,41 @@ static void
 decode_bytes (svn_stringbuf_t *str, const char *data, apr_size_t len,
               unsigned char *inbuf, int *inbuflen, svn_boolean_t *done)
 {
-  const char *p, *find;
+  const char *p = data, *end = data + len;
   char group[3];
 
-  for (p = data; !*done && p < data + len; p++)
+  /* Resize the buffer once for the worst case, three output bytes
+     per four of input; the whole-group work below can then write
+     straight into it. */
+  svn_stringbuf_ensure (str, str->len + ((len / 4 + 1) * 3) + 1);
+
+  while (!*done && p < end)
     {
+      /* The fast path: with no leftover bytes in hand, whole clean
+	 groups go from DATA into the buffer without passing through
+	 INBUF.  A newline or an '=' drops us back to the loop below.  */
+      if (*inbuflen == 0)
+	{
+	  while (end - p >= 4
+		 && base64val[(unsigned char) p[0]] >= 0
+		 && base64val[(unsigned char) p[1]] >= 0
+		 && base64val[(unsigned char) p[2]] >= 0
+		 && base64val[(unsigned char) p[3]] >= 0)
+	    {
+	      unsigned char quad[4];
+
+	      quad[0] = base64val[(unsigned char) p[0]];
+	      quad[1] = base64val[(unsigned char) p[1]];
+	      quad[2] = base64val[(unsigned char) p[2]];
+	      quad[3] = base64val[(unsigned char) p[3]];
+	      decode_group (quad, str->data + str->len);
+	      str->len += 3;
+	      p += 4;
+	    }
+	  if (p == end)
+	    break;
+	}
+
       if (*p == '=')
 	{
 	  /* We are at the end and have to decode a partial group.  */
@@ -246,9 +336,10 @@ decode_bytes (svn_stringbuf_t *str, const char *data, apr_size_t len,
 	}
       else
 	{
-	  find = strchr (base64tab, *p);
-	  if (find != NULL)
-	    inbuf[(*inbuflen)++] = find - base64tab;
+	  signed char val = base64val[(unsigned char) *p];
+
+	  if (val >= 0)
+	    inbuf[(*inbuflen)++] = val;
 	  if (*inbuflen == 4)
 	    {
 	      decode_group (inbuf, group);
@@ -256,7 +347,9 @@ decode_bytes (svn_stringbuf_t *str, const char *data, apr_size_t len,
 	      *inbuflen = 0;
 	    }
 	}
+      p++;
     }
+  str->data[str->len] = '\0';
 }
 
 
@@ -19,6 +19,7 @@
 
 #include <stdarg.h>
 #include <assert.h>
+#include <string.h>
 
 #include "apr_lib.h"
 #include "apr_general.h"
@@ -216,6 +217,167 @@ svn_pool__inherit_error_pool (apr_pool_t *p)
 }
 
 
+
+/*** Pool usage statistics. ***/
+
+#ifdef SVN_POOL_STATS
+
+#if !APR_POOL_DEBUG
+#error "SVN_POOL_STATS requires an APR built with pool debugging."
+#endif /* !APR_POOL_DEBUG */
+
+/* Aggregate figures for all the pools sharing one tag. */
+struct pool_stats
+{
+  const char *tag;          /* the name passed to svn_pool_tag */
+  int created;              /* pools ever tagged with this name */
+  int live;                 /* of those, the ones not yet destroyed */
+  int cleared;              /* total clears of those pools */
+  apr_size_t high_water;    /* largest size sampled, in bytes */
+  struct pool_stats *next;
+};
+
+/* One tagged pool, tying it to its aggregate record.  Dead links are
+   recycled when new pools are tagged. */
+struct pool_stats_link
+{
+  apr_pool_t *pool;
+  struct pool_stats *stats;
+  svn_boolean_t live;
+  struct pool_stats_link *next;
+};
+
+/* The registry.  It lives in a private pool of its own, so the records
+   survive the pools they describe.  Like the rest of the pool wrapper
+   machinery, it is not protected by any lock. */
+static apr_pool_t *stats_pool = NULL;
+static struct pool_stats *stats_list = NULL;
+static struct pool_stats_link *stats_links = NULL;
+
+
+/* Fold POOL's current size (subpools included) into STATS. */
+static void
+pool_stats_sample (struct pool_stats *stats, apr_pool_t *pool)
+{
+  apr_size_t num_bytes = apr_pool_num_bytes (pool, 1);
+
+  if (num_bytes > stats->high_water)
+    stats->high_water = num_bytes;
+}
+
+
+/* Return the live link for POOL, or null if POOL is not tagged. */
+static struct pool_stats_link *
+pool_stats_find_link (apr_pool_t *pool)
+{
+  struct pool_stats_link *link;
+
+  for (link = stats_links; link; link = link->next)
+    if (link->live && (link->pool == pool))
+      return link;
+
+  return NULL;
+}
+
+
+/* Cleanup handler: a tagged pool is being cleared or destroyed, so
+   take a last sample and mark its link dead.  (On a mere clear,
+   svn_pool_clear resurrects the link afterwards; see below.) */
+static apr_status_t
+pool_stats_cleanup (void *data)
+{
+  struct pool_stats_link *link = data;
+
+  pool_stats_sample (link->stats, link->pool);
+  link->live = FALSE;
+  link->stats->live--;
+
+  return APR_SUCCESS;
+}
+
+
+void
+svn_pool_tag (apr_pool_t *pool, const char *name)
+{
+  struct pool_stats *stats;
+  struct pool_stats_link *link;
+
+  if (stats_pool == NULL)
+    apr_pool_create_ex (&stats_pool, NULL, abort_on_pool_failure, NULL);
+
+  /* Find the aggregate record for NAME, making one if this is the
+     first pool so tagged. */
+  for (stats = stats_list; stats; stats = stats->next)
+    if (strcmp (stats->tag, name) == 0)
+      break;
+
+  if (stats == NULL)
+    {
+      stats = apr_pcalloc (stats_pool, sizeof (*stats));
+      stats->tag = apr_pstrdup (stats_pool, name);
+      stats->next = stats_list;
+      stats_list = stats;
+    }
+
+  /* Retagging an already-tagged pool just repoints its link; the
+     cleanup handler is registered once and reads the link at run
+     time. */
+  link = pool_stats_find_link (pool);
+  if (link)
+    {
+      link->stats->live--;
+      link->stats = stats;
+      stats->created++;
+      stats->live++;
+      return;
+    }
+
+  /* Recycle a dead link if there is one. */
+  for (link = stats_links; link; link = link->next)
+    if (! link->live)
+      break;
+
+  if (link == NULL)
+    {
+      link = apr_palloc (stats_pool, sizeof (*link));
+      link->next = stats_links;
+      stats_links = link;
+    }
+
+  link->pool = pool;
+  link->stats = stats;
+  link->live = TRUE;
+  stats->created++;
+  stats->live++;
+
+  pool_stats_sample (stats, pool);
+  apr_pool_cleanup_register (pool, link, pool_stats_cleanup,
+                             apr_pool_cleanup_null);
+}
+
+
+void
+svn_pool_stats_dump (FILE *file)
+{
+  struct pool_stats *stats;
+  struct pool_stats_link *link;
+
+  /* Bring the live pools' figures up to date. */
+  for (link = stats_links; link; link = link->next)
+    if (link->live)
+      pool_stats_sample (link->stats, link->pool);
+
+  fprintf (file, "%-28s %8s %6s %8s %12s\n",
+           "pool tag", "created", "live", "cleared", "high-water");
+  for (stats = stats_list; stats; stats = stats->next)
+    fprintf (file, "%-28s %8d %6d %8d %12lu\n",
+             stats->tag, stats->created, stats->live, stats->cleared,
+             (unsigned long) stats->high_water);
+}
+
+#endif /* SVN_POOL_STATS */
+
+
 
 
 
@@ -399,6 +561,41 @@ svn_strerror (apr_status_t statcode, char *buf, apr_size_t bufsize)
 
 
 
+/*-----------------------------------------------------------------*/
+/*** Recycling subpools. ***/
+
+/* Creating and destroying pools is endemic --- one per trail, editor
+   callback, and delta window --- and both operations serialize on
+   the allocator's global mutex in a threaded server.  To keep that
+   churn off the mutex, each pool keeps a small stack of its own
+   destroyed subpools, and svn_pool_create hands one back (already
+   cleared, its cleanups long since run) instead of asking APR for a
+   fresh pool.  A parked pool is still a child of its parent, so the
+   parent's destruction reclaims it like any other subpool, and no
+   lifetimes change.
+
+   Recycling is keyed strictly by parent --- APR gives us no way to
+   re-link a pool to a new parent --- and rides on two userdata keys:
+   a pool's SVN_POOL_RECYCLER is the stack of spare subpools *for its
+   children*, and its SVN_POOL_RECYCLER_HOME is its own parent's
+   stack, recorded at creation so svn_pool_destroy can find the way
+   back.  As with any other use of a single pool, pushing and popping
+   one parent's stack is assumed to happen on one thread at a time.  */
+
+static const char SVN_POOL_RECYCLER[] = "svn-pool-recycler";
+static const char SVN_POOL_RECYCLER_HOME[] = "svn-pool-recycler-home";
+
+/* Park at most this many spare subpools per parent.  */
+#define RECYCLER_SIZE 4
+
+struct pool_recycler
+{
+  apr_pool_t *pools[RECYCLER_SIZE];
+  int count;
+};
+
+
+
 /*-----------------------------------------------------------------*/
 /*
    Macros to make the preprocessor logic less confusing.
@@ -425,7 +622,38 @@ SVN_POOL_FUNC_DEFINE(apr_pool_t *, svn_pool_create)
   apr_pool_t *ret_pool;
 
 #if !APR_POOL_DEBUG
+  struct pool_recycler *recycler = NULL;
+
+  if (pool)
+    {
+      /* If the parent has a spare subpool parked on its recycler
+         stack, it's already cleared and already carries the error
+         pool; just re-attach its way home and hand it out. */
+      apr_pool_userdata_get ((void **) &recycler, SVN_POOL_RECYCLER, pool);
+      if (recycler && recycler->count > 0)
+        {
+          ret_pool = recycler->pools[--recycler->count];
+          apr_pool_userdata_set (recycler, SVN_POOL_RECYCLER_HOME,
+                                 apr_pool_cleanup_null, ret_pool);
+          return ret_pool;
+        }
+    }
+
   apr_pool_create_ex (&ret_pool, pool, abort_on_pool_failure, NULL);
+
+  if (pool)
+    {
+      /* Give the new pool a way back to its parent's recycler stack,
+         building the stack the first time the parent needs one. */
+      if (! recycler)
+        {
+          recycler = apr_pcalloc (pool, sizeof (*recycler));
+          apr_pool_userdata_set (recycler, SVN_POOL_RECYCLER,
+                                 apr_pool_cleanup_null, pool);
+        }
+      apr_pool_userdata_set (recycler, SVN_POOL_RECYCLER_HOME,
+                             apr_pool_cleanup_null, ret_pool);
+    }
 #else /* APR_POOL_DEBUG */
   apr_pool_create_ex_debug (&ret_pool, pool, abort_on_pool_failure,
                             NULL, file_line);
@@ -462,6 +690,20 @@ SVN_POOL_FUNC_DEFINE(void, svn_pool_clear)
 {
   apr_pool_t *error_pool;
   svn_boolean_t subpool_of_p_p;  /* That's "predicate" to you, bud. */
+#if !APR_POOL_DEBUG
+  struct pool_recycler *home;
+#endif /* !APR_POOL_DEBUG */
+#ifdef SVN_POOL_STATS
+  struct pool_stats_link *stats_link = pool_stats_find_link (pool);
+#endif /* SVN_POOL_STATS */
+
+#if !APR_POOL_DEBUG
+  /* The clear wipes this pool's userdata, so remember which recycler
+     stack it belongs to and re-attach it below; otherwise the common
+     create-once, clear-often, destroy-once loops would lose their way
+     back to the stack. */
+  apr_pool_userdata_get ((void **) &home, SVN_POOL_RECYCLER_HOME, pool);
+#endif /* !APR_POOL_DEBUG */
 
   /* Get the error_pool from this pool.  If it's rooted in this pool, we'll
      need to re-create it after we clear the pool. */
@@ -493,6 +735,49 @@ SVN_POOL_FUNC_DEFINE(void, svn_pool_clear)
 
   /* Now, reset the error pool on P. */
   svn_error__set_error_pool (pool, error_pool, subpool_of_p_p);
+
+#if !APR_POOL_DEBUG
+  if (home)
+    apr_pool_userdata_set (home, SVN_POOL_RECYCLER_HOME,
+                           apr_pool_cleanup_null, pool);
+#endif /* !APR_POOL_DEBUG */
+
+#ifdef SVN_POOL_STATS
+  /* The clear ran our cleanup handler, which sampled the pool and
+     marked its link dead; the pool is in fact still alive, so
+     resurrect the link and re-register the handler (cleanups do not
+     survive a clear). */
+  if (stats_link)
+    {
+      stats_link->live = TRUE;
+      stats_link->stats->live++;
+      stats_link->stats->cleared++;
+      apr_pool_cleanup_register (pool, stats_link, pool_stats_cleanup,
+                                 apr_pool_cleanup_null);
+    }
+#endif /* SVN_POOL_STATS */
+}
+
+
+void
+svn_pool_destroy (apr_pool_t *pool)
+{
+#if !APR_POOL_DEBUG
+  struct pool_recycler *home;
+
+  apr_pool_userdata_get ((void **) &home, SVN_POOL_RECYCLER_HOME, pool);
+  if (home && home->count < RECYCLER_SIZE)
+    {
+      /* Run the cleanups and release the memory now, exactly as a
+         destroy would, but park the empty pool on its parent's
+         recycler stack for the next svn_pool_create. */
+      svn_pool_clear (pool);
+      home->pools[home->count++] = pool;
+      return;
+    }
+#endif /* !APR_POOL_DEBUG */
+
+  apr_pool_destroy (pool);
 }
 
 
@@ -73,9 +73,16 @@ svn_string_t *
 svn_string_ncreate (const char *bytes, const apr_size_t size, 
                     apr_pool_t *pool)
 {
+  svn_string_t *new_string;
   char *data;
 
-  data = apr_palloc (pool, size + 1);
+  /* Lay the data right behind the header --- one allocation instead
+     of two.  These strings are created by the million, and the halved
+     allocator traffic (and the locality of header and data sharing a
+     cache line) add up. */
+  new_string = apr_palloc (pool, sizeof (*new_string) + size + 1);
+  data = (char *) new_string + sizeof (*new_string);
+
   memcpy (data, bytes, size);
 
   /* Null termination is the convention -- even if we suspect the data
@@ -83,8 +90,10 @@ svn_string_ncreate (const char *bytes, const apr_size_t size,
      call.  Heck, that's why they call it the caller! */
   data[size] = '\0';
 
-  /* wrap an svn_string_t around the new data */
-  return create_string (data, size, pool);
+  new_string->data = data;
+  new_string->len = size;
+
+  return new_string;
 }
 
 
@@ -230,6 +239,20 @@ svn_string_find_char_backward (const svn_string_t *str, char ch)
 
 /* svn_stringbuf functions */
 
+/* Round small buffers up to this size.  The overwhelming majority of
+   stringbufs are short --- paths, mostly --- and a lot of them get
+   extended a little right after creation (svn_stringbuf_dup followed
+   by svn_path_add_component is the classic), so a bit of slack saves
+   a my__realloc copy far more often than it wastes memory.  Pools
+   can't really realloc in place anyway; not reallocating at all is
+   the only way to win. */
+#define STRINGBUF_MIN_BLOCKSIZE 64
+
+
+/* Wrap an svn_stringbuf_t header around the existing buffer DATA,
+   which holds SIZE bytes plus a null terminator.  (When the buffer
+   doesn't exist yet, svn_stringbuf_ncreate lays it out together with
+   the header in a single allocation instead.) */
 static svn_stringbuf_t *
 create_stringbuf (char *data, apr_size_t size, apr_pool_t *pool)
 {
@@ -249,9 +272,19 @@ svn_stringbuf_t *
 svn_stringbuf_ncreate (const char *bytes, const apr_size_t size, 
                        apr_pool_t *pool)
 {
+  svn_stringbuf_t *new_string;
+  apr_size_t blocksize = size + 1;
   char *data;
 
-  data = apr_palloc (pool, size + 1);
+  if (blocksize < STRINGBUF_MIN_BLOCKSIZE)
+    blocksize = STRINGBUF_MIN_BLOCKSIZE;
+
+  /* One allocation for header and buffer both; see
+     STRINGBUF_MIN_BLOCKSIZE above for why the buffer may be roomier
+     than asked. */
+  new_string = apr_palloc (pool, sizeof (*new_string) + blocksize);
+  data = (char *) new_string + sizeof (*new_string);
+
   memcpy (data, bytes, size);
 
   /* Null termination is the convention -- even if we suspect the data
@@ -259,8 +292,12 @@ svn_stringbuf_ncreate (const char *bytes, const apr_size_t size,
      call.  Heck, that's why they call it the caller! */
   data[size] = '\0';
 
-  /* wrap an svn_stringbuf_t around the new data */
-  return create_stringbuf (data, size, pool);
+  new_string->data = data;
+  new_string->len = size;
+  new_string->blocksize = blocksize;
+  new_string->pool = pool;
+
+  return new_string;
 }
 
 
@@ -535,53 +572,51 @@ svn_string_compare_stringbuf (const svn_string_t *str1,
 
 /*** C string stuff. ***/
 
+svn_boolean_t
+svn_cstring_next_token (svn_string_t *token,
+                        const char **input,
+                        char sep_char,
+                        svn_boolean_t chop_whitespace)
+{
+  const char *b, *e;
+
+  if (*input == NULL)
+    return FALSE;
+
+  b = *input;
+  if (chop_whitespace)
+    while (apr_isspace (*b))
+      b++;
+
+  for (e = b; (*e != sep_char) && (*e != '\0'); e++)
+    ;
+
+  /* Either way the token ends at E; a separator is stepped over, the
+     final nul terminator ends the iteration. */
+  *input = (*e == sep_char) ? e + 1 : NULL;
+
+  if (chop_whitespace)
+    while ((e > b) && (apr_isspace (e[-1])))
+      e--;
+
+  token->data = b;
+  token->len = e - b;
+  return TRUE;
+}
+
+
 apr_array_header_t *
 svn_cstring_split (const char *input,
                    char sep_char,
                    svn_boolean_t chop_whitespace,
                    apr_pool_t *pool)
 {
-  const char *b = input, *e = input;
-  svn_boolean_t one_last_time = (! *e);
+  svn_string_t token;
   apr_array_header_t *substrings = apr_array_make (pool, 1, sizeof (input));
 
-  while (1)
-    {
-      if (chop_whitespace && (apr_isspace (*b)))
-        {
-          b++;
-
-          if (e < b)
-            e = b;
-        }
-      else if ((*e == sep_char) || (*e == '\0'))
-        {
-          const char *e2 = e;
-          
-          if (chop_whitespace)
-            {
-              if (e2 > b)
-                {
-                  while (apr_isspace (*(--e2)))
-                    ;
-                  e2++;
-                }
-            }
-
-          *((char **) (apr_array_push (substrings)))
-            = apr_pstrmemdup (pool, b, e2 - b);
-
-          b = ++e;
-        }
-      else
-        e++;
-
-      if (one_last_time)
-        break;
-
-      if (*e == '\0')
-        one_last_time = TRUE;
-    }
+  while (svn_cstring_next_token (&token, &input, sep_char, chop_whitespace))
+    *((char **) (apr_array_push (substrings)))
+      = apr_pstrmemdup (pool, token.data, token.len);
 
   return substrings;
 }
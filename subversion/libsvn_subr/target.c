@@ -23,6 +23,8 @@
 
 /*** Includes. ***/
 
+#include <stdlib.h>       /* for qsort()   */
+
 #include "svn_string.h"
 #include "svn_pools.h"
 #include "svn_error.h"
@@ -32,6 +34,51 @@
 
 /*** Code. ***/
 
+/* An absolute target and its position in the caller's array. */
+struct condense_item
+{
+  svn_stringbuf_t *path;
+  int idx;
+};
+
+
+/* qsort comparator: order condense_item's so that a directory sorts
+   immediately before the targets inside it.  Treating the separator
+   as lower than any other byte gives that grouping, which the
+   condensation sweep in svn_path_condense_targets relies on; ties
+   (duplicate targets) keep the caller's order. */
+static int
+compare_condense_items (const void *a, const void *b)
+{
+  const struct condense_item *item_a = a;
+  const struct condense_item *item_b = b;
+  const svn_stringbuf_t *path_a = item_a->path;
+  const svn_stringbuf_t *path_b = item_b->path;
+  apr_size_t min_len = (path_a->len < path_b->len) ? path_a->len : path_b->len;
+  apr_size_t i;
+
+  for (i = 0; i < min_len; i++)
+    {
+      unsigned char ch_a = path_a->data[i];
+      unsigned char ch_b = path_b->data[i];
+
+      if (ch_a != ch_b)
+        {
+          if (ch_a == SVN_PATH_SEPARATOR)
+            return -1;
+          if (ch_b == SVN_PATH_SEPARATOR)
+            return 1;
+          return (ch_a < ch_b) ? -1 : 1;
+        }
+    }
+
+  if (path_a->len != path_b->len)
+    return (path_a->len < path_b->len) ? -1 : 1;
+
+  return item_a->idx - item_b->idx;
+}
+
+
 svn_error_t *
 svn_path_get_absolute(svn_stringbuf_t **pabsolute,
                       const svn_stringbuf_t *relative,
@@ -105,7 +152,7 @@ svn_path_condense_targets (svn_stringbuf_t **pbasedir,
     }
   else
     {
-      int i, j, num_condensed = targets->nelts;
+      int i, num_condensed = targets->nelts;
       svn_stringbuf_t *file;
       svn_boolean_t *removed
         = apr_pcalloc (pool, (targets->nelts * sizeof (svn_boolean_t)));
@@ -145,45 +192,41 @@ svn_path_condense_targets (svn_stringbuf_t **pbasedir,
          *pbasedir, it can also be removed. */
       if (pcondensed_targets != NULL)
         {
-          /* First pass: when one non-removed target is a child of
-             another non-removed target, remove the child. */
+          /* First pass: when one target is a child of another
+             target, remove the child.  Rather than comparing every
+             pair of targets, sort them so that a directory stands
+             immediately before the targets inside it, then sweep the
+             sorted list once: each target needs comparing only
+             against the last one kept, which the sort guarantees is
+             its nearest surviving ancestor if it has one at all. */
+          struct condense_item *sorted
+            = apr_palloc (pool, (abs_targets->nelts * sizeof (*sorted)));
+          svn_stringbuf_t *last_kept;
+
           for (i = 0; i < abs_targets->nelts; ++i)
             {
-              if (removed[i])
-                continue;
+              sorted[i].path = ((svn_stringbuf_t **)abs_targets->elts)[i];
+              sorted[i].idx = i;
+            }
+
+          qsort (sorted, abs_targets->nelts, sizeof (*sorted),
+                 compare_condense_items);
 
-              for (j = i + 1; j < abs_targets->nelts; ++j)
+          last_kept = sorted[0].path;
+          for (i = 1; i < abs_targets->nelts; ++i)
+            {
+              svn_stringbuf_t *ancestor
+                = svn_path_get_longest_ancestor (last_kept,
+                                                 sorted[i].path, pool);
+
+              if (ancestor && svn_stringbuf_compare (ancestor, last_kept))
                 {
-                  svn_stringbuf_t *abs_targets_i;
-                  svn_stringbuf_t *abs_targets_j;
-                  svn_stringbuf_t *ancestor;
-
-                  if (removed[j])
-                    continue;
-
-                  abs_targets_i = 
-                    ((svn_stringbuf_t **)abs_targets->elts)[i];
-
-                  abs_targets_j = 
-                    ((svn_stringbuf_t **)abs_targets->elts)[j];
-
-                  ancestor = svn_path_get_longest_ancestor 
-                    (abs_targets_i, abs_targets_j, pool);
-
-                  if (! ancestor)
-                    continue;
-
-                  if (svn_stringbuf_compare (ancestor, abs_targets_i))
-                    {
-                      removed[j] = TRUE;
-                      num_condensed--;
-                    }
-                  else if (svn_stringbuf_compare (ancestor, abs_targets_j))
-                    {
-                      removed[i] = TRUE;
-                      num_condensed--;
-                    }
+                  /* LAST_KEPT is this target, or a parent of it. */
+                  removed[sorted[i].idx] = TRUE;
+                  num_condensed--;
                 }
+              else
+                last_kept = sorted[i].path;
             }
           
           /* Second pass: when a target is the same as *pbasedir,
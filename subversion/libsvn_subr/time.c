@@ -29,28 +29,75 @@
 /*** Code. ***/
 
 /* Our timestamp strings look like this:
- * 
- *    "Tue 3 Oct 2000 HH:MM:SS.UUU (day 277, dst 1, gmt_off -18000)"
  *
- * The idea is that they are conventionally human-readable for the
- * first part, and then in parentheses comes everything else required
- * to completely fill in an apr_time_exp_t: tm_yday, tm_isdst,
- * and tm_gmtoff.
+ *    "2002-05-28T13:22:01.123456Z"
  *
- * kff todo: what about portability problems resulting from the
- * plain int assumptions below, though?  Using apr_strftime() would
- * fix that, but converting the strings back is still a problem (see
- * the comment in svn_wc__time_to_string()).
+ * That is a fixed-width subset of ISO-8601, always in GMT.  Every
+ * field sits at a known offset, so writing one out is a handful of
+ * digit stores and reading one back is table-driven --- no printf or
+ * scanf machinery in either direction.  Working copies parse one
+ * timestamp per entry when the entries file is read, which puts this
+ * codec on the status path.
+ *
+ * The previous format,
+ *
+ *    "Tue 3 Oct 2000 HH:MM:SS.UUU (day 277, dst 1, gmt_off -18000)",
+ *
+ * is still recognized by svn_time_from_nts so existing entries files
+ * keep working, but it is never written anymore.  Free-form
+ * human-typed dates (e.g. from `-r {DATE}') are the business of the
+ * getdate.y parser, not of this codec.
  */
-static const char * const timestamp_format =
-"%s %d %s %d %02d:%02d:%02d.%06d (day %03d, dst %d, gmt_off %06d)";
 
+/* The template doubles as the punctuation table: the formatter copies
+   it and overwrites the digit positions, and the parser insists that
+   every non-digit position match it.  The two cannot drift apart.
+   (Its size, null included, is what SVN_TIME_NTS_BUFSIZE promises.) */
+static const char timestamp_template[] = "0000-00-00T00:00:00.000000Z";
+
+/* Where each numeric field of the fixed format lives, in the order
+   the fields appear in the string. */
+static const struct timestamp_field {
+  int offset;
+  int width;
+} timestamp_fields[] = {
+  {  0, 4 },      /* year */
+  {  5, 2 },      /* month */
+  {  8, 2 },      /* day */
+  { 11, 2 },      /* hour */
+  { 14, 2 },      /* minute */
+  { 17, 2 },      /* second */
+  { 20, 6 }       /* microseconds */
+};
+
+/* The old format, kept for reading timestamps written before the
+   fixed format existed.  (Since this is now only ever scanned, the
+   string conversions can be bounded to the three-letter day and month
+   names they match.) */
+static const char * const old_timestamp_format =
+"%3s %d %3s %d %02d:%02d:%02d.%06d (day %03d, dst %d, gmt_off %06d)";
+
+
+/* Write VAL at P as exactly WIDTH decimal digits, zero-padded. */
+static void
+write_digits (char *p, int val, int width)
+{
+  int i;
 
-const char *
-svn_time_to_nts (apr_time_t t, apr_pool_t *pool)
+  for (i = width - 1; i >= 0; i--)
+    {
+      p[i] = '0' + (val % 10);
+      val /= 10;
+    }
+}
+
+
+void
+svn_time_to_nts_buf (char *buf, apr_time_t t)
 {
-  const char *t_cstr;
   apr_time_exp_t exploded_time;
+  int vals[7];
+  int i;
 
   /* We toss apr_status_t return value here -- for one thing, caller
      should pass in good information.  But also, where APR's own code
@@ -58,25 +105,30 @@ svn_time_to_nts (apr_time_t t, apr_pool_t *pool)
      furthermore their current implementations can only return success
      anyway. */
 
-  apr_explode_localtime (&exploded_time, t);
-
-  /* It would be nice to use apr_strftime(), but APR doesn't give a way
-     to convert back, so we wouldn't be able to share the format string
-     between the writer and reader.  Sigh.  Also, apr_strftime() doesn't
-     offer format codes for its special tm_usec and tm_gmtoff fields. */
-  t_cstr = apr_psprintf (pool,
-                         timestamp_format,
-                         apr_day_snames[exploded_time.tm_wday],
-                         exploded_time.tm_mday,
-                         apr_month_snames[exploded_time.tm_mon],
-                         exploded_time.tm_year + 1900,
-                         exploded_time.tm_hour,
-                         exploded_time.tm_min,
-                         exploded_time.tm_sec,
-                         exploded_time.tm_usec,
-                         exploded_time.tm_yday + 1,
-                         exploded_time.tm_isdst,
-                         exploded_time.tm_gmtoff);
+  apr_explode_gmt (&exploded_time, t);
+
+  vals[0] = exploded_time.tm_year + 1900;
+  vals[1] = exploded_time.tm_mon + 1;
+  vals[2] = exploded_time.tm_mday;
+  vals[3] = exploded_time.tm_hour;
+  vals[4] = exploded_time.tm_min;
+  vals[5] = exploded_time.tm_sec;
+  vals[6] = exploded_time.tm_usec;
+
+  memcpy (buf, timestamp_template, sizeof (timestamp_template));
+  for (i = 0; i < 7; i++)
+    write_digits (buf + timestamp_fields[i].offset,
+                  vals[i],
+                  timestamp_fields[i].width);
+}
+
+
+const char *
+svn_time_to_nts (apr_time_t t, apr_pool_t *pool)
+{
+  char *t_cstr = apr_palloc (pool, SVN_TIME_NTS_BUFSIZE);
+
+  svn_time_to_nts_buf (t_cstr, t);
 
   return t_cstr;
 }
@@ -95,28 +147,10 @@ find_matching_string (char *str, const char strings[][4])
 }
 
 
-/* ### todo:
-
-   Recently Branko changed svn_time_from_string (or rather, he changed
-   svn_wc__string_to_time, but the function's name has changed since
-   then) to use apr_implode_gmt.  So now that function is using GMT,
-   but its inverse above, svn_time_to_string, is using localtime.
-
-   I'm not sure what the right thing to do is; see issue #404.  See
-   also the thread entitled "apr_implode_time and time zones" in the
-   APR dev mailing list archives:
-
-      http://apr.apache.org/mail/dev/200106.gz
-
-   That discussion between Branko and David Reid is directly
-   relevant.
-
-   Note that Subversion repositories probably want to record commit
-   dates in GMT.  Maybe we should just make Subversion's string
-   representation for times always use GMT -- that's good for
-   repositories, and for working copies it doesn't really matter since
-   humans don't have to read the timestamps in SVN/entries files much
-   (and when they do, they can easily do the conversion).  */
+/* The fixed format both writes and reads GMT, which settles the
+   localtime-out, GMT-back mismatch the old format suffered from (see
+   issue #404); the old-format fallback below keeps the historical
+   behavior for old strings. */
 
 
 apr_time_t
@@ -126,8 +160,59 @@ svn_time_from_nts (const char *data)
   char wday[4], month[4];
   apr_time_t when;
 
+  /* Try the fixed format first: right length, punctuation matching
+     the template, all digits in between.  Anything else falls through
+     to the old reader below. */
+  if (strlen (data) == sizeof (timestamp_template) - 1)
+    {
+      int vals[7];
+      svn_boolean_t valid = TRUE;
+      int i;
+
+      for (i = 0; valid && i < (int) sizeof (timestamp_template) - 1; i++)
+        if ((timestamp_template[i] != '0') && (data[i] != timestamp_template[i]))
+          valid = FALSE;
+
+      for (i = 0; valid && i < 7; i++)
+        {
+          const struct timestamp_field *field = &timestamp_fields[i];
+          int val = 0;
+          int j;
+
+          for (j = 0; j < field->width; j++)
+            {
+              char c = data[field->offset + j];
+
+              if ((c < '0') || (c > '9'))
+                {
+                  valid = FALSE;
+                  break;
+                }
+              val = (val * 10) + (c - '0');
+            }
+          vals[i] = val;
+        }
+
+      if (valid)
+        {
+          memset (&exploded_time, 0, sizeof (exploded_time));
+          exploded_time.tm_year = vals[0] - 1900;
+          exploded_time.tm_mon  = vals[1] - 1;
+          exploded_time.tm_mday = vals[2];
+          exploded_time.tm_hour = vals[3];
+          exploded_time.tm_min  = vals[4];
+          exploded_time.tm_sec  = vals[5];
+          exploded_time.tm_usec = vals[6];
+
+          apr_implode_gmt (&when, &exploded_time);
+
+          return when;
+        }
+    }
+
+  /* Old-format fallback. */
   sscanf (data,
-          timestamp_format,
+          old_timestamp_format,
           wday,
           &exploded_time.tm_mday,
           month,
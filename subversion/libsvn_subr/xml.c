@@ -28,6 +28,61 @@
 
 /*** XML escaping. ***/
 
+/* The five bytes XML makes us escape, as a table indexed by unsigned
+   char.  Scanning with one load per byte beats the five-way
+   comparison chain when almost every byte is innocent, which is the
+   normal case for paths.  (Strictly speaking, '>' only needs to be
+   quoted if it follows "]]", but it's easier to quote it all the
+   time.) */
+static const char xml_special[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*   0 -  15 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*  16 -  31 */
+  0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,   /*  32 -  47 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0,   /*  48 -  63 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*  64 -  79 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*  80 -  95 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*  96 - 111 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 112 - 127 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 128 - 143 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 144 - 159 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 160 - 175 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 176 - 191 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 192 - 207 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 208 - 223 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 224 - 239 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0   /* 240 - 255 */
+};
+
+
+/* Return how many leading bytes of DATA (which has length LEN) can be
+   passed through without escaping. */
+static apr_size_t
+count_xml_innocent_bytes (const char *data, apr_size_t len)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  apr_size_t remaining = len;
+
+  /* Four table probes per loop; this scan is the whole cost of
+     "escaping" a string that turns out to need none. */
+  while (remaining >= 4)
+    {
+      if (xml_special[p[0]] || xml_special[p[1]]
+          || xml_special[p[2]] || xml_special[p[3]])
+        break;
+      p += 4;
+      remaining -= 4;
+    }
+
+  while (remaining > 0 && ! xml_special[*p])
+    {
+      p++;
+      remaining--;
+    }
+
+  return (apr_size_t) ((const char *) p - data);
+}
+
+
 static void
 xml_escape (svn_stringbuf_t **outstr,
             const char *data,
@@ -40,16 +95,15 @@ xml_escape (svn_stringbuf_t **outstr,
   if (*outstr == NULL)
     *outstr = svn_stringbuf_create ("", pool);
 
+  /* The output is at least as long as the input; grow once up front
+     instead of a few bytes at a time. */
+  svn_stringbuf_ensure (*outstr, (*outstr)->len + len + 1);
+
   while (1)
     {
-      /* Find a character which needs to be quoted and append bytes up
-         to that point.  Strictly speaking, '>' only needs to be
-         quoted if it follows "]]", but it's easier to quote it all
-         the time.  */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>'
-             && *q != '"' && *q != '\'')
-        q++;
+      /* Find a character which needs to be quoted and append the run
+         of innocent bytes up to that point. */
+      q = p + count_xml_innocent_bytes (p, end - p);
       svn_stringbuf_appendbytes (*outstr, p, q - p);
 
       /* We may already be a winner.  */
@@ -167,6 +221,18 @@ svn_xml_escape_stringbuf (svn_stringbuf_t **outstr,
                           const svn_stringbuf_t *string,
                           apr_pool_t *pool)
 {
+  /* The common case --- a path or property value with nothing special
+     in it --- needs no escaping at all, so when the caller isn't
+     accumulating into an existing buffer, hand back the input itself
+     rather than a copy. */
+  if ((*outstr == NULL)
+      && (count_xml_innocent_bytes (string->data, string->len)
+          == string->len))
+    {
+      *outstr = (svn_stringbuf_t *) string;
+      return;
+    }
+
   xml_escape (outstr, string->data, string->len, pool);
 }
 
@@ -231,6 +297,12 @@ svn_xml_make_parser (void *userData,
 
   XML_Parser parser = XML_ParserCreate (NULL);
 
+  /* Everything parsed through here is one of our own internal
+     formats --- wc log files, entries files, delta streams --- which
+     we write ourselves, without namespaces or doctypes.  Tell expat
+     so it can skip the hash table bookkeeping those features need. */
+  XML_SetLeanParsing (parser, 1);
+
   XML_SetUserData (parser, userData);
   XML_SetElementHandler (parser, start_handler, end_handler); 
   XML_SetCharacterDataHandler (parser, data_handler);
@@ -260,27 +332,24 @@ svn_xml_free_parser (svn_xml_parser_t *svn_parser)
 
 
 
-svn_error_t *
-svn_xml_parse (svn_xml_parser_t *svn_parser,
-               const char *buf,
-               apr_size_t len,
-               svn_boolean_t is_final)
+/* Shared result checking for XML_Parse() and XML_ParseBuffer():
+   convert an expat failure or a callback bailout in SVN_PARSER into
+   an svn_error_t, freeing SVN_PARSER as svn_xml_parse() promises.
+   SUCCESS is the return value of the expat call. */
+static svn_error_t *
+check_parse_success (svn_xml_parser_t *svn_parser, int success)
 {
   svn_error_t *err;
-  int success;
-
-  /* Parse some xml data */
-  success = XML_Parse (svn_parser->parser, buf, len, is_final);
 
   /* If expat choked internally, return its error. */
   if (! success)
     {
       err = svn_error_createf
-        (SVN_ERR_MALFORMED_XML, 0, NULL, svn_parser->pool, 
+        (SVN_ERR_MALFORMED_XML, 0, NULL, svn_parser->pool,
          "%s at line %d",
          XML_ErrorString (XML_GetErrorCode (svn_parser->parser)),
          XML_GetCurrentLineNumber (svn_parser->parser));
-      
+
       /* Kill all parsers and return the expat error */
       svn_xml_free_parser (svn_parser);
       return err;
@@ -293,11 +362,43 @@ svn_xml_parse (svn_xml_parser_t *svn_parser,
       svn_xml_free_parser (svn_parser);
       return err;
     }
-  
+
   return SVN_NO_ERROR;
 }
 
 
+svn_error_t *
+svn_xml_parse (svn_xml_parser_t *svn_parser,
+               const char *buf,
+               apr_size_t len,
+               svn_boolean_t is_final)
+{
+  /* Parse some xml data */
+  int success = XML_Parse (svn_parser->parser, buf, len, is_final);
+
+  return check_parse_success (svn_parser, success);
+}
+
+
+char *
+svn_xml_get_parse_buffer (svn_xml_parser_t *svn_parser, apr_size_t len)
+{
+  return XML_GetBuffer (svn_parser->parser, len);
+}
+
+
+svn_error_t *
+svn_xml_parse_buffer (svn_xml_parser_t *svn_parser,
+                      apr_size_t len,
+                      svn_boolean_t is_final)
+{
+  /* Parse the data already sitting in expat's own buffer; no copy. */
+  int success = XML_ParseBuffer (svn_parser->parser, len, is_final);
+
+  return check_parse_success (svn_parser, success);
+}
+
+
 
 void svn_xml_signal_bailout (svn_error_t *error,
                              svn_xml_parser_t *svn_parser)
@@ -86,9 +86,15 @@ restore_file (svn_stringbuf_t *file_path,
    copy to an RA layer.  Used to initiate updates.
 
    This is a depth-first recursive walk of DIR_PATH under WC_PATH.
-   Look at each entry and check if its revision is different than
-   DIR_REV.  If so, report this fact to REPORTER.  If an entry is
-   missing from disk, report its absence to REPORTER.  
+   DIR_REV is the revision the *parent* directory believes this
+   subtree to be at; if this directory's own entry disagrees, report
+   that once with set_path, which covers every descendant at the same
+   revision --- a subtree at a uniform revision costs one report no
+   matter how big it is.  Then look at each entry and report only
+   those whose revision differs from this directory's.  If an entry is
+   missing from disk, report its absence to REPORTER.  (Existence
+   checks are batched: one readdir of the directory, not a stat per
+   entry.)
 
    If RESTORE_FILES is set, then unexpectedly missing working files
    will be restored from text-base and NOTIFY_FUNC/NOTIFY_BATON
@@ -116,7 +122,23 @@ report_revisions (svn_stringbuf_t *wc_path,
   /* Get both the SVN Entries and the actual on-disk entries. */
   SVN_ERR (svn_wc_entries_read (&entries, full_path, subpool));
   SVN_ERR (svn_io_get_dirents (&dirents, full_path, subpool));
-  
+
+  /* This directory's own entry carries its authoritative revision;
+     compare it to the parent's belief here, where the entries are
+     already in hand, rather than have the parent read them a second
+     time just to make this report. */
+  {
+    svn_wc_entry_t *this_dir_entry
+      = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, APR_HASH_KEY_STRING);
+
+    if ((dir_path->len > 0) && (this_dir_entry->revision != dir_rev))
+      SVN_ERR (reporter->set_path (report_baton,
+                                   dir_path->data,
+                                   this_dir_entry->revision));
+
+    dir_rev = this_dir_entry->revision;
+  }
+
   /* Do the real reporting and recursing. */
 
   /* Looping over current directory's SVN entries: */
@@ -218,28 +240,15 @@ report_revisions (svn_stringbuf_t *wc_path,
                    "Please remove this entry and try updating again.",
                    full_entry_path->data);
               
-              /* Otherwise, possibly report a differing revision, and
-                 recurse. */
-              {
-                svn_wc_entry_t *subdir_entry;
-                svn_stringbuf_t *megalong_path = 
-                  svn_stringbuf_dup (wc_path, subpool);
-                svn_path_add_component (megalong_path, full_entry_path);
-                SVN_ERR (svn_wc_entry (&subdir_entry, megalong_path, subpool));
-                
-                if (subdir_entry->revision != dir_rev)
-                  SVN_ERR (reporter->set_path (report_baton,
-                                               full_entry_path->data,
-                                               subdir_entry->revision));
-                /* Recurse. */
-                SVN_ERR (report_revisions (wc_path,
-                                           full_entry_path,
-                                           subdir_entry->revision,
-                                           reporter, report_baton,
-                                           notify_func, notify_baton,
-                                           restore_files, recurse,
-                                           subpool));
-              }
+              /* Otherwise recurse; the child reports its own
+                 revision, since it has to read its entries anyway. */
+              SVN_ERR (report_revisions (wc_path,
+                                         full_entry_path,
+                                         dir_rev,
+                                         reporter, report_baton,
+                                         notify_func, notify_baton,
+                                         restore_files, recurse,
+                                         subpool));
             } /* end directory case */
         } /* end 'entry exists on disk' */   
     } /* end main entries loop */
@@ -455,7 +464,8 @@ svn_wc_transmit_text_deltas (svn_stringbuf_t *path,
   /* Create a text-delta stream object that pulls data out of the two
      files. */
   svn_txdelta (&txdelta_stream,
-               svn_stream_from_aprfile (basefile, pool),
+               svn_stream_buffered (svn_stream_from_aprfile (basefile, pool),
+                                    0, pool),
                svn_stream_from_aprfile (localfile, pool),
                pool);
   
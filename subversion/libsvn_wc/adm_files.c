@@ -29,12 +29,16 @@
 #include <apr_file_io.h>
 #include <apr_time.h>
 #include <apr_strings.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_hash.h"
 #include "svn_io.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 #include "svn_wc.h"
 
 #include "wc.h"
@@ -193,6 +197,201 @@ chop_admin_name (svn_stringbuf_t *path, int num_components)
 }
 
 
+
+/*** A cache of administrative-directory listings. ***/
+
+/* Every "is this a working copy?" and "does this adm thing exist?"
+   question used to cost its own stat or open into the adm area, and
+   recursive operations ask them for node after node in the same
+   directory.  So we read each adm directory once --- a single readdir
+   --- remember the kind of everything in it, and validate the
+   snapshot against the directory's own size and mtime on each use.
+   Things appear in and leave the adm area by creation, removal, or a
+   rename from tmp/, all of which touch the directory, so the
+   validation catches writers.  (The usual caveat applies: two changes
+   within one mtime granule could fool it, but the working copy lock
+   keeps writers out while we're asking.  Lock files themselves come
+   and go too quickly for that comfort, so svn_wc_locked does not use
+   this cache.)
+
+   Process-wide and mutex-guarded, like the entries cache (see
+   entries.c): the mutex is created with the cache, so anything that
+   spawns threads must have primed it from a single thread first. */
+
+static apr_pool_t *adm_dir_cache_pool = NULL;
+static apr_hash_t *adm_dir_cache = NULL;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *adm_dir_cache_lock = NULL;
+#endif
+
+
+/* Serialize access to the adm directory cache.  No-ops until the
+   cache machinery exists. */
+static void
+lock_adm_dir_cache (void)
+{
+#if APR_HAS_THREADS
+  if (adm_dir_cache_lock)
+    apr_thread_mutex_lock (adm_dir_cache_lock);
+#endif
+}
+
+static void
+unlock_adm_dir_cache (void)
+{
+#if APR_HAS_THREADS
+  if (adm_dir_cache_lock)
+    apr_thread_mutex_unlock (adm_dir_cache_lock);
+#endif
+}
+
+
+struct adm_dir_index
+{
+  /* Basename of each thing in the adm directory
+     -> (enum svn_node_kind *), all allocated in SUBPOOL. */
+  apr_hash_t *kinds;
+
+  /* Size and mtime of the adm directory itself when we listed it. */
+  apr_off_t dir_size;
+  apr_time_t dir_mtime;
+
+  /* The subpool all of the above lives in. */
+  apr_pool_t *subpool;
+};
+
+
+/* Set *INDEX_P to a current index of the administrative directory
+   ADM_PATH, listing it afresh if the cache has nothing usable, or to
+   null if the directory can't be statted (the caller then falls back
+   to asking the filesystem directly).  Use POOL only for temporary
+   allocations.  Call with the cache lock held. */
+static svn_error_t *
+get_adm_dir_index (struct adm_dir_index **index_p,
+                   const char *adm_path,
+                   apr_pool_t *pool)
+{
+  struct adm_dir_index *index;
+  apr_finfo_t finfo;
+  apr_dir_t *dir;
+  apr_pool_t *subpool;
+  apr_status_t status;
+
+  if (adm_dir_cache_pool == NULL)
+    {
+      adm_dir_cache_pool = svn_pool_create (NULL);
+      adm_dir_cache = apr_hash_make (adm_dir_cache_pool);
+#if APR_HAS_THREADS
+      apr_thread_mutex_create (&adm_dir_cache_lock,
+                               APR_THREAD_MUTEX_DEFAULT,
+                               adm_dir_cache_pool);
+#endif
+    }
+
+  if (apr_stat (&finfo, adm_path, APR_FINFO_MIN, pool))
+    {
+      *index_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  index = apr_hash_get (adm_dir_cache, adm_path, APR_HASH_KEY_STRING);
+  if (index
+      && (index->dir_size == finfo.size)
+      && (index->dir_mtime == finfo.mtime))
+    {
+      *index_p = index;
+      return SVN_NO_ERROR;
+    }
+
+  /* Toss any stale listing, and read the directory afresh. */
+  if (index)
+    {
+      apr_hash_set (adm_dir_cache, adm_path, APR_HASH_KEY_STRING, NULL);
+      svn_pool_destroy (index->subpool);
+    }
+
+  subpool = svn_pool_create (adm_dir_cache_pool);
+  index = apr_pcalloc (subpool, sizeof (*index));
+  index->subpool = subpool;
+  index->kinds = apr_hash_make (subpool);
+  index->dir_size = finfo.size;
+  index->dir_mtime = finfo.mtime;
+
+  status = apr_dir_open (&dir, adm_path, pool);
+  if (status)
+    {
+      svn_pool_destroy (subpool);
+      return svn_error_createf (status, 0, NULL, pool,
+                                "get_adm_dir_index: can't open '%s'",
+                                adm_path);
+    }
+
+  for (status = apr_dir_read (&finfo, APR_FINFO_TYPE | APR_FINFO_NAME, dir);
+       status == APR_SUCCESS;
+       status = apr_dir_read (&finfo, APR_FINFO_TYPE | APR_FINFO_NAME, dir))
+    {
+      enum svn_node_kind *kind;
+
+      if ((strcmp (finfo.name, ".") == 0)
+          || (strcmp (finfo.name, "..") == 0))
+        continue;
+
+      kind = apr_palloc (subpool, sizeof (*kind));
+      if (finfo.filetype == APR_DIR)
+        *kind = svn_node_dir;
+      else if (finfo.filetype == APR_REG)
+        *kind = svn_node_file;
+      else
+        *kind = svn_node_unknown;
+
+      apr_hash_set (index->kinds,
+                    apr_pstrdup (subpool, finfo.name),
+                    APR_HASH_KEY_STRING, kind);
+    }
+
+  apr_dir_close (dir);
+
+  apr_hash_set (adm_dir_cache,
+                apr_pstrdup (adm_dir_cache_pool, adm_path),
+                APR_HASH_KEY_STRING, index);
+
+  *index_p = index;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__adm_thing_kind (enum svn_node_kind *kind,
+                        const svn_stringbuf_t *path,
+                        const char *thing,
+                        apr_pool_t *pool)
+{
+  struct adm_dir_index *index;
+  svn_stringbuf_t *adm_path = svn_stringbuf_dup (path, pool);
+  enum svn_node_kind *cached;
+
+  extend_with_adm_name (adm_path, NULL, 0, pool, NULL);
+
+  lock_adm_dir_cache ();
+  SVN_ERR (get_adm_dir_index (&index, adm_path->data, pool));
+  if (index)
+    {
+      cached = apr_hash_get (index->kinds, thing, APR_HASH_KEY_STRING);
+      *kind = cached ? *cached : svn_node_none;
+      unlock_adm_dir_cache ();
+      return SVN_NO_ERROR;
+    }
+  unlock_adm_dir_cache ();
+
+  /* No adm directory to list; ask about the thing directly, so the
+     caller sees the same answer it would have gotten the slow way. */
+  svn_path_add_component_nts (adm_path, thing);
+  SVN_ERR (svn_io_check_path (adm_path->data, kind, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /*** Making and using files in the adm area. ***/
 
@@ -378,11 +577,99 @@ svn_wc__text_base_path (const svn_stringbuf_t *path,
                         SVN_WC__ADM_TEXT_BASE,
                         basename->data,
                         NULL);
-    
+
   return newpath;
 }
 
 
+/* Set *STORE_PATH to the shared pristine store directory of the
+   working copy DIR_PATH belongs to: SVN_WC__ADM_PRISTINE in the adm
+   area of the topmost versioned directory at or above DIR_PATH. */
+static svn_error_t *
+pristine_store_path (svn_stringbuf_t **store_path,
+                     const svn_stringbuf_t *dir_path,
+                     apr_pool_t *pool)
+{
+  svn_stringbuf_t *root;
+
+  /* Climb to the root of the working copy; every directory below it
+     shares the root's store. */
+  SVN_ERR (svn_path_get_absolute (&root, dir_path, pool));
+  while (1)
+    {
+      svn_stringbuf_t *parent, *basename;
+      svn_boolean_t is_wc;
+
+      svn_path_split (root, &parent, &basename, pool);
+      if (svn_path_is_empty (parent)
+          || svn_stringbuf_compare (parent, root))
+        break;
+      SVN_ERR (svn_wc_check_wc (parent, &is_wc, pool));
+      if (! is_wc)
+        break;
+      root = parent;
+    }
+
+  extend_with_adm_name (root, NULL, 0, pool, SVN_WC__ADM_PRISTINE, NULL);
+  *store_path = root;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__pristine_install (svn_stringbuf_t *path,
+                          const svn_stringbuf_t *checksum,
+                          apr_pool_t *pool)
+{
+  svn_stringbuf_t *dir_path, *basename, *store_path, *text_base;
+  enum svn_node_kind kind;
+
+  svn_path_split (path, &dir_path, &basename, pool);
+  if (svn_path_is_empty (dir_path))
+    svn_stringbuf_set (dir_path, ".");
+
+  SVN_ERR (pristine_store_path (&store_path, dir_path, pool));
+
+  /* The store fills in lazily; older working copies won't have the
+     directory yet. */
+  SVN_ERR (svn_io_check_path (store_path->data, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      apr_status_t apr_err = apr_dir_make (store_path->data,
+                                           APR_OS_DEFAULT, pool);
+      if (apr_err && ! APR_STATUS_IS_EEXIST (apr_err))
+        return svn_error_create (apr_err, 0, NULL, pool, store_path->data);
+    }
+
+  svn_path_add_component_nts (store_path, checksum->data);
+  text_base = svn_wc__text_base_path (path, FALSE, pool);
+
+  SVN_ERR (svn_io_check_path (store_path->data, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      /* First sighting of these contents; the text-base becomes the
+         stored copy. */
+      SVN_ERR (svn_io_link_or_copy_file (text_base->data, store_path->data,
+                                         pool));
+    }
+  else
+    {
+      /* The store already holds these contents; point the text-base
+         at the stored copy.  Go through the tmp name and rename, so
+         the text-base never goes missing if we're interrupted.
+         ### We trust that the stored bytes match CHECKSUM; `svn
+         cleanup' would be the place to audit the store. */
+      svn_stringbuf_t *tmp_base = svn_wc__text_base_path (path, TRUE, pool);
+
+      SVN_ERR (svn_io_link_or_copy_file (store_path->data, tmp_base->data,
+                                         pool));
+      SVN_ERR (svn_wc__sync_text_base (path, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 prop_path_internal (svn_stringbuf_t **prop_path,
                     const svn_stringbuf_t *path,
@@ -1041,7 +1328,6 @@ check_adm_exists (int *exists,
   svn_error_t *err = NULL;
   enum svn_node_kind kind;
   int dir_exists = 0;
-  apr_file_t *f = NULL;
   int components_added;
 
   /** Step 1: check that the directory exists. **/
@@ -1083,20 +1369,13 @@ check_adm_exists (int *exists,
   /** The directory exists, but is it a valid working copy yet?
       Try step 2: checking that SVN_WC__ADM_README exists. **/
 
-  err = svn_wc__open_adm_file (&f, path, SVN_WC__ADM_README, APR_READ, pool);
-  if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
-    return err;
-  else if (err)
-    {
-      svn_error_clear_all (err);
-      *exists = 0;
-    }
-  else
-    *exists = 1;
+  {
+    enum svn_node_kind readme_kind;
 
-  err = svn_wc__close_adm_file (f, path, SVN_WC__ADM_README, 0, pool);
-  if (err)
-    return err;
+    SVN_ERR (svn_wc__adm_thing_kind (&readme_kind, path,
+                                     SVN_WC__ADM_README, pool));
+    *exists = (readme_kind == svn_node_file);
+  }
 
   /** kff todo:
       Step 3: now check that repos and ancestry are correct **/
@@ -55,6 +55,17 @@ svn_boolean_t svn_wc__adm_path_exists (svn_stringbuf_t *path,
                                        apr_pool_t *pool,
                                        ...);
 
+/* Set *KIND to the kind of `PATH/<adminstrative_subdir>/THING', or
+   svn_node_none if there is no such thing.  Served from a cached
+   listing of the adm directory --- one readdir, revalidated against
+   the directory's stat --- so asking about thing after thing in the
+   same directory costs no filesystem traffic.  Don't use this for
+   things that come and go mid-operation, like lock files. */
+svn_error_t *svn_wc__adm_thing_kind (enum svn_node_kind *kind,
+                                     const svn_stringbuf_t *path,
+                                     const char *thing,
+                                     apr_pool_t *pool);
+
 
 /* Make `PATH/<adminstrative_subdir>/THING'. */
 svn_error_t *svn_wc__make_adm_thing (svn_stringbuf_t *path,
@@ -77,6 +88,29 @@ svn_stringbuf_t *svn_wc__text_base_path (const svn_stringbuf_t *path,
                                          apr_pool_t *pool);
 
 
+/* Enter PATH's text-base into the shared pristine store.
+
+   The store is SVN_WC__ADM_PRISTINE in the adm area of the working
+   copy's root directory, holding one copy of each distinct pristine
+   text seen anywhere in the working copy, named by its hex MD5
+   digest.  CHECKSUM is the digest of PATH's current text-base.
+
+   If the store has no entry for CHECKSUM, the text-base becomes the
+   stored copy.  If it does, the text-base is relinked to the stored
+   copy, so identical pristines --- branch siblings, mostly --- share
+   a single inode (and one trip through the page cache) where the
+   filesystem supports hard links, and remain independent copies
+   where it doesn't.  Sharing is safe because text-bases are only
+   ever replaced by rename, which quietly dissolves the link.
+
+   Call this only after the text-base has reached its final name;
+   loggy installation runs the store update after the log, so an
+   interrupted run just leaves the store one entry behind. */
+svn_error_t *svn_wc__pristine_install (svn_stringbuf_t *path,
+                                       const svn_stringbuf_t *checksum,
+                                       apr_pool_t *pool);
+
+
 /* Return a path to the 'wcprop' file for PATH, possibly in TMP area.  */
 svn_error_t *svn_wc__wcprop_path (svn_stringbuf_t **wcprop_path,
                                   const svn_stringbuf_t *path,
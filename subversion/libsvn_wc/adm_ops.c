@@ -36,12 +36,15 @@
 #include "svn_path.h"
 #include "svn_wc.h"
 
+#include "svn_time.h"
+
 #include "wc.h"
 #include "log.h"
 #include "adm_files.h"
 #include "adm_ops.h"
 #include "entries.h"
 #include "props.h"
+#include "questions.h"
 #include "translate.h"
 
 
@@ -877,6 +880,36 @@ revert_admin_things (svn_stringbuf_t *parent_dir,
           SVN_ERR (svn_io_file_affected_time (&tstamp, fullpath, pool));
           *modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_TIME;
           entry->text_time = tstamp;
+          SVN_ERR (svn_io_file_size (&entry->text_size, fullpath->data, pool));
+          *modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_SIZE;
+        }
+      else if (kind == svn_node_file)
+        {
+          svn_boolean_t equal_timestamps;
+
+          /* The working file's contents match the text-base, so there
+             is nothing to restore.  But if the timestamp recorded in
+             the entries file is stale -- as happens when something
+             touches a file without changing it -- then the check
+             above had to fall back on an expensive comparison, and so
+             will every future check.  Record the working file's
+             current timestamp and size so those checks can decide
+             cheaply.  This is pure bookkeeping, not a reversion, so
+             it deliberately bypasses MODIFY_FLAGS and the caller's
+             notification. */
+          SVN_ERR (svn_wc__timestamps_equal_p (&equal_timestamps, fullpath,
+                                               svn_wc__text_time, pool));
+          if (! equal_timestamps)
+            {
+              SVN_ERR (svn_io_file_affected_time (&tstamp, fullpath, pool));
+              entry->text_time = tstamp;
+              SVN_ERR (svn_io_file_size (&entry->text_size, fullpath->data,
+                                         pool));
+              SVN_ERR (svn_wc__entry_modify (parent_dir, name, entry,
+                                             SVN_WC__ENTRY_MODIFY_TEXT_TIME
+                                             | SVN_WC__ENTRY_MODIFY_TEXT_SIZE,
+                                             pool));
+            }
         }
     }
 
@@ -1096,6 +1129,121 @@ svn_wc_revert (svn_stringbuf_t *path,
 }
 
 
+svn_error_t *
+svn_wc_stabilize (svn_stringbuf_t *path, apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create (pool);
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+      svn_wc_entry_t *entry;
+      svn_stringbuf_t *full_path;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      entry = val;
+
+      /* Skip "this dir"; its timestamps don't drive anything. */
+      if (! strcmp (key, SVN_WC_ENTRY_THIS_DIR))
+        continue;
+
+      full_path = svn_stringbuf_dup (path, subpool);
+      svn_path_add_component_nts (full_path, key);
+
+      if (entry->kind == svn_node_dir)
+        {
+          SVN_ERR (svn_wc_stabilize (full_path, subpool));
+        }
+      else if (entry->schedule == svn_wc_schedule_normal)
+        {
+          svn_boolean_t equal_timestamps, modified;
+          enum svn_node_kind kind;
+          svn_stringbuf_t *base_path;
+          svn_wc_entry_t tmp_entry;
+          apr_uint32_t modify_flags;
+          apr_time_t text_time;
+
+          /* We need both a working file and a text-base to compare. */
+          SVN_ERR (svn_io_check_path (full_path->data, &kind, subpool));
+          if (kind != svn_node_file)
+            {
+              svn_pool_clear (subpool);
+              continue;
+            }
+          base_path = svn_wc__text_base_path (full_path, 0, subpool);
+          SVN_ERR (svn_io_check_path (base_path->data, &kind, subpool));
+          if (kind != svn_node_file)
+            {
+              svn_pool_clear (subpool);
+              continue;
+            }
+
+          /* If the timestamp (and recorded size) already match and a
+             checksum is on record, there's nothing to repair. */
+          SVN_ERR (svn_wc__timestamps_equal_p (&equal_timestamps, full_path,
+                                               svn_wc__text_time, subpool));
+          if (equal_timestamps && entry->checksum && entry->text_size)
+            {
+              svn_pool_clear (subpool);
+              continue;
+            }
+
+          /* A genuinely modified file keeps its untrustworthy
+             timestamp; it will get a fresh one when it is committed. */
+          SVN_ERR (svn_wc_text_modified_p (&modified, full_path, subpool));
+          if (! modified)
+            {
+              memset (&tmp_entry, 0, sizeof (tmp_entry));
+              tmp_entry.kind = svn_node_file;
+              modify_flags = 0;
+
+              if (! equal_timestamps)
+                {
+                  /* Put the timestamp through the same string
+                     round-trip the comparison uses, so the repaired
+                     value really does compare equal next time. */
+                  SVN_ERR (svn_io_file_affected_time (&text_time, full_path,
+                                                      subpool));
+                  tmp_entry.text_time
+                    = svn_time_from_nts (svn_time_to_nts (text_time,
+                                                          subpool));
+                  modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_TIME;
+                }
+
+              /* Record the working size the (now-trusted) stamp
+                 pairs with. */
+              SVN_ERR (svn_io_file_size (&tmp_entry.text_size,
+                                         full_path->data, subpool));
+              if (tmp_entry.text_size != entry->text_size)
+                modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_SIZE;
+
+              if (! entry->checksum)
+                {
+                  SVN_ERR (svn_io_file_checksum (&tmp_entry.checksum,
+                                                 base_path->data, subpool));
+                  modify_flags |= SVN_WC__ENTRY_MODIFY_CHECKSUM;
+                }
+
+              if (modify_flags)
+                SVN_ERR (svn_wc__entry_modify
+                         (path, svn_stringbuf_create (key, subpool),
+                          &tmp_entry, modify_flags, subpool));
+            }
+        }
+
+      svn_pool_clear (subpool);
+    }
+
+  svn_pool_destroy (subpool);
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc_get_pristine_copy_path (svn_stringbuf_t *path,
                                svn_stringbuf_t **pristine_path,
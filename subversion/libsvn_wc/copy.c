@@ -189,18 +189,22 @@ copy_file_administratively (svn_stringbuf_t *src_path,
     SVN_ERR (svn_wc__prop_path (&dst_wprop, dst_path, 0, pool));
     SVN_ERR (svn_wc__prop_base_path (&dst_bprop, dst_path, 0, pool));
 
-    /* Copy the text-base over unconditionally. */
-    SVN_ERR (svn_io_copy_file (src_txtb->data, dst_txtb->data, TRUE, pool));
+    /* Share the text-base unconditionally.  Pristines are only ever
+       replaced by rename, never modified in place, so the two names
+       can point at the same bytes until one side gets a new base. */
+    SVN_ERR (svn_io_link_or_copy_file (src_txtb->data, dst_txtb->data, pool));
 
     /* Copy the props over if they exist. */
     SVN_ERR (svn_io_check_path (src_wprop->data, &kind, pool));
     if (kind == svn_node_file)
       SVN_ERR (svn_io_copy_file (src_wprop->data, dst_wprop->data, TRUE, pool));
       
-    /* Copy the base-props over if they exist */
+    /* Share the base-props if they exist; like the text-base, they
+       only ever change by rename. */
     SVN_ERR (svn_io_check_path (src_bprop->data, &kind, pool));
     if (kind == svn_node_file)
-      SVN_ERR (svn_io_copy_file (src_bprop->data, dst_bprop->data, TRUE, pool));
+      SVN_ERR (svn_io_link_or_copy_file (src_bprop->data, dst_bprop->data,
+                                         pool));
   }
 
   /* Schedule the new file for addition in its parent, WITH HISTORY. */
@@ -221,6 +225,128 @@ copy_file_administratively (svn_stringbuf_t *src_path,
 
 
 
+/* Where a directory being copied stands relative to an administrative
+   area; see copy_versioned_dir. */
+enum adm_depth
+{
+  adm_depth_outside,    /* an ordinary working copy directory */
+  adm_depth_adm,        /* an administrative directory itself */
+  adm_depth_pristine    /* text-base or prop-base inside one */
+};
+
+
+/* Copy the directory SRC_PATH into DST_PARENT as DST_BASENAME, just
+   like svn_io_copy_dir_recursively, except that pristine files ---
+   the ones under an administrative area's text-base and prop-base
+   directories --- are shared with the source via
+   svn_io_link_or_copy_file instead of duplicated.  Pristines are only
+   ever replaced by rename, so a shared one stops being shared the
+   moment either side installs a new base; until then the copy of a
+   large tree costs directory metadata, not file data.
+
+   DEPTH says where SRC_PATH itself stands relative to an
+   administrative area; top-level callers pass adm_depth_outside. */
+static svn_error_t *
+copy_versioned_dir (svn_stringbuf_t *src_path,
+                    svn_stringbuf_t *dst_parent,
+                    svn_stringbuf_t *dst_basename,
+                    enum adm_depth depth,
+                    apr_pool_t *pool)
+{
+  enum svn_node_kind kind;
+  apr_status_t status;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_stringbuf_t *src_target, *dst_target;
+  apr_pool_t *subpool = svn_pool_create (pool);
+
+  svn_stringbuf_t *dst_path = svn_stringbuf_dup (dst_parent, pool);
+  svn_path_add_component (dst_path, dst_basename);
+
+  SVN_ERR (svn_io_check_path (dst_path->data, &kind, subpool));
+  if (kind != svn_node_none)
+    return svn_error_createf (SVN_ERR_ENTRY_EXISTS, 0, NULL, subpool,
+                              "'%s' already exists.", dst_path->data);
+
+  /* Create the new directory. */
+  status = apr_dir_make (dst_path->data, APR_OS_DEFAULT, pool);
+  if (status)
+    return svn_error_createf (status, 0, NULL, pool,
+                              "Unable to create directory '%s'",
+                              dst_path->data);
+
+  /* Loop over the dirents in SRC_PATH.  ('.' and '..' are
+     auto-excluded) */
+  SVN_ERR (svn_io_get_dirents (&dirents, src_path, subpool));
+
+  src_target = svn_stringbuf_dup (src_path, subpool);
+  dst_target = svn_stringbuf_dup (dst_path, subpool);
+
+  for (hi = apr_hash_first (subpool, dirents); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      apr_ssize_t klen;
+      void *val;
+      const char *entryname;
+      enum svn_node_kind *entrykind;
+
+      apr_hash_this (hi, &key, &klen, &val);
+      entryname = (char *) key;
+      entrykind = (enum svn_node_kind *) val;
+
+      /* Telescope the entryname onto the source dir. */
+      svn_path_add_component_nts (src_target, entryname);
+
+      if (*entrykind == svn_node_file)
+        {
+          svn_path_add_component_nts (dst_target, entryname);
+
+          if (depth == adm_depth_pristine)
+            SVN_ERR (svn_io_link_or_copy_file (src_target->data,
+                                               dst_target->data,
+                                               subpool));
+          else
+            SVN_ERR (svn_io_copy_file (src_target->data, dst_target->data,
+                                       TRUE, subpool));
+
+          svn_path_remove_component (dst_target);
+        }
+
+      else if (*entrykind == svn_node_dir)
+        {
+          enum adm_depth child_depth;
+
+          if (depth == adm_depth_outside)
+            child_depth = (strcmp (entryname, SVN_WC_ADM_DIR_NAME) == 0)
+                          ? adm_depth_adm : adm_depth_outside;
+          else if (depth == adm_depth_adm)
+            /* Only the adm area's own text-base and prop-base hold
+               pristines; its tmp/ mirror of them holds scratch files
+               that do get written in place, so those are copied. */
+            child_depth = ((strcmp (entryname, SVN_WC__ADM_TEXT_BASE) == 0)
+                           || (strcmp (entryname, SVN_WC__ADM_PROP_BASE) == 0))
+                          ? adm_depth_pristine : adm_depth_outside;
+          else
+            child_depth = depth;
+
+          SVN_ERR (copy_versioned_dir (src_target,
+                                       dst_target,
+                                       svn_stringbuf_create (entryname,
+                                                             subpool),
+                                       child_depth,
+                                       subpool));
+        }
+
+      /* De-telescope the source dir for the next iteration. */
+      svn_path_remove_component (src_target);
+    }
+
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* This function effectively creates and schedules a dir for
    addition, but does extra administrative things to allow it to
    function as a 'copy'.
@@ -261,9 +387,11 @@ copy_dir_administratively (svn_stringbuf_t *src_path,
   /* Recursively copy the whole directory over. 
      
       (This gets us all text-base, props, base-props, as well as entries,
-      local mods, schedulings, existences, etc.) */
-  SVN_ERR (svn_io_copy_dir_recursively (src_path, dst_parent, dst_basename,
-                                        TRUE, pool));
+      local mods, schedulings, existences, etc.  The pristine files
+      come over as shared hard links where possible, so this costs
+      metadata, not a second copy of every file's data.) */
+  SVN_ERR (copy_versioned_dir (src_path, dst_parent, dst_basename,
+                               adm_depth_outside, pool));
 
   /* Remove all wcprops in the directory, because they're all bogus
      now.  After the commit, ra_dav should regenerate them and
@@ -19,7 +19,12 @@
 
 
 #include <string.h>
+#include <stdlib.h>             /* for qsort() */
 #include <apr_strings.h>
+#include <apr_file_io.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
 #include <assert.h>
 #include "svn_xml.h"
 #include "svn_error.h"
@@ -52,6 +57,35 @@
 #define SVN_WC__ENTRY_VALUE_DELETE     "delete"
 #define SVN_WC__ENTRY_VALUE_REPLACE    "replace"
 
+/* Expand to the two key arguments apr_hash wants for a string
+   literal: the literal itself and its compile-time length.  An entry
+   is taken apart and put together one attribute lookup at a time, and
+   APR_HASH_KEY_STRING would re-strlen the attribute name on every
+   single one of them.  */
+#define LITERAL_KEY(k)  k, (sizeof (k) - 1)
+
+
+
+/*** The entries-mods journal ***/
+
+/* Rewriting a directory's whole `entries' file to change one entry
+   gets expensive in big directories --- an update serializes every
+   entry's XML once per file it touches.  So svn_wc__entry_modify
+   appends the changed entry to an `entries-mods' journal instead,
+   and readers replay the journal on top of the entries file.
+
+   The journal's first record names the generation stamp of the
+   entries file it was appended against; a journal whose stamp
+   doesn't match is a leftover from an interrupted rewrite (whose
+   records are already folded in) and is ignored.  Any full write of
+   the entries file removes the journal, and entry_modify folds the
+   journal back in itself once it grows past the threshold below, so
+   replaying it stays cheap.  */
+
+/* When the journal grows past this many bytes, fold it back into the
+   entries file rather than appending further. */
+#define SVN_WC__ENTRIES_MODS_MAX_SIZE  16384
+
 
 
 /*** Initialization of the entries file. ***/
@@ -132,6 +166,18 @@ struct entries_accumulator
   /* The parser that's parsing it, for signal_expat_bailout(). */
   svn_xml_parser_t *parser;
 
+  /* The value of the toplevel form's generation attribute, if any. */
+  svn_stringbuf_t *generation;
+
+  /* While replaying an entries-mods journal: TRUE iff the journal's
+     generation stamp failed to match the entries file's, meaning all
+     of its records are to be ignored. */
+  svn_boolean_t mods_stale;
+
+  /* Interned attribute names and short attribute values, shared by
+     every entry parsed in this run; see interned_att_hash(). */
+  apr_hash_t *atoms;
+
   /* Don't leave home without one. */
   apr_pool_t *pool;
 };
@@ -161,14 +207,14 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   *modify_flags = 0;
 
   /* Find the name and set up the entry under that name. */
-  name = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_NAME, APR_HASH_KEY_STRING);
+  name = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_NAME));
   entry->name = name ? name 
                      : svn_stringbuf_create (SVN_WC_ENTRY_THIS_DIR, pool);
 
   /* Attempt to set revision (resolve_to_defaults may do it later, too) */
   {
     svn_stringbuf_t *revision_str
-      = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_REVISION, APR_HASH_KEY_STRING);
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_REVISION));
 
     if (revision_str)
       {
@@ -182,7 +228,7 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   /* Attempt to set up url path (again, see resolve_to_defaults). */
   {
     entry->url
-      = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_URL, APR_HASH_KEY_STRING);
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_URL));
 
     if (entry->url)
       *modify_flags |= SVN_WC__ENTRY_MODIFY_URL;
@@ -191,7 +237,7 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   /* Set up kind. */
   {
     svn_stringbuf_t *kindstr
-      = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_KIND, APR_HASH_KEY_STRING);
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_KIND));
 
     entry->kind = svn_node_none;
     if (kindstr)
@@ -212,7 +258,7 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   /* Look for a schedule attribute on this entry. */
   {
     svn_stringbuf_t *schedulestr
-      = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_SCHEDULE, APR_HASH_KEY_STRING);
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_SCHEDULE));
     
     entry->schedule = svn_wc_schedule_normal;
     if (schedulestr)
@@ -239,23 +285,19 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   /* Is this entry in a state of mental torment (conflict)? */
   {
     if ((entry->prejfile 
-         = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_PREJFILE, 
-                         APR_HASH_KEY_STRING)))
+         = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_PREJFILE))))
       *modify_flags |= SVN_WC__ENTRY_MODIFY_PREJFILE;
 
     if ((entry->conflict_old 
-         = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CONFLICT_OLD, 
-                         APR_HASH_KEY_STRING)))
+         = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_OLD))))
       *modify_flags |= SVN_WC__ENTRY_MODIFY_CONFLICT_OLD;
 
     if ((entry->conflict_new 
-         = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CONFLICT_NEW, 
-                         APR_HASH_KEY_STRING)))
+         = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_NEW))))
       *modify_flags |= SVN_WC__ENTRY_MODIFY_CONFLICT_NEW;
 
     if ((entry->conflict_wrk 
-         = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CONFLICT_WRK, 
-                         APR_HASH_KEY_STRING)))
+         = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_WRK))))
       *modify_flags |= SVN_WC__ENTRY_MODIFY_CONFLICT_WRK;
   }
 
@@ -263,8 +305,7 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   {
     svn_stringbuf_t *copiedstr, *revstr;
       
-    copiedstr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_COPIED, 
-                              APR_HASH_KEY_STRING);
+    copiedstr = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPIED));
         
     entry->copied = FALSE;
     if (copiedstr)
@@ -285,11 +326,11 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
         *modify_flags |= SVN_WC__ENTRY_MODIFY_COPIED;
       }
 
-    entry->copyfrom_url = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_COPYFROM_URL,
-                                        APR_HASH_KEY_STRING);
+    entry->copyfrom_url
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPYFROM_URL));
 
-    revstr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_COPYFROM_REV, 
-                           APR_HASH_KEY_STRING);
+    revstr
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPYFROM_REV));
     if (revstr)
       entry->copyfrom_rev = SVN_STR_TO_REV (revstr->data);
     
@@ -298,10 +339,10 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
 
   /* Attempt to set up timestamps. */
   {
-    svn_stringbuf_t *text_timestr, *prop_timestr;
+    svn_stringbuf_t *text_timestr, *text_sizestr, *prop_timestr;
     
-    text_timestr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_TEXT_TIME,
-                                 APR_HASH_KEY_STRING);
+    text_timestr
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_TEXT_TIME));
     if (text_timestr)
       {
         if (! strcmp (text_timestr->data, SVN_WC_TIMESTAMP_WC))
@@ -317,8 +358,16 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
         *modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_TIME;
       }
     
-    prop_timestr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_PROP_TIME,
-                                 APR_HASH_KEY_STRING);
+    text_sizestr
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_TEXT_SIZE));
+    if (text_sizestr)
+      {
+        entry->text_size = (apr_off_t) apr_atoi64 (text_sizestr->data);
+        *modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_SIZE;
+      }
+
+    prop_timestr
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_PROP_TIME));
     if (prop_timestr)
       {
         if (! strcmp (prop_timestr->data, SVN_WC_TIMESTAMP_WC))
@@ -335,12 +384,17 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
       }
   }
 
+  /* Does this entry have a checksum of its text-base? */
+  if ((entry->checksum
+       = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CHECKSUM))))
+    *modify_flags |= SVN_WC__ENTRY_MODIFY_CHECKSUM;
+
   /* Setup last-committed values. */
   {
     svn_stringbuf_t *cmt_datestr, *cmt_revstr;
     
-    cmt_datestr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CMT_DATE,
-                                APR_HASH_KEY_STRING);
+    cmt_datestr
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_DATE));
     if (cmt_datestr)
       {
         entry->cmt_date = svn_time_from_nts (cmt_datestr->data);
@@ -349,8 +403,7 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
     else
       entry->cmt_date = 0;
 
-    cmt_revstr = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CMT_REV,
-                               APR_HASH_KEY_STRING);
+    cmt_revstr = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_REV));
     if (cmt_revstr)
       {
         entry->cmt_rev = SVN_STR_TO_REV (cmt_revstr->data);
@@ -359,8 +412,8 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
     else
       entry->cmt_rev = SVN_INVALID_REVNUM;
 
-    entry->cmt_author = apr_hash_get (atts, SVN_WC__ENTRY_ATTR_CMT_AUTHOR,
-                                      APR_HASH_KEY_STRING);
+    entry->cmt_author
+      = apr_hash_get (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_AUTHOR));
     if (entry->cmt_author)
         *modify_flags |= SVN_WC__ENTRY_MODIFY_CMT_AUTHOR;
   }
@@ -370,7 +423,75 @@ svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
   return SVN_NO_ERROR;
 }
 
-                       
+
+/* The longest attribute value worth interning.  Node kinds, schedule
+   states, booleans and revision numbers all fit; file names, urls and
+   timestamps, which rarely repeat, generally do not. */
+#define SVN_WC__MAX_ATOM_LEN 10
+
+/* Return a stringbuf holding the LEN bytes at STR, shared with every
+   other caller in this parse run that asked for the same bytes.  The
+   atom is allocated in POOL the first time it is seen and entered
+   into ATOMS.  Callers must treat the result as read-only. */
+static svn_stringbuf_t *
+intern_atom (apr_hash_t *atoms,
+             const char *str,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *atom = apr_hash_get (atoms, str, len);
+
+  if (atom == NULL)
+    {
+      atom = svn_stringbuf_ncreate (str, len, pool);
+      apr_hash_set (atoms, atom->data, len, atom);
+    }
+
+  return atom;
+}
+
+
+/* Like svn_xml_make_att_hash, but attribute names and short
+   enum-like values are interned in ATOMS rather than duplicated
+   afresh.  An entries file repeats "kind", "file", a handful of
+   revision strings, and so on, once per entry; a 100k-entry working
+   copy would otherwise pool-duplicate each of them 100k times. */
+static apr_hash_t *
+interned_att_hash (const char **atts,
+                   apr_hash_t *atoms,
+                   apr_pool_t *pool)
+{
+  apr_hash_t *ht = apr_hash_make (pool);
+  const char *key;
+
+  if (atts)
+    for (key = *atts; key; key = *(++atts))
+      {
+        const char *val = *(++atts);
+        svn_stringbuf_t *name, *value;
+
+        name = intern_atom (atoms, key, strlen (key), pool);
+
+        if (val == NULL)
+          value = NULL;
+        else
+          {
+            apr_size_t len = strlen (val);
+
+            /* long values are almost certainly unique to this entry,
+               so looking them up would just bloat the atom table. */
+            if (len > SVN_WC__MAX_ATOM_LEN)
+              value = svn_stringbuf_ncreate (val, len, pool);
+            else
+              value = intern_atom (atoms, val, len, pool);
+          }
+
+        apr_hash_set (ht, name->data, name->len, value);
+      }
+
+  return ht;
+}
+
 
 /* Called whenever we find an <open> tag of some kind. */
 static void
@@ -382,13 +503,24 @@ handle_start_tag (void *userData, const char *tagname, const char **atts)
   svn_error_t *err;
   apr_uint32_t modify_flags = 0;
 
-  /* We only care about the `entry' tag; all other tags, such as `xml'
-     and `wc-entries', are ignored. */
+  /* The toplevel form carries the file's generation stamp, which any
+     entries-mods journal is validated against. */
+  if (! strcmp (tagname, SVN_WC__ENTRIES_TOPLEVEL))
+    {
+      attributes = interned_att_hash (atts, accum->atoms, accum->pool);
+      accum->generation
+        = apr_hash_get (attributes,
+                        LITERAL_KEY (SVN_WC__ENTRY_ATTR_GENERATION));
+      return;
+    }
+
+  /* Other than that, we only care about the `entry' tag; tags such
+     as `xml' are ignored. */
   if (strcmp (tagname, SVN_WC__ENTRIES_ENTRY))
     return;
 
   /* Make an entry from the attributes. */
-  attributes = svn_xml_make_att_hash (atts, accum->pool);
+  attributes = interned_att_hash (atts, accum->atoms, accum->pool);
   err = svn_wc__atts_to_entry (&entry, &modify_flags, attributes, accum->pool);
   if (err)
     svn_xml_signal_bailout (err, accum->parser);
@@ -400,6 +532,64 @@ handle_start_tag (void *userData, const char *tagname, const char **atts)
 }
 
 
+/* Called whenever we find an open tag of some kind in an
+   entries-mods journal.  Journal records either replace one entry
+   wholesale or remove it. */
+static void
+handle_mods_start_tag (void *userData, const char *tagname, const char **atts)
+{
+  struct entries_accumulator *accum = userData;
+  apr_hash_t *attributes;
+  svn_wc_entry_t *entry;
+  svn_error_t *err;
+  apr_uint32_t modify_flags = 0;
+
+  /* The journal's first record says which generation of the entries
+     file it was appended against.  A mismatch means the journal is a
+     leftover from an interrupted rewrite of the entries file, whose
+     records are already folded in; ignore them all. */
+  if (! strcmp (tagname, SVN_WC__ENTRIES_MODS_FOR))
+    {
+      svn_stringbuf_t *generation;
+
+      attributes = interned_att_hash (atts, accum->atoms, accum->pool);
+      generation = apr_hash_get (attributes,
+                                 LITERAL_KEY (SVN_WC__ENTRY_ATTR_GENERATION));
+      if (((generation == NULL) != (accum->generation == NULL))
+          || (generation
+              && (! svn_stringbuf_compare (generation, accum->generation))))
+        accum->mods_stale = TRUE;
+      return;
+    }
+
+  if (accum->mods_stale)
+    return;
+
+  /* A removal record. */
+  if (! strcmp (tagname, SVN_WC__ENTRIES_MODS_DELETE))
+    {
+      svn_stringbuf_t *name;
+
+      attributes = interned_att_hash (atts, accum->atoms, accum->pool);
+      name = apr_hash_get (attributes, LITERAL_KEY (SVN_WC__ENTRY_ATTR_NAME));
+      if (name)
+        apr_hash_set (accum->entries, name->data, name->len, NULL);
+      return;
+    }
+
+  if (strcmp (tagname, SVN_WC__ENTRIES_ENTRY))
+    return;
+
+  /* A replacement record, carrying the entry's complete new state. */
+  attributes = interned_att_hash (atts, accum->atoms, accum->pool);
+  err = svn_wc__atts_to_entry (&entry, &modify_flags, attributes, accum->pool);
+  if (err)
+    svn_xml_signal_bailout (err, accum->parser);
+
+  apr_hash_set (accum->entries, entry->name->data, entry->name->len, entry);
+}
+
+
 /* Use entry SRC to fill in blank portions of entry DST.  SRC itself
    may not have any blanks, of course.
    Typically, SRC is a parent directory's own entry, and DST is some
@@ -433,7 +623,7 @@ resolve_to_defaults (apr_hash_t *entries,
 {
   apr_hash_index_t *hi;
   svn_wc_entry_t *default_entry
-    = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, APR_HASH_KEY_STRING);
+    = apr_hash_get (entries, LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
 
   /* First check the dir's own entry for consistency. */
   if (! default_entry)
@@ -497,9 +687,17 @@ resolve_to_defaults (apr_hash_t *entries,
 
 
 
-/* Fill ENTRIES according to PATH's entries file. */
+/* Fill ENTRIES according to PATH's entries file, then replay any
+   applicable entries-mods journal on top.  If GENERATION is non-null,
+   set *GENERATION to the entries file's generation stamp, or NULL if
+   it carries none.  If MODS_SIZE is non-null, set *MODS_SIZE to the
+   size in bytes of the journal, 0 if there is none, or (apr_size_t)
+   -1 if a journal exists but is a stale leftover (so callers treat
+   it as due for compaction). */
 static svn_error_t *
 read_entries (apr_hash_t *entries,
+              svn_stringbuf_t **generation,
+              apr_size_t *mods_size,
               svn_stringbuf_t *path,
               apr_pool_t *pool)
 {
@@ -518,6 +716,9 @@ read_entries (apr_hash_t *entries,
   /* Set up userData for the XML parser. */
   accum = apr_palloc (pool, sizeof (*accum));
   accum->entries = entries;
+  accum->generation = NULL;
+  accum->mods_stale = FALSE;
+  accum->atoms = apr_hash_make (pool);
   accum->pool = pool;
 
   /* Create the XML parser */
@@ -552,6 +753,66 @@ read_entries (apr_hash_t *entries,
   /* Clean up the xml parser */
   svn_xml_free_parser (svn_parser);
 
+  if (mods_size)
+    *mods_size = 0;
+
+  /* Replay the entries-mods journal, if there is one. */
+  if (svn_wc__adm_path_exists (path, FALSE, pool, SVN_WC__ADM_ENTRIES_MODS,
+                               NULL))
+    {
+      apr_size_t journal_len = 0;
+
+      SVN_ERR (svn_wc__open_adm_file (&infile, path,
+                                      SVN_WC__ADM_ENTRIES_MODS,
+                                      APR_READ, pool));
+
+      svn_parser = svn_xml_make_parser (accum,
+                                        handle_mods_start_tag,
+                                        NULL,
+                                        NULL,
+                                        pool);
+      accum->parser = svn_parser;
+
+      /* The journal is a bare sequence of records; expat wants a
+         document, so supply a wrapper around it, the way run_log
+         does for the `log' file. */
+      SVN_ERR (svn_xml_parse (svn_parser,
+                              "<" SVN_WC__ENTRIES_MODS_TOPLEVEL ">",
+                              strlen ("<" SVN_WC__ENTRIES_MODS_TOPLEVEL ">"),
+                              0));
+
+      do {
+        apr_err = apr_file_read_full (infile, buf, sizeof(buf), &bytes_read);
+        if (apr_err && !APR_STATUS_IS_EOF(apr_err))
+          return svn_error_create 
+            (apr_err, 0, NULL, pool,
+             "read_entries: apr_file_read_full choked on entries-mods");
+
+        journal_len += bytes_read;
+        err = svn_xml_parse (svn_parser, buf, bytes_read, 0);
+        if (err)
+          return svn_error_createf (err->apr_err, 0, err, pool, 
+                                    "read_entries: xml parser failed on "
+                                    "entries-mods (%s).", 
+                                    path->data);
+      } while (!APR_STATUS_IS_EOF(apr_err));
+
+      SVN_ERR (svn_xml_parse (svn_parser,
+                              "</" SVN_WC__ENTRIES_MODS_TOPLEVEL ">",
+                              strlen ("</" SVN_WC__ENTRIES_MODS_TOPLEVEL ">"),
+                              1));
+
+      SVN_ERR (svn_wc__close_adm_file (infile, path,
+                                       SVN_WC__ADM_ENTRIES_MODS, 0, pool));
+      svn_xml_free_parser (svn_parser);
+
+      if (mods_size)
+        *mods_size = accum->mods_stale ? (apr_size_t) -1 : journal_len;
+    }
+
+  if (generation)
+    *generation = accum->generation;
+
   /* Fill in any implied fields. */
   SVN_ERR (resolve_to_defaults (entries, pool));
 
@@ -559,6 +820,327 @@ read_entries (apr_hash_t *entries,
 }
 
 
+/*--------------------------------------------------------------- */
+
+/*** A cache of parsed entries files ***/
+
+/* Parsing an entries file is expensive enough that doing it over and
+   over for the same directory dominates operations like status,
+   which ask about the same directories many times in one pass.  So
+   we keep one parsed copy of each entries file per process,
+   validated against the size and mtime of the files it came from,
+   and hand callers copies of it.  svn_wc__entry_modify writes its
+   changes through to the cached copy, so journaled modifications
+   don't cost the next reader a reparse; whole-file writes just toss
+   the cached copy.
+
+   The threaded status crawl reads entries from several threads at
+   once, so readers take ENTRIES_CACHE_LOCK around every cache
+   access.  Writers (svn_wc__entry_modify and company) take it too,
+   but only to protect readers from seeing half-made cache state;
+   concurrent *writes* to one directory are already ruled out by the
+   working copy lock.  The lock is created together with the cache
+   pool, so anything that spawns threads must touch the cache once
+   from a single thread first (the status crawl primes it by reading
+   its anchor directory before starting workers).  */
+
+static apr_pool_t *entries_cache_pool = NULL;
+static apr_hash_t *entries_cache = NULL;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *entries_cache_lock = NULL;
+#endif
+
+
+/* Serialize access to the entries cache.  No-ops until the cache
+   machinery exists. */
+static void
+lock_entries_cache (void)
+{
+#if APR_HAS_THREADS
+  if (entries_cache_lock)
+    apr_thread_mutex_lock (entries_cache_lock);
+#endif
+}
+
+static void
+unlock_entries_cache (void)
+{
+#if APR_HAS_THREADS
+  if (entries_cache_lock)
+    apr_thread_mutex_unlock (entries_cache_lock);
+#endif
+}
+
+struct entries_cache_entry
+{
+  /* The parsed entries, keyed on entry name, allocated in SUBPOOL. */
+  apr_hash_t *entries;
+
+  /* The entries file's generation stamp, or null if it has none. */
+  svn_stringbuf_t *generation;
+
+  /* What read_entries reported for the entries-mods journal. */
+  apr_size_t mods_size;
+
+  /* Size and mtime of the `entries' file and of the journal when we
+     parsed them; size -1 and mtime 0 where the file didn't exist.  A
+     directory modified behind our back fails this check.  (Two
+     writes within one mtime granule leaving identical sizes would
+     fool it, but our own writes keep the cache current themselves;
+     this only guards against other processes, which the working
+     copy lock already serializes with.) */
+  apr_off_t entries_file_size;
+  apr_time_t entries_file_mtime;
+  apr_off_t mods_file_size;
+  apr_time_t mods_file_mtime;
+
+  /* The cached entries in name order, pointing at the same structs
+     as ENTRIES, or null until a reader asks for sorted entries (and
+     null again after a write-through changes ENTRIES).  One qsort
+     per parse serves every sorted visitor --- say a status crawl
+     followed by a commit harvest over the same directories. */
+  apr_array_header_t *sorted;
+
+  /* When positive, a journal batch is open on this directory (see
+     svn_wc__entries_batch_begin): svn_wc__entry_modify buffers its
+     journal records in PENDING_MODS instead of writing each one,
+     and svn_wc__entries_batch_end writes the lot in one go. */
+  int batch_depth;
+  svn_stringbuf_t *pending_mods;
+
+  /* The subpool all of the above lives in. */
+  apr_pool_t *subpool;
+};
+
+
+/* Record the current sizes and mtimes of PATH's entries file and
+   entries-mods journal in CACHE_ENTRY.  Use POOL for temporary
+   allocations. */
+static void
+stat_entries_files (struct entries_cache_entry *cache_entry,
+                    svn_stringbuf_t *path,
+                    apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_stringbuf_t *thing;
+
+  thing = svn_wc__adm_path (path, 0, pool, SVN_WC__ADM_ENTRIES, NULL);
+  if (! apr_stat (&finfo, thing->data, APR_FINFO_MIN, pool))
+    {
+      cache_entry->entries_file_size = finfo.size;
+      cache_entry->entries_file_mtime = finfo.mtime;
+    }
+  else
+    {
+      cache_entry->entries_file_size = -1;
+      cache_entry->entries_file_mtime = 0;
+    }
+
+  thing = svn_wc__adm_path (path, 0, pool, SVN_WC__ADM_ENTRIES_MODS, NULL);
+  if (! apr_stat (&finfo, thing->data, APR_FINFO_MIN, pool))
+    {
+      cache_entry->mods_file_size = finfo.size;
+      cache_entry->mods_file_mtime = finfo.mtime;
+    }
+  else
+    {
+      cache_entry->mods_file_size = -1;
+      cache_entry->mods_file_mtime = 0;
+    }
+}
+
+
+/* Set *CACHE_ENTRY_P to a current cache entry for PATH's entries,
+   parsing the files afresh if the cache has nothing usable.  Use
+   POOL only for temporary allocations; the result lives in the
+   cache's own pool. */
+static svn_error_t *
+get_cached_entries (struct entries_cache_entry **cache_entry_p,
+                    svn_stringbuf_t *path,
+                    apr_pool_t *pool)
+{
+  struct entries_cache_entry *cache_entry, current;
+  apr_pool_t *subpool;
+  svn_error_t *err;
+
+  if (entries_cache_pool == NULL)
+    {
+      entries_cache_pool = svn_pool_create (NULL);
+      entries_cache = apr_hash_make (entries_cache_pool);
+#if APR_HAS_THREADS
+      apr_thread_mutex_create (&entries_cache_lock,
+                               APR_THREAD_MUTEX_DEFAULT,
+                               entries_cache_pool);
+#endif
+    }
+
+  stat_entries_files (&current, path, pool);
+
+  cache_entry = apr_hash_get (entries_cache, path->data, path->len);
+  if (cache_entry
+      && (cache_entry->entries_file_size == current.entries_file_size)
+      && (cache_entry->entries_file_mtime == current.entries_file_mtime)
+      && (cache_entry->mods_file_size == current.mods_file_size)
+      && (cache_entry->mods_file_mtime == current.mods_file_mtime))
+    {
+      *cache_entry_p = cache_entry;
+      return SVN_NO_ERROR;
+    }
+
+  /* Toss any stale copy, and parse afresh into a new subpool. */
+  if (cache_entry)
+    {
+      apr_hash_set (entries_cache, path->data, path->len, NULL);
+      svn_pool_destroy (cache_entry->subpool);
+    }
+
+  subpool = svn_pool_create (entries_cache_pool);
+  cache_entry = apr_pcalloc (subpool, sizeof (*cache_entry));
+  cache_entry->subpool = subpool;
+  cache_entry->entries = apr_hash_make (subpool);
+
+  /* Note that the files were statted before the parse; if someone
+     modifies them underneath us, the recorded stats won't match and
+     the next lookup reparses. */
+  err = read_entries (cache_entry->entries, &cache_entry->generation,
+                      &cache_entry->mods_size, path, subpool);
+  if (err)
+    /* The error lives in SUBPOOL, so we can't destroy it here; a
+       stray subpool is the price of a failed parse. */
+    return err;
+
+  cache_entry->entries_file_size = current.entries_file_size;
+  cache_entry->entries_file_mtime = current.entries_file_mtime;
+  cache_entry->mods_file_size = current.mods_file_size;
+  cache_entry->mods_file_mtime = current.mods_file_mtime;
+
+  apr_hash_set (entries_cache,
+                apr_pstrdup (subpool, path->data), path->len,
+                cache_entry);
+
+  *cache_entry_p = cache_entry;
+  return SVN_NO_ERROR;
+}
+
+
+/* Forget anything the cache holds for PATH. */
+static void
+uncache_entries (svn_stringbuf_t *path)
+{
+  struct entries_cache_entry *cache_entry;
+
+  if (! entries_cache)
+    return;
+
+  cache_entry = apr_hash_get (entries_cache, path->data, path->len);
+  if (cache_entry)
+    {
+      apr_hash_set (entries_cache, path->data, path->len, NULL);
+      svn_pool_destroy (cache_entry->subpool);
+    }
+}
+
+
+/* Return a copy in POOL of the cached hash ENTRIES.  Callers
+   scribble on the hashes we hand out, and may keep them longer than
+   the cache keeps its own, so they never see the cache's copy. */
+static apr_hash_t *
+dup_entries (apr_hash_t *entries, apr_pool_t *pool)
+{
+  apr_hash_t *new_entries = apr_hash_make (pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      void *val;
+      svn_wc_entry_t *entry;
+
+      apr_hash_this (hi, NULL, NULL, &val);
+      entry = svn_wc_entry_dup (val, pool);
+      apr_hash_set (new_entries, entry->name->data, entry->name->len, entry);
+    }
+
+  return new_entries;
+}
+
+
+/* qsort comparator: order two svn_wc_entry_t pointers by name. */
+static int
+compare_entries_by_name (const void *a, const void *b)
+{
+  const svn_wc_entry_t *entry_a = *((const svn_wc_entry_t * const *) a);
+  const svn_wc_entry_t *entry_b = *((const svn_wc_entry_t * const *) b);
+
+  return strcmp (entry_a->name->data, entry_b->name->data);
+}
+
+
+/* Ensure CACHE_ENTRY->sorted holds CACHE_ENTRY's entries in name
+   order, building it if a write-through (or nothing yet) has left it
+   null.  Use POOL for temporary allocations.  Call this with the
+   cache lock held. */
+static void
+sort_cached_entries (struct entries_cache_entry *cache_entry,
+                     apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_array_header_t *sorted;
+
+  if (cache_entry->sorted)
+    return;
+
+  sorted = apr_array_make (cache_entry->subpool,
+                           apr_hash_count (cache_entry->entries),
+                           sizeof (svn_wc_entry_t *));
+
+  for (hi = apr_hash_first (pool, cache_entry->entries);
+       hi;
+       hi = apr_hash_next (hi))
+    {
+      void *val;
+
+      apr_hash_this (hi, NULL, NULL, &val);
+      (*((svn_wc_entry_t **) apr_array_push (sorted))) = val;
+    }
+
+  qsort (sorted->elts, sorted->nelts, sorted->elt_size,
+         compare_entries_by_name);
+
+  cache_entry->sorted = sorted;
+}
+
+
+/* As dup_entries, but also set *SORTED_P to the copies in name
+   order; the array shares its entry structs with the returned hash.
+   Call this with the cache lock held. */
+static apr_hash_t *
+dup_entries_sorted (apr_array_header_t **sorted_p,
+                    struct entries_cache_entry *cache_entry,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *new_entries = apr_hash_make (pool);
+  apr_array_header_t *sorted;
+  int i;
+
+  sort_cached_entries (cache_entry, pool);
+
+  sorted = apr_array_make (pool, cache_entry->sorted->nelts,
+                           sizeof (svn_wc_entry_t *));
+  for (i = 0; i < cache_entry->sorted->nelts; i++)
+    {
+      svn_wc_entry_t *entry
+        = APR_ARRAY_IDX (cache_entry->sorted, i, svn_wc_entry_t *);
+
+      entry = svn_wc_entry_dup (entry, pool);
+      apr_hash_set (new_entries, entry->name->data, entry->name->len, entry);
+      (*((svn_wc_entry_t **) apr_array_push (sorted))) = entry;
+    }
+
+  *sorted_p = sorted;
+  return new_entries;
+}
+
+
 svn_error_t *
 svn_wc_entry (svn_wc_entry_t **entry,
               svn_stringbuf_t *path,
@@ -591,7 +1173,7 @@ svn_wc_entry (svn_wc_entry_t **entry,
       SVN_ERR (svn_wc_entries_read (&entries, path, pool));
 
       *entry
-        = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, APR_HASH_KEY_STRING);
+        = apr_hash_get (entries, LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
     }
 
   if (! *entry)
@@ -645,8 +1227,7 @@ check_entries (apr_hash_t *entries,
   apr_hash_index_t *hi;
 
   default_entry = apr_hash_get (entries, 
-                                SVN_WC_ENTRY_THIS_DIR, 
-                                APR_HASH_KEY_STRING);
+                                LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
   if (! default_entry)
     return svn_error_createf
       (SVN_ERR_WC_CORRUPT, 0, NULL, pool,
@@ -741,26 +1322,46 @@ svn_wc_entries_read (apr_hash_t **entries,
                      svn_stringbuf_t *path,
                      apr_pool_t *pool)
 {
-  apr_hash_t *new_entries;
+  struct entries_cache_entry *cache_entry;
+  svn_error_t *err;
 
-  new_entries = apr_hash_make (pool);
+  lock_entries_cache ();
+  err = get_cached_entries (&cache_entry, path, pool);
+  if (! err)
+    *entries = dup_entries (cache_entry->entries, pool);
+  unlock_entries_cache ();
 
-  SVN_ERR (read_entries (new_entries, path, pool));
+  return err;
+}
 
-  *entries = new_entries;
-  return SVN_NO_ERROR;
+
+svn_error_t *
+svn_wc_entries_read_sorted (apr_hash_t **entries,
+                            apr_array_header_t **sorted_entries,
+                            svn_stringbuf_t *path,
+                            apr_pool_t *pool)
+{
+  struct entries_cache_entry *cache_entry;
+  svn_error_t *err;
+
+  lock_entries_cache ();
+  err = get_cached_entries (&cache_entry, path, pool);
+  if (! err)
+    *entries = dup_entries_sorted (sorted_entries, cache_entry, pool);
+  unlock_entries_cache ();
+
+  return err;
 }
 
 
-/* Append a single entry THIS_ENTRY to the string OUTPUT, using the
-   entry for "this dir" THIS_DIR for comparison/optimization.
-   Allocations are done in POOL.  */
-static svn_error_t *
-write_entry (svn_stringbuf_t **output,
-             svn_wc_entry_t *entry,
-             const char *name,
-             svn_wc_entry_t *this_dir,
-             apr_pool_t *pool)
+/* Return a hash of the XML attributes that fully describe ENTRY,
+   whose name is NAME.  Every attribute with a value is included ---
+   pruning the ones derivable through inheritance is write_entry's
+   business, not ours.  Allocations are done in POOL.  */
+static apr_hash_t *
+entry_atts (svn_wc_entry_t *entry,
+            const char *name,
+            apr_pool_t *pool)
 {
   apr_hash_t *atts = apr_hash_make (pool);
   svn_stringbuf_t *valuestr;
@@ -771,17 +1372,17 @@ write_entry (svn_stringbuf_t **output,
 
   /* Name */
   entry->name = svn_stringbuf_create (name, pool);
-  apr_hash_set (atts, SVN_WC__ENTRY_ATTR_NAME, APR_HASH_KEY_STRING, 
+  apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_NAME), 
                 entry->name);
 
   /* Revision */
   if (SVN_IS_VALID_REVNUM (entry->revision))
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_REVISION, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_REVISION),
                   svn_stringbuf_createf (pool, "%ld", entry->revision));
   
   /* URL */
   if (entry->url)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_URL, APR_HASH_KEY_STRING, 
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_URL), 
                   entry->url);
   
   /* Kind */
@@ -801,7 +1402,7 @@ write_entry (svn_stringbuf_t **output,
       valuestr = svn_stringbuf_create (SVN_WC__ENTRIES_ATTR_FILE_STR, pool);
       break;
     }
-  apr_hash_set (atts, SVN_WC__ENTRY_ATTR_KIND, APR_HASH_KEY_STRING, valuestr);
+  apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_KIND), valuestr);
 
   /* Schedule */
   switch (entry->schedule)
@@ -823,69 +1424,93 @@ write_entry (svn_stringbuf_t **output,
       valuestr = NULL;
       break;
     }
-  apr_hash_set (atts, SVN_WC__ENTRY_ATTR_SCHEDULE, APR_HASH_KEY_STRING, 
+  apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_SCHEDULE), 
                 valuestr);
 
   /* Conflicts */
   if (entry->conflict_old)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CONFLICT_OLD, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_OLD),
                   entry->conflict_old);
 
   if (entry->conflict_new)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CONFLICT_NEW, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_NEW),
                   entry->conflict_new);
 
   if (entry->conflict_wrk)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CONFLICT_WRK, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CONFLICT_WRK),
                   entry->conflict_wrk);
 
   if (entry->prejfile)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_PREJFILE, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_PREJFILE),
                   entry->prejfile);
 
   /* Copy-related Stuff */
   valuestr = entry->copied ? svn_stringbuf_create ("true", pool) : NULL;
-  apr_hash_set (atts, SVN_WC__ENTRY_ATTR_COPIED, APR_HASH_KEY_STRING,
+  apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPIED),
                 valuestr);
 
   if (SVN_IS_VALID_REVNUM (entry->copyfrom_rev))
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_COPYFROM_REV, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPYFROM_REV),
                   svn_stringbuf_createf (pool, "%ld", entry->copyfrom_rev));
 
   if (entry->copyfrom_url)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_COPYFROM_URL, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_COPYFROM_URL),
                   entry->copyfrom_url);
 
   /* Timestamps */
   if (entry->text_time)
     {
       const char *timestr = svn_time_to_nts (entry->text_time, pool);
-      apr_hash_set (atts, SVN_WC__ENTRY_ATTR_TEXT_TIME, APR_HASH_KEY_STRING,
+      apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_TEXT_TIME),
                     svn_stringbuf_create (timestr, pool));
     }
+  if (entry->text_size)
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_TEXT_SIZE),
+                  svn_stringbuf_createf (pool, "%" APR_OFF_T_FMT,
+                                         entry->text_size));
   if (entry->prop_time)
     {
       const char *timestr = svn_time_to_nts (entry->prop_time, pool);
-      apr_hash_set (atts, SVN_WC__ENTRY_ATTR_PROP_TIME, APR_HASH_KEY_STRING,
+      apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_PROP_TIME),
                     svn_stringbuf_create (timestr, pool));
     }
 
+  /* Checksum */
+  if (entry->checksum)
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CHECKSUM),
+                  entry->checksum);
+
   /* Last-commit Stuff */
   if (SVN_IS_VALID_REVNUM (entry->cmt_rev))
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CMT_REV, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_REV),
                   svn_stringbuf_createf (pool, "%ld", entry->cmt_rev));
 
   if (entry->cmt_author)
-    apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CMT_AUTHOR, APR_HASH_KEY_STRING,
+    apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_AUTHOR),
                   entry->cmt_author);
 
   if (entry->cmt_date)
     {
       const char *timestr = svn_time_to_nts (entry->cmt_date, pool);
-      apr_hash_set (atts, SVN_WC__ENTRY_ATTR_CMT_DATE, APR_HASH_KEY_STRING,
+      apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_CMT_DATE),
                     svn_stringbuf_create (timestr, pool));
     }
     
+  return atts;
+}
+
+
+/* Append a single entry THIS_ENTRY to the string OUTPUT, using the
+   entry for "this dir" THIS_DIR for comparison/optimization.
+   Allocations are done in POOL.  */
+static svn_error_t *
+write_entry (svn_stringbuf_t **output,
+             svn_wc_entry_t *entry,
+             const char *name,
+             svn_wc_entry_t *this_dir,
+             apr_pool_t *pool)
+{
+  apr_hash_t *atts = entry_atts (entry, name, pool);
 
   /*** Now, remove stuff that can be derived through inheritance rules. ***/
 
@@ -913,9 +1538,9 @@ write_entry (svn_stringbuf_t **output,
         {
           /* We don't write url or revision for subdir
              entries. */
-          apr_hash_set (atts, SVN_WC__ENTRY_ATTR_REVISION, APR_HASH_KEY_STRING,
+          apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_REVISION),
                         NULL);
-          apr_hash_set (atts, SVN_WC__ENTRY_ATTR_URL, APR_HASH_KEY_STRING,
+          apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_URL),
                         NULL);
         }
       else
@@ -926,8 +1551,8 @@ write_entry (svn_stringbuf_t **output,
              the same as that of the "this dir" entry, don't out the
              revision. */
           if (entry->revision == this_dir->revision)
-            apr_hash_set (atts, SVN_WC__ENTRY_ATTR_REVISION, 
-                          APR_HASH_KEY_STRING, NULL);
+            apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_REVISION),
+                          NULL);
           
           /* If this is not the "this dir" entry, and the url is
              trivially calculable from that of the "this dir" entry,
@@ -937,8 +1562,7 @@ write_entry (svn_stringbuf_t **output,
               this_path = svn_stringbuf_dup (this_dir->url, pool);
               svn_path_add_component_nts (this_path, name);
               if (svn_stringbuf_compare (this_path, entry->url))
-                apr_hash_set (atts, SVN_WC__ENTRY_ATTR_URL,
-                              APR_HASH_KEY_STRING, NULL);
+                apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_URL), NULL);
             }
         }
     }
@@ -966,8 +1590,7 @@ svn_wc__entries_write (apr_hash_t *entries,
   svn_wc_entry_t *this_dir;
 
   /* Get a copy of the "this dir" entry for comparison purposes. */
-  this_dir = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, 
-                           APR_HASH_KEY_STRING);
+  this_dir = apr_hash_get (entries, LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
 
   /* If there is no "this dir" entry, something is wrong. */
   if (! this_dir)
@@ -981,10 +1604,18 @@ svn_wc__entries_write (apr_hash_t *entries,
                                   pool));
 
   svn_xml_make_header (&bigstr, pool);
+
+  /* Stamp this incarnation of the file.  A journal appended against
+     an older incarnation is recognized as stale by its mismatched
+     stamp. */
   svn_xml_make_open_tag (&bigstr, pool, svn_xml_normal,
                          SVN_WC__ENTRIES_TOPLEVEL,
                          "xmlns",
                          svn_stringbuf_create (SVN_XML_NAMESPACE, pool),
+                         SVN_WC__ENTRY_ATTR_GENERATION,
+                         svn_stringbuf_createf (pool, "%lu",
+                                                (unsigned long)
+                                                apr_time_now ()),
                          NULL);
 
   /* Write out "this dir" */
@@ -1025,10 +1656,116 @@ svn_wc__entries_write (apr_hash_t *entries,
   else if (err2)
     return err2;
 
+  /* Everything any journal said is now in the file proper. */
+  if (svn_wc__adm_path_exists (path, FALSE, pool, SVN_WC__ADM_ENTRIES_MODS,
+                               NULL))
+    SVN_ERR (svn_wc__remove_adm_file (path, pool, SVN_WC__ADM_ENTRIES_MODS,
+                                      NULL));
+
+  /* Any cached copy no longer reflects the files; the next reader
+     can reparse. */
+  lock_entries_cache ();
+  uncache_entries (path);
+  unlock_entries_cache ();
+
   return SVN_NO_ERROR;
 }
 
 
+/* Append one entries-mods journal record to *ACCUM (creating *ACCUM
+   if it is null).  If ENTRY is non-null, the record carries the
+   complete new state of the entry named NAME; otherwise it records
+   NAME's removal.  Allocations are done in POOL.  */
+static void
+make_mods_record (svn_stringbuf_t **accum_p,
+                  svn_stringbuf_t *name,
+                  svn_wc_entry_t *entry,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *accum = *accum_p;
+
+  if (entry)
+    {
+      apr_hash_t *atts = entry_atts (entry, name->data, pool);
+
+      /* Subdir entries never store url or revision (cf. write_entry);
+         everything else is spelled out, since the journal can't lean
+         on inheritance from a "this dir" entry whose state may have
+         moved on by the time the record is replayed. */
+      if ((entry->kind == svn_node_dir)
+          && strcmp (name->data, SVN_WC_ENTRY_THIS_DIR))
+        {
+          apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_REVISION), NULL);
+          apr_hash_set (atts, LITERAL_KEY (SVN_WC__ENTRY_ATTR_URL), NULL);
+        }
+
+      svn_xml_make_open_tag_hash (&accum, pool, svn_xml_self_closing,
+                                  SVN_WC__ENTRIES_ENTRY, atts);
+    }
+  else
+    svn_xml_make_open_tag (&accum, pool, svn_xml_self_closing,
+                           SVN_WC__ENTRIES_MODS_DELETE,
+                           SVN_WC__ENTRY_ATTR_NAME, name,
+                           NULL);
+
+  *accum_p = accum;
+}
+
+
+/* Append RECORDS (one or more records from make_mods_record) to
+   PATH's entries-mods journal, creating the journal (stamped with
+   GENERATION, which may be null) if it doesn't exist yet.  However
+   many records there are, this is one append and one sync.
+   Allocations are done in POOL.  */
+static svn_error_t *
+write_mods_records (svn_stringbuf_t *path,
+                    svn_stringbuf_t *records,
+                    svn_stringbuf_t *generation,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *accum = NULL;
+  apr_file_t *outfile = NULL;
+  apr_status_t apr_err;
+
+  /* A new journal opens by naming the generation it applies to. */
+  if (! svn_wc__adm_path_exists (path, FALSE, pool, SVN_WC__ADM_ENTRIES_MODS,
+                                 NULL))
+    {
+      if (generation)
+        svn_xml_make_open_tag (&accum, pool, svn_xml_self_closing,
+                               SVN_WC__ENTRIES_MODS_FOR,
+                               SVN_WC__ENTRY_ATTR_GENERATION, generation,
+                               NULL);
+      else
+        svn_xml_make_open_tag (&accum, pool, svn_xml_self_closing,
+                               SVN_WC__ENTRIES_MODS_FOR,
+                               NULL);
+      svn_stringbuf_appendstr (accum, records);
+    }
+  else
+    accum = records;
+
+  /* The adm machinery makes this append atomic: the journal is
+     copied to tmp, extended there, and renamed back into place. */
+  SVN_ERR (svn_wc__open_adm_file (&outfile, path, SVN_WC__ADM_ENTRIES_MODS,
+                                  (APR_WRITE | APR_CREATE | APR_APPEND),
+                                  pool));
+
+  apr_err = apr_file_write_full (outfile, accum->data, accum->len, NULL);
+  if (apr_err)
+    {
+      apr_file_close (outfile);
+      return svn_error_createf (apr_err, 0, NULL, pool,
+                                "write_mods_records: "
+                                "error writing %s's entries-mods file",
+                                path->data);
+    }
+
+  return svn_wc__close_adm_file (outfile, path, SVN_WC__ADM_ENTRIES_MODS,
+                                 1, pool);
+}
+
+
 /* Update an entry NAME in ENTRIES, according to the combination of
    entry data found in ENTRY and masked by MODIFY_FLAGS. If the entry
    already exists, the requested changes will be folded (merged) into
@@ -1087,9 +1824,18 @@ fold_entry (apr_hash_t *entries,
   if (modify_flags & SVN_WC__ENTRY_MODIFY_TEXT_TIME)
     cur_entry->text_time = entry->text_time;
 
+  if (modify_flags & SVN_WC__ENTRY_MODIFY_TEXT_SIZE)
+    cur_entry->text_size = entry->text_size;
+
   if (modify_flags & SVN_WC__ENTRY_MODIFY_PROP_TIME)
     cur_entry->prop_time = entry->prop_time;
 
+  /* Checksum */
+  if (modify_flags & SVN_WC__ENTRY_MODIFY_CHECKSUM)
+    cur_entry->checksum = entry->checksum
+                          ? svn_stringbuf_dup (entry->checksum, pool)
+                          : NULL;
+
   /* Conflict stuff */
   if (modify_flags & SVN_WC__ENTRY_MODIFY_CONFLICT_OLD)
     cur_entry->conflict_old = entry->conflict_old 
@@ -1128,7 +1874,7 @@ fold_entry (apr_hash_t *entries,
   if (cur_entry->kind != svn_node_dir)
     {
       svn_wc_entry_t *default_entry
-        = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, APR_HASH_KEY_STRING);
+        = apr_hash_get (entries, LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
       if (default_entry)
         take_from_entry (default_entry, cur_entry, pool);
     }
@@ -1208,8 +1954,7 @@ fold_scheduling (apr_hash_t *entries,
     }
 
   /* Get the default entry */
-  this_dir_entry = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, 
-                                 APR_HASH_KEY_STRING);
+  this_dir_entry = apr_hash_get (entries, LITERAL_KEY (SVN_WC_ENTRY_THIS_DIR));
 
   /* At this point, we know the following things:
 
@@ -1370,8 +2115,14 @@ svn_wc__entry_modify (svn_stringbuf_t *path,
                       apr_uint32_t modify_flags,
                       apr_pool_t *pool)
 {
+  struct entries_cache_entry *cache_entry;
   apr_hash_t *entries;
   svn_boolean_t entry_was_deleted_p = FALSE;
+  svn_boolean_t batched = FALSE;
+  svn_stringbuf_t *generation;
+  svn_stringbuf_t *record;
+  apr_size_t mods_size;
+  svn_error_t *err;
 
 
   /* ENTRY is rather necessary, and ENTRY->kind is required to be valid! */
@@ -1380,8 +2131,21 @@ svn_wc__entry_modify (svn_stringbuf_t *path,
   assert ((entry->kind == svn_node_dir) || (entry->kind == svn_node_file));
   */
 
-  /* Load PATH's whole entries file. */
-  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+  /* Get PATH's whole entries file, noting the generation stamp and
+     how big the modification journal has grown.  We fold into our
+     own copy; the cache's copy is only touched once the change has
+     made it to disk. */
+  lock_entries_cache ();
+  err = get_cached_entries (&cache_entry, path, pool);
+  if (! err)
+    {
+      entries = dup_entries (cache_entry->entries, pool);
+      generation = cache_entry->generation;
+      mods_size = cache_entry->mods_size;
+    }
+  unlock_entries_cache ();
+  if (err)
+    return err;
 
   /* Ensure that NAME is valid. */
   if (name == NULL)
@@ -1415,8 +2179,136 @@ svn_wc__entry_modify (svn_stringbuf_t *path,
   if (! entry_was_deleted_p)
     fold_entry (entries, name, modify_flags, entry, pool);
 
-  /* Sync changes to disk. */
-  return svn_wc__entries_write (entries, path, pool);
+  /* Sync the change to disk.  Appending it to the journal costs
+     bytes proportional to this one entry; but once the journal has
+     grown big enough that replaying it hurts (or it is a stale
+     leftover), fold everything back into the entries file proper. */
+  if (mods_size >= SVN_WC__ENTRIES_MODS_MAX_SIZE)
+    return svn_wc__entries_write (entries, path, pool);
+
+  record = NULL;
+  make_mods_record (&record, name,
+                    entry_was_deleted_p
+                    ? NULL
+                    : apr_hash_get (entries, name->data, name->len),
+                    pool);
+
+  /* If a journal batch is open on this directory, just buffer the
+     record; svn_wc__entries_batch_end will write the whole run with
+     one append.  (If we crash before then, the buffered records are
+     lost --- but a batch is only ever open underneath a log run, and
+     the log file survives to be replayed.)  */
+  lock_entries_cache ();
+  if (cache_entry->batch_depth > 0)
+    {
+      if (! cache_entry->pending_mods)
+        cache_entry->pending_mods
+          = svn_stringbuf_create ("", cache_entry->subpool);
+      svn_stringbuf_appendstr (cache_entry->pending_mods, record);
+      batched = TRUE;
+    }
+  unlock_entries_cache ();
+
+  if (! batched)
+    SVN_ERR (write_mods_records (path, record, generation, pool));
+
+  /* The journal (or the batch buffer) now records the change; carry
+     it into the cached copy too, so the next reader needn't replay
+     anything. */
+  lock_entries_cache ();
+  if (entry_was_deleted_p)
+    apr_hash_set (cache_entry->entries, name->data, name->len, NULL);
+  else
+    {
+      svn_wc_entry_t *new_entry
+        = svn_wc_entry_dup (apr_hash_get (entries, name->data, name->len),
+                            cache_entry->subpool);
+      apr_hash_set (cache_entry->entries,
+                    new_entry->name->data, new_entry->name->len, new_entry);
+    }
+  cache_entry->sorted = NULL;
+
+  /* Refresh the recorded stats so the cached copy still validates,
+     and note the journal's new size for the compaction check.  (A
+     buffered record changed nothing on disk.) */
+  if (! batched)
+    {
+      stat_entries_files (cache_entry, path, pool);
+      cache_entry->mods_size = (apr_size_t) cache_entry->mods_file_size;
+    }
+  unlock_entries_cache ();
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__entries_batch_begin (svn_stringbuf_t *path, apr_pool_t *pool)
+{
+  struct entries_cache_entry *cache_entry;
+  svn_error_t *err;
+
+  lock_entries_cache ();
+  err = get_cached_entries (&cache_entry, path, pool);
+  if (! err)
+    cache_entry->batch_depth++;
+  unlock_entries_cache ();
+
+  return err;
+}
+
+
+svn_error_t *
+svn_wc__entries_batch_end (svn_stringbuf_t *path, apr_pool_t *pool)
+{
+  struct entries_cache_entry *cache_entry = NULL;
+  svn_stringbuf_t *pending = NULL;
+  svn_stringbuf_t *generation = NULL;
+  apr_hash_t *entries = NULL;
+
+  lock_entries_cache ();
+
+  /* The cache entry may have vanished mid-batch: anything that
+     rewrites the whole entries file (scheduling changes, journal
+     compaction) uncaches it, and the rewrite already contained every
+     change we had buffered, so there was nothing left to flush. */
+  if (entries_cache)
+    cache_entry = apr_hash_get (entries_cache, path->data, path->len);
+
+  if (cache_entry && (cache_entry->batch_depth > 0))
+    {
+      cache_entry->batch_depth--;
+      if ((cache_entry->batch_depth == 0)
+          && cache_entry->pending_mods
+          && (cache_entry->pending_mods->len > 0))
+        {
+          pending = svn_stringbuf_dup (cache_entry->pending_mods, pool);
+          generation = cache_entry->generation;
+          cache_entry->pending_mods = NULL;
+        }
+    }
+  unlock_entries_cache ();
+
+  if (! pending)
+    return SVN_NO_ERROR;
+
+  /* One append, one sync, for the whole batch. */
+  SVN_ERR (write_mods_records (path, pending, generation, pool));
+
+  lock_entries_cache ();
+  stat_entries_files (cache_entry, path, pool);
+  cache_entry->mods_size = (apr_size_t) cache_entry->mods_file_size;
+  if (cache_entry->mods_size >= SVN_WC__ENTRIES_MODS_MAX_SIZE)
+    entries = dup_entries (cache_entry->entries, pool);
+  unlock_entries_cache ();
+
+  /* If the batch pushed the journal past the compaction threshold,
+     fold it into the entries file now rather than penalizing the
+     next modification. */
+  if (entries)
+    SVN_ERR (svn_wc__entries_write (entries, path, pool));
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1435,6 +2327,8 @@ svn_wc_entry_dup (svn_wc_entry_t *entry, apr_pool_t *pool)
     dupentry->url = svn_stringbuf_dup (entry->url, pool);
   if (entry->copyfrom_url)
     dupentry->copyfrom_url = svn_stringbuf_dup (entry->copyfrom_url, pool);
+  if (entry->checksum)
+    dupentry->checksum = svn_stringbuf_dup (entry->checksum, pool);
   if (entry->conflict_old)
     dupentry->conflict_old = svn_stringbuf_dup (entry->conflict_old, pool);
   if (entry->conflict_new)
@@ -1459,7 +2353,7 @@ svn_wc__tweak_entry (apr_hash_t *entries,
 {
   svn_wc_entry_t *entry;
 
-  entry = apr_hash_get (entries, name->data, APR_HASH_KEY_STRING);
+  entry = apr_hash_get (entries, name->data, name->len);
   if (! entry)
     return svn_error_createf (SVN_ERR_ENTRY_NOT_FOUND, 0, NULL, pool,
                               "No such entry: '%s'", name->data);
@@ -33,6 +33,13 @@ extern "C" {
 #define SVN_WC__ENTRIES_TOPLEVEL       "wc-entries"
 #define SVN_WC__ENTRIES_ENTRY          "entry"
 
+/* Tags in the `entries-mods' journal (see entries.c).  The journal
+   is a bare sequence of records; readers supply the toplevel
+   wrapper themselves. */
+#define SVN_WC__ENTRIES_MODS_TOPLEVEL  "wc-entries-mods"
+#define SVN_WC__ENTRIES_MODS_FOR       "mods-for"
+#define SVN_WC__ENTRIES_MODS_DELETE    "delete-entry"
+
 /* String representations for svn_node_kind.  This maybe should be
    abstracted farther out? */
 #define SVN_WC__ENTRIES_ATTR_FILE_STR   "file"
@@ -47,8 +54,9 @@ extern "C" {
 #define SVN_WC__ENTRY_ATTR_URL           "url"
 #define SVN_WC__ENTRY_ATTR_KIND          "kind"
 #define SVN_WC__ENTRY_ATTR_TEXT_TIME     "text-time"
+#define SVN_WC__ENTRY_ATTR_TEXT_SIZE     "text-size"
 #define SVN_WC__ENTRY_ATTR_PROP_TIME     "prop-time"
-#define SVN_WC__ENTRY_ATTR_CHECKSUM      "checksum"     /* ### not used */
+#define SVN_WC__ENTRY_ATTR_CHECKSUM      "checksum"     /* of text-base */
 #define SVN_WC__ENTRY_ATTR_SCHEDULE      "schedule"
 #define SVN_WC__ENTRY_ATTR_COPIED        "copied"
 #define SVN_WC__ENTRY_ATTR_COPYFROM_URL  "copyfrom-url"
@@ -61,6 +69,11 @@ extern "C" {
 #define SVN_WC__ENTRY_ATTR_CMT_DATE      "committed-date"
 #define SVN_WC__ENTRY_ATTR_CMT_AUTHOR    "last-author"
 
+/* Not an entry attribute: carried by the toplevel form (and by
+   `mods-for' journal records) to tie a journal to the incarnation of
+   the entries file it was appended against. */
+#define SVN_WC__ENTRY_ATTR_GENERATION    "generation"
+
 
 
 /* Initialize an entries file based on URL, in th adm area for
@@ -108,6 +121,7 @@ svn_error_t *svn_wc__atts_to_entry (svn_wc_entry_t **new_entry,
 #define SVN_WC__ENTRY_MODIFY_CMT_REV       0x00004000
 #define SVN_WC__ENTRY_MODIFY_CMT_DATE      0x00008000
 #define SVN_WC__ENTRY_MODIFY_CMT_AUTHOR    0x00010000
+#define SVN_WC__ENTRY_MODIFY_TEXT_SIZE     0x00020000
 
 
 /* ...or perhaps this to mean all of those above... */
@@ -141,6 +155,20 @@ svn_error_t *svn_wc__entry_modify (svn_stringbuf_t *path,
                                    apr_uint32_t modify_flags,
                                    apr_pool_t *pool);
 
+
+/* Open (and later close) a journal batch on the directory PATH.
+   While a batch is open, svn_wc__entry_modify buffers its journal
+   records in memory instead of appending each one to the entries-mods
+   file; svn_wc__entries_batch_end writes everything buffered with a
+   single append.  Batches nest.  Used by the log runner, which may
+   modify thousands of entries in one go --- and whose log file
+   survives a crash to be replayed, so buffered records are never the
+   only copy of anything.  Perform temporary allocations in POOL.  */
+svn_error_t *svn_wc__entries_batch_begin (svn_stringbuf_t *path,
+                                          apr_pool_t *pool);
+svn_error_t *svn_wc__entries_batch_end (svn_stringbuf_t *path,
+                                        apr_pool_t *pool);
+
 /* Remove entry NAME from ENTRIES, unconditionally. */
 void svn_wc__entry_remove (apr_hash_t *entries, svn_stringbuf_t *name);
 
@@ -17,19 +17,109 @@
  */
 
 
-
+
 #include <apr_pools.h>
 #include <apr_time.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
 
+#include "svn_pools.h"
+#include "svn_path.h"
 #include "wc.h"
 #include "adm_files.h"
 
 
-
+
+/*** The held-locks table. ***/
+
+/* The locks this process already holds, keyed on directory path; each
+   value counts how many times the holder has asked for the lock.
+
+   Recursive operations lock the same directories over and over --- the
+   update editor, for one, locks a file's parent around every single
+   file it installs.  With this table, re-acquiring a lock we already
+   hold is a hash lookup instead of a file creation, and releasing it
+   is a decrement instead of a file removal.  The lock file itself
+   remains the protocol between processes; the table only keeps one
+   process from fighting with itself.
+
+   svn_wc_lock_tree uses this to take a whole subtree's locks in one
+   pass up front, turning every per-directory lock/unlock cycle inside
+   the operation into a pair of table hits.
+
+   Like the entries cache (see entries.c), the table is process-wide
+   and its mutex is created along with it, so a caller that spawns
+   threads must have taken at least one lock from a single thread
+   first.  The update editor's install pipeline qualifies: its worker
+   only runs after the main thread has locked the anchor. */
+static apr_pool_t *held_locks_pool = NULL;
+static apr_hash_t *held_locks = NULL;
+
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *held_locks_lock = NULL;
+#endif /* APR_HAS_THREADS */
+
+
+/* Serialize access to the held-locks table.  No-ops until the table
+   exists or when apr has no thread support. */
+static void
+lock_lock_table (void)
+{
+#if APR_HAS_THREADS
+  if (held_locks_lock)
+    apr_thread_mutex_lock (held_locks_lock);
+#endif /* APR_HAS_THREADS */
+}
+
+static void
+unlock_lock_table (void)
+{
+#if APR_HAS_THREADS
+  if (held_locks_lock)
+    apr_thread_mutex_unlock (held_locks_lock);
+#endif /* APR_HAS_THREADS */
+}
+
+
+/* Return the held count recorded for PATH, or NULL if this process
+   does not hold PATH's lock.  Create the table on first use.  Call
+   with the table locked. */
+static int *
+get_held_count (svn_stringbuf_t *path)
+{
+  if (! held_locks)
+    {
+      held_locks_pool = svn_pool_create (NULL);
+      held_locks = apr_hash_make (held_locks_pool);
+#if APR_HAS_THREADS
+      apr_thread_mutex_create (&held_locks_lock, APR_THREAD_MUTEX_DEFAULT,
+                               held_locks_pool);
+#endif /* APR_HAS_THREADS */
+    }
+
+  return apr_hash_get (held_locks, path->data, path->len);
+}
+
+
+
 svn_error_t *
 svn_wc_lock (svn_stringbuf_t *path, int wait_for, apr_pool_t *pool)
 {
   svn_error_t *err;
+  int *count;
+
+  lock_lock_table ();
+  count = get_held_count (path);
+  if (count)
+    {
+      (*count)++;
+      unlock_lock_table ();
+      return SVN_NO_ERROR;
+    }
+  unlock_lock_table ();
 
   do {
     err = svn_wc__make_adm_thing (path, SVN_WC__ADM_LOCK,
@@ -41,18 +131,65 @@ svn_wc_lock (svn_stringbuf_t *path, int wait_for, apr_pool_t *pool)
         wait_for--;
       }
     else
-      return SVN_NO_ERROR;
+      {
+        if (! err)
+          {
+            /* The lock is ours; remember that, so reacquisitions are
+               cheap.  The count lives as long as the process, which
+               is fine --- it's an int per directory ever locked. */
+            lock_lock_table ();
+            count = apr_palloc (held_locks_pool, sizeof (*count));
+            *count = 1;
+            apr_hash_set (held_locks,
+                          apr_pstrdup (held_locks_pool, path->data),
+                          path->len, count);
+            unlock_lock_table ();
+          }
+        return SVN_NO_ERROR;
+      }
   } while (wait_for > 0);
 
-  return svn_error_createf (SVN_ERR_WC_LOCKED, 0, NULL, pool, 
-                            "working copy locked: %s", path->data); 
+  return svn_error_createf (SVN_ERR_WC_LOCKED, 0, NULL, pool,
+                            "working copy locked: %s", path->data);
 }
 
 
 svn_error_t *
 svn_wc_unlock (svn_stringbuf_t *path, apr_pool_t *pool)
 {
-  return svn_wc__remove_adm_file (path, pool, SVN_WC__ADM_LOCK, NULL);
+  svn_error_t *err;
+  int *count;
+  svn_boolean_t was_held = FALSE;
+
+  lock_lock_table ();
+  count = get_held_count (path);
+  if (count)
+    {
+      if (*count > 1)
+        {
+          /* Someone above us still holds this lock. */
+          (*count)--;
+          unlock_lock_table ();
+          return SVN_NO_ERROR;
+        }
+
+      was_held = TRUE;
+      apr_hash_set (held_locks, path->data, path->len, NULL);
+    }
+  unlock_lock_table ();
+
+  err = svn_wc__remove_adm_file (path, pool, SVN_WC__ADM_LOCK, NULL);
+  if (err && was_held)
+    {
+      /* The directory may have left revision control out from under
+         our lock --- an update that deletes a subtree removes its
+         whole administrative area, lock file and all.  The lock is
+         as released as it's going to get. */
+      svn_error_clear_all (err);
+      return SVN_NO_ERROR;
+    }
+
+  return err;
 }
 
 
@@ -60,9 +197,9 @@ svn_error_t *
 svn_wc_locked (svn_boolean_t *locked, svn_stringbuf_t *path, apr_pool_t *pool)
 {
   svn_node_kind_t kind;
-  svn_stringbuf_t *lockfile 
+  svn_stringbuf_t *lockfile
     = svn_wc__adm_path (path, 0, pool, SVN_WC__ADM_LOCK, NULL);
-                                             
+
   SVN_ERR (svn_io_check_path (lockfile->data, &kind, pool));
   if (kind == svn_node_file)
     *locked = 1;
@@ -73,13 +210,131 @@ svn_wc_locked (svn_boolean_t *locked, svn_stringbuf_t *path, apr_pool_t *pool)
                               "svn_wc__locked: "
                               "lock file is not a regular file (%s)",
                               path->data);
-    
+
   return SVN_NO_ERROR;
 }
 
 
-
-/* 
+
+/*** Tree locks. ***/
+
+svn_error_t *
+svn_wc_lock_tree (svn_stringbuf_t *path, int wait_for, apr_pool_t *pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+  apr_array_header_t *subdirs;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR (svn_wc_lock (path, wait_for, pool));
+
+  err = svn_wc_entries_read (&entries, path, pool);
+  if (err)
+    {
+      svn_error_t *unlock_err = svn_wc_unlock (path, pool);
+      if (unlock_err)
+        svn_error_clear_all (unlock_err);
+      return err;
+    }
+
+  subdirs = apr_array_make (pool, 1, sizeof (svn_stringbuf_t *));
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      apr_ssize_t keylen;
+      void *val;
+      svn_wc_entry_t *entry;
+
+      apr_hash_this (hi, &key, &keylen, &val);
+      entry = val;
+
+      if ((entry->kind != svn_node_dir)
+          || (strcmp (key, SVN_WC_ENTRY_THIS_DIR) == 0))
+        continue;
+
+      {
+        svn_stringbuf_t *subdir = svn_stringbuf_dup (path, pool);
+        svn_path_add_component_nts (subdir, key);
+        *((svn_stringbuf_t **) apr_array_push (subdirs)) = subdir;
+      }
+    }
+
+  for (i = 0; i < subdirs->nelts; i++)
+    {
+      err = svn_wc_lock_tree (((svn_stringbuf_t **) subdirs->elts)[i],
+                              wait_for, pool);
+      if (err)
+        break;
+    }
+
+  if (err)
+    {
+      /* Let go of everything we took on the way in, but hand back the
+         original error; a failed unlock here is the lesser problem. */
+      svn_error_t *unlock_err;
+      int j;
+
+      for (j = 0; j < i; j++)
+        {
+          unlock_err
+            = svn_wc_unlock_tree (((svn_stringbuf_t **) subdirs->elts)[j],
+                                  pool);
+          if (unlock_err)
+            svn_error_clear_all (unlock_err);
+        }
+      unlock_err = svn_wc_unlock (path, pool);
+      if (unlock_err)
+        svn_error_clear_all (unlock_err);
+
+      return err;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc_unlock_tree (svn_stringbuf_t *path, apr_pool_t *pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+  svn_boolean_t locked;
+
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      apr_ssize_t keylen;
+      void *val;
+      svn_wc_entry_t *entry;
+      svn_stringbuf_t *subdir;
+
+      apr_hash_this (hi, &key, &keylen, &val);
+      entry = val;
+
+      if ((entry->kind != svn_node_dir)
+          || (strcmp (key, SVN_WC_ENTRY_THIS_DIR) == 0))
+        continue;
+
+      subdir = svn_stringbuf_dup (path, pool);
+      svn_path_add_component_nts (subdir, key);
+      SVN_ERR (svn_wc_unlock_tree (subdir, pool));
+    }
+
+  /* A directory the operation added under the tree lock was locked
+     and unlocked on its own; don't try to unlock it twice. */
+  SVN_ERR (svn_wc_locked (&locked, path, pool));
+  if (! locked)
+    return SVN_NO_ERROR;
+
+  return svn_wc_unlock (path, pool);
+}
+
+
+
+/*
  * local variables:
  * eval: (load-file "../../tools/dev/svn-dev.el")
  * end:
@@ -23,6 +23,10 @@
 #include <apr_pools.h>
 #include <apr_strings.h>
 #include <apr_thread_proc.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 #include "svn_wc.h"
 #include "svn_error.h"
@@ -499,23 +503,34 @@ log_do_modify_entry (struct log_runner *loggy,
     {
       enum svn_node_kind tfile_kind;
       apr_time_t text_time;
+      apr_off_t text_size;
 
       if (strcmp (sname->data, SVN_WC_ENTRY_THIS_DIR))
         svn_path_add_component (tfile, sname);
-      
+
       err = svn_io_check_path (tfile->data, &tfile_kind, loggy->pool);
       if (err)
         return svn_error_createf
           (SVN_ERR_WC_BAD_ADM_LOG, 0, NULL, loggy->pool,
            "error checking path `%s'", tfile->data);
-          
+
       err = svn_io_file_affected_time (&text_time, tfile, loggy->pool);
       if (err)
         return svn_error_createf
           (SVN_ERR_WC_BAD_ADM_LOG, 0, NULL, loggy->pool,
            "error getting file affected time on `%s'", tfile->data);
 
+      err = svn_io_file_size (&text_size, tfile->data, loggy->pool);
+      if (err)
+        return svn_error_createf
+          (SVN_ERR_WC_BAD_ADM_LOG, 0, NULL, loggy->pool,
+           "error getting file size on `%s'", tfile->data);
+
+      /* Record the size along with the stamp; the pair is what
+         svn_wc_text_modified_p trusts. */
       entry->text_time = text_time;
+      entry->text_size = text_size;
+      modify_flags |= SVN_WC__ENTRY_MODIFY_TEXT_SIZE;
     }
 
   /* PROP_TIME: */
@@ -624,7 +639,9 @@ log_do_committed (struct log_runner *loggy,
   apr_hash_t *entries;
   svn_wc_entry_t *entry;
   apr_time_t text_time = 0; /* By default, don't override old stamp. */
+  apr_off_t text_size = 0;  /* Ditto. */
   apr_time_t prop_time = 0; /* By default, don't override old stamp. */
+  svn_stringbuf_t *checksum = NULL; /* By default, don't override. */
   svn_node_kind_t kind;
 
   /* Determine the actual full path of the affected item. */
@@ -766,16 +783,34 @@ log_do_committed (struct log_runner *loggy,
              else use the tmpf file's timestamp. */
           chosen = same ? wf : tmpf;
 
-          /* Get the timestamp from our chosen file. */
+          /* Get the timestamp and size from our chosen file. */
           if ((err = svn_io_file_affected_time (&text_time, chosen, pool)))
             return svn_error_createf (SVN_ERR_WC_BAD_ADM_LOG, 0, err, pool,
                                       "error getting affected time: %s",
                                       chosen->data);
-                  
+          if ((err = svn_io_file_size (&text_size, chosen->data, pool)))
+            return svn_error_createf (SVN_ERR_WC_BAD_ADM_LOG, 0, err, pool,
+                                      "error getting file size: %s",
+                                      chosen->data);
+
           /* Finally, install a new `text-base' item. */
           if ((err = replace_text_base (loggy->path, name, pool)))
             return svn_error_createf (SVN_ERR_WC_BAD_ADM_LOG, 0, err, pool,
                                       "error replacing text-base: %s", name);
+
+          /* The new text-base is what modification detection will be
+             comparing against from here on; record its checksum. */
+          if ((err = svn_io_file_checksum
+               (&checksum, svn_wc__text_base_path (wf, 0, pool)->data, pool)))
+            return svn_error_createf (SVN_ERR_WC_BAD_ADM_LOG, 0, err, pool,
+                                      "error checksumming text-base: %s",
+                                      name);
+
+          /* And give it to the shared pristine store, which may
+             relink it to an existing copy of the same contents. */
+          if ((err = svn_wc__pristine_install (wf, checksum, pool)))
+            return svn_error_createf (SVN_ERR_WC_BAD_ADM_LOG, 0, err, pool,
+                                      "error storing pristine: %s", name);
         }
     }
               
@@ -843,7 +878,9 @@ log_do_committed (struct log_runner *loggy,
   entry->schedule = svn_wc_schedule_normal;
   entry->copied = FALSE;
   entry->text_time = text_time;
+  entry->text_size = text_size;
   entry->prop_time = prop_time;
+  entry->checksum = checksum;
   entry->conflict_old = NULL;
   entry->conflict_new = NULL;
   entry->conflict_wrk = NULL;
@@ -861,7 +898,10 @@ log_do_committed (struct log_runner *loggy,
                                     | SVN_WC__ENTRY_MODIFY_CONFLICT_WRK
                                     | SVN_WC__ENTRY_MODIFY_PREJFILE
                                     | SVN_WC__ENTRY_MODIFY_TEXT_TIME
+                                    | SVN_WC__ENTRY_MODIFY_TEXT_SIZE
                                     | SVN_WC__ENTRY_MODIFY_PROP_TIME
+                                    | (checksum
+                                       ? SVN_WC__ENTRY_MODIFY_CHECKSUM : 0)
                                     | SVN_WC__ENTRY_MODIFY_FORCE),
                                    pool)))
     return svn_error_createf
@@ -985,8 +1025,10 @@ start_handler (void *userData, const XML_Char *eltname, const XML_Char **atts)
 
 /*** Using the parser to run the log file. ***/
 
-svn_error_t *
-svn_wc__run_log (svn_stringbuf_t *path, apr_pool_t *pool)
+/* The guts of svn_wc__run_log: parse PATH's log file and execute its
+   commands. */
+static svn_error_t *
+run_log_commands (svn_stringbuf_t *path, apr_pool_t *pool)
 {
   svn_error_t *err;
   apr_status_t apr_err;
@@ -1048,6 +1090,32 @@ svn_wc__run_log (svn_stringbuf_t *path, apr_pool_t *pool)
 
   svn_xml_free_parser (parser);
 
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__run_log (svn_stringbuf_t *path, apr_pool_t *pool)
+{
+  svn_error_t *err, *err2;
+
+  /* A log run modifies an entry per file it touches; batch the
+     journal records so all of them hit the disk in one append
+     instead of one apiece. */
+  SVN_ERR (svn_wc__entries_batch_begin (path, pool));
+
+  err = run_log_commands (path, pool);
+
+  /* Flush the batch even if a command failed: whatever was buffered
+     reflects commands that did complete, and the log file is still
+     around to be re-run.  Only after the flush is it safe to say the
+     log's effects are durable. */
+  err2 = svn_wc__entries_batch_end (path, pool);
+  if (err)
+    return err;
+  else if (err2)
+    return err2;
+
   /* Remove the logfile;  its commands have been executed. */
   SVN_ERR (svn_wc__remove_adm_file (path, pool, SVN_WC__ADM_LOG, NULL));
 
@@ -1069,46 +1137,54 @@ svn_wc__run_log (svn_stringbuf_t *path, apr_pool_t *pool)
 
 /*** Recursively do log things. ***/
 
-svn_error_t *
-svn_wc_cleanup (svn_stringbuf_t *path,
-                apr_pool_t *pool)
+/* How many worker threads svn_wc_cleanup may replay logs with; see
+   svn_wc_set_cleanup_threads. */
+static int cleanup_num_threads = 1;
+
+void
+svn_wc_set_cleanup_threads (int num_threads)
 {
-  svn_error_t *err;
-  apr_hash_t *entries = NULL;
-  apr_hash_index_t *hi;
-  svn_stringbuf_t *log_path = svn_wc__adm_path (path, 0, pool,
-                                                SVN_WC__ADM_LOG, NULL);
-  svn_boolean_t locked;
-  enum svn_node_kind kind;
+  cleanup_num_threads = (num_threads > 0) ? num_threads : 1;
+}
 
-  /* Recurse on versioned subdirs first, oddly enough. */
-  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
 
-  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
-    {
-      const void *key;
-      apr_ssize_t keylen;
-      void *val;
-      svn_wc_entry_t *entry;
-      svn_boolean_t is_this_dir = FALSE;
+/* Set *NEEDED_P iff the directory PATH has cleanup work waiting: a
+   leftover log, a `killme' file, or a stale lock.  This is the cheap
+   probe that lets cleanup skip the undamaged part of a working copy;
+   a directory showing none of the three was never mid-operation, so
+   there is nothing to recover there. */
+static svn_error_t *
+needs_cleanup (svn_boolean_t *needed_p,
+               svn_stringbuf_t *path,
+               apr_pool_t *pool)
+{
+  svn_boolean_t locked;
 
-      apr_hash_this (hi, &key, &keylen, &val);
-      entry = val;
+  *needed_p = TRUE;
+  if (svn_wc__adm_path_exists (path, 0, pool, SVN_WC__ADM_LOG, NULL))
+    return SVN_NO_ERROR;
+  if (svn_wc__adm_path_exists (path, 0, pool, SVN_WC__ADM_KILLME, NULL))
+    return SVN_NO_ERROR;
 
-      if ((keylen == strlen (SVN_WC_ENTRY_THIS_DIR))
-          && (strcmp ((char *) key, SVN_WC_ENTRY_THIS_DIR) == 0))
-        is_this_dir = TRUE;
+  SVN_ERR (svn_wc_locked (&locked, path, pool));
+  *needed_p = locked;
 
-      if ((entry->kind == svn_node_dir) && (! is_this_dir))
-        {
-          /* Recurse */
-          svn_stringbuf_t *subdir = svn_stringbuf_dup (path, pool);
-          svn_path_add_component (subdir,
-                                  svn_stringbuf_create ((char *) key, pool));
+  return SVN_NO_ERROR;
+}
 
-          SVN_ERR (svn_wc_cleanup (subdir, pool));
-        }
-    }
+
+/* Do the actual cleanup work in the single directory PATH: run any
+   leftover log, clear the tmp area, honor a `killme' file, and remove
+   the lock.  Doesn't recurse. */
+static svn_error_t *
+cleanup_one_dir (svn_stringbuf_t *path,
+                 apr_pool_t *pool)
+{
+  svn_error_t *err;
+  svn_stringbuf_t *log_path = svn_wc__adm_path (path, 0, pool,
+                                                SVN_WC__ADM_LOG, NULL);
+  svn_boolean_t locked;
+  enum svn_node_kind kind;
 
   /* Lock this working copy directory if it isn't already. */
   SVN_ERR (svn_wc_locked (&locked, path, pool));
@@ -1155,6 +1231,281 @@ svn_wc_cleanup (svn_stringbuf_t *path,
 }
 
 
+/* A directory svn_wc_cleanup found in need of recovery. */
+struct cleanup_item
+{
+  svn_stringbuf_t *path;        /* the directory itself */
+  int parent;                   /* index of the nearest needy ancestor
+                                   item, or -1 */
+  int pending;                  /* needy descendant items not yet
+                                   replayed; used by the threaded
+                                   replay */
+};
+
+
+/* Walk the working copy under PATH, appending a cleanup_item to ITEMS
+   for every directory that needs_cleanup says has recovery work.
+   PARENT is the index in ITEMS of the nearest needy ancestor of PATH,
+   or -1.  The walk visits parents before children.  Allocate in
+   POOL. */
+static svn_error_t *
+collect_cleanup_dirs (apr_array_header_t *items,
+                      svn_stringbuf_t *path,
+                      int parent,
+                      apr_pool_t *pool)
+{
+  apr_hash_t *entries = NULL;
+  apr_hash_index_t *hi;
+  svn_boolean_t needed;
+
+  SVN_ERR (needs_cleanup (&needed, path, pool));
+  if (needed)
+    {
+      struct cleanup_item *item = apr_array_push (items);
+      item->path = svn_stringbuf_dup (path, pool);
+      item->parent = parent;
+      item->pending = 0;
+      parent = items->nelts - 1;
+    }
+
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      apr_ssize_t keylen;
+      void *val;
+      svn_wc_entry_t *entry;
+      svn_boolean_t is_this_dir = FALSE;
+
+      apr_hash_this (hi, &key, &keylen, &val);
+      entry = val;
+
+      if ((keylen == strlen (SVN_WC_ENTRY_THIS_DIR))
+          && (strcmp ((char *) key, SVN_WC_ENTRY_THIS_DIR) == 0))
+        is_this_dir = TRUE;
+
+      if ((entry->kind == svn_node_dir) && (! is_this_dir))
+        {
+          svn_stringbuf_t *subdir = svn_stringbuf_dup (path, pool);
+          svn_path_add_component (subdir,
+                                  svn_stringbuf_create ((char *) key, pool));
+
+          SVN_ERR (collect_cleanup_dirs (items, subdir, parent, pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+#if APR_HAS_THREADS
+
+/* The work queue a threaded cleanup replays logs from.  Workers claim
+   ready items --- those whose needy descendants have all been
+   replayed --- and completing an item may make its parent ready;
+   independent directories recover in parallel, while every log still
+   runs only after the logs below it, as the old recursion
+   guaranteed. */
+struct cleanup_queue
+{
+  apr_array_header_t *items;    /* all the needy directories */
+  apr_array_header_t *ready;    /* indexes into ITEMS safe to replay */
+  int next;                     /* next unclaimed index into READY */
+  int done;                     /* items fully replayed */
+  svn_error_t *err;             /* first error any worker hit */
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+};
+
+
+/* One worker's private state. */
+struct cleanup_worker
+{
+  struct cleanup_queue *queue;
+  apr_pool_t *pool;             /* this worker's private pool */
+};
+
+
+static void *
+cleanup_worker (apr_thread_t *thread, void *data)
+{
+  struct cleanup_worker *worker = data;
+  struct cleanup_queue *q = worker->queue;
+
+  apr_thread_mutex_lock (q->lock);
+  while (1)
+    {
+      int idx;
+      struct cleanup_item *item;
+      svn_error_t *err;
+
+      /* Wait until there's either an item to claim or nothing left
+         that could become one. */
+      while ((q->next >= q->ready->nelts)
+             && (q->done < q->items->nelts)
+             && (! q->err))
+        apr_thread_cond_wait (q->cond, q->lock);
+
+      if (q->err || (q->next >= q->ready->nelts))
+        break;
+
+      idx = APR_ARRAY_IDX (q->ready, q->next, int);
+      q->next++;
+      item = &APR_ARRAY_IDX (q->items, idx, struct cleanup_item);
+      apr_thread_mutex_unlock (q->lock);
+
+      /* Replay outside the lock, in our private pool. */
+      err = cleanup_one_dir (svn_stringbuf_dup (item->path, worker->pool),
+                             worker->pool);
+
+      apr_thread_mutex_lock (q->lock);
+      q->done++;
+      if (err && (! q->err))
+        q->err = err;
+
+      /* If this was the last unfinished descendant of a needy
+         ancestor, that ancestor is now safe to replay. */
+      if (item->parent >= 0)
+        {
+          struct cleanup_item *parent
+            = &APR_ARRAY_IDX (q->items, item->parent, struct cleanup_item);
+
+          parent->pending--;
+          if (parent->pending == 0)
+            {
+              int *readied = apr_array_push (q->ready);
+              *readied = item->parent;
+            }
+        }
+
+      /* Wake the others: either there's new work for them, or it's
+         time to go home. */
+      apr_thread_cond_broadcast (q->cond);
+    }
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+/* Replay the directories in ITEMS, as built by collect_cleanup_dirs,
+   with NUM_THREADS workers.  The PENDING counts keep every directory
+   waiting on its needy descendants.  Allocate in POOL. */
+static svn_error_t *
+run_cleanup_threaded (apr_array_header_t *items,
+                      int num_threads,
+                      apr_pool_t *pool)
+{
+  struct cleanup_queue queue;
+  struct cleanup_worker *workers;
+  apr_thread_t **threads;
+  apr_status_t apr_err;
+  int i;
+
+  /* Count each item's unfinished descendants, then seed the ready
+     list with the items that have none. */
+  for (i = 0; i < items->nelts; i++)
+    {
+      struct cleanup_item *item
+        = &APR_ARRAY_IDX (items, i, struct cleanup_item);
+
+      if (item->parent >= 0)
+        APR_ARRAY_IDX (items, item->parent, struct cleanup_item).pending++;
+    }
+
+  queue.items = items;
+  queue.ready = apr_array_make (pool, items->nelts, sizeof (int));
+  for (i = 0; i < items->nelts; i++)
+    if (APR_ARRAY_IDX (items, i, struct cleanup_item).pending == 0)
+      {
+        int *readied = apr_array_push (queue.ready);
+        *readied = i;
+      }
+  queue.next = 0;
+  queue.done = 0;
+  queue.err = NULL;
+  apr_err = apr_thread_mutex_create (&queue.lock, APR_THREAD_MUTEX_DEFAULT,
+                                     pool);
+  if (! apr_err)
+    apr_err = apr_thread_cond_create (&queue.cond, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "svn_wc_cleanup: can't create replay queue");
+
+  if (num_threads > items->nelts)
+    num_threads = items->nelts;
+
+  workers = apr_pcalloc (pool, num_threads * sizeof (*workers));
+  threads = apr_pcalloc (pool, num_threads * sizeof (*threads));
+  for (i = 0; i < num_threads; i++)
+    {
+      workers[i].queue = &queue;
+
+      /* An independent top-level pool; pools aren't safe to share
+         across threads. */
+      workers[i].pool = svn_pool_create (NULL);
+
+      apr_err = apr_thread_create (&threads[i], NULL, cleanup_worker,
+                                   &workers[i], pool);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "svn_wc_cleanup: can't create worker");
+    }
+
+  for (i = 0; i < num_threads; i++)
+    {
+      apr_status_t ignored;
+      apr_thread_join (&ignored, threads[i]);
+    }
+
+  /* If a worker failed, hand its error on.  (The error lives in that
+     worker's pool, so we can't clean the pools up here.) */
+  if (queue.err)
+    return queue.err;
+
+  for (i = 0; i < num_threads; i++)
+    svn_pool_destroy (workers[i].pool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+svn_error_t *
+svn_wc_cleanup (svn_stringbuf_t *path,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *items
+    = apr_array_make (pool, 16, sizeof (struct cleanup_item));
+  int i;
+
+  /* Find the directories that actually have recovery work waiting.
+     After a killed operation that is the damaged corner of the tree,
+     not the whole working copy.  (This walk also primes the entries
+     cache machinery from this thread; see entries.c.) */
+  SVN_ERR (collect_cleanup_dirs (items, path, -1, pool));
+
+#if APR_HAS_THREADS
+  /* If a worker pool has been requested, replay the logs with it. */
+  if ((cleanup_num_threads > 1) && (items->nelts > 1))
+    return run_cleanup_threaded (items, cleanup_num_threads, pool);
+#endif
+
+  /* The walk above visits parents before children; replay in
+     reverse, so every directory's log runs only after those of its
+     descendants, as the old recursion did. */
+  for (i = items->nelts - 1; i >= 0; i--)
+    SVN_ERR (cleanup_one_dir (APR_ARRAY_IDX (items, i,
+                                             struct cleanup_item).path,
+                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* 
  * local variables:
@@ -36,15 +36,15 @@ svn_wc_merge (const char *left,
               apr_pool_t *pool)
 {
   svn_stringbuf_t *full_tgt_path, *full_left_path, *full_right_path;
-  svn_stringbuf_t *tmp_target, *result_target, *tmp_left, *tmp_right;
-  svn_stringbuf_t *pt, *bn, *bn_left, *bn_right, *mt_pt, *mt_bn;
+  svn_stringbuf_t *tmp_target, *result_target;
+  svn_stringbuf_t *mt_pt, *mt_bn;
   apr_file_t *tmp_f, *result_f;
   svn_boolean_t is_binary;
+  svn_boolean_t conflicted;
   svn_wc_keywords_t *keywords;
   enum svn_wc__eol_style eol_style;
   const char *eol;
   apr_status_t apr_err;
-  int exit_code;
   svn_wc_entry_t *entry;
 
   /* Stringbuf versions of our three fulltext paths, so that we pass
@@ -90,56 +90,20 @@ svn_wc_merge (const char *left,
                                      tmp_target->data, TRUE, pool));
         }
 
-      /* Open a second temporary file for writing; this is where diff3
-         will write the merged results. */
+      /* Open a second temporary file for writing; this is where the
+         merged results will go. */
       SVN_ERR (svn_io_open_unique_file (&result_f, &result_target,
                                         merge_target, SVN_WC__TMP_EXT,
                                         FALSE, pool));
 
-      /* LEFT and RIGHT might be in totally different directories than
-         MERGE_TARGET, and our diff3 command wants them all to be in
-         the same directory.  So make temporary copies of LEFT and
-         RIGHT right next to the target. */
-      SVN_ERR (svn_io_open_unique_file (&tmp_f, &tmp_left,
-                                        merge_target,
-                                        SVN_WC__TMP_EXT,
-                                        FALSE, pool));
-      apr_err = apr_file_close (tmp_f);
-      if (! APR_STATUS_IS_SUCCESS (apr_err))
-        return svn_error_createf
-          (apr_err, 0, NULL, pool,
-           "svn_wc_merge: unable to close tmp file `%s'",
-           tmp_left->data);
-
-      SVN_ERR (svn_io_open_unique_file (&tmp_f, &tmp_right,
-                                        merge_target,
-                                        SVN_WC__TMP_EXT,
-                                        FALSE, pool));
-      apr_err = apr_file_close (tmp_f);
-      if (! APR_STATUS_IS_SUCCESS (apr_err))
-        return svn_error_createf
-          (apr_err, 0, NULL, pool,
-           "svn_wc_merge: unable to close tmp file `%s'",
-           tmp_right->data);
-    
-      SVN_ERR (svn_io_copy_file (left, tmp_left->data, TRUE, pool));
-      SVN_ERR (svn_io_copy_file (right, tmp_right->data, TRUE, pool));
-
-      svn_path_split (tmp_left, &pt, &bn_left, pool);
-      svn_path_split (tmp_right, &pt, &bn_right, pool);
-      svn_path_split (tmp_target, &pt, &bn, pool);
-      
-      /* sanity check */
-      if (svn_stringbuf_isempty(mt_pt))
-        svn_stringbuf_set (mt_pt, ".");
-
-      /* Do the Deed, using all four scratch files. */
-      SVN_ERR (svn_io_run_diff3 (mt_pt->data,
-                                 bn->data, bn_left->data, bn_right->data,
-                                 target_label, left_label, right_label,
-                                 result_f,
-                                 &exit_code,
-                                 pool));
+      /* Do the Deed.  The built-in merge engine reads LEFT and RIGHT
+         wherever they live, so there's no need to copy them next to
+         the target the way an external diff3 would want. */
+      SVN_ERR (svn_io_merge_files (tmp_target->data, left, right,
+                                   target_label, left_label, right_label,
+                                   result_f,
+                                   &conflicted,
+                                   pool));
   
       /* Close the output file */
       apr_err = apr_file_close (result_f);
@@ -148,7 +112,7 @@ svn_wc_merge (const char *left,
           (apr_err, 0, NULL, pool,
            "svn_wc_merge: unable to close tmp file `%s'", result_target->data);
 
-      if (exit_code == 1)  /* got a conflict */
+      if (conflicted)
         {
           /* Preserve the three pre-merge files, and modify the
              entry (mark as conflicted, track the preserved files). */ 
@@ -270,8 +234,7 @@ svn_wc_merge (const char *left,
                                           merge_target,
                                           eol, FALSE, keywords, TRUE, pool));
 
-      /* Don't forget to clean up tmp_target, result_target, tmp_left,
-         tmp_right.  There are a lot of scratch files lying around. */
+      /* Don't forget to clean up tmp_target and result_target. */
       apr_err = apr_file_remove (tmp_target->data, pool);
       if (! APR_STATUS_IS_SUCCESS (apr_err))
         return svn_error_createf
@@ -284,18 +247,6 @@ svn_wc_merge (const char *left,
           (apr_err, 0, NULL, pool,
            "svn_wc_merge: unable to delete tmp file `%s'",
            result_target->data);
-      apr_err = apr_file_remove (tmp_left->data, pool);
-      if (! APR_STATUS_IS_SUCCESS (apr_err))
-        return svn_error_createf
-          (apr_err, 0, NULL, pool,
-           "svn_wc_merge: unable to delete tmp file `%s'",
-           tmp_left->data);
-      apr_err = apr_file_remove (tmp_right->data, pool);
-      if (! APR_STATUS_IS_SUCCESS (apr_err))
-        return svn_error_createf
-          (apr_err, 0, NULL, pool,
-           "svn_wc_merge: unable to delete tmp file `%s'",
-           tmp_right->data);
 
     } /* end of merging for text files */
 
@@ -356,13 +307,13 @@ svn_wc_merge (const char *left,
                 | SVN_WC__ENTRY_MODIFY_CONFLICT_WRK,
                 pool));
 
-      exit_code = 1;  /* a conflict happened */
+      conflicted = TRUE;  /* a conflict happened */
 
     } /* end of binary conflict handling */
 
   /* The docstring promises we'll return a CONFLICT error if
      appropriate;  presumably callers will specifically look for this. */
-  if (exit_code == 1)
+  if (conflicted)
     return svn_error_createf
       (SVN_ERR_WC_CONFLICT, 0, NULL, pool,
        "svn_wc_merge: `%s' had conflicts during merge", merge_target);
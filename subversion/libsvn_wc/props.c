@@ -29,6 +29,9 @@
 #include <apr_strings.h>
 #include <apr_lib.h>
 #include <apr_general.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
 #include "svn_types.h"
 #include "svn_delta.h"
 #include "svn_string.h"
@@ -878,6 +881,147 @@ wcprop_list (apr_hash_t **props,
 }
 
 
+/* Batched wcprop writes.
+
+   ra_dav's update sets a wcprop on every file it fetches, and each
+   set loads, rewrites and syncs that file's whole wcprops file.
+   While a batch is open (see svn_wc__wcprops_batch_begin),
+   svn_wc__wcprop_set buffers its changes here instead, and the
+   batch's close writes each touched wcprops file exactly once.
+
+   Process-wide and mutex-guarded: the update pipeline installs files
+   --- and thus sets wcprops --- from a worker thread.  The machinery
+   is created by svn_wc__wcprops_batch_begin, which runs before any
+   workers exist. */
+
+static apr_pool_t *wcprop_batch_pool = NULL;     /* parent; holds the lock */
+static apr_pool_t *wcprop_batch_subpool = NULL;  /* this batch's data */
+
+/* Path of a versioned object -> its full wcprop hash, everything
+   allocated in WCPROP_BATCH_SUBPOOL.  Null when no batch is open. */
+static apr_hash_t *wcprop_batch = NULL;
+
+static int wcprop_batch_depth = 0;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *wcprop_batch_lock = NULL;
+#endif
+
+
+/* Serialize access to the wcprop batch.  No-ops until the batch
+   machinery exists. */
+static void
+lock_wcprop_batch (void)
+{
+#if APR_HAS_THREADS
+  if (wcprop_batch_lock)
+    apr_thread_mutex_lock (wcprop_batch_lock);
+#endif
+}
+
+static void
+unlock_wcprop_batch (void)
+{
+#if APR_HAS_THREADS
+  if (wcprop_batch_lock)
+    apr_thread_mutex_unlock (wcprop_batch_lock);
+#endif
+}
+
+
+/* Write PROPHASH out as PATH's wcprops file, synced into place.  Use
+   POOL for temporary allocations. */
+static svn_error_t *
+wcprop_write (apr_hash_t *prophash,
+              const char *path,
+              apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+  apr_file_t *fp = NULL;
+  svn_stringbuf_t *pathbuf = svn_stringbuf_create (path, pool);
+
+  SVN_ERR (svn_wc__open_props (&fp,
+                               pathbuf, /* open in PATH */
+                               (APR_WRITE | APR_CREATE),
+                               0, /* not base props */
+                               1, /* we DO want wcprops */
+                               pool));
+
+  apr_err = svn_hash_write (prophash, svn_unpack_bytestring, fp, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "can't write prop hash for %s", path);
+
+  /* Close file, and doing an atomic "move". */
+  SVN_ERR (svn_wc__close_props (fp, pathbuf, 0, 1,
+                                1, /* sync! */
+                                pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+void
+svn_wc__wcprops_batch_begin (void)
+{
+  if (wcprop_batch_pool == NULL)
+    {
+      wcprop_batch_pool = svn_pool_create (NULL);
+#if APR_HAS_THREADS
+      apr_thread_mutex_create (&wcprop_batch_lock,
+                               APR_THREAD_MUTEX_DEFAULT,
+                               wcprop_batch_pool);
+#endif
+    }
+
+  lock_wcprop_batch ();
+  if (wcprop_batch_depth++ == 0)
+    {
+      wcprop_batch_subpool = svn_pool_create (wcprop_batch_pool);
+      wcprop_batch = apr_hash_make (wcprop_batch_subpool);
+    }
+  unlock_wcprop_batch ();
+}
+
+
+svn_error_t *
+svn_wc__wcprops_batch_end (apr_pool_t *pool)
+{
+  apr_pool_t *subpool = NULL;
+  apr_hash_t *batch = NULL;
+  apr_hash_index_t *hi;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  lock_wcprop_batch ();
+  if ((wcprop_batch_depth > 0) && (--wcprop_batch_depth == 0))
+    {
+      subpool = wcprop_batch_subpool;
+      batch = wcprop_batch;
+      wcprop_batch_subpool = NULL;
+      wcprop_batch = NULL;
+    }
+  unlock_wcprop_batch ();
+
+  if (! batch)
+    return SVN_NO_ERROR;
+
+  /* One load/rewrite/sync cycle per touched file, no matter how many
+     wcprops each one accumulated during the batch. */
+  for (hi = apr_hash_first (pool, batch); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      err = wcprop_write (val, key, pool);
+      if (err)
+        break;
+    }
+
+  svn_pool_destroy (subpool);
+  return err;
+}
+
+
 /* This is what RA_DAV will use to fetch 'wc' properties.  It will be
    passed to ra_session_baton->do_commit(). */
 svn_error_t *
@@ -890,6 +1034,23 @@ svn_wc__wcprop_get (const svn_string_t **value,
   apr_hash_t *prophash;
   svn_stringbuf_t *pvaluebuf;
 
+  /* A path the open batch has buffered carries its full wcprop hash
+     there, disk being stale for it; answer from the buffer. */
+  lock_wcprop_batch ();
+  if (wcprop_batch_depth > 0)
+    {
+      prophash = apr_hash_get (wcprop_batch, path, APR_HASH_KEY_STRING);
+      if (prophash)
+        {
+          pvaluebuf = apr_hash_get (prophash, name, APR_HASH_KEY_STRING);
+          *value = pvaluebuf
+                   ? svn_string_create_from_buf (pvaluebuf, pool) : NULL;
+          unlock_wcprop_batch ();
+          return SVN_NO_ERROR;
+        }
+    }
+  unlock_wcprop_batch ();
+
   err = wcprop_list (&prophash, path, pool);
   if (err)
     return
@@ -914,13 +1075,38 @@ svn_wc__wcprop_set (const char *name,
                     apr_pool_t *pool)
 {
   svn_error_t *err;
-  apr_status_t apr_err;
   apr_hash_t *prophash;
-  apr_file_t *fp = NULL;
 
-  /* ### be nice to eliminate these... */
-  svn_stringbuf_t *valuebuf = svn_stringbuf_create_from_string (value, pool);
-  svn_stringbuf_t *pathbuf = svn_stringbuf_create (path, pool);
+  /* While a batch is open, just buffer the change; the batch's close
+     writes each touched wcprops file once. */
+  lock_wcprop_batch ();
+  if (wcprop_batch_depth > 0)
+    {
+      apr_pool_t *bpool = wcprop_batch_subpool;
+
+      prophash = apr_hash_get (wcprop_batch, path, APR_HASH_KEY_STRING);
+      if (prophash == NULL)
+        {
+          /* First touch of this path: seed the buffer with what's on
+             disk, so the flush writes the complete prop set. */
+          err = wcprop_list (&prophash, path, bpool);
+          if (err)
+            {
+              unlock_wcprop_batch ();
+              return svn_error_quick_wrap
+                (err, "svn_wc__wcprop_set: failed to load props from disk.");
+            }
+          apr_hash_set (wcprop_batch, apr_pstrdup (bpool, path),
+                        APR_HASH_KEY_STRING, prophash);
+        }
+
+      apr_hash_set (prophash, apr_pstrdup (bpool, name),
+                    APR_HASH_KEY_STRING,
+                    svn_stringbuf_create_from_string (value, bpool));
+      unlock_wcprop_batch ();
+      return SVN_NO_ERROR;
+    }
+  unlock_wcprop_batch ();
 
   err = wcprop_list (&prophash, path, pool);
   if (err)
@@ -930,27 +1116,10 @@ svn_wc__wcprop_set (const char *name,
 
   /* Now we have all the properties in our hash.  Simply merge the new
      property into it. */
-  apr_hash_set (prophash, name, APR_HASH_KEY_STRING, valuebuf);
+  apr_hash_set (prophash, name, APR_HASH_KEY_STRING,
+                svn_stringbuf_create_from_string (value, pool));
 
-  /* Open the propfile for writing. */
-  SVN_ERR (svn_wc__open_props (&fp, 
-                               pathbuf, /* open in PATH */
-                               (APR_WRITE | APR_CREATE),
-                               0, /* not base props */
-                               1, /* we DO want wcprops */
-                               pool));
-  /* Write. */
-  apr_err = svn_hash_write (prophash, svn_unpack_bytestring, fp, pool);
-  if (apr_err)
-    return svn_error_createf (apr_err, 0, NULL, pool,
-                              "can't write prop hash for %s", path);
-  
-  /* Close file, and doing an atomic "move". */
-  SVN_ERR (svn_wc__close_props (fp, pathbuf, 0, 1,
-                                1, /* sync! */
-                                pool));
-
-  return SVN_NO_ERROR;
+  return wcprop_write (prophash, path, pool);
 }
 
 
@@ -1095,8 +1264,10 @@ svn_wc_prop_set (const char *name,
           svn_path_split (pathbuf, &pdir, &basename, pool);
           tmp_entry.kind = svn_node_file;
           tmp_entry.text_time = 0;
+          tmp_entry.text_size = 0;
           SVN_ERR (svn_wc__entry_modify (pdir, basename, &tmp_entry,
-                                         SVN_WC__ENTRY_MODIFY_TEXT_TIME,
+                                         (SVN_WC__ENTRY_MODIFY_TEXT_TIME
+                                          | SVN_WC__ENTRY_MODIFY_TEXT_SIZE),
                                          pool));
         }
     }
@@ -1167,6 +1338,164 @@ svn_wc__strip_entry_prefix (svn_stringbuf_t *name)
 
 
 
+/*** A cache of property-directory listings ***/
+
+/* status and commit ask about every node's properties, and most
+   nodes have none, so the answer mustn't cost filesystem traffic per
+   node.  We read each props/prop-base directory once and remember
+   every contained file's size, validated against the directory's own
+   size and mtime.  Property files always land by an atomic rename
+   into their directory, and renames touch the directory, so the
+   validation catches writers.  (As with the entries cache --- see
+   entries.c --- two renames within one mtime granule could fool it,
+   but the working copy lock keeps writers out while we're asking.)
+
+   Process-wide and mutex-guarded, for the threaded status crawl. */
+
+static apr_pool_t *prop_dir_cache_pool = NULL;
+static apr_hash_t *prop_dir_cache = NULL;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *prop_dir_cache_lock = NULL;
+#endif
+
+
+/* Serialize access to the prop directory cache.  No-ops until the
+   cache machinery exists. */
+static void
+lock_prop_dir_cache (void)
+{
+#if APR_HAS_THREADS
+  if (prop_dir_cache_lock)
+    apr_thread_mutex_lock (prop_dir_cache_lock);
+#endif
+}
+
+static void
+unlock_prop_dir_cache (void)
+{
+#if APR_HAS_THREADS
+  if (prop_dir_cache_lock)
+    apr_thread_mutex_unlock (prop_dir_cache_lock);
+#endif
+}
+
+
+struct prop_dir_index
+{
+  /* Basename of each file in the directory -> (apr_off_t *) size,
+     all allocated in SUBPOOL. */
+  apr_hash_t *sizes;
+
+  /* Size and mtime of the directory itself when we listed it. */
+  apr_off_t dir_size;
+  apr_time_t dir_mtime;
+
+  /* The subpool all of the above lives in. */
+  apr_pool_t *subpool;
+};
+
+
+/* Set *INDEX_P to a current index of the property directory
+   DIR_PATH, listing it afresh if the cache has nothing usable, or to
+   null if the directory can't be statted (the caller then falls back
+   to asking the filesystem directly).  Use POOL only for temporary
+   allocations.  Call with the cache lock held. */
+static svn_error_t *
+get_prop_dir_index (struct prop_dir_index **index_p,
+                    const char *dir_path,
+                    apr_pool_t *pool)
+{
+  struct prop_dir_index *index;
+  apr_finfo_t finfo;
+  apr_dir_t *dir;
+  apr_pool_t *subpool;
+  apr_status_t status;
+
+  if (prop_dir_cache_pool == NULL)
+    {
+      prop_dir_cache_pool = svn_pool_create (NULL);
+      prop_dir_cache = apr_hash_make (prop_dir_cache_pool);
+#if APR_HAS_THREADS
+      apr_thread_mutex_create (&prop_dir_cache_lock,
+                               APR_THREAD_MUTEX_DEFAULT,
+                               prop_dir_cache_pool);
+#endif
+    }
+
+  if (apr_stat (&finfo, dir_path, APR_FINFO_MIN, pool))
+    {
+      *index_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  index = apr_hash_get (prop_dir_cache, dir_path, APR_HASH_KEY_STRING);
+  if (index
+      && (index->dir_size == finfo.size)
+      && (index->dir_mtime == finfo.mtime))
+    {
+      *index_p = index;
+      return SVN_NO_ERROR;
+    }
+
+  /* Toss any stale listing, and read the directory afresh. */
+  if (index)
+    {
+      apr_hash_set (prop_dir_cache, dir_path, APR_HASH_KEY_STRING, NULL);
+      svn_pool_destroy (index->subpool);
+    }
+
+  subpool = svn_pool_create (prop_dir_cache_pool);
+  index = apr_pcalloc (subpool, sizeof (*index));
+  index->subpool = subpool;
+  index->sizes = apr_hash_make (subpool);
+  index->dir_size = finfo.size;
+  index->dir_mtime = finfo.mtime;
+
+  status = apr_dir_open (&dir, dir_path, pool);
+  if (status)
+    {
+      svn_pool_destroy (subpool);
+      return svn_error_createf (status, 0, NULL, pool,
+                                "get_prop_dir_index: can't open '%s'",
+                                dir_path);
+    }
+
+  while (1)
+    {
+      apr_off_t *size;
+
+      status = apr_dir_read (&finfo, APR_FINFO_MIN | APR_FINFO_NAME, dir);
+      if (APR_STATUS_IS_ENOENT (status))
+        break;
+      else if (status)
+        {
+          apr_dir_close (dir);
+          svn_pool_destroy (subpool);
+          return svn_error_createf (status, 0, NULL, pool,
+                                    "get_prop_dir_index: error reading '%s'",
+                                    dir_path);
+        }
+
+      if ((! strcmp (finfo.name, "."))
+          || (! strcmp (finfo.name, "..")))
+        continue;
+
+      size = apr_palloc (subpool, sizeof (*size));
+      *size = finfo.size;
+      apr_hash_set (index->sizes, apr_pstrdup (subpool, finfo.name),
+                    APR_HASH_KEY_STRING, size);
+    }
+
+  apr_dir_close (dir);
+
+  apr_hash_set (prop_dir_cache, apr_pstrdup (subpool, dir_path),
+                APR_HASH_KEY_STRING, index);
+
+  *index_p = index;
+  return SVN_NO_ERROR;
+}
+
+
 /* Helper to optimize svn_wc_props_modified_p().
 
    If PATH_TO_PROP_FILE is nonexistent, or is of size 4 bytes ("END"),
@@ -1177,39 +1506,67 @@ empty_props_p (svn_boolean_t *empty_p,
                svn_stringbuf_t *path_to_prop_file,
                apr_pool_t *pool)
 {
-  enum svn_node_kind kind;
+  struct prop_dir_index *index;
+  svn_stringbuf_t *dir, *basename;
+  apr_off_t size = -1;
+  svn_boolean_t found = FALSE;
+  svn_error_t *err;
 
-  SVN_ERR (svn_io_check_path (path_to_prop_file->data, &kind, pool));
+  /* Answer from the cached listing of the property directory, so a
+     directory full of prop-less nodes costs one readdir, not a stat
+     per node. */
+  svn_path_split (path_to_prop_file, &dir, &basename, pool);
 
-  if (kind == svn_node_none)
-    *empty_p = TRUE;
+  lock_prop_dir_cache ();
+  err = get_prop_dir_index (&index, dir->data, pool);
+  if ((! err) && index)
+    {
+      apr_off_t *cached = apr_hash_get (index->sizes, basename->data,
+                                        APR_HASH_KEY_STRING);
+      found = TRUE;
+      if (cached)
+        size = *cached;
+    }
+  unlock_prop_dir_cache ();
+  if (err)
+    return err;
 
-  else 
+  /* If the directory itself couldn't be statted, ask about the file
+     the hard way. */
+  if (! found)
     {
+      enum svn_node_kind kind;
       apr_finfo_t finfo;
       apr_status_t status;
 
+      SVN_ERR (svn_io_check_path (path_to_prop_file->data, &kind, pool));
+      if (kind == svn_node_none)
+        {
+          *empty_p = TRUE;
+          return SVN_NO_ERROR;
+        }
+
       status = apr_stat (&finfo, path_to_prop_file->data, APR_FINFO_MIN, pool);
       if (status)
         return svn_error_createf (status, 0, NULL, pool,
                                   "couldn't stat '%s'...",
                                   path_to_prop_file->data);
+      size = finfo.size;
+    }
 
-      /* If we remove props from a propfile, eventually the file will
-         contain nothing but "END\n" */
-      if (finfo.size == 4)  
-        *empty_p = TRUE;
-
-      else
-        *empty_p = FALSE;
+  /* If we remove props from a propfile, eventually the file will
+     contain nothing but "END\n" */
+  if ((size == -1) || (size == 4))
+    *empty_p = TRUE;
 
-      /* ### really, if the size is < 4, then something is corrupt.
-         If the size is between 4 and 16, then something is corrupt,
-         because 16 is the -smallest- the file can possibly be if it
-         contained only one property.  someday we should check for
-         this. */
+  else
+    *empty_p = FALSE;
 
-    }
+  /* ### really, if the size is < 4, then something is corrupt.
+     If the size is between 4 and 16, then something is corrupt,
+     because 16 is the -smallest- the file can possibly be if it
+     contained only one property.  someday we should check for
+     this. */
 
   return SVN_NO_ERROR;
 }
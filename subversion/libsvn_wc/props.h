@@ -125,6 +125,16 @@ svn_error_t *svn_wc__wcprop_set (const char *name,
                                  const char *path,
                                  apr_pool_t *pool);
 
+/* Open a batch of wcprop writes.  While a batch is open,
+   svn_wc__wcprop_set buffers its changes in memory (and
+   svn_wc__wcprop_get answers from the buffer), instead of rewriting
+   a wcprops file per set.  Batches nest. */
+void svn_wc__wcprops_batch_begin (void);
+
+/* Close a batch of wcprop writes, writing each touched wcprops file
+   exactly once.  Use POOL for temporary allocations. */
+svn_error_t *svn_wc__wcprops_batch_end (apr_pool_t *pool);
+
 /* Remove all wc properties under PATH, recursively.  Do any temporary
    allocation in POOL.  If PATH is not a directory, return the error
    SVN_ERR_WC_NOT_DIRECTORY. */
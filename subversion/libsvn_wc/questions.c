@@ -47,7 +47,6 @@ svn_wc_check_wc (const svn_stringbuf_t *path,
   /* Nothing fancy, just check for an administrative subdir and a
      `README' file. */ 
 
-  apr_file_t *f = NULL;
   svn_error_t *err = NULL;
   enum svn_node_kind kind;
 
@@ -65,9 +64,14 @@ svn_wc_check_wc (const svn_stringbuf_t *path,
     *is_wc = FALSE;
   else
     {
-      err = svn_wc__open_adm_file (&f, path, SVN_WC__ADM_README,
-                                   APR_READ, pool);
-      
+      enum svn_node_kind readme_kind;
+
+      /* The cached adm listing answers this without touching the
+         filesystem again; recursive operations ask about directory
+         after directory. */
+      err = svn_wc__adm_thing_kind (&readme_kind, path,
+                                    SVN_WC__ADM_README, pool);
+
       /* It really doesn't matter what kind of error it is; if there
          was an error at all, then for our purposes this is not a
          working copy. */
@@ -77,12 +81,7 @@ svn_wc_check_wc (const svn_stringbuf_t *path,
           *is_wc = FALSE;
         }
       else
-        {
-          *is_wc = TRUE;
-          err = svn_wc__close_adm_file (f, path, SVN_WC__ADM_README, 0, pool);
-          if (err)
-            return err;
-        }
+        *is_wc = (readme_kind == svn_node_file);
     }
 
   return SVN_NO_ERROR;
@@ -191,6 +190,21 @@ svn_wc__timestamps_equal_p (svn_boolean_t *equal_p,
   else
     *equal_p = FALSE;
 
+  /* An equal timestamp alone can be fooled by an edit made within the
+     stamp's granularity (we no longer sleep operations past the
+     granule boundary); when the entry also records the working file's
+     size, require that to match too. */
+  if (*equal_p
+      && (timestamp_kind == svn_wc__text_time)
+      && entry->text_size)
+    {
+      apr_off_t wfile_size;
+
+      SVN_ERR (svn_io_file_size (&wfile_size, path->data, pool));
+      if (wfile_size != entry->text_size)
+        *equal_p = FALSE;
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -336,11 +350,12 @@ svn_wc_text_modified_p (svn_boolean_t *modified_p,
       goto cleanup;
     }
 
-  /* See if the local file's timestamp is the same as the one recorded
-     in the administrative directory.  This could, theoretically, be
-     wrong in certain rare cases, but with the addition of a forced
-     delay after commits (see revision 419 and issue #542) it's highly
-     unlikely to be a problem. */
+  /* See if the local file's timestamp and size are the same as the
+     ones recorded in the administrative directory.  The pair can only
+     be fooled by an edit that lands within one timestamp granule of
+     the recorded stamp *and* leaves the size unchanged -- which is
+     why we no longer force a delay after commits and updates (see
+     issue #542). */
   SVN_ERR (svn_wc__timestamps_equal_p (&equal_timestamps, filename,
                                        svn_wc__text_time, subpool));
   if (equal_timestamps)
@@ -359,7 +374,29 @@ svn_wc_text_modified_p (svn_boolean_t *modified_p,
       *modified_p = TRUE;
       goto cleanup;
     }
-  
+
+  /* If the entry carries a checksum of the text-base, we can decide
+     by checksumming a detranslated copy of the working file, without
+     reading the text-base at all. */
+  {
+    svn_wc_entry_t *entry;
+
+    SVN_ERR (svn_wc_entry (&entry, filename, subpool));
+    if (entry && entry->checksum)
+      {
+        svn_stringbuf_t *tmp_vfile, *checksum;
+
+        SVN_ERR (svn_wc_translated_file (&tmp_vfile, filename, subpool));
+        SVN_ERR (svn_io_file_checksum (&checksum, tmp_vfile->data, subpool));
+        *modified_p = (! svn_stringbuf_compare (checksum, entry->checksum));
+
+        if (tmp_vfile != filename)
+          SVN_ERR (svn_io_remove_file (tmp_vfile->data, subpool));
+
+        goto cleanup;
+      }
+  }
+
   /* Otherwise, fall back on the standard mod detector. */
   SVN_ERR (svn_wc__versioned_file_modcheck (modified_p,
                                             filename,
@@ -382,56 +419,36 @@ svn_wc_conflicted_p (svn_boolean_t *text_conflicted_p,
                      svn_wc_entry_t *entry,
                      apr_pool_t *pool)
 {
-  svn_stringbuf_t *path;
-  enum svn_node_kind kind;
+  const char *names[4];
+  enum svn_node_kind kinds[4];
   apr_pool_t *subpool = svn_pool_create (pool);
 
   *text_conflicted_p = FALSE;
   *prop_conflicted_p = FALSE;
 
-  /* Look for any text conflict, exercising only as much effort as
-     necessary to obtain a definitive answer.  This only applies to
-     files, but we don't have to explicitly check that entry is a
-     file, since these attributes would never be set on a directory
-     anyway.  A conflict file entry notation only counts if the
-     conflict file still exists on disk.  */
-  if (entry->conflict_old)
-    {
-      path = svn_stringbuf_dup (dir_path, subpool);
-      svn_path_add_component (path, entry->conflict_old);
-      SVN_ERR (svn_io_check_path (path->data, &kind, subpool));
-      if (kind == svn_node_file)
-        *text_conflicted_p = TRUE;
-    }
+  /* Gather the conflict files named by the entry, and resolve them
+     against the directory in a single pass rather than one stat each.
+     This only applies to files, but we don't have to explicitly check
+     that entry is a file, since these attributes would never be set
+     on a directory anyway.  A conflict file entry notation only
+     counts if the conflict file still exists on disk.  */
+  names[0] = entry->conflict_old ? entry->conflict_old->data : NULL;
+  names[1] = entry->conflict_new ? entry->conflict_new->data : NULL;
+  names[2] = entry->conflict_wrk ? entry->conflict_wrk->data : NULL;
+  names[3] = entry->prejfile ? entry->prejfile->data : NULL;
+
+  SVN_ERR (svn_io_check_paths (kinds, dir_path->data, names, 4, subpool));
+
+  /* Any surviving conflict file means a text conflict... */
+  if ((kinds[0] == svn_node_file)
+      || (kinds[1] == svn_node_file)
+      || (kinds[2] == svn_node_file))
+    *text_conflicted_p = TRUE;
+
+  /* ...and a surviving reject file, a prop conflict. */
+  if (kinds[3] == svn_node_file)
+    *prop_conflicted_p = TRUE;
 
-  if ((! *text_conflicted_p) && (entry->conflict_new))
-    {
-      path = svn_stringbuf_dup (dir_path, subpool);
-      svn_path_add_component (path, entry->conflict_new);
-      SVN_ERR (svn_io_check_path (path->data, &kind, subpool));
-      if (kind == svn_node_file)
-        *text_conflicted_p = TRUE;
-    }
-
-  if ((! *text_conflicted_p) && (entry->conflict_wrk))
-    {
-      path = svn_stringbuf_dup (dir_path, subpool);
-      svn_path_add_component (path, entry->conflict_wrk);
-      SVN_ERR (svn_io_check_path (path->data, &kind, subpool));
-      if (kind == svn_node_file)
-        *text_conflicted_p = TRUE;
-    }
-
-  /* What about prop conflicts? */
-  if (entry->prejfile)
-    {
-      path = svn_stringbuf_dup (dir_path, subpool);
-      svn_path_add_component (path, entry->prejfile);
-      SVN_ERR (svn_io_check_path (path->data, &kind, subpool));
-      if (kind == svn_node_file)
-        *prop_conflicted_p = TRUE;
-    }
-  
   svn_pool_destroy (subpool);
   return SVN_NO_ERROR;
 }
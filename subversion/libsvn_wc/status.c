@@ -24,6 +24,11 @@
 #include <apr_hash.h>
 #include <apr_time.h>
 #include <apr_fnmatch.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 #include "svn_pools.h"
 #include "svn_types.h"
 #include "svn_string.h"
@@ -35,6 +40,17 @@
 #include "props.h"
 
 
+/* How many threads svn_wc_statuses may crawl with; see
+   svn_wc_set_status_threads. */
+static int status_num_threads = 1;
+
+void
+svn_wc_set_status_threads (int num_threads)
+{
+  status_num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+
 static void add_default_ignores (apr_array_header_t *patterns)
 {
   static const char * const ignores[] = 
@@ -296,23 +312,21 @@ add_status_structure (apr_hash_t *statushash,
 }
 
 
-/* Add all items that are NOT in ENTRIES (which is a list of PATH's
-   versioned things) to the STATUSHASH as unversioned items,
+/* Add all items that are in DIRENTS (PATH's on-disk entries, as
+   returned by svn_io_get_dirents) but NOT in ENTRIES (which is a list
+   of PATH's versioned things) to the STATUSHASH as unversioned items,
    allocating everything in POOL. */
 static svn_error_t *
-add_unversioned_items (svn_stringbuf_t *path, 
+add_unversioned_items (svn_stringbuf_t *path,
                        apr_hash_t *entries,
+                       apr_hash_t *dirents,
                        apr_hash_t *statushash,
                        apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create (pool);
-  apr_hash_t *dirents;
   apr_hash_index_t *hi;
   apr_array_header_t *patterns;
 
-  /* Read PATH's dirents. */
-  SVN_ERR (svn_io_get_dirents (&dirents, path, subpool));
-
   /* Try to load any '.svnignore' file that may be present. */
   patterns = apr_array_make (subpool, 1, sizeof(const char *));
   add_default_ignores (patterns);
@@ -405,6 +419,316 @@ svn_wc_status (svn_wc_status_t **status,
 
 
 
+/* Produce status structures for the entries of the directory PATH,
+   without descending: read PATH's entries, add the unversioned items,
+   and add a status structure to STATUSHASH for each file entry,
+   allocating in POOL.  A status structure for PATH itself is added
+   too, unless STATUSHASH already holds one.
+
+   If SUBDIRS is non-null, append each versioned subdirectory's full
+   path (an svn_stringbuf_t *, allocated in POOL) to it for the caller
+   to visit; each subdirectory's own status comes from its own
+   THIS_DIR entry when it is visited.  If SUBDIRS is null,
+   subdirectories are ignored, as always when not descending. */
+static svn_error_t *
+status_one_dir (apr_hash_t *statushash,
+                svn_stringbuf_t *path,
+                svn_boolean_t get_all,
+                svn_boolean_t strict,
+                apr_array_header_t *subdirs,
+                apr_pool_t *pool)
+{
+  apr_hash_t *entries, *dirents;
+  apr_array_header_t *sorted_entries;
+  enum svn_node_kind kind;
+  int i;
+
+  /* Load entries file for the directory into the requested pool.  The
+     sorted view makes the output (and the subdir visiting order)
+     independent of hash order, and the sort is cached with the parse,
+     so a commit harvest over the same directories reuses it. */
+  SVN_ERR (svn_wc_entries_read_sorted (&entries, &sorted_entries,
+                                       path, pool));
+
+  /* Read the directory once; it answers both the unversioned-item
+     scan and the per-entry existence checks below, which used to cost
+     a stat apiece. */
+  SVN_ERR (svn_io_get_dirents (&dirents, path, pool));
+
+  /* Add the unversioned items to the status output. */
+  SVN_ERR (add_unversioned_items (path, entries, dirents, statushash, pool));
+
+  /* Loop over the entries in name order */
+  for (i = 0; i < sorted_entries->nelts; i++)
+    {
+      svn_wc_entry_t *entry
+        = APR_ARRAY_IDX (sorted_entries, i, svn_wc_entry_t *);
+      const char *basename = entry->name->data;
+      enum svn_node_kind *dirent_kind;
+
+      /* Put fullpath into the request pool since it becomes a key
+         in the output statushash hash table. */
+      svn_stringbuf_t *fullpath = svn_stringbuf_dup (path, pool);
+
+      if (strcmp (basename, SVN_WC_ENTRY_THIS_DIR) != 0)
+        {
+          svn_path_add_component_nts (fullpath, basename);
+        }
+
+      /* The entry's actual kind comes from the directory read above,
+         not a stat per entry.  THIS_DIR is the directory itself and
+         is never among its own dirents, but its branch below never
+         looks at KIND anyway. */
+      dirent_kind = apr_hash_get (dirents, basename, entry->name->len);
+      kind = dirent_kind ? *dirent_kind : svn_node_none;
+
+      /* In deciding whether or not to descend, we use the actual
+         kind of the entity, not the kind claimed by the entries
+         file.  The two are usually the same, but where they are
+         not, its usually because some directory got moved, and
+         one would still want a status report on its contents.
+         kff todo: However, must handle mixed working copies.
+         What if the subdir is not under revision control, or is
+         from another repository? */
+
+      /* Do *not* store THIS_DIR in the statushash, unless this
+         path has never been seen before.  We don't want to add
+         the path key twice. */
+      if (! strcmp (basename, SVN_WC_ENTRY_THIS_DIR))
+        {
+          svn_wc_status_t *s = apr_hash_get (statushash,
+                                             fullpath->data,
+                                             fullpath->len);
+          if (! s)
+            SVN_ERR (add_status_structure (statushash, fullpath,
+                                           entry, get_all,
+                                           strict, pool));
+        }
+      else
+        {
+          if (kind == svn_node_dir && subdirs)
+            {
+              /* Directory entries are incomplete; their full status
+                 comes from their own THIS_DIR entry when the caller
+                 visits them. */
+              svn_stringbuf_t **queued = apr_array_push (subdirs);
+              *queued = fullpath;
+            }
+          else if ((kind == svn_node_file) || (kind == svn_node_none))
+            {
+              /* File entries are ... just fine! */
+              SVN_ERR (add_status_structure (statushash, fullpath,
+                                             entry, get_all,
+                                             strict, pool));
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+#if APR_HAS_THREADS
+
+/* The work queue a threaded status crawl distributes directories
+   from.  Workers pop the next unvisited directory, status it into
+   their own private hash, and push whatever subdirectories they find;
+   when no work is left and no worker is mid-directory, everyone goes
+   home. */
+struct status_queue
+{
+  apr_array_header_t *dirs;     /* the directories to visit */
+  int next;                     /* index of the next unclaimed one */
+  int active;                   /* workers currently mid-directory */
+  svn_boolean_t get_all;
+  svn_boolean_t strict;
+  svn_error_t *err;             /* first error any worker hit */
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_pool_t *pool;             /* for queue entries; use with LOCK held */
+};
+
+
+/* One worker's private state. */
+struct status_worker
+{
+  struct status_queue *queue;
+  apr_hash_t *statushash;       /* this worker's results */
+  apr_pool_t *pool;             /* this worker's private pool */
+};
+
+
+/* Return a deep copy of STATUS, allocated in POOL. */
+static svn_wc_status_t *
+dup_status (svn_wc_status_t *status, apr_pool_t *pool)
+{
+  svn_wc_status_t *new_status = apr_pcalloc (pool, sizeof (*new_status));
+
+  *new_status = *status;
+  if (status->entry)
+    new_status->entry = svn_wc_entry_dup (status->entry, pool);
+
+  return new_status;
+}
+
+
+static void *
+status_crawl_worker (apr_thread_t *thread, void *data)
+{
+  struct status_worker *worker = data;
+  struct status_queue *q = worker->queue;
+
+  apr_thread_mutex_lock (q->lock);
+  while (1)
+    {
+      svn_stringbuf_t *dir;
+      apr_array_header_t *subdirs;
+      svn_error_t *err;
+      int i;
+
+      /* Wait until there's either a directory to claim or nobody
+         left who could produce one. */
+      while ((q->next >= q->dirs->nelts) && (q->active > 0) && (! q->err))
+        apr_thread_cond_wait (q->cond, q->lock);
+
+      if (q->err || (q->next >= q->dirs->nelts))
+        break;
+
+      dir = APR_ARRAY_IDX (q->dirs, q->next, svn_stringbuf_t *);
+      q->next++;
+      q->active++;
+      apr_thread_mutex_unlock (q->lock);
+
+      /* Do the actual work outside the lock, against our private
+         hash and pool. */
+      subdirs = apr_array_make (worker->pool, 4, sizeof (svn_stringbuf_t *));
+      err = status_one_dir (worker->statushash,
+                            svn_stringbuf_dup (dir, worker->pool),
+                            q->get_all, q->strict, subdirs, worker->pool);
+
+      apr_thread_mutex_lock (q->lock);
+      q->active--;
+      if (err && (! q->err))
+        q->err = err;
+      for (i = 0; i < subdirs->nelts; i++)
+        {
+          svn_stringbuf_t **queued = apr_array_push (q->dirs);
+          *queued = svn_stringbuf_dup (APR_ARRAY_IDX (subdirs, i,
+                                                      svn_stringbuf_t *),
+                                       q->pool);
+        }
+
+      /* Wake the others: either there's new work for them, or --- if
+         we were the last one busy and found nothing --- it's time to
+         go home. */
+      apr_thread_cond_broadcast (q->cond);
+    }
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+/* The threaded version of the recursive directory case of
+   svn_wc_statuses: crawl the tree under PATH with NUM_THREADS
+   workers, then merge their results into STATUSHASH, allocated in
+   POOL. */
+static svn_error_t *
+crawl_statuses_threaded (apr_hash_t *statushash,
+                         svn_stringbuf_t *path,
+                         svn_boolean_t get_all,
+                         svn_boolean_t strict,
+                         int num_threads,
+                         apr_pool_t *pool)
+{
+  struct status_queue queue;
+  struct status_worker *workers;
+  apr_thread_t **threads;
+  apr_hash_t *entries;
+  apr_status_t apr_err;
+  svn_stringbuf_t **queued;
+  int i;
+
+  /* Prime the entries cache from this thread, so the workers don't
+     race to create its machinery.  (See entries.c.) */
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+
+  queue.dirs = apr_array_make (pool, 16, sizeof (svn_stringbuf_t *));
+  queued = apr_array_push (queue.dirs);
+  *queued = svn_stringbuf_dup (path, pool);
+  queue.next = 0;
+  queue.active = 0;
+  queue.get_all = get_all;
+  queue.strict = strict;
+  queue.err = NULL;
+  queue.pool = pool;
+  apr_err = apr_thread_mutex_create (&queue.lock, APR_THREAD_MUTEX_DEFAULT,
+                                     pool);
+  if (! apr_err)
+    apr_err = apr_thread_cond_create (&queue.cond, pool);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, pool,
+                             "svn_wc_statuses: can't create crawl queue");
+
+  workers = apr_pcalloc (pool, num_threads * sizeof (*workers));
+  threads = apr_pcalloc (pool, num_threads * sizeof (*threads));
+  for (i = 0; i < num_threads; i++)
+    {
+      workers[i].queue = &queue;
+
+      /* An independent top-level pool; pools aren't safe to share
+         across threads. */
+      workers[i].pool = svn_pool_create (NULL);
+      workers[i].statushash = apr_hash_make (workers[i].pool);
+
+      apr_err = apr_thread_create (&threads[i], NULL, status_crawl_worker,
+                                   &workers[i], pool);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, pool,
+                                 "svn_wc_statuses: can't create worker");
+    }
+
+  for (i = 0; i < num_threads; i++)
+    {
+      apr_status_t ignored;
+      apr_thread_join (&ignored, threads[i]);
+    }
+
+  /* If a worker failed, hand its error on.  (The error lives in that
+     worker's pool, so we can't clean the pools up here.) */
+  if (queue.err)
+    return queue.err;
+
+  /* Merge the workers' results into the caller's hash.  Each
+     directory was claimed by exactly one worker, so the keys are
+     disjoint; but be safe and never overwrite. */
+  for (i = 0; i < num_threads; i++)
+    {
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first (pool, workers[i].statushash); hi;
+           hi = apr_hash_next (hi))
+        {
+          const void *key;
+          apr_ssize_t klen;
+          void *val;
+
+          apr_hash_this (hi, &key, &klen, &val);
+          if (! apr_hash_get (statushash, key, klen))
+            apr_hash_set (statushash, apr_pstrmemdup (pool, key, klen),
+                          klen, dup_status (val, pool));
+        }
+
+      svn_pool_destroy (workers[i].pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
 svn_error_t *
 svn_wc_statuses (apr_hash_t *statushash,
                  svn_stringbuf_t *path,
@@ -450,88 +774,310 @@ svn_wc_statuses (apr_hash_t *statushash,
   /* Fill the hash with a status structure for *each* entry in PATH */
   else if (kind == svn_node_dir)
     {
-      apr_hash_t *entries;
-      apr_hash_index_t *hi;
+      apr_array_header_t *subdirs = NULL;
+      int i;
 
-      /* Load entries file for the directory into the requested pool. */
-      SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+#if APR_HAS_THREADS
+      /* If a worker pool has been requested, crawl the tree with it
+         instead of recursing serially. */
+      if (descend && (status_num_threads > 1))
+        return crawl_statuses_threaded (statushash, path, get_all, strict,
+                                        status_num_threads, pool);
+#endif
+
+      if (descend)
+        subdirs = apr_array_make (pool, 4, sizeof (svn_stringbuf_t *));
+
+      SVN_ERR (status_one_dir (statushash, path, get_all, strict,
+                               subdirs, pool));
+
+      for (i = 0; subdirs && (i < subdirs->nelts); i++)
+        SVN_ERR (svn_wc_statuses (statushash,
+                                  APR_ARRAY_IDX (subdirs, i,
+                                                 svn_stringbuf_t *),
+                                  descend, get_all, strict, pool));
+    }
 
-      /* Add the unversioned items to the status output. */
-      SVN_ERR (add_unversioned_items (path, entries, statushash, pool));
+  return SVN_NO_ERROR;
+}
 
-      /* Loop over entries hash */
-      for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
-        {
-          const void *key;
-          void *val;
-          const char *basename;
-          apr_ssize_t keylen;
 
-          /* Put fullpath into the request pool since it becomes a key
-             in the output statushash hash table. */
-          svn_stringbuf_t *fullpath = svn_stringbuf_dup (path, pool);
+/*** The single-pass status+report crawl. ***/
 
-          /* Get the next dirent */
-          apr_hash_this (hi, &key, &keylen, &val);
-          basename = (const char *) key;
-          if (strcmp (basename, SVN_WC_ENTRY_THIS_DIR) != 0)
-            {
-              svn_path_add_component_nts (fullpath, basename);
-            }
+/* The recursive engine of svn_wc_crawl_statuses: describe the tree at
+   WC_PATH + DIR_PATH to REPORTER exactly as report_revisions (see
+   adm_crawler.c) does for an update, while adding status structures
+   for the same entries to STATUSHASH.  Both jobs need a directory's
+   entries file and its dirents; doing them together reads each
+   directory once instead of twice.
+
+   DIR_REV is the revision the *parent* directory believes this
+   subtree to be at.  IN_REPORT is zero when this directory lies
+   outside the report --- e.g. a subtree scheduled for addition, which
+   the repository knows nothing about --- in which case only statuses
+   are produced.  Unlike an update crawl, this never restores missing
+   files; status is a read-only operation.
 
-          entry = (svn_wc_entry_t *) val;
+   Everything destined for STATUSHASH is allocated in POOL;
+   per-directory scratchwork lives in a subpool.  */
+static svn_error_t *
+crawl_status_and_report (apr_hash_t *statushash,
+                         svn_stringbuf_t *wc_path,
+                         svn_stringbuf_t *dir_path,
+                         svn_revnum_t dir_rev,
+                         svn_boolean_t in_report,
+                         const svn_ra_reporter_t *reporter,
+                         void *report_baton,
+                         svn_boolean_t descend,
+                         svn_boolean_t get_all,
+                         svn_boolean_t strict,
+                         apr_pool_t *pool)
+{
+  apr_hash_t *entries, *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *subpool = svn_pool_create (pool);
 
-          SVN_ERR (svn_io_check_path (fullpath->data, &kind, pool));
+  /* Construct the actual 'fullpath' = wc_path + dir_path */
+  svn_stringbuf_t *full_path = svn_stringbuf_dup (wc_path, subpool);
+  svn_path_add_component (full_path, dir_path);
 
-          /* In deciding whether or not to descend, we use the actual
-             kind of the entity, not the kind claimed by the entries
-             file.  The two are usually the same, but where they are
-             not, its usually because some directory got moved, and
-             one would still want a status report on its contents.
-             kff todo: However, must handle mixed working copies.
-             What if the subdir is not under revision control, or is
-             from another repository? */
-          
-          /* Do *not* store THIS_DIR in the statushash, unless this
-             path has never been seen before.  We don't want to add
-             the path key twice. */
-          if (! strcmp (basename, SVN_WC_ENTRY_THIS_DIR))
+  /* Get both the SVN Entries and the actual on-disk entries. */
+  SVN_ERR (svn_wc_entries_read (&entries, full_path, subpool));
+  SVN_ERR (svn_io_get_dirents (&dirents, full_path, subpool));
+
+  /* Add the unversioned items to the status output. */
+  SVN_ERR (add_unversioned_items (full_path, entries, dirents,
+                                  statushash, pool));
+
+  /* This directory's own entry carries its authoritative revision and
+     its own status; handle both here, where the entries are already
+     in hand. */
+  {
+    svn_wc_entry_t *this_dir_entry
+      = apr_hash_get (entries, SVN_WC_ENTRY_THIS_DIR, APR_HASH_KEY_STRING);
+
+    if (! apr_hash_get (statushash, full_path->data, full_path->len))
+      SVN_ERR (add_status_structure (statushash,
+                                     svn_stringbuf_dup (full_path, pool),
+                                     this_dir_entry, get_all,
+                                     strict, pool));
+
+    if (in_report && (dir_path->len > 0)
+        && (this_dir_entry->revision != dir_rev))
+      SVN_ERR (reporter->set_path (report_baton,
+                                   dir_path->data,
+                                   this_dir_entry->revision));
+
+    dir_rev = this_dir_entry->revision;
+  }
+
+  /* Looping over current directory's SVN entries: */
+  for (hi = apr_hash_first (subpool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      const char *keystring;
+      apr_ssize_t klen;
+      void *val;
+      svn_wc_entry_t *current_entry;
+      svn_stringbuf_t *full_entry_path;
+      enum svn_node_kind *dirent_kind;
+      enum svn_node_kind kind;
+      svn_boolean_t missing = FALSE;
+      svn_boolean_t report_entry;
+
+      /* Get the next entry.  Skip THIS_DIR altogether. */
+      apr_hash_this (hi, &key, &klen, &val);
+      keystring = (const char *) key;
+      current_entry = (svn_wc_entry_t *) val;
+
+      if (! strcmp (keystring, SVN_WC_ENTRY_THIS_DIR))
+        continue;
+
+      /* Compute the complete path of the entry, relative to the
+         report root. */
+      full_entry_path = svn_stringbuf_dup (dir_path, subpool);
+      svn_path_add_component_nts (full_entry_path, keystring);
+
+      /* Is the entry on disk?  What is it, really? */
+      dirent_kind = (enum svn_node_kind *) apr_hash_get (dirents, key, klen);
+      if (! dirent_kind)
+        missing = TRUE;
+      kind = dirent_kind ? *dirent_kind : svn_node_none;
+
+      /* The repository knows nothing about entries scheduled for
+         addition or deletion, so they stay out of the report. */
+      report_entry = in_report
+        && (current_entry->schedule == svn_wc_schedule_normal);
+
+      /* The report's half of the job, as in report_revisions. */
+      if (report_entry)
+        {
+          if (current_entry->kind == svn_node_file)
             {
-              svn_wc_status_t *s = apr_hash_get (statushash,
-                                                 fullpath->data,
-                                                 fullpath->len);
-              if (! s)
-                SVN_ERR (add_status_structure (statushash, fullpath,
-                                               entry, get_all, 
-                                               strict, pool));
+              if (dirent_kind && (*dirent_kind != svn_node_file))
+                /* The dirent changed kind; report it as missing, as
+                   report_revisions does. */
+                SVN_ERR (reporter->delete_path (report_baton,
+                                                full_entry_path->data));
+              else if (current_entry->revision != dir_rev)
+                SVN_ERR (reporter->set_path (report_baton,
+                                             full_entry_path->data,
+                                             current_entry->revision));
             }
-          else
+          else if ((current_entry->kind == svn_node_dir) && descend)
             {
-              if (kind == svn_node_dir && descend)
-                {
-                  /* Directory entries are incomplete.  We must get
-                     their full entry from their own THIS_DIR entry.
-                     svn_wc_entry does this for us if it can.  */
-                  svn_wc_entry_t *subdir;
-
-                  SVN_ERR (svn_wc_entry (&subdir, fullpath, pool));
-                  SVN_ERR (add_status_structure (statushash, fullpath,
-                                                 subdir, get_all, 
-                                                 strict, pool));
-                  SVN_ERR (svn_wc_statuses (statushash, fullpath,
-                                            descend, get_all, strict, pool)); 
-                }
-              else if ((kind == svn_node_file) || (kind == svn_node_none))
-                {
-                  /* File entries are ... just fine! */
-                  SVN_ERR (add_status_structure (statushash, fullpath,
-                                                 entry, get_all, 
-                                                 strict, pool));
-                }
+              if (missing)
+                /* We can't recreate dirs locally, so report as missing. */
+                SVN_ERR (reporter->delete_path (report_baton,
+                                                full_entry_path->data));
+              else if (dirent_kind && (*dirent_kind != svn_node_dir))
+                return svn_error_createf
+                  (SVN_ERR_WC_OBSTRUCTED_UPDATE, 0, NULL, subpool,
+                   "The entry '%s' is no longer a directory,\n"
+                   "which prevents proper updates.\n"
+                   "Please remove this entry and try updating again.",
+                   full_entry_path->data);
+              /* Otherwise, the recursion below makes this directory's
+                 own report. */
             }
         }
+
+      /* The status half.  As in svn_wc_statuses, we descend by the
+         entity's actual kind; a subdirectory's own status comes from
+         its THIS_DIR entry when we visit it. */
+      if (kind == svn_node_dir)
+        {
+          if (descend)
+            SVN_ERR (crawl_status_and_report (statushash, wc_path,
+                                              full_entry_path, dir_rev,
+                                              (report_entry
+                                               && (current_entry->kind
+                                                   == svn_node_dir)),
+                                              reporter, report_baton,
+                                              descend, get_all, strict,
+                                              pool));
+        }
+      else
+        {
+          /* Put fullpath into the request pool since it becomes a key
+             in the output statushash hash table. */
+          svn_stringbuf_t *fullpath = svn_stringbuf_dup (wc_path, pool);
+          svn_path_add_component (fullpath, full_entry_path);
+
+          SVN_ERR (add_status_structure (statushash, fullpath,
+                                         current_entry, get_all,
+                                         strict, pool));
+        }
     }
-  
+
+  /* We're done examining this dir's entries, so free everything. */
+  svn_pool_destroy (subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc_crawl_statuses (apr_hash_t *statushash,
+                       svn_stringbuf_t *path,
+                       const svn_ra_reporter_t *reporter,
+                       void *report_baton,
+                       svn_boolean_t descend,
+                       svn_boolean_t get_all,
+                       svn_boolean_t strict,
+                       apr_pool_t *pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  enum svn_node_kind kind;
+  svn_wc_entry_t *entry;
+  svn_revnum_t base_rev;
+  svn_boolean_t missing = FALSE;
+
+  SVN_ERR (svn_io_check_path (path->data, &kind, pool));
+
+  /* The base_rev from PATH's own entry is the first revnum that
+     entries will be compared to. */
+  SVN_ERR (svn_wc_entry (&entry, path, pool));
+  if (! entry)
+    return svn_error_createf
+      (SVN_ERR_ENTRY_NOT_FOUND, 0, NULL, pool,
+       "svn_wc_crawl_statuses: %s is not under revision control",
+       path->data);
+
+  base_rev = entry->revision;
+  if (base_rev == SVN_INVALID_REVNUM)
+    {
+      svn_stringbuf_t *parent_name = svn_stringbuf_dup (path, pool);
+      svn_wc_entry_t *parent_entry;
+      svn_path_remove_component (parent_name);
+      SVN_ERR (svn_wc_entry (&parent_entry, parent_name, pool));
+      base_rev = parent_entry->revision;
+    }
+
+  /* The first call to the reporter merely informs it that the
+     top-level directory being examined is at BASE_REV.  Its PATH
+     argument is ignored. */
+  err = reporter->set_path (report_baton, "", base_rev);
+
+  if ((! err) && (entry->schedule != svn_wc_schedule_delete)
+      && (kind == svn_node_none))
+    missing = TRUE;
+
+  if ((! err) && (entry->kind == svn_node_dir))
+    {
+      if (missing)
+        {
+          /* Always report missing directories as missing; we can't
+             recreate them locally.  Their status comes out as
+             `absent'. */
+          err = reporter->delete_path (report_baton, "");
+          if (! err)
+            err = add_status_structure (statushash, path, entry,
+                                        TRUE, strict, pool);
+        }
+      else
+        err = crawl_status_and_report (statushash, path,
+                                       svn_stringbuf_create ("", pool),
+                                       base_rev, TRUE,
+                                       reporter, report_baton,
+                                       descend, get_all, strict, pool);
+    }
+  else if (! err)
+    {
+      /* PATH is a single file (or at least not a directory): one
+         status structure, and --- since the file itself is the report
+         root --- a report of its revision under the empty path, as
+         svn_wc_crawl_revisions does. */
+      err = add_status_structure (statushash, path, entry,
+                                  TRUE, strict, pool);
+      if ((! err) && (entry->revision != base_rev))
+        err = reporter->set_path (report_baton, "", base_rev);
+    }
+
+  if (err)
+    {
+      /* Clean up the fs transaction. */
+      svn_error_t *fserr;
+      fserr = reporter->abort_report (report_baton);
+      if (fserr)
+        return svn_error_quick_wrap (fserr, "Error aborting report.");
+      else
+        return err;
+    }
+
+  /* Finish the report, which causes the status editor to be driven. */
+  err = reporter->finish_report (report_baton);
+  if (err)
+    {
+      /* Clean up the fs transaction. */
+      svn_error_t *fserr;
+      fserr = reporter->abort_report (report_baton);
+      if (fserr)
+        return svn_error_quick_wrap (fserr, "Error aborting report.");
+      else
+        return err;
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -69,6 +69,12 @@ struct edit_baton
 
 /* Look up the key PATH in EDIT_BATON->STATUSHASH.
 
+   PATH must be in canonical form (see svn_path_canonicalize), because
+   that's how svn_wc_statuses keyed the structures already in the
+   hash.  A key that differs only in spelling --- a trailing slash,
+   say --- would miss on every notification, and each miss costs a
+   trip to disk below; with canonical keys, one hash probe settles it.
+
    If the value doesn't yet exist, create a new status struct using
    EDIT_BATON->HASHPOOL.
 
@@ -192,6 +198,7 @@ make_dir_baton (const char *path,
   /* Construct the full path of this directory. */
   if (pb)
     svn_path_add_component_nts (full_path, path);
+  svn_path_canonicalize (full_path);
 
   /* Finish populating the baton members. */
   d->path         = full_path;
@@ -255,6 +262,7 @@ make_file_baton (struct dir_baton *parent_dir_baton,
   /* Construct the full path of this directory. */
   if (pb)
     svn_path_add_component_nts (full_path, path);
+  svn_path_canonicalize (full_path);
 
   /* Finish populating the baton members. */
   f->path       = full_path;
@@ -307,6 +315,7 @@ delete_entry (const char *path,
   const char *name = svn_path_basename (path, pool);
 
   svn_path_add_component_nts (full_path, path);
+  svn_path_canonicalize (full_path);
 
   /* Note:  when something is deleted, it's okay to tweak the
      statushash immediately.  No need to wait until close_file or
@@ -558,6 +567,12 @@ svn_wc_get_status_editor (const svn_delta_editor_t **editor,
   else
     eb->path = anchor;
 
+  /* All the paths this editor constructs hang off of EB->PATH, and
+     wind up as keys into STATUSHASH; keep them in canonical form so
+     they land on the keys svn_wc_statuses already put there.  (See
+     tweak_statushash.) */
+  svn_path_canonicalize (eb->path);
+
   /* Construct an editor. */
   tree_editor->set_target_revision = set_target_revision;
   tree_editor->open_root = open_root;
@@ -83,6 +83,42 @@ translate_write (apr_file_t *file,
 }
 
 
+/* Return the length of the longest prefix of BUF (which holds LEN
+   bytes) that the translation loop below would pass through
+   untouched: everything up to, but not including, the next '$' (if
+   KEYWORDS is non-null) or the next newline byte (if EOL_STR is
+   non-null).  The scanning is done with memchr, which the C library
+   implements with whatever word-at-a-time tricks the platform
+   offers, so this is much cheaper than inspecting each byte from C. */
+static apr_size_t
+uninteresting_len (const char *buf,
+                   apr_size_t len,
+                   svn_wc_keywords_t *keywords,
+                   const char *eol_str)
+{
+  const char *end = buf + len;
+  const char *p;
+
+  if (keywords)
+    {
+      p = memchr (buf, '$', end - buf);
+      if (p)
+        end = p;
+    }
+  if (eol_str)
+    {
+      p = memchr (buf, '\n', end - buf);
+      if (p)
+        end = p;
+      p = memchr (buf, '\r', end - buf);
+      if (p)
+        end = p;
+    }
+
+  return end - buf;
+}
+
+
 /* Perform the substition of VALUE into keyword string BUF (with len
    *LEN), given a pre-parsed KEYWORD (and KEYWORD_LEN), and updating
    *LEN to the new size of the substituted result.  Return TRUE if all
@@ -432,6 +468,8 @@ svn_wc_copy_and_translate (const char *src,
   char c;
   apr_size_t len;
   apr_size_t eol_str_len = eol_str ? strlen (eol_str) : 0;
+  char       buf[BUFSIZ];
+  apr_size_t buf_len = 0, buf_pos = 0;
   char       newline_buf[2] = { 0 };
   apr_size_t newline_off = 0;
   char       keyword_buf[SVN_KEYWORD_MAX_LEN] = { 0 };
@@ -468,63 +506,91 @@ svn_wc_copy_and_translate (const char *src,
      next two weeks). */
   while (err == SVN_NO_ERROR)
     {
-      /* Read a byte from SRC */
-      read_err = apr_file_getc (&c, s);
-
-      /* Check for read errors.  The docstring for apr_file_read
-         states that we cannot *both* read bytes AND get an error
-         while doing so (include APR_EOF).  Since apr_file_getc is simply a
-         wrapper around apr_file_read, we know that if we get any
-         error at all, we haven't read any bytes.  */
-      if (read_err)
+      /* Refill the read buffer when it runs dry. */
+      if (buf_pos >= buf_len)
         {
-          if (!APR_STATUS_IS_EOF(read_err))
+          buf_len = sizeof (buf);
+          read_err = apr_file_read (s, buf, &buf_len);
+          buf_pos = 0;
+
+          /* Check for read errors.  The docstring for apr_file_read
+             states that we cannot *both* read bytes AND get an error
+             while doing so (include APR_EOF).  So if we get any error
+             at all, we haven't read any bytes.  */
+          if (read_err)
             {
-              /* This was some error other than EOF! */
-              err = translate_err (read_err, "reading", src, pool);
-              goto cleanup;
-            }
-          else
-            {
-              /* We've reached the end of the file.  Close up shop.
-                 This means flushing our temporary streams.  Since we
-                 shouldn't have data in *both* temporary streams,
-                 order doesn't matter here.  However, the newline
-                 buffer will need to be translated.  */
-              if (newline_off)
+              if (!APR_STATUS_IS_EOF(read_err))
                 {
-                  if ((err = translate_newline (eol_str, eol_str_len, 
-                                                src_format, &src_format_len,
-                                                newline_buf, newline_off,
-                                                src, dst, d, repair, pool)))
-                    goto cleanup;
-                }
-              if (((len = keyword_off)) && 
-                  ((err = translate_write (d, dst, keyword_buf, len, pool))))
-                goto cleanup;
-
-              /* Close the source and destination files. */
-              apr_err = apr_file_close (s);
-              if (apr_err)
-                {
-                  s = NULL;
-                  err = translate_err (apr_err, "closing", src, pool);
+                  /* This was some error other than EOF! */
+                  err = translate_err (read_err, "reading", src, pool);
                   goto cleanup;
                 }
-              apr_err = apr_file_close (d);
-              if (apr_err)
+              else
                 {
-                  d = NULL;
-                  err = translate_err (apr_err, "closing", dst, pool);
-                  goto cleanup;
+                  /* We've reached the end of the file.  Close up shop.
+                     This means flushing our temporary streams.  Since we
+                     shouldn't have data in *both* temporary streams,
+                     order doesn't matter here.  However, the newline
+                     buffer will need to be translated.  */
+                  if (newline_off)
+                    {
+                      if ((err = translate_newline (eol_str, eol_str_len, 
+                                                    src_format,
+                                                    &src_format_len,
+                                                    newline_buf, newline_off,
+                                                    src, dst, d, repair,
+                                                    pool)))
+                        goto cleanup;
+                    }
+                  if (((len = keyword_off)) && 
+                      ((err = translate_write (d, dst, keyword_buf, len,
+                                               pool))))
+                    goto cleanup;
+
+                  /* Close the source and destination files. */
+                  apr_err = apr_file_close (s);
+                  if (apr_err)
+                    {
+                      s = NULL;
+                      err = translate_err (apr_err, "closing", src, pool);
+                      goto cleanup;
+                    }
+                  apr_err = apr_file_close (d);
+                  if (apr_err)
+                    {
+                      d = NULL;
+                      err = translate_err (apr_err, "closing", dst, pool);
+                      goto cleanup;
+                    }
+
+                  /* All done, all files closed, all is well, and all
+                     that. */
+                  return SVN_NO_ERROR;
                 }
+            }
+        }
 
-              /* All done, all files closed, all is well, and all that. */
-              return SVN_NO_ERROR;
+      /* Fast path.  When we're not in the middle of bagging up a
+         keyword or a newline --- which is nearly always --- the bytes
+         up to the next '$' or newline go through untouched, so find
+         them all at once and write them out in one go instead of
+         feeding them through the state machine below one at a time. */
+      if ((! keyword_off) && (! newline_off))
+        {
+          apr_size_t run = uninteresting_len (buf + buf_pos,
+                                              buf_len - buf_pos,
+                                              keywords, eol_str);
+          if (run)
+            {
+              if ((err = translate_write (d, dst, buf + buf_pos, run, pool)))
+                goto cleanup;
+              buf_pos += run;
+              continue;
             }
         }
 
       /* Handle the byte. */
+      c = buf[buf_pos++];
       switch (c)
         {
         case '$':
@@ -39,6 +39,11 @@
 #include "svn_io.h"
 #include "svn_hash.h"
 #include "svn_wc.h"
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 #include "svn_private_config.h"
 #include "svn_time.h"
 
@@ -76,10 +81,31 @@ struct edit_baton
   svn_boolean_t is_switch;
   svn_stringbuf_t *switch_url;
 
+#if APR_HAS_THREADS
+  /* The install pipeline, created lazily by the first close_file when
+     svn_wc_set_install_pipeline has turned it on.  Null when off. */
+  struct install_queue *install_queue;
+
+  /* The checkout apply stage, created lazily by the first pipelined
+     apply_textdelta.  Null when off or when this is not a checkout. */
+  struct apply_queue *apply_queue;
+#endif
+
   apr_pool_t *pool;
 };
 
 
+/* Whether close_file should hand file installation to a worker
+   thread; see svn_wc_set_install_pipeline. */
+static svn_boolean_t install_pipeline_enabled = FALSE;
+
+void
+svn_wc_set_install_pipeline (svn_boolean_t enabled)
+{
+  install_pipeline_enabled = enabled;
+}
+
+
 struct dir_baton
 {
   /* The path to this directory. */
@@ -119,6 +145,13 @@ struct dir_baton
      changes to be applied to this file. */
   apr_array_header_t *propchanges;
 
+  /* Entry props received for this directory, saved up in TMP_ENTRY
+     (with ENTRY_MODIFY_FLAGS saying which fields are live) so that
+     close_directory can rewrite the entries file once, instead of
+     once per property. */
+  svn_wc_entry_t tmp_entry;
+  apr_uint32_t entry_modify_flags;
+
   /* The bump information for this directory. */
   struct bump_dir_info *bump_info;
 
@@ -155,13 +188,609 @@ struct handler_baton
 {
   apr_file_t *source;
   apr_file_t *dest;
+
+  /* Checkout only: the working file, being written in step with the
+     text base.  Null during updates. */
+  apr_file_t *wfile;
+
   svn_txdelta_window_handler_t apply_handler;
   void *apply_baton;
   apr_pool_t *pool;
   struct file_baton *fb;
+
+#if APR_HAS_THREADS
+  /* Pipelined checkouts apply windows on a worker thread, and the
+     file's baton may be gone by the time the last one runs.  PATH is
+     the handler's own copy of the file's path, in POOL (which is
+     then a top-level pool). */
+  svn_boolean_t pipelined;
+  svn_stringbuf_t *path;
+#endif
 };
 
 
+static svn_error_t *maybe_bump_dir_revision (struct edit_baton *eb,
+                                             struct bump_dir_info *bdi,
+                                             apr_pool_t *pool);
+
+
+#if APR_HAS_THREADS
+
+/*** The install pipeline. ***/
+
+/* Receiving a file and installing it are two different bottlenecks:
+   one waits on the network, the other on the disk.  Run serially,
+   the edit drive pays for both in sequence.  When the pipeline is on
+   (svn_wc_set_install_pipeline), close_file instead queues the
+   install --- svn_wc_install_file plus the revision bump that must
+   follow it --- for a single worker thread, and goes straight back
+   to receiving the next file.
+
+   All the worker ever writes is the file being installed and its
+   parent's administrative area.  The editor functions that touch
+   administrative areas themselves (delete_entry, add_directory,
+   close_directory, close_edit) first wait for the queue to empty, so
+   the worker and the editor drive never have a directory's entries
+   in hand at the same time.  Bump reference counts are shared
+   between the two threads, and are only touched under the queue
+   lock. */
+
+/* How many installs may be waiting before close_file blocks. */
+#define INSTALL_QUEUE_MAX 32
+
+/* One queued installation.  Everything in here lives in POOL, an
+   independent top-level pool, since the editor's batons may be gone
+   by the time the job runs. */
+struct install_job
+{
+  const char *file_path;            /* file to install, or null for a
+                                       pure bump job */
+  svn_revnum_t new_revision;
+  const char *new_text_path;        /* may be null */
+  apr_array_header_t *props;        /* may be null */
+  struct bump_dir_info *bump_info;  /* bump to perform afterwards */
+  apr_pool_t *pool;
+};
+
+struct install_queue
+{
+  struct install_job *jobs[INSTALL_QUEUE_MAX];  /* a ring buffer */
+  int head;                   /* next job the worker will take */
+  int count;                  /* jobs waiting */
+  int active;                 /* jobs being worked on right now */
+  svn_boolean_t done;         /* no more jobs are coming */
+  svn_error_t *err;           /* first error any job produced */
+  struct edit_baton *eb;
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+};
+
+
+static void *
+install_worker (apr_thread_t *thread, void *data)
+{
+  struct install_queue *q = data;
+
+  apr_thread_mutex_lock (q->lock);
+  while (1)
+    {
+      struct install_job *job;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      while ((q->count == 0) && (! q->done))
+        apr_thread_cond_wait (q->cond, q->lock);
+      if (q->count == 0)
+        break;
+
+      job = q->jobs[q->head];
+      q->head = (q->head + 1) % INSTALL_QUEUE_MAX;
+      q->count--;
+
+      /* Once a job has failed, just drain the others unrun. */
+      if (q->err)
+        {
+          svn_pool_destroy (job->pool);
+          apr_thread_cond_broadcast (q->cond);
+          continue;
+        }
+
+      q->active++;
+      apr_thread_mutex_unlock (q->lock);
+
+      if (job->file_path)
+        err = svn_wc_install_file (job->file_path, job->new_revision,
+                                   job->new_text_path, job->props,
+                                   FALSE, /* -not- a full proplist */
+                                   NULL,  /* inherit URL from parent dir */
+                                   job->pool);
+      if ((! err) && job->bump_info)
+        err = maybe_bump_dir_revision (q->eb, job->bump_info, job->pool);
+
+      apr_thread_mutex_lock (q->lock);
+      q->active--;
+      if (err && (! q->err))
+        q->err = err;             /* ERR lives in the job pool; keep it */
+      else
+        svn_pool_destroy (job->pool);
+      apr_thread_cond_broadcast (q->cond);
+    }
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+/* Set *QUEUE_P to EB's install queue, starting the worker thread if
+   this is the first call.  (By the time anyone calls this, the edit
+   drive has long since read entries files, so the entries cache and
+   its lock already exist --- see entries.c on priming.) */
+static svn_error_t *
+get_install_queue (struct install_queue **queue_p, struct edit_baton *eb)
+{
+  struct install_queue *q = eb->install_queue;
+  apr_status_t apr_err;
+
+  if (! q)
+    {
+      q = apr_pcalloc (eb->pool, sizeof (*q));
+      q->eb = eb;
+      apr_err = apr_thread_mutex_create (&q->lock, APR_THREAD_MUTEX_DEFAULT,
+                                         eb->pool);
+      if (! apr_err)
+        apr_err = apr_thread_cond_create (&q->cond, eb->pool);
+      if (! apr_err)
+        apr_err = apr_thread_create (&q->thread, NULL, install_worker,
+                                     q, eb->pool);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, eb->pool,
+                                 "get_install_queue: "
+                                 "can't start install worker");
+      eb->install_queue = q;
+    }
+
+  *queue_p = q;
+  return SVN_NO_ERROR;
+}
+
+
+/* Build an install job for FILE_PATH (or, if FILE_PATH is null, just
+   the bump of BUMP_INFO).  Arguments are as for svn_wc_install_file,
+   and are copied into the job's own pool. */
+static struct install_job *
+make_install_job (struct edit_baton *eb,
+                  const char *file_path,
+                  const char *new_text_path,
+                  apr_array_header_t *props,
+                  struct bump_dir_info *bump_info)
+{
+  struct install_job *job;
+  apr_pool_t *job_pool;
+
+  /* An independent top-level pool; pools aren't safe to share across
+     threads. */
+  job_pool = svn_pool_create (NULL);
+  svn_pool_tag (job_pool, "wc:install-job");
+  job = apr_pcalloc (job_pool, sizeof (*job));
+  job->pool = job_pool;
+  job->new_revision = eb->target_revision;
+  job->bump_info = bump_info;
+  if (file_path)
+    job->file_path = apr_pstrdup (job_pool, file_path);
+  if (new_text_path)
+    job->new_text_path = apr_pstrdup (job_pool, new_text_path);
+  if (props)
+    {
+      int i;
+
+      job->props = apr_array_make (job_pool, props->nelts,
+                                   sizeof (svn_prop_t));
+      for (i = 0; i < props->nelts; i++)
+        {
+          const svn_prop_t *prop = &APR_ARRAY_IDX (props, i, svn_prop_t);
+          svn_prop_t *copy = apr_array_push (job->props);
+
+          copy->name = apr_pstrdup (job_pool, prop->name);
+          copy->value = prop->value
+                        ? svn_string_dup (prop->value, job_pool)
+                        : NULL;
+        }
+    }
+
+  return job;
+}
+
+
+/* Put JOB on install queue Q, blocking while the queue is full. */
+static void
+push_install_job (struct install_queue *q, struct install_job *job)
+{
+  apr_thread_mutex_lock (q->lock);
+  while (q->count == INSTALL_QUEUE_MAX)
+    apr_thread_cond_wait (q->cond, q->lock);
+  q->jobs[(q->head + q->count) % INSTALL_QUEUE_MAX] = job;
+  q->count++;
+  apr_thread_cond_broadcast (q->cond);
+  apr_thread_mutex_unlock (q->lock);
+}
+
+
+/* Queue an install of FILE_PATH (or, if FILE_PATH is null, just the
+   bump of BUMP_INFO) on EB's worker.  Arguments are as for
+   svn_wc_install_file. */
+static svn_error_t *
+queue_install_job (struct edit_baton *eb,
+                   const char *file_path,
+                   const char *new_text_path,
+                   apr_array_header_t *props,
+                   struct bump_dir_info *bump_info)
+{
+  struct install_queue *q;
+
+  SVN_ERR (get_install_queue (&q, eb));
+  push_install_job (q, make_install_job (eb, file_path, new_text_path,
+                                         props, bump_info));
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** The checkout apply stage. ***/
+
+/* During a checkout the network is one bottleneck and the disk is
+   another, but so is simply turning delta windows back into full
+   text.  The apply stage peels that work off too: when the pipeline
+   is on and the edit is a checkout, window_handler queues each
+   window for a second worker instead of applying it inline, so the
+   edit drive does nothing but parse the network stream.  The chain
+   is then
+
+      editor drive  -->  apply worker  -->  install worker
+
+   with a bounded queue between each pair of stages.
+
+   Updates are excluded: applying an update's delta reads the old
+   text base, whose access bookkeeping isn't safe off the editor
+   thread.  A checkout's windows touch only the two files opened by
+   apply_textdelta.
+
+   Ordering matters at the far end: the install of a file must not
+   start until its last window has been applied.  So close_file does
+   not queue installs directly when this stage is running; it sends
+   them down the apply queue as handoff jobs, and the apply worker
+   forwards each one to the install queue when it reaches it. */
+
+/* How many windows may be waiting before the editor drive blocks. */
+#define APPLY_QUEUE_MAX 64
+
+/* One queued window (or install handoff).  The job itself lives in
+   POOL, an independent top-level pool; HB lives in its own pool,
+   created top-level by a pipelined apply_textdelta. */
+struct apply_job
+{
+  struct handler_baton *hb;       /* handler to feed, or null for a
+                                     handoff job */
+  svn_txdelta_window_t *window;   /* null for the final window */
+  struct install_job *install;    /* handoff: forward to the install
+                                     queue */
+  apr_pool_t *pool;
+};
+
+struct apply_queue
+{
+  struct apply_job *jobs[APPLY_QUEUE_MAX];  /* a ring buffer */
+  int head;                   /* next job the worker will take */
+  int count;                  /* jobs waiting */
+  int active;                 /* jobs being worked on right now */
+  svn_boolean_t done;         /* no more jobs are coming */
+  svn_error_t *err;           /* first error any job produced */
+  struct edit_baton *eb;
+  apr_thread_mutex_t *lock;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+};
+
+
+/* Return a deep copy of WINDOW allocated in POOL.  The driver is
+   free to reuse the window the moment window_handler returns, so a
+   queued window must own its data. */
+static svn_txdelta_window_t *
+dup_txdelta_window (const svn_txdelta_window_t *window, apr_pool_t *pool)
+{
+  svn_txdelta_window_t *copy = apr_palloc (pool, sizeof (*copy));
+  svn_txdelta_op_t *ops;
+
+  *copy = *window;
+  ops = apr_palloc (pool, window->num_ops * sizeof (*ops));
+  memcpy (ops, window->ops, window->num_ops * sizeof (*ops));
+  copy->ops = ops;
+  if (window->new_data)
+    copy->new_data = svn_string_dup (window->new_data, pool);
+
+  return copy;
+}
+
+
+/* Worker-side completion of a pipelined apply: close HB's files,
+   and if ERR (or a close failure) has left the texts suspect,
+   remove them.  The file's baton may be long gone by now, so only
+   HB's own pool and path are touched.  Returns ERR, or the first
+   close error. */
+static svn_error_t *
+finish_apply (struct handler_baton *hb, svn_error_t *err)
+{
+  apr_status_t apr_err;
+
+  /* Pipelined handlers are always the checkout fast path: files open
+     at their final destinations, no tmp bookkeeping to close out. */
+  apr_err = apr_file_close (hb->dest);
+  if (! apr_err)
+    apr_err = apr_file_close (hb->wfile);
+  if (apr_err && (err == SVN_NO_ERROR))
+    err = svn_error_createf (apr_err, 0, NULL, hb->pool,
+                             "finish_apply: can't close %s",
+                             hb->path->data);
+
+  if (err != SVN_NO_ERROR)
+    {
+      /* We failed to apply the patch; clean up both texts. */
+      svn_stringbuf_t *base_path = svn_wc__text_base_path (hb->path, FALSE,
+                                                           hb->pool);
+      apr_file_remove (base_path->data, hb->pool);
+      apr_file_remove (hb->path->data, hb->pool);
+    }
+
+  return err;
+}
+
+
+static void *
+apply_worker (apr_thread_t *thread, void *data)
+{
+  struct apply_queue *q = data;
+
+  apr_thread_mutex_lock (q->lock);
+  while (1)
+    {
+      struct apply_job *job;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      while ((q->count == 0) && (! q->done))
+        apr_thread_cond_wait (q->cond, q->lock);
+      if (q->count == 0)
+        break;
+
+      job = q->jobs[q->head];
+      q->head = (q->head + 1) % APPLY_QUEUE_MAX;
+      q->count--;
+
+      /* Once a job has failed, just drain the others unrun. */
+      if (q->err)
+        {
+          svn_pool_destroy (job->pool);
+          apr_thread_cond_broadcast (q->cond);
+          continue;
+        }
+
+      q->active++;
+      apr_thread_mutex_unlock (q->lock);
+
+      if (job->hb)
+        {
+          struct handler_baton *hb = job->hb;
+
+          err = hb->apply_handler (job->window, hb->apply_baton);
+          if ((job->window == NULL) || err)
+            {
+              err = finish_apply (hb, err);
+              if (! err)
+                svn_pool_destroy (hb->pool);
+            }
+        }
+      else
+        /* A handoff: the file before this job is fully applied, so
+           its install may go out now.  (close_file made sure the
+           install queue exists before queueing us.) */
+        push_install_job (q->eb->install_queue, job->install);
+
+      apr_thread_mutex_lock (q->lock);
+      q->active--;
+      if (err && (! q->err))
+        q->err = err;       /* ERR lives in the handler's pool; keep it */
+      svn_pool_destroy (job->pool);
+      apr_thread_cond_broadcast (q->cond);
+    }
+  apr_thread_mutex_unlock (q->lock);
+
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+
+
+/* Set *QUEUE_P to EB's apply queue, starting the worker thread if
+   this is the first call. */
+static svn_error_t *
+get_apply_queue (struct apply_queue **queue_p, struct edit_baton *eb)
+{
+  struct apply_queue *q = eb->apply_queue;
+  apr_status_t apr_err;
+
+  if (! q)
+    {
+      q = apr_pcalloc (eb->pool, sizeof (*q));
+      q->eb = eb;
+      apr_err = apr_thread_mutex_create (&q->lock, APR_THREAD_MUTEX_DEFAULT,
+                                         eb->pool);
+      if (! apr_err)
+        apr_err = apr_thread_cond_create (&q->cond, eb->pool);
+      if (! apr_err)
+        apr_err = apr_thread_create (&q->thread, NULL, apply_worker,
+                                     q, eb->pool);
+      if (apr_err)
+        return svn_error_create (apr_err, 0, NULL, eb->pool,
+                                 "get_apply_queue: "
+                                 "can't start apply worker");
+      eb->apply_queue = q;
+    }
+
+  *queue_p = q;
+  return SVN_NO_ERROR;
+}
+
+
+/* Queue WINDOW (or, if WINDOW is null, HB's final cleanup) for EB's
+   apply worker, blocking while the queue is full. */
+static svn_error_t *
+queue_apply_job (struct edit_baton *eb,
+                 struct handler_baton *hb,
+                 svn_txdelta_window_t *window)
+{
+  struct apply_queue *q;
+  struct apply_job *job;
+  apr_pool_t *job_pool;
+
+  SVN_ERR (get_apply_queue (&q, eb));
+
+  job_pool = svn_pool_create (NULL);
+  svn_pool_tag (job_pool, "wc:apply-job");
+  job = apr_pcalloc (job_pool, sizeof (*job));
+  job->pool = job_pool;
+  job->hb = hb;
+  if (window)
+    job->window = dup_txdelta_window (window, job_pool);
+
+  apr_thread_mutex_lock (q->lock);
+  while (q->count == APPLY_QUEUE_MAX)
+    apr_thread_cond_wait (q->cond, q->lock);
+  q->jobs[(q->head + q->count) % APPLY_QUEUE_MAX] = job;
+  q->count++;
+  apr_thread_cond_broadcast (q->cond);
+  apr_thread_mutex_unlock (q->lock);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Send an install job down the apply queue, so it cannot overtake
+   the windows of the file it installs.  Arguments are as for
+   queue_install_job. */
+static svn_error_t *
+queue_install_handoff (struct edit_baton *eb,
+                       const char *file_path,
+                       const char *new_text_path,
+                       apr_array_header_t *props,
+                       struct bump_dir_info *bump_info)
+{
+  struct install_queue *iq;
+  struct apply_queue *q;
+  struct apply_job *job;
+  apr_pool_t *job_pool;
+
+  /* Create both queues here, on the editor thread, so the apply
+     worker never allocates from eb->pool. */
+  SVN_ERR (get_install_queue (&iq, eb));
+  SVN_ERR (get_apply_queue (&q, eb));
+
+  job_pool = svn_pool_create (NULL);
+  svn_pool_tag (job_pool, "wc:apply-job");
+  job = apr_pcalloc (job_pool, sizeof (*job));
+  job->pool = job_pool;
+  job->install = make_install_job (eb, file_path, new_text_path,
+                                   props, bump_info);
+
+  apr_thread_mutex_lock (q->lock);
+  while (q->count == APPLY_QUEUE_MAX)
+    apr_thread_cond_wait (q->cond, q->lock);
+  q->jobs[(q->head + q->count) % APPLY_QUEUE_MAX] = job;
+  q->count++;
+  apr_thread_cond_broadcast (q->cond);
+  apr_thread_mutex_unlock (q->lock);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/* Wait until every queued window has been applied, and return the
+   first error the apply stage produced.  A no-op when the stage is
+   off. */
+static svn_error_t *
+drain_apply_queue (struct edit_baton *eb)
+{
+#if APR_HAS_THREADS
+  struct apply_queue *q = eb->apply_queue;
+  svn_error_t *err;
+
+  if (! q)
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock (q->lock);
+  while ((q->count > 0) || (q->active > 0))
+    apr_thread_cond_wait (q->cond, q->lock);
+  err = q->err;
+  q->err = SVN_NO_ERROR;
+  apr_thread_mutex_unlock (q->lock);
+
+  return err;
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+
+/* Wait until every queued install has finished, and return the first
+   error any of them produced.  A no-op when the pipeline is off. */
+static svn_error_t *
+drain_install_queue (struct edit_baton *eb)
+{
+#if APR_HAS_THREADS
+  struct install_queue *q = eb->install_queue;
+  svn_error_t *err;
+
+  if (! q)
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock (q->lock);
+  while ((q->count > 0) || (q->active > 0))
+    apr_thread_cond_wait (q->cond, q->lock);
+  err = q->err;
+  q->err = SVN_NO_ERROR;
+  apr_thread_mutex_unlock (q->lock);
+
+  return err;
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+
+/* Adjust BDI's reference count by DELTA and return the new value.
+   The count is shared with the install worker when the pipeline is
+   on, so the adjustment happens under the queue lock. */
+static int
+adjust_bump_ref (struct edit_baton *eb,
+                 struct bump_dir_info *bdi,
+                 int delta)
+{
+  int count;
+
+#if APR_HAS_THREADS
+  if (eb->install_queue)
+    apr_thread_mutex_lock (eb->install_queue->lock);
+#endif
+  bdi->ref_count += delta;
+  count = bdi->ref_count;
+#if APR_HAS_THREADS
+  if (eb->install_queue)
+    apr_thread_mutex_unlock (eb->install_queue->lock);
+#endif
+
+  return count;
+}
+
+
 /* Return a new dir_baton to represent NAME (a subdirectory of
    PARENT_BATON).  If PATH is NULL, this is the root directory of the
    edit. */
@@ -238,7 +867,7 @@ make_dir_baton (const char *path,
 
   /* the parent's bump info has one more referer */
   if (pb)
-    ++bdi->parent->ref_count;
+    adjust_bump_ref (eb, bdi->parent, 1);
 
   d->edit_baton   = eb;
   d->parent_baton = pb;
@@ -278,7 +907,7 @@ maybe_bump_dir_revision (struct edit_baton *eb,
       tmp_entry.revision = eb->target_revision;
       tmp_entry.kind = svn_node_dir;
 
-      if (--bdi->ref_count > 0)
+      if (adjust_bump_ref (eb, bdi, -1) > 0)
         return SVN_NO_ERROR;    /* directory isn't done yet */
 
 
@@ -423,13 +1052,54 @@ make_file_baton (struct dir_baton *pb,
 
 /*** Helpers for the editor callbacks. ***/
 
+/* A writable stream that duplicates its output onto two open files.
+   The checkout fast path in apply_textdelta uses this to produce the
+   text base and the working file in a single pass over the delta
+   output. */
+struct tee_baton
+{
+  apr_file_t *base_file;
+  apr_file_t *working_file;
+  apr_pool_t *pool;
+};
+
+static svn_error_t *
+tee_write (void *baton, const char *data, apr_size_t *len)
+{
+  struct tee_baton *tb = baton;
+  apr_status_t apr_err;
+
+  apr_err = apr_file_write_full (tb->base_file, data, *len, NULL);
+  if (! apr_err)
+    apr_err = apr_file_write_full (tb->working_file, data, *len, NULL);
+  if (apr_err)
+    return svn_error_create (apr_err, 0, NULL, tb->pool,
+                             "tee_write: error writing checkout text");
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 window_handler (svn_txdelta_window_t *window, void *baton)
 {
   struct handler_baton *hb = baton;
   struct file_baton *fb = hb->fb;
+  svn_boolean_t streamed = (hb->wfile != NULL);
   svn_error_t *err = NULL, *err2 = NULL;
 
+#if APR_HAS_THREADS
+  if (hb->pipelined)
+    {
+      /* Hand the window to the apply worker and keep parsing.
+         Assume the apply will succeed --- if it doesn't, the queue
+         holds the error and this file's install never runs. */
+      if (window == NULL)
+        fb->text_changed = 1;
+      return queue_apply_job (fb->edit_baton, hb, window);
+    }
+#endif
+
   /* Apply this window.  We may be done at that point.  */
   err = hb->apply_handler (window, hb->apply_baton);
   if (window != NULL && err == SVN_NO_ERROR)
@@ -443,18 +1113,35 @@ window_handler (svn_txdelta_window_t *window, void *baton)
       if (err2 != SVN_NO_ERROR && err == SVN_NO_ERROR)
         err = err2;
     }
-  err2 = svn_wc__close_text_base (hb->dest, fb->path, 0, fb->pool);
-  if (err2 != SVN_NO_ERROR && err == SVN_NO_ERROR)
-    err = err2;
+  if (hb->wfile)
+    {
+      /* The checkout fast path opened plain files at their final
+         destinations; there's no tmp bookkeeping to close out. */
+      apr_status_t apr_err = apr_file_close (hb->dest);
+      if (! apr_err)
+        apr_err = apr_file_close (hb->wfile);
+      if (apr_err && err == SVN_NO_ERROR)
+        err = svn_error_createf (apr_err, 0, NULL, fb->pool,
+                                 "window_handler: can't close %s",
+                                 fb->path->data);
+    }
+  else
+    {
+      err2 = svn_wc__close_text_base (hb->dest, fb->path, 0, fb->pool);
+      if (err2 != SVN_NO_ERROR && err == SVN_NO_ERROR)
+        err = err2;
+    }
   svn_pool_destroy (hb->pool);
 
   if (err != SVN_NO_ERROR)
     {
       /* We failed to apply the patch; clean up the temporary file.  */
       svn_stringbuf_t *tmppath = svn_wc__text_base_path (fb->path,
-                                                         TRUE,
+                                                         ! streamed,
                                                          fb->pool);
       apr_file_remove (tmppath->data, fb->pool);
+      if (streamed)
+        apr_file_remove (fb->path->data, fb->pool);
     }
   else
     {
@@ -503,6 +1190,12 @@ set_target_revision (void *edit_baton, svn_revnum_t target_revision)
 {
   struct edit_baton *eb = edit_baton;
 
+  /* The edit will set a wcprop per fetched file; buffer them all and
+     write each wcprops file once, in close_edit.  (This runs before
+     the install pipeline spawns any workers, which matters: it
+     creates the batch machinery's lock.) */
+  svn_wc__wcprops_batch_begin ();
+
   /* Stashing a target_revision in the baton */
   eb->target_revision = target_revision;
   return SVN_NO_ERROR;
@@ -539,6 +1232,12 @@ delete_entry (const char *path,
   const char *basename;
   svn_stringbuf_t *log_item = svn_stringbuf_create ("", pool);
 
+  /* We're about to modify an administrative area ourselves; wait for
+     any queued installs first.  (The apply stage feeds the install
+     queue, so it drains first.) */
+  SVN_ERR (drain_apply_queue (pb->edit_baton));
+  SVN_ERR (drain_install_queue (pb->edit_baton));
+
   SVN_ERR (svn_wc_lock (pb->path, 0, pool));
   SVN_ERR (svn_wc__open_adm_file (&log_fp,
                                   pb->path,
@@ -595,6 +1294,11 @@ add_directory (const char *path,
   svn_node_kind_t kind;
   svn_stringbuf_t *cfpath;
 
+  /* We're about to create entries ourselves; wait for any queued
+     installs first. */
+  SVN_ERR (drain_apply_queue (pb->edit_baton));
+  SVN_ERR (drain_install_queue (pb->edit_baton));
+
   /* Semantic check.  Either both "copyfrom" args are valid, or they're
      NULL and SVN_INVALID_REVNUM.  A mixture is illegal semantics. */
   if ((copyfrom_path && (! SVN_IS_VALID_REVNUM (copyfrom_revision)))
@@ -684,6 +1388,11 @@ change_dir_prop (void *dir_baton,
   svn_prop_t *propchange;
   struct dir_baton *db = dir_baton;
 
+  /* Some of the cases below write to the administrative area
+     directly; wait for any queued installs first. */
+  SVN_ERR (drain_apply_queue (db->edit_baton));
+  SVN_ERR (drain_install_queue (db->edit_baton));
+
   /* If this is a 'wc' prop, store it in the administrative area and
      get on with life.  It's not a regular versioned property. */
   if (svn_wc_is_wc_prop (name))
@@ -693,33 +1402,32 @@ change_dir_prop (void *dir_baton,
      on with life.  It's not a regular user property. */
   else if (svn_wc_is_entry_prop (name))
     {
-      svn_wc_entry_t entry;
-      apr_uint32_t modify_flags = 0;
-
-      entry.kind = svn_node_dir;
+      db->tmp_entry.kind = svn_node_dir;
 
       /* a NULL-valued entry prop means the information was not
          available.  We don't remove this field from the entries file;
          we have convention just leave it empty. */
       if ((! strcmp (name, SVN_PROP_ENTRY_COMMITTED_REV)) && value)
         {
-          entry.cmt_rev = SVN_STR_TO_REV (value->data);
-          modify_flags = SVN_WC__ENTRY_MODIFY_CMT_REV;
+          db->tmp_entry.cmt_rev = SVN_STR_TO_REV (value->data);
+          db->entry_modify_flags |= SVN_WC__ENTRY_MODIFY_CMT_REV;
         }
       else if ((! strcmp (name, SVN_PROP_ENTRY_COMMITTED_DATE)) && value)
         {
-          entry.cmt_date = svn_time_from_nts (value->data);
-          modify_flags = SVN_WC__ENTRY_MODIFY_CMT_DATE;
+          db->tmp_entry.cmt_date = svn_time_from_nts (value->data);
+          db->entry_modify_flags |= SVN_WC__ENTRY_MODIFY_CMT_DATE;
         }
       else if ((! strcmp (name, SVN_PROP_ENTRY_LAST_AUTHOR)) && value)
         {
-          entry.cmt_author = svn_stringbuf_create_from_string (value, pool);
-          modify_flags = SVN_WC__ENTRY_MODIFY_CMT_AUTHOR;
+          db->tmp_entry.cmt_author
+            = svn_stringbuf_create_from_string (value, db->pool);
+          db->entry_modify_flags |= SVN_WC__ENTRY_MODIFY_CMT_AUTHOR;
         }
 
-      if (modify_flags)
-        return svn_wc__entry_modify (db->path, NULL, &entry,
-                                     modify_flags, pool);
+      /* The change lands in the entries file when close_directory
+         flushes the whole accumulated batch; rewriting the file here,
+         once per property, is what we're avoiding. */
+      return SVN_NO_ERROR;
     }
 
   /* Else, it's a real ("normal") property... */
@@ -745,6 +1453,21 @@ close_directory (void *dir_baton)
 {
   struct dir_baton *db = dir_baton;
 
+  /* Whether or not there are property changes to install, the bump
+     below may write entries; wait for any queued installs first.
+     (In a postfix-delta drive our files close *after* us, but then
+     our reference count keeps the bump from writing anything until
+     the last such file's own queued bump --- which runs on the
+     worker, where it belongs.) */
+  SVN_ERR (drain_apply_queue (db->edit_baton));
+  SVN_ERR (drain_install_queue (db->edit_baton));
+
+  /* If entry props arrived for this directory, flush the single
+     entries-file rewrite they add up to. */
+  if (db->entry_modify_flags)
+    SVN_ERR (svn_wc__entry_modify (db->path, NULL, &db->tmp_entry,
+                                   db->entry_modify_flags, db->pool));
+
   /* If this directory has property changes stored up, now is the time
      to deal with them. */
   if (db->prop_changed)
@@ -871,6 +1594,8 @@ add_or_open_file (const char *path,
      a subpool for any temporary allocations. */
   apr_pool_t *subpool = svn_pool_create (pool);
 
+  svn_pool_tag (subpool, "wc:add-or-open-file");
+
   /* ### kff todo: if file is marked as removed by user, then flag a
      conflict in the entry and proceed.  Similarly if it has changed
      kind.  see issuezilla task #398. */
@@ -975,9 +1700,24 @@ apply_textdelta (void *file_baton,
                  void **handler_baton)
 {
   struct file_baton *fb = file_baton;
-  apr_pool_t *subpool = svn_pool_create (fb->pool);
-  struct handler_baton *hb = apr_palloc (subpool, sizeof (*hb));
+  apr_pool_t *subpool;
+  struct handler_baton *hb;
   svn_error_t *err;
+  svn_boolean_t pipelined = FALSE;
+
+#if APR_HAS_THREADS
+  /* Checkouts only: applying an update's delta reads the old text
+     base, which isn't safe off the editor thread. */
+  if (install_pipeline_enabled && fb->edit_baton->is_checkout)
+    pipelined = TRUE;
+#endif
+
+  /* When the windows will be applied on the worker, the handler must
+     outlive this file's baton, so it gets a top-level pool. */
+  subpool = svn_pool_create (pipelined ? NULL : fb->pool);
+  hb = apr_palloc (subpool, sizeof (*hb));
+
+  svn_pool_tag (subpool, "wc:apply-textdelta");
 
   /* Open the text base for reading, unless this is a checkout. */
   hb->source = NULL;
@@ -1011,27 +1751,86 @@ apply_textdelta (void *file_baton,
         }
     }
 
-  /* Open the text base for writing (this will get us a temporary file).  */
+  /* Open the text base for writing.  For an update this gets us a
+     temporary file, later log-moved into place.  For a checkout there
+     is no old text base to preserve and no local file to respect
+     (add_or_open_file bails on obstructions), so skip the SVN/tmp
+     staging entirely: write the text base at its final location, and
+     tee a verbatim copy into the working file as the windows arrive.
+     If svn_wc_install_file finds that eol or keyword translation is
+     wanted after all, it re-copies through the translator; otherwise
+     the working file is already done and the usual post-hoc copy
+     never happens. */
   hb->dest = NULL;
-  err = svn_wc__open_text_base (&hb->dest, fb->path,
-                                (APR_WRITE | APR_TRUNCATE | APR_CREATE),
-                                subpool);
-  if (err)
+  hb->wfile = NULL;
+  if (fb->edit_baton->is_checkout)
     {
-      if (hb->dest)
-        svn_wc__close_text_base (hb->dest, fb->path, 0, subpool);
-      svn_pool_destroy (subpool);
-      return err;
+      svn_stringbuf_t *base_path
+        = svn_wc__text_base_path (fb->path, FALSE, subpool);
+      apr_status_t apr_err;
+
+      apr_err = apr_file_open (&hb->dest, base_path->data,
+                               (APR_WRITE | APR_TRUNCATE | APR_CREATE),
+                               APR_OS_DEFAULT, subpool);
+      if (! apr_err)
+        apr_err = apr_file_open (&hb->wfile, fb->path->data,
+                                 (APR_WRITE | APR_TRUNCATE | APR_CREATE),
+                                 APR_OS_DEFAULT, subpool);
+      if (apr_err)
+        {
+          if (hb->dest)
+            apr_file_close (hb->dest);
+          svn_pool_destroy (subpool);
+          return svn_error_createf (apr_err, 0, NULL, fb->pool,
+                                    "apply_textdelta: can't open %s",
+                                    fb->path->data);
+        }
+    }
+  else
+    {
+      err = svn_wc__open_text_base (&hb->dest, fb->path,
+                                    (APR_WRITE | APR_TRUNCATE | APR_CREATE),
+                                    subpool);
+      if (err)
+        {
+          if (hb->dest)
+            svn_wc__close_text_base (hb->dest, fb->path, 0, subpool);
+          svn_pool_destroy (subpool);
+          return err;
+        }
     }
   
   /* Prepare to apply the delta.  */
-  svn_txdelta_apply (svn_stream_from_aprfile (hb->source, subpool),
-                     svn_stream_from_aprfile (hb->dest, subpool),
-                     subpool, &hb->apply_handler, &hb->apply_baton);
+  if (hb->wfile)
+    {
+      struct tee_baton *tb = apr_palloc (subpool, sizeof (*tb));
+      svn_stream_t *tee = svn_stream_create (tb, subpool);
+
+      tb->base_file = hb->dest;
+      tb->working_file = hb->wfile;
+      tb->pool = subpool;
+      svn_stream_set_write (tee, tee_write);
+
+      svn_txdelta_apply (svn_stream_buffered
+                           (svn_stream_from_aprfile (hb->source, subpool),
+                            0, subpool),
+                         tee,
+                         subpool, &hb->apply_handler, &hb->apply_baton);
+    }
+  else
+    svn_txdelta_apply (svn_stream_buffered
+                         (svn_stream_from_aprfile (hb->source, subpool),
+                          0, subpool),
+                       svn_stream_from_aprfile (hb->dest, subpool),
+                       subpool, &hb->apply_handler, &hb->apply_baton);
   
   hb->pool = subpool;
   hb->fb = fb;
-  
+#if APR_HAS_THREADS
+  hb->pipelined = pipelined;
+  hb->path = pipelined ? svn_stringbuf_dup (fb->path, subpool) : fb->path;
+#endif
+
   /* We're all set.  */
   *handler_baton = hb;
   *handler = window_handler;
@@ -1085,6 +1884,8 @@ svn_wc_install_file (const char *file_path,
   svn_stringbuf_t *file_path_str, *parent_dir, *basename;
   svn_stringbuf_t *log_accum, *txtb, *tmp_txtb;
   svn_boolean_t is_locally_modified;
+  svn_boolean_t text_in_place = FALSE;
+  svn_stringbuf_t *checksum = NULL;
   apr_hash_t *prop_conflicts;
   apr_array_header_t *regular_props = NULL, *wc_props = NULL,
     *entry_props = NULL;
@@ -1143,9 +1944,17 @@ svn_wc_install_file (const char *file_path,
       svn_stringbuf_t *final_location =
         svn_wc__text_base_path (file_path_str, 1, pool);
       
+      /* The checkout fast path streams the new text straight to its
+         final text-base location (and a verbatim copy into the
+         working file); when NEW_TEXT_PATH is that location, there's
+         nothing to stage. */
+      if (strcmp (svn_wc__text_base_path (file_path_str, 0, pool)->data,
+                  new_text_path) == 0)
+        text_in_place = TRUE;
+
       /* Only do the 'move' if NEW_TEXT_PATH isn't -already-
          pointing to parent_dir/.svn/tmp/text-base/basename.  */
-      if (strcmp (final_location->data, new_text_path))
+      else if (strcmp (final_location->data, new_text_path))
         {
           apr_err = apr_file_rename (new_text_path, final_location->data,
                                      pool);
@@ -1295,29 +2104,65 @@ svn_wc_install_file (const char *file_path,
 
   if (new_text_path)   /* is there a new text-base to install? */
     {
-      /* Has the user made local mods to the working file?  */
-      SVN_ERR (svn_wc_text_modified_p (&is_locally_modified,
-                                       file_path_str, pool));
+      /* Has the user made local mods to the working file?  The
+         in-place case only arises on fresh checkouts, where no local
+         file predates us --- don't waste a fulltext comparison
+         discovering that the working file we just wrote matches the
+         text base we just wrote. */
+      if (text_in_place)
+        is_locally_modified = FALSE;
+      else
+        SVN_ERR (svn_wc_text_modified_p (&is_locally_modified,
+                                         file_path_str, pool));
 
       txtb     = svn_wc__text_base_path (basename, 0, pool);
-      tmp_txtb = svn_wc__text_base_path (basename, 1, pool);
+      tmp_txtb = text_in_place ? txtb
+                               : svn_wc__text_base_path (basename, 1, pool);
 
       if (! is_locally_modified)
         {
-          /* If there are no local mods, who cares whether it's a text
-             or binary file!  Just write a log command to overwrite
-             any working file with the new text-base.  If newline
-             conversion or keyword substitution is activated, this
-             will happen as well during the copy. */
-          svn_xml_make_open_tag (&log_accum,
-                                 pool,
-                                 svn_xml_self_closing,
-                                 SVN_WC__LOG_CP_AND_TRANSLATE,
-                                 SVN_WC__LOG_ATTR_NAME,
-                                 tmp_txtb,
-                                 SVN_WC__LOG_ATTR_DEST,
-                                 basename,
-                                 NULL);
+          /* Does this file call for newline conversion or keyword
+             substitution?  On a checkout the full proplist is in our
+             hands, so we can just look. */
+          svn_boolean_t needs_translation = FALSE;
+
+          if (regular_props)
+            {
+              int i;
+              for (i = 0; i < regular_props->nelts; i++)
+                {
+                  const svn_prop_t *prop
+                    = &APR_ARRAY_IDX (regular_props, i, svn_prop_t);
+                  if ((! strcmp (prop->name, SVN_PROP_EOL_STYLE))
+                      || (! strcmp (prop->name, SVN_PROP_KEYWORDS)))
+                    needs_translation = TRUE;
+                }
+            }
+
+          if (text_in_place && (! needs_translation))
+            {
+              /* The checkout fast path already wrote the working file
+                 verbatim, and with no translation in play, verbatim
+                 is exactly right.  Nothing to log. */
+            }
+          else
+            {
+              /* If there are no local mods, who cares whether it's a
+                 text or binary file!  Just write a log command to
+                 overwrite any working file with the new text-base.
+                 If newline conversion or keyword substitution is
+                 activated, this will happen as well during the
+                 copy. */
+              svn_xml_make_open_tag (&log_accum,
+                                     pool,
+                                     svn_xml_self_closing,
+                                     SVN_WC__LOG_CP_AND_TRANSLATE,
+                                     SVN_WC__LOG_ATTR_NAME,
+                                     tmp_txtb,
+                                     SVN_WC__LOG_ATTR_DEST,
+                                     basename,
+                                     NULL);
+            }
         }
   
       else   /* working file is locally modified... */
@@ -1400,6 +2245,27 @@ svn_wc_install_file (const char *file_path,
                          svn_stringbuf_create (revision_str, pool),
                          NULL);
 
+  /* Record the new text-base's checksum in the entry, so that
+     modification detection can compare the working file against it
+     without re-reading the text-base. */
+  if (new_text_path)
+    {
+      SVN_ERR (svn_io_file_checksum (&checksum,
+                                     svn_wc__text_base_path (file_path_str,
+                                                             ! text_in_place,
+                                                             pool)->data,
+                                     pool));
+      svn_xml_make_open_tag (&log_accum,
+                             pool,
+                             svn_xml_self_closing,
+                             SVN_WC__LOG_MODIFY_ENTRY,
+                             SVN_WC__LOG_ATTR_NAME,
+                             basename,
+                             SVN_WC__ENTRY_ATTR_CHECKSUM,
+                             checksum,
+                             NULL);
+    }
+
 
   /* Possibly write log commands to tweak text/prop entry timestamps:
      */
@@ -1464,17 +2330,19 @@ svn_wc_install_file (const char *file_path,
 
   if (new_text_path)
     {
-      /* Now write a log command to overwrite the old text-base file with
-         the new one. */ 
-      svn_xml_make_open_tag (&log_accum,
-                             pool,
-                             svn_xml_self_closing,
-                             SVN_WC__LOG_MV,
-                             SVN_WC__LOG_ATTR_NAME,
-                             tmp_txtb,
-                             SVN_WC__LOG_ATTR_DEST,
-                             txtb,
-                             NULL);
+      /* Now write a log command to overwrite the old text-base file
+         with the new one --- unless the new one is already sitting at
+         the text-base location. */ 
+      if (! text_in_place)
+        svn_xml_make_open_tag (&log_accum,
+                               pool,
+                               svn_xml_self_closing,
+                               SVN_WC__LOG_MV,
+                               SVN_WC__LOG_ATTR_NAME,
+                               tmp_txtb,
+                               SVN_WC__LOG_ATTR_DEST,
+                               txtb,
+                               NULL);
       
       /* Make text-base readonly */
       svn_xml_make_open_tag (&log_accum,
@@ -1502,6 +2370,12 @@ svn_wc_install_file (const char *file_path,
                                    1, /* sync */ pool));
   SVN_ERR (svn_wc__run_log (parent_dir, pool));
 
+  /* The new text-base is in its final place now; give it to the
+     shared pristine store, which may relink it to an existing copy
+     of the same contents. */
+  if (checksum)
+    SVN_ERR (svn_wc__pristine_install (file_path_str, checksum, pool));
+
   /* Now that the file's text, props, and entries are fully installed,
      we dump any "wc" props.  ### This should be done *loggily*, see
      issue #628.  */
@@ -1534,13 +2408,41 @@ close_file (void *file_baton)
   svn_stringbuf_t *new_text_path = NULL;
   apr_array_header_t *propchanges = NULL;
 
-  /* window-handler assembles new pristine text in .svn/tmp/text-base/  */
+  /* The window-handler assembles the new pristine text in
+     .svn/tmp/text-base/ for updates, or directly at its final
+     text-base location for checkouts.  svn_wc_install_file tells
+     the two apart by the path we hand it. */
   if (fb->text_changed)
-    new_text_path = svn_wc__text_base_path (fb->path, 1, fb->pool);
+    new_text_path = svn_wc__text_base_path (fb->path,
+                                            ! fb->edit_baton->is_checkout,
+                                            fb->pool);
 
   if (fb->prop_changed)
     propchanges = fb->propchanges;
 
+#if APR_HAS_THREADS
+  /* When the pipeline is on, hand the whole install --- and the bump
+     that must follow it --- to the worker, and go straight back to
+     receiving the next file.  If the apply stage is running, the
+     install must travel behind this file's windows, not around
+     them. */
+  if (install_pipeline_enabled)
+    {
+      if (fb->edit_baton->apply_queue)
+        return queue_install_handoff (fb->edit_baton,
+                                      fb->path->data,
+                                      new_text_path
+                                        ? new_text_path->data : NULL,
+                                      propchanges,
+                                      fb->bump_info);
+      return queue_install_job (fb->edit_baton,
+                                fb->path->data,
+                                new_text_path ? new_text_path->data : NULL,
+                                propchanges,
+                                fb->bump_info);
+    }
+#endif
+
   SVN_ERR (svn_wc_install_file (fb->path->data,
                                 fb->edit_baton->target_revision,
                                 new_text_path ? new_text_path->data : NULL,
@@ -1562,7 +2464,58 @@ static svn_error_t *
 close_edit (void *edit_baton)
 {
   struct edit_baton *eb = edit_baton;
-  
+
+#if APR_HAS_THREADS
+  /* The apply stage feeds the install stage, so it shuts down
+     first. */
+  if (eb->apply_queue)
+    {
+      struct apply_queue *q = eb->apply_queue;
+      apr_status_t ignored;
+
+      apr_thread_mutex_lock (q->lock);
+      q->done = TRUE;
+      apr_thread_cond_broadcast (q->cond);
+      apr_thread_mutex_unlock (q->lock);
+      apr_thread_join (&ignored, q->thread);
+
+      /* A failed apply's error lives in its handler's pool, which
+         the worker kept alive for us. */
+      if (q->err)
+        return q->err;
+      eb->apply_queue = NULL;
+    }
+
+  /* Shut the install pipeline down before doing (or judging) anything
+     else: the cleanup below walks the very entries the worker may
+     still be writing. */
+  if (eb->install_queue)
+    {
+      struct install_queue *q = eb->install_queue;
+      apr_status_t ignored;
+
+      apr_thread_mutex_lock (q->lock);
+      q->done = TRUE;
+      apr_thread_cond_broadcast (q->cond);
+      apr_thread_mutex_unlock (q->lock);
+      apr_thread_join (&ignored, q->thread);
+
+      /* A failed job's error lives in that job's pool, which the
+         worker kept alive for us. */
+      if (q->err)
+        return q->err;
+      eb->install_queue = NULL;
+    }
+#endif
+
+  /* Flush the wcprops the edit buffered -- one write per touched
+     file; see set_target_revision.  This must follow the pipeline
+     shutdown above, since the install workers buffer wcprops too.
+     An edit that errors out before reaching here abandons its
+     buffer, which is fine: wcprops are just a cache for the RA
+     layer. */
+  SVN_ERR (svn_wc__wcprops_batch_end (eb->pool));
+
   /* By definition, anybody "driving" this editor for update or switch
      purposes at a *minimum* must have called set_target_revision() at
      the outset, and close_edit() at the end -- even if it turned out
@@ -1623,6 +2576,8 @@ make_editor (svn_stringbuf_t *anchor,
   apr_pool_t *subpool = svn_pool_create (pool);
   svn_delta_editor_t *tree_editor = svn_delta_default_editor (subpool);
 
+  svn_pool_tag (subpool, "wc:update-editor");
+
   if (is_checkout)
     assert (ancestor_url != NULL);
 
@@ -1637,6 +2592,10 @@ make_editor (svn_stringbuf_t *anchor,
   eb->anchor          = anchor;
   eb->target          = target;
   eb->recurse         = recurse;
+#if APR_HAS_THREADS
+  eb->install_queue   = NULL;
+  eb->apply_queue     = NULL;
+#endif
 
   /* Construct an editor. */
   tree_editor->set_target_revision = set_target_revision;
@@ -73,9 +73,11 @@ svn_error_t *svn_wc__set_up_new_dir (svn_stringbuf_t *path,
 #define SVN_WC__ADM_FORMAT              "format"
 #define SVN_WC__ADM_README              "README"
 #define SVN_WC__ADM_ENTRIES             "entries"
+#define SVN_WC__ADM_ENTRIES_MODS        "entries-mods"
 #define SVN_WC__ADM_LOCK                "lock"
 #define SVN_WC__ADM_TMP                 "tmp"
 #define SVN_WC__ADM_TEXT_BASE           "text-base"
+#define SVN_WC__ADM_PRISTINE            "pristine"
 #define SVN_WC__ADM_PROPS               "props"
 #define SVN_WC__ADM_PROP_BASE           "prop-base"
 #define SVN_WC__ADM_DIR_PROPS           "dir-props"
@@ -32,6 +32,48 @@
 
 #define ACTIVITY_DB "dav/activities"
 
+/* A process-wide cache of activity->txn mappings, keyed by the
+   repository path and activity ID.  A commit is a long sequence of
+   CHECKOUT and PUT requests which all name the same activity, and
+   without the cache each one reopened the activities database just to
+   read back a mapping this process wrote in the first place.  Writes
+   still go through to the database below, so other server processes
+   see new activities as before.
+
+   ### no mutex protects this cache (see the similar comment on the
+   repository handle cache in libsvn_repos); multithreaded callers
+   must serialize access themselves. */
+static apr_pool_t *activity_cache_pool = NULL;
+static apr_hash_t *activity_cache = NULL;
+
+/* Return the cache key for ACTIVITY_ID within REPOS, allocated in
+   POOL.  The repository path is part of the key so that one server
+   handling several repositories keeps their activities apart. */
+static const char *activity_cache_key(const dav_svn_repos *repos,
+                                      const char *activity_id,
+                                      apr_pool_t *pool)
+{
+  return apr_pstrcat(pool, repos->fs_path, "|", activity_id, NULL);
+}
+
+/* Record ACTIVITY_ID -> TXN_NAME for REPOS in the in-process cache,
+   creating the cache the first time through. */
+static void activity_cache_set(const dav_svn_repos *repos,
+                               const char *activity_id,
+                               const char *txn_name)
+{
+  if (activity_cache == NULL)
+    {
+      activity_cache_pool = svn_pool_create(NULL);
+      activity_cache = apr_hash_make(activity_cache_pool);
+    }
+
+  apr_hash_set(activity_cache,
+               activity_cache_key(repos, activity_id, activity_cache_pool),
+               APR_HASH_KEY_STRING,
+               apr_pstrdup(activity_cache_pool, txn_name));
+}
+
 
 const char *dav_svn_get_txn(const dav_svn_repos *repos,
                             const char *activity_id)
@@ -43,6 +85,17 @@ const char *dav_svn_get_txn(const dav_svn_repos *repos,
   apr_datum_t value;
   const char *txn_name;
 
+  /* try the in-process cache before touching the database */
+  if (activity_cache != NULL)
+    {
+      txn_name = apr_hash_get(activity_cache,
+                              activity_cache_key(repos, activity_id,
+                                                 repos->pool),
+                              APR_HASH_KEY_STRING);
+      if (txn_name != NULL)
+        return txn_name;
+    }
+
   pathname = svn_stringbuf_create(repos->fs_path, repos->pool);
   svn_path_add_component_nts(pathname, ACTIVITY_DB);
   status = apr_dbm_open(&dbm, pathname->data, APR_DBM_READONLY,
@@ -69,6 +122,10 @@ const char *dav_svn_get_txn(const dav_svn_repos *repos,
 
   apr_dbm_close(dbm);
 
+  /* remember the mapping; a missing one is not remembered, since
+     another process may create the activity at any time */
+  activity_cache_set(repos, activity_id, txn_name);
+
   return txn_name;
 }
 
@@ -104,6 +161,10 @@ dav_error *dav_svn_store_activity(const dav_svn_repos *repos,
       return NULL;
     }
 
+  /* the database has it; now requests in this process can skip the
+     read back */
+  activity_cache_set(repos, activity_id, txn_name);
+
   return NULL;
 }
 
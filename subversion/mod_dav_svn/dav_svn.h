@@ -192,8 +192,25 @@ struct dav_resource_private {
 
   /* ### record the base for computing a delta during a GET */
   const char *delta_base;
+
+  /* Created-rev information for this resource's node, filled in by
+     dav_svn_get_committed_info the first time a liveprop needs it. A
+     PROPFIND asks for several properties that all derive from the
+     same node and revision records; computing them once per resource
+     keeps a depth-1 PROPFIND on a big directory from multiplying the
+     filesystem reads. */
+  svn_boolean_t committed_info_valid;
+  svn_revnum_t committed_rev;
+  svn_string_t *committed_date;      /* may be NULL */
+  svn_string_t *last_author;         /* may be NULL */
 };
 
+/* Fill in the created-rev fields of RESOURCE->info if they are not
+   already there: the node's created revision, plus that revision's
+   date and author (both fetched from the same revision record).
+   Allocates in RESOURCE's pool. */
+svn_error_t * dav_svn_get_committed_info(const dav_resource *resource);
+
 
 /*
   For a given resource, return the path that should be used when talking
@@ -338,6 +355,13 @@ const char *dav_svn_build_uri(const dav_svn_repos *repos,
                               apr_pool_t *pool);
 
 
+/* Escape PATH for use in a URI, preserving the characters that
+   ap_os_escape_path() would preserve.  If PATH needs no escaping (the
+   common case), it is returned unchanged without copying; otherwise
+   the escaped copy is allocated in POOL. */
+const char *dav_svn_escape_uri(apr_pool_t *pool, const char *path);
+
+
 /*
 ** Simple parsing of a URI. This is used for URIs which appear within a
 ** request body. It enables us to verify and break out the necessary pieces
@@ -74,11 +74,44 @@ static void get_repos_propname(dav_db *db, const dav_prop_name *name,
     }
 }
 
+/* Fetch the resource's entire property list into DB->PROPS, if it is
+   not there already.  The one walk serves every get/exists/sequence
+   call made against this database for the rest of the request; a
+   PROPFIND touches several properties per resource, and used to pay
+   for a separate proplist walk on each. */
+static dav_error *load_props(dav_db *db)
+{
+  svn_error_t *serr;
+
+  if (db->props != NULL)
+    return NULL;
+
+  /* Working Baseline, Baseline, or (Working) Version resource */
+  if (db->resource->baselined)
+    {
+      if (db->resource->type == DAV_RESOURCE_TYPE_WORKING)
+        serr = svn_fs_txn_proplist(&db->props, db->resource->info->root.txn,
+                                   db->p);
+      else
+        serr = svn_fs_revision_proplist(&db->props,
+                                        db->resource->info->repos->fs,
+                                        db->resource->info->root.rev, db->p);
+    }
+  else
+    serr = svn_fs_node_proplist(&db->props, db->resource->info->root.root,
+                                get_repos_path(db->resource->info), db->p);
+  if (serr != NULL)
+    return dav_svn_convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                               "could not fetch the resource's properties");
+
+  return NULL;
+}
+
 static dav_error *get_value(dav_db *db, const dav_prop_name *name,
                             svn_string_t **pvalue)
 {
   char *propname;
-  svn_error_t *serr;
+  dav_error *err;
 
   /* get the repos-local name */
   get_repos_propname(db, name, &propname);
@@ -92,24 +125,11 @@ static dav_error *get_value(dav_db *db, const dav_prop_name *name,
       return NULL;
     }
 
-  /* ### if db->props exists, then try in there first */
+  /* all lookups are served out of the one cached proplist */
+  if ((err = load_props(db)) != NULL)
+    return err;
 
-  /* Working Baseline, Baseline, or (Working) Version resource */
-  if (db->resource->baselined)
-    if (db->resource->type == DAV_RESOURCE_TYPE_WORKING)
-      serr = svn_fs_txn_prop(pvalue, db->resource->info->root.txn,
-                             propname, db->p);
-    else
-      serr = svn_fs_revision_prop(pvalue, db->resource->info->repos->fs,
-                                  db->resource->info->root.rev,
-                                  propname, db->p);
-  else
-    serr = svn_fs_node_prop(pvalue, db->resource->info->root.root,
-                            get_repos_path(db->resource->info),
-                            propname, db->p);
-  if (serr != NULL)
-    return dav_svn_convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
-                               "could not fetch a property");
+  *pvalue = apr_hash_get(db->props, propname, APR_HASH_KEY_STRING);
 
   return NULL;
 }
@@ -320,8 +340,6 @@ static dav_error *dav_svn_db_remove(dav_db *db, const dav_prop_name *name)
 static int dav_svn_db_exists(dav_db *db, const dav_prop_name *name)
 {
   char *propname;
-  svn_string_t *propval;
-  svn_error_t *serr;
 
   /* get the repos-local name */
   get_repos_propname(db, name, &propname);
@@ -330,23 +348,10 @@ static int dav_svn_db_exists(dav_db *db, const dav_prop_name *name)
   if (propname == NULL)
     return 0;
 
-  /* Working Baseline, Baseline, or (Working) Version resource */
-  if (db->resource->baselined)
-    if (db->resource->type == DAV_RESOURCE_TYPE_WORKING)
-      serr = svn_fs_txn_prop(&propval, db->resource->info->root.txn,
-                             propname, db->p);
-    else
-      serr = svn_fs_revision_prop(&propval, db->resource->info->repos->fs,
-                                  db->resource->info->root.rev,
-                                  propname, db->p);
-  else
-    serr = svn_fs_node_prop(&propval, db->resource->info->root.root,
-                            get_repos_path(db->resource->info),
-                            propname, db->p);
-
-  /* ### try and dispose of the value? */
+  if (load_props(db) != NULL)
+    return 0;
 
-  return serr == NULL && propval != NULL;
+  return apr_hash_get(db->props, propname, APR_HASH_KEY_STRING) != NULL;
 }
 
 static void get_name(dav_db *db, dav_prop_name *pname)
@@ -377,28 +382,11 @@ static void get_name(dav_db *db, dav_prop_name *pname)
 
 static dav_error *dav_svn_db_first_name(dav_db *db, dav_prop_name *pname)
 {
+  dav_error *err;
+
   /* if we don't have a copy of the properties, then get one */
-  if (db->props == NULL)
-    {
-      svn_error_t *serr;
-
-      /* Working Baseline, Baseline, or (Working) Version resource */
-      if (db->resource->baselined)
-        if (db->resource->type == DAV_RESOURCE_TYPE_WORKING)
-          serr = svn_fs_txn_proplist(&db->props, db->resource->info->root.txn,
-                                     db->p);
-        else
-          serr = svn_fs_revision_proplist(&db->props,
-                                          db->resource->info->repos->fs,
-                                          db->resource->info->root.rev, db->p);
-      else
-        serr = svn_fs_node_proplist(&db->props, db->resource->info->root.root,
-                                    get_repos_path(db->resource->info), db->p);
-      if (serr != NULL)
-        return dav_svn_convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
-                                   "could not begin sequencing through "
-                                   "properties");
-    }
+  if ((err = load_props(db)) != NULL)
+    return err;
 
   /* begin the iteration over the hash */
   db->hi = apr_hash_first(db->p, db->props);
@@ -97,6 +97,32 @@ static const dav_liveprop_group dav_svn_liveprop_group =
 };
 
 
+svn_error_t * dav_svn_get_committed_info(const dav_resource *resource)
+{
+  dav_resource_private *info = resource->info;
+  apr_pool_t *p = resource->pool;
+
+  if (info->committed_info_valid)
+    return SVN_NO_ERROR;
+
+  /* Get the CR field out of the node's skel.  Notice that the root
+     object might be an ID root -or- a revision root. */
+  SVN_ERR( svn_fs_node_created_rev(&info->committed_rev, info->root.root,
+                                   DAV_SVN_REPOS_PATH(resource), p) );
+
+  /* Get the date and author properties of the created revision; both
+     live in the same revision record, so the second read is cheap. */
+  SVN_ERR( svn_fs_revision_prop(&info->committed_date, info->repos->fs,
+                                info->committed_rev,
+                                SVN_PROP_REVISION_DATE, p) );
+  SVN_ERR( svn_fs_revision_prop(&info->last_author, info->repos->fs,
+                                info->committed_rev,
+                                SVN_PROP_REVISION_AUTHOR, p) );
+
+  info->committed_info_valid = TRUE;
+  return SVN_NO_ERROR;
+}
+
 static dav_prop_insert dav_svn_insert_prop(const dav_resource *resource,
                                            int propid, dav_prop_insert what,
                                            ap_text_header *phdr)
@@ -125,76 +151,36 @@ static dav_prop_insert dav_svn_insert_prop(const dav_resource *resource,
   switch (propid)
     {
     case DAV_PROPID_creationdate:
-      {
-        svn_revnum_t committed_rev = SVN_INVALID_REVNUM;
-        svn_string_t *committed_date = NULL;
-        
-        /* Get the CR field out of the node's skel.  Notice that the
-           root object might be an ID root -or- a revision root. */
-        serr = svn_fs_node_created_rev(&committed_rev,
-                                       resource->info->root.root,
-                                       DAV_SVN_REPOS_PATH(resource), p);
-        if (serr != NULL)
-          {
-            /* ### what to do? */
-            value = "###error###";
-            break;
-          }
-        
-        /* Get the date property of the created revision. */
-        serr = svn_fs_revision_prop(&committed_date,
-                                    resource->info->repos->fs,
-                                    committed_rev,
-                                    SVN_PROP_REVISION_DATE, p);
-        if (serr != NULL)
-          {
-            /* ### what to do? */
-            value = "###error###";
-            break;
-          }
-        
-        if (committed_date == NULL)
-          return DAV_PROP_INSERT_NOTDEF;
-
-        value = apr_xml_quote_string(p, committed_date->data, 1);
-        break;
-      }
+      /* the value comes from the committed-info cache, computed once
+         no matter how many liveprops draw on it. */
+      serr = dav_svn_get_committed_info(resource);
+      if (serr != NULL)
+        {
+          /* ### what to do? */
+          value = "###error###";
+          break;
+        }
+
+      if (resource->info->committed_date == NULL)
+        return DAV_PROP_INSERT_NOTDEF;
+
+      value = apr_xml_quote_string(p, resource->info->committed_date->data, 1);
+      break;
 
     case DAV_PROPID_creator_displayname:
-      {        
-        svn_revnum_t committed_rev = SVN_INVALID_REVNUM;
-        svn_string_t *last_author = NULL;
-        
-        /* Get the CR field out of the node's skel.  Notice that the
-           root object might be an ID root -or- a revision root. */
-        serr = svn_fs_node_created_rev(&committed_rev,
-                                       resource->info->root.root,
-                                       DAV_SVN_REPOS_PATH(resource), p);
-        if (serr != NULL)
-          {
-            /* ### what to do? */
-            value = "###error###";
-            break;
-          }
-        
-        /* Get the date property of the created revision. */
-        serr = svn_fs_revision_prop(&last_author,
-                                    resource->info->repos->fs,
-                                    committed_rev,
-                                    SVN_PROP_REVISION_AUTHOR, p);
-        if (serr != NULL)
-          {
-            /* ### what to do? */
-            value = "###error###";
-            break;
-          }
-
-        if (last_author == NULL)
-          return DAV_PROP_INSERT_NOTDEF;
-
-        value = apr_xml_quote_string(p, last_author->data, 1);
-        break;
-      }
+      serr = dav_svn_get_committed_info(resource);
+      if (serr != NULL)
+        {
+          /* ### what to do? */
+          value = "###error###";
+          break;
+        }
+
+      if (resource->info->last_author == NULL)
+        return DAV_PROP_INSERT_NOTDEF;
+
+      value = apr_xml_quote_string(p, resource->info->last_author->data, 1);
+      break;
 
     case DAV_PROPID_getcontentlanguage:
       /* ### need something here */
@@ -313,22 +299,16 @@ static dav_prop_insert dav_svn_insert_prop(const dav_resource *resource,
         }
       else
         {
-          svn_revnum_t committed_rev = SVN_INVALID_REVNUM;
-          
-          /* Get the CR field out of the node's skel.  Notice that the
-             root object might be an ID root -or- a revision root. */
-          serr = svn_fs_node_created_rev(&committed_rev,
-                                         resource->info->root.root,
-                                         DAV_SVN_REPOS_PATH(resource), p);
+          serr = dav_svn_get_committed_info(resource);
           if (serr != NULL)
             {
               /* ### what to do? */
               value = "###error###";
               break;
             }
-          
+
           /* Convert the revision into a quoted string */
-          s = apr_psprintf(p, "%ld", committed_rev);
+          s = apr_psprintf(p, "%ld", resource->info->committed_rev);
           value = apr_xml_quote_string(p, s, 1);
         }
       break;
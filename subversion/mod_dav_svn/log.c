@@ -65,6 +65,7 @@ static svn_error_t * log_receiver(void *baton,
                                   const char *msg)
 {
   struct log_receiver_baton *lrb = baton;
+  apr_status_t apr_err;
 
   send_xml(lrb,
            "<S:log-item>" DEBUG_CR
@@ -110,6 +111,18 @@ static svn_error_t * log_receiver(void *baton,
 
   send_xml(lrb, "</S:log-item>" DEBUG_CR);
 
+  /* Push this item at the client now instead of letting it sit in
+     the brigade until enough of them accumulate; the far end renders
+     log entries as they arrive, and the revision walk can take a
+     while between items.  Since the flush blocks until the data is
+     written, a slow client also throttles the walk rather than
+     growing our output buffers. */
+  apr_err = ap_fflush(lrb->output, lrb->bb);
+  if (apr_err)
+    /* The client hung up; no point walking any further back. */
+    return svn_error_create(apr_err, 0, NULL, lrb->pool,
+                            "client aborted log report");
+
   /* Clear out anything we may have placed in here. */
   svn_pool_clear(lrb->pool);
 
@@ -134,6 +147,7 @@ dav_error * dav_svn__log_report(const dav_resource *resource,
   svn_revnum_t start = SVN_INVALID_REVNUM;   /* defaults to HEAD */
   svn_revnum_t end = SVN_INVALID_REVNUM;     /* defaults to HEAD */
   svn_boolean_t discover_changed_paths = 0;  /* off by default */
+  int limit = 0;                             /* no limit by default */
 
   /* ### why are these paths stringbuf? they aren't going to be changed... */
   apr_array_header_t *paths
@@ -173,6 +187,11 @@ dav_error * dav_svn__log_report(const dav_resource *resource,
              (I.e., is that a traditional way to do things here?) */
           discover_changed_paths = 1;
         }
+      else if (strcmp(child->name, "limit") == 0)
+        {
+          /* ### assume no white space, no child elems, etc */
+          limit = atoi(child->first_cdata.first->text);
+        }
       else if (strcmp(child->name, "path") == 0)
         {
           /* Convert these relative paths to absolute paths in the
@@ -210,6 +229,7 @@ dav_error * dav_svn__log_report(const dav_resource *resource,
                             start,
                             end,
                             discover_changed_paths,
+                            limit,
                             log_receiver,
                             &lrb,
                             resource->pool);
@@ -51,6 +51,12 @@
    #################################################################
 */
 
+/* Pass the brigade along once this much response text has built up.
+   Everything used to sit in the brigade until the very end of the
+   MERGE, so a big commit meant a response as large as the change list
+   and a long silence before the first byte reached the client. */
+#define MERGE_RESPONSE_FLUSH_SIZE 8192
+
 typedef struct {
   apr_pool_t *pool;
   ap_filter_t *output;
@@ -114,6 +120,7 @@ static svn_error_t *send_response(mr_baton *baton, svn_boolean_t is_dir)
   svn_stringbuf_t *stable_id;
   const char *vsn_url;
   apr_status_t status;
+  apr_off_t buffered;
 
   href = dav_svn_build_uri(mrc->repos, DAV_SVN_BUILD_URI_PUBLIC,
                            SVN_IGNORED_REVNUM, baton->path,
@@ -152,6 +159,18 @@ static svn_error_t *send_response(mr_baton *baton, svn_boolean_t is_dir)
     return svn_error_create(status, 0, NULL, baton->pool,
                             "could not write response to output");
 
+  /* if enough has piled up in the brigade, then send it on down the
+     filter stack rather than hold the whole response in memory. */
+  buffered = 0;
+  (void) apr_brigade_length(mrc->bb, 1, &buffered);
+  if (buffered >= MERGE_RESPONSE_FLUSH_SIZE)
+    {
+      status = ap_fflush(mrc->output, mrc->bb);
+      if (status != APR_SUCCESS)
+        return svn_error_create(status, 0, NULL, baton->pool,
+                                "could not flush response to output");
+    }
+
   return APR_SUCCESS;
 }
 
@@ -394,6 +413,11 @@ dav_error * dav_svn__merge_response(ap_filter_t *output,
 
                      NULL);
 
+  /* get the start of the response onto the wire right away; walking the
+     delta of a big commit can take a while, and the client should see
+     something happening rather than silence. */
+  (void) ap_fflush(output, bb);
+
   /* Now we need to generate responses for all the resources which changed.
      This is done through a delta of the two roots.
 
@@ -438,6 +462,7 @@ dav_error * dav_svn__merge_response(ap_filter_t *output,
                              FALSE, /* don't bother with text-deltas */
                              TRUE, /* Do recurse into subdirectories */
                              FALSE, /* Do not allow copyfrom args */
+                             NULL,  /* no path filter */
                              pool);
   if (serr != NULL)
     {
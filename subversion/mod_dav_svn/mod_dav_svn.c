@@ -28,6 +28,7 @@
 
 #include "svn_version.h"
 #include "svn_pools.h"
+#include "svn_repos.h"
 
 #include "dav_svn.h"
 
@@ -171,7 +172,23 @@ static const char *dav_svn_special_uri_cmd(cmd_parms *cmd, void *config,
     return NULL;
 }
 
-
+static const char *dav_svn_cache_size_cmd(cmd_parms *cmd, void *config,
+                                          const char *arg1)
+{
+    /* The repository handle cache is process-wide, not per-server, so
+       this just pushes the limit straight down into libsvn_repos. */
+    int limit = atoi(arg1);
+
+    if (limit < 0 || (limit == 0 && strcmp(arg1, "0") != 0))
+      return "SVNReposCacheSize must be a number: 0 to disable the cache, "
+             "or the most repository handles to keep open per process.";
+
+    svn_repos_set_cache_size(limit);
+
+    return NULL;
+}
+
+
 /** Accessor functions for the module's configuration state **/
 
 const char *dav_svn_get_fs_path(request_rec *r)
@@ -218,6 +235,12 @@ static const command_rec dav_svn_cmds[] =
   AP_INIT_TAKE1("SVNReposName", dav_svn_repo_name, NULL, ACCESS_CONF,
                 "specify the name of a Subversion repository"),
 
+  /* per process */
+  AP_INIT_TAKE1("SVNReposCacheSize", dav_svn_cache_size_cmd, NULL, RSRC_CONF,
+                "limit how many open repository handles each server "
+                "process keeps cached between requests (0 disables "
+                "the cache; the default is no limit)"),
+
   { NULL }
 };
 
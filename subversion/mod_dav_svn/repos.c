@@ -828,6 +828,41 @@ static void log_warning(void *baton, const char *fmt, ...)
   ap_log_rerror(APLOG_MARK, APLOG_ERR, APR_EGENERAL, r, "%s", s);
 }
 
+#ifdef SVN_FS_TRAIL_STATS
+/* Baton for log_fs_stats: the request, the filesystem it operated on,
+   and the filesystem's counters as they stood when the request began.
+   The filesystem object outlives the request (it comes from the
+   process-wide repository cache), so its counters accumulate across
+   requests and we log the difference. */
+typedef struct {
+  request_rec *r;
+  svn_fs_t *fs;
+  svn_fs_stats_t start;
+} fs_stats_baton;
+
+/* Pool cleanup function: log how much Berkeley DB work the request
+   caused at the storage layer. Registered on r->pool, so it runs when
+   the request is torn down. */
+static apr_status_t log_fs_stats(void *data)
+{
+  fs_stats_baton *b = data;
+  svn_fs_stats_t end;
+
+  svn_fs_get_stats(&end, b->fs);
+  ap_log_rerror(APLOG_MARK, APLOG_INFO, 0, b->r,
+                "fs-stats: %s %s: gets=%ld puts=%ld cursor-ops=%ld "
+                "trails=%ld deadlocks=%ld trail-usec=%" APR_TIME_T_FMT,
+                b->r->method, b->r->uri,
+                (long) (end.db_gets - b->start.db_gets),
+                (long) (end.db_puts - b->start.db_puts),
+                (long) (end.db_cursor_ops - b->start.db_cursor_ops),
+                (long) (end.trails - b->start.trails),
+                (long) (end.deadlocks - b->start.deadlocks),
+                end.trail_time - b->start.trail_time);
+  return APR_SUCCESS;
+}
+#endif /* SVN_FS_TRAIL_STATS */
+
 static dav_error * dav_svn_get_resource(request_rec *r,
                                         const char *root_path,
                                         const char *label,
@@ -963,8 +998,9 @@ static dav_error * dav_svn_get_resource(request_rec *r,
   if ((repos->username = r->user) == NULL)
     repos->username = "anonymous";
 
-  /* open the SVN FS */
-  serr = svn_repos_open(&(repos->repos), fs_path, r->pool);
+  /* open the SVN FS.  Use the process-wide repository cache, so the
+     Berkeley DB environment isn't reopened on every request. */
+  serr = svn_repos_open_cached(&(repos->repos), fs_path, r->pool);
   if (serr != NULL)
     {
       return dav_svn_convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
@@ -979,6 +1015,20 @@ static dav_error * dav_svn_get_resource(request_rec *r,
   /* capture warnings during cleanup of the FS */
   svn_fs_set_warning_func(repos->fs, log_warning, r);
 
+#ifdef SVN_FS_TRAIL_STATS
+  /* snapshot the storage-layer counters now, and log the difference
+     when the request is torn down */
+  {
+    fs_stats_baton *b = apr_pcalloc(r->pool, sizeof(*b));
+
+    b->r = r;
+    b->fs = repos->fs;
+    svn_fs_get_stats(&b->start, b->fs);
+    apr_pool_cleanup_register(r->pool, b, log_fs_stats,
+                              apr_pool_cleanup_null);
+  }
+#endif /* SVN_FS_TRAIL_STATS */
+
   /* Figure out the type of the resource. Note that we have a PARSE step
      which is separate from a PREP step. This is because the PARSE can
      map multiple URLs to the same resource type. The PREP operates on
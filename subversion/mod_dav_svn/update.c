@@ -28,6 +28,7 @@
 #include "svn_fs.h"
 #include "svn_xml.h"
 #include "svn_path.h"
+#include "svn_base64.h"
 
 #include "dav_svn.h"
 
@@ -47,6 +48,11 @@ typedef struct {
      vsn-url's during the edit. */
   const char *dst_path;
 
+  /* if the client said it can digest them, we inline the file deltas
+     into the report as base64 svndiff elements, instead of directing
+     the client back to us for one GET per file. */
+  svn_boolean_t send_text_deltas;
+
   /* this buffers the output for a bit and is automatically flushed,
      at appropriate times, by the Apache filter system. */
   apr_bucket_brigade *bb;
@@ -63,6 +69,10 @@ typedef struct {
   svn_boolean_t added;
   apr_array_header_t *changed_props;
   apr_array_header_t *removed_props;
+
+  /* a scratch pool for the current inline delta chunk, cleared
+     between chunks; NULL unless this file's delta is being inlined. */
+  apr_pool_t *delta_pool;
 } item_baton_t;
 
 #define DIR_OR_FILE(is_dir) ((is_dir) ? "directory" : "file")
@@ -403,12 +413,51 @@ static svn_error_t * noop_handler(svn_txdelta_window_t *window, void *baton)
   return NULL;
 }
 
-static svn_error_t * upd_apply_textdelta(void *file_baton, 
+/* Write one chunk of svndiff data as its own S:txdelta element.  Each
+   element is base64-encoded independently of the others, so the
+   client can decode them one at a time and hand the raw bytes to its
+   svndiff parser as they arrive, rather than buffering a file's whole
+   delta. */
+static svn_error_t * upd_write_delta_chunk(void *baton, const char *data,
+                                           apr_size_t *len)
+{
+  item_baton_t *file = baton;
+  svn_stringbuf_t *chunk;
+  svn_stringbuf_t *encoded;
+
+  /* toss the previous chunk's allocations */
+  svn_pool_clear(file->delta_pool);
+
+  chunk = svn_stringbuf_ncreate(data, *len, file->delta_pool);
+  encoded = svn_base64_encode_string(chunk, file->delta_pool);
+
+  /* base64 output is XML-safe, so no quoting is needed. */
+  send_xml(file->uc, "<S:txdelta>%s</S:txdelta>" DEBUG_CR, encoded->data);
+
+  return NULL;
+}
+
+static svn_error_t * upd_apply_textdelta(void *file_baton,
                                        svn_txdelta_window_handler_t *handler,
                                        void **handler_baton)
 {
   item_baton_t *file = file_baton;
 
+  if (file->uc->send_text_deltas)
+    {
+      /* inline the svndiff right here, in place of the follow-up GET
+         round trip the client would otherwise make per file. */
+      svn_stream_t *out;
+
+      file->delta_pool = svn_pool_create(file->pool);
+
+      out = svn_stream_create(file, file->pool);
+      svn_stream_set_write(out, upd_write_delta_chunk);
+      svn_txdelta_to_svndiff(out, file->pool, handler, handler_baton);
+
+      return NULL;
+    }
+
   /* if we added the file, then no need to tell the client to fetch it */
   if (!file->added)
     send_xml(file->uc, "<S:fetch-file/>" DEBUG_CR);
@@ -420,7 +469,13 @@ static svn_error_t * upd_apply_textdelta(void *file_baton,
 
 static svn_error_t * upd_close_file(void *file_baton)
 {
-  close_helper(FALSE /* is_dir */, file_baton);
+  item_baton_t *file = file_baton;
+
+  close_helper(FALSE /* is_dir */, file);
+
+  if (file->delta_pool)
+    svn_pool_destroy(file->delta_pool);
+
   return NULL;
 }
 
@@ -468,6 +523,24 @@ dav_error * dav_svn__update_report(const dav_resource *resource,
                            "is required.");
     }
   
+  /* A client that can digest inline text deltas says so on the root
+     element; everyone else keeps getting fetch-file hrefs and making
+     one GET per file, as before. */
+  {
+    apr_xml_attr *this_attr;
+
+    for (this_attr = doc->root->attr; this_attr != NULL;
+         this_attr = this_attr->next)
+      {
+        if (strcmp(this_attr->name, "send-all") == 0
+            && strcmp(this_attr->value, "true") == 0)
+          {
+            uc.send_text_deltas = TRUE;
+            break;
+          }
+      }
+  }
+
   for (child = doc->root->first_child; child != NULL; child = child->next)
     {
       if (child->ns == ns && strcmp(child->name, "target-revision") == 0)
@@ -577,13 +650,16 @@ dav_error * dav_svn__update_report(const dav_resource *resource,
      dir_delta() between REPOS_PATH/TARGET and TARGET_PATH.  In the
      case of an update or status, these paths should be identical.  In
      the case of a switch, they should be different. */
-  serr = svn_repos_begin_report(&rbaton, revnum, repos->username, 
-                                repos->repos, 
+  serr = svn_repos_begin_report(&rbaton, revnum, repos->username,
+                                repos->repos,
                                 resource->info->repos_path, target,
                                 dir_delta_target,
-                                FALSE, /* don't send text-deltas */
+                                uc.send_text_deltas,
                                 recurse,
-                                editor, &uc, resource->pool);
+                                editor, &uc,
+                                NULL, /* no cross-request report cache */
+                                NULL, /* no path filter */
+                                resource->pool);
 
   if (serr != NULL)
     {
@@ -62,6 +62,103 @@ dav_error * dav_svn_convert_err(const svn_error_t *serr, int status,
     return derr;
 }
 
+/* The bytes that can appear in a URI path without escaping, as a
+   table indexed by unsigned char.  This is the same set that
+   ap_os_escape_path() preserves: alphanumerics plus the characters
+   "$-_.+!*'(),:@&=/~".  Scanning runs with one table load per byte
+   keeps the (overwhelmingly common) all-clean path nearly free; the
+   XML escaper in libsvn_subr/xml.c uses the same trick. */
+static const char uri_safe[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*   0 -  15 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /*  16 -  31 */
+  0, 1, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   /*  32 -  47 */
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 1, 0, 0,   /*  48 -  63 */
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   /*  64 -  79 */
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,   /*  80 -  95 */
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   /*  96 - 111 */
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,   /* 112 - 127 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 128 - 143 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 144 - 159 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 160 - 175 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 176 - 191 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 192 - 207 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 208 - 223 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 224 - 239 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0   /* 240 - 255 */
+};
+
+
+/* Return how many leading bytes of DATA (which has length LEN) can be
+   copied into a URI without escaping. */
+static apr_size_t count_uri_safe_bytes(const char *data, apr_size_t len)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  apr_size_t remaining = len;
+
+  while (remaining >= 4)
+    {
+      if (!uri_safe[p[0]] || !uri_safe[p[1]]
+          || !uri_safe[p[2]] || !uri_safe[p[3]])
+        break;
+      p += 4;
+      remaining -= 4;
+    }
+
+  while (remaining > 0 && uri_safe[*p])
+    {
+      p++;
+      remaining--;
+    }
+
+  return (apr_size_t) ((const char *) p - data);
+}
+
+
+const char *dav_svn_escape_uri(apr_pool_t *pool, const char *path)
+{
+  static const char hexchars[] = "0123456789ABCDEF";
+  apr_size_t len = strlen(path);
+  apr_size_t run = count_uri_safe_bytes(path, len);
+  const char *p = path + run;
+  const char *end = path + len;
+  char *result;
+  char *dst;
+
+  /* Almost every path is clean; hand it back untouched so the common
+     case costs one scan and no allocation. */
+  if (run == len)
+    return path;
+
+  /* In the worst case, every remaining byte expands to "%XX". */
+  result = apr_palloc(pool, run + 3 * (len - run) + 1);
+  memcpy(result, path, run);
+  dst = result + run;
+
+  while (p < end)
+    {
+      unsigned char c = (unsigned char) *p;
+
+      if (uri_safe[c])
+        {
+          apr_size_t chunk = count_uri_safe_bytes(p, end - p);
+          memcpy(dst, p, chunk);
+          dst += chunk;
+          p += chunk;
+        }
+      else
+        {
+          *dst++ = '%';
+          *dst++ = hexchars[c >> 4];
+          *dst++ = hexchars[c & 0x0f];
+          p++;
+        }
+    }
+
+  *dst = '\0';
+  return result;
+}
+
+
 const char *dav_svn_build_uri(const dav_svn_repos *repos,
                               enum dav_svn_build_what what,
                               svn_revnum_t revision,
@@ -90,12 +187,14 @@ const char *dav_svn_build_uri(const dav_svn_repos *repos,
 
     case DAV_SVN_BUILD_URI_PUBLIC:
       return apr_psprintf(pool, "%s%s%s%s",
-                          href1, root_path, path, href2);
+                          href1, root_path,
+                          dav_svn_escape_uri(pool, path), href2);
 
     case DAV_SVN_BUILD_URI_VERSION:
       /* path is the STABLE_ID */
       return apr_psprintf(pool, "%s%s/%s/ver/%s%s",
-                          href1, root_path, special_uri, path, href2);
+                          href1, root_path, special_uri,
+                          dav_svn_escape_uri(pool, path), href2);
 
     case DAV_SVN_BUILD_URI_VCC:
       return apr_psprintf(pool, "%s%s/%s/vcc/" DAV_SVN_DEFAULT_VCC_NAME "%s",
@@ -129,6 +228,13 @@ svn_error_t *dav_svn_simple_parse_uri(dav_svn_uri_info *info,
 
   path = comp.path;
 
+  /* httpd unescapes the request-URI before we ever see it, but URIs
+     quoted into a request body arrive exactly as the client sent
+     them; decode any escaping so the parsing below sees plain
+     paths. */
+  if (ap_unescape_url(path) != OK)
+    goto malformed_uri;
+
   /* clean up the URI */
   ap_getparents(path);
   ap_no2slash(path);
@@ -23,17 +23,26 @@ typedef enum svnadmin_cmd_t
 {
   svnadmin_cmd_unknown = 0,
 
+  svnadmin_cmd_build_changes,
   svnadmin_cmd_create,
   svnadmin_cmd_createtxn,
   svnadmin_cmd_deltify,
+  svnadmin_cmd_dump,
+  svnadmin_cmd_gc,
+  svnadmin_cmd_hotbackup,
+  svnadmin_cmd_load,
   svnadmin_cmd_lscr,
   svnadmin_cmd_lsrevs,
   svnadmin_cmd_lstxns,
+  svnadmin_cmd_purgetxns,
+  svnadmin_cmd_qdeltify,
   svnadmin_cmd_recover,
   svnadmin_cmd_rmtxns,
+  svnadmin_cmd_rundeltify,
   svnadmin_cmd_setlog,
   svnadmin_cmd_shell,
   svnadmin_cmd_undeltify,
+  svnadmin_cmd_verify,
   svnadmin_cmd_youngest
 
 } svnadmin_cmd_t;
@@ -113,6 +122,12 @@ usage (const char *progname, int exit_code)
      "\n"
      "Subcommands are: \n"
      "\n"
+     "   build-changes REPOS_PATH\n"
+     "      Build the changed-paths index entries for revisions that\n"
+     "      don't have one.  Commits maintain the index automatically;\n"
+     "      run this once on repositories created before the index\n"
+     "      existed.  Already indexed revisions are left alone.\n"
+     "\n"
      "   create    REPOS_PATH\n"
      "      Create a new, empty repository at REPOS_PATH.\n"
      "\n"
@@ -125,6 +140,31 @@ usage (const char *progname, int exit_code)
      "      a directory, perform a recursive deltification of the\n"
      "      tree starting at PATH.\n"
      "\n"
+     "   dump      REPOS_PATH [LOWER_REV [UPPER_REV]]\n"
+     "      Write a dump stream for the given revision range (default:\n"
+     "      all of them) to stdout.  File contents are carried as\n"
+     "      deltas, so dumping from the last revision a backup holds\n"
+     "      gives an incremental backup.\n"
+     "\n"
+     "   gc        REPOS_PATH\n"
+     "      Delete the dead records that aborted transactions and\n"
+     "      obsolete fulltexts leave in the database, returning their\n"
+     "      pages for reuse.  Runs as a single database transaction;\n"
+     "      best run when the repository is quiet.\n"
+     "\n"
+     "   hot-backup REPOS_PATH BACKUP_PATH [--incremental]\n"
+     "      Copy the repository's Berkeley DB environment to\n"
+     "      BACKUP_PATH while the repository stays live, using the\n"
+     "      documented hot-backup procedure: database files first,\n"
+     "      log files after, then recovery on the copy.  With\n"
+     "      \"--incremental\", only log segments the backup does not\n"
+     "      already hold are shipped.  Either way, log files the live\n"
+     "      environment no longer needs are removed afterwards.\n"
+     "\n"
+     "   load      REPOS_PATH\n"
+     "      Read a dump stream from stdin and commit its revisions.\n"
+     "      Revisions the repository already has are skipped.\n"
+     "\n"
      "   lscr      REPOS_PATH PATH\n"
      "      Print, one-per-line and youngest-to-eldest, the revisions in\n"
      "      which PATH was modified.\n"
@@ -149,9 +189,24 @@ usage (const char *progname, int exit_code)
      "      ought to be run.\n"
      "\n"
 #endif /* 0 */
+     "   purge-txns REPOS_PATH AGE_DAYS\n"
+     "      Delete every uncommitted transaction more than AGE_DAYS\n"
+     "      days old, with all the nodes it owns, in one database\n"
+     "      transaction.  Choose an age comfortably longer than your\n"
+     "      longest commit: an in-progress commit's transaction looks\n"
+     "      just like an abandoned one.  Suitable for a nightly job.\n"
+     "\n"
+     "   qdeltify  REPOS_PATH REVISION PATH\n"
+     "      Queue PATH in REVISION for later deltification by the\n"
+     "      rundeltify subcommand.  Unlike deltify, this returns\n"
+     "      immediately, so it is suitable for post-commit hooks.\n"
+     "\n"
      "   rmtxns    REPOS_PATH TXN_NAME [...]\n"
      "      Delete the transaction(s) named TXN_NAME.\n"
      "\n"
+     "   rundeltify REPOS_PATH\n"
+     "      Deltify everything queued by qdeltify, and empty the queue.\n"
+     "\n"
      "   setlog    REPOS_PATH REVNUM FILE\n"
      "      Set the log-message on revision REVNUM to the contents of FILE.\n"
      "      (Careful!  Revision props are not historied, so this command\n"
@@ -165,6 +220,12 @@ usage (const char *progname, int exit_code)
      "      If PATH represents a directory, perform a recursive\n"
      "      undeltification of the tree starting at PATH.\n"
      "\n"
+     "   verify    REPOS_PATH\n"
+     "      Check the integrity of the repository's database tables:\n"
+     "      validate every record and make sure all cross-references\n"
+     "      between tables resolve.  This never reconstructs file\n"
+     "      contents, so it is much faster than walking the trees.\n"
+     "\n"
      "   youngest  REPOS_PATH\n"
      "      Print the latest revision number.\n"
      "\n"
@@ -182,7 +243,9 @@ usage (const char *progname, int exit_code)
 static svnadmin_cmd_t 
 parse_command (const char *command)
 {
-  if (! strcmp (command, "create"))
+  if (! strcmp (command, "build-changes"))
+    return svnadmin_cmd_build_changes;
+  else if (! strcmp (command, "create"))
     return svnadmin_cmd_create;
   else if (! strcmp (command, "youngest"))
     return svnadmin_cmd_youngest;
@@ -194,6 +257,8 @@ parse_command (const char *command)
     return svnadmin_cmd_lsrevs;
   else if (! strcmp (command, "rmtxns"))
     return svnadmin_cmd_rmtxns;
+  else if (! strcmp (command, "purge-txns"))
+    return svnadmin_cmd_purgetxns;
   else if (! strcmp (command, "createtxn"))
     return svnadmin_cmd_createtxn;
   else if (! strcmp (command, "setlog"))
@@ -204,8 +269,22 @@ parse_command (const char *command)
     return svnadmin_cmd_undeltify;
   else if (! strcmp (command, "deltify"))
     return svnadmin_cmd_deltify;
+  else if (! strcmp (command, "dump"))
+    return svnadmin_cmd_dump;
+  else if (! strcmp (command, "gc"))
+    return svnadmin_cmd_gc;
+  else if (! strcmp (command, "hot-backup"))
+    return svnadmin_cmd_hotbackup;
+  else if (! strcmp (command, "load"))
+    return svnadmin_cmd_load;
+  else if (! strcmp (command, "qdeltify"))
+    return svnadmin_cmd_qdeltify;
+  else if (! strcmp (command, "rundeltify"))
+    return svnadmin_cmd_rundeltify;
   else if (! strcmp (command, "recover"))
     return svnadmin_cmd_recover;
+  else if (! strcmp (command, "verify"))
+    return svnadmin_cmd_verify;
 
   return svnadmin_cmd_unknown;
 }
@@ -367,6 +446,98 @@ main (int argc, const char * const *argv)
       }
       break;
 
+    case svnadmin_cmd_dump:
+      {
+        svn_revnum_t
+          lower = SVN_INVALID_REVNUM,
+          upper = SVN_INVALID_REVNUM;
+
+        INT_ERR (svn_repos_open (&repos, path, pool));
+
+        /* Do the args tell us what revisions to dump? */
+        if (argv[3])
+          {
+            lower = SVN_STR_TO_REV (argv[3]);
+            if (argv[4])
+              upper = SVN_STR_TO_REV (argv[4]);
+            else
+              upper = lower;
+          }
+
+        INT_ERR (svn_repos_dump_fs (repos,
+                                    svn_stream_from_stdio (stdout, pool),
+                                    lower, upper, pool));
+      }
+      break;
+
+    case svnadmin_cmd_hotbackup:
+      {
+        const char *backup_path;
+        svn_boolean_t incremental = FALSE;
+        apr_array_header_t *logfiles;
+        int i;
+
+        if (argc == 5)
+          {
+            if (strcmp (argv[4], "--incremental") != 0)
+              {
+                usage (argv[0], 1);
+                /* NOTREACHED */
+              }
+            incremental = TRUE;
+          }
+        else if (argc != 4)
+          {
+            usage (argv[0], 1);
+            /* NOTREACHED */
+          }
+
+        backup_path = argv[3];
+
+        /* Open the repository.  This takes the usual shared lock, so
+           commits proceed unhindered while we copy. */
+        INT_ERR (svn_repos_open (&repos, path, pool));
+
+        printf ("Backing up repository to `%s'...", backup_path);
+        fflush (stdout);
+        INT_ERR (svn_fs_berkeley_hotcopy (svn_repos_db_env (repos, pool),
+                                          backup_path, incremental, pool));
+        printf ("done.\n");
+
+        /* The backup now holds a copy of every log file, so archive
+           the ones the live environment no longer needs. */
+        INT_ERR (svn_fs_berkeley_logfiles (&logfiles,
+                                           svn_repos_db_env (repos, pool),
+                                           TRUE, pool));
+        for (i = 0; i < logfiles->nelts; i++)
+          {
+            const char *logfile = ((const char **) logfiles->elts)[i];
+            apr_status_t apr_err;
+
+            apr_err = apr_file_remove
+              (apr_psprintf (pool, "%s/%s",
+                             svn_repos_db_env (repos, pool), logfile),
+               pool);
+            if (apr_err)
+              {
+                printf ("error removing log file `%s'\n", logfile);
+                return EXIT_FAILURE;
+              }
+          }
+        if (logfiles->nelts)
+          printf ("Removed %d unused log file(s).\n", logfiles->nelts);
+      }
+      break;
+
+    case svnadmin_cmd_load:
+      {
+        INT_ERR (svn_repos_open (&repos, path, pool));
+        INT_ERR (svn_repos_load_fs (repos,
+                                    svn_stream_from_stdio (stdin, pool),
+                                    pool));
+      }
+      break;
+
     case svnadmin_cmd_lsrevs:
       {
         svn_revnum_t
@@ -454,6 +625,30 @@ main (int argc, const char * const *argv)
       }
       break;
 
+    case svnadmin_cmd_purgetxns:
+      {
+        apr_size_t purged;
+        apr_time_t cutoff;
+
+        if (! argv[3])
+          {
+            usage (argv[0], 1);
+            /* NOTREACHED */
+          }
+
+        cutoff = apr_time_now ()
+          - ((apr_time_t) atoi (argv[3])) * 86400 * APR_USEC_PER_SEC;
+
+        INT_ERR (svn_repos_open (&repos, path, pool));
+        fs = svn_repos_fs (repos);
+
+        printf ("Purging transactions more than %s day(s) old...",
+                argv[3]);
+        INT_ERR (svn_fs_purge_old_txns (&purged, fs, cutoff, pool));
+        printf ("done (%lu purged).\n", (unsigned long) purged);
+      }
+      break;
+
     case svnadmin_cmd_createtxn:
       {
         svn_fs_txn_t *txn;
@@ -499,6 +694,33 @@ main (int argc, const char * const *argv)
       }
       break;
 
+    case svnadmin_cmd_qdeltify:
+      {
+        svn_revnum_t the_rev;
+
+        if (argc != 5)
+          {
+            usage (argv[0], 1);
+            /* NOTREACHED */
+          }
+
+        the_rev = SVN_STR_TO_REV (argv[3]);
+
+        INT_ERR (svn_repos_open (&repos, path, pool));
+        INT_ERR (svn_repos_deltify_enqueue (repos, the_rev, argv[4], pool));
+      }
+      break;
+
+    case svnadmin_cmd_rundeltify:
+      {
+        INT_ERR (svn_repos_open (&repos, path, pool));
+
+        printf ("Deltifying queued paths...");
+        INT_ERR (svn_repos_deltify_drain (repos, pool));
+        printf ("done.\n");
+      }
+      break;
+
     case svnadmin_cmd_deltify:
     case svnadmin_cmd_undeltify:
       {
@@ -621,6 +843,40 @@ main (int argc, const char * const *argv)
       break;
 #endif /* 0 */
 
+    case svnadmin_cmd_build_changes:
+      {
+        INT_ERR (svn_repos_open (&repos, path, pool));
+
+        printf ("Building changed-paths index...");
+        INT_ERR (svn_repos_build_changes (repos, pool));
+        printf ("done.\n");
+      }
+      break;
+
+    case svnadmin_cmd_gc:
+      {
+        apr_size_t deleted;
+
+        INT_ERR (svn_repos_open (&repos, path, pool));
+        fs = svn_repos_fs (repos);
+
+        printf ("Collecting dead database records...");
+        INT_ERR (svn_fs_gc (&deleted, fs, pool));
+        printf ("done (%lu deleted).\n", (unsigned long) deleted);
+      }
+      break;
+
+    case svnadmin_cmd_verify:
+      {
+        INT_ERR (svn_repos_open (&repos, path, pool));
+        fs = svn_repos_fs (repos);
+
+        printf ("Verifying repository tables...");
+        INT_ERR (svn_fs_verify (fs, pool));
+        printf ("done.\n");
+      }
+      break;
+
     case svnadmin_cmd_shell:
       {
         INT_ERR (svn_repos_open (&repos, path, pool));
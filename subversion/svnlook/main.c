@@ -145,7 +145,7 @@ generate_delta_tree (svn_repos_node_t **tree,
   /* Drive our editor. */
   SVN_ERR (svn_repos_dir_delta (base_root, "", NULL, src_revs, root, "",
                                 editor, edit_baton, FALSE, TRUE, FALSE,
-                                edit_pool));
+                                NULL, edit_pool));
 
   /* Return the tree we just built. */
   *tree = svn_repos_node_from_baton (edit_baton);
@@ -166,7 +166,6 @@ print_dirs_changed_tree (svn_repos_node_t *node,
 {
   svn_repos_node_t *tmp_node;
   int print_me = 0;
-  svn_stringbuf_t *full_path;
 
   if (! node)
     return;
@@ -212,20 +211,16 @@ print_dirs_changed_tree (svn_repos_node_t *node,
       printf ("%s/\n", path->data);
     }
 
-  /* Recursively handle the node's children. */
+  /* Recursively handle the node's children, extending PATH in place
+     for each child and chopping it back off afterward. */
   tmp_node = node->child;
-  if (! tmp_node)
-    return;
-
-  full_path = svn_stringbuf_dup (path, pool);
-  svn_path_add_component_nts (full_path, tmp_node->name);
-  print_dirs_changed_tree (tmp_node, full_path, pool);
-  while (tmp_node->sibling)
+  while (tmp_node)
     {
+      apr_size_t path_len = path->len;
+      svn_path_add_component_nts (path, tmp_node->name);
+      print_dirs_changed_tree (tmp_node, path, pool);
+      svn_stringbuf_chop (path, path->len - path_len);
       tmp_node = tmp_node->sibling;
-      svn_stringbuf_set (full_path, path->data);
-      svn_path_add_component_nts (full_path, tmp_node->name);
-      print_dirs_changed_tree (tmp_node, full_path, pool);
     }
 
   return;
@@ -240,7 +235,6 @@ print_changed_tree (svn_repos_node_t *node,
                     apr_pool_t *pool)
 {
   svn_repos_node_t *tmp_node;
-  svn_stringbuf_t *full_path;
   char status[3] = "_ ";
   int print_me = 1;
 
@@ -272,21 +266,16 @@ print_changed_tree (svn_repos_node_t *node,
             path->data,
             tmp_node->kind == svn_node_dir ? "/" : "");
   
-  /* Return here if the node has no children. */
+  /* Recursively handle the node's children, extending PATH in place
+     for each child and chopping it back off afterward. */
   tmp_node = tmp_node->child;
-  if (! tmp_node)
-    return;
-
-  /* Recursively handle the node's children. */
-  full_path = svn_stringbuf_dup (path, pool);
-  svn_path_add_component_nts (full_path, tmp_node->name);
-  print_changed_tree (tmp_node, full_path, pool);
-  while (tmp_node->sibling)
+  while (tmp_node)
     {
+      apr_size_t path_len = path->len;
+      svn_path_add_component_nts (path, tmp_node->name);
+      print_changed_tree (tmp_node, path, pool);
+      svn_stringbuf_chop (path, path->len - path_len);
       tmp_node = tmp_node->sibling;
-      svn_stringbuf_set (full_path, path->data);
-      svn_path_add_component_nts (full_path, tmp_node->name);
-      print_changed_tree (tmp_node, full_path, pool);
     }
 
   return;
@@ -406,7 +395,6 @@ print_diff_tree (svn_fs_root_t *root,
                  apr_pool_t *pool)
 {
   svn_repos_node_t *tmp_node;
-  svn_stringbuf_t *full_path;
   svn_stringbuf_t *orig_path = NULL, *new_path = NULL;
   apr_file_t *fh1, *fh2;
       
@@ -485,7 +473,6 @@ print_diff_tree (svn_fs_root_t *root,
       apr_status_t apr_err;
       const char *label;
       svn_stringbuf_t *abs_path;
-      int exitcode;
 
       printf ("%s: %s\n", 
               ((tmp_node->action == 'A') ? "Added" : 
@@ -506,11 +493,8 @@ print_diff_tree (svn_fs_root_t *root,
 
       label = apr_psprintf (pool, "%s\t(original)", path->data);
       SVN_ERR (svn_path_get_absolute (&abs_path, orig_path, pool));
-      SVN_ERR (svn_io_run_diff (SVNLOOK_TMPDIR, NULL, 0, label,
-                                abs_path->data, path->data, 
-                                &exitcode, outhandle, NULL, pool));
-
-      /* TODO: Handle exit code == 2 (i.e. diff error) here. */
+      SVN_ERR (svn_io_diff_files (abs_path->data, new_path->data,
+                                  label, path->data, outhandle, pool));
 
       printf ("\n");
       fflush (stdout);
@@ -522,130 +506,125 @@ print_diff_tree (svn_fs_root_t *root,
   if (new_path)
     apr_file_remove (new_path->data, pool);
 
-  /* Return here if the node has no children. */
+  /* Recursively handle the node's children, extending PATH in place
+     for each child and chopping it back off afterward. */
   tmp_node = tmp_node->child;
-  if (! tmp_node)
-    return SVN_NO_ERROR;
-
-  /* Recursively handle the node's children. */
-  full_path = svn_stringbuf_dup (path, pool);
-  svn_path_add_component_nts (full_path, tmp_node->name);
-  SVN_ERR (print_diff_tree (root, base_root, tmp_node, full_path, pool));
-  while (tmp_node->sibling)
+  while (tmp_node)
     {
+      apr_size_t path_len = path->len;
+      svn_path_add_component_nts (path, tmp_node->name);
+      SVN_ERR (print_diff_tree (root, base_root, tmp_node, path, pool));
+      svn_stringbuf_chop (path, path->len - path_len);
       tmp_node = tmp_node->sibling;
-      svn_stringbuf_set (full_path, path->data);
-      svn_path_add_component_nts (full_path, tmp_node->name);
-      SVN_ERR (print_diff_tree (root, base_root, tmp_node, full_path, pool));
     }
 
   return SVN_NO_ERROR;
 }
 
 
-/* Recursively print all nodes in the tree. 
- * 
- * ### todo: I'd like to write a more descriptive doc string for this
- * function, but I wasn't able to figure out in a finite amount of
- * time why it even takes the arguments it takes, or why it does what
- * it does with them.  See issue #540.  -kff
- */
-static void
-print_ids_tree (svn_repos_node_t *node,
-                svn_fs_root_t *root,
-                svn_stringbuf_t *path,
-                int indentation,
-                apr_pool_t *pool)
+/* Baton for print_tree_entry: the state of a print_tree walk. */
+struct print_tree_baton
 {
-  svn_stringbuf_t *full_path;
-  svn_repos_node_t *tmp_node;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *path;
+  svn_boolean_t show_ids;
+  int indentation;
+  apr_pool_t *pool;
+};
+
+static svn_error_t *print_tree (svn_fs_root_t *root,
+                                svn_stringbuf_t *path,
+                                svn_boolean_t show_ids,
+                                int indentation,
+                                apr_pool_t *pool);
+
+/* An svn_fs_dirent_receiver_t that prints one directory entry and
+   recurses into it if it is a directory. */
+static svn_error_t *
+print_tree_entry (void *baton,
+                  const svn_fs_dirent_t *entry,
+                  apr_pool_t *pool)
+{
+  struct print_tree_baton *b = baton;
+  apr_size_t path_len = b->path->len;
+  apr_pool_t *subpool = svn_pool_create (b->pool);
+  int is_dir;
   int i;
-  svn_fs_id_t *id;
-  svn_stringbuf_t *unparsed_id = NULL;
-  apr_pool_t *subpool;
 
-  if (! node)
-    return;
+  svn_path_add_component_nts (b->path, entry->name);
+  SVN_ERR (svn_fs_is_dir (&is_dir, b->root, b->path->data, subpool));
 
   /* Print the indentation. */
-  for (i = 0; i < indentation; i++)
+  for (i = 0; i < b->indentation; i++)
     {
       printf (" ");
     }
 
-  /* Get the node's ID */
-  tmp_node = node;
-  svn_fs_node_id (&id, root, path->data, pool);
-  if (id)
-    unparsed_id = svn_fs_unparse_id (id, pool);
-  
-  /* Print the node. */
-  printf ("%s%s <%s>\n", 
-          tmp_node->name, 
-          tmp_node->kind == svn_node_dir ? "/" : "",
-          unparsed_id ? unparsed_id->data : "unknown");
-
-  /* Return here if the node has no children. */
-  tmp_node = tmp_node->child;
-  if (! tmp_node)
-    return;
-
-  /* Recursively handle the node's children. */
-  subpool = svn_pool_create (pool);
-  full_path = svn_stringbuf_dup (path, subpool);
-  svn_path_add_component_nts (full_path, tmp_node->name);
-  print_ids_tree (tmp_node, root, full_path, indentation + 1, subpool);
-  while (tmp_node->sibling)
+  /* Print the entry -- its ID came along for free with the
+     directory read, so there is no per-node lookup to do. */
+  if (b->show_ids)
     {
-      tmp_node = tmp_node->sibling;
-      svn_stringbuf_set (full_path, path->data);
-      svn_path_add_component_nts (full_path, tmp_node->name);
-      print_ids_tree (tmp_node, root, full_path, indentation + 1, subpool);
+      svn_stringbuf_t *unparsed_id = NULL;
+      if (entry->id)
+        unparsed_id = svn_fs_unparse_id (entry->id, subpool);
+      printf ("%s%s <%s>\n",
+              entry->name,
+              is_dir ? "/" : "",
+              unparsed_id ? unparsed_id->data : "unknown");
+    }
+  else
+    {
+      printf ("%s%s \n", entry->name, is_dir ? "/" : "");
     }
+
+  /* Recursively handle the entry's children. */
+  if (is_dir)
+    SVN_ERR (print_tree (b->root, b->path, b->show_ids,
+                         b->indentation + 1, subpool));
+
+  /* Restore PATH for the next entry. */
+  svn_stringbuf_chop (b->path, b->path->len - path_len);
   svn_pool_destroy (subpool);
 
-  return;
+  return SVN_NO_ERROR;
 }
 
+/* Recursively print the tree rooted at the directory PATH in ROOT,
+   indenting each entry by INDENTATION spaces.  If SHOW_IDS is
+   non-zero, print the node revision ID of each entry next to its
+   name.
 
-/* Recursively print all nodes in the tree.  If SHOW_IDS is non-zero,
-   print the id of each node next to its name. */
-static void
-print_tree (svn_repos_node_t *node,
-            int indentation)
+   The entries are streamed with svn_fs_dir_entries_iterate -- no
+   per-directory hash is built, so arbitrarily large directories walk
+   in constant memory -- and PATH is one buffer shared by the whole
+   walk: each entry's name is tacked onto it before recursing and
+   chopped back off afterward. */
+static svn_error_t *
+print_tree (svn_fs_root_t *root,
+            svn_stringbuf_t *path,
+            svn_boolean_t show_ids,
+            int indentation,
+            apr_pool_t *pool)
 {
-  svn_repos_node_t *tmp_node;
-  int i;
-
-  if (! node)
-    return;
-
-  /* Print the indentation. */
-  for (i = 0; i < indentation; i++)
-    {
-      printf (" ");
-    }
-
-  /* Print the node. */
-  tmp_node = node;
-  printf ("%s%s \n", 
-          tmp_node->name, 
-          tmp_node->kind == svn_node_dir ? "/" : "");
-
-  /* Return here if the node has no children. */
-  tmp_node = tmp_node->child;
-  if (! tmp_node)
-    return;
+  struct print_tree_baton b;
+
+  b.root        = root;
+  b.path        = path;
+  b.show_ids    = show_ids;
+  b.indentation = indentation;
+  b.pool        = pool;
+  return svn_fs_dir_entries_iterate (root, path->data, print_tree_entry,
+                                     &b, pool);
+}
 
-  /* Recursively handle the node's children. */
-  print_tree (tmp_node, indentation + 1);
-  while (tmp_node->sibling)
-    {
-      tmp_node = tmp_node->sibling;
-      print_tree (tmp_node, indentation + 1);
-    }
+/* A batch body (see svn_fs_read_batch) that runs a whole print_tree
+   walk, so the entire tree listing shares one database transaction. */
+static svn_error_t *
+print_tree_batch (void *baton, apr_pool_t *pool)
+{
+  struct print_tree_baton *b = baton;
 
-  return;
+  return print_tree (b->root, b->path, b->show_ids, b->indentation, b->pool);
 }
 
 
@@ -830,27 +809,47 @@ do_diff (svnlook_ctxt_t *c, apr_pool_t *pool)
 }
 
 
-/* Print the diff between revision 0 and our our root. */
+/* Print the tree of our root, with node revision IDs if SHOW_IDS. */
 static svn_error_t *
 do_tree (svnlook_ctxt_t *c, svn_boolean_t show_ids, apr_pool_t *pool)
 {
   svn_fs_root_t *root;
-  svn_repos_node_t *tree;
+  svn_stringbuf_t *path;
 
   SVN_ERR (get_root (&root, c, pool));
-  SVN_ERR (generate_delta_tree (&tree, c->repos, root, 0, pool)); 
-  if (tree)
+  path = svn_stringbuf_create ("", pool);
+
+  /* Print the root directory, then walk the tree beneath it.  The
+     walk reads the filesystem directly, streaming each directory's
+     entries -- no need to drive an editor just to list what's
+     there.  Wrapping the walk in a read batch makes the whole tree
+     one database transaction, so the recursion never stacks up
+     nested transactions. */
+  if (show_ids)
     {
-      if (show_ids)
-        {
-          print_ids_tree (tree, root, 
-                          svn_stringbuf_create ("", pool), 0, pool);
-        }
-      else
-        {
-          print_tree (tree, 0);
-        }
+      svn_fs_id_t *id;
+      svn_stringbuf_t *unparsed_id = NULL;
+
+      SVN_ERR (svn_fs_node_id (&id, root, path->data, pool));
+      if (id)
+        unparsed_id = svn_fs_unparse_id (id, pool);
+      printf ("/ <%s>\n", unparsed_id ? unparsed_id->data : "unknown");
     }
+  else
+    {
+      printf ("/ \n");
+    }
+
+  {
+    struct print_tree_baton b;
+
+    b.root        = root;
+    b.path        = path;
+    b.show_ids    = show_ids;
+    b.indentation = 1;
+    b.pool        = pool;
+    SVN_ERR (svn_fs_read_batch (c->fs, print_tree_batch, &b, pool));
+  }
 
   return SVN_NO_ERROR;
 }
@@ -937,6 +936,11 @@ main (int argc, const char * const *argv)
   int cmd_offset = 4;
   svnlook_cmd_t command;
   svnlook_ctxt_t c;
+  static char output_buffer[64 * 1024];
+
+  /* Give stdout a roomy buffer, so tree listings and such go out in
+     big blocks instead of a write() per line. */
+  setvbuf (stdout, output_buffer, _IOFBF, sizeof (output_buffer));
 
   /* Initialize context variable. */
   c.fs = NULL;
@@ -0,0 +1,400 @@
+/* delta-bench.c -- delta microbenchmark harness with corpus replay
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_general.h>
+#include <apr_time.h>
+#include <apr_file_io.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_io.h"
+#include "svn_delta.h"
+
+
+/* This is not a regression test; it never fails unless something
+   errors outright.  It replays every regular file in a corpus
+   directory through the delta engine --- vdelta window generation,
+   then svndiff encoding in both format versions --- and reports
+   throughput, compression ratio, and how many windows, instructions
+   and new-data bytes the engine produced.  The last three are the
+   engine's allocations, so a change to vdelta or the svndiff encoder
+   shows up in them directly.  Results are aggregated per file class
+   (text or binary, judged by whether the file contains a zero byte),
+   since the two behave very differently under deltification.
+
+   The numbers come out on `delta-bench:' lines of key=value pairs,
+   one line per class plus a total, for scraping into per-build
+   records.  */
+
+
+/* Everything measured about one class of corpus files.  */
+struct class_stats
+{
+  int files;
+  apr_off_t bytes;              /* total input bytes */
+  double vdelta_secs;           /* time spent generating windows */
+  double svndiff_secs;          /* time spent generating + encoding, v0 */
+  apr_off_t windows;            /* windows produced */
+  apr_off_t ops;                /* delta instructions produced */
+  apr_off_t newdata;            /* new-data bytes produced */
+  apr_off_t svndiff0_bytes;     /* encoded size, format version 0 */
+  apr_off_t svndiff1_bytes;     /* encoded size, format version 1 */
+};
+
+
+/*** In-memory streams. ***/
+
+/* A read stream over a fixed buffer, so replay measures the delta
+   engine and not the filesystem. */
+struct membuf_baton
+{
+  const char *data;
+  apr_size_t len;
+  apr_size_t offset;
+};
+
+static svn_error_t *
+membuf_read_fn (void *baton, char *buffer, apr_size_t *len)
+{
+  struct membuf_baton *mb = baton;
+  apr_size_t left = mb->len - mb->offset;
+
+  if (*len > left)
+    *len = left;
+  memcpy (buffer, mb->data + mb->offset, *len);
+  mb->offset += *len;
+  return SVN_NO_ERROR;
+}
+
+static svn_stream_t *
+membuf_stream (const char *data, apr_size_t len, apr_pool_t *pool)
+{
+  struct membuf_baton *mb = apr_palloc (pool, sizeof (*mb));
+  svn_stream_t *stream;
+
+  mb->data = data;
+  mb->len = len;
+  mb->offset = 0;
+  stream = svn_stream_create (mb, pool);
+  svn_stream_set_read (stream, membuf_read_fn);
+  return stream;
+}
+
+
+/* A write stream that just counts the bytes thrown at it. */
+static svn_error_t *
+count_write_fn (void *baton, const char *data, apr_size_t *len)
+{
+  apr_off_t *count = baton;
+
+  *count += *len;
+  return SVN_NO_ERROR;
+}
+
+static svn_stream_t *
+count_stream (apr_off_t *count, apr_pool_t *pool)
+{
+  svn_stream_t *stream = svn_stream_create (count, pool);
+
+  svn_stream_set_write (stream, count_write_fn);
+  return stream;
+}
+
+
+/*** The measured passes. ***/
+
+/* Run vdelta over DATA (LEN bytes, against an empty source), counting
+   windows, instructions and new-data bytes into STATS, and adding the
+   elapsed time to STATS->vdelta_secs. */
+static svn_error_t *
+vdelta_pass (const char *data,
+             apr_size_t len,
+             struct class_stats *stats,
+             apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *stream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *wpool = svn_pool_create (pool);
+  apr_time_t start = apr_time_now ();
+
+  svn_txdelta (&stream, svn_stream_empty (pool),
+               membuf_stream (data, len, pool), pool);
+  do
+    {
+      SVN_ERR (svn_txdelta_next_window (&window, stream, wpool));
+      if (window)
+        {
+          int i;
+
+          stats->windows++;
+          stats->ops += window->num_ops;
+          for (i = 0; i < window->num_ops; i++)
+            if (window->ops[i].action_code == svn_txdelta_new)
+              stats->newdata += window->ops[i].length;
+          svn_pool_clear (wpool);
+        }
+    }
+  while (window);
+  svn_pool_destroy (wpool);
+
+  stats->vdelta_secs
+    += ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Run vdelta over DATA again, this time feeding the windows through
+   the svndiff encoder at format VERSION.  Add the encoded size to
+   *ENCODED_BYTES and, if TIMED_SECS isn't null, the elapsed time to
+   *TIMED_SECS. */
+static svn_error_t *
+svndiff_pass (const char *data,
+              apr_size_t len,
+              int version,
+              apr_off_t *encoded_bytes,
+              double *timed_secs,
+              apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *stream;
+  svn_txdelta_window_t *window;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  apr_off_t count = 0;
+  apr_pool_t *wpool = svn_pool_create (pool);
+  apr_time_t start = apr_time_now ();
+
+  svn_txdelta (&stream, svn_stream_empty (pool),
+               membuf_stream (data, len, pool), pool);
+  svn_txdelta_to_svndiff_version (count_stream (&count, pool), pool,
+                                  version, &handler, &handler_baton);
+  do
+    {
+      SVN_ERR (svn_txdelta_next_window (&window, stream, wpool));
+      SVN_ERR (handler (window, handler_baton));
+      if (window)
+        svn_pool_clear (wpool);
+    }
+  while (window);
+  svn_pool_destroy (wpool);
+
+  *encoded_bytes += count;
+  if (timed_secs)
+    *timed_secs += ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Replay the file at PATH (ITERATIONS times) into the right one of
+   STATS[0] (text) or STATS[1] (binary). */
+static svn_error_t *
+replay_file (const char *path,
+             int iterations,
+             struct class_stats *stats,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  struct class_stats *cs;
+  apr_size_t i;
+  int iter;
+
+  SVN_ERR (svn_string_from_file (&contents, path, pool));
+
+  cs = &stats[0];
+  for (i = 0; i < contents->len; i++)
+    if (contents->data[i] == '\0')
+      {
+        cs = &stats[1];
+        break;
+      }
+
+  cs->files++;
+  cs->bytes += contents->len * iterations;
+
+  for (iter = 0; iter < iterations; iter++)
+    {
+      apr_pool_t *subpool = svn_pool_create (pool);
+
+      SVN_ERR (vdelta_pass (contents->data, contents->len, cs, subpool));
+      svn_pool_clear (subpool);
+      SVN_ERR (svndiff_pass (contents->data, contents->len, 0,
+                             &cs->svndiff0_bytes, &cs->svndiff_secs,
+                             subpool));
+      svn_pool_clear (subpool);
+      SVN_ERR (svndiff_pass (contents->data, contents->len,
+                             SVN_SVNDIFF_MAX_VERSION,
+                             &cs->svndiff1_bytes, NULL, subpool));
+      svn_pool_destroy (subpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Reporting. ***/
+
+static void
+print_class (const char *name, const struct class_stats *s)
+{
+  double mb = ((double) s->bytes) / (1024.0 * 1024.0);
+
+  if (! s->files)
+    return;
+
+  printf ("delta-bench: class=%s files=%d mb=%.2f"
+          " vdelta_mbps=%.2f svndiff_mbps=%.2f"
+          " ratio0=%.3f ratio1=%.3f"
+          " windows=%ld ops=%ld newdata=%ld\n",
+          name, s->files, mb,
+          s->vdelta_secs > 0 ? mb / s->vdelta_secs : 0.0,
+          s->svndiff_secs > 0 ? mb / s->svndiff_secs : 0.0,
+          s->bytes ? ((double) s->svndiff0_bytes) / s->bytes : 0.0,
+          s->bytes ? ((double) s->svndiff1_bytes) / s->bytes : 0.0,
+          (long) s->windows, (long) s->ops, (long) s->newdata);
+}
+
+static void
+add_class (struct class_stats *total, const struct class_stats *s)
+{
+  total->files += s->files;
+  total->bytes += s->bytes;
+  total->vdelta_secs += s->vdelta_secs;
+  total->svndiff_secs += s->svndiff_secs;
+  total->windows += s->windows;
+  total->ops += s->ops;
+  total->newdata += s->newdata;
+  total->svndiff0_bytes += s->svndiff0_bytes;
+  total->svndiff1_bytes += s->svndiff1_bytes;
+}
+
+
+/*** Main. ***/
+
+static void
+print_usage (const char *progname)
+{
+  printf ("%s - delta microbenchmark harness with corpus replay\n"
+          "\n"
+          "USAGE: %s CORPUS_DIR [ITERATIONS]\n"
+          "\n"
+          "Replays every regular file in CORPUS_DIR (ITERATIONS\n"
+          "times each, default 5) through vdelta and through the\n"
+          "svndiff encoder in both format versions, against an empty\n"
+          "source.  Reports throughput, compression ratio, and the\n"
+          "window/instruction/new-data counts the engine produced,\n"
+          "aggregated per file class (text or binary) on\n"
+          "`delta-bench:' lines of key=value pairs.\n",
+          progname, progname);
+}
+
+
+int
+main (int argc, const char * const *argv)
+{
+  apr_pool_t *pool;
+  apr_dir_t *dir;
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
+  struct class_stats stats[2], total;
+  int iterations;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if ((argc < 2) || (argc > 3)
+      || (strcmp (argv[1], "--help") == 0))
+    {
+      print_usage (argv[0]);
+      exit (argc < 2 ? 1 : 0);
+    }
+  iterations = (argc > 2) ? atoi (argv[2]) : 5;
+  if (iterations < 1)
+    {
+      print_usage (argv[0]);
+      exit (1);
+    }
+
+  if (apr_initialize () != APR_SUCCESS)
+    {
+      fprintf (stderr, "apr_initialize() failed.\n");
+      exit (1);
+    }
+  pool = svn_pool_create (NULL);
+
+  memset (stats, 0, sizeof (stats));
+  memset (&total, 0, sizeof (total));
+
+  apr_err = apr_dir_open (&dir, argv[1], pool);
+  if (apr_err)
+    {
+      fprintf (stderr, "error opening corpus directory `%s'\n", argv[1]);
+      exit (1);
+    }
+
+  while (1)
+    {
+      apr_pool_t *subpool;
+
+      apr_err = apr_dir_read (&finfo, APR_FINFO_NAME | APR_FINFO_TYPE, dir);
+      if (APR_STATUS_IS_ENOENT (apr_err))
+        break;
+      else if (apr_err)
+        {
+          fprintf (stderr, "error reading corpus directory `%s'\n", argv[1]);
+          exit (1);
+        }
+      if (finfo.filetype != APR_REG)
+        continue;
+
+      subpool = svn_pool_create (pool);
+      err = replay_file (apr_psprintf (subpool, "%s/%s", argv[1], finfo.name),
+                         iterations, stats, subpool);
+      if (err)
+        break;
+      svn_pool_destroy (subpool);
+    }
+  apr_dir_close (dir);
+
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      exit (1);
+    }
+
+  printf ("delta-bench: params corpus=%s iterations=%d\n",
+          argv[1], iterations);
+  print_class ("text", &stats[0]);
+  print_class ("binary", &stats[1]);
+  add_class (&total, &stats[0]);
+  add_class (&total, &stats[1]);
+  print_class ("all", &total);
+
+  svn_pool_destroy (pool);
+  apr_terminate ();
+  return 0;
+}
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../../tools/dev/svn-dev.el")
+ * end:
+ */
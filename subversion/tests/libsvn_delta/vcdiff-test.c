@@ -0,0 +1,94 @@
+/* vcdiff-test.c -- test driver for parsing vcdiff-format deltas
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <apr_general.h>
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+
+
+/* Apply the vcdiff delta in the first argument to the source file in
+   the second, writing the reconstructed target to stdout.  Together
+   with an xdelta-style encoder this round-trips the corpus under
+   ../libsvn_vcdiff.  */
+
+int
+main (int argc, char **argv)
+{
+  FILE *vcdiff_file;
+  FILE *source_file;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *parser;
+  svn_error_t *err;
+  char buf[4096];
+  apr_size_t len;
+  apr_pool_t *pool;
+
+  if (argc < 3)
+    {
+      printf ("usage: %s vcdiff-file source-file\n", argv[0]);
+      exit (0);
+    }
+
+  vcdiff_file = fopen (argv[1], "rb");
+  source_file = fopen (argv[2], "rb");
+  if (! vcdiff_file || ! source_file)
+    {
+      fprintf (stderr, "%s: can't open input files\n", argv[0]);
+      exit (1);
+    }
+
+  apr_initialize ();
+  pool = svn_pool_create (NULL);
+
+  svn_txdelta_apply (svn_stream_from_stdio (source_file, pool),
+                     svn_stream_from_stdio (stdout, pool), pool,
+                     &handler, &handler_baton);
+  parser = svn_txdelta_parse_vcdiff (handler, handler_baton, TRUE, pool);
+
+  err = SVN_NO_ERROR;
+  while ((len = fread (buf, 1, sizeof (buf), vcdiff_file)) > 0)
+    {
+      err = svn_stream_write (parser, buf, &len);
+      if (err)
+        break;
+    }
+  if (! err)
+    err = svn_stream_close (parser);
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      exit (1);
+    }
+
+  fclose (vcdiff_file);
+  fclose (source_file);
+  svn_pool_destroy (pool);
+  apr_terminate ();
+  exit (0);
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -4846,6 +4846,15 @@ file_integrity_helper (apr_size_t filesize, apr_pool_t *pool)
         return svn_error_createf
           (SVN_ERR_FS_GENERAL, 0, NULL, pool,
            "MD5 checksum failure, revision %lu", (long unsigned int)j);
+
+      /* The checksum the filesystem recorded at commit time should
+         say the same thing, without reading any file data. */
+      SVN_ERR (svn_fs_file_md5_checksum (digest, rev_root, "bigfile",
+                                         subpool));
+      if (memcmp (digest, digest_list[j], MD5_DIGESTSIZE))
+        return svn_error_createf
+          (SVN_ERR_FS_GENERAL, 0, NULL, pool,
+           "recorded checksum failure, revision %lu", (long unsigned int)j);
     }
 
   svn_pool_destroy (subpool);
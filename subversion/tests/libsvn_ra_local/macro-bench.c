@@ -0,0 +1,468 @@
+/*
+ * macro-bench.c: repository load generator and macro-benchmark suite
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_path.h"
+#include "svn_delta.h"
+#include "svn_ra.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "../fs-helpers.h"
+
+
+/* This is not a regression test; it never fails unless something
+   errors outright.  It synthesizes a repository of parameterized
+   shape, then times the operations a build's performance lives or
+   dies by: committing revisions, checking out over ra_local, a raw
+   svn_repos_dir_delta drive, and `log' over the whole history.  Every
+   measurement comes out on a line starting with "macro-bench:" as
+   key=value pairs, so a script can scrape the numbers and track them
+   per build.  */
+
+
+#define BENCH_REPO_NAME "macro-bench-repo"
+
+/* Size of the contents generated for a binary file.  */
+#define BINARY_FILE_SIZE 8192
+
+
+/* Command-line knobs, with defaults sized so a bare run finishes
+   quickly. */
+struct bench_config
+{
+  int files;            /* files per directory of the generated tree */
+  int depth;            /* directory nesting; each level forks in two */
+  int revs;             /* revisions to commit, including the import */
+  int binary_pct;       /* percentage of files given binary contents */
+
+  /* Bookkeeping filled in as the tree is generated. */
+  int total_files;
+  int total_dirs;
+};
+
+
+
+/*** Building the tree to measure. ***/
+
+/* Set the file at PATH in TXN_ROOT to BINARY_FILE_SIZE bytes of
+   byte-salad, seeded by SERIAL so every binary file differs.  (The
+   usual helper only handles null-terminated text.)  */
+static svn_error_t *
+set_binary_file_contents (svn_fs_root_t *txn_root,
+                          const char *path,
+                          int serial,
+                          apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t consumer_func;
+  void *consumer_baton;
+  unsigned char *buf = apr_palloc (pool, BINARY_FILE_SIZE);
+  svn_string_t string;
+  unsigned long state = 2891336453UL + serial;
+  int i;
+
+  for (i = 0; i < BINARY_FILE_SIZE; i++)
+    {
+      state = state * 1103515245UL + 12345UL;
+      buf[i] = (unsigned char) (state >> 16);
+    }
+
+  SVN_ERR (svn_fs_apply_textdelta (&consumer_func, &consumer_baton,
+                                   txn_root, path, pool));
+
+  string.data = (const char *) buf;
+  string.len = BINARY_FILE_SIZE;
+  SVN_ERR (svn_txdelta_send_string (&string, consumer_func,
+                                    consumer_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Fill PARENT_PATH in TXN_ROOT with CONFIG->files files --- every
+   hundredth file weighted so CONFIG->binary_pct percent of them get
+   binary contents --- and, unless DEPTH is zero, two subdirectories
+   each recursively filled the same way with DEPTH - 1.  */
+static svn_error_t *
+populate_dir (struct bench_config *config,
+              svn_fs_root_t *txn_root,
+              const char *parent_path,
+              int depth,
+              apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < config->files; i++)
+    {
+      const char *path = apr_psprintf (pool, "%s/file%d", parent_path, i);
+      int serial = config->total_files++;
+
+      SVN_ERR (svn_fs_make_file (txn_root, path, pool));
+      if ((serial % 100) < config->binary_pct)
+        SVN_ERR (set_binary_file_contents (txn_root, path, serial, pool));
+      else
+        SVN_ERR (svn_test__set_file_contents
+                 (txn_root, path,
+                  apr_psprintf (pool,
+                                "This is `%s', full of benchmark prose.\n",
+                                path),
+                  pool));
+    }
+
+  if (depth > 0)
+    for (i = 0; i < 2; i++)
+      {
+        const char *path = apr_psprintf (pool, "%s/dir%d", parent_path, i);
+
+        config->total_dirs++;
+        SVN_ERR (svn_fs_make_dir (txn_root, path, pool));
+        SVN_ERR (populate_dir (config, txn_root, path, depth - 1, pool));
+      }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Rewrite the first file in PARENT_PATH and each subdirectory below
+   it, stamping in REVISION, so each revision after the import touches
+   every directory without rewriting the whole tree.  */
+static svn_error_t *
+touch_dir (svn_fs_root_t *txn_root,
+           const char *parent_path,
+           int depth,
+           int revision,
+           apr_pool_t *pool)
+{
+  const char *path = apr_psprintf (pool, "%s/file0", parent_path);
+  int i;
+
+  SVN_ERR (svn_test__set_file_contents
+           (txn_root, path,
+            apr_psprintf (pool, "Revision %d of this file.\n", revision),
+            pool));
+
+  if (depth > 0)
+    for (i = 0; i < 2; i++)
+      SVN_ERR (touch_dir (txn_root,
+                          apr_psprintf (pool, "%s/dir%d", parent_path, i),
+                          depth - 1, revision, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** The measured operations. ***/
+
+/* Build the benchmark repository, committing CONFIG->revs revisions,
+   and set *COMMIT_SECS to the time the commits took.  */
+static svn_error_t *
+bench_commits (struct bench_config *config,
+               double *commit_secs,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t new_rev = 0;
+  apr_time_t start;
+  apr_pool_t *subpool;
+  int r;
+
+  SVN_ERR (svn_test__create_repos (&repos, BENCH_REPO_NAME, pool));
+  fs = svn_repos_fs (repos);
+
+  start = apr_time_now ();
+  subpool = svn_pool_create (pool);
+  for (r = 1; r <= config->revs; r++)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+
+      SVN_ERR (svn_fs_begin_txn (&txn, fs, new_rev, subpool));
+      SVN_ERR (svn_fs_txn_root (&txn_root, txn, subpool));
+      if (r == 1)
+        SVN_ERR (populate_dir (config, txn_root, "",
+                               config->depth, subpool));
+      else
+        SVN_ERR (touch_dir (txn_root, "", config->depth, r, subpool));
+      SVN_ERR (svn_fs_commit_txn (NULL, &new_rev, txn));
+      SVN_ERR (svn_fs_close_txn (txn));
+      svn_pool_clear (subpool);
+    }
+  svn_pool_destroy (subpool);
+  *commit_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  SVN_ERR (svn_repos_close (repos));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+null_window_handler (svn_txdelta_window_t *window, void *baton)
+{
+  return SVN_NO_ERROR;
+}
+
+
+/* The old default editor's apply_textdelta hands back a null handler,
+   which the drivers would promptly call.  Give them a real sink
+   instead.  */
+static svn_error_t *
+bench_apply_textdelta (void *file_baton,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  *handler = null_window_handler;
+  *handler_baton = NULL;
+  return SVN_NO_ERROR;
+}
+
+
+/* Return an editor that swallows a whole drive without doing
+   anything.  */
+static svn_delta_edit_fns_t *
+make_null_editor (apr_pool_t *pool)
+{
+  svn_delta_edit_fns_t *editor = svn_delta_old_default_editor (pool);
+
+  editor->apply_textdelta = bench_apply_textdelta;
+  return editor;
+}
+
+
+/* The callbacks ra_local pulls a username through. */
+
+static svn_error_t *
+bench_get_username (char **username,
+                    void *auth_baton,
+                    svn_boolean_t force_prompt,
+                    apr_pool_t *pool)
+{
+  *username = "macro-bench";
+  return SVN_NO_ERROR;
+}
+
+static const svn_ra_username_authenticator_t bench_authenticator
+  = { bench_get_username, NULL };
+
+static svn_error_t *
+bench_get_authenticator (void **authenticator,
+                         void **auth_baton,
+                         enum svn_ra_auth_method method,
+                         void *callback_baton,
+                         apr_pool_t *pool)
+{
+  *authenticator = (void *) &bench_authenticator;
+  *auth_baton = NULL;
+  return SVN_NO_ERROR;
+}
+
+
+/* Check out the head of the benchmark repository through ra_local
+   into a null editor, setting *CHECKOUT_SECS to the elapsed time.  */
+static svn_error_t *
+bench_checkout (double *checkout_secs,
+                apr_pool_t *pool)
+{
+  void *ra_baton, *session;
+  svn_ra_plugin_t *plugin;
+  svn_ra_callbacks_t *callbacks = apr_pcalloc (pool, sizeof (*callbacks));
+  svn_stringbuf_t *abs_path, *url;
+  svn_revnum_t youngest;
+  apr_time_t start;
+
+  SVN_ERR (svn_ra_init_ra_libs (&ra_baton, pool));
+  SVN_ERR (svn_ra_get_ra_library (&plugin, ra_baton, "file:", pool));
+
+  SVN_ERR (svn_path_get_absolute
+           (&abs_path, svn_stringbuf_create (BENCH_REPO_NAME, pool), pool));
+  url = svn_stringbuf_createf (pool, "file://%s", abs_path->data);
+
+  callbacks->get_authenticator = bench_get_authenticator;
+
+  SVN_ERR (plugin->open (&session, url, callbacks, NULL, pool));
+  SVN_ERR (plugin->get_latest_revnum (session, &youngest));
+
+  start = apr_time_now ();
+  SVN_ERR (plugin->do_checkout (session, youngest, TRUE,
+                                make_null_editor (pool), NULL));
+  *checkout_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  SVN_ERR (plugin->close (session));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+count_log_receiver (void *baton,
+                    apr_hash_t *changed_paths,
+                    svn_revnum_t revision,
+                    const char *author,
+                    const char *date,
+                    const char *message)
+{
+  int *count = baton;
+
+  (*count)++;
+  return SVN_NO_ERROR;
+}
+
+
+/* Time a raw dir_delta drive of the whole tree and a changed-paths
+   log of the whole history.  */
+static svn_error_t *
+bench_dir_delta_and_log (double *dir_delta_secs,
+                         double *log_secs,
+                         int *log_revs,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_root_t *base_root, *head_root;
+  svn_revnum_t youngest;
+  apr_time_t start;
+
+  SVN_ERR (svn_repos_open (&repos, BENCH_REPO_NAME, pool));
+  fs = svn_repos_fs (repos);
+  SVN_ERR (svn_fs_youngest_rev (&youngest, fs, pool));
+
+  SVN_ERR (svn_fs_revision_root (&base_root, fs, 0, pool));
+  SVN_ERR (svn_fs_revision_root (&head_root, fs, youngest, pool));
+
+  start = apr_time_now ();
+  SVN_ERR (svn_repos_dir_delta (base_root, "", NULL, NULL,
+                                head_root, "",
+                                make_null_editor (pool), NULL,
+                                TRUE, TRUE, FALSE, NULL, pool));
+  *dir_delta_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  *log_revs = 0;
+  start = apr_time_now ();
+  SVN_ERR (svn_repos_get_logs (repos, NULL, youngest, 1, TRUE, 0,
+                               count_log_receiver, log_revs, pool));
+  *log_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+
+  SVN_ERR (svn_repos_close (repos));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Main. ***/
+
+static void
+print_usage (const char *progname)
+{
+  printf ("%s - repository load generator and macro-benchmark suite\n"
+          "\n"
+          "USAGE: %s [FILES [DEPTH [REVS [BINARY_PCT]]]]\n"
+          "\n"
+          "Creates `%s' in the current directory (replacing any\n"
+          "earlier one): a tree DEPTH levels deep, forking in two at\n"
+          "each level, with FILES files per directory of which\n"
+          "BINARY_PCT percent hold binary contents; then REVS - 1\n"
+          "more revisions each touching a file in every directory.\n"
+          "Times the commits, a full checkout over ra_local, a raw\n"
+          "dir_delta drive, and a changed-paths log of the whole\n"
+          "history.  Results come out as `macro-bench:' lines of\n"
+          "key=value pairs, for scraping into per-build records.\n",
+          progname, progname, BENCH_REPO_NAME);
+}
+
+
+int
+main (int argc, const char * const *argv)
+{
+  apr_pool_t *pool;
+  struct bench_config config;
+  double commit_secs, checkout_secs, dir_delta_secs, log_secs;
+  int log_revs;
+  svn_error_t *err;
+
+  if (apr_initialize () != APR_SUCCESS)
+    {
+      fprintf (stderr, "apr_initialize() failed.\n");
+      exit (1);
+    }
+  pool = svn_pool_create (NULL);
+
+  if ((argc > 1) && (strcmp (argv[1], "--help") == 0))
+    {
+      print_usage (argv[0]);
+      exit (0);
+    }
+
+  config.files      = (argc > 1) ? atoi (argv[1]) : 10;
+  config.depth      = (argc > 2) ? atoi (argv[2]) : 3;
+  config.revs       = (argc > 3) ? atoi (argv[3]) : 10;
+  config.binary_pct = (argc > 4) ? atoi (argv[4]) : 20;
+  config.total_files = 0;
+  config.total_dirs = 1;
+  if ((config.files < 1) || (config.depth < 0) || (config.revs < 1)
+      || (config.binary_pct < 0) || (config.binary_pct > 100))
+    {
+      print_usage (argv[0]);
+      exit (1);
+    }
+
+  printf ("macro-bench: params files=%d depth=%d revs=%d binary_pct=%d\n",
+          config.files, config.depth, config.revs, config.binary_pct);
+
+  err = bench_commits (&config, &commit_secs, pool);
+  if (! err)
+    err = bench_checkout (&checkout_secs, pool);
+  if (! err)
+    err = bench_dir_delta_and_log (&dir_delta_secs, &log_secs,
+                                   &log_revs, pool);
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      exit (1);
+    }
+
+  printf ("macro-bench: tree files=%d dirs=%d\n",
+          config.total_files, config.total_dirs);
+  printf ("macro-bench: commit secs=%.3f revs_per_sec=%.2f\n",
+          commit_secs, ((double) config.revs) / commit_secs);
+  printf ("macro-bench: checkout secs=%.3f files_per_sec=%.1f\n",
+          checkout_secs, ((double) config.total_files) / checkout_secs);
+  printf ("macro-bench: dir_delta secs=%.3f\n", dir_delta_secs);
+  printf ("macro-bench: log secs=%.3f revs=%d\n", log_secs, log_revs);
+
+  svn_pool_destroy (pool);
+  apr_terminate ();
+  return 0;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -0,0 +1,408 @@
+/*
+ * repos-bench.c: concurrent-read benchmark for libsvn_repos
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "../fs-helpers.h"
+
+
+/* This is not a regression test; it never fails unless something
+   errors outright.  It measures how server-side reads scale when one
+   repository is hammered from several threads at once, which is what
+   a busy mod_dav_svn looks like to the filesystem.  Each thread opens
+   the repository itself (its own Berkeley DB environment handle) and
+   loops driving svn_repos_dir_delta --- a full checkout's worth of
+   reading --- and svn_repos_get_logs.  The number to watch is
+   aggregate drives per second as the thread count grows; if it
+   flattens out, the threads are serializing on BDB locks.  Berkeley's
+   lock table statistics aren't exposed through svn_fs, so for the
+   detailed contention picture run `db_stat -c -h REPO/db' after a
+   run.  */
+
+
+#define BENCH_REPO_NAME "bench-repo"
+
+
+/* Command-line knobs, with defaults sized so a bare run finishes
+   quickly. */
+struct bench_config
+{
+  int num_threads;      /* reader threads to run */
+  int depth;            /* directory nesting of the generated tree */
+  int width;            /* entries per directory level */
+  int iterations;       /* dir_delta + get_logs loops per thread */
+};
+
+
+
+/*** Building the tree to read. ***/
+
+/* Fill PARENT_PATH in TXN_ROOT with WIDTH files, and --- unless DEPTH
+   is zero --- WIDTH subdirectories each recursively filled the same
+   way with DEPTH - 1.  */
+static svn_error_t *
+populate_dir (svn_fs_root_t *txn_root,
+              const char *parent_path,
+              int depth,
+              int width,
+              apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < width; i++)
+    {
+      const char *path = apr_psprintf (pool, "%s/file%d", parent_path, i);
+      const char *contents
+        = apr_psprintf (pool, "This is `%s', full of benchmark prose.\n",
+                        path);
+
+      SVN_ERR (svn_fs_make_file (txn_root, path, pool));
+      SVN_ERR (svn_test__set_file_contents (txn_root, path, contents, pool));
+    }
+
+  if (depth > 0)
+    for (i = 0; i < width; i++)
+      {
+        const char *path = apr_psprintf (pool, "%s/dir%d", parent_path, i);
+
+        SVN_ERR (svn_fs_make_dir (txn_root, path, pool));
+        SVN_ERR (populate_dir (txn_root, path, depth - 1, width, pool));
+      }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Rewrite the first file in PARENT_PATH and each subdirectory below
+   it, so the second revision touches every directory without
+   rewriting the whole tree.  */
+static svn_error_t *
+touch_dir (svn_fs_root_t *txn_root,
+           const char *parent_path,
+           int depth,
+           int width,
+           apr_pool_t *pool)
+{
+  const char *path = apr_psprintf (pool, "%s/file0", parent_path);
+  int i;
+
+  SVN_ERR (svn_test__set_file_contents
+           (txn_root, path, "Second revision of this file.\n", pool));
+
+  if (depth > 0)
+    for (i = 0; i < width; i++)
+      SVN_ERR (touch_dir (txn_root,
+                          apr_psprintf (pool, "%s/dir%d", parent_path, i),
+                          depth - 1, width, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Create the benchmark repository: one revision holding the full
+   generated tree, and a second one touching a file in every
+   directory.  */
+static svn_error_t *
+create_bench_repos (struct bench_config *config,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t new_rev;
+
+  SVN_ERR (svn_test__create_repos (&repos, BENCH_REPO_NAME, pool));
+  fs = svn_repos_fs (repos);
+
+  SVN_ERR (svn_fs_begin_txn (&txn, fs, 0, pool));
+  SVN_ERR (svn_fs_txn_root (&txn_root, txn, pool));
+  SVN_ERR (populate_dir (txn_root, "", config->depth, config->width, pool));
+  SVN_ERR (svn_fs_commit_txn (NULL, &new_rev, txn));
+  SVN_ERR (svn_fs_close_txn (txn));
+
+  SVN_ERR (svn_fs_begin_txn (&txn, fs, new_rev, pool));
+  SVN_ERR (svn_fs_txn_root (&txn_root, txn, pool));
+  SVN_ERR (touch_dir (txn_root, "", config->depth, config->width, pool));
+  SVN_ERR (svn_fs_commit_txn (NULL, &new_rev, txn));
+  SVN_ERR (svn_fs_close_txn (txn));
+
+  SVN_ERR (svn_repos_close (repos));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** The read loop each thread runs. ***/
+
+static svn_error_t *
+null_window_handler (svn_txdelta_window_t *window, void *baton)
+{
+  return SVN_NO_ERROR;
+}
+
+
+/* The old default editor's apply_textdelta hands back a null handler,
+   which dir_delta's driver would promptly call.  Give it a real
+   sink instead.  */
+static svn_error_t *
+bench_apply_textdelta (void *file_baton,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  *handler = null_window_handler;
+  *handler_baton = NULL;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+count_log_receiver (void *baton,
+                    apr_hash_t *changed_paths,
+                    svn_revnum_t revision,
+                    const char *author,
+                    const char *date,
+                    const char *message)
+{
+  int *count = baton;
+
+  (*count)++;
+  return SVN_NO_ERROR;
+}
+
+
+/* Everything one reader thread needs, plus room for its results. */
+struct reader_baton
+{
+  struct bench_config *config;
+  int drives_done;           /* how many loops this reader finished */
+  svn_error_t *err;          /* error that stopped it, if any */
+};
+
+
+/* Open the repository and run CONFIG->iterations rounds of a full
+   dir_delta drive plus a get_logs call.  Results land in the
+   reader_baton.  */
+static svn_error_t *
+reader_loop (struct reader_baton *rb,
+             apr_pool_t *pool)
+{
+  struct bench_config *config = rb->config;
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t youngest;
+  apr_pool_t *subpool;
+  int i;
+
+  SVN_ERR (svn_repos_open (&repos, BENCH_REPO_NAME, pool));
+  fs = svn_repos_fs (repos);
+  SVN_ERR (svn_fs_youngest_rev (&youngest, fs, pool));
+
+  subpool = svn_pool_create (pool);
+  for (i = 0; i < config->iterations; i++)
+    {
+      svn_fs_root_t *base_root, *head_root;
+      svn_delta_edit_fns_t *editor;
+      int log_count = 0;
+
+      SVN_ERR (svn_fs_revision_root (&base_root, fs, 0, subpool));
+      SVN_ERR (svn_fs_revision_root (&head_root, fs, youngest, subpool));
+
+      editor = svn_delta_old_default_editor (subpool);
+      editor->apply_textdelta = bench_apply_textdelta;
+
+      /* The whole tree comes out of this drive --- it's a checkout
+         as the filesystem sees one. */
+      SVN_ERR (svn_repos_dir_delta (base_root, "", NULL, NULL,
+                                    head_root, "",
+                                    editor, NULL,
+                                    TRUE, TRUE, FALSE, NULL, subpool));
+
+      SVN_ERR (svn_repos_get_logs (repos, NULL, youngest, 1, FALSE, 0,
+                                   count_log_receiver, &log_count,
+                                   subpool));
+
+      rb->drives_done++;
+      svn_pool_clear (subpool);
+    }
+  svn_pool_destroy (subpool);
+
+  SVN_ERR (svn_repos_close (repos));
+
+  return SVN_NO_ERROR;
+}
+
+
+#if APR_HAS_THREADS
+static void *
+reader_thread (apr_thread_t *thread, void *data)
+{
+  struct reader_baton *rb = data;
+
+  /* An independent top-level pool; pools aren't safe to share across
+     threads. */
+  apr_pool_t *pool = svn_pool_create (NULL);
+
+  rb->err = reader_loop (rb, pool);
+
+  svn_pool_destroy (pool);
+  apr_thread_exit (thread, 0);
+  return NULL;
+}
+#endif /* APR_HAS_THREADS */
+
+
+
+/*** Main. ***/
+
+static void
+print_usage (const char *progname)
+{
+  printf ("%s - concurrent-read benchmark for libsvn_repos\n"
+          "\n"
+          "USAGE: %s [THREADS [DEPTH [WIDTH [ITERATIONS]]]]\n"
+          "\n"
+          "Creates `%s' in the current directory (replacing any\n"
+          "earlier one), fills it with a tree DEPTH levels deep and\n"
+          "WIDTH entries wide, then reads it from THREADS threads at\n"
+          "once, each doing ITERATIONS rounds of svn_repos_dir_delta\n"
+          "and svn_repos_get_logs.  Reports aggregate throughput.\n"
+          "For Berkeley DB lock statistics, run `db_stat -c' against\n"
+          "the repository's db directory afterwards.\n",
+          progname, progname, BENCH_REPO_NAME);
+}
+
+
+int
+main (int argc, const char * const *argv)
+{
+  apr_pool_t *pool;
+  struct bench_config config;
+  struct reader_baton *batons;
+  apr_time_t start, elapsed;
+  svn_error_t *err;
+  int total_drives = 0;
+  int i;
+
+  if (apr_initialize () != APR_SUCCESS)
+    {
+      fprintf (stderr, "apr_initialize() failed.\n");
+      exit (1);
+    }
+  pool = svn_pool_create (NULL);
+
+  if ((argc > 1) && (strcmp (argv[1], "--help") == 0))
+    {
+      print_usage (argv[0]);
+      exit (0);
+    }
+
+  config.num_threads = (argc > 1) ? atoi (argv[1]) : 4;
+  config.depth       = (argc > 2) ? atoi (argv[2]) : 3;
+  config.width       = (argc > 3) ? atoi (argv[3]) : 5;
+  config.iterations  = (argc > 4) ? atoi (argv[4]) : 10;
+  if ((config.num_threads < 1) || (config.depth < 0)
+      || (config.width < 1) || (config.iterations < 1))
+    {
+      print_usage (argv[0]);
+      exit (1);
+    }
+
+  printf ("Building %s: depth %d, width %d ...\n",
+          BENCH_REPO_NAME, config.depth, config.width);
+  err = create_bench_repos (&config, pool);
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      exit (1);
+    }
+
+  batons = apr_pcalloc (pool, config.num_threads * sizeof (*batons));
+  for (i = 0; i < config.num_threads; i++)
+    batons[i].config = &config;
+
+  printf ("Running %d reader(s), %d iteration(s) each ...\n",
+          config.num_threads, config.iterations);
+  start = apr_time_now ();
+
+#if APR_HAS_THREADS
+  {
+    apr_thread_t **threads
+      = apr_pcalloc (pool, config.num_threads * sizeof (*threads));
+
+    for (i = 0; i < config.num_threads; i++)
+      if (apr_thread_create (&threads[i], NULL, reader_thread,
+                             &batons[i], pool) != APR_SUCCESS)
+        {
+          fprintf (stderr, "apr_thread_create() failed.\n");
+          exit (1);
+        }
+
+    for (i = 0; i < config.num_threads; i++)
+      {
+        apr_status_t ignored;
+        apr_thread_join (&ignored, threads[i]);
+      }
+  }
+#else  /* ! APR_HAS_THREADS */
+  printf ("(APR built without threads; running the readers in turn.)\n");
+  for (i = 0; i < config.num_threads; i++)
+    batons[i].err = reader_loop (&batons[i], pool);
+#endif /* APR_HAS_THREADS */
+
+  elapsed = apr_time_now () - start;
+
+  for (i = 0; i < config.num_threads; i++)
+    {
+      if (batons[i].err)
+        {
+          fprintf (stderr, "reader %d failed:\n", i);
+          svn_handle_error (batons[i].err, stderr, FALSE);
+          exit (1);
+        }
+      total_drives += batons[i].drives_done;
+    }
+
+  printf ("%d drives in %.3f seconds: %.1f drives/sec\n",
+          total_drives,
+          ((double) elapsed) / APR_USEC_PER_SEC,
+          ((double) total_drives) * APR_USEC_PER_SEC / elapsed);
+
+  svn_pool_destroy (pool);
+  apr_terminate ();
+  return 0;
+}
+
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -383,6 +383,85 @@ test_basename (const char **msg,
 }
 
 
+
+static svn_error_t *
+test_index (const char **msg,
+            svn_boolean_t msg_only,
+            apr_pool_t *pool)
+{
+  svn_path_index_t *index;
+  svn_indexed_path_t *foo, *bar, *baz;
+  int i;
+
+  /* Join cases an index must spell the way svn_path_join does. */
+  static const char * const joins[][3] = {
+    { "abc", "def", "abc/def" },
+    { "/", "d", "/d" },
+    { "/abc", "def", "/abc/def" },
+    { "/abc", "/def", "/def" },
+    { "/abc/", "def", "/abc/def" },
+    { "", "def", "def" },
+    { "abc", "", "abc" },
+    { "", "/def", "/def" },
+  };
+
+  *msg = "test svn_path_index get/join";
+  if (msg_only)
+    return SVN_NO_ERROR;
+
+  index = svn_path_index_create (pool);
+
+  /* The same path must be the same entry however it arrives, with a
+     parent chain leading toward the root. */
+  foo = svn_path_index_get (index, "/foo");
+  bar = svn_path_index_join (index, foo, "bar");
+
+  if (svn_path_index_get (index, "/foo/bar") != bar)
+    return svn_error_create
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "interning /foo/bar again produced a different entry");
+
+  if (svn_path_index_join (index, foo, "bar") != bar)
+    return svn_error_create
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "repeating a join produced a different entry");
+
+  if (strcmp (bar->path, "/foo/bar") || bar->len != strlen ("/foo/bar"))
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "joining /foo and bar produced '%s'", bar->path);
+
+  if (bar->parent != foo)
+    return svn_error_create
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "/foo/bar's parent is not the entry for /foo");
+
+  /* Interning a deep path must intern its ancestors too. */
+  baz = svn_path_index_get (index, "/foo/baz/qux");
+  if (baz->parent == NULL || baz->parent->parent != foo)
+    return svn_error_create
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "interning /foo/baz/qux did not hang it below /foo");
+
+  /* Indexed joins must agree with svn_path_join. */
+  for (i = sizeof (joins) / sizeof (joins[0]); i--; )
+    {
+      svn_indexed_path_t *base = svn_path_index_get (index, joins[i][0]);
+      svn_indexed_path_t *result
+        = svn_path_index_join (index, base, joins[i][1]);
+
+      if (strcmp (result->path, joins[i][2]))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+           "svn_path_index_join(\"%s\", \"%s\") returned "
+           "\"%s\". expected \"%s\"",
+           joins[i][0], joins[i][1], result->path, joins[i][2]);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -396,6 +475,7 @@ svn_error_t * (*test_funcs[]) (const char **msg,
   test_uri_encode,
   test_join,
   test_basename,
+  test_index,
   0
 };
 
@@ -317,27 +317,35 @@ test11 (const char **msg,
 {
   svn_stringbuf_t *s, *t;
   size_t len_1 = 0;
-  size_t len_2 = 0;
   size_t block_len_1 = 0;
   size_t block_len_2 = 0;
+  const char *phrase
+    = "a string comfortably longer than the minimum block size, "
+      "so that its block is sized to fit rather than rounded up";
   
   *msg = "block initialization and growth";
 
   if (msg_only)
     return SVN_NO_ERROR;
 
+  /* Small strings get a block with room to spare, so that appending
+     a little to a freshly created string doesn't reallocate. */
   s = svn_stringbuf_create ("a small string", pool);
+  if (s->blocksize <= (s->len + 1))
+    return fail (pool, "test failed");
+
+  s = svn_stringbuf_create (phrase, pool);
   len_1       = (s->len);
   block_len_1 = (s->blocksize);
   
-  t = svn_stringbuf_create (", plus a string more than twice as long", pool);
+  t = svn_stringbuf_dup (s, pool);
+  svn_stringbuf_appendstr (s, t);
   svn_stringbuf_appendstr (s, t);
-  len_2       = (s->len);
   block_len_2 = (s->blocksize);
   
   /* Test that:
    *   - The initial block was just the right fit.
-   *   - The block more than doubled (because second string so long).
+   *   - The block more than doubled (because of the appends).
    *   - The block grew by a power of 2.
    */
   if ((len_1 == (block_len_1 - 1))
@@ -0,0 +1,173 @@
+/*
+ * time-test.c :  testing the timestamp codec
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr_pools.h>
+#include <apr_time.h>
+#include "svn_error.h"
+#include "svn_time.h"
+
+
+/* A moment with a known fixed-format spelling, and that spelling. */
+static const apr_time_t test_time = APR_TIME_C (1021836547123456);
+static const char *test_timestring = "2002-05-19T19:29:07.123456Z";
+
+/* The same moment as the old format wrote it (in GMT). */
+static const char *test_old_timestring =
+"Sun 19 May 2002 19:29:07.123456 (day 139, dst 0, gmt_off 000000)";
+
+
+static svn_error_t *
+test_time_to_nts (const char **msg,
+                  svn_boolean_t msg_only,
+                  apr_pool_t *pool)
+{
+  const char *timestring;
+  char buf[SVN_TIME_NTS_BUFSIZE];
+
+  *msg = "test svn_time_to_nts";
+
+  if (msg_only)
+    return SVN_NO_ERROR;
+
+  timestring = svn_time_to_nts (test_time, pool);
+
+  if (strcmp (timestring, test_timestring) != 0)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "svn_time_to_nts (%" APR_INT64_T_FMT ") returned %s instead of %s",
+       test_time, timestring, test_timestring);
+
+  /* The non-allocating formatter must agree with it exactly. */
+  svn_time_to_nts_buf (buf, test_time);
+
+  if (strcmp (buf, timestring) != 0)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "svn_time_to_nts_buf returned %s instead of %s", buf, timestring);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_time_from_nts (const char **msg,
+                    svn_boolean_t msg_only,
+                    apr_pool_t *pool)
+{
+  apr_time_t timestamp;
+
+  *msg = "test svn_time_from_nts";
+
+  if (msg_only)
+    return SVN_NO_ERROR;
+
+  timestamp = svn_time_from_nts (test_timestring);
+
+  if (timestamp != test_time)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "svn_time_from_nts (%s) returned %" APR_INT64_T_FMT
+       " instead of %" APR_INT64_T_FMT,
+       test_timestring, timestamp, test_time);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_time_from_nts_old (const char **msg,
+                        svn_boolean_t msg_only,
+                        apr_pool_t *pool)
+{
+  apr_time_t timestamp;
+
+  *msg = "test svn_time_from_nts (old format)";
+
+  if (msg_only)
+    return SVN_NO_ERROR;
+
+  timestamp = svn_time_from_nts (test_old_timestring);
+
+  if (timestamp != test_time)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "svn_time_from_nts (%s) returned %" APR_INT64_T_FMT
+       " instead of %" APR_INT64_T_FMT,
+       test_old_timestring, timestamp, test_time);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_time_invariant (const char **msg,
+                     svn_boolean_t msg_only,
+                     apr_pool_t *pool)
+{
+  apr_time_t current_timestamp = apr_time_now ();
+  const char *timestring;
+  apr_time_t timestamp;
+
+  *msg = "test timestamp invariant";
+
+  if (msg_only)
+    return SVN_NO_ERROR;
+
+  timestring = svn_time_to_nts (current_timestamp, pool);
+  timestamp = svn_time_from_nts (timestring);
+
+  if (timestamp != current_timestamp)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, 0, NULL, pool,
+       "timestamp %" APR_INT64_T_FMT
+       " did not round trip through %s (got %" APR_INT64_T_FMT ")",
+       current_timestamp, timestring, timestamp);
+
+  return SVN_NO_ERROR;
+}
+
+
+
+
+/*
+   ====================================================================
+   If you add a new test to this file, update this array.
+
+*/
+
+/* An array of all test functions */
+svn_error_t *(*test_funcs[])(const char **msg,
+                             svn_boolean_t msg_only,
+                             apr_pool_t *pool) =
+{
+  NULL,
+  test_time_to_nts,
+  test_time_from_nts,
+  test_time_from_nts_old,
+  test_time_invariant,
+  NULL
+};
+
+
+
+/* -----------------------------------------------------------------
+ * local variables:
+ * eval: (load-file "../../../tools/dev/svn-dev.el")
+ * end:
+ */
@@ -0,0 +1,425 @@
+/* wc-bench.c -- working-copy scale fixture and timing harness
+ *
+ * ====================================================================
+ * Copyright (c) 2000-2002 CollabNet.  All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.  The terms
+ * are also available at http://subversion.tigris.org/license-1.html.
+ * If newer versions of this license are posted there, you may use a
+ * newer version instead, at your option.
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals.  For exact contribution history, see the revision
+ * history and logs, available at http://subversion.tigris.org/.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_general.h>
+#include <apr_hash.h>
+#include <apr_time.h>
+#include <apr_file_io.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_path.h"
+#include "svn_io.h"
+#include "svn_ra.h"
+#include "svn_wc.h"
+
+#include "../../libsvn_wc/wc.h"
+#include "../../libsvn_wc/adm_files.h"
+#include "../../libsvn_wc/entries.h"
+
+
+/* This is not a regression test; it never fails unless something
+   errors outright.  It fabricates a working copy of configurable
+   size directly through the adm-area and entries primitives ---
+   no repository, no checkout --- then times the operations whose
+   cost grows with working copy size: a full svn_wc_entries_read
+   walk, svn_wc_statuses, and svn_wc_crawl_revisions against a
+   reporter that discards everything.  That gives regression numbers
+   for entries-format and status-crawl changes on trees far larger
+   than the regular test suite ever builds.
+
+   The numbers come out on `wc-bench:' lines of key=value pairs,
+   for scraping into per-build records.  */
+
+
+#define BENCH_WC_NAME "wc-bench-wc"
+#define BENCH_WC_URL  "file:///wc-bench-repos"
+
+/* The shape of the fabricated working copy: FILES files in every
+   directory, and below each directory two subdirectories, DEPTH
+   levels deep. */
+struct bench_config
+{
+  int files;
+  int depth;
+  int total_files;
+  int total_dirs;
+};
+
+
+/*** Building the fixture. ***/
+
+/* Return a new entry named NAME of kind KIND at REVISION, allocated
+   in POOL.  (The real allocator lives private in entries.c; this
+   duplicates its invalid-revnum defaults.) */
+static svn_wc_entry_t *
+make_entry (const char *name,
+            svn_node_kind_t kind,
+            svn_revnum_t revision,
+            apr_pool_t *pool)
+{
+  svn_wc_entry_t *entry = apr_pcalloc (pool, sizeof (*entry));
+
+  entry->name = svn_stringbuf_create (name, pool);
+  entry->kind = kind;
+  entry->revision = revision;
+  entry->copyfrom_rev = SVN_INVALID_REVNUM;
+  entry->cmt_rev = SVN_INVALID_REVNUM;
+  return entry;
+}
+
+
+/* Create the working file NAME in the directory PATH, plus its
+   text-base copy, and record it in ENTRIES with a text-time matching
+   the file on disk (so status sees it as unmodified without reading
+   it).  *SERIAL makes the contents differ from file to file. */
+static svn_error_t *
+make_file (svn_stringbuf_t *path,
+           const char *name,
+           apr_hash_t *entries,
+           int *serial,
+           apr_pool_t *pool)
+{
+  apr_file_t *f;
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
+  svn_wc_entry_t *entry;
+  svn_stringbuf_t *contents;
+  apr_size_t path_len = path->len;
+
+  svn_path_add_component_nts (path, name);
+  contents = svn_stringbuf_createf
+    (pool,
+     "This is file number %d.\n"
+     "Its contents are repetitive prose, much as a working\n"
+     "copy full of source files is repetitive prose.\n",
+     (*serial)++);
+
+  apr_err = apr_file_open (&f, path->data,
+                           (APR_WRITE | APR_CREATE | APR_EXCL),
+                           APR_OS_DEFAULT, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "error creating file `%s'", path->data);
+  apr_err = apr_file_write_full (f, contents->data, contents->len, NULL);
+  if (! apr_err)
+    apr_err = apr_file_close (f);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "error writing file `%s'", path->data);
+
+  /* An unmodified file has an identical text-base. */
+  SVN_ERR (svn_io_copy_file (path->data,
+                             svn_wc__text_base_path (path, FALSE, pool)->data,
+                             FALSE, pool));
+
+  apr_err = apr_stat (&finfo, path->data, APR_FINFO_MTIME, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "error stating file `%s'", path->data);
+
+  entry = make_entry (name, svn_node_file, 1, pool);
+  entry->text_time = finfo.mtime;
+  apr_hash_set (entries, entry->name->data, APR_HASH_KEY_STRING, entry);
+
+  svn_stringbuf_chop (path, path->len - path_len);
+  return SVN_NO_ERROR;
+}
+
+
+/* Fabricate the working copy directory PATH, versioned as URL: make
+   the directory and its adm area, populate it per CONFIG, write its
+   entries file, and recurse DEPTH more levels.  SERIAL numbers the
+   files across the whole tree. */
+static svn_error_t *
+build_dir (svn_stringbuf_t *path,
+           svn_stringbuf_t *url,
+           const struct bench_config *config,
+           int depth,
+           int *serial,
+           apr_pool_t *pool)
+{
+  apr_hash_t *entries = apr_hash_make (pool);
+  apr_status_t apr_err;
+  int i;
+
+  apr_err = apr_dir_make (path->data, APR_OS_DEFAULT, pool);
+  if (apr_err)
+    return svn_error_createf (apr_err, 0, NULL, pool,
+                              "error creating directory `%s'", path->data);
+  SVN_ERR (svn_wc__ensure_adm (path, url, 1, pool));
+
+  {
+    svn_wc_entry_t *this_dir
+      = make_entry (SVN_WC_ENTRY_THIS_DIR, svn_node_dir, 1, pool);
+    this_dir->url = svn_stringbuf_dup (url, pool);
+    apr_hash_set (entries, this_dir->name->data, APR_HASH_KEY_STRING,
+                  this_dir);
+  }
+
+  for (i = 0; i < config->files; i++)
+    SVN_ERR (make_file (path,
+                        apr_psprintf (pool, "file%d.c", i),
+                        entries, serial, pool));
+
+  for (i = 0; i < (depth > 0 ? 2 : 0); i++)
+    {
+      const char *name = apr_psprintf (pool, "dir%d", i);
+      svn_wc_entry_t *entry = make_entry (name, svn_node_dir, 1, pool);
+
+      apr_hash_set (entries, entry->name->data, APR_HASH_KEY_STRING, entry);
+    }
+
+  SVN_ERR (svn_wc__entries_write (entries, path, pool));
+
+  /* Entries must exist before the children do, the same order a
+     checkout creates them in. */
+  for (i = 0; i < (depth > 0 ? 2 : 0); i++)
+    {
+      apr_pool_t *subpool = svn_pool_create (pool);
+      apr_size_t path_len = path->len;
+      apr_size_t url_len = url->len;
+      const char *name = apr_psprintf (subpool, "dir%d", i);
+
+      svn_path_add_component_nts (path, name);
+      svn_path_add_component_nts (url, name);
+      SVN_ERR (build_dir (path, url, config, depth - 1, serial, subpool));
+      svn_stringbuf_chop (path, path->len - path_len);
+      svn_stringbuf_chop (url, url->len - url_len);
+      svn_pool_destroy (subpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** The timed passes. ***/
+
+/* Read the entries file of PATH and, recursively, of every subdir
+   listed in it, bumping *COUNT by the number of entries seen. */
+static svn_error_t *
+walk_entries (svn_stringbuf_t *path,
+              int *count,
+              apr_pool_t *pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+
+  SVN_ERR (svn_wc_entries_read (&entries, path, pool));
+  *count += apr_hash_count (entries);
+
+  for (hi = apr_hash_first (pool, entries); hi; hi = apr_hash_next (hi))
+    {
+      const void *key;
+      void *val;
+      svn_wc_entry_t *entry;
+
+      apr_hash_this (hi, &key, NULL, &val);
+      entry = val;
+      if ((entry->kind == svn_node_dir)
+          && strcmp (key, SVN_WC_ENTRY_THIS_DIR))
+        {
+          apr_pool_t *subpool = svn_pool_create (pool);
+          apr_size_t path_len = path->len;
+
+          svn_path_add_component_nts (path, key);
+          SVN_ERR (walk_entries (path, count, subpool));
+          svn_stringbuf_chop (path, path->len - path_len);
+          svn_pool_destroy (subpool);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* A reporter that discards everything, so crawl_revisions is timed
+   without any RA layer behind it. */
+static svn_error_t *
+null_set_path (void *report_baton,
+               const char *path,
+               svn_revnum_t revision)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+null_delete_path (void *report_baton, const char *path)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+null_finish_report (void *report_baton)
+{
+  return SVN_NO_ERROR;
+}
+
+static const svn_ra_reporter_t null_reporter =
+{
+  null_set_path,
+  null_delete_path,
+  null_finish_report,
+  null_finish_report    /* abort_report is no different here */
+};
+
+
+/*** Main. ***/
+
+static void
+print_usage (const char *progname)
+{
+  printf ("%s - working-copy scale fixture and timing harness\n"
+          "\n"
+          "USAGE: %s [FILES [DEPTH [THREADS]]]\n"
+          "\n"
+          "Fabricates a working copy under `%s' with FILES files\n"
+          "per directory (default 10) and a two-way directory fan-out\n"
+          "DEPTH levels deep (default 3), directly through the entries\n"
+          "and adm-area primitives.  Then times a full entries walk,\n"
+          "svn_wc_statuses, and svn_wc_crawl_revisions over it.  If\n"
+          "THREADS is 2 or more, status crawls with that many worker\n"
+          "threads.  The directory must not already exist.\n",
+          progname, progname, BENCH_WC_NAME);
+}
+
+
+int
+main (int argc, char **argv)
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+  svn_stringbuf_t *path, *url;
+  struct bench_config config;
+  enum svn_node_kind kind;
+  int threads = 0;
+  int serial = 0, entry_count = 0;
+  int i, level_dirs;
+  apr_time_t start;
+  double build_secs = 0, entries_secs = 0, status_secs = 0, crawl_secs = 0;
+  apr_hash_t *statushash = NULL;
+
+  if ((argc > 1) && (strcmp (argv[1], "--help") == 0))
+    {
+      print_usage (argv[0]);
+      exit (0);
+    }
+
+  config.files = (argc > 1) ? atoi (argv[1]) : 10;
+  config.depth = (argc > 2) ? atoi (argv[2]) : 3;
+  if (argc > 3)
+    threads = atoi (argv[3]);
+  if ((config.files < 1) || (config.depth < 0) || (argc > 4))
+    {
+      print_usage (argv[0]);
+      exit (1);
+    }
+
+  /* Two-way fan-out: count the directories level by level. */
+  config.total_dirs = 0;
+  level_dirs = 1;
+  for (i = 0; i <= config.depth; i++)
+    {
+      config.total_dirs += level_dirs;
+      level_dirs *= 2;
+    }
+  config.total_files = config.total_dirs * config.files;
+
+  if (apr_initialize () != APR_SUCCESS)
+    {
+      fprintf (stderr, "apr_initialize() failed.\n");
+      exit (1);
+    }
+  pool = svn_pool_create (NULL);
+
+  path = svn_stringbuf_create (BENCH_WC_NAME, pool);
+  url = svn_stringbuf_create (BENCH_WC_URL, pool);
+
+  err = svn_io_check_path (path->data, &kind, pool);
+  if (! err && (kind != svn_node_none))
+    err = svn_error_createf (SVN_ERR_GENERAL, 0, NULL, pool,
+                             "`%s' already exists; remove it first",
+                             path->data);
+
+  /* Build the fixture. */
+  if (! err)
+    {
+      start = apr_time_now ();
+      err = build_dir (path, url, &config, config.depth, &serial, pool);
+      build_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+    }
+
+  /* Walk every entries file. */
+  if (! err)
+    {
+      start = apr_time_now ();
+      err = walk_entries (path, &entry_count, pool);
+      entries_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+    }
+
+  /* Full recursive status. */
+  if (! err)
+    {
+      svn_wc_set_status_threads (threads);
+      statushash = apr_hash_make (pool);
+      start = apr_time_now ();
+      err = svn_wc_statuses (statushash, path, TRUE, TRUE, FALSE, pool);
+      status_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+    }
+
+  /* Revision-report crawl into the bit bucket. */
+  if (! err)
+    {
+      start = apr_time_now ();
+      err = svn_wc_crawl_revisions (path, &null_reporter, NULL,
+                                    FALSE, TRUE, NULL, NULL, pool);
+      crawl_secs = ((double) (apr_time_now () - start)) / APR_USEC_PER_SEC;
+    }
+
+  if (err)
+    {
+      svn_handle_error (err, stderr, FALSE);
+      exit (1);
+    }
+
+  printf ("wc-bench: params files=%d depth=%d threads=%d\n",
+          config.files, config.depth, threads);
+  printf ("wc-bench: tree dirs=%d files=%d\n",
+          config.total_dirs, config.total_files);
+  printf ("wc-bench: build secs=%.3f\n", build_secs);
+  printf ("wc-bench: entries_read entries=%d secs=%.3f\n",
+          entry_count, entries_secs);
+  printf ("wc-bench: statuses statuses=%u secs=%.3f\n",
+          apr_hash_count (statushash), status_secs);
+  printf ("wc-bench: crawl secs=%.3f\n", crawl_secs);
+
+  svn_pool_destroy (pool);
+  apr_terminate ();
+  return 0;
+}
+
+
+/*
+ * local variables:
+ * eval: (load-file "../../../tools/dev/svn-dev.el")
+ * end:
+ */
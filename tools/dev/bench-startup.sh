@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# USAGE: bench-startup.sh SVN-BINARY [ITERATIONS]
+#
+#  Measure the cold-start overhead of the cmdline client: how long it
+#  takes `svn st' to run in an empty working directory, i.e. the time
+#  spent before a command touches its first entries file.  Build
+#  farms run svn thousands of times per build, so shaving
+#  milliseconds here is worth real wall-clock time.
+#
+#  Runs `svn --version' once first (paging the binary and the RA
+#  libraries into cache), then times ITERATIONS (default 100) runs of
+#  `svn st' and reports the total; divide by ITERATIONS yourself.
+#
+
+if test $# -lt 1; then
+  echo "USAGE: bench-startup.sh SVN-BINARY [ITERATIONS]"
+  exit 1
+fi
+
+svn=$1
+iterations=${2-100}
+
+tmpdir=bench-startup.$$
+mkdir $tmpdir || exit 1
+cd $tmpdir
+
+# Warm the caches; ignore the output.
+$svn --version > /dev/null 2>&1
+
+echo "$iterations runs of '$svn st' in an empty directory:"
+time sh -c 'i=0
+while test $i -lt '$iterations'; do
+  '"$svn"' st > /dev/null 2>&1
+  i=`expr $i + 1`
+done'
+
+cd ..
+rmdir $tmpdir
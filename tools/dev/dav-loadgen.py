@@ -0,0 +1,188 @@
+#!/usr/bin/env python
+#
+# USAGE: dav-loadgen.py [options] REPOS_URL
+#
+# Replay a parameterized mix of svn operations against REPOS_URL with
+# N concurrent client sessions, and report latency percentiles per
+# operation type.  Every operation goes through the ordinary `svn'
+# client, i.e. through libsvn_ra_dav and mod_dav_svn, so this
+# exercises the whole DAV stack the way production clients do --
+# useful for validating server-side caching and streaming changes
+# under load rather than with one polite serial client.
+#
+# Options:
+#   -n N        number of concurrent workers (default 4)
+#   -c N        operations per worker (default 25)
+#   -m MIX      operation mix as weights, e.g. "update=8,log=4,commit=2"
+#               (default "checkout=1,update=6,log=4,commit=1")
+#   -s SVN      path to the svn binary (default "svn")
+#
+# Each worker checks out its own working copy first (not counted),
+# then draws operations from the weighted mix:
+#
+#   checkout -- fresh checkout into a scratch directory, then removed
+#   update   -- svn up in the worker's working copy
+#   log      -- svn log on the URL
+#   commit   -- append to a worker-owned file and commit it
+#
+# Commits from one worker make other workers' updates nontrivial, so
+# a mix with some commit weight produces genuinely mixed read/write
+# load on the server.
+#
+# Workers are forked processes; each writes "<op> <seconds>" lines to
+# its own results file, and the parent aggregates them at the end.
+#
+
+import getopt
+import os
+import random
+import string
+import sys
+import time
+
+PERCENTILES = (50, 90, 99)
+
+def run(cmd):
+    "Run CMD quietly, returning its wall-clock duration in seconds."
+    start = time.time()
+    os.system('%s > /dev/null 2>&1' % cmd)
+    return time.time() - start
+
+def worker(n, url, count, mix, svn, scratch, results_name):
+    "Run COUNT operations; write per-op timings to RESULTS_NAME."
+    random.seed(os.getpid())
+    results = open(results_name, 'w')
+
+    wc = os.path.join(scratch, 'wc-%d' % n)
+    run('%s checkout %s -d %s' % (svn, url, wc))
+
+    # A worker-owned file to commit changes to.  Adding it is itself
+    # a commit, which conveniently also verifies we may write.
+    victim = os.path.join(wc, 'loadgen-%d.txt' % n)
+    open(victim, 'w').write('loadgen worker %d\n' % n)
+    run('cd %s && %s add %s && %s commit -m loadgen %s'
+        % (wc, svn, os.path.basename(victim),
+           svn, os.path.basename(victim)))
+
+    # Build a pick list: each op appears WEIGHT times.
+    picks = []
+    for op, weight in mix.items():
+        picks.extend([op] * weight)
+
+    for i in range(count):
+        op = random.choice(picks)
+        if op == 'checkout':
+            dir = os.path.join(scratch, 'co-%d-%d' % (n, i))
+            elapsed = run('%s checkout %s -d %s' % (svn, url, dir))
+            os.system('rm -rf %s' % dir)
+        elif op == 'update':
+            elapsed = run('cd %s && %s update' % (wc, svn))
+        elif op == 'log':
+            elapsed = run('%s log %s' % (svn, url))
+        elif op == 'commit':
+            open(victim, 'a').write('change %d\n' % i)
+            elapsed = run('cd %s && %s commit -m loadgen %s'
+                          % (wc, svn, os.path.basename(victim)))
+        else:
+            sys.stderr.write('unknown op in mix: %s\n' % op)
+            os._exit(1)
+        results.write('%s %f\n' % (op, elapsed))
+
+    results.close()
+    os._exit(0)
+
+def percentile(sorted_times, pct):
+    "Return the PCT'th percentile of the ascending list SORTED_TIMES."
+    i = (len(sorted_times) * pct) / 100
+    if i >= len(sorted_times):
+        i = len(sorted_times) - 1
+    return sorted_times[i]
+
+def report(timings, wall):
+    total_ops = 0
+    for op in timings.keys():
+        total_ops = total_ops + len(timings[op])
+
+    print 'total: %d ops in %.1fs (%.2f ops/s overall)' \
+          % (total_ops, wall, total_ops / wall)
+    print '%-10s %6s %8s' % ('op', 'count', 'mean'),
+    for pct in PERCENTILES:
+        print '%7s' % ('p%d' % pct),
+    print
+
+    ops = timings.keys()
+    ops.sort()
+    for op in ops:
+        times = timings[op]
+        times.sort()
+        mean = 0.0
+        for t in times:
+            mean = mean + t
+        mean = mean / len(times)
+        print '%-10s %6d %7.3fs' % (op, len(times), mean),
+        for pct in PERCENTILES:
+            print '%6.3fs' % percentile(times, pct),
+        print
+
+def main():
+    workers = 4
+    count = 25
+    mixstr = 'checkout=1,update=6,log=4,commit=1'
+    svn = 'svn'
+
+    opts, args = getopt.getopt(sys.argv[1:], 'n:c:m:s:')
+    for opt, value in opts:
+        if opt == '-n':
+            workers = int(value)
+        elif opt == '-c':
+            count = int(value)
+        elif opt == '-m':
+            mixstr = value
+        elif opt == '-s':
+            svn = value
+    if len(args) != 1:
+        sys.stderr.write('USAGE: dav-loadgen.py [options] REPOS_URL\n')
+        sys.exit(1)
+    url = args[0]
+
+    mix = {}
+    for part in string.split(mixstr, ','):
+        op, weight = string.split(part, '=')
+        mix[op] = int(weight)
+
+    scratch = 'dav-loadgen.%d' % os.getpid()
+    os.mkdir(scratch)
+
+    start = time.time()
+    pids = []
+    for n in range(workers):
+        results_name = os.path.join(scratch, 'results-%d' % n)
+        pid = os.fork()
+        if pid == 0:
+            worker(n, url, count, mix, svn, scratch, results_name)
+        pids.append((pid, results_name))
+
+    timings = {}
+    failed = 0
+    for pid, results_name in pids:
+        pid, status = os.waitpid(pid, 0)
+        if status != 0:
+            failed = failed + 1
+        for line in open(results_name).readlines():
+            op, t = string.split(line)
+            if not timings.has_key(op):
+                timings[op] = []
+            timings[op].append(float(t))
+    wall = time.time() - start
+
+    if failed:
+        sys.stderr.write('warning: %d worker(s) exited abnormally\n' % failed)
+    if not timings:
+        sys.stderr.write('no results collected\n')
+        sys.exit(1)
+
+    report(timings, wall)
+    os.system('rm -rf %s' % scratch)
+
+if __name__ == '__main__':
+    main()